@@ -25,6 +25,8 @@ extern "C" {
 
 #define TIMER_TICK_IRQ 0
 #define OFFLOAD_SW_IRQ 1
+#define ETH_NATIVE_POSIX_IRQ 2
+#define ETH_NATIVE_SHM_IRQ 3
 
 /*
  * This interrupt will awake the CPU if IRQs are not locked,
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * This provides a model of host file descriptors as interrupt sources:
+ * when a watched file descriptor becomes readable, its interrupt is raised.
+ *
+ * The interrupt is raised once, the driver rearms it after it has read all
+ * the data available.
+ * While the CPU sleeps, the HW models wait for the watched file descriptors
+ * instead of just for the next timer in real time, so data coming from the
+ * host is handled as soon as it arrives.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/select.h>
+#include "hw_models_top.h"
+#include "timer_model.h"
+#include "irq_ctrl.h"
+#include "fd_model.h"
+#include "posix_trace.h"
+
+#define FD_MODEL_MAX 4
+
+static struct {
+	int fd;
+	unsigned int irq;
+	bool armed;
+} watched[FD_MODEL_MAX];
+
+static int watched_count;
+
+/**
+ * Raise <irq> when <fd> becomes readable
+ */
+void hw_fd_watch(int fd, unsigned int irq)
+{
+	if (watched_count == FD_MODEL_MAX) {
+		posix_print_error_and_exit("Too many file descriptors "
+					   "watched\n");
+	}
+
+	watched[watched_count].fd = fd;
+	watched[watched_count].irq = irq;
+	watched[watched_count].armed = true;
+	watched_count++;
+}
+
+/**
+ * Raise the interrupt of <fd> again the next time it is readable
+ */
+void hw_fd_rearm(int fd)
+{
+	for (int i = 0; i < watched_count; i++) {
+		if (watched[i].fd == fd) {
+			watched[i].armed = true;
+		}
+	}
+}
+
+/**
+ * Wait for the armed file descriptors until the simulated time <next_time>
+ * is reached (in real time mode, otherwise they are only checked), and raise
+ * the interrupts of those which are readable
+ */
+void hw_fd_wait(u64_t next_time)
+{
+	u64_t time_left;
+	struct timeval timeout;
+	fd_set rset;
+	int max_fd = -1;
+	int ret;
+
+	FD_ZERO(&rset);
+
+	for (int i = 0; i < watched_count; i++) {
+		if (watched[i].armed) {
+			FD_SET(watched[i].fd, &rset);
+			if (watched[i].fd > max_fd) {
+				max_fd = watched[i].fd;
+			}
+		}
+	}
+
+	if (max_fd < 0) {
+		return;
+	}
+
+	time_left = hwtimer_get_real_time_left(next_time);
+	timeout.tv_sec = time_left / 1000000;
+	timeout.tv_usec = time_left % 1000000;
+
+	ret = select(max_fd + 1, &rset, NULL, NULL, &timeout);
+	if (ret < 0) {
+		if (errno != EINTR) {
+			posix_print_warning("select() on watched file "
+					    "descriptors failed (%i)\n",
+					    errno);
+		}
+		return;
+	}
+
+	for (int i = 0; ret > 0 && i < watched_count; i++) {
+		if (watched[i].armed && FD_ISSET(watched[i].fd, &rset)) {
+			watched[i].armed = false;
+			hw_irq_ctrl_set_irq(watched[i].irq);
+		}
+	}
+}
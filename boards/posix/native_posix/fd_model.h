@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _NATIVE_POSIX_FD_MODEL_H
+#define _NATIVE_POSIX_FD_MODEL_H
+
+#include "hw_models_top.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void hw_fd_watch(int fd, unsigned int irq);
+void hw_fd_rearm(int fd);
+void hw_fd_wait(u64_t next_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NATIVE_POSIX_FD_MODEL_H */
@@ -15,6 +15,7 @@
 #include "hw_models_top.h"
 #include "timer_model.h"
 #include "irq_ctrl.h"
+#include "fd_model.h"
 #include "posix_board_if.h"
 #include "posix_soc_if.h"
 #include "posix_arch_internal.h"
@@ -80,6 +81,9 @@ void hwm_set_sig_handler(void)
 
 static void hwm_sleep_until_next_timer(void)
 {
+	/* Data from the host may raise an interrupt before the next timer */
+	hw_fd_wait(next_timer_time);
+
 	if (next_timer_time >= simu_time) { /* LCOV_EXCL_BR_LINE */
 		simu_time = next_timer_time;
 	} else {
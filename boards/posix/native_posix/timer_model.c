@@ -263,6 +263,30 @@ void hwtimer_wake_in_time(u64_t time)
 	}
 }
 
+/**
+ * Return how many host microseconds are left until the simulated time <time>
+ * is reached in real time.
+ * If not running in real time mode, there is no need to wait and 0 is returned
+ */
+u64_t hwtimer_get_real_time_left(u64_t time)
+{
+	u64_t expected_rt;
+	u64_t real_time;
+
+	if (!real_time_mode || (time == NEVER)) {
+		return 0;
+	}
+
+	expected_rt = (time - last_radj_stime) / clock_ratio + last_radj_rtime;
+	real_time = get_host_us_time();
+
+	if (expected_rt <= real_time) {
+		return 0;
+	}
+
+	return expected_rt - real_time;
+}
+
 /**
  * The kernel wants to skip the next sys_ticks tick interrupts
  * If sys_ticks == 0, the next interrupt will be raised.
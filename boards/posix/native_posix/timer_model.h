@@ -19,6 +19,7 @@ void hwtimer_cleanup(void);
 void hwtimer_set_real_time_mode(bool new_rt);
 void hwtimer_timer_reached(void);
 void hwtimer_wake_in_time(u64_t time);
+u64_t hwtimer_get_real_time_left(u64_t time);
 void hwtimer_set_silent_ticks(s64_t sys_ticks);
 void hwtimer_enable(u64_t period);
 s64_t hwtimer_get_pending_silent_ticks(void);
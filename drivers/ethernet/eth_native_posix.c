@@ -38,6 +38,10 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #include "eth_native_posix_priv.h"
 #include "ethernet/eth_stats.h"
 
+/* native_posix HW models */
+#include "soc.h"
+#include "fd_model.h"
+
 #if defined(CONFIG_NET_L2_ETHERNET)
 #define _ETH_MTU 1500
 #endif
@@ -86,6 +90,7 @@ struct eth_context {
 	struct net_linkaddr ll_addr;
 	struct net_if *iface;
 	const char *if_name;
+	struct k_sem rx_sem;
 	int dev_fd;
 	bool init_done;
 	bool status;
@@ -286,7 +291,8 @@ static inline struct net_if *get_iface(struct eth_context *ctx,
 #endif
 }
 
-static int read_data(struct eth_context *ctx, int fd)
+static int read_data(struct eth_context *ctx, int fd,
+		     struct net_pkt **pkt_out, struct net_if **iface_out)
 {
 	u16_t vlan_tag = NET_VLAN_TAG_UNSPEC;
 	int count = 0;
@@ -298,7 +304,7 @@ static int read_data(struct eth_context *ctx, int fd)
 
 	ret = eth_read_data(fd, ctx->recv, sizeof(ctx->recv));
 	if (ret <= 0) {
-		return 0;
+		return -EAGAIN;
 	}
 
 	pkt = net_pkt_get_reserve_rx(0, NET_BUF_TIMEOUT);
@@ -365,28 +371,96 @@ static int read_data(struct eth_context *ctx, int fd)
 
 	update_gptp(iface, pkt, false);
 
-	if (net_recv_data(iface, pkt) < 0) {
-		net_pkt_unref(pkt);
-	}
+	*pkt_out = pkt;
+	*iface_out = iface;
 
 	return 0;
 }
 
-static void eth_rx(struct eth_context *ctx)
+static void recv_batch(struct net_if *iface, struct net_pkt **pkts, int count)
 {
-	int ret;
+	int i;
+
+	if (!count) {
+		return;
+	}
+
+	if (net_recv_data_batch(iface, pkts, count) < 0) {
+		for (i = 0; i < count; i++) {
+			net_pkt_unref(pkts[i]);
+		}
+	}
+}
+
+/* Read the frames that are available and pass them to the stack in
+ * batches. Returns true if the batch got full so that there might be
+ * more frames waiting.
+ */
+static bool read_batch(struct eth_context *ctx)
+{
+	struct net_pkt *pkts[CONFIG_ETH_NATIVE_POSIX_RX_BATCH];
+	struct net_if *batch_iface = NULL;
+	struct net_if *iface;
+	struct net_pkt *pkt;
+	int count = 0;
+
+	while (count < ARRAY_SIZE(pkts) && !eth_wait_data(ctx->dev_fd)) {
+		if (read_data(ctx, ctx->dev_fd, &pkt, &iface) < 0) {
+			break;
+		}
+
+		/* All the packets in a batch must be for the same
+		 * interface, which is not the case with VLANs.
+		 */
+		if (count && iface != batch_iface) {
+			recv_batch(batch_iface, pkts, count);
+			count = 0;
+		}
+
+		batch_iface = iface;
+		pkts[count++] = pkt;
+	}
+
+	recv_batch(batch_iface, pkts, count);
+
+	return count == ARRAY_SIZE(pkts);
+}
+
+/* Raised by the HW models when the TAP device becomes readable */
+static void eth_isr(void *arg)
+{
+	struct eth_context *ctx = arg;
 
+	k_sem_give(&ctx->rx_sem);
+}
+
+static void eth_rx(struct eth_context *ctx)
+{
 	LOG_DBG("Starting ZETH RX thread");
 
 	while (1) {
+		k_sem_take(&ctx->rx_sem, K_FOREVER);
+
 		if (net_if_is_up(ctx->iface)) {
-			ret = eth_wait_data(ctx->dev_fd);
-			if (!ret) {
-				read_data(ctx, ctx->dev_fd);
+			while (read_batch(ctx)) {
+				/* More frames might be pending, let the
+				 * stack process the batch and continue
+				 * reading.
+				 */
+				k_yield();
+			}
+		} else {
+			/* Like a NIC which is down, drop the frames */
+			while (!eth_wait_data(ctx->dev_fd)) {
+				if (eth_read_data(ctx->dev_fd, ctx->recv,
+						  sizeof(ctx->recv)) <= 0) {
+					break;
+				}
 			}
 		}
 
-		k_sleep(K_MSEC(50));
+		/* Interrupt again when new frames arrive */
+		hw_fd_rearm(ctx->dev_fd);
 	}
 }
 
@@ -450,6 +524,12 @@ static void eth_iface_init(struct net_if *iface)
 	if (ctx->dev_fd < 0) {
 		LOG_ERR("Cannot create %s (%d)", ctx->if_name, ctx->dev_fd);
 	} else {
+		k_sem_init(&ctx->rx_sem, 0, 1);
+
+		IRQ_CONNECT(ETH_NATIVE_POSIX_IRQ, 2, eth_isr, ctx, 0);
+		irq_enable(ETH_NATIVE_POSIX_IRQ);
+		hw_fd_watch(ctx->dev_fd, ETH_NATIVE_POSIX_IRQ);
+
 		/* Create a thread that will handle incoming data from host */
 		create_rx_handler(ctx);
 
@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * Ethernet driver connecting native posix instances to each other over
+ * a shared memory link. Every instance attached to the same link sees the
+ * same Ethernet segment, which can be given a bandwidth, a delay and a
+ * loss rate. Unlike the TUN/TAP based driver this does not need any host
+ * network configuration or privileges.
+ */
+
+#define LOG_MODULE_NAME eth_shm
+#define LOG_LEVEL CONFIG_ETHERNET_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+
+#include <kernel.h>
+
+#include <stdbool.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <net/net_pkt.h>
+#include <net/net_core.h>
+#include <net/net_if.h>
+#include <net/ethernet.h>
+
+#include "eth_native_shm_priv.h"
+#include "ethernet/eth_stats.h"
+
+/* native_posix HW models */
+#include "soc.h"
+#include "cmdline.h"
+#include "posix_trace.h"
+#include "fd_model.h"
+
+#define _ETH_MTU 1500
+
+#define NET_BUF_TIMEOUT K_MSEC(100)
+
+#define ETH_SHM_SEED 0x5678
+
+/* Room left in a file name for the ".<node>" suffix of the doorbells */
+#define ETH_SHM_LINK_NAME_MAX 250
+
+struct eth_shm_context {
+	u8_t recv[ETH_NATIVE_SHM_FRAME_LEN];
+	u8_t send[ETH_NATIVE_SHM_FRAME_LEN];
+	u8_t mac_addr[6];
+	struct net_if *iface;
+	struct k_sem rx_sem;
+	int doorbell_fd;
+	bool init_done;
+
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+	struct net_stats_eth stats;
+#endif
+};
+
+NET_STACK_DEFINE(RX_ZSHM, eth_shm_rx_stack,
+		 CONFIG_ARCH_POSIX_RECOMMENDED_STACK_SIZE,
+		 CONFIG_ARCH_POSIX_RECOMMENDED_STACK_SIZE);
+static struct k_thread rx_thread_data;
+
+static struct eth_shm_context eth_shm_context_data;
+
+/* Set from the command line, the defaults are applied once parsed */
+static int node;
+static char *link_name;
+static struct eth_shm_params params;
+
+/* Frames to a node of the link are only signalled to that node, anything
+ * else is seen by every node.
+ */
+static int dst_node(struct eth_shm_context *ctx, struct net_eth_addr *dst)
+{
+	if (!memcmp(dst->addr, ctx->mac_addr, sizeof(ctx->mac_addr) - 1) &&
+	    dst->addr[5] >= ETH_NATIVE_SHM_NODE_MIN &&
+	    dst->addr[5] <= ETH_NATIVE_SHM_NODE_MAX) {
+		return dst->addr[5];
+	}
+
+	return ETH_NATIVE_SHM_NODE_ALL;
+}
+
+static int eth_shm_send_pkt(struct net_if *iface, struct net_pkt *pkt)
+{
+	struct eth_shm_context *ctx = net_if_get_device(iface)->driver_data;
+	struct net_eth_hdr *hdr = NET_ETH_HDR(pkt);
+	struct net_buf *frag;
+	int count;
+	int ret;
+
+	/* First fragment contains link layer (Ethernet) headers.
+	 */
+	count = net_pkt_ll_reserve(pkt) + pkt->frags->len;
+	memcpy(ctx->send, net_pkt_ll(pkt), count);
+
+	/* Then the remaining data */
+	frag = pkt->frags->frags;
+	while (frag) {
+		memcpy(ctx->send + count, frag->data, frag->len);
+		count += frag->len;
+		frag = frag->frags;
+	}
+
+	ret = eth_shm_send(ctx->send, count, dst_node(ctx, &hdr->dst));
+	if (ret < 0) {
+		LOG_DBG("Cannot send pkt %p (%d)", pkt, ret);
+		eth_stats_update_errors_tx(iface);
+		return ret;
+	}
+
+	eth_stats_update_bytes_tx(iface, count);
+	eth_stats_update_pkts_tx(iface);
+
+	if (IS_ENABLED(CONFIG_NET_STATISTICS_ETHERNET)) {
+		if (net_eth_is_addr_broadcast(&hdr->dst)) {
+			eth_stats_update_broadcast_tx(iface);
+		} else if (net_eth_is_addr_multicast(&hdr->dst)) {
+			eth_stats_update_multicast_tx(iface);
+		}
+	}
+
+	LOG_DBG("Send pkt %p len %d", pkt, count);
+
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static int eth_shm_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+	return 0;
+}
+
+static struct net_pkt *frame_to_pkt(struct eth_shm_context *ctx, int len)
+{
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+	int count = 0;
+
+	pkt = net_pkt_get_reserve_rx(0, NET_BUF_TIMEOUT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	do {
+		frag = net_pkt_get_frag(pkt, NET_BUF_TIMEOUT);
+		if (!frag) {
+			net_pkt_unref(pkt);
+			return NULL;
+		}
+
+		net_pkt_frag_add(pkt, frag);
+
+		net_buf_add_mem(frag, ctx->recv + count,
+				min(net_buf_tailroom(frag), len));
+		len -= frag->len;
+		count += frag->len;
+	} while (len > 0);
+
+	eth_stats_update_bytes_rx(ctx->iface, count);
+	eth_stats_update_pkts_rx(ctx->iface);
+
+	if (IS_ENABLED(CONFIG_NET_STATISTICS_ETHERNET)) {
+		struct net_eth_hdr *hdr = NET_ETH_HDR(pkt);
+
+		if (net_eth_is_addr_broadcast(&hdr->dst)) {
+			eth_stats_update_broadcast_rx(ctx->iface);
+		} else if (net_eth_is_addr_multicast(&hdr->dst)) {
+			eth_stats_update_multicast_rx(ctx->iface);
+		}
+	}
+
+	LOG_DBG("Recv pkt %p len %d", pkt, count);
+
+	return pkt;
+}
+
+/* Read the frames that have arrived and pass them to the stack in a
+ * batch. Returns true if the batch got full so that there might be more
+ * frames waiting.
+ */
+static bool read_batch(struct eth_shm_context *ctx, u32_t *wait_us)
+{
+	struct net_pkt *pkts[CONFIG_ETH_NATIVE_SHM_RX_BATCH];
+	struct net_pkt *pkt;
+	int count = 0;
+	int i, len;
+
+	while (count < ARRAY_SIZE(pkts)) {
+		len = eth_shm_recv(ctx->recv, sizeof(ctx->recv), wait_us);
+		if (!len) {
+			break;
+		}
+
+		if (len < 0) {
+			eth_stats_update_errors_rx(ctx->iface);
+			continue;
+		}
+
+		pkt = frame_to_pkt(ctx, len);
+		if (!pkt) {
+			eth_stats_update_errors_rx(ctx->iface);
+			continue;
+		}
+
+		pkts[count++] = pkt;
+	}
+
+	if (count && net_recv_data_batch(ctx->iface, pkts, count) < 0) {
+		for (i = 0; i < count; i++) {
+			net_pkt_unref(pkts[i]);
+		}
+	}
+
+	return count == ARRAY_SIZE(pkts);
+}
+
+/* Raised by the HW models when another node rings the doorbell */
+static void eth_shm_isr(void *arg)
+{
+	struct eth_shm_context *ctx = arg;
+
+	k_sem_give(&ctx->rx_sem);
+}
+
+static void eth_shm_rx(struct eth_shm_context *ctx)
+{
+	u32_t wait_us;
+
+	LOG_DBG("Starting ZSHM RX thread");
+
+	while (1) {
+		k_sem_take(&ctx->rx_sem, K_FOREVER);
+
+		do {
+			/* Doorbells rung after this are served on the next
+			 * interrupt.
+			 */
+			eth_shm_doorbell_clear();
+
+			if (!net_if_is_up(ctx->iface)) {
+				/* Like a NIC which is down, drop the frames */
+				while (eth_shm_recv(ctx->recv,
+						    sizeof(ctx->recv),
+						    &wait_us)) {
+				}
+
+				break;
+			}
+
+			while (read_batch(ctx, &wait_us)) {
+				/* More frames might be pending, let the
+				 * stack process the batch and continue
+				 * reading.
+				 */
+				k_yield();
+			}
+
+			/* The next frame is still on the wire, or still
+			 * being written by its sender.
+			 */
+			if (wait_us) {
+				k_sleep(K_MSEC((wait_us + 999) / 1000));
+			}
+		} while (wait_us);
+
+		/* Interrupt again when new frames arrive */
+		hw_fd_rearm(ctx->doorbell_fd);
+	}
+}
+
+static void eth_shm_iface_init(struct net_if *iface)
+{
+	struct eth_shm_context *ctx = net_if_get_device(iface)->driver_data;
+
+	ctx->iface = iface;
+
+	ethernet_init(iface);
+
+	if (ctx->init_done) {
+		return;
+	}
+
+	ctx->init_done = true;
+
+	/* Locally administered 02-00-5E-00-53-xx, the last byte being the
+	 * node id so that the addresses on the link are unique.
+	 */
+	ctx->mac_addr[0] = 0x02;
+	ctx->mac_addr[1] = 0x00;
+	ctx->mac_addr[2] = 0x5E;
+	ctx->mac_addr[3] = 0x00;
+	ctx->mac_addr[4] = 0x53;
+	ctx->mac_addr[5] = node;
+
+	net_if_set_link_addr(iface, ctx->mac_addr, sizeof(ctx->mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ctx->doorbell_fd = eth_shm_attach(link_name, node,
+					  CONFIG_ETH_NATIVE_SHM_SLOTS,
+					  &params);
+	if (ctx->doorbell_fd < 0) {
+		LOG_ERR("Cannot attach node %d to %s (%d)", node, link_name,
+			ctx->doorbell_fd);
+		return;
+	}
+
+	k_sem_init(&ctx->rx_sem, 0, 1);
+
+	IRQ_CONNECT(ETH_NATIVE_SHM_IRQ, 2, eth_shm_isr, ctx, 0);
+	irq_enable(ETH_NATIVE_SHM_IRQ);
+	hw_fd_watch(ctx->doorbell_fd, ETH_NATIVE_SHM_IRQ);
+
+	k_thread_create(&rx_thread_data, eth_shm_rx_stack,
+			K_THREAD_STACK_SIZEOF(eth_shm_rx_stack),
+			(k_thread_entry_t)eth_shm_rx,
+			ctx, NULL, NULL, K_PRIO_COOP(14),
+			0, K_NO_WAIT);
+}
+
+static enum ethernet_hw_caps eth_shm_get_capabilities(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return ETHERNET_LINK_10BASE_T | ETHERNET_LINK_100BASE_T;
+}
+
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+static struct net_stats_eth *eth_shm_get_stats(struct device *dev)
+{
+	struct eth_shm_context *context = dev->driver_data;
+
+	return &(context->stats);
+}
+#endif
+
+static const struct ethernet_api eth_shm_api = {
+	.iface_api.init = eth_shm_iface_init,
+	.iface_api.send = eth_shm_send_pkt,
+
+	.get_capabilities = eth_shm_get_capabilities,
+
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+	.get_stats = eth_shm_get_stats,
+#endif
+};
+
+ETH_NET_DEVICE_INIT(eth_native_shm, ETH_NATIVE_SHM_DRV_NAME,
+		    eth_shm_init, &eth_shm_context_data, NULL,
+		    CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &eth_shm_api,
+		    _ETH_MTU);
+
+static void add_eth_shm_options(void)
+{
+	static struct args_struct_t eth_shm_options[] = {
+		/*
+		 * Fields:
+		 * manual, mandatory, switch,
+		 * option_name, var_name ,type,
+		 * destination, callback,
+		 * description
+		 */
+		{false, true, false,
+		"eth-shm-node", "id", 'i',
+		(void *)&node, NULL,
+		"Node id of this instance on the shared memory link, "
+		"1 to 254. The MAC address ends with it"},
+		{false, false, false,
+		"eth-shm-link", "name", 's',
+		(void *)&link_name, NULL,
+		"Name of the shared memory link, instances given the same "
+		"name are connected. Default: "
+		"'" CONFIG_ETH_NATIVE_SHM_LINK_NAME "'"},
+		{false, false, false,
+		"eth-shm-bw", "kbps", 'u',
+		(void *)&params.bandwidth, NULL,
+		"Bandwidth of the shared memory link in kbit/s, 0 for "
+		"unlimited"},
+		{false, false, false,
+		"eth-shm-delay", "us", 'u',
+		(void *)&params.delay, NULL,
+		"Delay of the frames sent to the shared memory link in "
+		"microseconds"},
+		{false, false, false,
+		"eth-shm-loss", "ppm", 'u',
+		(void *)&params.loss, NULL,
+		"Probability of losing a received frame in parts per million"},
+		{false, false, false,
+		"eth-shm-seed", "r_seed", 'u',
+		(void *)&params.seed, NULL,
+		"Seed of the frame loss generator. With the same seed, the "
+		"frames at the same positions of those received are lost"},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(eth_shm_options);
+}
+
+static void eth_shm_check_options(void)
+{
+	/* The options not given are set to the largest value of their type,
+	 * or NULL.
+	 */
+	if (!link_name) {
+		link_name = ETH_NATIVE_SHM_LINK_NAME;
+	}
+
+	if (params.bandwidth == UINT32_MAX) {
+		params.bandwidth = CONFIG_ETH_NATIVE_SHM_BANDWIDTH;
+	}
+
+	if (params.delay == UINT32_MAX) {
+		params.delay = CONFIG_ETH_NATIVE_SHM_DELAY;
+	}
+
+	if (params.loss == UINT32_MAX) {
+		params.loss = CONFIG_ETH_NATIVE_SHM_LOSS;
+	}
+
+	if (params.seed == UINT32_MAX) {
+		params.seed = ETH_SHM_SEED;
+	}
+
+	if (!*link_name || strchr(link_name, '/') ||
+	    strlen(link_name) > ETH_SHM_LINK_NAME_MAX) {
+		posix_print_error_and_exit("Error: Invalid shared memory link "
+					   "name '%s'\n", link_name);
+	}
+
+	if (node == INT32_MAX) {
+		posix_print_error_and_exit("Error: The shared memory link "
+					   "needs --eth-shm-node\n");
+	}
+
+	if (node < ETH_NATIVE_SHM_NODE_MIN || node > ETH_NATIVE_SHM_NODE_MAX) {
+		posix_print_error_and_exit("Error: Invalid shared memory link "
+					   "node %d (should be 1 to 254)\n",
+					   node);
+	}
+
+	if (params.loss > 1000000) {
+		posix_print_error_and_exit("Error: Invalid shared memory link "
+					   "loss %u ppm\n", params.loss);
+	}
+}
+
+static void eth_shm_cleanup(void)
+{
+	eth_shm_detach();
+}
+
+NATIVE_TASK(add_eth_shm_options, PRE_BOOT_1, 10);
+NATIVE_TASK(eth_shm_check_options, PRE_BOOT_2, 10);
+NATIVE_TASK(eth_shm_cleanup, ON_EXIT, 10);
@@ -0,0 +1,585 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * Host side of the native posix shared memory link. The link is a POSIX
+ * shared memory segment holding a ring of frame slots which every attached
+ * process writes to and reads from. Writers claim a slot by incrementing
+ * the ring head and publish the frame by storing its sequence number in the
+ * slot, so no locks are needed. Each reader keeps its own position in the
+ * ring; a reader that falls more than a ring behind loses frames, like a
+ * NIC running out of receive descriptors.
+ *
+ * A reader is woken up through a per node FIFO (the doorbell) which the
+ * native_posix HW models watch for it.
+ *
+ * The segment counts the processes attached to it, the last one to detach
+ * removes it.
+ */
+
+/* Host include files */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "posix_trace.h"
+
+/* Zephyr include files. Be very careful here and only include minimum
+ * things needed.
+ */
+#define LOG_MODULE_NAME eth_shm_adapt
+#define LOG_LEVEL CONFIG_ETHERNET_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <zephyr/types.h>
+#include <misc/util.h>
+
+#include "eth_native_shm_priv.h"
+
+#define SHM_MAGIC 0x7a73686d /* "zshm" */
+
+/* Directory of the doorbell FIFOs, next to the shared memory segment */
+#define SHM_DOORBELL_DIR "/dev/shm"
+
+/* How long a process waits for the creator of the segment to set it up */
+#define SHM_SETUP_TIMEOUT_MS 1000
+
+/* Frames are dropped when more than this much transmit time is queued,
+ * which bounds the latency of a link that is sent to faster than its
+ * bandwidth.
+ */
+#define SHM_TX_BACKLOG_US 100000
+
+/* A slot claimed by a writer is polled at this interval until published.
+ * The writer only rings the nodes the frame is for, so the readers held
+ * up by the slot would otherwise miss the doorbell of the frames behind
+ * it.
+ */
+#define SHM_WRITE_WAIT_US 100
+
+struct shm_slot {
+	/* Sequence number of the frame plus one, zero while being written */
+	u64_t seq;
+	/* Host time in microseconds when the frame reaches the receivers */
+	u64_t due;
+	u16_t len;
+	u8_t src;
+	u8_t dst;
+	u8_t data[ETH_NATIVE_SHM_FRAME_LEN];
+};
+
+struct shm_header {
+	u32_t magic;
+	u32_t slot_count;
+	/* Number of processes attached, never raised again once zero */
+	u32_t users;
+	/* Sequence number of the next frame to be written */
+	u64_t head;
+	/* Nodes which have their doorbell set up */
+	u8_t attached[ETH_NATIVE_SHM_NODE_MAX + 1];
+	struct shm_slot slot[];
+};
+
+static struct {
+	struct shm_header *hdr;
+	size_t size;
+	struct eth_shm_params params;
+	/* Sequence number of the next frame to read */
+	u64_t cursor;
+	/* Host time when the previous frame has been transmitted */
+	u64_t busy_until;
+	u32_t rand;
+	int node;
+	int doorbell;
+	int peer[ETH_NATIVE_SHM_NODE_MAX + 1];
+	char name[NAME_MAX];
+} shm_link = {
+	.doorbell = -1,
+};
+
+static u64_t host_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Losses are drawn from a generator seeded per node so that a run can be
+ * repeated with the same loss pattern.
+ */
+static bool shm_frame_lost(void)
+{
+	u32_t x = shm_link.rand;
+
+	if (!shm_link.params.loss) {
+		return false;
+	}
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	shm_link.rand = x;
+
+	return x % 1000000 < shm_link.params.loss;
+}
+
+static void doorbell_path(char *path, size_t len, int node)
+{
+	snprintf(path, len, SHM_DOORBELL_DIR "/%s.%d", shm_link.name, node);
+}
+
+static void shm_ring(int node)
+{
+	char path[PATH_MAX];
+	u8_t bell = 0;
+
+	if (shm_link.peer[node] < 0) {
+		doorbell_path(path, sizeof(path), node);
+
+		/* Fails if the node is not running */
+		shm_link.peer[node] = open(path, O_WRONLY | O_NONBLOCK);
+		if (shm_link.peer[node] < 0) {
+			return;
+		}
+	}
+
+	/* A full FIFO means the node has not yet served earlier doorbells,
+	 * so it will see the new frame anyway.
+	 */
+	if (write(shm_link.peer[node], &bell, sizeof(bell)) < 0 &&
+	    errno != EAGAIN) {
+		/* The node went away, look up its doorbell again next time */
+		close(shm_link.peer[node]);
+		shm_link.peer[node] = -1;
+	}
+}
+
+static void shm_unmap(void)
+{
+	munmap(shm_link.hdr, shm_link.size);
+	shm_link.hdr = NULL;
+}
+
+/* Joins a segment unless its last user is removing it */
+static bool shm_join(void)
+{
+	u32_t users = __atomic_load_n(&shm_link.hdr->users, __ATOMIC_RELAXED);
+
+	do {
+		if (!users) {
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(&shm_link.hdr->users, &users,
+					      users + 1, false,
+					      __ATOMIC_ACQ_REL,
+					      __ATOMIC_RELAXED));
+
+	return true;
+}
+
+static int shm_wait_ready(int fd, u32_t slot_count)
+{
+	int retries = SHM_SETUP_TIMEOUT_MS;
+	struct stat st;
+
+	/* The segment is empty until its creator has sized it */
+	do {
+		if (fstat(fd, &st) < 0) {
+			return -errno;
+		}
+
+		if (st.st_size) {
+			break;
+		}
+
+		usleep(1000);
+	} while (--retries);
+
+	if (st.st_size != shm_link.size) {
+		return -EINVAL;
+	}
+
+	shm_link.hdr = mmap(NULL, shm_link.size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED, fd, 0);
+	if (shm_link.hdr == MAP_FAILED) {
+		shm_link.hdr = NULL;
+		return -errno;
+	}
+
+	while (__atomic_load_n(&shm_link.hdr->magic, __ATOMIC_ACQUIRE) !=
+	       SHM_MAGIC) {
+		if (!--retries) {
+			shm_unmap();
+			return -ETIMEDOUT;
+		}
+
+		usleep(1000);
+	}
+
+	if (shm_link.hdr->slot_count != slot_count) {
+		shm_unmap();
+		return -EINVAL;
+	}
+
+	if (!shm_join()) {
+		shm_unmap();
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+static void shm_path(char *path, size_t len)
+{
+	snprintf(path, len, "/%s", shm_link.name);
+}
+
+static int shm_map(u32_t slot_count)
+{
+	int retries = SHM_SETUP_TIMEOUT_MS;
+	char path[NAME_MAX + 1];
+	int fd, ret;
+
+	shm_link.size = sizeof(struct shm_header) +
+		slot_count * sizeof(struct shm_slot);
+
+	shm_path(path, sizeof(path));
+
+	while (1) {
+		fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) {
+			break;
+		}
+
+		if (errno != EEXIST) {
+			return -errno;
+		}
+
+		/* Another node created the link, or a previous run left it
+		 * behind. Either way it is joined as is.
+		 */
+		fd = shm_open(path, O_RDWR, 0);
+		if (fd < 0) {
+			if (errno != ENOENT) {
+				return -errno;
+			}
+
+			/* Removed in the meantime */
+			continue;
+		}
+
+		ret = shm_wait_ready(fd, slot_count);
+		close(fd);
+
+		if (ret != -EAGAIN) {
+			return ret;
+		}
+
+		/* Its last user is detaching, wait until it is removed */
+		if (!--retries) {
+			return -ETIMEDOUT;
+		}
+
+		usleep(1000);
+	}
+
+	if (ftruncate(fd, shm_link.size) < 0) {
+		ret = -errno;
+		goto fail;
+	}
+
+	shm_link.hdr = mmap(NULL, shm_link.size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED, fd, 0);
+	if (shm_link.hdr == MAP_FAILED) {
+		shm_link.hdr = NULL;
+		ret = -errno;
+		goto fail;
+	}
+
+	close(fd);
+
+	/* The segment is zero filled, which leaves every slot empty */
+	shm_link.hdr->slot_count = slot_count;
+	shm_link.hdr->users = 1;
+	__atomic_store_n(&shm_link.hdr->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	return 0;
+
+fail:
+	close(fd);
+	shm_unlink(path);
+
+	return ret;
+}
+
+int eth_shm_attach(const char *name, int node, u32_t slots,
+		   const struct eth_shm_params *params)
+{
+	char path[PATH_MAX];
+	int i, ret;
+
+	strncpy(shm_link.name, name, sizeof(shm_link.name) - 1);
+	shm_link.node = node;
+	shm_link.params = *params;
+	shm_link.rand = params->seed ^ (node * 0x9e3779b9);
+	if (!shm_link.rand) {
+		shm_link.rand = 1;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(shm_link.peer); i++) {
+		shm_link.peer[i] = -1;
+	}
+
+	ret = shm_map(slots);
+	if (ret < 0) {
+		LOG_ERR("Cannot map link %s (%d), remove " SHM_DOORBELL_DIR
+			"/%s if an instance killed before detaching left it "
+			"with another slot count", name, ret, name);
+		goto fail;
+	}
+
+	doorbell_path(path, sizeof(path), node);
+
+	if (mkfifo(path, 0600) < 0 && errno != EEXIST) {
+		ret = -errno;
+		goto fail;
+	}
+
+	/* Opened for writing too so that the FIFO never reports EOF */
+	shm_link.doorbell = open(path, O_RDWR | O_NONBLOCK);
+	if (shm_link.doorbell < 0) {
+		ret = -errno;
+		goto fail;
+	}
+
+	/* Writing to the doorbell of a node which has just exited must not
+	 * terminate this one.
+	 */
+	signal(SIGPIPE, SIG_IGN);
+
+	if (shm_link.hdr->attached[node]) {
+		LOG_WRN("Node %d is already attached to %s", node, name);
+	}
+
+	__atomic_store_n(&shm_link.hdr->attached[node], 1, __ATOMIC_RELEASE);
+
+	/* Only frames sent from now on are received */
+	shm_link.cursor = __atomic_load_n(&shm_link.hdr->head,
+					  __ATOMIC_ACQUIRE);
+
+	return shm_link.doorbell;
+
+fail:
+	eth_shm_detach();
+
+	return ret;
+}
+
+void eth_shm_detach(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(shm_link.peer); i++) {
+		if (shm_link.peer[i] >= 0) {
+			close(shm_link.peer[i]);
+			shm_link.peer[i] = -1;
+		}
+	}
+
+	if (shm_link.doorbell >= 0) {
+		close(shm_link.doorbell);
+		shm_link.doorbell = -1;
+
+		doorbell_path(path, sizeof(path), shm_link.node);
+		unlink(path);
+	}
+
+	if (shm_link.hdr) {
+		__atomic_store_n(&shm_link.hdr->attached[shm_link.node], 0,
+				 __ATOMIC_RELEASE);
+
+		/* Nodes attaching later create a new segment, so that one
+		 * with another slot count can take its place.
+		 */
+		if (!__atomic_sub_fetch(&shm_link.hdr->users, 1,
+					__ATOMIC_ACQ_REL)) {
+			shm_path(path, sizeof(path));
+			shm_unlink(path);
+		}
+
+		shm_unmap();
+	}
+}
+
+int eth_shm_send(const void *frame, u16_t len, int dst)
+{
+	struct shm_header *hdr = shm_link.hdr;
+	struct shm_slot *slot;
+	u64_t now, start, seq;
+	int i;
+
+	if (!hdr) {
+		return -ENETDOWN;
+	}
+
+	if (len > ETH_NATIVE_SHM_FRAME_LEN) {
+		return -EMSGSIZE;
+	}
+
+	/* The frame is transmitted once the previous ones are done, and
+	 * takes the time needed to send it at the link bandwidth.
+	 */
+	now = host_time_us();
+	start = shm_link.busy_until > now ? shm_link.busy_until : now;
+
+	if (start - now > SHM_TX_BACKLOG_US) {
+		return -ENOBUFS;
+	}
+
+	if (shm_link.params.bandwidth) {
+		start += (u64_t)len * 8 * 1000 / shm_link.params.bandwidth;
+	}
+
+	shm_link.busy_until = start;
+
+	seq = __atomic_fetch_add(&hdr->head, 1, __ATOMIC_RELAXED);
+	slot = &hdr->slot[seq % hdr->slot_count];
+
+	/* Readers copying the slot see that it changed under them */
+	__atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->due = start + shm_link.params.delay;
+	slot->len = len;
+	slot->src = shm_link.node;
+	slot->dst = dst;
+	memcpy(slot->data, frame, len);
+
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+
+	if (dst != ETH_NATIVE_SHM_NODE_ALL) {
+		if (__atomic_load_n(&hdr->attached[dst], __ATOMIC_RELAXED)) {
+			shm_ring(dst);
+		}
+
+		return 0;
+	}
+
+	for (i = ETH_NATIVE_SHM_NODE_MIN; i <= ETH_NATIVE_SHM_NODE_MAX; i++) {
+		if (i != shm_link.node &&
+		    __atomic_load_n(&hdr->attached[i], __ATOMIC_RELAXED)) {
+			shm_ring(i);
+		}
+	}
+
+	return 0;
+}
+
+/* Returns the length of the next frame for this node, 0 if there is none
+ * or -ENOBUFS if frames were overwritten before they could be read. If the
+ * next frame is still in flight or being written, wait_us is set to the
+ * time after which to try again.
+ */
+int eth_shm_recv(void *buf, u16_t buf_len, u32_t *wait_us)
+{
+	struct shm_header *hdr = shm_link.hdr;
+	struct shm_slot *slot;
+	u64_t head, seq, now;
+	u16_t len;
+
+	*wait_us = 0;
+
+	if (!hdr) {
+		return 0;
+	}
+
+	while (1) {
+		head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+		if (shm_link.cursor >= head) {
+			return 0;
+		}
+
+		if (head - shm_link.cursor > hdr->slot_count) {
+			shm_link.cursor = head - hdr->slot_count;
+			return -ENOBUFS;
+		}
+
+		slot = &hdr->slot[shm_link.cursor % hdr->slot_count];
+
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq > shm_link.cursor + 1) {
+			shm_link.cursor++;
+			return -ENOBUFS;
+		}
+
+		if (seq != shm_link.cursor + 1) {
+			/* Still being written, and its doorbell might be
+			 * rung for another node only.
+			 */
+			*wait_us = SHM_WRITE_WAIT_US;
+			return 0;
+		}
+
+		if (slot->src == shm_link.node ||
+		    (slot->dst != shm_link.node &&
+		     slot->dst != ETH_NATIVE_SHM_NODE_ALL)) {
+			shm_link.cursor++;
+			continue;
+		}
+
+		now = host_time_us();
+		if (slot->due > now) {
+			*wait_us = min(slot->due - now, UINT32_MAX);
+			return 0;
+		}
+
+		len = slot->len;
+		if (len <= buf_len) {
+			memcpy(buf, slot->data, len);
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+			shm_link.cursor++;
+			return -ENOBUFS;
+		}
+
+		shm_link.cursor++;
+
+		if (len > buf_len) {
+			return -EMSGSIZE;
+		}
+
+		if (shm_frame_lost()) {
+			continue;
+		}
+
+		return len;
+	}
+}
+
+void eth_shm_doorbell_clear(void)
+{
+	u8_t bells[64];
+
+	while (read(shm_link.doorbell, bells, sizeof(bells)) > 0) {
+	}
+}
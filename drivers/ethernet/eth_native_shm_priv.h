@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file
+ * @brief Private functions for native posix shared memory link driver.
+ */
+
+#ifndef ZEPHYR_DRIVERS_ETHERNET_ETH_NATIVE_SHM_PRIV_H_
+#define ZEPHYR_DRIVERS_ETHERNET_ETH_NATIVE_SHM_PRIV_H_
+
+#define ETH_NATIVE_SHM_DRV_NAME CONFIG_ETH_NATIVE_SHM_DRV_NAME
+#define ETH_NATIVE_SHM_LINK_NAME CONFIG_ETH_NATIVE_SHM_LINK_NAME
+
+/* Largest frame carried over the link, a VLAN tagged Ethernet frame */
+#define ETH_NATIVE_SHM_FRAME_LEN 1518
+
+/* Valid node ids, the MAC address of a node ends with its id */
+#define ETH_NATIVE_SHM_NODE_MIN 1
+#define ETH_NATIVE_SHM_NODE_MAX 254
+
+/* Destination used for frames which every node receives */
+#define ETH_NATIVE_SHM_NODE_ALL 255
+
+struct eth_shm_params {
+	/* Link bandwidth in kbit/s, 0 for unlimited */
+	u32_t bandwidth;
+	/* Propagation delay in microseconds */
+	u32_t delay;
+	/* Receive loss probability in parts per million */
+	u32_t loss;
+	/* Seed of the loss generator */
+	u32_t seed;
+};
+
+int eth_shm_attach(const char *name, int node, u32_t slots,
+		   const struct eth_shm_params *params);
+void eth_shm_detach(void);
+int eth_shm_send(const void *frame, u16_t len, int dst);
+int eth_shm_recv(void *buf, u16_t buf_len, u32_t *wait_us);
+void eth_shm_doorbell_clear(void);
+
+#endif /* ZEPHYR_DRIVERS_ETHERNET_ETH_NATIVE_SHM_PRIV_H_ */
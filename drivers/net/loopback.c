@@ -21,6 +21,134 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #include <net/buf.h>
 #include <net/net_ip.h>
 #include <net/net_if.h>
+#include <net/loopback.h>
+
+#if defined(CONFIG_NET_LOOPBACK_SIMULATE_PACKET_DROP)
+static u32_t drop_ratio;
+static u32_t drop_acc;
+static u32_t dropped;
+
+int loopback_set_packet_drop_ratio(u32_t ratio)
+{
+	if (ratio > 1000) {
+		return -EINVAL;
+	}
+
+	drop_ratio = ratio;
+	drop_acc = 0;
+
+	return 0;
+}
+
+u32_t loopback_get_num_dropped_packets(void)
+{
+	return dropped;
+}
+
+static bool loopback_drop_packet(void)
+{
+	drop_acc += drop_ratio;
+	if (drop_acc < 1000) {
+		return false;
+	}
+
+	drop_acc -= 1000;
+	dropped++;
+
+	return true;
+}
+#else
+#define loopback_drop_packet() false
+#endif /* CONFIG_NET_LOOPBACK_SIMULATE_PACKET_DROP */
+
+#if defined(CONFIG_NET_LOOPBACK_SIMULATE_DELAY)
+#define DELAY_QUEUE_SIZE CONFIG_NET_LOOPBACK_DELAY_QUEUE_SIZE
+
+static struct {
+	struct net_if *iface;
+	struct net_pkt *pkt;
+	u32_t due;
+} delay_queue[DELAY_QUEUE_SIZE];
+
+static u32_t delay_head;
+static u32_t delay_tail;
+static u32_t delay_ms;
+
+static K_SEM_DEFINE(delay_sem, 0, DELAY_QUEUE_SIZE);
+
+void loopback_set_delay(u32_t delay)
+{
+	delay_ms = delay;
+}
+
+static int loopback_delay_packet(struct net_if *iface, struct net_pkt *pkt)
+{
+	unsigned int key;
+	u32_t idx;
+
+	key = irq_lock();
+
+	if (delay_tail - delay_head >= DELAY_QUEUE_SIZE) {
+		irq_unlock(key);
+		return -ENOBUFS;
+	}
+
+	idx = delay_tail++ % DELAY_QUEUE_SIZE;
+
+	delay_queue[idx].iface = iface;
+	delay_queue[idx].pkt = pkt;
+	delay_queue[idx].due = k_uptime_get_32() + delay_ms;
+
+	irq_unlock(key);
+
+	k_sem_give(&delay_sem);
+
+	return 0;
+}
+
+/* The delay is the same for all the packets, so they are due in the
+ * order they were queued.
+ */
+static void loopback_delay_thread(void *p1, void *p2, void *p3)
+{
+	struct net_pkt *pkt;
+	struct net_if *iface;
+	unsigned int key;
+	s32_t remaining;
+	u32_t idx;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (1) {
+		k_sem_take(&delay_sem, K_FOREVER);
+
+		idx = delay_head % DELAY_QUEUE_SIZE;
+
+		remaining = delay_queue[idx].due - k_uptime_get_32();
+		if (remaining > 0) {
+			k_sleep(remaining);
+		}
+
+		iface = delay_queue[idx].iface;
+		pkt = delay_queue[idx].pkt;
+
+		key = irq_lock();
+		delay_head++;
+		irq_unlock(key);
+
+		if (net_recv_data(iface, pkt) < 0) {
+			LOG_ERR("Data receive failed.");
+			net_pkt_unref(pkt);
+		}
+	}
+}
+
+K_THREAD_DEFINE(loopback_delay, CONFIG_NET_LOOPBACK_DELAY_STACK_SIZE,
+		loopback_delay_thread, NULL, NULL, NULL,
+		K_PRIO_COOP(7), 0, K_NO_WAIT);
+#endif /* CONFIG_NET_LOOPBACK_SIMULATE_DELAY */
 
 int loopback_dev_init(struct device *dev)
 {
@@ -44,6 +172,12 @@ static int loopback_send(struct net_if *iface, struct net_pkt *pkt)
 		return -ENODATA;
 	}
 
+	if (loopback_drop_packet()) {
+		LOG_DBG("Dropping pkt %p", pkt);
+		net_pkt_unref(pkt);
+		return 0;
+	}
+
 	/* We need to swap the IP addresses because otherwise
 	 * the packet will be dropped.
 	 */
@@ -75,6 +209,19 @@ static int loopback_send(struct net_if *iface, struct net_pkt *pkt)
 		goto out;
 	}
 
+#if defined(CONFIG_NET_LOOPBACK_SIMULATE_DELAY)
+	if (delay_ms) {
+		if (loopback_delay_packet(iface, cloned) < 0) {
+			LOG_DBG("Delay queue full, dropping pkt %p", pkt);
+			net_pkt_unref(cloned);
+		}
+
+		net_pkt_unref(pkt);
+		res = 0;
+		goto out;
+	}
+#endif
+
 	res = net_recv_data(iface, cloned);
 	if (res < 0) {
 		LOG_ERR("Data receive failed.");
@@ -22,6 +22,12 @@
 #define MBEDTLS_PLATFORM_PRINTF_ALT
 #define MBEDTLS_PLATFORM_SNPRINTF_ALT
 
+#if defined(CONFIG_MBEDTLS_MEMORY_DEBUG)
+#define MBEDTLS_MEMORY_DEBUG
+/* Heap errors are reported with fprintf() */
+#include <stdio.h>
+#endif
+
 #if !defined(CONFIG_ARM)
 #define MBEDTLS_HAVE_ASM
 #endif
@@ -67,6 +73,15 @@
 #define MBEDTLS_SSL_COOKIE_C
 #endif
 
+#if defined(CONFIG_TLS_SESSION_CACHE)
+#define MBEDTLS_SSL_CACHE_C
+#endif
+
+#if defined(CONFIG_TLS_SESSION_TICKETS)
+#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_TICKET_C
+#endif
+
 /* Supported key exchange methods */
 
 #if defined(CONFIG_TLS_KEY_EXCHANGE_PSK_ENABLED)
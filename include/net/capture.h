@@ -0,0 +1,279 @@
+/** @file
+ * @brief Network packet capture
+ *
+ * An API to record the packets sent and received by the network
+ * interfaces, and to export them in pcapng format.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_CAPTURE_H_
+#define ZEPHYR_INCLUDE_NET_CAPTURE_H_
+
+/**
+ * @brief Network packet capture
+ * @defgroup net_capture Network packet capture
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <errno.h>
+#include <device.h>
+#include <net/net_if.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Capture the received packets */
+#define NET_CAPTURE_RX BIT(0)
+
+/** Capture the sent packets */
+#define NET_CAPTURE_TX BIT(1)
+
+/**
+ * @brief Filter instruction.
+ *
+ * The filter is a classic BPF program, with the same encoding as the
+ * struct sock_filter of Linux, so the output of "tcpdump -dd" can be used
+ * as is. The program runs on the packet starting from its link layer
+ * header, the packet is captured if the program returns a non zero value.
+ *
+ * All the instructions are supported, except the ones using the scratch
+ * memory and the extensions of Linux.
+ */
+struct net_capture_insn {
+	/** Operation code */
+	u16_t code;
+
+	/** Jump offset if the condition is true */
+	u8_t jt;
+
+	/** Jump offset if the condition is false */
+	u8_t jf;
+
+	/** Constant operand */
+	u32_t k;
+};
+
+/* Instruction classes */
+#define BPF_CLASS(code) ((code) & 0x07)
+#define BPF_LD   0x00
+#define BPF_LDX  0x01
+#define BPF_ALU  0x04
+#define BPF_JMP  0x05
+#define BPF_RET  0x06
+#define BPF_MISC 0x07
+
+/* Load sizes */
+#define BPF_SIZE(code) ((code) & 0x18)
+#define BPF_W 0x00
+#define BPF_H 0x08
+#define BPF_B 0x10
+
+/* Load modes */
+#define BPF_MODE(code) ((code) & 0xe0)
+#define BPF_IMM 0x00
+#define BPF_ABS 0x20
+#define BPF_IND 0x40
+#define BPF_LEN 0x80
+#define BPF_MSH 0xa0
+
+/* ALU operations and jumps */
+#define BPF_OP(code) ((code) & 0xf0)
+#define BPF_ADD  0x00
+#define BPF_SUB  0x10
+#define BPF_MUL  0x20
+#define BPF_DIV  0x30
+#define BPF_OR   0x40
+#define BPF_AND  0x50
+#define BPF_LSH  0x60
+#define BPF_RSH  0x70
+#define BPF_NEG  0x80
+#define BPF_MOD  0x90
+#define BPF_XOR  0xa0
+#define BPF_JA   0x00
+#define BPF_JEQ  0x10
+#define BPF_JGT  0x20
+#define BPF_JGE  0x30
+#define BPF_JSET 0x40
+
+/* Operand sources */
+#define BPF_SRC(code) ((code) & 0x08)
+#define BPF_K 0x00
+#define BPF_X 0x08
+
+/* Return values */
+#define BPF_RVAL(code) ((code) & 0x18)
+#define BPF_A 0x10
+
+/* Register transfers */
+#define BPF_MISCOP(code) ((code) & 0xf8)
+#define BPF_TAX 0x00
+#define BPF_TXA 0x80
+
+/** Filter statement */
+#define NET_CAPTURE_STMT(_code, _k) \
+	{ .code = (_code), .jt = 0, .jf = 0, .k = (_k) }
+
+/** Filter jump */
+#define NET_CAPTURE_JUMP(_code, _k, _jt, _jf) \
+	{ .code = (_code), .jt = (_jt), .jf = (_jf), .k = (_k) }
+
+/** Capture statistics */
+struct net_capture_stats {
+	/** Packets written to the capture buffer */
+	u32_t captured;
+
+	/** Packets rejected by the filter */
+	u32_t filtered;
+
+	/** Packets lost because the capture buffer was full */
+	u32_t dropped;
+
+	/** Packets exported */
+	u32_t exported;
+};
+
+/**
+ * @typedef net_capture_write_cb_t
+ * @brief Callback writing the exported capture.
+ *
+ * @param data Data to write
+ * @param len Length of the data
+ * @param user_data User data given to net_capture_export()
+ *
+ * @return 0 if ok, <0 if error, which stops the export.
+ */
+typedef int (*net_capture_write_cb_t)(const void *data, size_t len,
+				      void *user_data);
+
+#if defined(CONFIG_NET_CAPTURE)
+
+/**
+ * @brief Start capturing packets.
+ *
+ * @param iface Network interface to capture, NULL to capture all of them
+ * @param dir Directions to capture, NET_CAPTURE_RX and/or NET_CAPTURE_TX
+ *
+ * @return 0 if ok, <0 if error
+ */
+int net_capture_start(struct net_if *iface, u8_t dir);
+
+/**
+ * @brief Stop capturing packets.
+ *
+ * The packets already captured stay in the capture buffer until they
+ * are exported or cleared.
+ */
+void net_capture_stop(void);
+
+/**
+ * @brief Check if packets are being captured.
+ *
+ * @return True if capture is active, False otherwise
+ */
+bool net_capture_is_active(void);
+
+/**
+ * @brief Set the capture filter.
+ *
+ * The program is copied. It is checked before being used: it must end
+ * with a return, its jumps must stay in the program and it must only use
+ * supported instructions.
+ *
+ * @param prog Filter program, NULL to capture all packets
+ * @param count Number of instructions
+ *
+ * @return 0 if ok, -EINVAL if the program is invalid, -ENOMEM if it is
+ * longer than CONFIG_NET_CAPTURE_FILTER_LEN, -EBUSY if capture is active.
+ */
+int net_capture_set_filter(const struct net_capture_insn *prog,
+			   size_t count);
+
+/**
+ * @brief Export the captured packets in pcapng format.
+ *
+ * The export starts with a section header and a description of every
+ * network interface, followed by the captured packets. The exported
+ * packets are removed from the capture buffer. Packets can be captured
+ * during the export, only one export can run at a time.
+ *
+ * @param cb Callback writing the exported data
+ * @param user_data User data given to the callback
+ *
+ * @return Number of exported packets if ok, <0 if error
+ */
+int net_capture_export(net_capture_write_cb_t cb, void *user_data);
+
+#if defined(CONFIG_SERIAL)
+/**
+ * @brief Export the captured packets to a UART.
+ *
+ * @param dev UART device
+ *
+ * @return Number of exported packets if ok, <0 if error
+ */
+int net_capture_export_uart(struct device *dev);
+#endif
+
+#if defined(CONFIG_FILE_SYSTEM)
+/**
+ * @brief Export the captured packets to a file.
+ *
+ * The file is created or overwritten.
+ *
+ * @param path Path of the file
+ *
+ * @return Number of exported packets if ok, <0 if error
+ */
+int net_capture_export_file(const char *path);
+#endif
+
+/**
+ * @brief Remove all the captured packets from the capture buffer.
+ */
+void net_capture_clear(void);
+
+/**
+ * @brief Get the capture statistics.
+ *
+ * @param stats Statistics are copied here.
+ */
+void net_capture_get_stats(struct net_capture_stats *stats);
+
+#else /* CONFIG_NET_CAPTURE */
+
+static inline int net_capture_start(struct net_if *iface, u8_t dir)
+{
+	ARG_UNUSED(iface);
+	ARG_UNUSED(dir);
+
+	return -ENOTSUP;
+}
+
+static inline void net_capture_stop(void)
+{
+}
+
+static inline bool net_capture_is_active(void)
+{
+	return false;
+}
+
+#endif /* CONFIG_NET_CAPTURE */
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_CAPTURE_H_ */
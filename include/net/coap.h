@@ -72,6 +72,7 @@ enum coap_method {
 	COAP_METHOD_POST = 2,
 	COAP_METHOD_PUT = 3,
 	COAP_METHOD_DELETE = 4,
+	COAP_METHOD_FETCH = 5,
 };
 
 #define COAP_REQUEST_MASK 0x07
@@ -183,6 +184,10 @@ struct coap_resource {
 	void *user_data;
 	sys_slist_t observers;
 	int age;
+#if defined(CONFIG_COAP_INDEX)
+	sys_snode_t index_node;
+	u32_t path_hash;
+#endif
 };
 
 /**
@@ -193,6 +198,9 @@ struct coap_observer {
 	struct sockaddr addr;
 	u8_t token[8];
 	u8_t tkl;
+#if defined(CONFIG_COAP_INDEX)
+	sys_snode_t index_node;
+#endif
 };
 
 /**
@@ -224,6 +232,9 @@ struct coap_pending {
 	struct sockaddr addr;
 	s32_t timeout;
 	u16_t id;
+#if defined(CONFIG_COAP_INDEX)
+	sys_snode_t index_node;
+#endif
 };
 
 /**
@@ -237,8 +248,26 @@ struct coap_reply {
 	u8_t token[8];
 	u16_t id;
 	u8_t tkl;
+#if defined(CONFIG_COAP_INDEX)
+	sys_snode_t index_node;
+#endif
 };
 
+#if defined(CONFIG_COAP_INDEX)
+/**
+ * @brief Hash table of resources, observers, pending requests or replies.
+ *
+ * The lookups of coap_handle_request(), coap_find_observer_by_addr(),
+ * coap_pending_received() and coap_response_received() scan the arrays
+ * they are given. An index finds the same entries without a scan. Each
+ * index holds one kind of entries, which stay in the arrays of the
+ * application.
+ */
+struct coap_index {
+	sys_slist_t buckets[CONFIG_COAP_INDEX_SIZE];
+};
+#endif
+
 /**
  * @brief Indicates that the remote device referenced by @a addr, with
  * @a request, wants to observe a resource.
@@ -491,6 +520,150 @@ int coap_handle_request(struct coap_packet *cpkt,
 			struct coap_option *options,
 			u8_t opt_num);
 
+#if defined(CONFIG_COAP_INDEX)
+/**
+ * @brief Initialize an empty index.
+ *
+ * @param index Index to initialize
+ */
+void coap_index_init(struct coap_index *index);
+
+/**
+ * @brief Add resources to an index, keyed on their path.
+ *
+ * @param index Index of resources
+ * @param resources Array of resources, terminated by a resource with a
+ * NULL path
+ *
+ * @return Number of resources added.
+ */
+int coap_index_add_resources(struct coap_index *index,
+			     struct coap_resource *resources);
+
+/**
+ * @brief When a request is received, call the appropriate method of
+ * the matching resource of an index.
+ *
+ * @details Same as coap_handle_request(), except that the resource is
+ * found from the hash of the URI path of the request.
+ *
+ * @param cpkt Packet received
+ * @param index Index of the known resources
+ * @param options Parsed options from coap_packet_parse()
+ * @param opt_num Number of options
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_index_handle_request(struct coap_packet *cpkt,
+			      struct coap_index *index,
+			      struct coap_option *options,
+			      u8_t opt_num);
+
+/**
+ * @brief Add an observer to an index, keyed on its address.
+ *
+ * @param index Index of observers
+ * @param observer Observer initialized with coap_observer_init()
+ */
+void coap_index_add_observer(struct coap_index *index,
+			     struct coap_observer *observer);
+
+/**
+ * @brief Remove an observer from an index.
+ *
+ * @param index Index of observers
+ * @param observer Observer to remove
+ */
+void coap_index_remove_observer(struct coap_index *index,
+				struct coap_observer *observer);
+
+/**
+ * @brief Returns the observer of an index that matches the @a addr.
+ *
+ * @param index Index of observers
+ * @param addr Address of the endpoint observing a resource
+ *
+ * @return A pointer to a observer if a match is found, NULL
+ * otherwise.
+ */
+struct coap_observer *coap_index_find_observer_by_addr(
+	struct coap_index *index, const struct sockaddr *addr);
+
+/**
+ * @brief Add a pending request to an index, keyed on its message ID.
+ *
+ * @param index Index of pending requests
+ * @param pending Pending request initialized with coap_pending_init()
+ */
+void coap_index_add_pending(struct coap_index *index,
+			    struct coap_pending *pending);
+
+/**
+ * @brief Remove a pending request from an index.
+ *
+ * @param index Index of pending requests
+ * @param pending Pending request to remove
+ */
+void coap_index_remove_pending(struct coap_index *index,
+			       struct coap_pending *pending);
+
+/**
+ * @brief After a response is received, returns the pending request of
+ * an index that matches it.
+ *
+ * @details Same as coap_pending_received(), the matching request is
+ * cleared and removed from the index.
+ *
+ * @param response The received response
+ * @param index Index of pending requests
+ *
+ * @return A pointer to the pending request that matched, NULL
+ * otherwise.
+ */
+struct coap_pending *coap_index_pending_received(
+	const struct coap_packet *response,
+	struct coap_index *index);
+
+/**
+ * @brief Add a reply to an index, keyed on its token or, for requests
+ * without token, on its message ID.
+ *
+ * @param index Index of replies
+ * @param reply Reply initialized with coap_reply_init()
+ */
+void coap_index_add_reply(struct coap_index *index,
+			  struct coap_reply *reply);
+
+/**
+ * @brief Remove a reply from an index.
+ *
+ * @param index Index of replies
+ * @param reply Reply to remove
+ */
+void coap_index_remove_reply(struct coap_index *index,
+			     struct coap_reply *reply);
+
+/**
+ * @brief After a response is received, call the reply of an index that
+ * matches it.
+ *
+ * @details Same as coap_response_received(), except that a response
+ * without token only matches replies without token, as responses echo
+ * the token of their request.
+ *
+ * @param response A response received
+ * @param from Address from which the response was received
+ * @param index Index of replies
+ *
+ * @return Pointer to the reply matching the packet received, NULL if
+ * none could be found.
+ */
+struct coap_reply *coap_index_response_received(
+	const struct coap_packet *response,
+	const struct sockaddr *from,
+	struct coap_index *index);
+#endif
+
 /**
  * @brief Indicates that this resource was updated and that the @a
  * notify callback should be called for every registered observer.
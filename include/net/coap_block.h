@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * @brief CoAP block-wise transfer engine for Zephyr.
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_COAP_BLOCK_H_
+#define ZEPHYR_INCLUDE_NET_COAP_BLOCK_H_
+
+/**
+ * @addtogroup coap COAP Library
+ * @{
+ */
+
+#include <net/coap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct coap_blockwise;
+
+/**
+ * @typedef coap_block_read_t
+ * @brief Producer of the body of a block-wise transfer.
+ *
+ * @details Copies up to @a len bytes of the body, starting at @a offset,
+ * to @a data. A client uploading a body reads it once, in increasing
+ * offsets. A server serving a body must be able to read any offset, as
+ * clients may request blocks again or out of order.
+ *
+ * @param bw Block-wise transfer
+ * @param offset Offset of the data in the body
+ * @param data Where to copy the data
+ * @param len Size of a block
+ * @param last Set to true if the body ends with this data
+ *
+ * @return Number of bytes copied, or negative in case of error.
+ */
+typedef int (*coap_block_read_t)(struct coap_blockwise *bw, size_t offset,
+				 u8_t *data, size_t len, bool *last);
+
+/**
+ * @typedef coap_block_write_t
+ * @brief Consumer of the body of a block-wise transfer.
+ *
+ * @details Called for each piece of a received block, without copying
+ * it out of the network buffers. Blocks are received in increasing
+ * offsets, unless more than one block is in flight and messages are
+ * lost or reordered.
+ *
+ * @param bw Block-wise transfer
+ * @param offset Offset of the data in the body
+ * @param data Data received
+ * @param len Length of the data
+ * @param last True if the body ends with this data
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+typedef int (*coap_block_write_t)(struct coap_blockwise *bw, size_t offset,
+				  const u8_t *data, size_t len, bool last);
+
+/**
+ * @typedef coap_block_alloc_t
+ * @brief Allocates a packet, with a data fragment, to send a message.
+ */
+typedef struct net_pkt *(*coap_block_alloc_t)(struct coap_blockwise *bw);
+
+/**
+ * @typedef coap_block_send_t
+ * @brief Sends the message in @a pkt to @a addr.
+ *
+ * @details The reference to @a pkt is given to the callback, which
+ * must release it if the message cannot be sent.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+typedef int (*coap_block_send_t)(struct coap_blockwise *bw,
+				 struct net_pkt *pkt,
+				 const struct sockaddr *addr);
+
+/**
+ * @typedef coap_block_done_t
+ * @brief Called when a transfer is over.
+ *
+ * @param bw Block-wise transfer
+ * @param status Code of the final response, or negative in case of
+ * error
+ */
+typedef void (*coap_block_done_t)(struct coap_blockwise *bw, int status);
+
+/**
+ * @brief Request of a block that is waiting for its response.
+ */
+struct coap_block_slot {
+	struct net_pkt *pkt;
+	size_t offset;
+	u32_t sent;
+	s32_t timeout;
+	u16_t id;
+	u8_t retries;
+};
+
+/**
+ * @brief Represents a block-wise transfer, on a client or on a server.
+ *
+ * A client downloads a body with GET requests of its blocks (Block2),
+ * or uploads one with PUT or POST requests (Block1). Up to @a window
+ * blocks are in flight at once, once the block size is negotiated with
+ * the first block.
+ *
+ * The callbacks and @a user_data are set by the application, the other
+ * fields are private.
+ */
+struct coap_blockwise {
+	coap_block_alloc_t alloc;
+	coap_block_send_t send;
+	coap_block_read_t read;
+	coap_block_write_t write;
+	coap_block_done_t done;
+	void *user_data;
+
+	/** Initial retransmission timeout, in ms */
+	s32_t ack_timeout;
+
+	struct sockaddr addr;
+	const char * const *path;
+	struct coap_block_slot slots[CONFIG_COAP_BLOCKWISE_WINDOW];
+	u8_t buf[CONFIG_COAP_BLOCKWISE_MAX_BLOCK_SIZE];
+	u8_t token[4];
+
+	/** Start of the blocks not acknowledged yet */
+	size_t base;
+	/** Start of the next block to request */
+	size_t next;
+	/** End of the body, once known */
+	size_t end;
+	/** Blocks from @a base that were acknowledged, one bit per block */
+	u32_t acked;
+
+	enum coap_block_size block_size;
+	u8_t method;
+	u8_t code;
+	u8_t window;
+	u8_t in_flight;
+	bool negotiated;
+	bool last;
+	bool active;
+};
+
+/**
+ * @brief Initializes a client transfer.
+ *
+ * @details GET downloads the body of the resource to the @a write
+ * callback, PUT and POST upload the body produced by the @a read
+ * callback.
+ *
+ * @param bw Block-wise transfer, with its callbacks set
+ * @param method Method of the requests, see #coap_method
+ * @param addr Address of the server
+ * @param path Path of the resource, NULL terminated
+ * @param block_size Preferred block size
+ * @param window Number of blocks in flight, at most
+ * CONFIG_COAP_BLOCKWISE_WINDOW
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_blockwise_client_init(struct coap_blockwise *bw, u8_t method,
+			       const struct sockaddr *addr,
+			       const char * const *path,
+			       enum coap_block_size block_size, u8_t window);
+
+/**
+ * @brief Starts a client transfer, sending the request of its first
+ * block.
+ *
+ * @param bw Block-wise transfer
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_blockwise_start(struct coap_blockwise *bw);
+
+/**
+ * @brief Handles a response received by a client.
+ *
+ * @details Delivers downloaded data, requests the next blocks and calls
+ * the @a done callback when the transfer is over.
+ *
+ * @param bw Block-wise transfer
+ * @param response Response received
+ *
+ * @return 0 if the response was handled, -ENOENT if it is not part of
+ * the transfer, or negative in case of error.
+ */
+int coap_blockwise_response(struct coap_blockwise *bw,
+			    const struct coap_packet *response);
+
+/**
+ * @brief Retransmits the requests of a client that timed out.
+ *
+ * @details The transfer fails with -ETIMEDOUT when a request was
+ * retransmitted too many times.
+ *
+ * @param bw Block-wise transfer
+ *
+ * @return Time until this should be called again, in ms, or K_FOREVER
+ * if no request is waiting for a response.
+ */
+s32_t coap_blockwise_poll(struct coap_blockwise *bw);
+
+/**
+ * @brief Initializes a server transfer.
+ *
+ * @details A server transfer serves GET requests of a resource with the
+ * @a read callback, and PUT or POST requests with the @a write callback.
+ * Downloads are stateless, so one transfer can serve every client of a
+ * resource. Uploads are followed, a transfer receives one body at a
+ * time.
+ *
+ * @param bw Block-wise transfer, with its callbacks set
+ * @param block_size Largest block size of the server
+ * @param code Code of the response to the last block of an upload
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_blockwise_server_init(struct coap_blockwise *bw,
+			       enum coap_block_size block_size, u8_t code);
+
+/**
+ * @brief Handles a request received by a server, sending its response.
+ *
+ * @details To be called from the methods of the resource.
+ *
+ * @param bw Block-wise transfer
+ * @param request Request received
+ * @param from Address of the client
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_blockwise_request(struct coap_blockwise *bw,
+			   const struct coap_packet *request,
+			   const struct sockaddr *from);
+
+/**
+ * @brief Cancels a transfer, releasing its pending requests.
+ *
+ * @param bw Block-wise transfer
+ */
+void coap_blockwise_cancel(struct coap_blockwise *bw);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_COAP_BLOCK_H_ */
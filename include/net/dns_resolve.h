@@ -183,6 +183,18 @@ struct dns_resolve_context {
 
 		/** DNS id of this query */
 		u16_t id;
+
+		/** DNS id of the query sent to the server. Concurrent queries
+		 * for the same name share the id of the query that was sent.
+		 */
+		u16_t wire_id;
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/** Copy of the name to resolve, used as the cache key. Empty
+		 * if the name is too long to be cached.
+		 */
+		char name[CONFIG_DNS_RESOLVER_CACHE_MAX_NAME_LEN + 1];
+#endif
 	} queries[CONFIG_DNS_NUM_CONCUR_QUERIES];
 
 	/** Is this context in use */
@@ -349,6 +361,78 @@ static inline int dns_cancel_addr_info(u16_t dns_id)
 	return dns_resolve_cancel(dns_resolve_get_default(), dns_id);
 }
 
+/**
+ * Cached DNS answer, see dns_cache_foreach().
+ */
+struct dns_cache_info {
+	/** Name that was resolved */
+	const char *name;
+
+	/** Addresses of a positive answer, 4 bytes each for
+	 * DNS_QUERY_TYPE_A and 16 bytes each for DNS_QUERY_TYPE_AAAA.
+	 */
+	const u8_t *addr;
+
+	/** Seconds until the answer expires */
+	u32_t ttl;
+
+	/** Number of queries answered from the cache */
+	u32_t hits;
+
+	/** Query type */
+	enum dns_query_type type;
+
+	/** DNS_EAI_ALLDONE for a positive answer, DNS_EAI_NONAME or
+	 * DNS_EAI_NODATA for a negative one.
+	 */
+	enum dns_resolve_status status;
+
+	/** Number of addresses */
+	u8_t count;
+};
+
+/**
+ * @typedef dns_cache_cb_t
+ * @brief Callback used while iterating over the DNS cache.
+ *
+ * @param info Cached answer
+ * @param user_data A valid pointer to user data or NULL
+ */
+typedef void (*dns_cache_cb_t)(const struct dns_cache_info *info,
+			       void *user_data);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/**
+ * @brief Go through all the answers in the DNS cache.
+ *
+ * @details The answers are passed from the most recently used one.
+ * Expired answers are removed from the cache.
+ *
+ * @param cb User supplied callback function to call
+ * @param user_data User specified data
+ *
+ * @return Number of answers in the cache.
+ */
+int dns_cache_foreach(dns_cache_cb_t cb, void *user_data);
+
+/**
+ * @brief Remove all the answers from the DNS cache.
+ */
+void dns_cache_flush(void);
+#else
+static inline int dns_cache_foreach(dns_cache_cb_t cb, void *user_data)
+{
+	ARG_UNUSED(cb);
+	ARG_UNUSED(user_data);
+
+	return 0;
+}
+
+static inline void dns_cache_flush(void)
+{
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 /**
  * @}
  */
@@ -637,6 +637,85 @@ struct http_root_url *http_server_add_default(struct http_server_urls *urls,
  */
 int http_server_del_default(struct http_server_urls *urls);
 
+/**
+ * @brief Limit the number of connections the server serves at once.
+ *
+ * @details Connections accepted when the limit is reached are closed
+ * right away.
+ *
+ * @param ctx Http context.
+ * @param max_conn Maximum number of connections, at most
+ * CONFIG_HTTP_SERVER_CONNECTIONS, or 0 for no other limit than that.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int http_server_set_max_connections(struct http_ctx *ctx, int max_conn);
+
+/**
+ * @brief Start a response with a body sent in chunks.
+ *
+ * @details Adds the status line and the header of a response using the
+ * chunked transfer coding. The body is then sent with http_send_chunk(),
+ * and ended by calling it with a NULL payload.
+ *
+ * @param ctx Http context.
+ * @param status Status line, with its "\r\n", like
+ * "HTTP/1.1 200 OK\r\n".
+ * @param content_type Value of the Content-Type field, or NULL.
+ * @param dst Remote socket address.
+ * @param user_send_data User data value that is used in send callback.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int http_add_chunked_header(struct http_ctx *ctx, const char *status,
+			    const char *content_type,
+			    const struct sockaddr *dst,
+			    void *user_send_data);
+
+#if defined(CONFIG_HTTP_SEND_STATIC)
+/**
+ * @brief Add static data to the message without copying it.
+ *
+ * @details The network buffers sent reference the data, which must stay
+ * valid and unchanged until the peer acknowledges it. This fits data in
+ * flash or in constant tables.
+ *
+ * @param ctx Http context.
+ * @param payload Data to send.
+ * @param payload_len Length of the data.
+ * @param dst Remote socket address.
+ * @param user_send_data User data value that is used in send callback.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int http_send_static(struct http_ctx *ctx, const void *payload,
+		     size_t payload_len, const struct sockaddr *dst,
+		     void *user_send_data);
+
+/**
+ * @brief Send a complete response with a static body.
+ *
+ * @details Sends the status line, the Content-Type and Content-Length
+ * fields, and the body without copying it, see http_send_static().
+ *
+ * @param ctx Http context.
+ * @param status Status line, with its "\r\n", like
+ * "HTTP/1.1 200 OK\r\n".
+ * @param content_type Value of the Content-Type field, or NULL.
+ * @param body Body of the response.
+ * @param body_len Length of the body.
+ * @param dst Remote socket address.
+ * @param user_send_data User data value that is used in send callback.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int http_send_static_response(struct http_ctx *ctx, const char *status,
+			      const char *content_type,
+			      const void *body, size_t body_len,
+			      const struct sockaddr *dst,
+			      void *user_send_data);
+#endif /* CONFIG_HTTP_SEND_STATIC */
+
 #else /* CONFIG_HTTP_SERVER */
 
 static inline int http_server_init(struct http_ctx *ctx,
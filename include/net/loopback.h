@@ -0,0 +1,70 @@
+/** @file
+ * @brief Network loopback interface
+ *
+ * Test helpers for the network loopback driver.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_LOOPBACK_H_
+#define ZEPHYR_INCLUDE_NET_LOOPBACK_H_
+
+/**
+ * @brief Loopback interface support.
+ * @defgroup loopback Loopback interface
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_NET_LOOPBACK_SIMULATE_PACKET_DROP)
+/**
+ * @brief Set the ratio of packets the loopback interface drops.
+ *
+ * The packets are dropped deterministically, i.e. with ratio 10 exactly
+ * one packet out of every hundred is dropped.
+ *
+ * @param ratio Drop ratio in per mille (0 - 1000). 0 disables dropping.
+ *
+ * @return 0 if ok, -EINVAL if the ratio is out of range.
+ */
+int loopback_set_packet_drop_ratio(u32_t ratio);
+
+/**
+ * @brief Get the number of packets the loopback interface has dropped.
+ *
+ * @return Number of dropped packets.
+ */
+u32_t loopback_get_num_dropped_packets(void);
+#endif /* CONFIG_NET_LOOPBACK_SIMULATE_PACKET_DROP */
+
+#if defined(CONFIG_NET_LOOPBACK_SIMULATE_DELAY)
+/**
+ * @brief Set the one-way delay of the loopback interface.
+ *
+ * The delay is applied to every sent packet, so the round-trip time of
+ * a connection over the loopback interface is twice the delay.
+ *
+ * @param delay Delay in milliseconds. 0 disables the delay.
+ */
+void loopback_set_delay(u32_t delay);
+#endif /* CONFIG_NET_LOOPBACK_SIMULATE_DELAY */
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_LOOPBACK_H_ */
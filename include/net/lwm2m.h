@@ -27,6 +27,29 @@
 #define IPSO_OBJECT_TEMP_SENSOR_ID			3303
 #define IPSO_OBJECT_LIGHT_CONTROL_ID			3311
 
+/**
+ * @brief LwM2M notification counters
+ *
+ * @details Counters of the notifications of a LwM2M context, to see how
+ * the changes of the observed resources end up sent to the server.
+ *
+ * @param events Changes of an observed resource.
+ * @param coalesced Changes carried by a notification which was already
+ *    pending for another change.
+ * @param filtered Changes not notified because of the gt, lt and st
+ *    attributes of the observed resource.
+ * @param rate_limited Notifications delayed by the rate limit of the
+ *    server.
+ * @param sent Notifications sent, for changes or once pmax elapsed.
+ */
+struct lwm2m_notify_stats {
+	u32_t events;
+	u32_t coalesced;
+	u32_t filtered;
+	u32_t rate_limited;
+	u32_t sent;
+};
+
 /**
  * @brief LwM2M context structure
  *
@@ -41,6 +64,7 @@
  *    attached to this LwM2M context.
  * @param data_pool Network data net_buf pool for network contexts attached
  *    to this LwM2M context.
+ * @param notify_stats Notification counters.
  */
 struct lwm2m_ctx {
 	/** Net app context structure */
@@ -58,6 +82,12 @@ struct lwm2m_ctx {
 	struct coap_reply replies[CONFIG_LWM2M_ENGINE_MAX_REPLIES];
 	struct k_delayed_work retransmit_work;
 
+	/** Notification rate limit, see CONFIG_LWM2M_ENGINE_NOTIFY_BURST */
+	s64_t notify_timestamp;
+	u16_t notify_tokens;
+
+	struct lwm2m_notify_stats notify_stats;
+
 #if defined(CONFIG_NET_APP_DTLS)
 	/** Pre-Shared Key  Information*/
 	unsigned char *client_psk;
@@ -198,6 +228,80 @@ int lwm2m_engine_get_bool(char *path, bool *value);
 int lwm2m_engine_get_float32(char *pathstr, float32_value_t *buf);
 int lwm2m_engine_get_float64(char *pathstr, float64_value_t *buf);
 
+/*
+ * A resource handle keeps a resource path resolved by
+ * lwm2m_engine_get_handle(), so that setting or reading the resource does
+ * not parse the path and look up the resource again. When object
+ * instances are deleted, the handle is resolved again on its next use,
+ * which fails with -ENOENT if its resource is gone.
+ */
+struct lwm2m_engine_res_handle {
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res;
+	u32_t generation;
+	u16_t obj_id;
+	u16_t obj_inst_id;
+	u16_t res_id;
+};
+
+int lwm2m_engine_get_handle(char *pathstr,
+			    struct lwm2m_engine_res_handle *handle);
+
+int lwm2m_engine_handle_set_opaque(struct lwm2m_engine_res_handle *handle,
+				   char *data_ptr, u16_t data_len);
+int lwm2m_engine_handle_set_string(struct lwm2m_engine_res_handle *handle,
+				   char *data_ptr);
+int lwm2m_engine_handle_set_u8(struct lwm2m_engine_res_handle *handle,
+			       u8_t value);
+int lwm2m_engine_handle_set_u16(struct lwm2m_engine_res_handle *handle,
+			       u16_t value);
+int lwm2m_engine_handle_set_u32(struct lwm2m_engine_res_handle *handle,
+			       u32_t value);
+int lwm2m_engine_handle_set_u64(struct lwm2m_engine_res_handle *handle,
+			       u64_t value);
+int lwm2m_engine_handle_set_s8(struct lwm2m_engine_res_handle *handle,
+			       s8_t value);
+int lwm2m_engine_handle_set_s16(struct lwm2m_engine_res_handle *handle,
+			       s16_t value);
+int lwm2m_engine_handle_set_s32(struct lwm2m_engine_res_handle *handle,
+			       s32_t value);
+int lwm2m_engine_handle_set_s64(struct lwm2m_engine_res_handle *handle,
+			       s64_t value);
+int lwm2m_engine_handle_set_bool(struct lwm2m_engine_res_handle *handle,
+				 bool value);
+int lwm2m_engine_handle_set_float32(struct lwm2m_engine_res_handle *handle,
+				    float32_value_t *value);
+int lwm2m_engine_handle_set_float64(struct lwm2m_engine_res_handle *handle,
+				    float64_value_t *value);
+
+int lwm2m_engine_handle_get_opaque(struct lwm2m_engine_res_handle *handle,
+				   void *buf, u16_t buflen);
+int lwm2m_engine_handle_get_string(struct lwm2m_engine_res_handle *handle,
+				   void *str, u16_t strlen);
+int lwm2m_engine_handle_get_u8(struct lwm2m_engine_res_handle *handle,
+			       u8_t *value);
+int lwm2m_engine_handle_get_u16(struct lwm2m_engine_res_handle *handle,
+			       u16_t *value);
+int lwm2m_engine_handle_get_u32(struct lwm2m_engine_res_handle *handle,
+			       u32_t *value);
+int lwm2m_engine_handle_get_u64(struct lwm2m_engine_res_handle *handle,
+			       u64_t *value);
+int lwm2m_engine_handle_get_s8(struct lwm2m_engine_res_handle *handle,
+			       s8_t *value);
+int lwm2m_engine_handle_get_s16(struct lwm2m_engine_res_handle *handle,
+			       s16_t *value);
+int lwm2m_engine_handle_get_s32(struct lwm2m_engine_res_handle *handle,
+			       s32_t *value);
+int lwm2m_engine_handle_get_s64(struct lwm2m_engine_res_handle *handle,
+			       s64_t *value);
+int lwm2m_engine_handle_get_bool(struct lwm2m_engine_res_handle *handle,
+				 bool *value);
+int lwm2m_engine_handle_get_float32(struct lwm2m_engine_res_handle *handle,
+				    float32_value_t *buf);
+int lwm2m_engine_handle_get_float64(struct lwm2m_engine_res_handle *handle,
+				    float64_value_t *buf);
+
 int lwm2m_engine_register_read_callback(char *path,
 					lwm2m_engine_get_data_cb_t cb);
 int lwm2m_engine_register_pre_write_callback(char *path,
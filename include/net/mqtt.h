@@ -36,6 +36,56 @@ enum mqtt_app {
 	MQTT_APP_SERVER
 };
 
+/**
+ * State of the incoming MQTT message stream, internal use only
+ */
+struct mqtt_rx {
+	/** Fixed and variable header of the message being received, or the
+	 * whole message when its payload is not streamed
+	 */
+	u8_t buf[CONFIG_MQTT_MSG_MAX_SIZE];
+
+	/** PUBLISH msg whose payload is being streamed */
+	struct mqtt_publish_msg msg;
+
+	/** Remaining Length of the message, from the fixed header */
+	u32_t rlen;
+
+	/** Bytes of the Remaining Length already received */
+	u32_t offset;
+
+	/** Bytes stored in buf */
+	u16_t len;
+
+	/** Size of the fixed header, 0 until it is complete */
+	u8_t hdr_len;
+
+	/** 1 while the payload of a PUBLISH msg is streamed */
+	u8_t payload:1;
+
+	/** 1 while the rest of a rejected message is skipped */
+	u8_t discard:1;
+};
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+/**
+ * Outgoing QoS 1 or QoS 2 PUBLISH msg waiting for its acknowledgment,
+ * internal use only
+ */
+struct mqtt_inflight {
+	/** Packet Identifier, 0 if the slot is free */
+	u16_t pkt_id;
+
+	/** MQTT_PUBLISH until the PUBACK or PUBREC msg is received, then
+	 * MQTT_PUBREL until the PUBCOMP msg is received
+	 */
+	u8_t state;
+
+	/** QoS of the PUBLISH msg */
+	u8_t qos;
+};
+#endif
+
 /**
  * MQTT context structure
  *
@@ -60,7 +110,12 @@ enum mqtt_app {
  * messages.
  *
  * <b>NOTE: The application (and not the API) is in charge of keeping track of
- * the state of the received and sent messages.</b>
+ * the state of the received and sent messages.</b> When
+ * CONFIG_MQTT_INFLIGHT_WINDOW is not 0, the library also keeps track of the
+ * QoS 1 and QoS 2 PUBLISH msgs sent, so that several of them can be in flight
+ * at the same time: acknowledgments that do not match a msg in flight are
+ * rejected, and mqtt_tx_publish() waits for a free slot when the window is
+ * full.
  */
 struct mqtt_ctx {
 	/** Net app context structure */
@@ -142,6 +197,28 @@ struct mqtt_ctx {
 	int (*publish_rx)(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg,
 			  u16_t pkt_id, enum mqtt_packet type);
 
+	/** Callback executed for each part of the payload of a received
+	 * MQTT PUBLISH msg. The payload is handed over as it arrives from the
+	 * network, without being copied, so messages of any size can be
+	 * received. The msg fields are those of the PUBLISH msg, except for
+	 * msg->msg and msg->msg_len that give the current part of the payload.
+	 * Once the whole payload has been handed over, #publish_rx is executed
+	 * with a NULL msg->msg and the QoS handshake continues.
+	 * If this callback returns a value other than 0, the rest of the
+	 * payload is skipped and the msg is not acknowledged.
+	 *
+	 * If this function pointer is NULL, the msg is reassembled and passed
+	 * whole to #publish_rx, so it must fit in CONFIG_MQTT_MSG_MAX_SIZE.
+	 *
+	 * @param [in] ctx MQTT context
+	 * @param [in] msg Publish message
+	 * @param [in] offset Offset of this part in the payload
+	 * @param [in] total_len Length of the whole payload
+	 */
+	int (*publish_rx_data)(struct mqtt_ctx *ctx,
+			       struct mqtt_publish_msg *msg,
+			       u32_t offset, u32_t total_len);
+
 	/** Callback executed when a MQTT_APP_SUBSCRIBER or
 	 * MQTT_APP_PUBLISHER_SUBSCRIBER receives the MQTT SUBACK message
 	 * If this callback returns 0, the caller will continue. Any other
@@ -182,6 +259,16 @@ struct mqtt_ctx {
 	/* Internal use only */
 	int (*rcv)(struct mqtt_ctx *ctx, struct net_pkt *);
 
+	/* Internal use only */
+	struct mqtt_rx rx;
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+	/* Internal use only */
+	struct mqtt_inflight inflight[CONFIG_MQTT_INFLIGHT_WINDOW];
+	struct k_sem inflight_free;
+	struct k_mutex inflight_lock;
+#endif
+
 	/** Application type, see: enum mqtt_app */
 	u8_t app_type;
 
@@ -300,6 +387,10 @@ int mqtt_tx_pubrel(struct mqtt_ctx *ctx, u16_t id);
 /**
  * Sends the MQTT PUBLISH message
  *
+ * @details When CONFIG_MQTT_INFLIGHT_WINDOW is not 0 and the window of QoS 1
+ * and QoS 2 msgs in flight is full, this routine waits up to net_timeout for
+ * an acknowledgment to free a slot.
+ *
  * @param [in] ctx MQTT context structure
  * @param [in] msg MQTT PUBLISH msg
  *
@@ -307,6 +398,7 @@ int mqtt_tx_pubrel(struct mqtt_ctx *ctx, u16_t id);
  * @retval -EINVAL
  * @retval -ENOMEM
  * @retval -EIO
+ * @retval -EAGAIN if the window of msgs in flight is still full
  */
 int mqtt_tx_publish(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg);
 
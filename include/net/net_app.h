@@ -308,6 +308,9 @@ struct net_app_ctx {
 		 * when TCP is enabled.
 		 */
 		struct net_context *net_ctxs[CONFIG_NET_APP_SERVER_NUM_CONN];
+
+		/** Maximum number of active contexts, 0 if not limited */
+		u8_t max_conn;
 #endif
 	} server;
 #endif /* CONFIG_NET_APP_SERVER */
@@ -596,6 +599,20 @@ bool net_app_server_enable(struct net_app_ctx *ctx);
  */
 bool net_app_server_disable(struct net_app_ctx *ctx);
 
+/**
+ * @brief Limit the number of connections the server serves at once.
+ *
+ * @details Connections accepted when the limit is reached are closed
+ * right away. The limit cannot exceed CONFIG_NET_APP_SERVER_NUM_CONN.
+ *
+ * @param ctx Network application context.
+ * @param max_conn Maximum number of connections, 0 to serve as many as
+ * there are connection slots.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int net_app_server_set_max_conn(struct net_app_ctx *ctx, int max_conn);
+
 #endif /* CONFIG_NET_APP_SERVER */
 
 #if defined(CONFIG_NET_APP_CLIENT)
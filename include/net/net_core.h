@@ -97,6 +97,24 @@ enum net_verdict {
 /* Called by lower network stack when a network packet has been received */
 int net_recv_data(struct net_if *iface, struct net_pkt *pkt);
 
+/**
+ * @brief Called by lower network stack when several network packets have
+ * been received.
+ *
+ * @details This is cheaper than calling net_recv_data() for each packet
+ * as the packets are queued to the Rx traffic class queues at once.
+ * The packets are processed in the order they are in the array.
+ *
+ * @param iface Network interface the packets were received from.
+ * @param pkts Array of received network packets.
+ * @param count Number of packets in the array.
+ *
+ * @return 0 if the packets were queued, <0 otherwise. On error, none of
+ * the packets were queued and the caller still owns them.
+ */
+int net_recv_data_batch(struct net_if *iface, struct net_pkt **pkts,
+			int count);
+
 /**
  * @brief Send data to network.
  *
@@ -178,6 +178,12 @@ enum {
 	/* interface is in promiscuous mode */
 	NET_IF_PROMISC,
 
+	/* interface calculates the checksums of sent packets in hardware */
+	NET_IF_TX_CHKSUM_OFFLOAD,
+
+	/* interface verifies the checksums of received packets in hardware */
+	NET_IF_RX_CHKSUM_OFFLOAD,
+
 	/* Total number of flags - must be at the end of the enum */
 	NET_IF_NUM_FLAGS
 };
@@ -416,6 +422,69 @@ struct net_if_dev {
 	u16_t mtu;
 };
 
+#if defined(CONFIG_NET_TX_SCHED)
+/**
+ * @brief Statistics of a Tx scheduler queue
+ */
+struct net_if_tx_queue_stats {
+	/** Number of packets currently queued */
+	u16_t len;
+
+	/** Highest number of packets that have been queued */
+	u16_t max_len;
+
+	/** Number of packets sent */
+	u32_t sent;
+
+	/** Number of packets dropped because the queue was full */
+	u32_t dropped;
+};
+
+/** @cond INTERNAL_HIDDEN */
+struct net_if_tx_queue {
+	/** Queued packets */
+	sys_slist_t pkts;
+
+	struct net_if_tx_queue_stats stats;
+
+	/** Bytes the queue may still send in the current round */
+	s32_t deficit;
+
+	/** Share of the link the queue gets relative to the others */
+	u16_t weight;
+
+	/** The quantum of the current round has been added to deficit */
+	bool active;
+};
+
+struct net_if_tx_sched {
+	/** One queue per Tx traffic class */
+	struct net_if_tx_queue queues[NET_TC_TX_COUNT];
+
+	/** Sends the queued packets */
+	struct k_work work;
+
+	/** Restarts sending when the token bucket has been refilled */
+	struct k_delayed_work shaper;
+
+	/** Time of the last token bucket refill */
+	s64_t last_refill;
+
+	/** Shaping rate in bytes per second, 0 if not shaped */
+	u32_t rate;
+
+	/** Size of the token bucket in bytes */
+	u32_t burst;
+
+	/** Bytes that can be sent right now */
+	u32_t tokens;
+
+	/** Traffic class being served */
+	u8_t current;
+};
+/** @endcond */
+#endif /* CONFIG_NET_TX_SCHED */
+
 /**
  * @brief Network Interface structure
  *
@@ -434,6 +503,11 @@ struct net_if {
 
 	/** Network interface instance configuration */
 	struct net_if_config config;
+
+#if defined(CONFIG_NET_TX_SCHED)
+	/** Egress scheduler of the interface */
+	struct net_if_tx_sched tx_sched;
+#endif /* CONFIG_NET_TX_SCHED */
 } __net_if_align;
 
 /**
@@ -521,6 +595,44 @@ static inline struct device *net_if_get_device(struct net_if *iface)
  */
 void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt);
 
+#if defined(CONFIG_NET_TX_SCHED) || defined(__DOXYGEN__)
+/**
+ * @brief Set the weight of a traffic class in the egress scheduler
+ *
+ * @details The backlogged traffic classes of an interface share the link
+ * in proportion to their weights.
+ *
+ * @param iface Network interface.
+ * @param tc Tx traffic class.
+ * @param weight Weight of the traffic class, at least 1.
+ *
+ * @return 0 if ok, -EINVAL if a parameter is invalid.
+ */
+int net_if_tx_sched_set_weight(struct net_if *iface, u8_t tc, u16_t weight);
+
+/**
+ * @brief Shape the egress traffic of an interface with a token bucket
+ *
+ * @param iface Network interface.
+ * @param rate Average rate in bytes per second, 0 disables shaping.
+ * @param burst Amount of bytes that can be sent at once after the link
+ * has been idle.
+ */
+void net_if_tx_sched_set_rate(struct net_if *iface, u32_t rate, u32_t burst);
+
+/**
+ * @brief Get the statistics of a traffic class queue of an interface
+ *
+ * @param iface Network interface.
+ * @param tc Tx traffic class.
+ * @param stats Statistics are copied here.
+ *
+ * @return 0 if ok, -EINVAL if a parameter is invalid.
+ */
+int net_if_tx_sched_get_stats(struct net_if *iface, u8_t tc,
+			      struct net_if_tx_queue_stats *stats);
+#endif /* CONFIG_NET_TX_SCHED */
+
 #if defined(CONFIG_NET_OFFLOAD)
 /**
  * @brief Return the IP offload status
@@ -1593,6 +1705,8 @@ void net_if_call_link_cb(struct net_if *iface, struct net_linkaddr *lladdr,
  * @brief Check if received network packet checksum calculation can be avoided
  * or not. For example many ethernet devices support network packet offloading
  * in which case the IP stack does not need to calculate the checksum.
+ * A driver announces this by setting the NET_IF_RX_CHKSUM_OFFLOAD flag of
+ * the interface, Ethernet L2 sets it from the device capabilities.
  *
  * @param iface Network interface
  *
@@ -1604,7 +1718,8 @@ bool net_if_need_calc_rx_checksum(struct net_if *iface);
  * @brief Check if network packet checksum calculation can be avoided or not
  * when sending the packet. For example many ethernet devices support network
  * packet offloading in which case the IP stack does not need to calculate the
- * checksum.
+ * checksum. A driver announces this by setting the NET_IF_TX_CHKSUM_OFFLOAD
+ * flag of the interface, Ethernet L2 sets it from the device capabilities.
  *
  * @param iface Network interface
  *
@@ -46,8 +46,10 @@ struct net_context;
  * net_pkt_clone() function.
  */
 struct net_pkt {
-	/** FIFO uses first 4 bytes itself, reserve space */
-	int _reserved;
+	/** FIFO uses first word itself, reserve space. The RX queue and
+	 * the TX scheduler use it also to link packets together.
+	 */
+	intptr_t _reserved;
 
 	/** Internal variable that is used when packet is sent */
 	struct k_work work;
@@ -130,6 +132,16 @@ struct net_pkt {
 				     * Used only if
 				     * defined(CONFIG_NET_IPV4_AUTO)
 				     */
+#if defined(CONFIG_NET_TCP_SACK)
+	u8_t tcp_sacked : 1;	/* For outgoing packet: has the peer
+				 * selectively acknowledged this packet.
+				 */
+#endif
+#if defined(CONFIG_NET_GRO)
+	u8_t chksum_verified : 1; /* For incoming packet: transport
+				   * checksum was already verified.
+				   */
+#endif
 
 	union {
 		/* IPv6 hop limit or IPv4 ttl for this network packet.
@@ -174,6 +186,11 @@ struct net_pkt {
 	u8_t ipv6_ext_opt_len; /* IPv6 ND option length */
 #endif /* CONFIG_NET_IPV6 */
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	u16_t ipv4_fragment_offset;	/* Fragment offset of this packet */
+	u8_t ipv4_reassembled : 1;	/* Reassembled from IPv4 fragments */
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #if defined(CONFIG_IEEE802154)
 	u8_t ieee802154_rssi; /* Received Signal Strength Indication */
 	u8_t ieee802154_lqi;  /* Link Quality Indicator */
@@ -309,6 +326,38 @@ static inline void net_pkt_set_queued(struct net_pkt *pkt, bool send)
 	pkt->pkt_queued = send;
 }
 
+#if defined(CONFIG_NET_TCP_SACK)
+static inline u8_t net_pkt_sacked(struct net_pkt *pkt)
+{
+	return pkt->tcp_sacked;
+}
+
+static inline void net_pkt_set_sacked(struct net_pkt *pkt, bool sacked)
+{
+	pkt->tcp_sacked = sacked;
+}
+#endif
+
+#if defined(CONFIG_NET_GRO)
+static inline bool net_pkt_chksum_verified(struct net_pkt *pkt)
+{
+	return pkt->chksum_verified;
+}
+
+static inline void net_pkt_set_chksum_verified(struct net_pkt *pkt,
+					       bool verified)
+{
+	pkt->chksum_verified = verified;
+}
+#else
+static inline bool net_pkt_chksum_verified(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return false;
+}
+#endif
+
 #if defined(CONFIG_NET_SOCKETS)
 static inline u8_t net_pkt_eof(struct net_pkt *pkt)
 {
@@ -434,6 +483,30 @@ static inline void net_pkt_set_ipv6_fragment_id(struct net_pkt *pkt,
 #define net_pkt_set_ipv6_ext_len(...)
 #endif /* CONFIG_NET_IPV6 */
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+static inline u16_t net_pkt_ipv4_fragment_offset(struct net_pkt *pkt)
+{
+	return pkt->ipv4_fragment_offset;
+}
+
+static inline void net_pkt_set_ipv4_fragment_offset(struct net_pkt *pkt,
+						    u16_t offset)
+{
+	pkt->ipv4_fragment_offset = offset;
+}
+
+static inline bool net_pkt_ipv4_reassembled(struct net_pkt *pkt)
+{
+	return pkt->ipv4_reassembled;
+}
+
+static inline void net_pkt_set_ipv4_reassembled(struct net_pkt *pkt,
+						bool reassembled)
+{
+	pkt->ipv4_reassembled = reassembled;
+}
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #if NET_TC_COUNT > 1
 static inline u8_t net_pkt_priority(struct net_pkt *pkt)
 {
@@ -1177,6 +1250,27 @@ bool net_pkt_compact(struct net_pkt *pkt);
 u16_t net_pkt_append(struct net_pkt *pkt, u16_t len, const u8_t *data,
 		     s32_t timeout);
 
+/**
+ * @brief Append a fragment chain to a packet without copying the data
+ *
+ * @details The packet takes ownership of the fragments. If the packet has
+ * a network context, only as much data as the MTU or the TCP MSS allows is
+ * added, like net_pkt_append() does, and the chain is split at that point.
+ * The fragments after the split are returned in rest and are owned by the
+ * caller.
+ *
+ * @param pkt Network packet.
+ * @param frags Fragment chain to be added.
+ * @param rest Fragments that did not fit into the packet, or NULL.
+ * @param timeout Affects the action taken should the net buf pool be empty
+ *        when the buffer at the split point needs to be copied.
+ *
+ * @return Length of data added, 0 on failure in which case the caller
+ *         still owns the fragments.
+ */
+u16_t net_pkt_append_frags(struct net_pkt *pkt, struct net_buf *frags,
+			   struct net_buf **rest, s32_t timeout);
+
 /**
  * @brief Append all data to fragment list of a packet (or fail)
  *
@@ -1504,6 +1598,255 @@ struct net_buf *net_frag_read_be16(struct net_buf *frag, u16_t offset,
 struct net_buf *net_frag_read_be32(struct net_buf *frag, u16_t offset,
 				   u16_t *pos, u32_t *value);
 
+/**
+ * @brief Position in the data of a packet.
+ *
+ * @details A cursor reads or writes the data of a packet sequentially.
+ * Unlike net_frag_read() and net_pkt_write(), which locate their offset
+ * from a fragment at each call, it keeps the fragment it is in, and copies
+ * data with memcpy() one fragment at a time.
+ */
+struct net_pkt_cursor {
+	/** Packet the cursor is in */
+	struct net_pkt *pkt;
+
+	/** Current fragment, NULL at the end of the data */
+	struct net_buf *buf;
+
+	/** Offset in the current fragment */
+	u16_t pos;
+};
+
+/**
+ * @brief Set a cursor at the start of the data of a packet.
+ *
+ * @param cursor Cursor to initialize.
+ * @param pkt Network packet.
+ */
+static inline void net_pkt_cursor_init(struct net_pkt_cursor *cursor,
+				       struct net_pkt *pkt)
+{
+	cursor->pkt = pkt;
+	cursor->buf = pkt->frags;
+	cursor->pos = 0;
+}
+
+/**
+ * @brief Set a cursor at an offset of a fragment of a packet.
+ *
+ * @details The fragment and offset are typically the ones returned by
+ * net_frag_read() or net_frag_skip().
+ *
+ * @param cursor Cursor to initialize.
+ * @param pkt Network packet.
+ * @param frag Fragment of the packet, or NULL for the end of its data.
+ * @param pos Offset in the fragment.
+ */
+static inline void net_pkt_cursor_set(struct net_pkt_cursor *cursor,
+				      struct net_pkt *pkt,
+				      struct net_buf *frag, u16_t pos)
+{
+	cursor->pkt = pkt;
+	cursor->buf = frag;
+	cursor->pos = pos;
+}
+
+/**
+ * @brief Get the data that is contiguous at the position of a cursor.
+ *
+ * @details This gives direct access to the data of the current fragment,
+ * without copying it and without moving the cursor.
+ *
+ * @param cursor Cursor.
+ * @param len Number of contiguous bytes, 0 at the end of the data.
+ *
+ * @return Pointer to the data, NULL at the end of the data.
+ */
+u8_t *net_pkt_cursor_span(struct net_pkt_cursor *cursor, u16_t *len);
+
+/**
+ * @brief Get the number of bytes from a cursor to the end of the data.
+ *
+ * @param cursor Cursor.
+ *
+ * @return Number of bytes left.
+ */
+size_t net_pkt_cursor_remaining(struct net_pkt_cursor *cursor);
+
+/**
+ * @brief Check whether a cursor is at the end of the data of its packet.
+ *
+ * @param cursor Cursor.
+ *
+ * @return True if there is no data left to read.
+ */
+static inline bool net_pkt_cursor_at_end(struct net_pkt_cursor *cursor)
+{
+	u16_t len;
+
+	return !net_pkt_cursor_span(cursor, &len);
+}
+
+/**
+ * @brief Read data at a cursor and move it after the data.
+ *
+ * @param cursor Cursor.
+ * @param data Where to copy the data, or NULL to skip it.
+ * @param len Number of bytes to read.
+ *
+ * @return 0 if ok, -ENODATA if there is less than len bytes left, in
+ *         which case the cursor is at the end of the data.
+ */
+int net_pkt_cursor_read(struct net_pkt_cursor *cursor, void *data,
+			u16_t len);
+
+/**
+ * @brief Read data at a cursor without moving it.
+ *
+ * @param cursor Cursor.
+ * @param data Where to copy the data.
+ * @param len Number of bytes to read.
+ *
+ * @return 0 if ok, -ENODATA if there is less than len bytes left.
+ */
+int net_pkt_cursor_peek(struct net_pkt_cursor *cursor, void *data,
+			u16_t len);
+
+/**
+ * @brief Move a cursor forward.
+ *
+ * @param cursor Cursor.
+ * @param len Number of bytes to skip.
+ *
+ * @return 0 if ok, -ENODATA if there is less than len bytes left.
+ */
+static inline int net_pkt_cursor_skip(struct net_pkt_cursor *cursor,
+				      u16_t len)
+{
+	return net_pkt_cursor_read(cursor, NULL, len);
+}
+
+/**
+ * @brief Read a byte at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value read.
+ *
+ * @return 0 if ok, -ENODATA at the end of the data.
+ */
+static inline int net_pkt_cursor_read_u8(struct net_pkt_cursor *cursor,
+					 u8_t *value)
+{
+	if (cursor->buf && cursor->pos < cursor->buf->len) {
+		*value = cursor->buf->data[cursor->pos++];
+		return 0;
+	}
+
+	return net_pkt_cursor_read(cursor, value, sizeof(u8_t));
+}
+
+/**
+ * @brief Read a 16 bit big endian value at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value read, in host byte order.
+ *
+ * @return 0 if ok, -ENODATA if there is less than 2 bytes left.
+ */
+int net_pkt_cursor_read_be16(struct net_pkt_cursor *cursor, u16_t *value);
+
+/**
+ * @brief Read a 32 bit big endian value at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value read, in host byte order.
+ *
+ * @return 0 if ok, -ENODATA if there is less than 4 bytes left.
+ */
+int net_pkt_cursor_read_be32(struct net_pkt_cursor *cursor, u32_t *value);
+
+/**
+ * @brief Write data at a cursor and move it after the data.
+ *
+ * @details The data of the packet is overwritten, and the packet grows if
+ * the cursor reaches its end, like with net_pkt_append().
+ *
+ * @param cursor Cursor.
+ * @param data Data to write.
+ * @param len Number of bytes to write.
+ * @param timeout Affects the action taken should the net buf pool be empty.
+ *
+ * @return 0 if ok, -ENOMEM if the data could not be added to the packet.
+ */
+int net_pkt_cursor_write(struct net_pkt_cursor *cursor, const void *data,
+			 u16_t len, s32_t timeout);
+
+/**
+ * @brief Write a byte at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value to write.
+ * @param timeout Affects the action taken should the net buf pool be empty.
+ *
+ * @return 0 if ok, -ENOMEM if the data could not be added to the packet.
+ */
+static inline int net_pkt_cursor_write_u8(struct net_pkt_cursor *cursor,
+					  u8_t value, s32_t timeout)
+{
+	return net_pkt_cursor_write(cursor, &value, sizeof(u8_t), timeout);
+}
+
+/**
+ * @brief Write a 16 bit value in big endian at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value to write, in host byte order.
+ * @param timeout Affects the action taken should the net buf pool be empty.
+ *
+ * @return 0 if ok, -ENOMEM if the data could not be added to the packet.
+ */
+static inline int net_pkt_cursor_write_be16(struct net_pkt_cursor *cursor,
+					    u16_t value, s32_t timeout)
+{
+	u16_t data = htons(value);
+
+	return net_pkt_cursor_write(cursor, &data, sizeof(u16_t), timeout);
+}
+
+/**
+ * @brief Write a 32 bit value in big endian at a cursor.
+ *
+ * @param cursor Cursor.
+ * @param value Value to write, in host byte order.
+ * @param timeout Affects the action taken should the net buf pool be empty.
+ *
+ * @return 0 if ok, -ENOMEM if the data could not be added to the packet.
+ */
+static inline int net_pkt_cursor_write_be32(struct net_pkt_cursor *cursor,
+					    u32_t value, s32_t timeout)
+{
+	u32_t data = htonl(value);
+
+	return net_pkt_cursor_write(cursor, &data, sizeof(u32_t), timeout);
+}
+
+/**
+ * @brief Copy data from a cursor to another.
+ *
+ * @details The data is copied one contiguous span at a time, and both
+ * cursors are moved after it.
+ *
+ * @param dst Cursor to write at.
+ * @param src Cursor to read from.
+ * @param len Number of bytes to copy.
+ * @param timeout Affects the action taken should the net buf pool be empty.
+ *
+ * @return 0 if ok, -ENODATA if src has less than len bytes left, -ENOMEM
+ *         if the data could not be added to the destination packet.
+ */
+int net_pkt_cursor_copy(struct net_pkt_cursor *dst,
+			struct net_pkt_cursor *src, u16_t len, s32_t timeout);
+
 /**
  * @brief Write data to an arbitrary offset in fragments list of a packet.
  *
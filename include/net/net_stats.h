@@ -78,6 +78,23 @@ struct net_stats_ip_errors {
 	net_stats_t protoerr;
 };
 
+struct net_stats_ipv4_frag {
+	/** Number of received IPv4 fragments. */
+	net_stats_t recv;
+
+	/** Number of sent IPv4 fragments. */
+	net_stats_t sent;
+
+	/** Number of reassembled IPv4 datagrams. */
+	net_stats_t reassembled;
+
+	/** Number of dropped IPv4 fragments. */
+	net_stats_t drop;
+
+	/** Number of IPv4 reassemblies that timed out. */
+	net_stats_t timeout;
+};
+
 struct net_stats_icmp {
 	/** Number of received ICMP packets. */
 	net_stats_t recv;
@@ -270,6 +287,10 @@ struct net_stats {
 	struct net_stats_ip ipv4;
 #endif
 
+#if defined(CONFIG_NET_STATISTICS_IPV4_FRAGMENT)
+	struct net_stats_ipv4_frag ipv4_frag;
+#endif
+
 #if defined(CONFIG_NET_STATISTICS_ICMP)
 	struct net_stats_icmp icmp;
 #endif
@@ -45,8 +45,30 @@ struct zsock_pollfd {
 #define ZSOCK_POLLNVAL 0x20
 
 #define ZSOCK_MSG_PEEK 0x02
+#define ZSOCK_MSG_TRUNC 0x20
 #define ZSOCK_MSG_DONTWAIT 0x40
 
+struct zsock_iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+
+/* Ancillary data is not supported, msg_control is ignored */
+struct zsock_msghdr {
+	void *msg_name;
+	socklen_t msg_namelen;
+	struct zsock_iovec *msg_iov;
+	size_t msg_iovlen;
+	void *msg_control;
+	size_t msg_controllen;
+	int msg_flags;
+};
+
+struct zsock_mmsghdr {
+	struct zsock_msghdr msg_hdr;
+	unsigned int msg_len;
+};
+
 /* Protocol level for TLS.
  * Here, the same socket protocol level for TLS as in Linux was used.
  */
@@ -92,8 +114,26 @@ struct zsock_pollfd {
  * mbedTLS values:
  * 0 - client,
  * 1 - server.
+ * A DTLS server socket put in the listening state with listen() serves many
+ * peers on one port, and accept() returns a socket for each peer that
+ * completed the handshake (requires CONFIG_NET_SOCKETS_DTLS_SERVER).
  */
 #define TLS_DTLS_ROLE 6
+/* Socket option to enable TLS/DTLS session resumption on a socket. With
+ * the option enabled, a client reuses the session of an earlier connection
+ * to the same peer address and hostname, and a server lets its clients
+ * resume their sessions, so that the full handshake is skipped. This option
+ * accepts and returns an integer:
+ * 0 - disabled,
+ * 1 - enabled.
+ * By default, session resumption is disabled. It requires
+ * CONFIG_NET_SOCKETS_TLS_SESSION_CACHE.
+ */
+#define TLS_SESSION_CACHE 7
+/* Write-only socket option to drop all cached TLS/DTLS sessions, both of
+ * clients and of servers. The option value is ignored.
+ */
+#define TLS_SESSION_CACHE_PURGE 8
 
 struct zsock_addrinfo {
 	struct zsock_addrinfo *ai_next;
@@ -143,6 +183,21 @@ static inline ssize_t zsock_recv(int sock, void *buf, size_t max_len,
 	return zsock_recvfrom(sock, buf, max_len, flags, NULL, NULL);
 }
 
+__syscall ssize_t zsock_sendmsg(int sock, const struct zsock_msghdr *msg,
+				int flags);
+
+__syscall ssize_t zsock_recvmsg(int sock, struct zsock_msghdr *msg, int flags);
+
+/* Unlike POSIX, there is no timeout argument. Only the first message is
+ * waited for according to flags, the following ones are received only if
+ * they are already queued.
+ */
+__syscall int zsock_sendmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
+__syscall int zsock_recvmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
 __syscall int zsock_fcntl(int sock, int cmd, int flags);
 
 __syscall int zsock_poll(struct zsock_pollfd *fds, int nfds, int timeout);
@@ -164,6 +219,84 @@ int zsock_getaddrinfo(const char *host, const char *service,
 		      const struct zsock_addrinfo *hints,
 		      struct zsock_addrinfo **res);
 
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+struct net_pkt;
+struct net_buf;
+
+/**
+ * @brief Receive data from a socket without copying it
+ *
+ * @details The packet holding the received data is lent to the caller,
+ * which must give it back with zsock_recv_zc_release() once the data has
+ * been processed. Only the payload is left in the fragment chain of the
+ * packet. For a stream socket, the receive window is not opened again
+ * until the packet is released. This function is only available to kernel
+ * threads.
+ *
+ * @param sock Socket descriptor.
+ * @param pkt Lent packet, or NULL if no data was returned.
+ * @param flags ZSOCK_MSG_DONTWAIT is supported, ZSOCK_MSG_PEEK is not.
+ * @param src_addr Source address of a datagram, can be NULL.
+ * @param addrlen Length of src_addr, value-result argument.
+ *
+ * @return Length of the lent data, 0 at the end of stream, -1 with errno
+ * set on error.
+ */
+ssize_t zsock_recvfrom_zc(int sock, struct net_pkt **pkt, int flags,
+			  struct sockaddr *src_addr, socklen_t *addrlen);
+
+static inline ssize_t zsock_recv_zc(int sock, struct net_pkt **pkt, int flags)
+{
+	return zsock_recvfrom_zc(sock, pkt, flags, NULL, NULL);
+}
+
+/**
+ * @brief Release a packet lent by zsock_recvfrom_zc()
+ *
+ * @param sock Socket descriptor the packet was received from.
+ * @param pkt Lent packet.
+ */
+void zsock_recv_zc_release(int sock, struct net_pkt *pkt);
+
+/**
+ * @brief Allocate a network buffer for zsock_sendto_zc()
+ *
+ * @param sock Socket descriptor.
+ * @param timeout Time to wait for a free buffer.
+ *
+ * @return Network buffer, NULL with errno set on error.
+ */
+struct net_buf *zsock_get_buf(int sock, s32_t timeout);
+
+/**
+ * @brief Send a chain of network buffers without copying it
+ *
+ * @details The socket takes ownership of the buffer chain whatever the
+ * result. The buffers should be allocated with zsock_get_buf() so that
+ * they come from the data pool of the socket. Data that does not
+ * fit into one packet is sent in several packets for a stream socket and
+ * makes the call fail with EMSGSIZE for a datagram socket. If sending
+ * fails after some of the data was sent, the rest of the chain is freed
+ * and the amount of data sent is returned. This function is only
+ * available to kernel threads.
+ *
+ * @param sock Socket descriptor.
+ * @param frags Buffer chain holding the data.
+ * @param flags ZSOCK_MSG_DONTWAIT is supported.
+ * @param dest_addr Destination address of a datagram, can be NULL.
+ * @param addrlen Length of dest_addr.
+ *
+ * @return Amount of data sent, -1 with errno set on error.
+ */
+ssize_t zsock_sendto_zc(int sock, struct net_buf *frags, int flags,
+			const struct sockaddr *dest_addr, socklen_t addrlen);
+
+static inline ssize_t zsock_send_zc(int sock, struct net_buf *frags, int flags)
+{
+	return zsock_sendto_zc(sock, frags, flags, NULL, 0);
+}
+#endif /* defined(CONFIG_NET_SOCKETS_ZEROCOPY) */
+
 #if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
 
 int ztls_socket(int family, int type, int proto);
@@ -178,6 +311,12 @@ ssize_t ztls_sendto(int sock, const void *buf, size_t len, int flags,
 		    const struct sockaddr *dest_addr, socklen_t addrlen);
 ssize_t ztls_recvfrom(int sock, void *buf, size_t max_len, int flags,
 		      struct sockaddr *src_addr, socklen_t *addrlen);
+ssize_t ztls_sendmsg(int sock, const struct zsock_msghdr *msg, int flags);
+ssize_t ztls_recvmsg(int sock, struct zsock_msghdr *msg, int flags);
+int ztls_sendmmsg(int sock, struct zsock_mmsghdr *msgvec, unsigned int vlen,
+		  int flags);
+int ztls_recvmmsg(int sock, struct zsock_mmsghdr *msgvec, unsigned int vlen,
+		  int flags);
 int ztls_fcntl(int sock, int cmd, int flags);
 int ztls_poll(struct zsock_pollfd *fds, int nfds, int timeout);
 int ztls_getsockopt(int sock, int level, int optname,
@@ -263,6 +402,45 @@ static inline ssize_t recv(int sock, void *buf, size_t max_len, int flags)
 #endif /* defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS) */
 }
 
+static inline ssize_t sendmsg(int sock, const struct zsock_msghdr *msg,
+			      int flags)
+{
+#if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
+	return ztls_sendmsg(sock, msg, flags);
+#else
+	return zsock_sendmsg(sock, msg, flags);
+#endif /* defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS) */
+}
+
+static inline ssize_t recvmsg(int sock, struct zsock_msghdr *msg, int flags)
+{
+#if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
+	return ztls_recvmsg(sock, msg, flags);
+#else
+	return zsock_recvmsg(sock, msg, flags);
+#endif /* defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS) */
+}
+
+static inline int sendmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+#if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
+	return ztls_sendmmsg(sock, msgvec, vlen, flags);
+#else
+	return zsock_sendmmsg(sock, msgvec, vlen, flags);
+#endif /* defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS) */
+}
+
+static inline int recvmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+#if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
+	return ztls_recvmmsg(sock, msgvec, vlen, flags);
+#else
+	return zsock_recvmmsg(sock, msgvec, vlen, flags);
+#endif /* defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS) */
+}
+
 /* This conflicts with fcntl.h, so code must include fcntl.h before socket.h: */
 #if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
 #define fcntl ztls_fcntl
@@ -357,8 +535,13 @@ struct addrinfo {
 #define POLLNVAL ZSOCK_POLLNVAL
 
 #define MSG_PEEK ZSOCK_MSG_PEEK
+#define MSG_TRUNC ZSOCK_MSG_TRUNC
 #define MSG_DONTWAIT ZSOCK_MSG_DONTWAIT
 
+#define iovec zsock_iovec
+#define msghdr zsock_msghdr
+#define mmsghdr zsock_mmsghdr
+
 static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 			      size_t size)
 {
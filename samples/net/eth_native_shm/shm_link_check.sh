@@ -0,0 +1,127 @@
+#!/bin/sh
+#
+# Copyright (c) 2018 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# This script checks the shared memory link of native posix with the
+# eth_native_shm sample: node 2 sends echo requests to node 1, first over a
+# plain link, then over a lossy one and over a slow one.
+#
+# Usage: shm_link_check.sh [path to zephyr.exe]
+
+ZEPHYR_EXE=${1:-build/zephyr/zephyr.exe}
+
+# A link of its own, so that other instances on the host are not disturbed
+LINK_NAME=zephyr-link-check-$$
+LINK=/dev/shm/$LINK_NAME
+
+# ECHO_COUNT of the sample
+ECHO_COUNT=200
+
+LOSS=100000
+SEED=1234
+DELAY=20000
+
+LOG=$(mktemp)
+SERVER=
+FAILED=0
+
+cleanup() {
+    if [ -n "$SERVER" ]; then
+	kill $SERVER 2>/dev/null
+    fi
+
+    # Left behind if an instance had to be killed
+    rm -f $LOG $LINK $LINK.*
+}
+
+trap cleanup EXIT
+
+# Runs node 1 with the options given in $1 and node 2 with the ones given
+# in $2, and prints the result lines of node 2.
+run() {
+    $ZEPHYR_EXE --rt --eth-shm-link=$LINK_NAME --eth-shm-node=1 $1 \
+	> /dev/null 2>&1 &
+    SERVER=$!
+
+    # Let node 1 set up its address
+    sleep 1
+
+    timeout 120 $ZEPHYR_EXE --rt --eth-shm-link=$LINK_NAME \
+	--eth-shm-node=2 $2 > $LOG 2>&1
+
+    kill $SERVER 2>/dev/null
+    wait $SERVER 2>/dev/null
+    SERVER=
+
+    grep "^node 2:" $LOG
+}
+
+received() {
+    echo "$1" | sed -n 's/^node 2: \([0-9]*\)\/.*/\1/p'
+}
+
+# Sequence numbers of the echoes lost
+lost() {
+    echo "$1" | sed -n 's/^node 2: lost//p'
+}
+
+rtt() {
+    echo "$1" | sed -n \
+	's/.*rtt min\/avg\/max \([0-9]*\)\/\([0-9]*\)\/\([0-9]*\) ms/\'$2'/p'
+}
+
+check() {
+    if [ "$1" = 0 ]; then
+	echo "PASS: $2"
+    else
+	echo "FAIL: $2"
+	FAILED=1
+    fi
+}
+
+if [ ! -x "$ZEPHYR_EXE" ]; then
+    echo "Cannot find $ZEPHYR_EXE"
+    exit 1
+fi
+
+# Every echo comes back over a plain link
+RESULT=$(run "" "")
+echo "$RESULT"
+[ "$(received "$RESULT")" = "$ECHO_COUNT" ]
+check $? "frames delivered"
+
+# Node 2 loses LOSS ppm of the echoes, the same ones for the same seed
+RESULT=$(run "" "--eth-shm-loss=$LOSS --eth-shm-seed=$SEED")
+echo "$RESULT"
+LOST=$((ECHO_COUNT - $(received "$RESULT")))
+EXPECTED=$((ECHO_COUNT * LOSS / 1000000))
+[ $LOST -ge $((EXPECTED / 2)) ] && [ $LOST -le $((EXPECTED * 3 / 2)) ]
+check $? "$LOST echoes lost, about $EXPECTED expected"
+
+AGAIN=$(run "" "--eth-shm-loss=$LOSS --eth-shm-seed=$SEED")
+echo "$AGAIN"
+[ -n "$(lost "$RESULT")" ] && [ "$(lost "$AGAIN")" = "$(lost "$RESULT")" ]
+check $? "same echoes lost for the same seed"
+
+# Both ways are delayed by DELAY us
+RESULT=$(run "--eth-shm-delay=$DELAY" "--eth-shm-delay=$DELAY")
+echo "$RESULT"
+MIN=$(rtt "$RESULT" 1)
+AVG=$(rtt "$RESULT" 2)
+EXPECTED=$((2 * DELAY / 1000))
+[ -n "$MIN" ] && [ $MIN -ge $EXPECTED ] && [ $AVG -lt $((EXPECTED + 10)) ]
+check $? "round trip of ${AVG:-?} ms, $EXPECTED ms expected"
+
+exit $FAILED
@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# Copyright (c) 2018 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# This script runs the eth_native_shm sample on a link of many instances:
+# node 1 echoes the requests of all the other nodes, which must all report
+# that their echoes came back.
+#
+# Usage: shm_link_nodes.sh [path to zephyr.exe] [number of nodes]
+
+ZEPHYR_EXE=${1:-build/zephyr/zephyr.exe}
+NODES=${2:-50}
+
+# A link of its own, so that other instances on the host are not disturbed
+LINK_NAME=zephyr-link-nodes-$$
+LINK=/dev/shm/$LINK_NAME
+
+# ECHO_COUNT of the sample. The link loses nothing, but an echo later than
+# the timeout of the sample counts as lost on a loaded host.
+ECHO_COUNT=200
+MIN_RECEIVED=$((ECHO_COUNT * 9 / 10))
+
+LOGS=$(mktemp -d)
+SERVER=
+CLIENTS=
+FAILED=0
+
+cleanup() {
+    if [ -n "$SERVER$CLIENTS" ]; then
+	kill $SERVER $CLIENTS 2>/dev/null
+    fi
+
+    # Left behind if an instance had to be killed
+    rm -rf $LOGS $LINK $LINK.*
+}
+
+trap cleanup EXIT
+
+if [ ! -x "$ZEPHYR_EXE" ]; then
+    echo "Cannot find $ZEPHYR_EXE"
+    exit 1
+fi
+
+if [ "$NODES" -lt 2 ] || [ "$NODES" -gt 254 ]; then
+    echo "Invalid number of nodes $NODES (should be 2 to 254)"
+    exit 1
+fi
+
+$ZEPHYR_EXE --rt --eth-shm-link=$LINK_NAME --eth-shm-node=1 \
+    > /dev/null 2>&1 &
+SERVER=$!
+
+# Let node 1 set up its address
+sleep 1
+
+for i in $(seq 2 $NODES); do
+    timeout 300 $ZEPHYR_EXE --rt --eth-shm-link=$LINK_NAME \
+	--eth-shm-node=$i > $LOGS/$i 2>&1 &
+    CLIENTS="$CLIENTS $!"
+done
+
+wait $CLIENTS
+CLIENTS=
+
+kill $SERVER 2>/dev/null
+wait $SERVER 2>/dev/null
+SERVER=
+
+for i in $(seq 2 $NODES); do
+    RESULT=$(grep "^node $i: [0-9]" $LOGS/$i)
+    RECEIVED=$(echo "$RESULT" | sed -n 's/^node [0-9]*: \([0-9]*\)\/.*/\1/p')
+
+    if [ -z "$RECEIVED" ] || [ $RECEIVED -lt $MIN_RECEIVED ]; then
+	echo "FAIL: ${RESULT:-node $i: no result}"
+	FAILED=1
+    fi
+done
+
+if [ $FAILED = 0 ]; then
+    echo "PASS: $((NODES - 1)) nodes got their echoes from node 1"
+fi
+
+exit $FAILED
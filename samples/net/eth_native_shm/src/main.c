@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <misc/printk.h>
+
+#include <net/net_if.h>
+#include <net/socket.h>
+
+#include "posix_board_if.h"
+
+#define PORT 4242
+
+/* Node 1 echoes the requests, the other nodes measure the link to it */
+#define SERVER_NODE 1
+
+#define ECHO_COUNT 200
+#define ECHO_TIMEOUT_MS 250
+
+struct echo {
+	u32_t seq;
+	u32_t sent;
+};
+
+/* Node n is 192.0.2.n, its node id being the last byte of its MAC */
+static int node_setup(void)
+{
+	struct net_if *iface = net_if_get_default();
+	struct in_addr addr = { { { 192, 0, 2, 0 } } };
+	struct in_addr netmask = { { { 255, 255, 255, 0 } } };
+	int node;
+
+	node = net_if_get_link_addr(iface)->addr[5];
+	addr.s4_addr[3] = node;
+
+	if (!net_if_ipv4_addr_add(iface, &addr, NET_ADDR_MANUAL, 0)) {
+		return -EINVAL;
+	}
+
+	net_if_ipv4_set_netmask(iface, &netmask);
+
+	return node;
+}
+
+static void echo_server(int sock)
+{
+	struct sockaddr_in peer;
+	socklen_t peer_len;
+	struct echo echo;
+	ssize_t len;
+
+	printk("Echoing on port %d\n", PORT);
+
+	while (1) {
+		peer_len = sizeof(peer);
+		len = recvfrom(sock, &echo, sizeof(echo), 0,
+			       (struct sockaddr *)&peer, &peer_len);
+		if (len < 0) {
+			printk("Cannot receive (%d)\n", errno);
+			continue;
+		}
+
+		sendto(sock, &echo, len, 0, (struct sockaddr *)&peer,
+		       peer_len);
+	}
+}
+
+/* Waits for the echo of a request, skipping the late ones */
+static bool echo_wait(int sock, u32_t seq, u32_t *rtt)
+{
+	struct pollfd pfd = {
+		.fd = sock,
+		.events = POLLIN,
+	};
+	struct echo echo;
+
+	while (poll(&pfd, 1, ECHO_TIMEOUT_MS) > 0) {
+		if (recv(sock, &echo, sizeof(echo), 0) == sizeof(echo) &&
+		    echo.seq == seq) {
+			*rtt = k_uptime_get_32() - echo.sent;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void echo_client(int sock, int node)
+{
+	struct sockaddr_in server = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT),
+		.sin_addr = { { { 192, 0, 2, SERVER_NODE } } },
+	};
+	u32_t rtt, rtt_min = UINT32_MAX, rtt_max = 0, rtt_sum = 0;
+	static bool lost[ECHO_COUNT];
+	u32_t received = 0;
+	struct echo echo;
+	int i;
+
+	for (echo.seq = 0; echo.seq < ECHO_COUNT; echo.seq++) {
+		echo.sent = k_uptime_get_32();
+		if (sendto(sock, &echo, sizeof(echo), 0,
+			   (struct sockaddr *)&server, sizeof(server)) < 0) {
+			printk("Cannot send (%d)\n", errno);
+			continue;
+		}
+
+		if (!echo_wait(sock, echo.seq, &rtt)) {
+			lost[echo.seq] = true;
+			continue;
+		}
+
+		received++;
+		rtt_sum += rtt;
+		rtt_min = min(rtt_min, rtt);
+		rtt_max = max(rtt_max, rtt);
+	}
+
+	/* The format is parsed by shm_link_check.sh */
+	printk("node %d: %u/%u echoes received", node, received, ECHO_COUNT);
+	if (received) {
+		printk(", rtt min/avg/max %u/%u/%u ms", rtt_min,
+		       rtt_sum / received, rtt_max);
+	}
+	printk("\n");
+
+	printk("node %d: lost", node);
+	for (i = 0; i < ECHO_COUNT; i++) {
+		if (lost[i]) {
+			printk(" %d", i);
+		}
+	}
+	printk("\n");
+}
+
+void main(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT),
+	};
+	int node, sock;
+
+	node = node_setup();
+	if (node < 0) {
+		printk("Cannot set the node address\n");
+		return;
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		printk("Cannot create socket (%d)\n", errno);
+		return;
+	}
+
+	if (node == SERVER_NODE) {
+		if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			printk("Cannot bind (%d)\n", errno);
+			return;
+		}
+
+		echo_server(sock);
+	}
+
+	echo_client(sock, node);
+	close(sock);
+
+	posix_exit(0);
+}
@@ -13,6 +13,7 @@
 
 #include <errno.h>
 #include <misc/util.h>
+#include <random/rand32.h>
 
 #include <net/net_core.h>
 #include <net/net_pkt.h>
@@ -46,304 +47,95 @@
 
 static struct net_conn conns[CONFIG_NET_MAX_CONN];
 
-#if defined(CONFIG_NET_CONN_CACHE)
-
-/* Cache the connection so that we do not have to go
- * through the full list of connections when receiving
- * a network packet. The cache contains an index to
- * corresponding entry in conns array.
- *
- * Hash value is constructed like this:
- *
- *   bit      description
- *   0  - 3   bits from remote port
- *   4  - 7   bits from local port
- *   8  - 18  bits from remote address
- *   19 - 29  bits from local address
- *   30       family
- *   31       protocol
+BUILD_ASSERT_MSG(!(CONFIG_NET_CONN_HASH_SIZE &
+		   (CONFIG_NET_CONN_HASH_SIZE - 1)),
+		 "Connection hash size must be a power of two");
+
+/* The connections are kept in a hash table so that we do not have to go
+ * through all of them when receiving a network packet. Connections that
+ * know the remote address and both ports are hashed using the protocol,
+ * remote address and ports of the packet. All the other connections are
+ * hashed using the protocol and local port only, so that a listener is
+ * found in the bucket of its port or, if the local port is not set, in
+ * the bucket of port 0.
  */
-struct conn_hash {
-	u32_t value;
-	s32_t idx;
-};
+static sys_slist_t conn_hash[CONFIG_NET_CONN_HASH_SIZE];
 
-struct conn_hash_neg {
-	u32_t value;
-};
-
-/** Connection cache */
-static struct conn_hash conn_cache[CONFIG_NET_MAX_CONN];
-
-/** Negative cache, we definitely do not have a connection
- * to these hosts.
+/* Random seed so that remote peers cannot easily choose addresses and
+ * ports that all end up in the same bucket. It is set when the first
+ * connection is registered, the buckets are all empty before that.
  */
-static struct conn_hash_neg conn_cache_neg[CONFIG_NET_MAX_CONN];
-
-#define TAKE_BIT(val, bit, max, used)				\
-	(((val & BIT(bit)) >> bit) << (max - used))
+static u32_t conn_hash_seed;
 
-static inline u8_t ports_to_hash(u16_t remote_port,
-				    u16_t local_port)
+static inline u32_t hash_mix(u32_t hash, u32_t value)
 {
-	/* Note that we do not convert port value to network byte order */
-	return (remote_port & BIT(0)) |
-		((remote_port & BIT(4)) >> 3) |
-		((remote_port & BIT(8)) >> 6) |
-		((remote_port & BIT(15)) >> 12) |
-		(((local_port & BIT(0)) |
-		  ((local_port & BIT(4)) >> 3) |
-		  ((local_port & BIT(8)) >> 6) |
-		  ((local_port & BIT(15)) >> 12)) << 4);
-}
+	hash ^= value;
+	hash *= 0x9e3779b1;
 
-static inline u16_t ipv6_to_hash(struct in6_addr *addr)
-{
-	/* There is 11 bits available for IPv6 address */
-	/* Use more bits from the lower part of address space */
-	return
-		/* Take 3 bits from higher values */
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[0]), 31, 11, 1) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[0]), 15, 11, 2) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[0]), 7, 11, 3) |
-
-		/* Take 2 bits from higher middle values */
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[1]), 31, 11, 4) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[1]), 15, 11, 5) |
-
-		/* Take 2 bits from lower middle values */
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[2]), 31, 11, 6) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[2]), 15, 11, 7) |
-
-		/* Take 4 bits from lower values */
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[3]), 31, 11, 8) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[3]), 15, 11, 9) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[3]), 7, 11, 10) |
-		TAKE_BIT(UNALIGNED_GET(&addr->s6_addr32[3]), 0, 11, 11);
-}
-
-static inline u16_t ipv4_to_hash(struct in_addr *addr)
-{
-	/* There is 11 bits available for IPv4 address */
-	/* Use more bits from the lower part of address space */
-	return
-		TAKE_BIT(addr->s_addr, 31, 11, 1) |
-		TAKE_BIT(addr->s_addr, 27, 11, 2) |
-		TAKE_BIT(addr->s_addr, 21, 11, 3) |
-		TAKE_BIT(addr->s_addr, 17, 11, 4) |
-		TAKE_BIT(addr->s_addr, 14, 11, 5) |
-		TAKE_BIT(addr->s_addr, 11, 11, 6) |
-		TAKE_BIT(addr->s_addr, 8, 11, 7) |
-		TAKE_BIT(addr->s_addr, 5, 11, 8) |
-		TAKE_BIT(addr->s_addr, 3, 11, 9) |
-		TAKE_BIT(addr->s_addr, 2, 11, 10) |
-		TAKE_BIT(addr->s_addr, 0, 11, 11);
+	return hash ^ (hash >> 15);
 }
 
-/* Return either the first free position in the cache (idx < 0) or
- * the existing cached position (idx >= 0)
- */
-static s32_t check_hash(enum net_ip_protocol proto,
-			  sa_family_t family,
-			  void *remote_addr,
-			  void *local_addr,
-			  u16_t remote_port,
-			  u16_t local_port,
-			  u32_t *cache_value)
+static sys_slist_t *hash_tuple(u8_t proto, sa_family_t family,
+			       const void *remote_addr,
+			       u16_t remote_port, u16_t local_port)
 {
-	int i, free_pos = -1;
-	u32_t value = 0;
-
-	value = ports_to_hash(remote_port, local_port);
-
-#if defined(CONFIG_NET_UDP)
-	if (proto == IPPROTO_UDP) {
-		value |= BIT(31);
-	}
-#endif
+	u32_t hash = hash_mix(conn_hash_seed, proto << 16 | family);
 
-#if defined(CONFIG_NET_TCP)
-	if (proto == IPPROTO_TCP) {
-		value &= ~BIT(31);
-	}
-#endif
-
-#if defined(CONFIG_NET_IPV6)
-	if (family == AF_INET6) {
-		value |= BIT(30);
-		value |= ipv6_to_hash((struct in6_addr *)remote_addr) << 8;
-		value |= ipv6_to_hash((struct in6_addr *)local_addr) << 19;
-	}
-#endif
+	hash = hash_mix(hash, remote_port << 16 | local_port);
 
-#if defined(CONFIG_NET_IPV4)
-	if (family == AF_INET) {
-		value &= ~BIT(30);
-		value |= ipv4_to_hash((struct in_addr *)remote_addr) << 8;
-		value |= ipv4_to_hash((struct in_addr *)local_addr) << 19;
-	}
-#endif
-
-	for (i = 0; i < CONFIG_NET_MAX_CONN; i++) {
-		if (conn_cache[i].value == value) {
-			return i;
-		}
+	if (IS_ENABLED(CONFIG_NET_IPV6) && family == AF_INET6) {
+		const struct in6_addr *addr6 = remote_addr;
+		int i;
 
-		if (conn_cache[i].idx < 0 && free_pos < 0) {
-			free_pos = i;
+		for (i = 0; i < 4; i++) {
+			hash = hash_mix(hash,
+					UNALIGNED_GET(&addr6->s6_addr32[i]));
 		}
-	}
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) && family == AF_INET) {
+		const struct in_addr *addr4 = remote_addr;
 
-	if (free_pos >= 0) {
-		conn_cache[free_pos].value = value;
-		return free_pos;
+		hash = hash_mix(hash, UNALIGNED_GET(&addr4->s_addr));
 	}
 
-	*cache_value = value;
-
-	return -ENOENT;
+	return &conn_hash[hash & (CONFIG_NET_CONN_HASH_SIZE - 1)];
 }
 
-static inline s32_t get_conn(enum net_ip_protocol proto,
-			     sa_family_t family,
-			     struct net_pkt *pkt,
-			     u32_t *cache_value)
+static sys_slist_t *hash_local(u8_t proto, u16_t local_port)
 {
-	struct net_udp_hdr hdr, *udp_hdr;
-
-	udp_hdr = net_udp_get_hdr(pkt, &hdr);
-	if (!udp_hdr) {
-		return NET_DROP;
-	}
-
-#if defined(CONFIG_NET_IPV4)
-	if (family == AF_INET) {
-		return check_hash(proto, family,
-				  &NET_IPV4_HDR(pkt)->src,
-				  &NET_IPV4_HDR(pkt)->dst,
-				  udp_hdr->src_port,
-				  udp_hdr->dst_port,
-				  cache_value);
-	}
-#endif
-
-#if defined(CONFIG_NET_IPV6)
-	if (family == AF_INET6) {
-		return check_hash(proto, family,
-				  &NET_IPV6_HDR(pkt)->src,
-				  &NET_IPV6_HDR(pkt)->dst,
-				  udp_hdr->src_port,
-				  udp_hdr->dst_port,
-				  cache_value);
-	}
-#endif
+	u32_t hash = hash_mix(conn_hash_seed, proto << 16 | local_port);
 
-	return -1;
+	return &conn_hash[hash & (CONFIG_NET_CONN_HASH_SIZE - 1)];
 }
 
-static inline void cache_add_neg(u32_t cache_value)
+static inline bool conn_is_connected(struct net_conn *conn)
 {
-	int i;
-
-	for (i = 0; i < CONFIG_NET_MAX_CONN && cache_value > 0; i++) {
-		if (conn_cache_neg[i].value) {
-			continue;
-		}
-
-		NET_DBG("Add to neg cache value 0x%x", cache_value);
-
-		conn_cache_neg[i].value = cache_value;
-		break;
-	}
+	return (conn->rank & (NET_RANK_REMOTE_SPEC_ADDR |
+			      NET_RANK_REMOTE_PORT | NET_RANK_LOCAL_PORT)) ==
+		(NET_RANK_REMOTE_SPEC_ADDR | NET_RANK_REMOTE_PORT |
+		 NET_RANK_LOCAL_PORT);
 }
 
-static inline bool cache_check_neg(u32_t cache_value)
+/* Ports are in network byte order in the hash */
+static sys_slist_t *conn_bucket(struct net_conn *conn)
 {
-	int i;
+	const void *remote_addr;
 
-	for (i = 0; i < CONFIG_NET_MAX_CONN && cache_value > 0; i++) {
-		if (conn_cache_neg[i].value == cache_value) {
-			NET_DBG("Cache neg [%d] value 0x%x found",
-				i, cache_value);
-			return true;
+	if (conn_is_connected(conn)) {
+		if (conn->remote_addr.sa_family == AF_INET6) {
+			remote_addr = &net_sin6(&conn->remote_addr)->sin6_addr;
+		} else {
+			remote_addr = &net_sin(&conn->remote_addr)->sin_addr;
 		}
-	}
-
-	return false;
-}
-
-static void cache_clear(void)
-{
-	int i;
-
-	for (i = 0; i < CONFIG_NET_MAX_CONN; i++) {
-		conn_cache[i].idx = -1;
-		conn_cache_neg[i].value = 0;
-	}
-}
-
-static inline enum net_verdict cache_check(enum net_ip_protocol proto,
-					   struct net_pkt *pkt,
-					   u32_t *cache_value,
-					   s32_t *pos)
-{
-	*pos = get_conn(proto, net_pkt_family(pkt), pkt, cache_value);
-	if (*pos >= 0) {
-		if (conn_cache[*pos].idx >= 0) {
-			/* Connection is in the cache */
-			struct net_conn *conn;
-			struct net_udp_hdr hdr, *udp_hdr;
-
-			udp_hdr = net_udp_get_hdr(pkt, &hdr);
-			if (!udp_hdr) {
-				return NET_CONTINUE;
-			}
-
-			conn = &conns[conn_cache[*pos].idx];
 
-			NET_DBG("Cache %s listener for pkt %p src port %u "
-				"dst port %u family %d cache[%d] 0x%x",
-				net_proto2str(proto), pkt,
-				ntohs(udp_hdr->src_port),
-				ntohs(udp_hdr->dst_port),
-				net_pkt_family(pkt), *pos,
-				conn_cache[*pos].value);
-
-			return conn->cb(conn, pkt, conn->user_data);
-		}
-	} else if (*cache_value > 0) {
-		if (cache_check_neg(*cache_value)) {
-			NET_DBG("Drop by cache");
-			return NET_DROP;
-		}
+		return hash_tuple(conn->proto, conn->remote_addr.sa_family,
+				  remote_addr,
+				  net_sin(&conn->remote_addr)->sin_port,
+				  net_sin(&conn->local_addr)->sin_port);
 	}
 
-	return NET_CONTINUE;
+	return hash_local(conn->proto, net_sin(&conn->local_addr)->sin_port);
 }
 
-static inline void cache_remove(struct net_conn *conn)
-{
-	int i;
-
-	for (i = 0; i < CONFIG_NET_MAX_CONN; i++) {
-		if (conn_cache[i].idx < 0 ||
-		    conn_cache[i].idx >= CONFIG_NET_MAX_CONN) {
-			continue;
-		}
-
-		if (&conns[conn_cache[i].idx] == conn) {
-			conn_cache[i].idx = -1;
-			break;
-		}
-	}
-}
-#else
-#define cache_clear(...)
-#define cache_add_neg(...)
-#define cache_check(...) NET_CONTINUE
-#define cache_remove(...)
-#endif /* CONFIG_NET_CONN_CACHE */
-
 int net_conn_unregister(struct net_conn_handle *handle)
 {
 	struct net_conn *conn = (struct net_conn *)handle;
@@ -356,7 +148,7 @@ int net_conn_unregister(struct net_conn_handle *handle)
 		return -ENOENT;
 	}
 
-	cache_remove(conn);
+	sys_slist_find_and_remove(conn_bucket(conn), &conn->node);
 
 	NET_DBG("[%zu] connection handler %p removed",
 		conn - conns, conn);
@@ -672,8 +464,11 @@ int net_conn_register(enum net_ip_protocol proto,
 		conns[i].rank = rank;
 		conns[i].proto = proto;
 
-		/* Cache needs to be cleared if new entries are added. */
-		cache_clear();
+		if (!conn_hash_seed) {
+			conn_hash_seed = sys_rand32_get() | 1;
+		}
+
+		sys_slist_append(conn_bucket(&conns[i]), &conns[i].node);
 
 		if (NET_LOG_LEVEL >= LOG_LEVEL_DBG) {
 			char dst[NET_IPV6_ADDR_LEN];
@@ -798,25 +593,101 @@ static bool is_invalid_packet(struct net_pkt *pkt,
 	return my_src_addr && (src_port == dst_port);
 }
 
+static bool conn_match(struct net_conn *conn, enum net_ip_protocol proto,
+		       struct net_pkt *pkt, u16_t src_port, u16_t dst_port)
+{
+	if (!(conn->flags & NET_CONN_IN_USE)) {
+		return false;
+	}
+
+	if (conn->proto != proto) {
+		return false;
+	}
+
+	if (net_sin(&conn->remote_addr)->sin_port) {
+		if (net_sin(&conn->remote_addr)->sin_port != src_port) {
+			return false;
+		}
+	}
+
+	if (net_sin(&conn->local_addr)->sin_port) {
+		if (net_sin(&conn->local_addr)->sin_port != dst_port) {
+			return false;
+		}
+	}
+
+	if (conn->flags & NET_CONN_REMOTE_ADDR_SET) {
+		if (!check_addr(pkt, &conn->remote_addr, true)) {
+			return false;
+		}
+	}
+
+	if (conn->flags & NET_CONN_LOCAL_ADDR_SET) {
+		if (!check_addr(pkt, &conn->local_addr, false)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Find the most specific connection for the packet. The candidates are
+ * the connected ones in the bucket of the packet tuple, the listeners
+ * of the destination port and the listeners without a local port.
+ */
+static struct net_conn *conn_find(enum net_ip_protocol proto,
+				  struct net_pkt *pkt,
+				  u16_t src_port, u16_t dst_port)
+{
+	struct net_conn *conn, *best_match = NULL;
+	sys_slist_t *buckets[3];
+	const void *src_addr;
+	int i;
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && net_pkt_family(pkt) == AF_INET6) {
+		src_addr = &NET_IPV6_HDR(pkt)->src;
+	} else {
+		src_addr = &NET_IPV4_HDR(pkt)->src;
+	}
+
+	buckets[0] = hash_tuple(proto, net_pkt_family(pkt), src_addr,
+				src_port, dst_port);
+	buckets[1] = hash_local(proto, dst_port);
+	buckets[2] = hash_local(proto, 0);
+
+	for (i = 0; i < ARRAY_SIZE(buckets); i++) {
+		if ((i > 0 && buckets[i] == buckets[0]) ||
+		    (i > 1 && buckets[i] == buckets[1])) {
+			continue;
+		}
+
+		SYS_SLIST_FOR_EACH_CONTAINER(buckets[i], conn, node) {
+			if (!conn_match(conn, proto, pkt, src_port,
+					dst_port)) {
+				continue;
+			}
+
+			/* Prefer the higher rank, and the connection that
+			 * was registered first if the ranks are the same.
+			 */
+			if (!best_match || best_match->rank < conn->rank ||
+			    (best_match->rank == conn->rank &&
+			     conn < best_match)) {
+				best_match = conn;
+			}
+		}
+	}
+
+	return best_match;
+}
+
 enum net_verdict net_conn_input(enum net_ip_protocol proto, struct net_pkt *pkt)
 {
-	int i, best_match = -1;
-	s16_t best_rank = -1;
+	struct net_conn *best_match;
 	u16_t src_port, dst_port;
 	u16_t chksum;
 	struct net_if *pkt_iface = net_pkt_iface(pkt);
 
-#if defined(CONFIG_NET_CONN_CACHE)
-	enum net_verdict verdict;
-	u32_t cache_value = 0;
-	s32_t pos;
-
-	verdict = cache_check(proto, pkt, &cache_value, &pos);
-	if (verdict != NET_CONTINUE) {
-		return verdict;
-	}
-#endif
-
 	/* This is only used for getting source and destination ports.
 	 * Because both TCP and UDP header have these in the same
 	 * location, we can check them both using the UDP struct.
@@ -876,57 +747,8 @@ enum net_verdict net_conn_input(enum net_ip_protocol proto, struct net_pkt *pkt)
 			net_pkt_family(pkt), ntohs(chksum), data_len);
 	}
 
-	for (i = 0; i < CONFIG_NET_MAX_CONN; i++) {
-		if (!(conns[i].flags & NET_CONN_IN_USE)) {
-			continue;
-		}
-
-		if (conns[i].proto != proto) {
-			continue;
-		}
-
-		if (net_sin(&conns[i].remote_addr)->sin_port) {
-			if (net_sin(&conns[i].remote_addr)->sin_port !=
-			    src_port) {
-				continue;
-			}
-		}
-
-		if (net_sin(&conns[i].local_addr)->sin_port) {
-			if (net_sin(&conns[i].local_addr)->sin_port !=
-			    dst_port) {
-				continue;
-			}
-		}
-
-		if (conns[i].flags & NET_CONN_REMOTE_ADDR_SET) {
-			if (!check_addr(pkt, &conns[i].remote_addr, true)) {
-				continue;
-			}
-		}
-
-		if (conns[i].flags & NET_CONN_LOCAL_ADDR_SET) {
-			if (!check_addr(pkt, &conns[i].local_addr, false)) {
-				continue;
-			}
-		}
-
-		/* If we have an existing best_match, and that one
-		 * specifies a remote port, then we've matched to a
-		 * LISTENING connection that should not override.
-		 */
-		if (best_match >= 0 &&
-		    net_sin(&conns[best_match].remote_addr)->sin_port) {
-			continue;
-		}
-
-		if (best_rank < conns[i].rank) {
-			best_rank = conns[i].rank;
-			best_match = i;
-		}
-	}
-
-	if (best_match >= 0) {
+	best_match = conn_find(proto, pkt, src_port, dst_port);
+	if (best_match) {
 
 		/* If packet has a listener configured, then check also the
 		 * protocol checksum if that checking is enabled.
@@ -950,7 +772,8 @@ enum net_verdict net_conn_input(enum net_ip_protocol proto, struct net_pkt *pkt)
 
 		} else if (IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) &&
 			   proto == IPPROTO_TCP &&
-			   net_if_need_calc_rx_checksum(net_pkt_iface(pkt))) {
+			   net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+			   !net_pkt_chksum_verified(pkt)) {
 			u16_t chksum_calc;
 
 			net_tcp_set_chksum(pkt, pkt->frags);
@@ -966,27 +789,14 @@ enum net_verdict net_conn_input(enum net_ip_protocol proto, struct net_pkt *pkt)
 			}
 		}
 
-#if defined(CONFIG_NET_CONN_CACHE)
-		NET_DBG("[%d] match found cb %p ud %p rank 0x%02x cache 0x%x",
-			best_match,
-			conns[best_match].cb,
-			conns[best_match].user_data,
-			conns[best_match].rank,
-			pos < 0 ? 0 : conn_cache[pos].value);
+		NET_DBG("[%zu] match found cb %p ud %p rank 0x%02x",
+			best_match - conns,
+			best_match->cb,
+			best_match->user_data,
+			best_match->rank);
 
-		if (pos >= 0) {
-			conn_cache[pos].idx = best_match;
-		}
-#else
-		NET_DBG("[%d] match found cb %p ud %p rank 0x%02x",
-			best_match,
-			conns[best_match].cb,
-			conns[best_match].user_data,
-			conns[best_match].rank);
-#endif /* CONFIG_NET_CONN_CACHE */
-
-		if (conns[best_match].cb(&conns[best_match], pkt,
-			     conns[best_match].user_data) == NET_DROP) {
+		if (best_match->cb(best_match, pkt,
+				   best_match->user_data) == NET_DROP) {
 			goto drop;
 		}
 
@@ -997,8 +807,6 @@ enum net_verdict net_conn_input(enum net_ip_protocol proto, struct net_pkt *pkt)
 
 	NET_DBG("No match found.");
 
-	cache_add_neg(cache_value);
-
 #if defined(CONFIG_NET_IPV6)
 	/* If the destination address is multicast address,
 	 * we do not send ICMP error as that makes no sense.
@@ -1043,13 +851,9 @@ void net_conn_foreach(net_conn_foreach_cb_t cb, void *user_data)
 
 void net_conn_init(void)
 {
-#if defined(CONFIG_NET_CONN_CACHE)
-	do {
-		int i;
+	int i;
 
-		for (i = 0; i < CONFIG_NET_MAX_CONN; i++) {
-			conn_cache[i].idx = -1;
-		}
-	} while (0);
-#endif /* CONFIG_NET_CONN_CACHE */
+	for (i = 0; i < CONFIG_NET_CONN_HASH_SIZE; i++) {
+		sys_slist_init(&conn_hash[i]);
+	}
 }
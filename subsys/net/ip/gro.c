@@ -0,0 +1,294 @@
+/** @file
+ * @brief Generic receive offload for TCP
+ *
+ * Consecutive in-order TCP segments of a connection that are received in
+ * the same Rx batch are merged together before they are passed to TCP.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_gro
+#define NET_LOG_LEVEL CONFIG_NET_TCP_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <string.h>
+#include <misc/byteorder.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "tcp_internal.h"
+#include "ipv4.h"
+#include "gro.h"
+
+/* The coalesced segment must fit into the 16-bit IP length field */
+#define GRO_MAX_LEN 0xffff
+
+struct gro_flow {
+	/** Segment that the following ones are appended to */
+	struct net_pkt *pkt;
+
+	/** TCP header of the first segment */
+	struct net_tcp_hdr *tcp;
+
+	/** Last buffer of the coalesced segment */
+	struct net_buf *last;
+
+	/** Sequence number that the next segment must have */
+	u32_t next_seq;
+
+	/** Total length of the coalesced segment including headers */
+	u32_t len;
+
+	/** Length of the IP and TCP headers */
+	u16_t hdr_len;
+
+	/** Number of segments coalesced */
+	u8_t count;
+};
+
+static struct gro_flow flows[NET_TC_RX_COUNT];
+
+/* Check that the packet is a plain TCP data segment and return its TCP
+ * header. The IP and TCP headers must be in the first buffer.
+ */
+static struct net_tcp_hdr *gro_parse(struct net_pkt *pkt, u16_t *hdr_len,
+				     u32_t *len)
+{
+	struct net_buf *buf = pkt->frags;
+	struct net_tcp_hdr *tcp;
+	u8_t ip_len;
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) &&
+	    (NET_IPV6_HDR(pkt)->vtc & 0xf0) == 0x40) {
+		struct net_ipv4_hdr *hdr = NET_IPV4_HDR(pkt);
+
+		if (hdr->vhl != 0x45 || hdr->proto != IPPROTO_TCP ||
+		    net_ipv4_is_fragment(hdr)) {
+			return NULL;
+		}
+
+		ip_len = NET_IPV4H_LEN;
+		*len = ntohs(hdr->len);
+		net_pkt_set_family(pkt, AF_INET);
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+		   (NET_IPV6_HDR(pkt)->vtc & 0xf0) == 0x60) {
+		struct net_ipv6_hdr *hdr = NET_IPV6_HDR(pkt);
+
+		if (hdr->nexthdr != IPPROTO_TCP) {
+			return NULL;
+		}
+
+		ip_len = NET_IPV6H_LEN;
+		*len = ntohs(hdr->len) + NET_IPV6H_LEN;
+		net_pkt_set_family(pkt, AF_INET6);
+		net_pkt_set_ipv6_ext_len(pkt, 0);
+	} else {
+		return NULL;
+	}
+
+	if (buf->len < ip_len + NET_TCPH_LEN) {
+		return NULL;
+	}
+
+	/* Only the IPv4 header of the first segment is kept, a segment with
+	 * a corrupt header is left to the IPv4 input.
+	 */
+	if (ip_len == NET_IPV4H_LEN &&
+	    net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+	    net_calc_chksum_ipv4(pkt) != 0xffff) {
+		return NULL;
+	}
+
+	tcp = (struct net_tcp_hdr *)(buf->data + ip_len);
+
+	*hdr_len = ip_len + (tcp->offset >> 4) * 4;
+
+	if (*hdr_len < ip_len + NET_TCPH_LEN || buf->len < *hdr_len ||
+	    *len <= *hdr_len) {
+		return NULL;
+	}
+
+	if ((tcp->flags & ~NET_TCP_PSH) != NET_TCP_ACK) {
+		return NULL;
+	}
+
+	if (*len != net_buf_frags_len(buf)) {
+		return NULL;
+	}
+
+	net_pkt_set_ip_hdr_len(pkt, ip_len);
+
+	return tcp;
+}
+
+static bool gro_chksum_ok(struct net_pkt *pkt)
+{
+	if (!IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) ||
+	    !net_if_need_calc_rx_checksum(net_pkt_iface(pkt))) {
+		return true;
+	}
+
+	/* The sum over a valid segment including its checksum is 0xffff */
+	if (net_calc_chksum_tcp(pkt) != 0xffff) {
+		return false;
+	}
+
+	net_pkt_set_chksum_verified(pkt, true);
+
+	return true;
+}
+
+static bool gro_same_flow(struct gro_flow *flow, struct net_pkt *pkt,
+			  struct net_tcp_hdr *tcp)
+{
+	struct net_pkt *head = flow->pkt;
+
+	if (net_pkt_family(head) != net_pkt_family(pkt) ||
+	    net_pkt_iface(head) != net_pkt_iface(pkt)) {
+		return false;
+	}
+
+	/* Source and destination ports */
+	if (memcmp(flow->tcp, tcp, 2 * sizeof(u16_t))) {
+		return false;
+	}
+
+	/* The TOS, including ECN, and the TTL of the merged segments are
+	 * those of the first one.
+	 */
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
+		struct net_ipv4_hdr *ip = NET_IPV4_HDR(head);
+		struct net_ipv4_hdr *hdr = NET_IPV4_HDR(pkt);
+
+		return ip->tos == hdr->tos && ip->ttl == hdr->ttl &&
+		       !memcmp(&ip->src, &hdr->src,
+			       2 * sizeof(struct in_addr));
+	}
+
+	/* Likewise the traffic class, flow label and hop limit */
+	return !memcmp(NET_IPV6_HDR(head), NET_IPV6_HDR(pkt),
+		       offsetof(struct net_ipv6_hdr, len)) &&
+	       NET_IPV6_HDR(head)->hop_limit ==
+	       NET_IPV6_HDR(pkt)->hop_limit &&
+	       !memcmp(&NET_IPV6_HDR(head)->src, &NET_IPV6_HDR(pkt)->src,
+		       2 * sizeof(struct in6_addr));
+}
+
+static bool gro_merge(struct gro_flow *flow, struct net_pkt *pkt,
+		      struct net_tcp_hdr *tcp, u16_t hdr_len, u32_t len)
+{
+	u32_t data_len = len - hdr_len;
+
+	if (!gro_same_flow(flow, pkt, tcp)) {
+		return false;
+	}
+
+	/* A pushed segment ends the coalescing. The ack, window and options
+	 * must be the same as in the first segment as only its header is
+	 * kept.
+	 */
+	if ((flow->tcp->flags & NET_TCP_PSH) ||
+	    flow->count >= CONFIG_NET_GRO_MAX_SEGS ||
+	    flow->len + data_len > GRO_MAX_LEN ||
+	    hdr_len != flow->hdr_len ||
+	    sys_get_be32(tcp->seq) != flow->next_seq ||
+	    memcmp(flow->tcp->ack, tcp->ack, sizeof(tcp->ack)) ||
+	    memcmp(flow->tcp->wnd, tcp->wnd, sizeof(tcp->wnd)) ||
+	    memcmp(flow->tcp->optdata, tcp->optdata,
+		   hdr_len - net_pkt_ip_hdr_len(pkt) - NET_TCPH_LEN)) {
+		return false;
+	}
+
+	flow->tcp->flags |= tcp->flags & NET_TCP_PSH;
+
+	/* Append the payload buffers without copying */
+	net_buf_pull(pkt->frags, hdr_len);
+	if (!pkt->frags->len) {
+		pkt->frags = net_buf_frag_del(NULL, pkt->frags);
+	}
+
+	flow->last->frags = pkt->frags;
+	flow->last = net_buf_frag_last(pkt->frags);
+	pkt->frags = NULL;
+
+	net_pkt_unref(pkt);
+
+	flow->len += data_len;
+	flow->next_seq += data_len;
+	flow->count++;
+
+	return true;
+}
+
+struct net_pkt *net_gro_flush(u8_t tc)
+{
+	struct gro_flow *flow = &flows[tc];
+	struct net_pkt *pkt = flow->pkt;
+
+	if (!pkt) {
+		return NULL;
+	}
+
+	flow->pkt = NULL;
+
+	if (flow->count == 1) {
+		return pkt;
+	}
+
+	NET_DBG("Coalesced %d segments into pkt %p len %u", flow->count,
+		pkt, flow->len);
+
+	if (net_pkt_family(pkt) == AF_INET) {
+		struct net_ipv4_hdr *hdr = NET_IPV4_HDR(pkt);
+		u16_t len = htons(flow->len);
+
+		hdr->chksum = net_chksum_update_u16(hdr->chksum, hdr->len, len);
+		hdr->len = len;
+	} else {
+		NET_IPV6_HDR(pkt)->len = htons(flow->len - NET_IPV6H_LEN);
+	}
+
+	return pkt;
+}
+
+enum net_verdict net_gro_receive(struct net_pkt *pkt,
+				 struct net_pkt **flushed)
+{
+	u8_t tc = net_rx_priority2tc(net_pkt_priority(pkt));
+	struct gro_flow *flow = &flows[tc];
+	struct net_tcp_hdr *tcp;
+	u16_t hdr_len;
+	u32_t len;
+
+	*flushed = NULL;
+
+	tcp = gro_parse(pkt, &hdr_len, &len);
+	if (!tcp || !gro_chksum_ok(pkt)) {
+		*flushed = net_gro_flush(tc);
+		return NET_CONTINUE;
+	}
+
+	if (flow->pkt && gro_merge(flow, pkt, tcp, hdr_len, len)) {
+		return NET_OK;
+	}
+
+	*flushed = net_gro_flush(tc);
+
+	flow->pkt = pkt;
+	flow->tcp = tcp;
+	flow->last = net_buf_frag_last(pkt->frags);
+	flow->next_seq = sys_get_be32(tcp->seq) + len - hdr_len;
+	flow->len = len;
+	flow->hdr_len = hdr_len;
+	flow->count = 1;
+
+	return NET_OK;
+}
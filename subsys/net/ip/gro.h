@@ -0,0 +1,59 @@
+/** @file
+ @brief Generic receive offload for TCP
+
+ This is not to be included by the application and is only used by
+ core IP stack.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __GRO_H
+#define __GRO_H
+
+#include <zephyr/types.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Try to coalesce a received packet with earlier TCP segments.
+ *
+ * @details The packet must have passed L2 processing so that it starts
+ * with the IP header. Only one segment is kept pending per Rx traffic
+ * class. If the packet cannot be merged with the pending one, the pending
+ * segment is returned in flushed and the caller must process it before
+ * the packet.
+ *
+ * @param pkt Received network packet.
+ * @param flushed Pending segment to be processed by the caller, or NULL.
+ *
+ * @return NET_OK if the packet was taken by GRO, NET_CONTINUE if the
+ * caller must process the packet normally.
+ */
+enum net_verdict net_gro_receive(struct net_pkt *pkt,
+				 struct net_pkt **flushed);
+
+/**
+ * @brief Return the pending coalesced segment of a traffic class.
+ *
+ * @details This is called when an Rx batch has been processed.
+ *
+ * @param tc Rx traffic class.
+ *
+ * @return Pending segment that the caller must process, or NULL.
+ */
+struct net_pkt *net_gro_flush(u8_t tc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GRO_H */
@@ -104,40 +104,32 @@ static inline void setup_ipv6_header(struct net_pkt *pkt, u16_t extra_len,
 
 int net_icmpv6_set_chksum(struct net_pkt *pkt)
 {
+	struct net_pkt_cursor cursor, chksum_cursor;
 	u16_t chksum = 0;
-	struct net_buf *frag;
-	struct net_buf *temp_frag;
-	u16_t temp_pos;
-	u16_t pos;
 
 	/* Skip to the position of checksum */
-	frag = net_frag_skip(pkt->frags, 0, &pos,
-			     net_pkt_ip_hdr_len(pkt) +
-			     net_pkt_ipv6_ext_len(pkt) +
-			     1 + 1 /* type + code */);
-	if (pos > 0 && !frag) {
+	net_pkt_cursor_init(&cursor, pkt);
+	if (net_pkt_cursor_skip(&cursor, net_pkt_ip_hdr_len(pkt) +
+				net_pkt_ipv6_ext_len(pkt) +
+				1 + 1 /* type + code */) < 0) {
 		return -EINVAL;
 	}
 
-	/* Cache checksum fragment and postion, to be safe side first
-	 * write 0's in checksum position and calculate checksum and
-	 * write checksum in the packet.
+	/* Cache checksum position, to be safe side first write 0's in
+	 * checksum position and calculate checksum and write checksum in
+	 * the packet.
 	 */
-	temp_frag = frag;
-	temp_pos = pos;
+	chksum_cursor = cursor;
 
-	frag = net_pkt_write(pkt, frag, pos, &pos, sizeof(chksum),
-			     (u8_t *)&chksum, PKT_WAIT_TIME);
-	if (pos > 0 && !frag) {
+	if (net_pkt_cursor_write(&cursor, &chksum, sizeof(chksum),
+				 PKT_WAIT_TIME) < 0) {
 		return -EINVAL;
 	}
 
 	chksum = ~net_calc_chksum_icmpv6(pkt);
 
-	temp_frag = net_pkt_write(pkt, temp_frag, temp_pos, &temp_pos,
-				  sizeof(chksum), (u8_t *)&chksum,
-				  PKT_WAIT_TIME);
-	if (temp_pos > 0 && !temp_frag) {
+	if (net_pkt_cursor_write(&chksum_cursor, &chksum, sizeof(chksum),
+				 PKT_WAIT_TIME) < 0) {
 		return -EINVAL;
 	}
 
@@ -150,6 +150,16 @@ enum net_verdict net_ipv4_process_pkt(struct net_pkt *pkt)
 		goto drop;
 	}
 
+	if (net_ipv4_is_fragment(hdr)) {
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+		return net_ipv4_handle_fragment(pkt);
+#else
+		NET_DBG("IPv4 fragment in pkt %p dropped", pkt);
+		net_stats_update_ip_errors_fragerr(net_pkt_iface(pkt));
+		goto drop;
+#endif
+	}
+
 	net_pkt_set_transport_proto(pkt, hdr->proto);
 
 	switch (hdr->proto) {
@@ -14,6 +14,7 @@
 #define __IPV4_H
 
 #include <zephyr/types.h>
+#include <misc/byteorder.h>
 
 #include <net/net_ip.h>
 #include <net/net_pkt.h>
@@ -52,4 +53,100 @@ struct net_pkt *net_ipv4_create(struct net_pkt *pkt,
  */
 void net_ipv4_finalize(struct net_pkt *pkt, u8_t next_header_proto);
 
+/* Flags and fragment offset mask of the IPv4 header offset field */
+#define NET_IPV4_DF 0x4000
+#define NET_IPV4_MF 0x2000
+#define NET_IPV4_FRAGH_OFFSET_MASK 0x1fff
+
+/**
+ * @brief Check if the IPv4 packet is a fragment of a larger datagram.
+ *
+ * @param hdr IPv4 header of the packet
+ *
+ * @return True if more fragments follow or the fragment offset is not zero.
+ */
+static inline bool net_ipv4_is_fragment(struct net_ipv4_hdr *hdr)
+{
+	return (sys_get_be16(hdr->offset) &
+		(NET_IPV4_MF | NET_IPV4_FRAGH_OFFSET_MASK)) != 0;
+}
+
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+#define NET_IPV4_FRAGMENTS_MAX_PKT CONFIG_NET_IPV4_FRAGMENT_MAX_PKT
+
+/** Store pending IPv4 fragment information that is needed for reassembly. */
+struct net_ipv4_reassembly {
+	/** IPv4 source address of the fragment */
+	struct in_addr src;
+
+	/** IPv4 destination address of the fragment */
+	struct in_addr dst;
+
+	/** Timeout for cancelling the reassembly */
+	struct k_delayed_work timer;
+
+	/**
+	 * Pointers to pending fragments, sorted by fragment offset. The
+	 * slot is in use if it holds at least one fragment.
+	 */
+	struct net_pkt *pkt[NET_IPV4_FRAGMENTS_MAX_PKT];
+
+	/** Length of the reassembled payload, 0 until the last fragment
+	 * has been received.
+	 */
+	u16_t len;
+
+	/** IPv4 fragment identification */
+	u16_t id;
+
+	/** Protocol of the fragmented datagram */
+	u8_t proto;
+};
+
+/**
+ * @typedef net_ipv4_frag_cb_t
+ * @brief Callback used while iterating over pending IPv4 fragments.
+ *
+ * @param reass IPv4 fragment reassembly struct
+ * @param user_data A valid pointer on some user data or NULL
+ */
+typedef void (*net_ipv4_frag_cb_t)(struct net_ipv4_reassembly *reass,
+				   void *user_data);
+
+/**
+ * @brief Go through all the currently pending IPv4 fragments.
+ *
+ * @param cb Callback to call for each pending IPv4 fragment.
+ * @param user_data User specified data or NULL.
+ */
+void net_ipv4_frag_foreach(net_ipv4_frag_cb_t cb, void *user_data);
+
+/**
+ * @brief Handles received IPv4 fragments.
+ *
+ * The fragment is stored until all the fragments of the datagram have
+ * been received. The reassembled datagram is then fed back to the IP
+ * stack.
+ *
+ * @param pkt Network packet containing the fragment.
+ *
+ * @return Return verdict about the packet
+ */
+enum net_verdict net_ipv4_handle_fragment(struct net_pkt *pkt);
+
+/**
+ * @brief Send an IPv4 datagram that does not fit into the MTU as
+ * fragments.
+ *
+ * @param iface Network interface the datagram is sent to.
+ * @param pkt Network packet containing the datagram. The caller still
+ * owns the packet after the call.
+ * @param mtu MTU of the network interface.
+ *
+ * @return 0 if the fragments were sent, <0 otherwise.
+ */
+int net_ipv4_send_fragmented_pkt(struct net_if *iface, struct net_pkt *pkt,
+				 u16_t mtu);
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #endif /* __IPV4_H */
@@ -0,0 +1,541 @@
+/** @file
+ * @brief IPv4 Fragment related functions
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_ipv4_frag
+#define NET_LOG_LEVEL CONFIG_NET_IPV4_LOG_LEVEL
+
+#include <errno.h>
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_stats.h>
+#include <net/net_context.h>
+#include <random/rand32.h>
+#include "net_private.h"
+#include "connection.h"
+#include "udp_internal.h"
+#include "tcp_internal.h"
+#include "ipv4.h"
+#include "net_stats.h"
+
+#define IPV4_REASSEMBLY_TIMEOUT K_SECONDS(CONFIG_NET_IPV4_FRAGMENT_TIMEOUT)
+
+#define FRAG_BUF_WAIT K_MSEC(10) /* how long to max wait for a buffer */
+#define BUF_ALLOC_TIMEOUT K_MSEC(100)
+
+/* Largest payload that an IPv4 datagram can carry */
+#define IPV4_MAX_PAYLOAD (0xffff - NET_IPV4H_LEN)
+
+static void reassembly_timeout(struct k_work *work);
+static bool reassembly_init_done;
+
+/* A reassembly slot is in use when it holds at least one fragment */
+static struct net_ipv4_reassembly
+reassembly[CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT];
+
+static u16_t ipv4_id;
+
+static inline u16_t fragment_len(struct net_pkt *pkt)
+{
+	return ntohs(NET_IPV4_HDR(pkt)->len) - NET_IPV4H_LEN;
+}
+
+static void reassembly_init(void)
+{
+	int i;
+
+	if (reassembly_init_done) {
+		return;
+	}
+
+	/* Static initializing does not work here because of the array
+	 * so we must do it at runtime.
+	 */
+	for (i = 0; i < CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT; i++) {
+		k_delayed_work_init(&reassembly[i].timer, reassembly_timeout);
+	}
+
+	reassembly_init_done = true;
+}
+
+static struct net_ipv4_reassembly *reassembly_get(u16_t id, u8_t proto,
+						  struct in_addr *src,
+						  struct in_addr *dst)
+{
+	int i, avail = -1;
+
+	for (i = 0; i < CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT; i++) {
+		if (!reassembly[i].pkt[0]) {
+			if (avail < 0) {
+				avail = i;
+			}
+
+			continue;
+		}
+
+		if (reassembly[i].id == id &&
+		    reassembly[i].proto == proto &&
+		    net_ipv4_addr_cmp(src, &reassembly[i].src) &&
+		    net_ipv4_addr_cmp(dst, &reassembly[i].dst)) {
+			return &reassembly[i];
+		}
+	}
+
+	if (avail < 0) {
+		return NULL;
+	}
+
+	k_delayed_work_submit(&reassembly[avail].timer,
+			      IPV4_REASSEMBLY_TIMEOUT);
+
+	net_ipaddr_copy(&reassembly[avail].src, src);
+	net_ipaddr_copy(&reassembly[avail].dst, dst);
+
+	reassembly[avail].id = id;
+	reassembly[avail].proto = proto;
+	reassembly[avail].len = 0;
+
+	return &reassembly[avail];
+}
+
+static void reassembly_cancel(struct net_ipv4_reassembly *reass)
+{
+	int i;
+
+	NET_DBG("Cancel 0x%x", reass->id);
+
+	k_delayed_work_cancel(&reass->timer);
+
+	for (i = 0; i < NET_IPV4_FRAGMENTS_MAX_PKT; i++) {
+		if (!reass->pkt[i]) {
+			continue;
+		}
+
+		NET_DBG("[%d] IPv4 reassembly pkt %p %zd bytes data",
+			i, reass->pkt[i], net_pkt_get_len(reass->pkt[i]));
+
+		net_pkt_unref(reass->pkt[i]);
+		reass->pkt[i] = NULL;
+	}
+}
+
+static void reassembly_info(char *str, struct net_ipv4_reassembly *reass)
+{
+	int i, len;
+
+	for (i = 0, len = 0; i < NET_IPV4_FRAGMENTS_MAX_PKT; i++) {
+		if (reass->pkt[i]) {
+			len += fragment_len(reass->pkt[i]);
+		}
+	}
+
+	NET_DBG("%s id 0x%x src %s dst %s remain %d ms len %d/%d", str,
+		reass->id,
+		log_strdup(net_sprint_ipv4_addr(&reass->src)),
+		log_strdup(net_sprint_ipv4_addr(&reass->dst)),
+		k_delayed_work_remaining_get(&reass->timer), len, reass->len);
+}
+
+static void reassembly_timeout(struct k_work *work)
+{
+	struct net_ipv4_reassembly *reass =
+		CONTAINER_OF(work, struct net_ipv4_reassembly, timer);
+
+	if (!reass->pkt[0]) {
+		return;
+	}
+
+	reassembly_info("Reassembly cancelled", reass);
+
+	net_stats_update_ipv4_frag_timeout(net_pkt_iface(reass->pkt[0]));
+
+	reassembly_cancel(reass);
+}
+
+void net_ipv4_frag_foreach(net_ipv4_frag_cb_t cb, void *user_data)
+{
+	int i;
+
+	for (i = 0; reassembly_init_done &&
+		     i < CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT; i++) {
+		if (!reassembly[i].pkt[0]) {
+			continue;
+		}
+
+		cb(&reassembly[i], user_data);
+	}
+}
+
+/* Place the fragment to the list that is kept sorted by fragment offset. */
+static int fragment_insert(struct net_ipv4_reassembly *reass,
+			   struct net_pkt *pkt)
+{
+	u16_t offset = net_pkt_ipv4_fragment_offset(pkt);
+	int i;
+
+	for (i = 0; i < NET_IPV4_FRAGMENTS_MAX_PKT; i++) {
+		if (!reass->pkt[i]) {
+			reass->pkt[i] = pkt;
+			return 0;
+		}
+
+		if (net_pkt_ipv4_fragment_offset(reass->pkt[i]) == offset) {
+			return -EALREADY;
+		}
+
+		if (net_pkt_ipv4_fragment_offset(reass->pkt[i]) > offset) {
+			break;
+		}
+	}
+
+	if (i == NET_IPV4_FRAGMENTS_MAX_PKT ||
+	    reass->pkt[NET_IPV4_FRAGMENTS_MAX_PKT - 1]) {
+		return -ENOMEM;
+	}
+
+	memmove(&reass->pkt[i + 1], &reass->pkt[i],
+		sizeof(reass->pkt[0]) * (NET_IPV4_FRAGMENTS_MAX_PKT - i - 1));
+
+	reass->pkt[i] = pkt;
+
+	return 0;
+}
+
+/* Check whether the fragments cover the whole datagram. Returns 1 if the
+ * datagram is complete, 0 if fragments are still missing and <0 if the
+ * fragments overlap.
+ */
+static int fragments_check(struct net_ipv4_reassembly *reass)
+{
+	u32_t end = 0;
+	int i;
+
+	for (i = 0; i < NET_IPV4_FRAGMENTS_MAX_PKT && reass->pkt[i]; i++) {
+		u16_t offset = net_pkt_ipv4_fragment_offset(reass->pkt[i]);
+
+		if (offset < end) {
+			return -EINVAL;
+		}
+
+		if (offset > end) {
+			return 0;
+		}
+
+		end = offset + fragment_len(reass->pkt[i]);
+	}
+
+	return reass->len && end == reass->len;
+}
+
+static void reassemble_packet(struct net_ipv4_reassembly *reass)
+{
+	struct net_pkt *pkt;
+	struct net_buf *last;
+	int i, ret;
+
+	k_delayed_work_cancel(&reass->timer);
+
+	pkt = reass->pkt[0];
+	reass->pkt[0] = NULL;
+
+	last = net_buf_frag_last(pkt->frags);
+
+	/* We start from 2nd packet which is then appended to
+	 * the first one.
+	 */
+	for (i = 1; i < NET_IPV4_FRAGMENTS_MAX_PKT && reass->pkt[i]; i++) {
+		struct net_pkt *frag_pkt = reass->pkt[i];
+
+		reass->pkt[i] = NULL;
+
+		/* Get rid of IPv4 header which is at the beginning of
+		 * the fragment.
+		 */
+		ret = net_pkt_pull(frag_pkt, 0, NET_IPV4H_LEN);
+		if (ret) {
+			NET_ERR("Failed to pull headers");
+			net_pkt_unref(frag_pkt);
+			net_pkt_unref(pkt);
+			reassembly_cancel(reass);
+			return;
+		}
+
+		/* Attach the data to previous pkt */
+		last->frags = frag_pkt->frags;
+		last = net_buf_frag_last(frag_pkt->frags);
+
+		frag_pkt->frags = NULL;
+		net_pkt_unref(frag_pkt);
+	}
+
+	NET_IPV4_HDR(pkt)->len = htons(reass->len + NET_IPV4H_LEN);
+	NET_IPV4_HDR(pkt)->offset[0] = NET_IPV4_HDR(pkt)->offset[1] = 0;
+	NET_IPV4_HDR(pkt)->chksum = 0;
+	NET_IPV4_HDR(pkt)->chksum = ~net_calc_chksum_ipv4(pkt);
+
+	NET_DBG("New pkt %p IPv4 len is %d bytes", pkt, reass->len);
+
+	net_stats_update_ipv4_frag_reassembled(net_pkt_iface(pkt));
+
+	/* Feed the datagram back to the IP stack through the queue so that
+	 * we do not run out of stack. As the packet does not contain link
+	 * layer header, it is marked so that it is not passed to L2.
+	 */
+	net_pkt_set_ipv4_reassembled(pkt, true);
+
+	ret = net_recv_data(net_pkt_iface(pkt), pkt);
+	if (ret < 0) {
+		net_pkt_unref(pkt);
+	}
+}
+
+enum net_verdict net_ipv4_handle_fragment(struct net_pkt *pkt)
+{
+	struct net_ipv4_hdr *hdr = NET_IPV4_HDR(pkt);
+	struct net_ipv4_reassembly *reass;
+	u16_t flags, offset, len;
+	int ret;
+
+	reassembly_init();
+
+	net_stats_update_ipv4_frag_recv(net_pkt_iface(pkt));
+
+	flags = sys_get_be16(hdr->offset);
+	offset = (flags & NET_IPV4_FRAGH_OFFSET_MASK) * 8;
+	len = fragment_len(pkt);
+
+	/* All but the last fragment must carry a multiple of 8 bytes. */
+	if (!len || ((flags & NET_IPV4_MF) && (len % 8)) ||
+	    (u32_t)offset + len > IPV4_MAX_PAYLOAD) {
+		NET_DBG("Invalid fragment offset %u len %u", offset, len);
+		goto drop;
+	}
+
+	reass = reassembly_get(sys_get_be16(hdr->id), hdr->proto,
+			       &hdr->src, &hdr->dst);
+	if (!reass) {
+		NET_DBG("Cannot get reassembly slot, dropping pkt %p", pkt);
+		goto drop;
+	}
+
+	if (!(flags & NET_IPV4_MF)) {
+		if (reass->len && reass->len != offset + len) {
+			NET_DBG("Conflicting last fragment for 0x%x",
+				reass->id);
+			goto cancel;
+		}
+
+		reass->len = offset + len;
+	}
+
+	if (reass->len && offset + len > reass->len) {
+		NET_DBG("Fragment beyond the end of 0x%x", reass->id);
+		goto cancel;
+	}
+
+	net_pkt_set_ipv4_fragment_offset(pkt, offset);
+
+	ret = fragment_insert(reass, pkt);
+	if (ret == -EALREADY) {
+		NET_DBG("Duplicate fragment offset %u for 0x%x", offset,
+			reass->id);
+		goto drop;
+	} else if (ret < 0) {
+		/* We could not add this fragment into our saved fragment
+		 * list. We must discard the whole packet at this point.
+		 */
+		NET_DBG("No slots available for 0x%x", reass->id);
+		goto cancel;
+	}
+
+	ret = fragments_check(reass);
+	if (ret < 0) {
+		NET_DBG("Overlapping fragments for 0x%x", reass->id);
+		net_stats_update_ipv4_frag_drop(net_pkt_iface(pkt));
+
+		/* This releases also the current fragment */
+		reassembly_cancel(reass);
+		return NET_OK;
+	}
+
+	if (ret == 0) {
+		reassembly_info("Reassembly nth pkt", reass);
+		return NET_OK;
+	}
+
+	reassembly_info("Reassembly last pkt", reass);
+
+	/* All the fragments received, reassemble the packet */
+	reassemble_packet(reass);
+
+	return NET_OK;
+
+cancel:
+	reassembly_cancel(reass);
+
+drop:
+	net_stats_update_ipv4_frag_drop(net_pkt_iface(pkt));
+
+	return NET_DROP;
+}
+
+static int send_ipv4_fragment(struct net_if *iface,
+			      struct net_pkt *pkt,
+			      struct net_buf **rest,
+			      u16_t fit_len,
+			      u16_t frag_offset)
+{
+	struct net_pkt *ipv4;
+	struct net_buf *frag;
+	u16_t flags;
+	int ret;
+
+	/* The packet holds only the IPv4 header at this point */
+	ipv4 = net_pkt_clone(pkt, BUF_ALLOC_TIMEOUT);
+	if (!ipv4) {
+		NET_DBG("Cannot clone %p", pkt);
+		return -ENOMEM;
+	}
+
+	frag = *rest;
+	if (fit_len < net_buf_frags_len(*rest)) {
+		ret = net_pkt_split(pkt, frag, fit_len, rest, FRAG_BUF_WAIT);
+		if (ret < 0) {
+			net_buf_unref(frag);
+			goto fail;
+		}
+	} else {
+		*rest = NULL;
+	}
+
+	net_buf_frag_add(ipv4->frags, frag);
+
+	flags = frag_offset / 8;
+	if (*rest) {
+		flags |= NET_IPV4_MF;
+	}
+
+	sys_put_be16(flags, NET_IPV4_HDR(ipv4)->offset);
+	NET_IPV4_HDR(ipv4)->len = htons(net_pkt_get_len(ipv4));
+
+	/* Note that the upper layer checksum must not be calculated here
+	 * as that is already done for the whole datagram.
+	 */
+	NET_IPV4_HDR(ipv4)->chksum = 0;
+	if (net_if_need_calc_tx_checksum(iface)) {
+		NET_IPV4_HDR(ipv4)->chksum = ~net_calc_chksum_ipv4(ipv4);
+	}
+
+	net_stats_update_ipv4_frag_sent(iface);
+
+	if (net_if_send_data(iface, ipv4) == NET_DROP) {
+		NET_DBG("Cannot send fragment of %p", pkt);
+		ret = -EIO;
+		goto fail;
+	}
+
+	/* Let this packet to be sent and hopefully it will release
+	 * the memory that can be utilized for next sent IPv4 fragment.
+	 */
+	k_yield();
+
+	return 0;
+
+fail:
+	net_pkt_unref(ipv4);
+
+	return ret;
+}
+
+int net_ipv4_send_fragmented_pkt(struct net_if *iface, struct net_pkt *pkt,
+				 u16_t mtu)
+{
+	struct net_buf *rest = NULL;
+	struct net_pkt *clone;
+	u16_t frag_offset;
+	int fit_len;
+	int ret;
+
+	if (sys_get_be16(NET_IPV4_HDR(pkt)->offset) & NET_IPV4_DF) {
+		NET_DBG("Cannot fragment pkt %p, DF is set", pkt);
+		return -EMSGSIZE;
+	}
+
+	/* The fragment payload must be a multiple of 8 bytes */
+	fit_len = (mtu - NET_IPV4H_LEN) & ~7;
+	if (fit_len <= 0) {
+		NET_DBG("No room for IPv4 payload MTU %d", mtu);
+		return -EINVAL;
+	}
+
+	/* We cannot touch original pkt because it might be used for
+	 * some other purposes, like TCP resend etc. So we need to copy
+	 * the large pkt here and do the fragmenting with the clone.
+	 */
+	clone = net_pkt_clone(pkt, BUF_ALLOC_TIMEOUT);
+	if (!clone) {
+		NET_DBG("Cannot clone %p", pkt);
+		return -ENOMEM;
+	}
+
+	pkt = clone;
+
+	/* A device calculating the checksums cannot do it from the
+	 * fragments, so calculate the upper layer checksum of the whole
+	 * datagram here.
+	 */
+	if (!net_if_need_calc_tx_checksum(iface)) {
+		if (IS_ENABLED(CONFIG_NET_UDP) &&
+		    NET_IPV4_HDR(pkt)->proto == IPPROTO_UDP) {
+			net_udp_set_chksum(pkt, pkt->frags);
+		} else if (IS_ENABLED(CONFIG_NET_TCP) &&
+			   NET_IPV4_HDR(pkt)->proto == IPPROTO_TCP) {
+			net_tcp_set_chksum(pkt, pkt->frags);
+		}
+	}
+
+	if (!ipv4_id) {
+		ipv4_id = sys_rand32_get();
+	}
+
+	sys_put_be16(ipv4_id++, NET_IPV4_HDR(pkt)->id);
+
+	ret = net_pkt_split(pkt, pkt->frags, NET_IPV4H_LEN, &rest,
+			    FRAG_BUF_WAIT);
+	if (ret < 0 || net_pkt_get_len(pkt) != NET_IPV4H_LEN) {
+		NET_DBG("Cannot split packet (%d)", ret);
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	frag_offset = 0;
+
+	while (rest) {
+		ret = send_ipv4_fragment(iface, pkt, &rest, fit_len,
+					 frag_offset);
+		if (ret < 0) {
+			goto fail;
+		}
+
+		frag_offset += fit_len;
+	}
+
+	net_pkt_unref(pkt);
+
+	return 0;
+
+fail:
+	net_pkt_unref(pkt);
+
+	if (rest) {
+		net_buf_unref(rest);
+	}
+
+	return ret;
+}
@@ -0,0 +1,152 @@
+/** @file
+ * @brief IPv4 route handling.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_ipv4_route
+#define NET_LOG_LEVEL CONFIG_NET_IPV4_LOG_LEVEL
+
+#include <kernel.h>
+#include <zephyr/types.h>
+#include <errno.h>
+
+#include <net/net_core.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "route.h"
+#include "route_lpm.h"
+
+static struct net_route_entry_ipv4 routes[CONFIG_NET_MAX_IPV4_ROUTES];
+
+NET_ROUTE_LPM_DEFINE(route_lpm, CONFIG_NET_MAX_IPV4_ROUTES, 32);
+
+static bool route_iface_match(sys_snode_t *node, void *user_data)
+{
+	struct net_route_entry_ipv4 *route =
+		CONTAINER_OF(node, struct net_route_entry_ipv4, lpm_node);
+
+	return !user_data || route->iface == user_data;
+}
+
+struct net_route_entry_ipv4 *net_route_ipv4_lookup(struct net_if *iface,
+						   struct in_addr *dst)
+{
+	sys_snode_t *node;
+
+	node = net_route_lpm_lookup(&route_lpm, dst->s4_addr,
+				    route_iface_match, iface);
+	if (!node) {
+		return NULL;
+	}
+
+	return CONTAINER_OF(node, struct net_route_entry_ipv4, lpm_node);
+}
+
+struct net_route_entry_ipv4 *net_route_ipv4_add(struct net_if *iface,
+						struct in_addr *addr,
+						u8_t prefix_len,
+						struct in_addr *gw)
+{
+	struct net_route_entry_ipv4 *route = NULL;
+	int i;
+
+	NET_ASSERT(iface);
+	NET_ASSERT(addr);
+	NET_ASSERT(gw);
+
+	if (prefix_len > 32) {
+		return NULL;
+	}
+
+	for (i = 0; i < CONFIG_NET_MAX_IPV4_ROUTES; i++) {
+		if (!routes[i].is_used) {
+			if (!route) {
+				route = &routes[i];
+			}
+
+			continue;
+		}
+
+		if (routes[i].iface == iface &&
+		    routes[i].prefix_len == prefix_len &&
+		    net_ipv4_addr_cmp(&routes[i].addr, addr)) {
+			net_ipaddr_copy(&routes[i].gw, gw);
+
+			NET_DBG("Updated route %s/%d via %s",
+				log_strdup(net_sprint_ipv4_addr(addr)),
+				prefix_len,
+				log_strdup(net_sprint_ipv4_addr(gw)));
+
+			return &routes[i];
+		}
+	}
+
+	if (!route) {
+		NET_DBG("No free IPv4 route entries");
+		return NULL;
+	}
+
+	if (net_route_lpm_add(&route_lpm, addr->s4_addr, prefix_len,
+			      &route->lpm_node) < 0) {
+		return NULL;
+	}
+
+	route->iface = iface;
+	route->prefix_len = prefix_len;
+	route->is_used = true;
+	net_ipaddr_copy(&route->addr, addr);
+	net_ipaddr_copy(&route->gw, gw);
+
+	NET_DBG("Added route %s/%d via %s (iface %p)",
+		log_strdup(net_sprint_ipv4_addr(addr)), prefix_len,
+		log_strdup(net_sprint_ipv4_addr(gw)), iface);
+
+	return route;
+}
+
+int net_route_ipv4_del(struct net_route_entry_ipv4 *route)
+{
+	int ret;
+
+	if (!route || !route->is_used) {
+		return -EINVAL;
+	}
+
+	ret = net_route_lpm_del(&route_lpm, route->addr.s4_addr,
+				route->prefix_len, &route->lpm_node);
+	if (ret < 0) {
+		return ret;
+	}
+
+	route->is_used = false;
+
+	NET_DBG("Deleted route %s/%d",
+		log_strdup(net_sprint_ipv4_addr(&route->addr)),
+		route->prefix_len);
+
+	return 0;
+}
+
+int net_route_ipv4_foreach(net_route_ipv4_cb_t cb, void *user_data)
+{
+	int i, ret = 0;
+
+	for (i = 0; i < CONFIG_NET_MAX_IPV4_ROUTES; i++) {
+		if (!routes[i].is_used) {
+			continue;
+		}
+
+		cb(&routes[i], user_data);
+
+		ret++;
+	}
+
+	return ret;
+}
@@ -14,6 +14,8 @@
 #define __IPV6_H
 
 #include <zephyr/types.h>
+#include <misc/slist.h>
+#include <misc/dlist.h>
 
 #include <net/net_ip.h>
 #include <net/net_pkt.h>
@@ -106,8 +108,41 @@ struct net_ipv6_nbr_data {
 
 	/** Is the neighbor a router */
 	bool is_router;
+
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	/** Node in the neighbor hash table */
+	sys_snode_t hash_node;
+
+	/** Node in the reachable timer wheel */
+	sys_dnode_t timer_node;
+
+	/** Lookup count when the neighbor was last found, used to replace
+	 * the least recently used neighbor when the cache is full.
+	 */
+	u32_t last_used;
+#endif
 };
 
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+/** Neighbor cache statistics */
+struct net_ipv6_nbr_stats {
+	/** Number of neighbor lookups */
+	u32_t lookups;
+
+	/** Lookups answered by the last neighbor found on the interface */
+	u32_t last_hits;
+
+	/** Lookups that did not find a neighbor */
+	u32_t misses;
+
+	/** Neighbors replaced because the cache was full */
+	u32_t evictions;
+
+	/** Expired reachable timers */
+	u32_t timeouts;
+};
+#endif
+
 static inline struct net_ipv6_nbr_data *net_ipv6_nbr_data(struct net_nbr *nbr)
 {
 	return (struct net_ipv6_nbr_data *)nbr->data;
@@ -281,6 +316,15 @@ bool net_ipv6_nbr_rm(struct net_if *iface, struct in6_addr *addr);
  */
 void net_ipv6_nbr_foreach(net_nbr_cb_t cb, void *user_data);
 
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+/**
+ * @brief Get the neighbor cache statistics.
+ *
+ * @param stats Statistics are copied here.
+ */
+void net_ipv6_nbr_get_stats(struct net_ipv6_nbr_stats *stats);
+#endif
+
 #else /* CONFIG_NET_IPV6_NBR_CACHE */
 static inline struct net_pkt *net_ipv6_prepare_for_send(struct net_pkt *pkt)
 {
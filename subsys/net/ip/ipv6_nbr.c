@@ -24,6 +24,7 @@
 #include <net/net_context.h>
 #include <net/net_mgmt.h>
 #include <net/tcp.h>
+#include <random/rand32.h>
 #include "net_private.h"
 #include "connection.h"
 #include "icmpv6.h"
@@ -84,6 +85,108 @@ NET_NBR_TABLE_INIT(NET_NBR_GLOBAL,
 		   net_neighbor_pool,
 		   net_neighbor_table_clear);
 
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+static struct net_ipv6_nbr_stats nbr_stats;
+
+static inline struct net_nbr *nbr_from_data(struct net_ipv6_nbr_data *data)
+{
+	return CONTAINER_OF((u8_t *)data, struct net_nbr, __nbr);
+}
+#endif
+
+#if defined(CONFIG_NET_IPV6_ND) && defined(CONFIG_NET_IPV6_NBR_HASH)
+/* The reachable timers are kept in a hashed timer wheel of
+ * NBR_TIMER_SLOTS slots of NBR_TIMER_TICK ms. A timer is put in the slot
+ * of the tick at which it expires, so when the timer work runs only the
+ * neighbors in the slots of the elapsed ticks are looked at. Timers longer
+ * than one turn of the wheel stay in their slot for several turns.
+ */
+#define NBR_TIMER_SLOTS 64
+#define NBR_TIMER_TICK 100
+
+static sys_dlist_t nbr_timer_wheel[NBR_TIMER_SLOTS];
+
+/* Next tick to be processed by the timer work */
+static s64_t nbr_timer_tick;
+
+static inline sys_dlist_t *nbr_timer_slot(s64_t tick)
+{
+	return &nbr_timer_wheel[tick % NBR_TIMER_SLOTS];
+}
+
+static void nbr_timer_schedule(void)
+{
+	s64_t tick, delay;
+
+	for (tick = nbr_timer_tick; tick < nbr_timer_tick + NBR_TIMER_SLOTS;
+	     tick++) {
+		if (sys_dlist_is_empty(nbr_timer_slot(tick))) {
+			continue;
+		}
+
+		delay = tick * NBR_TIMER_TICK - k_uptime_get();
+
+		k_delayed_work_submit(&ipv6_nd_reachable_timer,
+				      delay > 0 ? delay : 0);
+		return;
+	}
+}
+#endif
+
+static void nbr_reachable_stop(struct net_nbr *nbr)
+{
+	struct net_ipv6_nbr_data *data = net_ipv6_nbr_data(nbr);
+
+#if defined(CONFIG_NET_IPV6_ND) && defined(CONFIG_NET_IPV6_NBR_HASH)
+	/* A neighbor is in the timer wheel while its timer runs */
+	if (data->reachable) {
+		sys_dlist_remove(&data->timer_node);
+	}
+#endif
+
+	data->reachable = 0;
+	data->reachable_timeout = 0;
+}
+
+#if defined(CONFIG_NET_IPV6_ND)
+static void nbr_reachable_start(struct net_nbr *nbr, s32_t timeout)
+{
+	struct net_ipv6_nbr_data *data = net_ipv6_nbr_data(nbr);
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	s32_t remaining;
+	s64_t tick;
+
+	nbr_reachable_stop(nbr);
+
+	data->reachable = k_uptime_get();
+	data->reachable_timeout = timeout;
+
+	/* Round up so that the timer never expires early */
+	tick = (data->reachable + timeout + NBR_TIMER_TICK - 1) /
+		NBR_TIMER_TICK;
+	if (tick < nbr_timer_tick) {
+		tick = nbr_timer_tick;
+	}
+
+	sys_dlist_append(nbr_timer_slot(tick), &data->timer_node);
+
+	timeout = tick * NBR_TIMER_TICK - data->reachable;
+
+	remaining = k_delayed_work_remaining_get(&ipv6_nd_reachable_timer);
+	if (!remaining || remaining > timeout) {
+		k_delayed_work_submit(&ipv6_nd_reachable_timer, timeout);
+	}
+#else
+	data->reachable = k_uptime_get();
+	data->reachable_timeout = timeout;
+
+	if (!k_delayed_work_remaining_get(&ipv6_nd_reachable_timer)) {
+		k_delayed_work_submit(&ipv6_nd_reachable_timer, timeout);
+	}
+#endif
+}
+#endif /* CONFIG_NET_IPV6_ND */
+
 const char *net_ipv6_nbr_state2str(enum net_ipv6_nbr_state state)
 {
 	switch (state) {
@@ -247,6 +350,188 @@ void nbr_print(void)
 #define nbr_print(...)
 #endif
 
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+BUILD_ASSERT_MSG((CONFIG_NET_IPV6_NBR_HASH_SIZE &
+		  (CONFIG_NET_IPV6_NBR_HASH_SIZE - 1)) == 0,
+		 "Neighbor hash size must be a power of two");
+
+/* The neighbors are kept in a hash table of their IPv6 address, so that
+ * the neighbor of an outgoing packet is found without going through the
+ * whole neighbor pool. A neighbor is in the table from its creation until
+ * its last reference is gone, like the neighbors the pool scan finds.
+ */
+static sys_slist_t nbr_hash[CONFIG_NET_IPV6_NBR_HASH_SIZE];
+
+/* Random seed so that remote peers cannot easily choose addresses that
+ * go to the same bucket.
+ */
+static u32_t nbr_hash_seed;
+
+/* Last neighbor found on each interface. Consecutive packets are often
+ * sent to the same neighbor, which is then found with one comparison.
+ */
+static struct {
+	struct net_if *iface;
+	struct net_nbr *nbr;
+} nbr_last_hit[CONFIG_NET_IF_MAX_IPV6_COUNT];
+
+/* Incremented at each lookup, tells which neighbor was used last */
+static u32_t nbr_lru_clock;
+
+static inline u32_t hash_mix(u32_t hash, u32_t value)
+{
+	hash ^= value;
+	hash *= 0x9e3779b1;
+
+	return hash ^ (hash >> 15);
+}
+
+static sys_slist_t *nbr_hash_bucket(const struct in6_addr *addr)
+{
+	u32_t hash = nbr_hash_seed;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		hash = hash_mix(hash, UNALIGNED_GET(&addr->s6_addr32[i]));
+	}
+
+	return &nbr_hash[hash & (CONFIG_NET_IPV6_NBR_HASH_SIZE - 1)];
+}
+
+static void nbr_hash_add(struct net_nbr *nbr)
+{
+	struct net_ipv6_nbr_data *data = net_ipv6_nbr_data(nbr);
+
+	if (!nbr_hash_seed) {
+		nbr_hash_seed = sys_rand32_get() | 1;
+	}
+
+	data->last_used = nbr_lru_clock;
+
+	sys_slist_prepend(nbr_hash_bucket(&data->addr), &data->hash_node);
+}
+
+static void nbr_hash_del(struct net_nbr *nbr)
+{
+	struct net_ipv6_nbr_data *data = net_ipv6_nbr_data(nbr);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nbr_last_hit); i++) {
+		if (nbr_last_hit[i].nbr == nbr) {
+			nbr_last_hit[i].nbr = NULL;
+		}
+	}
+
+	sys_slist_find_and_remove(nbr_hash_bucket(&data->addr),
+				  &data->hash_node);
+}
+
+static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
+				  struct net_if *iface,
+				  struct in6_addr *addr)
+{
+	struct net_ipv6_nbr_data *data;
+	struct net_nbr *nbr;
+	int i, slot = -1;
+
+	ARG_UNUSED(table);
+
+	nbr_stats.lookups++;
+	nbr_lru_clock++;
+
+	if (iface) {
+		for (i = 0; i < ARRAY_SIZE(nbr_last_hit); i++) {
+			if (!nbr_last_hit[i].iface) {
+				nbr_last_hit[i].iface = iface;
+			}
+
+			if (nbr_last_hit[i].iface == iface) {
+				slot = i;
+				break;
+			}
+		}
+
+		nbr = slot < 0 ? NULL : nbr_last_hit[slot].nbr;
+		if (nbr && nbr->iface == iface &&
+		    net_ipv6_addr_cmp(&net_ipv6_nbr_data(nbr)->addr, addr)) {
+			net_ipv6_nbr_data(nbr)->last_used = nbr_lru_clock;
+			nbr_stats.last_hits++;
+
+			return nbr;
+		}
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(nbr_hash_bucket(addr), data, hash_node) {
+		nbr = nbr_from_data(data);
+
+		if (iface && nbr->iface != iface) {
+			continue;
+		}
+
+		if (!net_ipv6_addr_cmp(&data->addr, addr)) {
+			continue;
+		}
+
+		data->last_used = nbr_lru_clock;
+
+		if (slot >= 0) {
+			nbr_last_hit[slot].nbr = nbr;
+		}
+
+		return nbr;
+	}
+
+	nbr_stats.misses++;
+
+	return NULL;
+}
+
+/* Removes the least recently used neighbor that is not referenced by
+ * anything else than the neighbor cache, for example by a route.
+ */
+static bool nbr_evict(void)
+{
+	struct net_nbr *victim = NULL;
+	u32_t age, oldest = 0;
+	struct in6_addr addr;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
+		struct net_nbr *nbr = get_nbr(i);
+
+		if (nbr->ref != 1 || !nbr->iface ||
+		    net_ipv6_nbr_data(nbr)->pending ||
+		    net_ipv6_nbr_data(nbr)->state ==
+						NET_IPV6_NBR_STATE_STATIC) {
+			continue;
+		}
+
+		age = nbr_lru_clock - net_ipv6_nbr_data(nbr)->last_used;
+		if (!victim || age > oldest) {
+			victim = nbr;
+			oldest = age;
+		}
+	}
+
+	if (!victim) {
+		return false;
+	}
+
+	net_ipaddr_copy(&addr, &net_ipv6_nbr_data(victim)->addr);
+
+	NET_DBG("Replacing nbr %p IPv6 %s", victim,
+		log_strdup(net_sprint_ipv6_addr(&addr)));
+
+	nbr_stats.evictions++;
+
+	return net_ipv6_nbr_rm(victim->iface, &addr);
+}
+
+void net_ipv6_nbr_get_stats(struct net_ipv6_nbr_stats *stats)
+{
+	*stats = nbr_stats;
+}
+#else
 static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 				  struct net_if *iface,
 				  struct in6_addr *addr)
@@ -271,6 +556,7 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 
 	return NULL;
 }
+#endif /* CONFIG_NET_IPV6_NBR_HASH */
 
 static inline void nbr_clear_ns_pending(struct net_ipv6_nbr_data *data)
 {
@@ -288,8 +574,7 @@ static inline void nbr_free(struct net_nbr *nbr)
 
 	nbr_clear_ns_pending(net_ipv6_nbr_data(nbr));
 
-	net_ipv6_nbr_data(nbr)->reachable = 0;
-	net_ipv6_nbr_data(nbr)->reachable_timeout = 0;
+	nbr_reachable_stop(nbr);
 
 	net_nbr_unref(nbr);
 	net_nbr_unlink(nbr, NULL);
@@ -409,6 +694,10 @@ static void nbr_init(struct net_nbr *nbr, struct net_if *iface,
 	net_ipv6_nbr_data(nbr)->reachable = 0;
 	net_ipv6_nbr_data(nbr)->reachable_timeout = 0;
 #endif
+
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	nbr_hash_add(nbr);
+#endif
 }
 
 static struct net_nbr *nbr_new(struct net_if *iface,
@@ -417,6 +706,12 @@ static struct net_nbr *nbr_new(struct net_if *iface,
 {
 	struct net_nbr *nbr = net_nbr_get(&net_neighbor.table);
 
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	if (!nbr && nbr_evict()) {
+		nbr = net_nbr_get(&net_neighbor.table);
+	}
+#endif
+
 	if (!nbr) {
 		return NULL;
 	}
@@ -572,7 +867,10 @@ void net_neighbor_data_remove(struct net_nbr *nbr)
 {
 	NET_DBG("Neighbor %p removed", nbr);
 
-	return;
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	nbr_hash_del(nbr);
+	nbr_reachable_stop(nbr);
+#endif
 }
 
 void net_neighbor_table_clear(struct net_nbr_table *table)
@@ -962,16 +1260,7 @@ try_send:
 		if (net_ipv6_nbr_data(nbr)->state == NET_IPV6_NBR_STATE_STALE) {
 			ipv6_nbr_set_state(nbr, NET_IPV6_NBR_STATE_DELAY);
 
-			net_ipv6_nbr_data(nbr)->reachable = k_uptime_get();
-			net_ipv6_nbr_data(nbr)->reachable_timeout =
-							DELAY_FIRST_PROBE_TIME;
-
-			if (!k_delayed_work_remaining_get(
-						&ipv6_nd_reachable_timer)) {
-				k_delayed_work_submit(
-					&ipv6_nd_reachable_timer,
-					DELAY_FIRST_PROBE_TIME);
-			}
+			nbr_reachable_start(nbr, DELAY_FIRST_PROBE_TIME);
 		}
 #endif
 
@@ -1489,12 +1778,158 @@ drop:
 #endif /* CONFIG_NET_IPV6_NBR_CACHE */
 
 #if defined(CONFIG_NET_IPV6_ND)
+static void nbr_reachable_expired(struct net_nbr *nbr)
+{
+	struct net_ipv6_nbr_data *data = net_ipv6_nbr_data(nbr);
+	int ret;
+
+	if (net_rpl_get_interface() && nbr->iface ==
+	    net_rpl_get_interface()) {
+		/* The address belongs to RPL network, no need to
+		 * activate full neighbor reachable rules in this case.
+		 * Mark the neighbor always reachable.
+		 */
+		data->state = NET_IPV6_NBR_STATE_REACHABLE;
+		return;
+	}
+
+	switch (data->state) {
+	case NET_IPV6_NBR_STATE_STATIC:
+		NET_ASSERT_INFO(false, "Static entry shall never timeout");
+		break;
+
+	case NET_IPV6_NBR_STATE_INCOMPLETE:
+		if (data->ns_count >= MAX_MULTICAST_SOLICIT) {
+			nbr_free(nbr);
+		} else {
+			data->ns_count++;
+
+			NET_DBG("nbr %p incomplete count %u", nbr,
+				data->ns_count);
+
+			ret = net_ipv6_send_ns(nbr->iface, NULL, NULL,
+					       NULL, &data->addr,
+					       false);
+			if (ret < 0) {
+				NET_DBG("Cannot send NS (%d)", ret);
+			}
+		}
+		break;
+
+	case NET_IPV6_NBR_STATE_REACHABLE:
+		data->state = NET_IPV6_NBR_STATE_STALE;
+
+		NET_DBG("nbr %p moving %s state to STALE (%d)",
+			nbr,
+			log_strdup(net_sprint_ipv6_addr(&data->addr)),
+			data->state);
+		break;
+
+	case NET_IPV6_NBR_STATE_STALE:
+		NET_DBG("nbr %p removing stale address %s",
+			nbr,
+			log_strdup(net_sprint_ipv6_addr(&data->addr)));
+		nbr_free(nbr);
+		break;
+
+	case NET_IPV6_NBR_STATE_DELAY:
+		data->state = NET_IPV6_NBR_STATE_PROBE;
+		data->ns_count = 0;
+
+		NET_DBG("nbr %p moving %s state to PROBE (%d)",
+			nbr,
+			log_strdup(net_sprint_ipv6_addr(&data->addr)),
+			data->state);
+
+		/* Intentionally continuing to probe state */
+
+	case NET_IPV6_NBR_STATE_PROBE:
+		if (data->ns_count >= MAX_UNICAST_SOLICIT) {
+			struct net_if_router *router;
+
+			router = net_if_ipv6_router_lookup(nbr->iface,
+							   &data->addr);
+			if (router && !router->is_infinite) {
+				NET_DBG("nbr %p address %s PROBE ended (%d)",
+					nbr,
+					log_strdup(
+						net_sprint_ipv6_addr(
+							&data->addr)),
+					data->state);
+
+				net_if_ipv6_router_rm(router);
+				nbr_free(nbr);
+			}
+		} else {
+			data->ns_count++;
+
+			NET_DBG("nbr %p probe count %u", nbr,
+				data->ns_count);
+
+			ret = net_ipv6_send_ns(nbr->iface, NULL, NULL,
+					       NULL, &data->addr,
+					       false);
+			if (ret < 0) {
+				NET_DBG("Cannot send NS (%d)", ret);
+			}
+
+			nbr_reachable_start(nbr, RETRANS_TIMER);
+		}
+		break;
+	}
+}
+
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+static void ipv6_nd_reachable_timeout(struct k_work *work)
+{
+	s64_t current = k_uptime_get();
+	s64_t last = current / NBR_TIMER_TICK;
+	struct net_ipv6_nbr_data *data, *next;
+	sys_dlist_t expired;
+	sys_dnode_t *node;
+	s64_t tick;
+
+	ARG_UNUSED(work);
+
+	sys_dlist_init(&expired);
+
+	/* Collect the expired timers first, handling them can add and
+	 * remove other timers.
+	 */
+	for (tick = nbr_timer_tick;
+	     tick <= last && tick < nbr_timer_tick + NBR_TIMER_SLOTS; tick++) {
+		SYS_DLIST_FOR_EACH_CONTAINER_SAFE(nbr_timer_slot(tick), data,
+						  next, timer_node) {
+			if (data->reachable + data->reachable_timeout >
+			    current) {
+				continue;
+			}
+
+			sys_dlist_remove(&data->timer_node);
+			sys_dlist_append(&expired, &data->timer_node);
+		}
+	}
+
+	nbr_timer_tick = last + 1;
+
+	while ((node = sys_dlist_get(&expired))) {
+		data = CONTAINER_OF(node, struct net_ipv6_nbr_data,
+				    timer_node);
+		data->reachable = 0;
+
+		nbr_stats.timeouts++;
+
+		nbr_reachable_expired(nbr_from_data(data));
+	}
+
+	nbr_timer_schedule();
+}
+#else
 static void ipv6_nd_reachable_timeout(struct k_work *work)
 {
 	s64_t current = k_uptime_get();
 	struct net_nbr *nbr = NULL;
 	struct net_ipv6_nbr_data *data = NULL;
-	int ret;
 	int i;
 
 	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
@@ -1527,112 +1962,10 @@ static void ipv6_nd_reachable_timeout(struct k_work *work)
 
 		data->reachable = 0;
 
-		if (net_rpl_get_interface() && nbr->iface ==
-		    net_rpl_get_interface()) {
-			/* The address belongs to RPL network, no need to
-			 * activate full neighbor reachable rules in this case.
-			 * Mark the neighbor always reachable.
-			 */
-			data->state = NET_IPV6_NBR_STATE_REACHABLE;
-			continue;
-		}
-
-		switch (data->state) {
-		case NET_IPV6_NBR_STATE_STATIC:
-			NET_ASSERT_INFO(false, "Static entry shall never timeout");
-			break;
-
-		case NET_IPV6_NBR_STATE_INCOMPLETE:
-			if (data->ns_count >= MAX_MULTICAST_SOLICIT) {
-				nbr_free(nbr);
-			} else {
-				data->ns_count++;
-
-				NET_DBG("nbr %p incomplete count %u", nbr,
-					data->ns_count);
-
-				ret = net_ipv6_send_ns(nbr->iface, NULL, NULL,
-						       NULL, &data->addr,
-						       false);
-				if (ret < 0) {
-					NET_DBG("Cannot send NS (%d)", ret);
-				}
-			}
-			break;
-
-		case NET_IPV6_NBR_STATE_REACHABLE:
-			data->state = NET_IPV6_NBR_STATE_STALE;
-
-			NET_DBG("nbr %p moving %s state to STALE (%d)",
-				nbr,
-				log_strdup(net_sprint_ipv6_addr(&data->addr)),
-				data->state);
-			break;
-
-		case NET_IPV6_NBR_STATE_STALE:
-			NET_DBG("nbr %p removing stale address %s",
-				nbr,
-				log_strdup(net_sprint_ipv6_addr(&data->addr)));
-			nbr_free(nbr);
-			break;
-
-		case NET_IPV6_NBR_STATE_DELAY:
-			data->state = NET_IPV6_NBR_STATE_PROBE;
-			data->ns_count = 0;
-
-			NET_DBG("nbr %p moving %s state to PROBE (%d)",
-				nbr,
-				log_strdup(net_sprint_ipv6_addr(&data->addr)),
-				data->state);
-
-			/* Intentionally continuing to probe state */
-
-		case NET_IPV6_NBR_STATE_PROBE:
-			if (data->ns_count >= MAX_UNICAST_SOLICIT) {
-				struct net_if_router *router;
-
-				router = net_if_ipv6_router_lookup(nbr->iface,
-								   &data->addr);
-				if (router && !router->is_infinite) {
-					NET_DBG("nbr %p address %s PROBE ended (%d)",
-						nbr,
-						log_strdup(
-							net_sprint_ipv6_addr(
-								&data->addr)),
-						data->state);
-
-					net_if_ipv6_router_rm(router);
-					nbr_free(nbr);
-				}
-			} else {
-				data->ns_count++;
-
-				NET_DBG("nbr %p probe count %u", nbr,
-					data->ns_count);
-
-				ret = net_ipv6_send_ns(nbr->iface, NULL, NULL,
-						       NULL, &data->addr,
-						       false);
-				if (ret < 0) {
-					NET_DBG("Cannot send NS (%d)", ret);
-				}
-
-				net_ipv6_nbr_data(nbr)->reachable =
-								k_uptime_get();
-				net_ipv6_nbr_data(nbr)->reachable_timeout =
-								RETRANS_TIMER;
-
-				if (!k_delayed_work_remaining_get(
-						&ipv6_nd_reachable_timer)) {
-					k_delayed_work_submit(
-						&ipv6_nd_reachable_timer,
-						RETRANS_TIMER);
-				}
-			}
-			break;
-		}
+		nbr_reachable_expired(nbr);
 	}
 }
+#endif /* CONFIG_NET_IPV6_NBR_HASH */
 
 void net_ipv6_nbr_set_reachable_timer(struct net_if *iface,
 				      struct net_nbr *nbr)
@@ -1646,12 +1979,7 @@ void net_ipv6_nbr_set_reachable_timer(struct net_if *iface,
 	NET_DBG("Starting reachable timer nbr %p data %p time %d ms",
 		nbr, net_ipv6_nbr_data(nbr), time);
 
-	net_ipv6_nbr_data(nbr)->reachable = k_uptime_get();
-	net_ipv6_nbr_data(nbr)->reachable_timeout = time;
-
-	if (!k_delayed_work_remaining_get(&ipv6_nd_reachable_timer)) {
-		k_delayed_work_submit(&ipv6_nd_reachable_timer, time);
-	}
+	nbr_reachable_start(nbr, time);
 }
 #endif /* CONFIG_NET_IPV6_ND */
 
@@ -1747,8 +2075,7 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 			net_ipv6_nbr_data(nbr)->ns_count = 0;
 
 			/* We might have active timer from PROBE */
-			net_ipv6_nbr_data(nbr)->reachable = 0;
-			net_ipv6_nbr_data(nbr)->reachable_timeout = 0;
+			nbr_reachable_stop(nbr);
 
 			net_ipv6_nbr_set_reachable_timer(net_pkt_iface(pkt),
 							 nbr);
@@ -1788,8 +2115,7 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 			ipv6_nbr_set_state(nbr, NET_IPV6_NBR_STATE_REACHABLE);
 
 			/* We might have active timer from PROBE */
-			net_ipv6_nbr_data(nbr)->reachable = 0;
-			net_ipv6_nbr_data(nbr)->reachable_timeout = 0;
+			nbr_reachable_stop(nbr);
 
 			net_ipv6_nbr_set_reachable_timer(net_pkt_iface(pkt),
 							 nbr);
@@ -2744,6 +3070,18 @@ static struct net_icmpv6_handler ra_input_handler = {
 
 void net_ipv6_nbr_init(void)
 {
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nbr_hash); i++) {
+		sys_slist_init(&nbr_hash[i]);
+	}
+#endif
+#if defined(CONFIG_NET_IPV6_ND) && defined(CONFIG_NET_IPV6_NBR_HASH)
+	for (i = 0; i < ARRAY_SIZE(nbr_timer_wheel); i++) {
+		sys_dlist_init(&nbr_timer_wheel[i]);
+	}
+#endif
 #if defined(CONFIG_NET_IPV6_NBR_CACHE)
 	net_icmpv6_register_handler(&ns_input_handler);
 	net_icmpv6_register_handler(&na_input_handler);
@@ -0,0 +1,798 @@
+/** @file
+ * @brief Network packet capture
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_capture
+#define NET_LOG_LEVEL CONFIG_NET_CAPTURE_LOG_LEVEL
+
+#include <errno.h>
+#include <string.h>
+#include <atomic.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_if.h>
+#include <net/net_l2.h>
+#include <net/capture.h>
+#include <misc/byteorder.h>
+
+#if defined(CONFIG_SERIAL)
+#include <uart.h>
+#endif
+
+#if defined(CONFIG_FILE_SYSTEM)
+#include <fs.h>
+#endif
+
+#include "net_private.h"
+
+#define BUF_SIZE CONFIG_NET_CAPTURE_BUF_SIZE
+
+BUILD_ASSERT_MSG((BUF_SIZE & (BUF_SIZE - 1)) == 0,
+		 "Capture buffer size must be a power of two");
+
+/* The captured packets are kept in a ring buffer of records. The capture
+ * points reserve the space of a record by moving the head with an atomic
+ * compare and swap, so they never wait for each other or for the export.
+ * A record is marked committed once it is written, and the export reads
+ * the committed records from the tail. A record that would cross the end
+ * of the buffer is preceded by a padding record up to the end.
+ *
+ * Everything between the head and the tail is kept zeroed, so that a
+ * reserved record is seen as not committed until its flags are written.
+ */
+#define RECORD_COMMITTED BIT(0)
+#define RECORD_PAD       BIT(1)
+#define RECORD_TX        BIT(2)
+
+struct capture_record {
+	/** Length of the record, multiple of 4 */
+	u16_t len;
+
+	/** RECORD_* flags */
+	u8_t flags;
+
+	/** Network interface index */
+	u8_t iface;
+
+	/** Length of the captured data */
+	u16_t caplen;
+
+	/** Length of the packet */
+	u16_t orig_len;
+
+	/** Cycle counter when the packet was captured */
+	u32_t cycles;
+
+	/** Uptime in ms when the packet was captured, used to find out how
+	 * many times the cycle counter wrapped between two records.
+	 */
+	u32_t uptime;
+
+	/** Captured data */
+	u8_t data[0];
+};
+
+BUILD_ASSERT_MSG(sizeof(struct capture_record) +
+		 CONFIG_NET_CAPTURE_SNAPLEN <= BUF_SIZE / 2,
+		 "Capture buffer too small for the snapshot length");
+
+static u8_t capture_buf[BUF_SIZE] __aligned(4);
+static atomic_t capture_head;
+static atomic_t capture_tail;
+
+/* Set while the records are read, by an export or a clear */
+static atomic_t capture_exporting;
+
+/* Checked by the capture points, see net_private.h */
+bool net_capture_enabled;
+
+static struct net_if *capture_iface;
+static u8_t capture_dir;
+
+static struct net_capture_insn capture_filter[CONFIG_NET_CAPTURE_FILTER_LEN];
+static size_t capture_filter_len;
+
+static atomic_t stats_captured;
+static atomic_t stats_filtered;
+static atomic_t stats_dropped;
+static atomic_t stats_exported;
+
+/* pcapng blocks, see draft-tuexen-opsawg-pcapng */
+#define PCAPNG_SHB 0x0a0d0d0a
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_OPT_END 0
+#define PCAPNG_OPT_EPB_FLAGS 2
+#define PCAPNG_EPB_INBOUND 1
+#define PCAPNG_EPB_OUTBOUND 2
+
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_IEEE802_15_4_NOFCS 230
+
+/* Reads from the packet as if it was contiguous. When the packet is sent,
+ * its link layer header is in the headroom of the first fragment. The
+ * total length is given so that reading past the end fails silently.
+ */
+static bool pkt_read(struct net_pkt *pkt, u32_t pkt_len, u32_t offset,
+		     u8_t *data, u16_t len)
+{
+	u16_t reserve = net_pkt_ll_reserve(pkt);
+	struct net_buf *frag;
+	u16_t pos;
+
+	if (offset >= pkt_len || pkt_len - offset < len) {
+		return false;
+	}
+
+	while (len && offset < reserve) {
+		*data++ = net_pkt_ll(pkt)[offset++];
+		len--;
+	}
+
+	if (!len) {
+		return true;
+	}
+
+	frag = net_frag_read(pkt->frags, offset - reserve, &pos, len, data);
+
+	return frag || pos != 0xffff;
+}
+
+static bool filter_load(struct net_pkt *pkt, u32_t pkt_len, u32_t offset,
+			u16_t size, u32_t *value)
+{
+	u8_t buf[4];
+
+	switch (size) {
+	case BPF_W:
+		if (!pkt_read(pkt, pkt_len, offset, buf, 4)) {
+			return false;
+		}
+
+		*value = sys_get_be32(buf);
+		return true;
+
+	case BPF_H:
+		if (!pkt_read(pkt, pkt_len, offset, buf, 2)) {
+			return false;
+		}
+
+		*value = sys_get_be16(buf);
+		return true;
+
+	case BPF_B:
+		if (!pkt_read(pkt, pkt_len, offset, buf, 1)) {
+			return false;
+		}
+
+		*value = buf[0];
+		return true;
+	}
+
+	return false;
+}
+
+/* Runs the filter, which has been checked by filter_check() */
+static u32_t filter_run(struct net_pkt *pkt, u32_t len)
+{
+	const struct net_capture_insn *insn = capture_filter;
+	u32_t a = 0, x = 0, src;
+	bool cond;
+
+	for (;; insn++) {
+		src = BPF_SRC(insn->code) == BPF_X ? x : insn->k;
+
+		switch (BPF_CLASS(insn->code)) {
+		case BPF_LD:
+			switch (BPF_MODE(insn->code)) {
+			case BPF_IMM:
+				a = insn->k;
+				break;
+			case BPF_LEN:
+				a = len;
+				break;
+			case BPF_ABS:
+				if (!filter_load(pkt, len, insn->k,
+						 BPF_SIZE(insn->code), &a)) {
+					return 0;
+				}
+				break;
+			case BPF_IND:
+				if (!filter_load(pkt, len, x + insn->k,
+						 BPF_SIZE(insn->code), &a)) {
+					return 0;
+				}
+				break;
+			}
+			break;
+
+		case BPF_LDX:
+			switch (BPF_MODE(insn->code)) {
+			case BPF_IMM:
+				x = insn->k;
+				break;
+			case BPF_LEN:
+				x = len;
+				break;
+			case BPF_MSH:
+				if (!filter_load(pkt, len, insn->k, BPF_B,
+						 &x)) {
+					return 0;
+				}
+
+				x = (x & 0xf) << 2;
+				break;
+			}
+			break;
+
+		case BPF_ALU:
+			switch (BPF_OP(insn->code)) {
+			case BPF_ADD:
+				a += src;
+				break;
+			case BPF_SUB:
+				a -= src;
+				break;
+			case BPF_MUL:
+				a *= src;
+				break;
+			case BPF_DIV:
+				if (!src) {
+					return 0;
+				}
+
+				a /= src;
+				break;
+			case BPF_MOD:
+				if (!src) {
+					return 0;
+				}
+
+				a %= src;
+				break;
+			case BPF_OR:
+				a |= src;
+				break;
+			case BPF_AND:
+				a &= src;
+				break;
+			case BPF_XOR:
+				a ^= src;
+				break;
+			case BPF_LSH:
+				a = src < 32 ? a << src : 0;
+				break;
+			case BPF_RSH:
+				a = src < 32 ? a >> src : 0;
+				break;
+			case BPF_NEG:
+				a = -a;
+				break;
+			}
+			break;
+
+		case BPF_JMP:
+			switch (BPF_OP(insn->code)) {
+			case BPF_JA:
+				insn += insn->k;
+				continue;
+			case BPF_JEQ:
+				cond = a == src;
+				break;
+			case BPF_JGT:
+				cond = a > src;
+				break;
+			case BPF_JGE:
+				cond = a >= src;
+				break;
+			default:
+				cond = a & src;
+				break;
+			}
+
+			insn += cond ? insn->jt : insn->jf;
+			break;
+
+		case BPF_RET:
+			return BPF_RVAL(insn->code) == BPF_A ? a : insn->k;
+
+		case BPF_MISC:
+			if (BPF_MISCOP(insn->code) == BPF_TAX) {
+				x = a;
+			} else {
+				a = x;
+			}
+			break;
+		}
+	}
+}
+
+static bool filter_check_insn(const struct net_capture_insn *insn,
+			      size_t remaining)
+{
+	u16_t code = insn->code;
+
+	if (code & ~0xff) {
+		return false;
+	}
+
+	switch (BPF_CLASS(code)) {
+	case BPF_LD:
+		switch (BPF_MODE(code)) {
+		case BPF_IMM:
+		case BPF_LEN:
+			return BPF_SIZE(code) == BPF_W;
+		case BPF_ABS:
+		case BPF_IND:
+			return BPF_SIZE(code) != 0x18;
+		}
+
+		return false;
+
+	case BPF_LDX:
+		switch (BPF_MODE(code)) {
+		case BPF_IMM:
+		case BPF_LEN:
+			return BPF_SIZE(code) == BPF_W;
+		case BPF_MSH:
+			return BPF_SIZE(code) == BPF_B;
+		}
+
+		return false;
+
+	case BPF_ALU:
+		if (BPF_OP(code) > BPF_XOR) {
+			return false;
+		}
+
+		if ((BPF_OP(code) == BPF_DIV || BPF_OP(code) == BPF_MOD) &&
+		    BPF_SRC(code) == BPF_K && !insn->k) {
+			return false;
+		}
+
+		return BPF_OP(code) != BPF_NEG || BPF_SRC(code) == BPF_K;
+
+	case BPF_JMP:
+		if (BPF_OP(code) == BPF_JA) {
+			return BPF_SRC(code) == BPF_K && insn->k < remaining;
+		}
+
+		return BPF_OP(code) <= BPF_JSET && insn->jt < remaining &&
+		       insn->jf < remaining;
+
+	case BPF_RET:
+		return BPF_RVAL(code) == BPF_K || BPF_RVAL(code) == BPF_A;
+
+	case BPF_MISC:
+		return BPF_MISCOP(code) == BPF_TAX ||
+		       BPF_MISCOP(code) == BPF_TXA;
+	}
+
+	return false;
+}
+
+/* Checks that the filter only has supported instructions, and that it
+ * always ends with a return: the jumps only go forward, so this is the
+ * case when they stay in the program and the last instruction returns.
+ */
+static bool filter_check(const struct net_capture_insn *prog, size_t count)
+{
+	size_t i;
+
+	if (!count || BPF_CLASS(prog[count - 1].code) != BPF_RET) {
+		return false;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!filter_check_insn(&prog[i], count - i - 1)) {
+			NET_DBG("Invalid instruction %u: 0x%04x", (unsigned int)i,
+				prog[i].code);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static inline struct capture_record *record_at(u32_t pos)
+{
+	return (struct capture_record *)&capture_buf[pos & (BUF_SIZE - 1)];
+}
+
+void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt, u8_t dir)
+{
+	struct capture_record *rec;
+	u32_t head, tail, len, size, pad;
+	u16_t caplen;
+
+	if (!(capture_dir & dir) || (capture_iface && capture_iface != iface) ||
+	    !pkt->frags) {
+		return;
+	}
+
+	len = net_pkt_ll_reserve(pkt) + net_pkt_get_len(pkt);
+
+	if (capture_filter_len && !filter_run(pkt, len)) {
+		atomic_inc(&stats_filtered);
+		return;
+	}
+
+	caplen = min(len, CONFIG_NET_CAPTURE_SNAPLEN);
+	size = ROUND_UP(sizeof(*rec) + caplen, 4);
+
+	do {
+		head = atomic_get(&capture_head);
+		tail = atomic_get(&capture_tail);
+
+		pad = BUF_SIZE - (head & (BUF_SIZE - 1));
+		if (pad >= size) {
+			pad = 0;
+		}
+
+		if (head + pad + size - tail > BUF_SIZE) {
+			atomic_inc(&stats_dropped);
+			return;
+		}
+	} while (!atomic_cas(&capture_head, head, head + pad + size));
+
+	if (pad) {
+		rec = record_at(head);
+		rec->len = pad;
+
+		compiler_barrier();
+		rec->flags = RECORD_COMMITTED | RECORD_PAD;
+	}
+
+	rec = record_at(head + pad);
+	rec->len = size;
+	rec->iface = net_if_get_by_iface(iface);
+	rec->caplen = caplen;
+	rec->orig_len = len;
+	rec->cycles = k_cycle_get_32();
+	rec->uptime = k_uptime_get_32();
+
+	pkt_read(pkt, len, 0, rec->data, caplen);
+
+	compiler_barrier();
+	rec->flags = RECORD_COMMITTED | (dir == NET_CAPTURE_TX ? RECORD_TX : 0);
+
+	atomic_inc(&stats_captured);
+}
+
+/* The record is zeroed before its space is given back to the producers */
+static void record_free(struct capture_record *rec)
+{
+	u16_t len = rec->len;
+
+	(void)memset(rec, 0, len);
+
+	compiler_barrier();
+	atomic_add(&capture_tail, len);
+}
+
+/* Returns the oldest committed record, skipping the padding */
+static struct capture_record *record_get(void)
+{
+	struct capture_record *rec;
+	u32_t tail;
+
+	while (1) {
+		tail = atomic_get(&capture_tail);
+		if (tail == atomic_get(&capture_head)) {
+			return NULL;
+		}
+
+		rec = record_at(tail);
+
+		compiler_barrier();
+
+		if (!(rec->flags & RECORD_COMMITTED)) {
+			return NULL;
+		}
+
+		if (!(rec->flags & RECORD_PAD)) {
+			return rec;
+		}
+
+		record_free(rec);
+	}
+}
+
+int net_capture_start(struct net_if *iface, u8_t dir)
+{
+	if (!(dir & (NET_CAPTURE_RX | NET_CAPTURE_TX))) {
+		return -EINVAL;
+	}
+
+	capture_iface = iface;
+	capture_dir = dir;
+
+	compiler_barrier();
+	net_capture_enabled = true;
+
+	NET_DBG("Capturing iface %p dir 0x%x", iface, dir);
+
+	return 0;
+}
+
+void net_capture_stop(void)
+{
+	net_capture_enabled = false;
+
+	NET_DBG("Capture stopped");
+}
+
+bool net_capture_is_active(void)
+{
+	return net_capture_enabled;
+}
+
+int net_capture_set_filter(const struct net_capture_insn *prog,
+			   size_t count)
+{
+	if (net_capture_enabled) {
+		return -EBUSY;
+	}
+
+	if (!prog) {
+		capture_filter_len = 0;
+		return 0;
+	}
+
+	if (count > ARRAY_SIZE(capture_filter)) {
+		return -ENOMEM;
+	}
+
+	if (!filter_check(prog, count)) {
+		return -EINVAL;
+	}
+
+	memcpy(capture_filter, prog, count * sizeof(*prog));
+	capture_filter_len = count;
+
+	return 0;
+}
+
+void net_capture_clear(void)
+{
+	struct capture_record *rec;
+
+	/* The records are read by a single consumer at a time */
+	if (!atomic_cas(&capture_exporting, 0, 1)) {
+		return;
+	}
+
+	while ((rec = record_get())) {
+		record_free(rec);
+	}
+
+	atomic_clear(&capture_exporting);
+}
+
+void net_capture_get_stats(struct net_capture_stats *stats)
+{
+	stats->captured = atomic_get(&stats_captured);
+	stats->filtered = atomic_get(&stats_filtered);
+	stats->dropped = atomic_get(&stats_dropped);
+	stats->exported = atomic_get(&stats_exported);
+}
+
+struct export_ctx {
+	net_capture_write_cb_t cb;
+	void *user_data;
+	int ret;
+
+	/* Timestamp of the previous record, in cycles */
+	u64_t time;
+	u32_t cycles;
+	u32_t uptime;
+	bool started;
+};
+
+static void export_write(struct export_ctx *ctx, const void *data,
+			 size_t len)
+{
+	if (!ctx->ret) {
+		ctx->ret = ctx->cb(data, len, ctx->user_data);
+	}
+}
+
+static u16_t link_type(struct net_if *iface)
+{
+#if defined(CONFIG_NET_L2_ETHERNET)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(ETHERNET)) {
+		return LINKTYPE_ETHERNET;
+	}
+#endif
+
+#if defined(CONFIG_NET_L2_IEEE802154)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(IEEE802154)) {
+		return LINKTYPE_IEEE802_15_4_NOFCS;
+	}
+#endif
+
+	/* Other links do not have a header in the packet, or one that
+	 * pcapng does not know about.
+	 */
+	return LINKTYPE_RAW;
+}
+
+static void export_shb(struct export_ctx *ctx)
+{
+	u32_t shb[7] = {
+		PCAPNG_SHB, sizeof(shb), PCAPNG_BYTE_ORDER_MAGIC,
+		/* Version 1.0 */
+		1,
+		/* Unknown section length */
+		0xffffffff, 0xffffffff,
+		sizeof(shb),
+	};
+
+	export_write(ctx, shb, sizeof(shb));
+}
+
+static void export_idb(struct net_if *iface, void *user_data)
+{
+	u32_t idb[5] = {
+		PCAPNG_IDB, sizeof(idb), link_type(iface),
+		CONFIG_NET_CAPTURE_SNAPLEN, sizeof(idb),
+	};
+
+	export_write(user_data, idb, sizeof(idb));
+}
+
+/* Extends the 32 bit cycle counter of the records, using their uptime to
+ * count the wraps of the counter.
+ */
+static u64_t record_time(struct export_ctx *ctx, struct capture_record *rec)
+{
+	u32_t cycles_per_ms = sys_clock_hw_cycles_per_sec() / MSEC_PER_SEC;
+	s64_t expected, delta;
+
+	if (!ctx->started) {
+		ctx->time = (u64_t)rec->uptime * cycles_per_ms;
+		ctx->started = true;
+	} else {
+		expected = (s64_t)(u32_t)(rec->uptime - ctx->uptime) *
+			cycles_per_ms;
+		delta = (s32_t)(rec->cycles - ctx->cycles);
+
+		/* Number of wraps that brings the cycles closest to the
+		 * elapsed uptime.
+		 */
+		delta += ((expected - delta + ((s64_t)1 << 31)) >> 32) << 32;
+
+		ctx->time += delta;
+	}
+
+	ctx->cycles = rec->cycles;
+	ctx->uptime = rec->uptime;
+
+	return ctx->time;
+}
+
+static void export_epb(struct export_ctx *ctx, struct capture_record *rec)
+{
+	static const u8_t padding[3];
+	u32_t hz = sys_clock_hw_cycles_per_sec();
+	u32_t pad = ROUND_UP(rec->caplen, 4) - rec->caplen;
+	u32_t len = 44 + rec->caplen + pad;
+	u64_t cycles, time;
+	u32_t hdr[7];
+	u32_t opt[4];
+
+	cycles = record_time(ctx, rec);
+
+	/* Microseconds, the default time resolution */
+	time = cycles / hz * USEC_PER_SEC + cycles % hz * USEC_PER_SEC / hz;
+
+	hdr[0] = PCAPNG_EPB;
+	hdr[1] = len;
+	hdr[2] = rec->iface;
+	hdr[3] = time >> 32;
+	hdr[4] = time;
+	hdr[5] = rec->caplen;
+	hdr[6] = rec->orig_len;
+
+	opt[0] = PCAPNG_OPT_EPB_FLAGS | sizeof(u32_t) << 16;
+	opt[1] = rec->flags & RECORD_TX ? PCAPNG_EPB_OUTBOUND :
+		PCAPNG_EPB_INBOUND;
+	opt[2] = PCAPNG_OPT_END;
+	opt[3] = len;
+
+	export_write(ctx, hdr, sizeof(hdr));
+	export_write(ctx, rec->data, rec->caplen);
+	export_write(ctx, padding, pad);
+	export_write(ctx, opt, sizeof(opt));
+}
+
+int net_capture_export(net_capture_write_cb_t cb, void *user_data)
+{
+	struct capture_record *rec;
+	struct export_ctx ctx = {
+		.cb = cb,
+		.user_data = user_data,
+	};
+	int count = 0;
+
+	if (!atomic_cas(&capture_exporting, 0, 1)) {
+		return -EBUSY;
+	}
+
+	export_shb(&ctx);
+	net_if_foreach(export_idb, &ctx);
+
+	while (!ctx.ret && (rec = record_get())) {
+		export_epb(&ctx, rec);
+		record_free(rec);
+		count++;
+	}
+
+	atomic_add(&stats_exported, count);
+	atomic_clear(&capture_exporting);
+
+	NET_DBG("Exported %d packets (%d)", count, ctx.ret);
+
+	return ctx.ret < 0 ? ctx.ret : count;
+}
+
+#if defined(CONFIG_SERIAL)
+static int uart_write(const void *data, size_t len, void *user_data)
+{
+	const u8_t *ptr = data;
+
+	while (len--) {
+		uart_poll_out(user_data, *ptr++);
+	}
+
+	return 0;
+}
+
+int net_capture_export_uart(struct device *dev)
+{
+	return net_capture_export(uart_write, dev);
+}
+#endif /* CONFIG_SERIAL */
+
+#if defined(CONFIG_FILE_SYSTEM)
+static int file_write(const void *data, size_t len, void *user_data)
+{
+	ssize_t ret;
+
+	ret = fs_write(user_data, data, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return ret == len ? 0 : -ENOSPC;
+}
+
+int net_capture_export_file(const char *path)
+{
+	struct fs_file_t file;
+	int ret, count;
+
+	/* Opening does not truncate an existing file */
+	(void)fs_unlink(path);
+
+	ret = fs_open(&file, path);
+	if (ret < 0) {
+		return ret;
+	}
+
+	count = net_capture_export(file_write, &file);
+
+	ret = fs_close(&file);
+
+	return count < 0 ? count : (ret < 0 ? ret : count);
+}
+#endif /* CONFIG_FILE_SYSTEM */
@@ -37,6 +37,7 @@
 #include "ipv6.h"
 
 #include "icmpv4.h"
+#include "ipv4.h"
 
 #if defined(CONFIG_NET_DHCPV4)
 #include "dhcpv4.h"
@@ -50,8 +51,53 @@
 #include "tcp_internal.h"
 #include "ipv4_autoconf_internal.h"
 
+#if defined(CONFIG_NET_GRO)
+#include "gro.h"
+#endif
+
 #include "net_stats.h"
 
+static inline enum net_verdict process_ip(struct net_pkt *pkt,
+					  bool is_loopback)
+{
+	/* IP version and header length. */
+	switch (NET_IPV6_HDR(pkt)->vtc & 0xf0) {
+#if defined(CONFIG_NET_IPV6)
+	case 0x60:
+		net_stats_update_ipv6_recv(net_pkt_iface(pkt));
+		net_pkt_set_family(pkt, PF_INET6);
+		return net_ipv6_process_pkt(pkt, is_loopback);
+#endif
+#if defined(CONFIG_NET_IPV4)
+	case 0x40:
+		net_stats_update_ipv4_recv(net_pkt_iface(pkt));
+		net_pkt_set_family(pkt, PF_INET);
+		return net_ipv4_process_pkt(pkt);
+#endif
+	}
+
+	NET_DBG("Unknown IP family packet (0x%x)",
+		NET_IPV6_HDR(pkt)->vtc & 0xf0);
+	net_stats_update_ip_errors_protoerr(net_pkt_iface(pkt));
+	net_stats_update_ip_errors_vhlerr(net_pkt_iface(pkt));
+
+	return NET_DROP;
+}
+
+static void processed(struct net_pkt *pkt, enum net_verdict verdict)
+{
+	switch (verdict) {
+	case NET_OK:
+		NET_DBG("Consumed pkt %p", pkt);
+		break;
+	case NET_DROP:
+	default:
+		NET_DBG("Dropping pkt %p", pkt);
+		net_pkt_unref(pkt);
+		break;
+	}
+}
+
 static inline enum net_verdict process_data(struct net_pkt *pkt,
 					    bool is_loopback)
 {
@@ -67,6 +113,12 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 		locally_routed = true;
 	}
 #endif
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	/* Same applies to a reassembled IPv4 datagram. */
+	if (net_pkt_ipv4_reassembled(pkt)) {
+		locally_routed = true;
+	}
+#endif
 
 	/* If there is no data, then drop the packet. */
 	if (!pkt->frags) {
@@ -77,6 +129,8 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 	}
 
 	if (!is_loopback && !locally_routed) {
+		net_capture_rx(net_pkt_iface(pkt), pkt);
+
 		ret = net_if_recv_data(net_pkt_iface(pkt), pkt);
 		if (ret != NET_CONTINUE) {
 			if (ret == NET_DROP) {
@@ -89,42 +143,29 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 		}
 	}
 
-	/* IP version and header length. */
-	switch (NET_IPV6_HDR(pkt)->vtc & 0xf0) {
-#if defined(CONFIG_NET_IPV6)
-	case 0x60:
-		net_stats_update_ipv6_recv(net_pkt_iface(pkt));
-		net_pkt_set_family(pkt, PF_INET6);
-		return net_ipv6_process_pkt(pkt, is_loopback);
-#endif
-#if defined(CONFIG_NET_IPV4)
-	case 0x40:
-		net_stats_update_ipv4_recv(net_pkt_iface(pkt));
-		net_pkt_set_family(pkt, PF_INET);
-		return net_ipv4_process_pkt(pkt);
-#endif
-	}
+#if defined(CONFIG_NET_GRO)
+	if (!is_loopback && !locally_routed) {
+		struct net_pkt *flushed;
+		enum net_verdict verdict;
 
-	NET_DBG("Unknown IP family packet (0x%x)",
-		NET_IPV6_HDR(pkt)->vtc & 0xf0);
-	net_stats_update_ip_errors_protoerr(net_pkt_iface(pkt));
-	net_stats_update_ip_errors_vhlerr(net_pkt_iface(pkt));
+		verdict = net_gro_receive(pkt, &flushed);
+		if (flushed) {
+			/* Earlier segments must be processed first */
+			processed(flushed, process_ip(flushed, false));
+		}
 
-	return NET_DROP;
+		if (verdict == NET_OK) {
+			return NET_OK;
+		}
+	}
+#endif
+
+	return process_ip(pkt, is_loopback);
 }
 
 static void processing_data(struct net_pkt *pkt, bool is_loopback)
 {
-	switch (process_data(pkt, is_loopback)) {
-	case NET_OK:
-		NET_DBG("Consumed pkt %p", pkt);
-		break;
-	case NET_DROP:
-	default:
-		NET_DBG("Dropping pkt %p", pkt);
-		net_pkt_unref(pkt);
-		break;
-	}
+	processed(pkt, process_data(pkt, is_loopback));
 }
 
 /* Things to setup after we are able to RX and TX */
@@ -284,6 +325,31 @@ int net_send_data(struct net_pkt *pkt)
 		return 0;
 	}
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	if (net_pkt_family(pkt) == AF_INET) {
+		u16_t mtu = net_if_get_mtu(net_pkt_iface(pkt));
+
+		if (mtu && net_pkt_get_len(pkt) > mtu) {
+			status = net_ipv4_send_fragmented_pkt(net_pkt_iface(pkt),
+							      pkt, mtu);
+			if (status < 0) {
+				return status;
+			}
+
+			/* The fragments were sent from a copy of the
+			 * datagram, so the original is released here.
+			 */
+			if (IS_ENABLED(CONFIG_NET_TCP)) {
+				net_pkt_set_sent(pkt, true);
+			}
+
+			net_pkt_unref(pkt);
+
+			return 0;
+		}
+	}
+#endif
+
 	if (net_if_send_data(net_pkt_iface(pkt), pkt) == NET_DROP) {
 		return -EIO;
 	}
@@ -306,26 +372,44 @@ static void net_rx(struct net_if *iface, struct net_pkt *pkt)
 	net_stats_update_bytes_recv(iface, pkt_len);
 
 	processing_data(pkt, false);
+}
 
-	net_print_statistics();
-	net_pkt_print();
+void net_process_rx_packet(struct net_pkt *pkt)
+{
+	net_rx(net_pkt_iface(pkt), pkt);
 }
 
-static void process_rx_packet(struct k_work *work)
+void net_process_rx_batch_done(u8_t tc)
 {
+#if defined(CONFIG_NET_GRO)
 	struct net_pkt *pkt;
 
-	pkt = CONTAINER_OF(work, struct net_pkt, work);
+	pkt = net_gro_flush(tc);
+	if (pkt) {
+		processed(pkt, process_ip(pkt, false));
+	}
+#else
+	ARG_UNUSED(tc);
+#endif
 
-	net_rx(net_pkt_iface(pkt), pkt);
+	net_print_statistics();
+	net_pkt_print();
 }
 
-static void net_queue_rx(struct net_if *iface, struct net_pkt *pkt)
+/* Prepare a received packet for queueing and return its traffic class */
+static u8_t net_rx_prepare(struct net_if *iface, struct net_pkt *pkt)
 {
 	u8_t prio = net_pkt_priority(pkt);
 	u8_t tc = net_rx_priority2tc(prio);
 
-	k_work_init(net_pkt_work(pkt), process_rx_packet);
+	NET_DBG("prio %d iface %p pkt %p len %zu", prio, iface, pkt,
+		net_pkt_get_len(pkt));
+
+	if (IS_ENABLED(CONFIG_NET_ROUTING)) {
+		net_pkt_set_orig_iface(pkt, iface);
+	}
+
+	net_pkt_set_iface(pkt, iface);
 
 #if defined(CONFIG_NET_STATISTICS)
 	pkt->total_pkt_len = net_pkt_get_len(pkt);
@@ -339,7 +423,7 @@ static void net_queue_rx(struct net_if *iface, struct net_pkt *pkt)
 	NET_DBG("TC %d with prio %d pkt %p", tc, prio, pkt);
 #endif
 
-	net_tc_submit_to_rx_queue(tc, pkt);
+	return tc;
 }
 
 /* Called by driver when an IP packet has been received */
@@ -357,16 +441,49 @@ int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
 		return -ENETDOWN;
 	}
 
-	NET_DBG("prio %d iface %p pkt %p len %zu", net_pkt_priority(pkt),
-		iface, pkt, net_pkt_get_len(pkt));
+	net_tc_submit_to_rx_queue(net_rx_prepare(iface, pkt), pkt);
 
-	if (IS_ENABLED(CONFIG_NET_ROUTING)) {
-		net_pkt_set_orig_iface(pkt, iface);
+	return 0;
+}
+
+int net_recv_data_batch(struct net_if *iface, struct net_pkt **pkts,
+			int count)
+{
+	sys_slist_t lists[NET_TC_RX_COUNT];
+	int i;
+
+	if (!pkts || !iface || count <= 0) {
+		return -EINVAL;
 	}
 
-	net_pkt_set_iface(pkt, iface);
+	for (i = 0; i < count; i++) {
+		if (!pkts[i] || !pkts[i]->frags) {
+			return -ENODATA;
+		}
+	}
+
+	if (!atomic_test_bit(iface->if_dev->flags, NET_IF_UP)) {
+		return -ENETDOWN;
+	}
 
-	net_queue_rx(iface, pkt);
+	for (i = 0; i < NET_TC_RX_COUNT; i++) {
+		sys_slist_init(&lists[i]);
+	}
+
+	/* The packets are linked together using the space reserved for
+	 * the FIFO so that each traffic class queue is locked only once.
+	 */
+	for (i = 0; i < count; i++) {
+		u8_t tc = net_rx_prepare(iface, pkts[i]);
+
+		sys_slist_append(&lists[tc], (sys_snode_t *)pkts[i]);
+	}
+
+	for (i = 0; i < NET_TC_RX_COUNT; i++) {
+		if (!sys_slist_is_empty(&lists[i])) {
+			net_tc_submit_list_to_rx_queue(i, &lists[i]);
+		}
+	}
 
 	return 0;
 }
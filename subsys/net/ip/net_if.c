@@ -21,6 +21,7 @@
 #include "net_private.h"
 #include "ipv6.h"
 #include "rpl.h"
+#include "route.h"
 #include "ipv4_autoconf_internal.h"
 
 #include "net_stats.h"
@@ -146,7 +147,37 @@ static inline void net_context_send_cb(struct net_context *context,
 	}
 }
 
-static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
+/* The packet might be freed by the driver already, so the information
+ * needed after sending is passed separately.
+ */
+static void net_if_tx_done(struct net_if *iface, struct net_pkt *pkt,
+			   struct net_linkaddr *dst,
+			   struct net_context *context,
+			   void *context_token, int status)
+{
+	if (status < 0) {
+		if (IS_ENABLED(CONFIG_NET_TCP)) {
+			net_pkt_set_sent(pkt, false);
+		}
+
+		net_pkt_unref(pkt);
+	} else {
+		net_stats_update_bytes_sent(iface, pkt->total_pkt_len);
+	}
+
+	if (context) {
+		NET_DBG("Calling context send cb %p token %p status %d",
+			context, context_token, status);
+
+		net_context_send_cb(context, context_token, status);
+	}
+
+	if (dst->addr) {
+		net_if_call_link_cb(iface, dst, status);
+	}
+}
+
+bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 {
 	const struct net_if_api *api = net_if_get_device(iface)->driver_api;
 	struct net_linkaddr *dst;
@@ -170,6 +201,8 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 			net_pkt_set_queued(pkt, false);
 		}
 
+		net_capture_tx(iface, pkt);
+
 		status = api->send(iface, pkt);
 	} else {
 		/* Drop packet if interface is not up */
@@ -177,30 +210,22 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 		status = -ENETDOWN;
 	}
 
-	if (status < 0) {
-		if (IS_ENABLED(CONFIG_NET_TCP)) {
-			net_pkt_set_sent(pkt, false);
-		}
-
-		net_pkt_unref(pkt);
-	} else {
-		net_stats_update_bytes_sent(iface, pkt->total_pkt_len);
-	}
+	net_if_tx_done(iface, pkt, dst, context, context_token, status);
 
-	if (context) {
-		NET_DBG("Calling context send cb %p token %p status %d",
-			context, context_token, status);
-
-		net_context_send_cb(context, context_token, status);
-	}
+	return true;
+}
 
-	if (dst->addr) {
-		net_if_call_link_cb(iface, dst, status);
+void net_if_tx_drop(struct net_if *iface, struct net_pkt *pkt, int status)
+{
+	if (IS_ENABLED(CONFIG_NET_TCP)) {
+		net_pkt_set_queued(pkt, false);
 	}
 
-	return true;
+	net_if_tx_done(iface, pkt, net_pkt_lladdr_dst(pkt),
+		       net_pkt_context(pkt), net_pkt_token(pkt), status);
 }
 
+#if !defined(CONFIG_NET_TX_SCHED)
 static void process_tx_packet(struct k_work *work)
 {
 	struct net_pkt *pkt;
@@ -209,14 +234,13 @@ static void process_tx_packet(struct k_work *work)
 
 	net_if_tx(net_pkt_iface(pkt), pkt);
 }
+#endif
 
 void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt)
 {
 	u8_t prio = net_pkt_priority(pkt);
 	u8_t tc = net_tx_priority2tc(prio);
 
-	k_work_init(net_pkt_work(pkt), process_tx_packet);
-
 #if defined(CONFIG_NET_STATISTICS)
 	pkt->total_pkt_len = net_pkt_get_len(pkt);
 
@@ -229,7 +253,13 @@ void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt)
 	NET_DBG("TC %d with prio %d pkt %p", tc, prio, pkt);
 #endif
 
+#if defined(CONFIG_NET_TX_SCHED)
+	net_if_tx_sched_queue(iface, pkt, tc);
+#else
+	k_work_init(net_pkt_work(pkt), process_tx_packet);
+
 	net_tc_submit_to_tx_queue(tc, pkt);
+#endif
 }
 
 static inline void init_iface(struct net_if *iface)
@@ -2197,6 +2227,9 @@ bool net_if_ipv4_is_addr_bcast(struct net_if *iface,
 
 struct net_if *net_if_ipv4_select_src_iface(struct in_addr *dst)
 {
+#if defined(CONFIG_NET_ROUTE_IPV4)
+	struct net_route_entry_ipv4 *route;
+#endif
 	struct net_if *iface;
 
 	for (iface = __net_if_start; iface != __net_if_end; iface++) {
@@ -2208,6 +2241,13 @@ struct net_if *net_if_ipv4_select_src_iface(struct in_addr *dst)
 		}
 	}
 
+#if defined(CONFIG_NET_ROUTE_IPV4)
+	route = net_route_ipv4_lookup(NULL, dst);
+	if (route) {
+		return route->iface;
+	}
+#endif
+
 	return net_if_get_default();
 }
 
@@ -2681,27 +2721,14 @@ void net_if_call_link_cb(struct net_if *iface, struct net_linkaddr *lladdr,
 	}
 }
 
-static bool need_calc_checksum(struct net_if *iface, enum ethernet_hw_caps caps)
-{
-#if defined(CONFIG_NET_L2_ETHERNET)
-	if (net_if_l2(iface) != &NET_L2_GET_NAME(ETHERNET)) {
-		return true;
-	}
-
-	return !(net_eth_get_hw_capabilities(iface) & caps);
-#else
-	return true;
-#endif
-}
-
 bool net_if_need_calc_tx_checksum(struct net_if *iface)
 {
-	return need_calc_checksum(iface, ETHERNET_HW_TX_CHKSUM_OFFLOAD);
+	return !atomic_test_bit(iface->if_dev->flags, NET_IF_TX_CHKSUM_OFFLOAD);
 }
 
 bool net_if_need_calc_rx_checksum(struct net_if *iface)
 {
-	return need_calc_checksum(iface, ETHERNET_HW_RX_CHKSUM_OFFLOAD);
+	return !atomic_test_bit(iface->if_dev->flags, NET_IF_RX_CHKSUM_OFFLOAD);
 }
 
 struct net_if *net_if_get_by_index(u8_t index)
@@ -2953,6 +2980,10 @@ void net_if_init(void)
 	for (iface = __net_if_start, if_count = 0; iface != __net_if_end;
 	     iface++, if_count++) {
 		init_iface(iface);
+
+#if defined(CONFIG_NET_TX_SCHED)
+		net_if_tx_sched_init(iface);
+#endif
 	}
 
 	if (iface == __net_if_start) {
@@ -586,7 +586,7 @@ static struct net_pkt *net_pkt_get(struct k_mem_slab *slab,
 
 		if (IS_ENABLED(CONFIG_NET_TCP) && proto == IPPROTO_TCP) {
 			data_len -= NET_TCPH_LEN;
-			data_len -= NET_TCP_MAX_OPT_SIZE;
+			data_len -= NET_TCP_DATA_OPT_SIZE;
 		}
 
 		if (IS_ENABLED(CONFIG_NET_UDP) && proto == IPPROTO_UDP) {
@@ -1183,6 +1183,23 @@ static inline struct net_buf *net_pkt_append_allocator(s32_t timeout,
 	return net_pkt_get_frag((struct net_pkt *)user_data, timeout);
 }
 
+/* Make sure we don't send more data in one packet than protocol or MTU
+ * allows when there is a context for the packet.
+ */
+static u16_t net_pkt_append_max_len(struct net_pkt *pkt,
+				    struct net_context *ctx)
+{
+	u16_t max_len = pkt->data_len;
+
+#if defined(CONFIG_NET_TCP)
+	if (ctx->tcp && (ctx->tcp->send_mss < max_len)) {
+		max_len = ctx->tcp->send_mss;
+	}
+#endif
+
+	return max_len;
+}
+
 u16_t net_pkt_append(struct net_pkt *pkt, u16_t len, const u8_t *data,
 		    s32_t timeout)
 {
@@ -1208,18 +1225,7 @@ u16_t net_pkt_append(struct net_pkt *pkt, u16_t len, const u8_t *data,
 	}
 
 	if (ctx) {
-		/* Make sure we don't send more data in one packet than
-		 * protocol or MTU allows when there is a context for the
-		 * packet.
-		 */
-		max_len = pkt->data_len;
-
-#if defined(CONFIG_NET_TCP)
-		if (ctx->tcp && (ctx->tcp->send_mss < max_len)) {
-			max_len = ctx->tcp->send_mss;
-		}
-#endif
-
+		max_len = net_pkt_append_max_len(pkt, ctx);
 		if (len > max_len) {
 			len = max_len;
 		}
@@ -1236,6 +1242,46 @@ u16_t net_pkt_append(struct net_pkt *pkt, u16_t len, const u8_t *data,
 	return appended;
 }
 
+u16_t net_pkt_append_frags(struct net_pkt *pkt, struct net_buf *frags,
+			   struct net_buf **rest, s32_t timeout)
+{
+	struct net_context *ctx = NULL;
+	u16_t max_len = 0xffff;
+	size_t len;
+
+	if (!pkt || !frags || !rest) {
+		return 0;
+	}
+
+	*rest = NULL;
+
+	if (pkt->slab != &rx_pkts) {
+		ctx = net_pkt_context(pkt);
+	}
+
+	if (ctx) {
+		max_len = net_pkt_append_max_len(pkt, ctx);
+	}
+
+	len = net_buf_frags_len(frags);
+	if (len > max_len) {
+		/* Only the buffer at the split point needs to be copied */
+		if (net_pkt_split(pkt, frags, max_len, rest, timeout) < 0) {
+			return 0;
+		}
+
+		len = max_len;
+	}
+
+	net_pkt_frag_add(pkt, frags);
+
+	if (ctx) {
+		pkt->data_len -= len;
+	}
+
+	return len;
+}
+
 u16_t net_pkt_append_memset(struct net_pkt *pkt, u16_t len, const u8_t data,
 			    s32_t timeout)
 {
@@ -1307,30 +1353,6 @@ u16_t net_pkt_append_memset(struct net_pkt *pkt, u16_t len, const u8_t data,
 	return appended;
 }
 
-/* Helper routine to retrieve single byte from fragment and move
- * offset. If required byte is last byte in fragment then return
- * next fragment and set offset = 0.
- */
-static inline struct net_buf *net_frag_read_byte(struct net_buf *frag,
-						 u16_t offset,
-						 u16_t *pos,
-						 u8_t *data)
-{
-	if (data) {
-		*data = frag->data[offset];
-	}
-
-	*pos = offset + 1;
-
-	if (*pos >= frag->len) {
-		*pos = 0;
-
-		return frag->frags;
-	}
-
-	return frag;
-}
-
 /* Helper function to adjust offset in net_frag_read() call
  * if given offset is more than current fragment length.
  */
@@ -1358,28 +1380,42 @@ static inline struct net_buf *adjust_offset(struct net_buf *frag,
 struct net_buf *net_frag_read(struct net_buf *frag, u16_t offset,
 			      u16_t *pos, u16_t len, u8_t *data)
 {
-	u16_t copy = 0;
+	u16_t count;
 
 	frag = adjust_offset(frag, offset, pos);
 	if (!frag) {
 		goto error;
 	}
 
-	while (len-- > 0 && frag) {
-		if (data) {
-			frag = net_frag_read_byte(frag, *pos,
-						  pos, data + copy++);
-		} else {
-			frag = net_frag_read_byte(frag, *pos, pos, NULL);
-		}
+	offset = *pos;
 
-		/* Error: Still remaining length to be read, but no data. */
-		if (!frag && len) {
+	/* Copy what each fragment has at once. If the data ends with a
+	 * fragment, the next one is returned with pos 0.
+	 */
+	while (len > 0) {
+		if (!frag) {
 			NET_ERR("Not enough data to read");
 			goto error;
 		}
+
+		count = min(len, frag->len - offset);
+
+		if (data) {
+			memcpy(data, frag->data + offset, count);
+			data += count;
+		}
+
+		len -= count;
+		offset += count;
+
+		if (offset >= frag->len) {
+			frag = frag->frags;
+			offset = 0;
+		}
 	}
 
+	*pos = offset;
+
 	return frag;
 
 error:
@@ -1414,6 +1450,174 @@ struct net_buf *net_frag_read_be32(struct net_buf *frag, u16_t offset,
 	return ret_frag;
 }
 
+/* Skip the data the cursor is done with, so that it is in the fragment
+ * of its next byte.
+ */
+static struct net_buf *cursor_buf(struct net_pkt_cursor *cursor)
+{
+	while (cursor->buf && cursor->pos >= cursor->buf->len) {
+		cursor->pos -= cursor->buf->len;
+		cursor->buf = cursor->buf->frags;
+	}
+
+	if (!cursor->buf) {
+		cursor->pos = 0;
+	}
+
+	return cursor->buf;
+}
+
+u8_t *net_pkt_cursor_span(struct net_pkt_cursor *cursor, u16_t *len)
+{
+	if (!cursor_buf(cursor)) {
+		*len = 0;
+		return NULL;
+	}
+
+	*len = cursor->buf->len - cursor->pos;
+
+	return cursor->buf->data + cursor->pos;
+}
+
+size_t net_pkt_cursor_remaining(struct net_pkt_cursor *cursor)
+{
+	struct net_buf *frag;
+	size_t len;
+
+	if (!cursor_buf(cursor)) {
+		return 0;
+	}
+
+	len = cursor->buf->len - cursor->pos;
+
+	for (frag = cursor->buf->frags; frag; frag = frag->frags) {
+		len += frag->len;
+	}
+
+	return len;
+}
+
+int net_pkt_cursor_read(struct net_pkt_cursor *cursor, void *data,
+			u16_t len)
+{
+	u8_t *dst = data;
+	u16_t count;
+
+	while (len > 0) {
+		if (!cursor_buf(cursor)) {
+			return -ENODATA;
+		}
+
+		count = min(len, cursor->buf->len - cursor->pos);
+
+		if (dst) {
+			memcpy(dst, cursor->buf->data + cursor->pos, count);
+			dst += count;
+		}
+
+		cursor->pos += count;
+		len -= count;
+	}
+
+	return 0;
+}
+
+int net_pkt_cursor_peek(struct net_pkt_cursor *cursor, void *data,
+			u16_t len)
+{
+	struct net_pkt_cursor tmp = *cursor;
+
+	return net_pkt_cursor_read(&tmp, data, len);
+}
+
+int net_pkt_cursor_read_be16(struct net_pkt_cursor *cursor, u16_t *value)
+{
+	u8_t v16[2];
+	int ret;
+
+	ret = net_pkt_cursor_read(cursor, v16, sizeof(v16));
+	if (ret < 0) {
+		return ret;
+	}
+
+	*value = sys_get_be16(v16);
+
+	return 0;
+}
+
+int net_pkt_cursor_read_be32(struct net_pkt_cursor *cursor, u32_t *value)
+{
+	u8_t v32[4];
+	int ret;
+
+	ret = net_pkt_cursor_read(cursor, v32, sizeof(v32));
+	if (ret < 0) {
+		return ret;
+	}
+
+	*value = sys_get_be32(v32);
+
+	return 0;
+}
+
+int net_pkt_cursor_write(struct net_pkt_cursor *cursor, const void *data,
+			 u16_t len, s32_t timeout)
+{
+	const u8_t *src = data;
+	u16_t count;
+
+	while (len > 0 && cursor_buf(cursor)) {
+		count = min(len, cursor->buf->len - cursor->pos);
+
+		memcpy(cursor->buf->data + cursor->pos, src, count);
+
+		cursor->pos += count;
+		src += count;
+		len -= count;
+	}
+
+	if (!len) {
+		return 0;
+	}
+
+	/* The cursor is at the end of the data, the packet grows */
+	if (net_pkt_append(cursor->pkt, len, src, timeout) != len) {
+		return -ENOMEM;
+	}
+
+	cursor->buf = NULL;
+	cursor->pos = 0;
+
+	return 0;
+}
+
+int net_pkt_cursor_copy(struct net_pkt_cursor *dst,
+			struct net_pkt_cursor *src, u16_t len, s32_t timeout)
+{
+	u16_t count;
+	u8_t *data;
+	int ret;
+
+	while (len > 0) {
+		data = net_pkt_cursor_span(src, &count);
+		if (!data) {
+			return -ENODATA;
+		}
+
+		count = min(len, count);
+
+		ret = net_pkt_cursor_write(dst, data, count, timeout);
+		if (ret < 0) {
+			return ret;
+		}
+
+		src->pos += count;
+		len -= count;
+	}
+
+	return 0;
+}
+
 static inline struct net_buf *check_and_create_data(struct net_pkt *pkt,
 						    struct net_buf *data,
 						    s32_t timeout)
@@ -48,8 +48,49 @@ enum net_verdict net_ipv6_process_pkt(struct net_pkt *pkt, bool is_loopback);
 extern void net_tc_tx_init(void);
 extern void net_tc_rx_init(void);
 extern void net_tc_submit_to_tx_queue(u8_t tc, struct net_pkt *pkt);
+extern void net_tc_submit_work_to_tx_queue(u8_t tc, struct k_work *work);
 extern void net_tc_submit_to_rx_queue(u8_t tc, struct net_pkt *pkt);
+extern void net_tc_submit_list_to_rx_queue(u8_t tc, sys_slist_t *list);
+extern void net_process_rx_packet(struct net_pkt *pkt);
+extern void net_process_rx_batch_done(u8_t tc);
 extern enum net_verdict net_promisc_mode_input(struct net_pkt *pkt);
+extern bool net_if_tx(struct net_if *iface, struct net_pkt *pkt);
+extern void net_if_tx_drop(struct net_if *iface, struct net_pkt *pkt,
+			   int status);
+
+#if defined(CONFIG_NET_TX_SCHED)
+extern void net_if_tx_sched_init(struct net_if *iface);
+extern void net_if_tx_sched_queue(struct net_if *iface, struct net_pkt *pkt,
+				  u8_t tc);
+#endif
+
+#if defined(CONFIG_NET_CAPTURE)
+#include <net/capture.h>
+
+extern bool net_capture_enabled;
+extern void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt,
+			    u8_t dir);
+
+/* Called for every packet, so the capture only costs a test when it is
+ * not started.
+ */
+static inline void net_capture_rx(struct net_if *iface, struct net_pkt *pkt)
+{
+	if (unlikely(net_capture_enabled)) {
+		net_capture_pkt(iface, pkt, NET_CAPTURE_RX);
+	}
+}
+
+static inline void net_capture_tx(struct net_if *iface, struct net_pkt *pkt)
+{
+	if (unlikely(net_capture_enabled)) {
+		net_capture_pkt(iface, pkt, NET_CAPTURE_TX);
+	}
+}
+#else
+#define net_capture_rx(iface, pkt)
+#define net_capture_tx(iface, pkt)
+#endif /* CONFIG_NET_CAPTURE */
 
 char *net_sprint_addr(sa_family_t af, const void *addr);
 
@@ -173,6 +214,31 @@ static inline u16_t net_calc_chksum_tcp(struct net_pkt *pkt)
 	return net_calc_chksum(pkt, IPPROTO_TCP);
 }
 
+/* Update a checksum when a 16-bit word of the checksummed data changes
+ * from old_val to new_val, see RFC 1624 eqn. 3. The checksum and the
+ * values are all in network byte order.
+ */
+static inline u16_t net_chksum_update_u16(u16_t chksum, u16_t old_val,
+					  u16_t new_val)
+{
+	u32_t sum = (u16_t)~chksum + (u16_t)~old_val + new_val;
+
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~sum;
+}
+
+/* Same as above for a 32-bit field at an even offset of the data */
+static inline u16_t net_chksum_update_u32(u16_t chksum, u32_t old_val,
+					  u32_t new_val)
+{
+	chksum = net_chksum_update_u16(chksum, old_val >> 16, new_val >> 16);
+
+	return net_chksum_update_u16(chksum, old_val & 0xffff,
+				     new_val & 0xffff);
+}
+
 static inline char *net_sprint_ll_addr(const u8_t *ll, u8_t ll_len)
 {
 	static char buf[sizeof("xx:xx:xx:xx:xx:xx:xx:xx")];
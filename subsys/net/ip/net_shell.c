@@ -20,6 +20,7 @@
 
 #include <net/net_if.h>
 #include <net/dns_resolve.h>
+#include <net/capture.h>
 #include <misc/printk.h>
 
 #include "route.h"
@@ -33,6 +34,7 @@
 #endif
 
 #include "ipv6.h"
+#include "ipv4.h"
 
 #if defined(CONFIG_HTTP)
 #include <net/http.h>
@@ -274,6 +276,24 @@ static void iface_cb(struct net_if *iface, void *user_data)
 
 	PR("MTU       : %d\n", net_if_get_mtu(iface));
 
+#if defined(CONFIG_NET_TX_SCHED)
+	if (iface->tx_sched.rate) {
+		PR("Tx rate   : %u bytes/s, burst %u bytes\n",
+		   iface->tx_sched.rate, iface->tx_sched.burst);
+	}
+
+	PR("Tx queues :\n");
+	for (i = 0; i < NET_TC_TX_COUNT; i++) {
+		struct net_if_tx_queue_stats stats;
+
+		net_if_tx_sched_get_stats(iface, i, &stats);
+
+		PR("\t[%d] weight %d queued %d max %d sent %u dropped %u\n",
+		   i, iface->tx_sched.queues[i].weight, stats.len,
+		   stats.max_len, stats.sent, stats.dropped);
+	}
+#endif
+
 #if defined(CONFIG_NET_L2_ETHERNET_MGMT)
 	count = 0;
 	ret = net_mgmt(NET_REQUEST_ETHERNET_GET_PRIORITY_QUEUES_NUM,
@@ -704,6 +724,14 @@ static void net_shell_print_statistics(struct net_if *iface, void *user_data)
 	   GET_STAT(iface, ipv4.sent),
 	   GET_STAT(iface, ipv4.drop),
 	   GET_STAT(iface, ipv4.forwarded));
+#if defined(CONFIG_NET_STATISTICS_IPV4_FRAGMENT)
+	PR("IPv4 frag recv %d\tsent\t%d\treasm\t%d\tdrop\t%d\ttimeout\t%d\n",
+	   GET_STAT(iface, ipv4_frag.recv),
+	   GET_STAT(iface, ipv4_frag.sent),
+	   GET_STAT(iface, ipv4_frag.reassembled),
+	   GET_STAT(iface, ipv4_frag.drop),
+	   GET_STAT(iface, ipv4_frag.timeout));
+#endif /* CONFIG_NET_STATISTICS_IPV4_FRAGMENT */
 #endif /* CONFIG_NET_IPV4 */
 
 	PR("IP vhlerr      %d\thblener\t%d\tlblener\t%d\n",
@@ -1079,6 +1107,40 @@ static void ipv6_frag_cb(struct net_ipv6_reassembly *reass,
 }
 #endif /* CONFIG_NET_IPV6_FRAGMENT */
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+static void ipv4_frag_cb(struct net_ipv4_reassembly *reass,
+			 void *user_data)
+{
+	struct net_shell_user_data *data = user_data;
+	const struct shell *shell = data->shell;
+	int *count = data->user_data;
+	char src[ADDR_LEN];
+	int i;
+
+	if (!*count) {
+		PR("\nIPv4 reassembly Id     Remain Len   "
+		   "Src             \tDst\n");
+	}
+
+	snprintk(src, ADDR_LEN, "%s", net_sprint_ipv4_addr(&reass->src));
+
+	PR("%p      0x%04x  %5d %5d %16s\t%16s\n",
+	   reass, reass->id,
+	   k_delayed_work_remaining_get(&reass->timer), reass->len,
+	   src, net_sprint_ipv4_addr(&reass->dst));
+
+	for (i = 0; i < NET_IPV4_FRAGMENTS_MAX_PKT; i++) {
+		if (reass->pkt[i]) {
+			PR("[%d] pkt %p offset %d len %zd\n", i, reass->pkt[i],
+			   net_pkt_ipv4_fragment_offset(reass->pkt[i]),
+			   net_pkt_get_len(reass->pkt[i]));
+		}
+	}
+
+	(*count)++;
+}
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #if CONFIG_NET_PKT_LOG_LEVEL >= LOG_LEVEL_DBG
 static void allocs_cb(struct net_pkt *pkt,
 		      struct net_buf *buf,
@@ -1503,6 +1565,275 @@ static int cmd_net_arp_flush(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#if defined(CONFIG_NET_CAPTURE)
+static void print_capture_stats(const struct shell *shell)
+{
+	struct net_capture_stats stats;
+
+	net_capture_get_stats(&stats);
+
+	PR("Capture %s\n", net_capture_is_active() ? "started" : "stopped");
+	PR("Captured %u\tFiltered %u\tDropped %u\tExported %u\n",
+	   stats.captured, stats.filtered, stats.dropped, stats.exported);
+}
+
+struct capture_dump_data {
+	const struct shell *shell;
+	int count;
+};
+
+static int capture_dump_cb(const void *data, size_t len, void *user_data)
+{
+	struct capture_dump_data *dump = user_data;
+	const struct shell *shell = dump->shell;
+	const u8_t *ptr = data;
+
+	while (len--) {
+		PR("%02x", *ptr++);
+
+		if (++dump->count % 32 == 0) {
+			PR("\n");
+		}
+	}
+
+	return 0;
+}
+#else
+static void print_capture_error(const struct shell *shell)
+{
+	PR_INFO("Set CONFIG_NET_CAPTURE to enable packet capture.\n");
+}
+#endif /* CONFIG_NET_CAPTURE */
+
+static int cmd_net_capture(const struct shell *shell, size_t argc,
+			   char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	print_capture_stats(shell);
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_start(const struct shell *shell, size_t argc,
+				 char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE)
+	struct net_if *iface = NULL;
+	u8_t dir = NET_CAPTURE_RX | NET_CAPTURE_TX;
+	char *endptr;
+	int arg = 1;
+	int ret;
+#endif
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	/* capture start [<interface index>] [rx|tx] */
+	if (argv[arg] && strcmp(argv[arg], "rx") && strcmp(argv[arg], "tx")) {
+		iface = net_if_get_by_index(strtol(argv[arg], &endptr, 10));
+		if (*endptr != '\0' || !iface) {
+			PR_WARNING("Invalid index %s\n", argv[arg]);
+			goto usage;
+		}
+
+		arg++;
+	}
+
+	if (argv[arg]) {
+		if (!strcmp(argv[arg], "rx")) {
+			dir = NET_CAPTURE_RX;
+		} else if (!strcmp(argv[arg], "tx")) {
+			dir = NET_CAPTURE_TX;
+		} else {
+			PR_WARNING("Invalid direction %s\n", argv[arg]);
+			goto usage;
+		}
+	}
+
+	ret = net_capture_start(iface, dir);
+	if (ret < 0) {
+		PR_WARNING("Cannot start capture (%d)\n", ret);
+		return -ENOEXEC;
+	}
+
+	PR("Capturing %s%s%s packets\n",
+	   dir & NET_CAPTURE_RX ? "received" : "",
+	   dir == (NET_CAPTURE_RX | NET_CAPTURE_TX) ? " and " : "",
+	   dir & NET_CAPTURE_TX ? "sent" : "");
+
+	return 0;
+
+usage:
+	PR("Usage:\n");
+	PR("\tcapture start [<interface index>] [rx|tx]\n");
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_stop(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	net_capture_stop();
+	print_capture_stats(shell);
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_filter(const struct shell *shell, size_t argc,
+				  char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE)
+	static struct net_capture_insn prog[CONFIG_NET_CAPTURE_FILTER_LEN];
+	size_t count = (argc - 1) / 4;
+	unsigned long value[4];
+	char *endptr;
+	size_t i, j;
+	int ret;
+#endif
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	/* capture filter [<code> <jt> <jf> <k>]... as printed by
+	 * "tcpdump -ddd", without the number of instructions.
+	 */
+	if ((argc - 1) % 4 || count > ARRAY_SIZE(prog)) {
+		PR_WARNING("Invalid number of values\n");
+		goto usage;
+	}
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < 4; j++) {
+			value[j] = strtoul(argv[1 + i * 4 + j], &endptr, 0);
+			if (*endptr != '\0') {
+				PR_WARNING("Invalid value %s\n",
+					   argv[1 + i * 4 + j]);
+				goto usage;
+			}
+		}
+
+		prog[i].code = value[0];
+		prog[i].jt = value[1];
+		prog[i].jf = value[2];
+		prog[i].k = value[3];
+	}
+
+	ret = net_capture_set_filter(count ? prog : NULL, count);
+	if (ret < 0) {
+		PR_WARNING("Cannot set filter (%d)\n", ret);
+		return -ENOEXEC;
+	}
+
+	if (count) {
+		PR("Filter of %u instructions set\n",
+		   (unsigned int)count);
+	} else {
+		PR("Filter removed\n");
+	}
+
+	return 0;
+
+usage:
+	PR("Usage:\n");
+	PR("\tcapture filter [<code> <jt> <jf> <k>]...\n");
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_dump(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE)
+	struct capture_dump_data dump = {
+		.shell = shell,
+	};
+	int ret;
+#endif
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	ret = net_capture_export(capture_dump_cb, &dump);
+
+	if (dump.count % 32) {
+		PR("\n");
+	}
+
+	if (ret < 0) {
+		PR_WARNING("Cannot export capture (%d)\n", ret);
+		return -ENOEXEC;
+	}
+
+	PR_INFO("%d packets exported, convert with 'xxd -r -p'\n", ret);
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_clear(const struct shell *shell, size_t argc,
+				 char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_NET_CAPTURE)
+	net_capture_clear();
+	PR("Capture buffer cleared\n");
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
 static int cmd_net_conn(const struct shell *shell, size_t argc, char *argv[])
 {
 	struct net_shell_user_data user_data;
@@ -1571,6 +1902,12 @@ static int cmd_net_conn(const struct shell *shell, size_t argc, char *argv[])
 	/* Do not print anything if no fragments are pending atm */
 #endif
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	count = 0;
+
+	net_ipv4_frag_foreach(ipv4_frag_cb, &user_data);
+#endif
+
 	return 0;
 }
 
@@ -1620,12 +1957,18 @@ static void dns_result_cb(enum dns_resolve_status status,
 		return;
 	}
 
-	if (status == DNS_EAI_FAIL) {
+	if (status == DNS_EAI_FAIL || status == DNS_EAI_NONAME) {
 		PR_WARNING("No such name found.\n");
 		*first = false;
 		return;
 	}
 
+	if (status == DNS_EAI_NODATA) {
+		PR_WARNING("No address of this type found.\n");
+		*first = false;
+		return;
+	}
+
 	PR_WARNING("Unhandled status %d received\n", status);
 }
 
@@ -1682,6 +2025,104 @@ static void print_dns_info(const struct shell *shell,
 }
 #endif
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+static void dns_cache_cb(const struct dns_cache_info *info, void *user_data)
+{
+	struct net_shell_user_data *data = user_data;
+	const struct shell *shell = data->shell;
+	int *count = data->user_data;
+	char addr[NET_IPV6_ADDR_LEN];
+	int i;
+
+	if (*count == 0) {
+		PR("Type TTL    Hits  Name\n");
+	}
+
+	(*count)++;
+
+	PR("%-4s %-6u %-5u %s\n",
+	   info->type == DNS_QUERY_TYPE_A ? "A" : "AAAA", info->ttl,
+	   info->hits, info->name);
+
+	if (info->status == DNS_EAI_NONAME) {
+		PR("\t<no such name>\n");
+		return;
+	}
+
+	if (info->status == DNS_EAI_NODATA) {
+		PR("\t<no address>\n");
+		return;
+	}
+
+	for (i = 0; i < info->count; i++) {
+		if (info->type == DNS_QUERY_TYPE_A) {
+			net_addr_ntop(AF_INET, info->addr +
+				      i * sizeof(struct in_addr),
+				      addr, sizeof(addr));
+		} else {
+			net_addr_ntop(AF_INET6, info->addr +
+				      i * sizeof(struct in6_addr),
+				      addr, sizeof(addr));
+		}
+
+		PR("\t%s\n", addr);
+	}
+}
+#endif
+
+static int cmd_net_dns_cache(const struct shell *shell, size_t argc,
+			     char *argv[])
+{
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct net_shell_user_data user_data;
+	int count = 0;
+#endif
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	user_data.shell = shell;
+	user_data.user_data = &count;
+
+	if (dns_cache_foreach(dns_cache_cb, &user_data) == 0) {
+		PR("DNS cache is empty.\n");
+	}
+#else
+	PR_INFO("DNS cache not supported. Set CONFIG_DNS_RESOLVER_CACHE to "
+		"enable it.\n");
+#endif
+
+	return 0;
+}
+
+static int cmd_net_dns_cache_flush(const struct shell *shell, size_t argc,
+				   char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (shell_help_requested(shell)) {
+		shell_help_print(shell, NULL, 0);
+		return -ENOEXEC;
+	}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	PR("Flushing DNS cache.\n");
+	dns_cache_flush();
+#else
+	PR_INFO("DNS cache not supported. Set CONFIG_DNS_RESOLVER_CACHE to "
+		"enable it.\n");
+#endif
+
+	return 0;
+}
+
 static int cmd_net_dns_cancel(const struct shell *shell, size_t argc,
 			      char *argv[])
 {
@@ -3078,6 +3519,9 @@ static int cmd_net_nbr(const struct shell *shell, size_t argc, char *argv[])
 	int count = 0;
 	struct net_shell_user_data user_data;
 #endif
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	struct net_ipv6_nbr_stats stats;
+#endif
 
 	ARG_UNUSED(argc);
 	ARG_UNUSED(argv);
@@ -3096,6 +3540,14 @@ static int cmd_net_nbr(const struct shell *shell, size_t argc, char *argv[])
 	if (count == 0) {
 		PR("No neighbors.\n");
 	}
+
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	net_ipv6_nbr_get_stats(&stats);
+
+	PR("\nLookups %u, last hits %u, misses %u, evictions %u, "
+	   "timeouts %u\n", stats.lookups, stats.last_hits, stats.misses,
+	   stats.evictions, stats.timeouts);
+#endif
 #else
 	PR_INFO("IPv6 not enabled.\n");
 #endif /* CONFIG_NET_IPV6 */
@@ -4298,8 +4750,37 @@ SHELL_CREATE_STATIC_SUBCMD_SET(net_cmd_arp)
 	SHELL_SUBCMD_SET_END
 };
 
+SHELL_CREATE_STATIC_SUBCMD_SET(net_cmd_capture)
+{
+	SHELL_CMD(start, NULL,
+		  "'net capture start [<index>] [rx|tx]' starts capturing "
+		  "the packets of all or one network interface.",
+		  cmd_net_capture_start),
+	SHELL_CMD(stop, NULL, "Stop capturing packets.",
+		  cmd_net_capture_stop),
+	SHELL_CMD(filter, NULL,
+		  "'net capture filter [<code> <jt> <jf> <k>]...' sets the "
+		  "BPF filter printed by 'tcpdump -ddd', or removes it.",
+		  cmd_net_capture_filter),
+	SHELL_CMD(dump, NULL,
+		  "Print the captured packets in pcapng format, in hex.",
+		  cmd_net_capture_dump),
+	SHELL_CMD(clear, NULL, "Remove the captured packets.",
+		  cmd_net_capture_clear),
+	SHELL_SUBCMD_SET_END
+};
+
+SHELL_CREATE_STATIC_SUBCMD_SET(net_cmd_dns_cache)
+{
+	SHELL_CMD(flush, NULL, "Remove all entries from DNS cache.",
+		  cmd_net_dns_cache_flush),
+	SHELL_SUBCMD_SET_END
+};
+
 SHELL_CREATE_STATIC_SUBCMD_SET(net_cmd_dns)
 {
+	SHELL_CMD(cache, &net_cmd_dns_cache, "Print DNS cache content.",
+		  cmd_net_dns_cache),
 	SHELL_CMD(cancel, NULL, "Cancel all pending requests.",
 		  cmd_net_dns_cancel),
 	SHELL_CMD(query, NULL,
@@ -4526,6 +5007,8 @@ SHELL_CREATE_STATIC_SUBCMD_SET(net_commands)
 		  cmd_net_app),
 	SHELL_CMD(arp, &net_cmd_arp, "Print information about IPv4 ARP cache.",
 		  cmd_net_arp),
+	SHELL_CMD(capture, &net_cmd_capture,
+		  "Show packet capture status.", cmd_net_capture),
 	SHELL_CMD(conn, NULL, "Print information about network connections.",
 		  cmd_net_conn),
 	SHELL_CMD(dns, &net_cmd_dns, "Show how DNS is configured.",
@@ -46,6 +46,11 @@ static inline void net_stats_update_ip_errors_vhlerr(struct net_if *iface)
 	UPDATE_STAT(iface, stats.ip_errors.vhlerr++);
 }
 
+static inline void net_stats_update_ip_errors_fragerr(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ip_errors.fragerr++);
+}
+
 static inline void net_stats_update_bytes_recv(struct net_if *iface,
 					       u32_t bytes)
 {
@@ -61,6 +66,7 @@ static inline void net_stats_update_bytes_sent(struct net_if *iface,
 #define net_stats_update_processing_error(iface)
 #define net_stats_update_ip_errors_protoerr(iface)
 #define net_stats_update_ip_errors_vhlerr(iface)
+#define net_stats_update_ip_errors_fragerr(iface)
 #define net_stats_update_bytes_recv(iface, bytes)
 #define net_stats_update_bytes_sent(iface, bytes)
 #endif /* CONFIG_NET_STATISTICS */
@@ -134,6 +140,42 @@ static inline void net_stats_update_ipv4_recv(struct net_if *iface)
 #define net_stats_update_ipv4_recv(iface)
 #endif /* CONFIG_NET_STATISTICS_IPV4 */
 
+#if defined(CONFIG_NET_STATISTICS_IPV4_FRAGMENT)
+/* IPv4 fragmentation stats */
+
+static inline void net_stats_update_ipv4_frag_recv(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ipv4_frag.recv++);
+}
+
+static inline void net_stats_update_ipv4_frag_sent(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ipv4_frag.sent++);
+}
+
+static inline void net_stats_update_ipv4_frag_reassembled(
+	struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ipv4_frag.reassembled++);
+}
+
+static inline void net_stats_update_ipv4_frag_drop(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ipv4_frag.drop++);
+}
+
+static inline void net_stats_update_ipv4_frag_timeout(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.ipv4_frag.timeout++);
+}
+#else
+#define net_stats_update_ipv4_frag_recv(iface)
+#define net_stats_update_ipv4_frag_sent(iface)
+#define net_stats_update_ipv4_frag_reassembled(iface)
+#define net_stats_update_ipv4_frag_drop(iface)
+#define net_stats_update_ipv4_frag_timeout(iface)
+#endif /* CONFIG_NET_STATISTICS_IPV4_FRAGMENT */
+
 #if defined(CONFIG_NET_STATISTICS_ICMP)
 /* Common ICMPv4/ICMPv6 stats */
 static inline void net_stats_update_icmp_sent(struct net_if *iface)
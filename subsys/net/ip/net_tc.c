@@ -38,9 +38,57 @@ void net_tc_submit_to_tx_queue(u8_t tc, struct net_pkt *pkt)
 	k_work_submit_to_queue(&tx_classes[tc].work_q, net_pkt_work(pkt));
 }
 
+void net_tc_submit_work_to_tx_queue(u8_t tc, struct k_work *work)
+{
+	k_work_submit_to_queue(&tx_classes[tc].work_q, work);
+}
+
+/* Received packets are queued to a FIFO per traffic class, and one work
+ * item per traffic class processes the queued packets in batches.
+ */
+struct net_rx_batch {
+	struct k_fifo fifo;
+	struct k_work work;
+};
+
+static struct net_rx_batch rx_batches[NET_TC_RX_COUNT];
+
 void net_tc_submit_to_rx_queue(u8_t tc, struct net_pkt *pkt)
 {
-	k_work_submit_to_queue(&rx_classes[tc].work_q, net_pkt_work(pkt));
+	k_fifo_put(&rx_batches[tc].fifo, pkt);
+	k_work_submit_to_queue(&rx_classes[tc].work_q, &rx_batches[tc].work);
+}
+
+void net_tc_submit_list_to_rx_queue(u8_t tc, sys_slist_t *list)
+{
+	k_fifo_put_slist(&rx_batches[tc].fifo, list);
+	k_work_submit_to_queue(&rx_classes[tc].work_q, &rx_batches[tc].work);
+}
+
+static void process_rx_batch(struct k_work *work)
+{
+	struct net_rx_batch *batch = CONTAINER_OF(work, struct net_rx_batch,
+						  work);
+	u8_t tc = batch - rx_batches;
+	struct net_pkt *pkt;
+	int count = 0;
+
+	while (count < CONFIG_NET_RX_BATCH_SIZE) {
+		pkt = k_fifo_get(&batch->fifo, K_NO_WAIT);
+		if (!pkt) {
+			break;
+		}
+
+		net_process_rx_packet(pkt);
+		count++;
+	}
+
+	net_process_rx_batch_done(tc);
+
+	/* Let other work in the queue to run before continuing */
+	if (!k_fifo_is_empty(&batch->fifo)) {
+		k_work_submit_to_queue(&rx_classes[tc].work_q, work);
+	}
 }
 
 int net_tx_priority2tc(enum net_priority prio)
@@ -277,6 +325,9 @@ void net_tc_rx_init(void)
 		thread_priority = rx_tc2thread(i);
 		rx_classes[i].tc = thread_priority;
 
+		k_fifo_init(&rx_batches[i].fifo);
+		k_work_init(&rx_batches[i].work, process_rx_batch);
+
 #if defined(CONFIG_NET_SHELL)
 		/* Fix the thread start address so that "net stacks"
 		 * command will print correct stack information.
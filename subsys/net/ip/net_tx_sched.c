@@ -0,0 +1,276 @@
+/** @file
+ * @brief Egress scheduler of a network interface
+ *
+ * Each interface has a queue per Tx traffic class. The queues are served
+ * with deficit round robin, which shares the link between the backlogged
+ * traffic classes in proportion to their weights, and the total rate of
+ * the interface can be shaped with a token bucket.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_tx_sched
+#define NET_LOG_LEVEL CONFIG_NET_TC_LOG_LEVEL
+
+#include <zephyr.h>
+#include <string.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+
+/* The packets of all the interfaces are sent from the highest priority Tx
+ * thread. This way the packets of one interface are never sent
+ * concurrently, and the scheduler alone decides the order of the traffic
+ * classes. Each interface sends at most CONFIG_NET_TX_SCHED_BUDGET packets
+ * before letting the other interfaces to send.
+ */
+#define SCHED_TC (NET_TC_TX_COUNT - 1)
+
+static inline struct net_if *sched_to_iface(struct net_if_tx_sched *sched)
+{
+	return CONTAINER_OF(sched, struct net_if, tx_sched);
+}
+
+/* Take len bytes from the token bucket. If there are not enough tokens,
+ * return the time in milliseconds until there are.
+ */
+static bool sched_take_tokens(struct net_if_tx_sched *sched, size_t len,
+			      s32_t *wait)
+{
+	s64_t now;
+	u64_t tokens;
+	u32_t need;
+
+	if (!sched->rate) {
+		return true;
+	}
+
+	now = k_uptime_get();
+
+	tokens = (u64_t)(now - sched->last_refill) * sched->rate /
+		MSEC_PER_SEC;
+	if (tokens) {
+		sched->tokens = min(sched->tokens + tokens, sched->burst);
+		sched->last_refill = now;
+	}
+
+	/* A packet larger than the bucket is sent when the bucket is full */
+	need = min(len, sched->burst);
+
+	if (sched->tokens >= need) {
+		sched->tokens -= need;
+		return true;
+	}
+
+	*wait = ((u64_t)(need - sched->tokens) * MSEC_PER_SEC +
+		 sched->rate - 1) / sched->rate;
+
+	return false;
+}
+
+static inline void sched_next_queue(struct net_if_tx_sched *sched)
+{
+	/* Higher traffic classes are served first in each round */
+	if (sched->current) {
+		sched->current--;
+	} else {
+		sched->current = NET_TC_TX_COUNT - 1;
+	}
+}
+
+/* Pick the next packet to send. Must be called with interrupts locked. */
+static struct net_pkt *sched_dequeue(struct net_if_tx_sched *sched,
+				     s32_t *wait)
+{
+	int empty = 0;
+
+	*wait = 0;
+
+	while (empty < NET_TC_TX_COUNT) {
+		struct net_if_tx_queue *queue = &sched->queues[sched->current];
+		struct net_pkt *pkt;
+		size_t len;
+
+		pkt = (struct net_pkt *)sys_slist_peek_head(&queue->pkts);
+		if (!pkt) {
+			/* An idle queue does not save its deficit */
+			queue->deficit = 0;
+			queue->active = false;
+			sched_next_queue(sched);
+			empty++;
+			continue;
+		}
+
+		empty = 0;
+
+		if (!queue->active) {
+			queue->deficit += queue->weight *
+				CONFIG_NET_TX_SCHED_QUANTUM;
+			queue->active = true;
+		}
+
+		len = net_pkt_get_len(pkt);
+		if ((s32_t)len > queue->deficit) {
+			queue->active = false;
+			sched_next_queue(sched);
+			continue;
+		}
+
+		if (!sched_take_tokens(sched, len, wait)) {
+			return NULL;
+		}
+
+		sys_slist_get_not_empty(&queue->pkts);
+		queue->deficit -= len;
+		queue->stats.len--;
+		queue->stats.sent++;
+
+		return pkt;
+	}
+
+	return NULL;
+}
+
+static void sched_send(struct k_work *work)
+{
+	struct net_if_tx_sched *sched = CONTAINER_OF(work,
+						     struct net_if_tx_sched,
+						     work);
+	struct net_if *iface = sched_to_iface(sched);
+	int budget = CONFIG_NET_TX_SCHED_BUDGET;
+	struct net_pkt *pkt;
+	unsigned int key;
+	s32_t wait;
+
+	while (budget--) {
+		key = irq_lock();
+		pkt = sched_dequeue(sched, &wait);
+		irq_unlock(key);
+
+		if (!pkt) {
+			if (wait) {
+				NET_DBG("iface %p shaped for %d ms", iface,
+					wait);
+				k_delayed_work_submit(&sched->shaper, wait);
+			}
+
+			return;
+		}
+
+		net_if_tx(iface, pkt);
+	}
+
+	net_tc_submit_work_to_tx_queue(SCHED_TC, work);
+}
+
+static void sched_shaper_timeout(struct k_work *work)
+{
+	struct net_if_tx_sched *sched = CONTAINER_OF(work,
+						     struct net_if_tx_sched,
+						     shaper);
+
+	net_tc_submit_work_to_tx_queue(SCHED_TC, &sched->work);
+}
+
+void net_if_tx_sched_queue(struct net_if *iface, struct net_pkt *pkt, u8_t tc)
+{
+	struct net_if_tx_sched *sched = &iface->tx_sched;
+	struct net_if_tx_queue *queue = &sched->queues[tc];
+	unsigned int key;
+
+	key = irq_lock();
+
+	if (queue->stats.len >= CONFIG_NET_TX_SCHED_QUEUE_LEN) {
+		queue->stats.dropped++;
+		irq_unlock(key);
+
+		NET_DBG("iface %p TC %d queue full, dropping pkt %p", iface,
+			tc, pkt);
+
+		net_if_tx_drop(iface, pkt, -ENOBUFS);
+		return;
+	}
+
+	sys_slist_append(&queue->pkts, (sys_snode_t *)pkt);
+
+	if (++queue->stats.len > queue->stats.max_len) {
+		queue->stats.max_len = queue->stats.len;
+	}
+
+	irq_unlock(key);
+
+	net_tc_submit_work_to_tx_queue(SCHED_TC, &sched->work);
+}
+
+int net_if_tx_sched_set_weight(struct net_if *iface, u8_t tc, u16_t weight)
+{
+	if (!iface || tc >= NET_TC_TX_COUNT || !weight) {
+		return -EINVAL;
+	}
+
+	iface->tx_sched.queues[tc].weight = weight;
+
+	return 0;
+}
+
+void net_if_tx_sched_set_rate(struct net_if *iface, u32_t rate, u32_t burst)
+{
+	struct net_if_tx_sched *sched = &iface->tx_sched;
+	unsigned int key;
+
+	key = irq_lock();
+
+	sched->rate = rate;
+	sched->burst = burst;
+	sched->tokens = burst;
+	sched->last_refill = k_uptime_get();
+
+	irq_unlock(key);
+
+	/* Packets might be waiting for the old rate */
+	k_delayed_work_cancel(&sched->shaper);
+	net_tc_submit_work_to_tx_queue(SCHED_TC, &sched->work);
+}
+
+int net_if_tx_sched_get_stats(struct net_if *iface, u8_t tc,
+			      struct net_if_tx_queue_stats *stats)
+{
+	unsigned int key;
+
+	if (!iface || tc >= NET_TC_TX_COUNT || !stats) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+	memcpy(stats, &iface->tx_sched.queues[tc].stats, sizeof(*stats));
+	irq_unlock(key);
+
+	return 0;
+}
+
+void net_if_tx_sched_init(struct net_if *iface)
+{
+	struct net_if_tx_sched *sched = &iface->tx_sched;
+	int i;
+
+	memset(sched, 0, sizeof(*sched));
+
+	for (i = 0; i < NET_TC_TX_COUNT; i++) {
+		sys_slist_init(&sched->queues[i].pkts);
+
+		/* Higher traffic classes get a larger share by default */
+		sched->queues[i].weight = i + 1;
+	}
+
+	sched->current = NET_TC_TX_COUNT - 1;
+
+	k_work_init(&sched->work, sched_send);
+	k_delayed_work_init(&sched->shaper, sched_shaper_timeout);
+}
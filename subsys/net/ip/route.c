@@ -29,6 +29,7 @@
 #include "nbr.h"
 #include "route.h"
 #include "rpl.h"
+#include "route_lpm.h"
 
 #if !defined(NET_ROUTE_EXTRA_DATA_SIZE)
 #define NET_ROUTE_EXTRA_DATA_SIZE 0
@@ -37,7 +38,7 @@
 /* We keep track of the routes in a separate list so that we can remove
  * the oldest routes (at tail) if needed.
  */
-static sys_slist_t routes;
+static sys_dlist_t routes = SYS_DLIST_STATIC_INIT(&routes);
 
 static void net_route_nexthop_remove(struct net_nbr *nbr)
 {
@@ -109,6 +110,13 @@ NET_NBR_POOL_INIT(net_route_entries_pool,
 NET_NBR_TABLE_INIT(NET_NBR_LOCAL, nbr_routes, net_route_entries_pool,
 		   net_route_entries_table_clear);
 
+#if defined(CONFIG_NET_ROUTE_LPM)
+/* Prefix trie of the routing table entries, so that the lookup does not
+ * need to go through all the entries in the table.
+ */
+NET_ROUTE_LPM_DEFINE(route_lpm, CONFIG_NET_MAX_ROUTES, 128);
+#endif
+
 static inline struct net_nbr *get_nbr(int idx)
 {
 	return &net_route_entries_pool[idx].nbr;
@@ -173,6 +181,12 @@ static inline void nbr_free(struct net_nbr *nbr)
 {
 	NET_DBG("nbr %p", nbr);
 
+#if defined(CONFIG_NET_ROUTE_LPM)
+	net_route_lpm_del(&route_lpm, net_route_data(nbr)->addr.s6_addr,
+			  net_route_data(nbr)->prefix_len,
+			  &net_route_data(nbr)->lpm_node);
+#endif
+
 	net_nbr_unref(nbr);
 }
 
@@ -191,6 +205,16 @@ static struct net_nbr *nbr_new(struct net_if *iface,
 	net_ipaddr_copy(&net_route_data(nbr)->addr, addr);
 	net_route_data(nbr)->prefix_len = prefix_len;
 
+#if defined(CONFIG_NET_ROUTE_LPM)
+	if (net_route_lpm_add(&route_lpm, addr->s6_addr, prefix_len,
+			      &net_route_data(nbr)->lpm_node) < 0) {
+		NET_DBG("Cannot add prefix %s/%d",
+			log_strdup(net_sprint_ipv6_addr(addr)), prefix_len);
+		net_nbr_unref(nbr);
+		return NULL;
+	}
+#endif
+
 	NET_DBG("[%d] nbr %p iface %p IPv6 %s/%d",
 		nbr->idx, nbr, iface,
 		log_strdup(net_sprint_ipv6_addr(&net_route_data(nbr)->addr)),
@@ -248,12 +272,35 @@ static int nbr_nexthop_put(struct net_nbr *nbr)
 /* Route was accessed, so place it in front of the routes list */
 static inline void update_route_access(struct net_route_entry *route)
 {
-	sys_slist_find_and_remove(&routes, &route->node);
-	sys_slist_prepend(&routes, &route->node);
+	sys_dlist_remove(&route->node);
+	sys_dlist_prepend(&routes, &route->node);
 }
 
-struct net_route_entry *net_route_lookup(struct net_if *iface,
-					 struct in6_addr *dst)
+#if defined(CONFIG_NET_ROUTE_LPM)
+static bool route_iface_match(sys_snode_t *node, void *user_data)
+{
+	struct net_route_entry *route =
+		CONTAINER_OF(node, struct net_route_entry, lpm_node);
+
+	return !user_data || route->iface == user_data;
+}
+
+static struct net_route_entry *route_find(struct net_if *iface,
+					  struct in6_addr *dst)
+{
+	sys_snode_t *node;
+
+	node = net_route_lpm_lookup(&route_lpm, dst->s6_addr,
+				    route_iface_match, iface);
+	if (!node) {
+		return NULL;
+	}
+
+	return CONTAINER_OF(node, struct net_route_entry, lpm_node);
+}
+#else
+static struct net_route_entry *route_find(struct net_if *iface,
+					  struct in6_addr *dst)
 {
 	struct net_route_entry *route, *found = NULL;
 	u8_t longest_match = 0;
@@ -281,6 +328,16 @@ struct net_route_entry *net_route_lookup(struct net_if *iface,
 		}
 	}
 
+	return found;
+}
+#endif /* CONFIG_NET_ROUTE_LPM */
+
+struct net_route_entry *net_route_lookup(struct net_if *iface,
+					 struct in6_addr *dst)
+{
+	struct net_route_entry *found;
+
+	found = route_find(iface, dst);
 	if (found) {
 		net_route_info("Found", found, dst);
 
@@ -290,6 +347,35 @@ struct net_route_entry *net_route_lookup(struct net_if *iface,
 	return found;
 }
 
+/* Find the route to exactly this prefix. A route covering the prefix is
+ * not a match as more specific routes can coexist with it.
+ */
+static struct net_route_entry *route_find_exact(struct net_if *iface,
+						struct in6_addr *addr,
+						u8_t prefix_len)
+{
+	struct net_route_entry *route;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_MAX_ROUTES; i++) {
+		struct net_nbr *nbr = get_nbr(i);
+
+		if (!nbr->ref || nbr->iface != iface) {
+			continue;
+		}
+
+		route = net_route_data(nbr);
+
+		if (route->prefix_len == prefix_len &&
+		    net_ipv6_is_prefix((u8_t *)addr, (u8_t *)&route->addr,
+				       prefix_len)) {
+			return route;
+		}
+	}
+
+	return NULL;
+}
+
 struct net_route_entry *net_route_add(struct net_if *iface,
 				      struct in6_addr *addr,
 				      u8_t prefix_len,
@@ -328,7 +414,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 		log_strdup(net_sprint_ll_addr(nexthop_lladdr->addr,
 					      nexthop_lladdr->len)));
 
-	route = net_route_lookup(iface, addr);
+	route = route_find_exact(iface, addr, prefix_len);
 	if (route) {
 		/* Update nexthop if not the same */
 		struct in6_addr *nexthop_addr;
@@ -348,9 +434,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	nbr = nbr_new(iface, addr, prefix_len);
 	if (!nbr) {
 		/* Remove the oldest route and try again */
-		sys_snode_t *last = sys_slist_peek_tail(&routes);
-
-		sys_slist_find_and_remove(&routes, last);
+		sys_dnode_t *last = sys_dlist_peek_tail(&routes);
 
 		route = CONTAINER_OF(last,
 				     struct net_route_entry,
@@ -388,6 +472,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	tmp = get_nexthop_route();
 	if (!tmp) {
 		NET_ERR("No nexthop route available!");
+		nbr_free(nbr);
 		return NULL;
 	}
 
@@ -396,7 +481,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	route = net_route_data(nbr);
 	route->iface = iface;
 
-	sys_slist_prepend(&routes, &route->node);
+	sys_dlist_prepend(&routes, &route->node);
 
 	tmp = nbr_nexthop_get(iface, nexthop);
 
@@ -449,13 +534,13 @@ int net_route_del(struct net_route_entry *route)
 	net_mgmt_event_notify(NET_EVENT_IPV6_ROUTE_DEL, route->iface);
 #endif
 
-	sys_slist_find_and_remove(&routes, &route->node);
-
 	nbr = net_route_get_nbr(route);
 	if (!nbr) {
 		return -ENOENT;
 	}
 
+	sys_dlist_remove(&route->node);
+
 	net_route_info("Deleted", route, &route->addr);
 
 	SYS_SLIST_FOR_EACH_CONTAINER(&route->nexthop, nexthop_route, node) {
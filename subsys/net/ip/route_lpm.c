@@ -0,0 +1,233 @@
+/** @file
+ * @brief Longest prefix match trie for the routing tables
+ *
+ * Path compressed binary trie. Each node stores its full prefix so a
+ * lookup visits at most one node per distinct prefix length on the
+ * path to the destination instead of every route in the table.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <zephyr/types.h>
+#include <errno.h>
+#include <string.h>
+
+#include "route_lpm.h"
+
+static inline int get_bit(const u8_t *addr, u8_t pos)
+{
+	return (addr[pos / 8] >> (7 - (pos % 8))) & 0x01;
+}
+
+static inline u8_t prefix_mask(u8_t len)
+{
+	return 0xff << (8 - (len % 8));
+}
+
+static bool prefix_match(const u8_t *prefix, const u8_t *addr, u8_t len)
+{
+	u8_t bytes = len / 8;
+
+	if (memcmp(prefix, addr, bytes)) {
+		return false;
+	}
+
+	if (!(len % 8)) {
+		return true;
+	}
+
+	return !((prefix[bytes] ^ addr[bytes]) & prefix_mask(len));
+}
+
+/* Number of leading bits that are the same in both prefixes */
+static u8_t common_len(const u8_t *a, const u8_t *b, u8_t len)
+{
+	u8_t i, diff, bits;
+
+	for (i = 0; i < (len + 7) / 8; i++) {
+		diff = a[i] ^ b[i];
+		if (!diff) {
+			continue;
+		}
+
+		bits = i * 8;
+
+		while (!(diff & 0x80)) {
+			diff <<= 1;
+			bits++;
+		}
+
+		return min(bits, len);
+	}
+
+	return len;
+}
+
+static struct net_route_lpm_node *node_alloc(struct net_route_lpm *lpm,
+					     const u8_t *prefix, u8_t len)
+{
+	struct net_route_lpm_node *node;
+	int i;
+
+	for (i = 0; i < lpm->node_count; i++) {
+		node = &lpm->nodes[i];
+
+		if (node->is_used) {
+			continue;
+		}
+
+		(void)memset(node, 0, sizeof(*node));
+
+		memcpy(node->prefix, prefix, len / 8);
+		if (len % 8) {
+			node->prefix[len / 8] = prefix[len / 8] &
+						prefix_mask(len);
+		}
+
+		node->len = len;
+		node->is_used = true;
+
+		return node;
+	}
+
+	return NULL;
+}
+
+static inline void node_free(struct net_route_lpm_node *node)
+{
+	node->is_used = false;
+}
+
+static inline struct net_route_lpm_node *
+only_child(struct net_route_lpm_node *node)
+{
+	return node->child[0] ? node->child[0] : node->child[1];
+}
+
+int net_route_lpm_add(struct net_route_lpm *lpm, const u8_t *prefix,
+		      u8_t len, sys_snode_t *entry)
+{
+	struct net_route_lpm_node **link = &lpm->root;
+	struct net_route_lpm_node *node, *new, *branch;
+	u8_t common = 0;
+
+	if (len > lpm->key_len) {
+		return -EINVAL;
+	}
+
+	while ((node = *link)) {
+		common = common_len(node->prefix, prefix, min(node->len, len));
+		if (common < node->len) {
+			break;
+		}
+
+		if (node->len == len) {
+			sys_slist_append(&node->entries, entry);
+			return 0;
+		}
+
+		link = &node->child[get_bit(prefix, node->len)];
+	}
+
+	new = node_alloc(lpm, prefix, len);
+	if (!new) {
+		return -ENOMEM;
+	}
+
+	sys_slist_append(&new->entries, entry);
+
+	if (!node) {
+		*link = new;
+		return 0;
+	}
+
+	if (common == len) {
+		/* The new prefix covers the existing node */
+		new->child[get_bit(node->prefix, len)] = node;
+		*link = new;
+		return 0;
+	}
+
+	/* The prefixes diverge after the common part */
+	branch = node_alloc(lpm, prefix, common);
+	if (!branch) {
+		node_free(new);
+		return -ENOMEM;
+	}
+
+	branch->child[get_bit(prefix, common)] = new;
+	branch->child[get_bit(node->prefix, common)] = node;
+	*link = branch;
+
+	return 0;
+}
+
+int net_route_lpm_del(struct net_route_lpm *lpm, const u8_t *prefix,
+		      u8_t len, sys_snode_t *entry)
+{
+	struct net_route_lpm_node **link = &lpm->root, **parent_link = NULL;
+	struct net_route_lpm_node *node, *parent = NULL, *child;
+
+	while ((node = *link) && node->len < len) {
+		parent_link = link;
+		parent = node;
+		link = &node->child[get_bit(prefix, node->len)];
+	}
+
+	if (!node || node->len != len ||
+	    !prefix_match(node->prefix, prefix, len)) {
+		return -ENOENT;
+	}
+
+	if (!sys_slist_find_and_remove(&node->entries, entry)) {
+		return -ENOENT;
+	}
+
+	if (!sys_slist_is_empty(&node->entries) ||
+	    (node->child[0] && node->child[1])) {
+		return 0;
+	}
+
+	child = only_child(node);
+	*link = child;
+	node_free(node);
+
+	/* A branch node with only one subtree left is not needed */
+	if (!child && parent && sys_slist_is_empty(&parent->entries)) {
+		*parent_link = only_child(parent);
+		node_free(parent);
+	}
+
+	return 0;
+}
+
+sys_snode_t *net_route_lpm_lookup(struct net_route_lpm *lpm,
+				  const u8_t *addr,
+				  net_route_lpm_cb_t cb,
+				  void *user_data)
+{
+	struct net_route_lpm_node *node = lpm->root;
+	sys_snode_t *found = NULL, *entry;
+
+	while (node && prefix_match(node->prefix, addr, node->len)) {
+		SYS_SLIST_FOR_EACH_NODE(&node->entries, entry) {
+			if (!cb || cb(entry, user_data)) {
+				found = entry;
+				break;
+			}
+		}
+
+		if (node->len == lpm->key_len) {
+			break;
+		}
+
+		node = node->child[get_bit(addr, node->len)];
+	}
+
+	return found;
+}
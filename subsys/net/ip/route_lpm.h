@@ -0,0 +1,146 @@
+/** @file
+ * @brief Longest prefix match trie for the routing tables
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __ROUTE_LPM_H
+#define __ROUTE_LPM_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <misc/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest supported prefix in bytes, i.e. an IPv6 address */
+#define NET_ROUTE_LPM_MAX_KEY_LEN 16
+
+/**
+ * @brief Node of a path compressed binary trie.
+ *
+ * A node either holds the routes for one prefix or it is a branch node
+ * where two subtrees with a common prefix diverge.
+ */
+struct net_route_lpm_node {
+	/** Subtrees where the bit after the prefix is 0 or 1 */
+	struct net_route_lpm_node *child[2];
+
+	/** Routes having exactly this prefix, empty for branch nodes */
+	sys_slist_t entries;
+
+	/** Prefix, the bits after the prefix length are always zero */
+	u8_t prefix[NET_ROUTE_LPM_MAX_KEY_LEN];
+
+	/** Prefix length in bits */
+	u8_t len;
+
+	/** Is this node in use or not */
+	bool is_used;
+};
+
+/**
+ * @brief Longest prefix match trie.
+ */
+struct net_route_lpm {
+	/** Root node of the trie */
+	struct net_route_lpm_node *root;
+
+	/** Node storage */
+	struct net_route_lpm_node *nodes;
+
+	/** Number of nodes in the node storage */
+	u16_t node_count;
+
+	/** Length of the lookup key in bits */
+	u8_t key_len;
+};
+
+/**
+ * @brief Define a longest prefix match trie.
+ *
+ * A path compressed trie with N prefixes never needs more than 2 * N
+ * nodes, so the insertion cannot run out of nodes as long as at most
+ * _max_prefixes distinct prefixes are stored.
+ *
+ * @param _name Name of the trie.
+ * @param _max_prefixes Max number of distinct prefixes in the trie.
+ * @param _key_len Length of the lookup key in bits, 32 for IPv4 and
+ * 128 for IPv6.
+ */
+#define NET_ROUTE_LPM_DEFINE(_name, _max_prefixes, _key_len)		\
+	static struct net_route_lpm_node _name##_nodes[2 * (_max_prefixes)]; \
+	static struct net_route_lpm _name = {				\
+		.nodes = _name##_nodes,					\
+		.node_count = 2 * (_max_prefixes),			\
+		.key_len = (_key_len),					\
+	}
+
+/**
+ * @typedef net_route_lpm_cb_t
+ * @brief Callback used to filter the routes during lookup.
+ *
+ * @param entry Route entry node that was added to the trie.
+ * @param user_data User data given to net_route_lpm_lookup().
+ *
+ * @return True if the route can be used, false otherwise.
+ */
+typedef bool (*net_route_lpm_cb_t)(sys_snode_t *entry, void *user_data);
+
+/**
+ * @brief Add a route entry to the trie.
+ *
+ * Several entries can share the same prefix, for example when the same
+ * prefix is routed via different network interfaces.
+ *
+ * @param lpm Trie to use.
+ * @param prefix Prefix of the route, only the first len bits are used.
+ * @param len Prefix length in bits.
+ * @param entry Route entry node to add.
+ *
+ * @return 0 if ok, <0 if error
+ */
+int net_route_lpm_add(struct net_route_lpm *lpm, const u8_t *prefix,
+		      u8_t len, sys_snode_t *entry);
+
+/**
+ * @brief Remove a route entry from the trie.
+ *
+ * @param lpm Trie to use.
+ * @param prefix Prefix of the route.
+ * @param len Prefix length in bits.
+ * @param entry Route entry node to remove.
+ *
+ * @return 0 if ok, <0 if error
+ */
+int net_route_lpm_del(struct net_route_lpm *lpm, const u8_t *prefix,
+		      u8_t len, sys_snode_t *entry);
+
+/**
+ * @brief Find the route entry with the longest prefix matching an address.
+ *
+ * @param lpm Trie to use.
+ * @param addr Address to look up, key_len bits long.
+ * @param cb Optional callback which can reject route entries.
+ * @param user_data User data passed to the callback.
+ *
+ * @return Route entry node, NULL if no route was found.
+ */
+sys_snode_t *net_route_lpm_lookup(struct net_route_lpm *lpm,
+				  const u8_t *addr,
+				  net_route_lpm_cb_t cb,
+				  void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ROUTE_LPM_H */
@@ -52,7 +52,7 @@ static struct tcp_backlog_entry {
 	u32_t send_ack;
 	struct k_delayed_work ack_timer;
 	struct sockaddr remote;
-	u16_t send_mss;
+	struct net_tcp_options opts;
 } tcp_backlog[CONFIG_NET_TCP_BACKLOG_SIZE];
 
 #if defined(CONFIG_NET_TCP_ACK_TIMEOUT)
@@ -161,10 +161,212 @@ static void net_tcp_trace(struct net_pkt *pkt, struct net_tcp *tcp)
 
 static inline u32_t retry_timeout(const struct net_tcp *tcp)
 {
-	return ((u32_t)1 << tcp->retry_timeout_shift) *
-				CONFIG_NET_TCP_INIT_RETRANSMISSION_TIMEOUT;
+	return min((u64_t)tcp->rto << tcp->retry_timeout_shift,
+		   NET_TCP_MAX_RTO);
 }
 
+/* Update the retransmission timeout from a new round-trip time sample as
+ * described in RFC 6298 chapter 2. The srtt is stored scaled by 8 and
+ * rttvar scaled by 4 so that the calculation can be done with integers.
+ */
+static void tcp_update_rto(struct net_tcp *tcp, u32_t rtt)
+{
+	s32_t delta;
+
+	if (!tcp->srtt) {
+		tcp->srtt = max(rtt, 1) << 3;
+		tcp->rttvar = rtt << 1;
+	} else {
+		delta = rtt - (tcp->srtt >> 3);
+		tcp->srtt += delta;
+
+		if (delta < 0) {
+			delta = -delta;
+		}
+
+		delta -= tcp->rttvar >> 2;
+		tcp->rttvar += delta;
+	}
+
+	/* The clock granularity is 1 ms */
+	tcp->rto = (tcp->srtt >> 3) + max(tcp->rttvar, 1);
+
+	if (tcp->rto < CONFIG_NET_TCP_MIN_RETRANSMISSION_TIMEOUT) {
+		tcp->rto = CONFIG_NET_TCP_MIN_RETRANSMISSION_TIMEOUT;
+	} else if (tcp->rto > NET_TCP_MAX_RTO) {
+		tcp->rto = NET_TCP_MAX_RTO;
+	}
+
+	NET_DBG("[%p] rtt %u srtt %u rttvar %u rto %u", tcp, rtt,
+		tcp->srtt >> 3, tcp->rttvar >> 2, tcp->rto);
+}
+
+static bool tcp_pkt_seq(struct net_pkt *pkt, u32_t *seq, u32_t *seq_len)
+{
+	struct net_tcp_hdr hdr, *tcp_hdr;
+
+	tcp_hdr = net_tcp_get_hdr(pkt, &hdr);
+	if (!tcp_hdr) {
+		return false;
+	}
+
+	*seq = sys_get_be32(tcp_hdr->seq);
+	*seq_len = net_pkt_appdatalen(pkt);
+
+	/* Each of SYN and FIN flags are counted
+	 * as one sequence number.
+	 */
+	if (tcp_hdr->flags & NET_TCP_SYN) {
+		*seq_len += 1;
+	}
+
+	if (tcp_hdr->flags & NET_TCP_FIN) {
+		*seq_len += 1;
+	}
+
+	return true;
+}
+
+static inline bool tcp_pkt_in_flight(struct net_pkt *pkt)
+{
+	return net_pkt_sent(pkt) || net_pkt_queued(pkt);
+}
+
+/* Return the amount of data sent but not yet acknowledged, and the
+ * sequence number following the last sent byte.
+ */
+static u32_t tcp_flight_size(struct net_tcp *tcp, u32_t *snd_nxt)
+{
+	struct net_pkt *pkt;
+	u32_t flight = 0;
+	u32_t seq, seq_len;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		if (!tcp_pkt_in_flight(pkt)) {
+			break;
+		}
+
+		flight += net_pkt_appdatalen(pkt);
+
+		if (snd_nxt && tcp_pkt_seq(pkt, &seq, &seq_len)) {
+			*snd_nxt = seq + seq_len;
+		}
+	}
+
+	return flight;
+}
+
+#if defined(CONFIG_NET_TCP_SACK)
+static inline bool tcp_sack_ok(struct net_tcp *tcp)
+{
+	return tcp->flags & NET_TCP_SACK;
+}
+
+static struct net_pkt *tcp_last_sacked(struct net_tcp *tcp)
+{
+	struct net_pkt *pkt, *last = NULL;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		if (net_pkt_sacked(pkt)) {
+			last = pkt;
+		}
+	}
+
+	return last;
+}
+
+/* Estimate of the data still in the network ("pipe" in RFC 6675). The
+ * segments selectively acknowledged by the peer have left the network,
+ * and during fast recovery so have the segments in front of them that
+ * have not been retransmitted yet.
+ */
+static u32_t tcp_pipe(struct net_tcp *tcp)
+{
+	struct net_pkt *pkt, *last_sacked = NULL;
+	bool lost = false;
+	u32_t pipe = 0;
+	u32_t seq, seq_len;
+
+	if (!tcp_sack_ok(tcp)) {
+		return tcp_flight_size(tcp, NULL);
+	}
+
+	if (tcp->in_recovery) {
+		last_sacked = tcp_last_sacked(tcp);
+		lost = last_sacked != NULL;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		if (!tcp_pkt_in_flight(pkt)) {
+			break;
+		}
+
+		if (pkt == last_sacked) {
+			lost = false;
+		}
+
+		if (net_pkt_sacked(pkt)) {
+			continue;
+		}
+
+		if (lost && tcp_pkt_seq(pkt, &seq, &seq_len) &&
+		    !net_tcp_seq_greater(tcp->high_rxt, seq)) {
+			continue;
+		}
+
+		pipe += net_pkt_appdatalen(pkt);
+	}
+
+	return pipe;
+}
+
+/* Mark the packets covered by the SACK blocks of an incoming ACK */
+static void tcp_sack_update(struct net_tcp *tcp,
+			    const struct net_tcp_options *opts)
+{
+	struct net_pkt *pkt;
+	u32_t seq, seq_len;
+	int i;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		if (!tcp_pkt_in_flight(pkt)) {
+			break;
+		}
+
+		if (net_pkt_sacked(pkt) || !tcp_pkt_seq(pkt, &seq, &seq_len) ||
+		    !seq_len) {
+			continue;
+		}
+
+		for (i = 0; i < opts->num_sack; i++) {
+			if (!net_tcp_seq_greater(opts->sack[i].start, seq) &&
+			    !net_tcp_seq_greater(seq + seq_len,
+						 opts->sack[i].end)) {
+				net_pkt_set_sacked(pkt, true);
+				break;
+			}
+		}
+	}
+}
+
+/* The peer may discard data it has selectively acknowledged (RFC 2018
+ * chapter 8), so the scoreboard is forgotten when the retransmission
+ * timer expires.
+ */
+static void tcp_sack_clear(struct net_tcp *tcp)
+{
+	struct net_pkt *pkt;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		net_pkt_set_sacked(pkt, false);
+	}
+}
+#else
+#define tcp_sack_ok(...) false
+#define tcp_pipe(tcp) tcp_flight_size(tcp, NULL)
+#define tcp_sack_clear(...)
+#endif /* CONFIG_NET_TCP_SACK */
+
 #define is_6lo_technology(pkt)						\
 	(IS_ENABLED(CONFIG_NET_IPV6) &&	net_pkt_family(pkt) == AF_INET6 &&  \
 	 ((IS_ENABLED(CONFIG_NET_L2_BT) &&				\
@@ -205,6 +407,288 @@ static void abort_connection(struct net_tcp *tcp)
 	net_context_unref(ctx);
 }
 
+static int tcp_retransmit(struct net_tcp *tcp, struct net_pkt *pkt)
+{
+	if (net_pkt_sent(pkt)) {
+		do_ref_if_needed(tcp, pkt);
+		net_pkt_set_sent(pkt, false);
+	}
+
+	net_pkt_set_queued(pkt, true);
+
+	/* Karn's algorithm: the ACK of a retransmitted segment cannot be
+	 * used for measuring the round-trip time.
+	 */
+	tcp->rtt_pending = 0;
+
+	if (net_tcp_send_pkt(pkt) < 0 && !is_6lo_technology(pkt)) {
+		NET_DBG("retry %u: [%p] pkt %p send failed",
+			tcp->retry_timeout_shift, tcp, pkt);
+		net_pkt_unref(pkt);
+
+		return -EIO;
+	}
+
+	NET_DBG("retry %u: [%p] sent pkt %p",
+		tcp->retry_timeout_shift, tcp, pkt);
+
+	if (IS_ENABLED(CONFIG_NET_STATISTICS_TCP) &&
+	    !is_6lo_technology(pkt)) {
+		net_stats_update_tcp_seg_rexmit(net_pkt_iface(pkt));
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+#if defined(CONFIG_NET_TCP_CC_CUBIC)
+#define TCP_CC_DEFAULT (&net_tcp_cc_cubic)
+#else
+#define TCP_CC_DEFAULT (&net_tcp_cc_newreno)
+#endif
+
+/* The peer window limits the data in flight anyway, this just keeps
+ * the congestion window from overflowing.
+ */
+#define TCP_CC_MAX_CWND (1 << 30)
+
+static void tcp_cc_init(struct net_tcp *tcp)
+{
+	u32_t mss = tcp->send_mss;
+
+	/* Initial window, RFC 5681 chapter 3.1 */
+	if (mss > 2190) {
+		tcp->cwnd = 2 * mss;
+	} else if (mss > 1095) {
+		tcp->cwnd = 3 * mss;
+	} else {
+		tcp->cwnd = 4 * mss;
+	}
+
+	tcp->ssthresh = UINT32_MAX;
+	tcp->in_recovery = 0;
+	tcp->dup_acks = 0;
+	tcp->cc = TCP_CC_DEFAULT;
+
+	if (tcp->cc->init) {
+		tcp->cc->init(tcp);
+	}
+
+	NET_DBG("[%p] %s cwnd %u", tcp, tcp->cc->name, tcp->cwnd);
+}
+
+static inline u32_t tcp_send_window(struct net_tcp *tcp)
+{
+	return min(tcp->cwnd, tcp->send_wnd);
+}
+
+static void tcp_retransmit_head(struct net_tcp *tcp)
+{
+	struct net_pkt *pkt;
+
+	pkt = SYS_SLIST_PEEK_HEAD_CONTAINER(&tcp->sent_list, pkt, sent_list);
+	if (!pkt) {
+		return;
+	}
+
+	/* Packet is still waiting in the TX queue, no need to resend it */
+	if (net_pkt_queued(pkt) && !is_6lo_technology(pkt)) {
+		return;
+	}
+
+	tcp_retransmit(tcp, pkt);
+}
+
+#if defined(CONFIG_NET_TCP_SACK)
+/* Retransmit the segments that the SACK scoreboard shows as lost, see
+ * RFC 6675 chapter 5. A segment is considered lost when data after it
+ * has been selectively acknowledged. Each hole is retransmitted once per
+ * fast recovery while the pipe allows, except that the first one is sent
+ * unconditionally when the recovery begins.
+ */
+static void tcp_sack_retransmit(struct net_tcp *tcp, bool force)
+{
+	struct net_pkt *pkt, *last_sacked;
+	u32_t seq, seq_len;
+	u32_t pipe;
+
+	last_sacked = tcp_last_sacked(tcp);
+	if (!last_sacked) {
+		if (force) {
+			tcp_retransmit_head(tcp);
+		}
+
+		return;
+	}
+
+	pipe = tcp_pipe(tcp);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
+		if (pkt == last_sacked) {
+			break;
+		}
+
+		if (net_pkt_sacked(pkt) || !tcp_pkt_seq(pkt, &seq, &seq_len) ||
+		    net_tcp_seq_greater(tcp->high_rxt, seq)) {
+			continue;
+		}
+
+		if (!force && pipe + net_pkt_appdatalen(pkt) > tcp->cwnd) {
+			break;
+		}
+
+		/* Packet is still waiting in the TX queue */
+		if (net_pkt_queued(pkt) && !is_6lo_technology(pkt)) {
+			continue;
+		}
+
+		tcp->high_rxt = seq + seq_len;
+
+		if (tcp_retransmit(tcp, pkt) < 0) {
+			break;
+		}
+
+		pipe += net_pkt_appdatalen(pkt);
+		force = false;
+	}
+}
+#else
+#define tcp_sack_retransmit(...)
+#endif /* CONFIG_NET_TCP_SACK */
+
+/* New data was acknowledged, RFC 5681 chapter 3.1 and RFC 6582
+ * chapter 3.2 step 3.
+ */
+static void tcp_cc_new_ack(struct net_tcp *tcp, u32_t ack, u32_t acked)
+{
+	u32_t mss = tcp->send_mss;
+
+	tcp->dup_acks = 0;
+
+	if (!tcp->in_recovery) {
+		tcp->cc->ack(tcp, acked);
+		tcp->cwnd = min(tcp->cwnd, TCP_CC_MAX_CWND);
+		return;
+	}
+
+	if (!net_tcp_seq_greater(tcp->recover, ack)) {
+		/* Full acknowledgment, exit fast recovery */
+		tcp->cwnd = min(tcp->ssthresh,
+				max(tcp_flight_size(tcp, NULL), mss) + mss);
+		tcp->in_recovery = 0;
+
+		NET_DBG("[%p] recovered, cwnd %u", tcp, tcp->cwnd);
+		return;
+	}
+
+	/* Partial acknowledgment. With SACK the window is kept at ssthresh
+	 * and the next holes are retransmitted as the pipe drains.
+	 */
+	if (tcp_sack_ok(tcp)) {
+		tcp_sack_retransmit(tcp, false);
+		return;
+	}
+
+	/* Otherwise the first unacknowledged segment was lost too.
+	 * Deflate the window by the amount of new data acknowledged and
+	 * add back one MSS.
+	 */
+	tcp_retransmit_head(tcp);
+
+	tcp->cwnd = tcp->cwnd > acked ? tcp->cwnd - acked : 0;
+	if (acked >= mss) {
+		tcp->cwnd += mss;
+	}
+
+	tcp->cwnd = max(tcp->cwnd, mss);
+}
+
+/* Duplicate ACK received, RFC 5681 chapter 3.2 */
+static void tcp_cc_dup_ack(struct net_tcp *tcp)
+{
+	u32_t snd_nxt = tcp->send_seq;
+	u32_t flight;
+
+	if (tcp->in_recovery) {
+		/* With SACK the scoreboard tells what has left the network,
+		 * otherwise each duplicate ACK means that a segment has left
+		 * the network, so inflate the window accordingly.
+		 */
+		if (tcp_sack_ok(tcp)) {
+			tcp_sack_retransmit(tcp, false);
+		} else {
+			tcp->cwnd = min(tcp->cwnd + tcp->send_mss,
+					TCP_CC_MAX_CWND);
+		}
+
+		return;
+	}
+
+	if (++tcp->dup_acks < NET_TCP_DUP_ACK_THRESHOLD) {
+		return;
+	}
+
+	flight = tcp_flight_size(tcp, &snd_nxt);
+
+	tcp->ssthresh = tcp->cc->ssthresh(tcp, flight);
+	tcp->recover = snd_nxt;
+	tcp->in_recovery = 1;
+	tcp->dup_acks = 0;
+
+	NET_DBG("[%p] fast retransmit, flight %u ssthresh %u", tcp, flight,
+		tcp->ssthresh);
+
+#if defined(CONFIG_NET_TCP_SACK)
+	if (tcp_sack_ok(tcp)) {
+		struct net_pkt *pkt;
+		u32_t seq_len;
+
+		pkt = SYS_SLIST_PEEK_HEAD_CONTAINER(&tcp->sent_list, pkt,
+						    sent_list);
+		if (pkt) {
+			tcp_pkt_seq(pkt, &tcp->high_rxt, &seq_len);
+		}
+
+		tcp->cwnd = tcp->ssthresh;
+		tcp_sack_retransmit(tcp, true);
+		return;
+	}
+#endif
+
+	tcp_retransmit_head(tcp);
+
+	tcp->cwnd = tcp->ssthresh + NET_TCP_DUP_ACK_THRESHOLD * tcp->send_mss;
+}
+
+/* Retransmission timer expired, RFC 5681 chapter 3.1 equation (4) */
+static void tcp_cc_timeout(struct net_tcp *tcp)
+{
+	/* The threshold is held constant when the same segment is
+	 * retransmitted again.
+	 */
+	if (tcp->retry_timeout_shift == 1) {
+		tcp->ssthresh = tcp->cc->ssthresh(tcp,
+						  tcp_flight_size(tcp, NULL));
+	}
+
+	tcp->cwnd = tcp->send_mss;
+	tcp->in_recovery = 0;
+	tcp->dup_acks = 0;
+
+	tcp_sack_clear(tcp);
+}
+#else
+#define tcp_cc_init(...)
+#define tcp_cc_new_ack(...)
+#define tcp_cc_dup_ack(...)
+#define tcp_cc_timeout(...)
+
+static inline u32_t tcp_send_window(struct net_tcp *tcp)
+{
+	return tcp->send_wnd;
+}
+#endif /* CONFIG_NET_TCP_CONGESTION_CONTROL */
+
 static void tcp_retry_expired(struct k_work *work)
 {
 	struct net_tcp *tcp = CONTAINER_OF(work, struct net_tcp, retry_timer);
@@ -223,29 +707,12 @@ static void tcp_retry_expired(struct k_work *work)
 
 		k_delayed_work_submit(&tcp->retry_timer, retry_timeout(tcp));
 
+		tcp_cc_timeout(tcp);
+
 		pkt = CONTAINER_OF(sys_slist_peek_head(&tcp->sent_list),
 				   struct net_pkt, sent_list);
 
-		if (net_pkt_sent(pkt)) {
-			do_ref_if_needed(tcp, pkt);
-			net_pkt_set_sent(pkt, false);
-		}
-
-		net_pkt_set_queued(pkt, true);
-
-		if (net_tcp_send_pkt(pkt) < 0 && !is_6lo_technology(pkt)) {
-			NET_DBG("retry %u: [%p] pkt %p send failed",
-				tcp->retry_timeout_shift, tcp, pkt);
-			net_pkt_unref(pkt);
-		} else {
-			NET_DBG("retry %u: [%p] sent pkt %p",
-				tcp->retry_timeout_shift, tcp, pkt);
-			if (IS_ENABLED(CONFIG_NET_STATISTICS_TCP) &&
-			    !is_6lo_technology(pkt)) {
-				net_stats_update_tcp_seg_rexmit(
-							net_pkt_iface(pkt));
-			}
-		}
+		tcp_retransmit(tcp, pkt);
 	} else if (CONFIG_NET_TCP_TIME_WAIT_DELAY != 0) {
 		if (tcp->fin_sent && tcp->fin_rcvd) {
 			NET_DBG("[%p] Closing connection (context %p)",
@@ -279,8 +746,11 @@ struct net_tcp *net_tcp_alloc(struct net_context *context)
 	tcp_context[i].context = context;
 
 	tcp_context[i].send_seq = tcp_init_isn();
-	tcp_context[i].recv_wnd = min(NET_TCP_MAX_WIN, NET_TCP_BUF_MAX_LEN);
+	tcp_context[i].recv_wnd = CONFIG_NET_TCP_RECV_WINDOW_SIZE;
 	tcp_context[i].send_mss = NET_TCP_DEFAULT_MSS;
+	tcp_context[i].rto = CONFIG_NET_TCP_INIT_RETRANSMISSION_TIMEOUT;
+
+	tcp_cc_init(&tcp_context[i]);
 
 	tcp_context[i].accept_cb = NULL;
 
@@ -326,6 +796,14 @@ int net_tcp_release(struct net_tcp *tcp)
 		net_pkt_unref(pkt);
 	}
 
+#if defined(CONFIG_NET_TCP_SACK)
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&tcp->ooo_list, pkt, tmp,
+					  sent_list) {
+		sys_slist_remove(&tcp->ooo_list, NULL, &pkt->sent_list);
+		net_pkt_unref(pkt);
+	}
+#endif
+
 	retry_timer_cancel(tcp);
 	k_sem_reset(&tcp->connect_wait);
 
@@ -487,29 +965,149 @@ static int prepare_segment(struct net_tcp *tcp,
 		net_pkt_frag_add(pkt, tail);
 	}
 
-	status = finalize_segment(context, pkt);
-	if (status < 0) {
-		if (pkt_allocated) {
-			net_pkt_unref(pkt);
+	status = finalize_segment(context, pkt);
+	if (status < 0) {
+		if (pkt_allocated) {
+			net_pkt_unref(pkt);
+		}
+
+		return status;
+	}
+
+	net_tcp_trace(pkt, tcp);
+
+	*out_pkt = pkt;
+
+	return 0;
+
+fail:
+	if (pkt_allocated) {
+		net_pkt_unref(pkt);
+	} else {
+		pkt->frags = tail;
+	}
+
+	return status;
+}
+
+#if defined(CONFIG_NET_TCP_WINDOW_SCALE)
+/* Smallest shift that makes the receive window fit into the window field */
+static u8_t tcp_recv_wscale(void)
+{
+	u8_t shift = 0;
+
+	while ((CONFIG_NET_TCP_RECV_WINDOW_SIZE >> shift) > UINT16_MAX &&
+	       shift < NET_TCP_MAX_WINDOW_SCALE) {
+		shift++;
+	}
+
+	return shift;
+}
+#endif
+
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+/* The timestamps option is sent aligned to 4 bytes, prefixed by two NOPs.
+ * The clock used for the timestamps is the uptime in milliseconds.
+ */
+static u8_t tcp_put_ts_opt(u32_t tsecr, u8_t *options)
+{
+	options[0] = NET_TCP_NOP_OPT;
+	options[1] = NET_TCP_NOP_OPT;
+	options[2] = NET_TCP_TIMESTAMP_OPT;
+	options[3] = NET_TCP_TIMESTAMP_SIZE;
+	sys_put_be32(k_uptime_get_32(), &options[4]);
+	sys_put_be32(tsecr, &options[8]);
+
+	return NET_TCP_TIMESTAMP_ALIGNED_SIZE;
+}
+#endif
+
+#if defined(CONFIG_NET_TCP_SACK)
+/* Describe the out-of-order data as SACK blocks. The block containing the
+ * most recently received segment is reported first (RFC 2018 chapter 4).
+ */
+static u8_t tcp_put_sack_opt(struct net_tcp *tcp, u8_t *options,
+			     u8_t max_len)
+{
+	struct net_tcp_sack_block blocks[NET_TCP_MAX_SACK_BLOCKS];
+	int num = 0, first = 0, max_blocks, i, j;
+	struct net_pkt *pkt;
+	u32_t seq, seq_len;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->ooo_list, pkt, sent_list) {
+		if (!tcp_pkt_seq(pkt, &seq, &seq_len)) {
+			continue;
+		}
+
+		if (num && blocks[num - 1].end == seq) {
+			blocks[num - 1].end = seq + seq_len;
+		} else if (num < ARRAY_SIZE(blocks)) {
+			blocks[num].start = seq;
+			blocks[num].end = seq + seq_len;
+			num++;
+		} else {
+			break;
+		}
+
+		if (seq == tcp->ooo_last_seq) {
+			first = num - 1;
+		}
+	}
+
+	max_blocks = (max_len - 4) / NET_TCP_SACK_BLOCK_SIZE;
+	if (!num || max_blocks <= 0) {
+		return 0;
+	}
+
+	/* Most recent block first, then the rest in sequence order */
+	for (i = 0, j = -1; i < min(num, max_blocks); i++, j++) {
+		struct net_tcp_sack_block *block;
+
+		if (j == first) {
+			j++;
 		}
 
-		return status;
+		block = &blocks[i ? j : first];
+
+		sys_put_be32(block->start,
+			     &options[4 + i * NET_TCP_SACK_BLOCK_SIZE]);
+		sys_put_be32(block->end,
+			     &options[8 + i * NET_TCP_SACK_BLOCK_SIZE]);
 	}
 
-	net_tcp_trace(pkt, tcp);
+	num = i;
 
-	*out_pkt = pkt;
+	options[0] = NET_TCP_NOP_OPT;
+	options[1] = NET_TCP_NOP_OPT;
+	options[2] = NET_TCP_SACK_OPT;
+	options[3] = 2 + num * NET_TCP_SACK_BLOCK_SIZE;
 
-	return 0;
+	return 4 + num * NET_TCP_SACK_BLOCK_SIZE;
+}
+#endif
 
-fail:
-	if (pkt_allocated) {
-		net_pkt_unref(pkt);
-	} else {
-		pkt->frags = tail;
+/* Options of the segments sent once the connection is established: the
+ * timestamps option, and SACK blocks in segments carrying no data.
+ */
+static u8_t tcp_set_opts(struct net_tcp *tcp, bool ack_only, u8_t *options)
+{
+	u8_t optlen = 0;
+
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+	if (tcp->flags & NET_TCP_TS) {
+		optlen += tcp_put_ts_opt(tcp->ts_recent, options);
+	}
+#endif
+
+#if defined(CONFIG_NET_TCP_SACK)
+	if (ack_only && tcp_sack_ok(tcp) &&
+	    !sys_slist_is_empty(&tcp->ooo_list)) {
+		optlen += tcp_put_sack_opt(tcp, options + optlen,
+					   NET_TCP_MAX_OPT_SIZE - optlen);
 	}
+#endif
 
-	return status;
+	return optlen;
 }
 
 u32_t net_tcp_get_recv_wnd(const struct net_tcp *tcp)
@@ -523,8 +1121,9 @@ int net_tcp_prepare_segment(struct net_tcp *tcp, u8_t flags,
 			    const struct sockaddr *remote,
 			    struct net_pkt **send_pkt)
 {
+	u8_t opts[NET_TCP_MAX_OPT_SIZE];
 	u32_t seq;
-	u16_t wnd;
+	u32_t wnd;
 	struct tcp_segment segment = { 0 };
 	int status;
 
@@ -572,12 +1171,22 @@ int net_tcp_prepare_segment(struct net_tcp *tcp, u8_t flags,
 
 	wnd = net_tcp_get_recv_wnd(tcp);
 
+	/* The window field of SYN segments is never scaled */
+	if (!(flags & NET_TCP_SYN)) {
+		wnd >>= tcp->recv_wscale;
+
+		if (!options) {
+			optlen = tcp_set_opts(tcp, *send_pkt == NULL, opts);
+			options = opts;
+		}
+	}
+
 	segment.src_addr = (struct sockaddr_ptr *)local;
 	segment.dst_addr = remote;
 	segment.seq = tcp->send_seq;
 	segment.ack = tcp->send_ack;
 	segment.flags = flags;
-	segment.wnd = wnd;
+	segment.wnd = min(wnd, UINT16_MAX);
 	segment.options = options;
 	segment.optlen = optlen;
 
@@ -663,14 +1272,21 @@ u16_t net_tcp_get_recv_mss(const struct net_tcp *tcp)
 	return 0;
 }
 
-static void net_tcp_set_syn_opt(struct net_tcp *tcp, u8_t *options,
-				u8_t *optionlen)
+/* Set the options of a SYN segment. When replying with SYN-ACK, the
+ * options received in the SYN are given in syn and only the options
+ * that the peer offered are included.
+ */
+static void net_tcp_set_syn_opt(struct net_tcp *tcp,
+				const struct net_tcp_options *syn,
+				u8_t *options, u8_t *optionlen)
 {
 	u32_t recv_mss;
 
 	*optionlen = 0;
 
-	if (!(tcp->flags & NET_TCP_RECV_MSS_SET)) {
+	if (syn) {
+		recv_mss = net_tcp_get_recv_mss(tcp);
+	} else if (!(tcp->flags & NET_TCP_RECV_MSS_SET)) {
 		recv_mss = net_tcp_get_recv_mss(tcp);
 		tcp->flags |= NET_TCP_RECV_MSS_SET;
 	} else {
@@ -682,20 +1298,95 @@ static void net_tcp_set_syn_opt(struct net_tcp *tcp, u8_t *options,
 		      (u32_t *)(options + *optionlen));
 
 	*optionlen += NET_TCP_MSS_SIZE;
+
+#if defined(CONFIG_NET_TCP_WINDOW_SCALE)
+	if (!syn || syn->wscale_ok) {
+		options[(*optionlen)++] = NET_TCP_NOP_OPT;
+		options[(*optionlen)++] = NET_TCP_WINDOW_SCALE_OPT;
+		options[(*optionlen)++] = NET_TCP_WINDOW_SCALE_SIZE;
+		options[(*optionlen)++] = tcp_recv_wscale();
+	}
+#endif
+
+#if defined(CONFIG_NET_TCP_SACK)
+	if (!syn || syn->sack_perm) {
+		options[(*optionlen)++] = NET_TCP_NOP_OPT;
+		options[(*optionlen)++] = NET_TCP_NOP_OPT;
+		options[(*optionlen)++] = NET_TCP_SACK_PERM_OPT;
+		options[(*optionlen)++] = NET_TCP_SACK_PERM_SIZE;
+	}
+#endif
+
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+	if (!syn || syn->ts_ok) {
+		*optionlen += tcp_put_ts_opt(syn ? syn->tsval : 0,
+					     options + *optionlen);
+	}
+#endif
+}
+
+/* Enable the options that both ends offered during the handshake */
+static void tcp_set_peer_opts(struct net_tcp *tcp,
+			      const struct net_tcp_options *opts)
+{
+	tcp->send_mss = opts->mss;
+
+#if defined(CONFIG_NET_TCP_WINDOW_SCALE)
+	if (opts->wscale_ok) {
+		tcp->flags |= NET_TCP_WSCALE;
+		tcp->send_wscale = min(opts->wscale, NET_TCP_MAX_WINDOW_SCALE);
+		tcp->recv_wscale = tcp_recv_wscale();
+	}
+#endif
+
+	if (!(tcp->flags & NET_TCP_WSCALE)) {
+		tcp->recv_wnd = min(tcp->recv_wnd, UINT16_MAX);
+	}
+
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+	if (opts->ts_ok) {
+		tcp->flags |= NET_TCP_TS;
+		tcp->ts_recent = opts->tsval;
+	}
+#endif
+
+#if defined(CONFIG_NET_TCP_SACK)
+	if (opts->sack_perm) {
+		tcp->flags |= NET_TCP_SACK;
+	}
+#endif
+
+	NET_DBG("[%p] mss %u wscale %u/%u%s%s", tcp, tcp->send_mss,
+		tcp->send_wscale, tcp->recv_wscale,
+		tcp->flags & NET_TCP_TS ? " ts" : "",
+		tcp->flags & NET_TCP_SACK ? " sack" : "");
+}
+
+/* Window advertised in a received segment, SYN segments are not scaled */
+static inline u32_t tcp_peer_wnd(struct net_tcp *tcp,
+				 struct net_tcp_hdr *tcp_hdr)
+{
+	if (tcp_hdr->flags & NET_TCP_SYN) {
+		return sys_get_be16(tcp_hdr->wnd);
+	}
+
+	return (u32_t)sys_get_be16(tcp_hdr->wnd) << tcp->send_wscale;
 }
 
 int net_tcp_prepare_ack(struct net_tcp *tcp, const struct sockaddr *remote,
 			struct net_pkt **pkt)
 {
+	struct net_tcp_options syn = { 0 };
 	u8_t options[NET_TCP_MAX_OPT_SIZE];
 	u8_t optionlen;
 
 	switch (net_tcp_get_state(tcp)) {
 	case NET_TCP_SYN_RCVD:
 		/* In the SYN_RCVD state acknowledgment must be with the
-		 * SYN flag.
+		 * SYN flag. The options of the SYN are not known here, so
+		 * only the MSS is sent.
 		 */
-		net_tcp_set_syn_opt(tcp, options, &optionlen);
+		net_tcp_set_syn_opt(tcp, &syn, options, &optionlen);
 
 		return net_tcp_prepare_segment(tcp, NET_TCP_SYN | NET_TCP_ACK,
 					       options, optionlen, NULL, remote,
@@ -862,11 +1553,60 @@ static int net_tcp_queue_pkt(struct net_context *context, struct net_pkt *pkt)
 	return 0;
 }
 
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+/* Refresh the timestamps option of a segment that is about to be sent,
+ * as the segment might have been created a while ago or be a
+ * retransmission. The option is always the first one, after two NOPs.
+ */
+static bool tcp_update_ts_opt(struct net_tcp *tcp, struct net_pkt *pkt,
+			      struct net_tcp_hdr *tcp_hdr)
+{
+	u16_t pos = net_pkt_ip_hdr_len(pkt) + net_pkt_ipv6_ext_len(pkt) +
+		sizeof(struct net_tcp_hdr) + 2;
+	u8_t ts[2 * sizeof(u32_t)], old_ts[2 * sizeof(u32_t)];
+	struct net_buf *frag;
+	u16_t ts_pos;
+	u8_t kind;
+	int i;
+
+	if (NET_TCP_HDR_LEN(tcp_hdr) < sizeof(struct net_tcp_hdr) +
+	    NET_TCP_TIMESTAMP_ALIGNED_SIZE) {
+		return false;
+	}
+
+	frag = net_frag_read_u8(pkt->frags, pos, &pos, &kind);
+	if (!frag || kind != NET_TCP_TIMESTAMP_OPT) {
+		return false;
+	}
+
+	/* Skip the length field */
+	if (!net_frag_read(frag, pos + 1, &ts_pos, sizeof(old_ts), old_ts) &&
+	    ts_pos == 0xffff) {
+		return false;
+	}
+
+	sys_put_be32(k_uptime_get_32(), ts);
+	sys_put_be32(tcp->ts_recent, ts + sizeof(u32_t));
+
+	net_pkt_write(pkt, frag, pos + 1, &pos, sizeof(ts), ts,
+		      ALLOC_TIMEOUT);
+
+	/* The option values are at an even offset of the header */
+	for (i = 0; i < sizeof(ts); i += sizeof(u16_t)) {
+		tcp_hdr->chksum = net_chksum_update_u16(
+			tcp_hdr->chksum, UNALIGNED_GET((u16_t *)&old_ts[i]),
+			UNALIGNED_GET((u16_t *)&ts[i]));
+	}
+
+	return true;
+}
+#endif
+
 int net_tcp_send_pkt(struct net_pkt *pkt)
 {
 	struct net_context *ctx = net_pkt_context(pkt);
 	struct net_tcp_hdr hdr, *tcp_hdr;
-	bool calc_chksum = false;
+	u32_t old_ack;
 
 	tcp_hdr = net_tcp_get_hdr(pkt, &hdr);
 	if (!tcp_hdr) {
@@ -874,9 +1614,16 @@ int net_tcp_send_pkt(struct net_pkt *pkt)
 		return -EMSGSIZE;
 	}
 
-	if (sys_get_be32(tcp_hdr->ack) != ctx->tcp->send_ack) {
+	/* The checksum was calculated when the segment was prepared, so
+	 * only the changed header fields are patched into it here instead
+	 * of summing the whole segment again.
+	 */
+	old_ack = sys_get_be32(tcp_hdr->ack);
+	if (old_ack != ctx->tcp->send_ack) {
 		sys_put_be32(ctx->tcp->send_ack, tcp_hdr->ack);
-		calc_chksum = true;
+		tcp_hdr->chksum = net_chksum_update_u32(tcp_hdr->chksum,
+							htonl(old_ack),
+							htonl(ctx->tcp->send_ack));
 	}
 
 	/* The data stream code always sets this flag, because
@@ -886,13 +1633,20 @@ int net_tcp_send_pkt(struct net_pkt *pkt)
 	 */
 	if (ctx->tcp->sent_ack != ctx->tcp->send_ack &&
 		(tcp_hdr->flags & NET_TCP_ACK) == 0) {
+		u16_t old_word = (tcp_hdr->offset << 8) | tcp_hdr->flags;
+
 		tcp_hdr->flags |= NET_TCP_ACK;
-		calc_chksum = true;
+		tcp_hdr->chksum = net_chksum_update_u16(
+			tcp_hdr->chksum, htons(old_word),
+			htons(old_word | NET_TCP_ACK));
 	}
 
-	if (calc_chksum) {
-		net_tcp_set_chksum(pkt, pkt->frags);
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+	if ((ctx->tcp->flags & NET_TCP_TS) &&
+	    !(tcp_hdr->flags & NET_TCP_SYN)) {
+		tcp_update_ts_opt(ctx->tcp, pkt, tcp_hdr);
 	}
+#endif
 
 	if (tcp_hdr->flags & NET_TCP_FIN) {
 		ctx->tcp->fin_sent = 1;
@@ -976,38 +1730,68 @@ static void restart_timer(struct net_tcp *tcp)
 	}
 }
 
-int net_tcp_send_data(struct net_context *context, net_context_send_cb_t cb,
-		      void *token, void *user_data)
+static void tcp_rtt_start(struct net_tcp *tcp, struct net_pkt *pkt)
+{
+	u32_t seq, seq_len;
+
+	/* With timestamps every ACK gives a measurement */
+	if (tcp->rtt_pending || (tcp->flags & NET_TCP_TS) ||
+	    !tcp_pkt_seq(pkt, &seq, &seq_len)) {
+		return;
+	}
+
+	tcp->rtt_seq = seq + seq_len;
+	tcp->rtt_start = k_uptime_get_32();
+	tcp->rtt_pending = 1;
+}
+
+/* Send the queued packets that fit into the send window. At least one
+ * segment is always allowed to be in flight, so that a zero window gets
+ * probed by the retransmission timer.
+ */
+static void tcp_send_queued(struct net_tcp *tcp)
 {
+	u32_t wnd = tcp_send_window(tcp);
+	u32_t flight = tcp_pipe(tcp);
 	struct net_pkt *pkt;
+	int ret;
 
-	/* For now, just send all queued data synchronously.  Need to
-	 * add window handling and retry/ACK logic.
-	 */
-	SYS_SLIST_FOR_EACH_CONTAINER(&context->tcp->sent_list, pkt, sent_list) {
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->sent_list, pkt, sent_list) {
 		/* Do not resend packets that were sent by expire timer */
-		if (net_pkt_queued(pkt)) {
-			NET_DBG("[%p] Skipping pkt %p because it was already "
-				"sent.", context->tcp, pkt);
+		if (tcp_pkt_in_flight(pkt)) {
 			continue;
 		}
 
-		if (!net_pkt_sent(pkt)) {
-			int ret;
+		if (flight && flight + net_pkt_appdatalen(pkt) > wnd) {
+			NET_DBG("[%p] Window full (%u bytes in flight)",
+				tcp, flight);
+			break;
+		}
 
-			NET_DBG("[%p] Sending pkt %p (%zd bytes)", context->tcp,
-				pkt, net_pkt_get_len(pkt));
+		NET_DBG("[%p] Sending pkt %p (%zd bytes)", tcp,
+			pkt, net_pkt_get_len(pkt));
 
-			ret = net_tcp_send_pkt(pkt);
-			if (ret < 0 && !is_6lo_technology(pkt)) {
-				NET_DBG("[%p] pkt %p not sent (%d)",
-					context->tcp, pkt, ret);
-				net_pkt_unref(pkt);
-			}
+		tcp_rtt_start(tcp, pkt);
 
-			net_pkt_set_queued(pkt, true);
+		ret = net_tcp_send_pkt(pkt);
+		if (ret < 0 && !is_6lo_technology(pkt)) {
+			NET_DBG("[%p] pkt %p not sent (%d)", tcp, pkt, ret);
+			net_pkt_unref(pkt);
 		}
+
+		net_pkt_set_queued(pkt, true);
+
+		flight += net_pkt_appdatalen(pkt);
 	}
+}
+
+int net_tcp_send_data(struct net_context *context, net_context_send_cb_t cb,
+		      void *token, void *user_data)
+{
+	/* Send as much of the queued data as the window allows, the
+	 * rest is sent when ACKs arrive.
+	 */
+	tcp_send_queued(context->tcp);
 
 	/* Just make the callback synchronously even if it didn't
 	 * go over the wire.  In theory it would be nice to track
@@ -1022,13 +1806,15 @@ int net_tcp_send_data(struct net_context *context, net_context_send_cb_t cb,
 	return 0;
 }
 
-bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
+static bool tcp_ack_received(struct net_context *ctx, u32_t ack,
+			     const struct net_tcp_options *opts)
 {
 	struct net_tcp *tcp = ctx->tcp;
 	sys_slist_t *list = &ctx->tcp->sent_list;
 	sys_snode_t *head;
 	struct net_pkt *pkt;
 	bool valid_ack = false;
+	u32_t acked = 0;
 
 	if (net_tcp_seq_greater(ack, ctx->tcp->send_seq)) {
 		NET_ERR("ctx %p: ACK for unsent data", ctx);
@@ -1049,7 +1835,7 @@ bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
 		pkt = CONTAINER_OF(head, struct net_pkt, sent_list);
 
 		tcp_hdr = net_tcp_get_hdr(pkt, &hdr);
-		if (!tcp_hdr) {
+		if (!tcp_hdr || !tcp_pkt_seq(pkt, &last_seq, &seq_len)) {
 			/* The pkt does not contain TCP header, this should
 			 * not happen.
 			 */
@@ -1059,20 +1845,8 @@ bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
 			continue;
 		}
 
-		seq_len = net_pkt_appdatalen(pkt);
-
-		/* Each of SYN and FIN flags are counted
-		 * as one sequence number.
-		 */
-		if (tcp_hdr->flags & NET_TCP_SYN) {
-			seq_len += 1;
-		}
-		if (tcp_hdr->flags & NET_TCP_FIN) {
-			seq_len += 1;
-		}
-
 		/* Last sequence number in this packet. */
-		last_seq = sys_get_be32(tcp_hdr->seq) + seq_len - 1;
+		last_seq += seq_len - 1;
 
 		/* Ack number should be strictly greater to acknowleged numbers
 		 * below it. For example, ack no. 10 acknowledges all numbers up
@@ -1095,6 +1869,22 @@ bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
 		sys_slist_remove(list, NULL, head);
 		net_pkt_unref(pkt);
 		valid_ack = true;
+		acked += seq_len;
+	}
+
+#if defined(CONFIG_NET_TCP_SACK)
+	if (opts->num_sack && tcp_sack_ok(tcp)) {
+		tcp_sack_update(tcp, opts);
+	}
+#endif
+
+	if (valid_ack && opts->ts_ok && opts->tsecr) {
+		/* RFC 7323 chapter 4.1 */
+		tcp_update_rto(tcp, k_uptime_get_32() - opts->tsecr);
+	} else if (valid_ack && tcp->rtt_pending &&
+		   !net_tcp_seq_greater(tcp->rtt_seq, ack)) {
+		tcp->rtt_pending = 0;
+		tcp_update_rto(tcp, k_uptime_get_32() - tcp->rtt_start);
 	}
 
 	/* Restart the timer (if needed) on a valid inbound ACK.  This isn't
@@ -1105,11 +1895,43 @@ bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
 	 */
 	if (valid_ack) {
 		restart_timer(ctx->tcp);
+		tcp_cc_new_ack(tcp, ack, acked);
 	}
 
 	return true;
 }
 
+bool net_tcp_ack_received(struct net_context *ctx, u32_t ack)
+{
+	struct net_tcp_options opts = { 0 };
+
+	return tcp_ack_received(ctx, ack, &opts);
+}
+
+/* RFC 5681 chapter 2: an ACK is a duplicate if it carries no data and
+ * no SYN or FIN, does not change the advertised window, acknowledges
+ * the oldest outstanding segment and there is data in flight.
+ */
+static bool tcp_is_dup_ack(struct net_tcp *tcp, struct net_tcp_hdr *tcp_hdr,
+			   u16_t data_len)
+{
+	struct net_pkt *pkt;
+	u32_t seq, seq_len;
+
+	if (data_len || (tcp_hdr->flags & (NET_TCP_SYN | NET_TCP_FIN)) ||
+	    tcp_peer_wnd(tcp, tcp_hdr) != tcp->send_wnd) {
+		return false;
+	}
+
+	pkt = SYS_SLIST_PEEK_HEAD_CONTAINER(&tcp->sent_list, pkt, sent_list);
+	if (!pkt || !tcp_pkt_in_flight(pkt) ||
+	    !tcp_pkt_seq(pkt, &seq, &seq_len)) {
+		return false;
+	}
+
+	return sys_get_be32(tcp_hdr->ack) == seq;
+}
+
 void net_tcp_init(void)
 {
 }
@@ -1392,6 +2214,7 @@ int net_tcp_parse_opts(struct net_pkt *pkt, int opt_totlen,
 		  + net_pkt_ipv6_ext_len(pkt)
 		  + sizeof(struct net_tcp_hdr);
 	u8_t opt, optlen;
+	int i;
 
 	/* TODO: this should be done for each TCP pkt, on reception */
 	if (pos + opt_totlen > net_pkt_get_len(pkt)) {
@@ -1443,6 +2266,43 @@ int net_tcp_parse_opts(struct net_pkt *pkt, int opt_totlen,
 			frag = net_frag_read_be16(frag, pos, &pos,
 						  &opts->mss);
 			break;
+		case NET_TCP_WINDOW_SCALE_OPT:
+			if (optlen != 1) {
+				goto error;
+			}
+			frag = net_frag_read_u8(frag, pos, &pos,
+						&opts->wscale);
+			opts->wscale_ok = 1;
+			break;
+		case NET_TCP_SACK_PERM_OPT:
+			if (optlen != 0) {
+				goto error;
+			}
+			opts->sack_perm = 1;
+			break;
+		case NET_TCP_SACK_OPT:
+			if (!optlen || optlen % NET_TCP_SACK_BLOCK_SIZE ||
+			    optlen > sizeof(opts->sack)) {
+				goto error;
+			}
+			opts->num_sack = optlen / NET_TCP_SACK_BLOCK_SIZE;
+			for (i = 0; i < opts->num_sack; i++) {
+				frag = net_frag_read_be32(frag, pos, &pos,
+							&opts->sack[i].start);
+				frag = net_frag_read_be32(frag, pos, &pos,
+							&opts->sack[i].end);
+			}
+			break;
+		case NET_TCP_TIMESTAMP_OPT:
+			if (optlen != 8) {
+				goto error;
+			}
+			frag = net_frag_read_be32(frag, pos, &pos,
+						  &opts->tsval);
+			frag = net_frag_read_be32(frag, pos, &pos,
+						  &opts->tsecr);
+			opts->ts_ok = 1;
+			break;
 		default:
 			frag = net_frag_skip(frag, pos, &pos, optlen);
 			break;
@@ -1548,7 +2408,8 @@ int net_tcp_update_recv_wnd(struct net_context *context, s32_t delta)
 	}
 
 	new_win = context->tcp->recv_wnd + delta;
-	if (new_win < 0 || new_win > UINT16_MAX) {
+	if (new_win < 0 ||
+	    new_win > ((s32_t)UINT16_MAX << context->tcp->recv_wscale)) {
 		return -EINVAL;
 	}
 
@@ -1641,7 +2502,7 @@ static int tcp_backlog_find(struct net_pkt *pkt, int *empty_slot)
 }
 
 static int tcp_backlog_syn(struct net_pkt *pkt, struct net_context *context,
-			   u16_t send_mss)
+			   const struct net_tcp_options *opts)
 {
 	int empty_slot = -1;
 	int ret;
@@ -1667,7 +2528,7 @@ static int tcp_backlog_syn(struct net_pkt *pkt, struct net_context *context,
 
 	tcp_backlog[empty_slot].send_seq = context->tcp->send_seq;
 	tcp_backlog[empty_slot].send_ack = context->tcp->send_ack;
-	tcp_backlog[empty_slot].send_mss = send_mss;
+	tcp_backlog[empty_slot].opts = *opts;
 
 	k_delayed_work_init(&tcp_backlog[empty_slot].ack_timer,
 			    backlog_ack_timeout);
@@ -1701,7 +2562,7 @@ static int tcp_backlog_ack(struct net_pkt *pkt, struct net_context *context)
 		sizeof(struct sockaddr));
 	context->tcp->send_seq = tcp_backlog[r].send_seq + 1;
 	context->tcp->send_ack = tcp_backlog[r].send_ack;
-	context->tcp->send_mss = tcp_backlog[r].send_mss;
+	tcp_set_peer_opts(context->tcp, &tcp_backlog[r].opts);
 
 	k_delayed_work_cancel(&tcp_backlog[r].ack_timer);
 	(void)memset(&tcp_backlog[r], 0, sizeof(struct tcp_backlog_entry));
@@ -1872,15 +2733,17 @@ static void print_send_info(struct net_pkt *pkt, const char *msg)
 static inline int send_syn_segment(struct net_context *context,
 				       const struct sockaddr_ptr *local,
 				       const struct sockaddr *remote,
-				       int flags, const char *msg)
+				       int flags,
+				       const struct net_tcp_options *syn,
+				       const char *msg)
 {
 	struct net_pkt *pkt = NULL;
 	int ret;
 	u8_t options[NET_TCP_MAX_OPT_SIZE];
 	u8_t optionlen = 0;
 
-	if (flags == NET_TCP_SYN) {
-		net_tcp_set_syn_opt(context->tcp, options, &optionlen);
+	if (flags == NET_TCP_SYN || syn) {
+		net_tcp_set_syn_opt(context->tcp, syn, options, &optionlen);
 	}
 
 	ret = net_tcp_prepare_segment(context->tcp, flags, options, optionlen,
@@ -1907,15 +2770,17 @@ static inline int send_syn(struct net_context *context,
 {
 	net_tcp_change_state(context->tcp, NET_TCP_SYN_SENT);
 
-	return send_syn_segment(context, NULL, remote, NET_TCP_SYN, "SYN");
+	return send_syn_segment(context, NULL, remote, NET_TCP_SYN, NULL,
+				"SYN");
 }
 
 static inline int send_syn_ack(struct net_context *context,
 			       struct sockaddr_ptr *local,
-			       struct sockaddr *remote)
+			       struct sockaddr *remote,
+			       const struct net_tcp_options *syn)
 {
 	return send_syn_segment(context, local, remote,
-				    NET_TCP_SYN | NET_TCP_ACK,
+				    NET_TCP_SYN | NET_TCP_ACK, syn,
 				    "SYN_ACK");
 }
 
@@ -1969,6 +2834,132 @@ static int send_reset(struct net_context *context,
 	return ret;
 }
 
+/* Parse the options of a segment received on an established connection,
+ * only the options that were negotiated are of interest.
+ */
+static int tcp_parse_seg_opts(struct net_tcp *tcp, struct net_pkt *pkt,
+			      struct net_tcp_hdr *tcp_hdr,
+			      struct net_tcp_options *opts)
+{
+	int opt_totlen = NET_TCP_HDR_LEN(tcp_hdr) - sizeof(struct net_tcp_hdr);
+	int ret;
+
+	if (!(tcp->flags & (NET_TCP_TS | NET_TCP_SACK)) || opt_totlen <= 0) {
+		return 0;
+	}
+
+	ret = net_tcp_parse_opts(pkt, opt_totlen, opts);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!(tcp->flags & NET_TCP_TS)) {
+		opts->ts_ok = 0;
+	}
+
+	if (!(tcp->flags & NET_TCP_SACK)) {
+		opts->num_sack = 0;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_NET_TCP_SACK)
+/* Keep an out-of-order segment until the missing data arrives, so that
+ * it can be reported in SACK blocks. Segments overlapping the data that
+ * is already queued are not kept.
+ */
+static bool tcp_ooo_queue(struct net_tcp *tcp, struct net_pkt *pkt,
+			  u8_t tcp_flags)
+{
+	struct net_pkt *cur, *prev = NULL;
+	u32_t seq, seq_len, cur_seq, cur_len;
+	int count = 0;
+
+	if (!tcp_sack_ok(tcp) ||
+	    (tcp_flags & (NET_TCP_SYN | NET_TCP_FIN | NET_TCP_RST))) {
+		return false;
+	}
+
+	net_pkt_set_appdata_values(pkt, IPPROTO_TCP);
+
+	if (!tcp_pkt_seq(pkt, &seq, &seq_len) || !seq_len ||
+	    net_tcp_seq_greater(seq + seq_len,
+				tcp->send_ack + net_tcp_get_recv_wnd(tcp))) {
+		return false;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tcp->ooo_list, cur, sent_list) {
+		if (!tcp_pkt_seq(cur, &cur_seq, &cur_len)) {
+			return false;
+		}
+
+		if (net_tcp_seq_greater(cur_seq + cur_len, seq) &&
+		    net_tcp_seq_greater(seq + seq_len, cur_seq)) {
+			return false;
+		}
+
+		if (net_tcp_seq_greater(seq, cur_seq)) {
+			prev = cur;
+		}
+
+		count++;
+	}
+
+	if (count >= CONFIG_NET_TCP_OOO_QUEUE_SIZE) {
+		NET_DBG("[%p] Out-of-order queue full", tcp);
+		return false;
+	}
+
+	sys_slist_insert(&tcp->ooo_list, prev ? &prev->sent_list : NULL,
+			 &pkt->sent_list);
+	tcp->ooo_last_seq = seq;
+
+	NET_DBG("[%p] Queued out-of-order pkt %p seq %u len %u", tcp, pkt,
+		seq, seq_len);
+
+	return true;
+}
+
+/* Pass the queued out-of-order segments that became in-order to the
+ * application.
+ */
+static void tcp_ooo_deliver(struct net_context *context, struct net_conn *conn)
+{
+	struct net_tcp *tcp = context->tcp;
+	struct net_pkt *pkt;
+	u32_t seq, seq_len;
+
+	while (1) {
+		pkt = SYS_SLIST_PEEK_HEAD_CONTAINER(&tcp->ooo_list, pkt,
+						    sent_list);
+		if (!pkt || !tcp_pkt_seq(pkt, &seq, &seq_len) ||
+		    net_tcp_seq_greater(seq, tcp->send_ack)) {
+			break;
+		}
+
+		sys_slist_remove(&tcp->ooo_list, NULL, &pkt->sent_list);
+
+		/* The data was received again in a different segment */
+		if (seq != tcp->send_ack) {
+			net_pkt_unref(pkt);
+			continue;
+		}
+
+		tcp->send_ack += seq_len;
+
+		if (net_context_packet_received(conn, pkt,
+						tcp->recv_user_data) ==
+		    NET_DROP) {
+			net_pkt_unref(pkt);
+		}
+	}
+}
+#else
+#define tcp_ooo_queue(...) false
+#define tcp_ooo_deliver(...)
+#endif /* CONFIG_NET_TCP_SACK */
+
 /* This is called when we receive data after the connection has been
  * established. The core TCP logic is located here.
  *
@@ -1979,6 +2970,7 @@ static int send_reset(struct net_context *context,
 NET_CONN_CB(tcp_established)
 {
 	struct net_context *context = (struct net_context *)user_data;
+	struct net_tcp_options opts = { 0 };
 	struct net_tcp_hdr hdr, *tcp_hdr;
 	enum net_verdict ret = NET_OK;
 	u8_t tcp_flags;
@@ -2001,6 +2993,21 @@ NET_CONN_CB(tcp_established)
 
 	tcp_flags = NET_TCP_FLAGS(tcp_hdr);
 
+	if (tcp_parse_seg_opts(context->tcp, pkt, tcp_hdr, &opts) < 0) {
+		return NET_DROP;
+	}
+
+	/* PAWS, RFC 7323 chapter 5.3: a segment with an older timestamp
+	 * than already seen is a duplicate from an earlier incarnation of
+	 * the sequence space.
+	 */
+	if (opts.ts_ok && !(tcp_flags & NET_TCP_RST) &&
+	    net_tcp_seq_greater(context->tcp->ts_recent, opts.tsval)) {
+		NET_DBG("[%p] PAWS drop, tsval %u ts_recent %u",
+			context->tcp, opts.tsval, context->tcp->ts_recent);
+		goto resend_ack;
+	}
+
 	if (net_tcp_seq_cmp(sys_get_be32(tcp_hdr->seq),
 			    context->tcp->send_ack) < 0) {
 		/* Peer sent us packet we've already seen. Apparently,
@@ -2017,11 +3024,27 @@ resend_ack:
 
 	if (net_tcp_seq_cmp(sys_get_be32(tcp_hdr->seq),
 			    context->tcp->send_ack) > 0) {
-		/* Don't try to reorder packets.  If it doesn't
-		 * match the next segment exactly, drop and wait for
-		 * retransmit
+		/* With SACK the segment is kept until the missing data
+		 * arrives. Otherwise don't try to reorder packets, drop
+		 * and wait for retransmit. In both cases send a duplicate
+		 * ACK immediately so that the peer can do a fast retransmit
+		 * (RFC 5681 ch. 4.2).
 		 */
-		return NET_DROP;
+		if (tcp_ooo_queue(context->tcp, pkt, tcp_flags)) {
+			send_ack(context, &conn->remote_addr, true);
+			return NET_OK;
+		}
+
+		goto resend_ack;
+	}
+
+	/* RFC 7323 chapter 4.3, the segment is in order so the timestamp
+	 * is the one to echo.
+	 */
+	if (opts.ts_ok &&
+	    !net_tcp_seq_greater(sys_get_be32(tcp_hdr->seq),
+				 context->tcp->sent_ack)) {
+		context->tcp->ts_recent = opts.tsval;
 	}
 
 	/*
@@ -2049,13 +3072,29 @@ resend_ack:
 		return NET_DROP;
 	}
 
+	net_pkt_set_appdata_values(pkt, IPPROTO_TCP);
+
+	data_len = net_pkt_appdatalen(pkt);
+
 	/* Handle TCP state transition */
 	if (tcp_flags & NET_TCP_ACK) {
-		if (!net_tcp_ack_received(context,
-				     sys_get_be32(tcp_hdr->ack))) {
+		bool dup_ack = tcp_is_dup_ack(context->tcp, tcp_hdr, data_len);
+
+		if (!tcp_ack_received(context, sys_get_be32(tcp_hdr->ack),
+				      &opts)) {
 			return NET_DROP;
 		}
 
+		if (dup_ack) {
+			tcp_cc_dup_ack(context->tcp);
+		}
+
+		/* The peer might have opened its window, or we might have
+		 * got more room in the congestion window.
+		 */
+		context->tcp->send_wnd = tcp_peer_wnd(context->tcp, tcp_hdr);
+		tcp_send_queued(context->tcp);
+
 		/* TCP state might be changed after maintaining the sent pkt
 		 * list, e.g., an ack of FIN is received.
 		 */
@@ -2097,9 +3136,6 @@ resend_ack:
 		context->tcp->fin_rcvd = 1;
 	}
 
-	net_pkt_set_appdata_values(pkt, IPPROTO_TCP);
-
-	data_len = net_pkt_appdatalen(pkt);
 	if (data_len > net_tcp_get_recv_wnd(context->tcp)) {
 		/* In case we have zero window, we should still accept
 		 * Zero Window Probes from peer, which per convention
@@ -2133,6 +3169,8 @@ resend_ack:
 	context->tcp->send_ack += data_len;
 	if (tcp_flags & NET_TCP_FIN) {
 		context->tcp->send_ack += 1;
+	} else if (data_len > 0) {
+		tcp_ooo_deliver(context, conn);
 	}
 
 	send_ack(context, &conn->remote_addr, false);
@@ -2217,9 +3255,18 @@ NET_CONN_CB(tcp_synack_received)
 		/* Remove the temporary connection handler and register
 		 * a proper now as we have an established connection.
 		 */
+		struct net_tcp_options tcp_opts = {
+			.mss = NET_TCP_DEFAULT_MSS,
+		};
 		struct sockaddr local_addr;
 		struct sockaddr remote_addr;
 
+		if (net_tcp_parse_opts(pkt, NET_TCP_HDR_LEN(tcp_hdr) -
+				       sizeof(struct net_tcp_hdr),
+				       &tcp_opts) < 0) {
+			return NET_DROP;
+		}
+
 		if (net_pkt_get_src_addr(
 			pkt, &remote_addr, sizeof(remote_addr)) < 0) {
 			NET_DBG("Cannot parse remote address"
@@ -2248,6 +3295,11 @@ NET_CONN_CB(tcp_synack_received)
 			return NET_DROP;
 		}
 
+		tcp_set_peer_opts(context->tcp, &tcp_opts);
+
+		context->tcp->send_wnd = tcp_peer_wnd(context->tcp, tcp_hdr);
+		tcp_cc_init(context->tcp);
+
 		net_tcp_change_state(context->tcp, NET_TCP_ESTABLISHED);
 		net_context_set_state(context, NET_CONTEXT_CONNECTED);
 
@@ -2393,7 +3445,7 @@ NET_CONN_CB(tcp_syn_rcvd)
 
 		/* Get MSS from TCP options here*/
 
-		r = tcp_backlog_syn(pkt, context, tcp_opts.mss);
+		r = tcp_backlog_syn(pkt, context, &tcp_opts);
 		if (r < 0) {
 			if (r == -EADDRINUSE) {
 				NET_DBG("TCP connection already exists");
@@ -2406,7 +3458,7 @@ NET_CONN_CB(tcp_syn_rcvd)
 
 		pkt_get_sockaddr(net_context_get_family(context),
 				 pkt, &pkt_src_addr);
-		send_syn_ack(context, &pkt_src_addr, &remote_addr);
+		send_syn_ack(context, &pkt_src_addr, &remote_addr, &tcp_opts);
 
 		return NET_DROP;
 	}
@@ -2505,6 +3557,10 @@ NET_CONN_CB(tcp_syn_rcvd)
 		 */
 		new_context->tcp->state = NET_TCP_ESTABLISHED;
 
+		new_context->tcp->send_wnd = tcp_peer_wnd(new_context->tcp,
+							  tcp_hdr);
+		tcp_cc_init(new_context->tcp);
+
 		net_context_set_state(new_context, NET_CONTEXT_CONNECTED);
 
 		if (new_context->remote.sa_family == AF_INET) {
@@ -0,0 +1,175 @@
+/** @file
+ * @brief TCP CUBIC congestion control
+ *
+ * Window growth function of RFC 8312. Slow start and fast recovery
+ * are shared with NewReno.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_tcp_cubic
+#define NET_LOG_LEVEL CONFIG_NET_TCP_LOG_LEVEL
+
+#include <kernel.h>
+#include <string.h>
+#include <zephyr/types.h>
+
+#include <net/net_core.h>
+
+#include "net_private.h"
+#include "tcp_internal.h"
+
+/* Multiplicative decrease factor beta_cubic = 0.7, in 1/1024 units */
+#define CUBIC_BETA 717
+
+/* Fast convergence factor (1 + beta_cubic) / 2 = 0.85, in 1/1024 units */
+#define CUBIC_BETA_FC 870
+
+/* Constant C = 0.4 is applied as 4 / 10 */
+#define CUBIC_C_NUM 4
+#define CUBIC_C_DEN 10
+
+/* Limit the time difference used in W(t) so that the cube fits in 64
+ * bits, in milliseconds.
+ */
+#define CUBIC_MAX_DELTA 1000000
+
+static u32_t cubic_root(u64_t a)
+{
+	u64_t x = 0;
+	int shift;
+
+	/* Bitwise integer cube root, see Hacker's Delight 11-2 */
+	for (shift = 63; shift >= 0; shift -= 3) {
+		u64_t b;
+
+		x <<= 1;
+		b = 3 * x * (x + 1) + 1;
+
+		if ((a >> shift) >= b) {
+			a -= b << shift;
+			x++;
+		}
+	}
+
+	return (u32_t)x;
+}
+
+static void cubic_init(struct net_tcp *tcp)
+{
+	(void)memset(&tcp->cubic, 0, sizeof(tcp->cubic));
+}
+
+/* W_cubic(t) = C * (t - K)^3 + W_max, RFC 8312 chapter 4.1. Times are
+ * in ms and windows in segments, so the result has to be scaled by
+ * 10^9 to get from ms^3 to s^3.
+ */
+static u32_t cubic_window(struct net_tcp *tcp, u32_t t)
+{
+	u32_t w_max = tcp->cubic.w_max / tcp->send_mss;
+	u64_t delta, offs;
+
+	if (t > tcp->cubic.k) {
+		delta = min(t - tcp->cubic.k, CUBIC_MAX_DELTA);
+		offs = delta * delta * delta * CUBIC_C_NUM /
+			((u64_t)CUBIC_C_DEN * 1000000000);
+
+		return (u32_t)min(w_max + offs, UINT16_MAX);
+	}
+
+	delta = min(tcp->cubic.k - t, CUBIC_MAX_DELTA);
+	offs = delta * delta * delta * CUBIC_C_NUM /
+		((u64_t)CUBIC_C_DEN * 1000000000);
+
+	return offs >= w_max ? 1 : (u32_t)(w_max - offs);
+}
+
+static void cubic_ack(struct net_tcp *tcp, u32_t acked)
+{
+	u32_t now = k_uptime_get_32();
+	u32_t cwnd_seg, target, rtt, t;
+
+	if (tcp->cwnd < tcp->ssthresh) {
+		/* Slow start is the same as with NewReno */
+		net_tcp_cc_newreno.ack(tcp, acked);
+		return;
+	}
+
+	if (!tcp->cubic.epoch_start) {
+		tcp->cubic.epoch_start = now ? now : 1;
+		tcp->cubic.w_est = tcp->cwnd;
+
+		if (tcp->cwnd < tcp->cubic.w_max) {
+			/* K = cubic_root(W_max * (1 - beta_cubic) / C),
+			 * converted to ms.
+			 */
+			u64_t w = (tcp->cubic.w_max - tcp->cwnd) /
+				tcp->send_mss;
+
+			tcp->cubic.k = cubic_root(w * CUBIC_C_DEN *
+						  1000000000 / CUBIC_C_NUM);
+		} else {
+			tcp->cubic.k = 0;
+			tcp->cubic.w_max = tcp->cwnd;
+		}
+	}
+
+	/* Smoothed RTT is stored scaled by 8 */
+	rtt = max(tcp->srtt >> 3, 1);
+	t = now - tcp->cubic.epoch_start;
+	target = cubic_window(tcp, t + rtt);
+	cwnd_seg = max(tcp->cwnd / tcp->send_mss, 1);
+
+	/* TCP friendly region, RFC 8312 chapter 4.2. W_est grows by
+	 * 3 * (1 - beta) / (1 + beta) segments per RTT.
+	 */
+	tcp->cubic.w_est += (u64_t)acked * tcp->send_mss * 3 *
+		(1024 - CUBIC_BETA) / ((1024 + CUBIC_BETA) * tcp->cwnd);
+
+	if (target < tcp->cubic.w_est / tcp->send_mss) {
+		target = tcp->cubic.w_est / tcp->send_mss;
+	}
+
+	if (target > cwnd_seg) {
+		/* Concave and convex regions, RFC 8312 chapters 4.3 and
+		 * 4.4: grow by (target - cwnd) / cwnd for each ACK.
+		 */
+		tcp->cwnd += max((target - cwnd_seg) * tcp->send_mss /
+				 cwnd_seg, 1);
+	} else {
+		/* Plateau, grow very slowly */
+		tcp->cwnd += max((u32_t)tcp->send_mss / (100 * cwnd_seg), 1);
+	}
+
+	NET_DBG("[%p] cwnd %u target %u segments", tcp, tcp->cwnd, target);
+}
+
+static u32_t cubic_ssthresh(struct net_tcp *tcp, u32_t flight)
+{
+	ARG_UNUSED(flight);
+
+	/* Fast convergence, RFC 8312 chapter 4.6 */
+	if (tcp->cwnd < tcp->cubic.w_last_max) {
+		tcp->cubic.w_last_max = tcp->cwnd;
+		tcp->cubic.w_max = (u64_t)tcp->cwnd * CUBIC_BETA_FC / 1024;
+	} else {
+		tcp->cubic.w_last_max = tcp->cwnd;
+		tcp->cubic.w_max = tcp->cwnd;
+	}
+
+	tcp->cubic.epoch_start = 0;
+
+	return max((u64_t)tcp->cwnd * CUBIC_BETA / 1024,
+		   2 * (u32_t)tcp->send_mss);
+}
+
+const struct net_tcp_cc net_tcp_cc_cubic = {
+	.name = "cubic",
+	.init = cubic_init,
+	.ack = cubic_ack,
+	.ssthresh = cubic_ssthresh,
+};
@@ -0,0 +1,54 @@
+/** @file
+ * @brief TCP NewReno congestion control
+ *
+ * Window growth and reduction rules of RFC 5681. The fast recovery
+ * part of NewReno (RFC 6582) is common to all algorithms and is done
+ * in tcp.c.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_tcp_newreno
+#define NET_LOG_LEVEL CONFIG_NET_TCP_LOG_LEVEL
+
+#include <kernel.h>
+#include <zephyr/types.h>
+
+#include <net/net_core.h>
+
+#include "net_private.h"
+#include "tcp_internal.h"
+
+static void newreno_ack(struct net_tcp *tcp, u32_t acked)
+{
+	u32_t incr;
+
+	if (tcp->cwnd < tcp->ssthresh) {
+		/* Slow start, RFC 5681 chapter 3.1 equation (2) */
+		incr = min(acked, tcp->send_mss);
+	} else {
+		/* Congestion avoidance, RFC 5681 chapter 3.1 equation (3) */
+		incr = max((u32_t)tcp->send_mss * tcp->send_mss / tcp->cwnd,
+			   1);
+	}
+
+	tcp->cwnd += incr;
+
+	NET_DBG("[%p] cwnd %u ssthresh %u", tcp, tcp->cwnd, tcp->ssthresh);
+}
+
+static u32_t newreno_ssthresh(struct net_tcp *tcp, u32_t flight)
+{
+	/* RFC 5681 chapter 3.1 equation (4) */
+	return max(flight / 2, 2 * (u32_t)tcp->send_mss);
+}
+
+const struct net_tcp_cc net_tcp_cc_newreno = {
+	.name = "newreno",
+	.ack = newreno_ack,
+	.ssthresh = newreno_ssthresh,
+};
@@ -29,7 +29,11 @@ extern "C" {
 /** Is this TCP context/socket used or not */
 #define NET_TCP_IN_USE BIT(0)
 
-/* BIT(1), BIT(2) are unused and available */
+/** Window scale option has been negotiated (RFC 7323) */
+#define NET_TCP_WSCALE BIT(1)
+
+/** Timestamps option has been negotiated (RFC 7323) */
+#define NET_TCP_TS BIT(2)
 
 /** Is the socket shutdown for read/write */
 #define NET_TCP_IS_SHUTDOWN BIT(3)
@@ -40,6 +44,9 @@ extern "C" {
 /** MSS option has been set already */
 #define NET_TCP_RECV_MSS_SET BIT(5)
 
+/** Selective acknowledgments have been negotiated (RFC 2018) */
+#define NET_TCP_SACK BIT(6)
+
 /*
  * TCP connection states
  */
@@ -77,38 +84,140 @@ enum net_tcp_state {
  */
 #define NET_TCP_DEFAULT_MSS   536
 
-/* TCP max window size */
-#define NET_TCP_MAX_WIN   (4 * 1024)
-
 /* Maximal value of the sequence number */
 #define NET_TCP_MAX_SEQ   0xffffffff
 
-#define NET_TCP_MAX_OPT_SIZE  8
+/* Max length of the options field */
+#define NET_TCP_MAX_OPT_SIZE  40
 
 /* TCP Option codes */
 #define NET_TCP_END_OPT          0
 #define NET_TCP_NOP_OPT          1
 #define NET_TCP_MSS_OPT          2
 #define NET_TCP_WINDOW_SCALE_OPT 3
+#define NET_TCP_SACK_PERM_OPT    4
+#define NET_TCP_SACK_OPT         5
+#define NET_TCP_TIMESTAMP_OPT    8
 
 /* TCP Option sizes */
 #define NET_TCP_END_SIZE          1
 #define NET_TCP_NOP_SIZE          1
 #define NET_TCP_MSS_SIZE          4
 #define NET_TCP_WINDOW_SCALE_SIZE 3
+#define NET_TCP_SACK_PERM_SIZE    2
+#define NET_TCP_SACK_BLOCK_SIZE   8
+#define NET_TCP_TIMESTAMP_SIZE    10
+
+/* Timestamps option is sent aligned, i.e. prefixed with two NOPs */
+#define NET_TCP_TIMESTAMP_ALIGNED_SIZE (NET_TCP_TIMESTAMP_SIZE + 2)
+
+/* Space reserved for the options of data segments */
+#if defined(CONFIG_NET_TCP_TIMESTAMPS)
+#define NET_TCP_DATA_OPT_SIZE NET_TCP_TIMESTAMP_ALIGNED_SIZE
+#else
+#define NET_TCP_DATA_OPT_SIZE 8
+#endif
+
+/* Largest allowed window scale shift (RFC 7323 chapter 2.3) */
+#define NET_TCP_MAX_WINDOW_SCALE 14
+
+/* Max number of SACK blocks that fit into the options field */
+#define NET_TCP_MAX_SACK_BLOCKS 4
+
+/** SACK block, a received range of sequence numbers [start, end) */
+struct net_tcp_sack_block {
+	u32_t start;
+	u32_t end;
+};
 
 /** Parsed TCP option values for net_tcp_parse_opts()  */
 struct net_tcp_options {
+	/** Timestamp value of the peer */
+	u32_t tsval;
+
+	/** Timestamp echo reply */
+	u32_t tsecr;
+
+	/** SACK blocks */
+	struct net_tcp_sack_block sack[NET_TCP_MAX_SACK_BLOCKS];
+
 	u16_t mss;
-};
 
-/* Max received bytes to buffer internally */
-#define NET_TCP_BUF_MAX_LEN 1280
+	/** Window scale shift of the peer */
+	u8_t wscale;
+
+	/** Window scale option is present */
+	u8_t wscale_ok : 1;
+
+	/** SACK permitted option is present */
+	u8_t sack_perm : 1;
+
+	/** Timestamps option is present */
+	u8_t ts_ok : 1;
+
+	/** Number of SACK blocks */
+	u8_t num_sack : 3;
+};
 
 /* Max segment lifetime, in seconds */
 #define NET_TCP_MAX_SEG_LIFETIME 60
 
+/* Upper bound of the retransmission timeout, in milliseconds
+ * (RFC 6298 chapter 2.5)
+ */
+#define NET_TCP_MAX_RTO K_SECONDS(60)
+
+/* Number of duplicate ACKs that trigger a fast retransmit (RFC 5681) */
+#define NET_TCP_DUP_ACK_THRESHOLD 3
+
 struct net_context;
+struct net_tcp;
+
+/**
+ * @brief TCP congestion control algorithm.
+ *
+ * The generic parts of the congestion control (flight size tracking,
+ * fast retransmit and fast recovery) are done in tcp.c, the algorithm
+ * only decides how the congestion window evolves.
+ */
+struct net_tcp_cc {
+	/** Name of the algorithm, used for debugging and in net shell */
+	const char *name;
+
+	/** Initialize the algorithm state when connection is established */
+	void (*init)(struct net_tcp *tcp);
+
+	/** New data was acknowledged outside of loss recovery */
+	void (*ack)(struct net_tcp *tcp, u32_t acked);
+
+	/** Loss was detected, return the new slow start threshold */
+	u32_t (*ssthresh)(struct net_tcp *tcp, u32_t flight);
+};
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+extern const struct net_tcp_cc net_tcp_cc_newreno;
+#if defined(CONFIG_NET_TCP_CC_CUBIC)
+extern const struct net_tcp_cc net_tcp_cc_cubic;
+#endif
+
+/** CUBIC specific congestion control state */
+struct net_tcp_cubic {
+	/** Window size (in bytes) just before the last reduction */
+	u32_t w_max;
+
+	/** Previous w_max, used for fast convergence */
+	u32_t w_last_max;
+
+	/** Time (in ms) when the current congestion avoidance epoch began */
+	u32_t epoch_start;
+
+	/** Time (in ms) to reach w_max from the start of the epoch */
+	u32_t k;
+
+	/** Estimated window of standard TCP (in bytes) */
+	u32_t w_est;
+};
+#endif /* CONFIG_NET_TCP_CONGESTION_CONTROL */
 
 struct net_tcp {
 	/** Network context back pointer. */
@@ -141,6 +250,56 @@ struct net_tcp {
 	/** Last ACK value sent */
 	u32_t sent_ack;
 
+	/** Smoothed round-trip time, in ms scaled by 8 (RFC 6298) */
+	u32_t srtt;
+
+	/** Round-trip time variation, in ms scaled by 4 (RFC 6298) */
+	u32_t rttvar;
+
+	/** Current retransmission timeout in ms, before backoff */
+	u32_t rto;
+
+	/** Sequence number that completes the pending RTT measurement */
+	u32_t rtt_seq;
+
+	/** Uptime (in ms) when the RTT measurement was started */
+	u32_t rtt_start;
+
+	/** Most recent timestamp received from the peer (TS.Recent) */
+	u32_t ts_recent;
+
+#if defined(CONFIG_NET_TCP_SACK)
+	/** Out-of-order segments received, sorted by sequence number */
+	sys_slist_t ooo_list;
+
+	/** Sequence number of the most recent out-of-order segment */
+	u32_t ooo_last_seq;
+
+	/** Highest sequence number retransmitted in the current fast
+	 * recovery (HighRxt in RFC 6675)
+	 */
+	u32_t high_rxt;
+#endif
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	/** Congestion control algorithm used by this connection */
+	const struct net_tcp_cc *cc;
+
+	/** Congestion window, in bytes */
+	u32_t cwnd;
+
+	/** Slow start threshold, in bytes */
+	u32_t ssthresh;
+
+	/** Highest sequence number sent when fast recovery was entered */
+	u32_t recover;
+
+#if defined(CONFIG_NET_TCP_CC_CUBIC)
+	/** Algorithm specific state */
+	struct net_tcp_cubic cubic;
+#endif
+#endif /* CONFIG_NET_TCP_CONGESTION_CONTROL */
+
 	/** Accept callback to be called when the connection has been
 	 * established.
 	 */
@@ -154,13 +313,24 @@ struct net_tcp {
 	/**
 	 * Current TCP receive window for our side
 	 */
-	u16_t recv_wnd;
+	u32_t recv_wnd;
+
+	/**
+	 * Last TCP receive window advertised by the peer, scaled
+	 */
+	u32_t send_wnd;
 
 	/**
 	 * Send MSS for the peer
 	 */
 	u16_t send_mss;
 
+	/** Window scale shift of the peer */
+	u8_t send_wscale;
+
+	/** Window scale shift of our side */
+	u8_t recv_wscale;
+
 	/** Current retransmit period */
 	u32_t retry_timeout_shift : 5;
 	/** Flags for the TCP */
@@ -171,8 +341,14 @@ struct net_tcp {
 	u32_t fin_sent : 1;
 	/* An inbound FIN packet has been received */
 	u32_t fin_rcvd : 1;
+	/* A round-trip time measurement is in progress */
+	u32_t rtt_pending : 1;
+	/* Fast recovery is in progress */
+	u32_t in_recovery : 1;
+	/* Number of consecutive duplicate ACKs received */
+	u32_t dup_acks : 4;
 	/** Remaining bits in this u32_t */
-	u32_t _padding : 13;
+	u32_t _padding : 7;
 };
 
 typedef void (*net_tcp_cb_t)(struct net_tcp *tcp, void *user_data);
@@ -424,8 +600,8 @@ u16_t net_tcp_get_chksum(struct net_pkt *pkt, struct net_buf *frag);
 /**
  * @brief Parse TCP options from network packet.
  *
- * Parse TCP options, returning MSS value (as that the only one we
- * handle so far).
+ * Parse TCP options, returning the MSS, window scale, SACK and
+ * timestamps option values.
  *
  * @param pkt Network packet
  * @param opt_totlen Total length of options to parse
@@ -22,6 +22,12 @@
 #include <net/net_pkt.h>
 #include <net/net_core.h>
 
+#if defined(CONFIG_NET_CHKSUM_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(CONFIG_NET_CHKSUM_SIMD) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 char *net_sprint_addr(sa_family_t af, const void *addr)
 {
 #define NBUFS 3
@@ -390,31 +396,146 @@ int net_addr_pton(sa_family_t family, const char *src,
 	return 0;
 }
 
-static u16_t calc_chksum(u16_t sum, const u8_t *ptr, u16_t len)
+/* The checksum is accumulated from the data as it is laid out in memory,
+ * so that the words can be loaded in host byte order. The one's complement
+ * sum does not depend on the byte order (RFC 1071), only the final 16-bit
+ * value needs to be converted. Carries are collected in a 64-bit accumulator
+ * and folded back only at the end.
+ */
+typedef u16_t __attribute__((__may_alias__)) chksum_u16_t;
+typedef u32_t __attribute__((__may_alias__)) chksum_u32_t;
+
+static inline u16_t chksum_fold(u64_t acc)
 {
-	u16_t tmp;
-	const u8_t *end;
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffff) + (acc >> 16);
+	acc = (acc & 0xffff) + (acc >> 16);
 
-	end = ptr + len - 1;
+	return acc;
+}
 
-	while (ptr < end) {
-		tmp = (ptr[0] << 8) + ptr[1];
-		sum += tmp;
-		if (sum < tmp) {
-			sum++;
-		}
+#if defined(CONFIG_NET_CHKSUM_SIMD) && defined(__SSE2__)
+static inline u64_t chksum_simd(u64_t acc, const u8_t **ptr, size_t *len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	u32_t lanes[4];
+
+	/* Every 32-bit lane gets two 16-bit words per round, so the lanes
+	 * cannot overflow for buffers shorter than 64kB.
+	 */
+	while (*len >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)*ptr);
+
+		sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(v, zero));
+		sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(v, zero));
+
+		*ptr += 16;
+		*len -= 16;
+	}
+
+	_mm_storeu_si128((__m128i *)lanes, sum);
+
+	return acc + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+#elif defined(CONFIG_NET_CHKSUM_SIMD) && defined(__ARM_NEON)
+static inline u64_t chksum_simd(u64_t acc, const u8_t **ptr, size_t *len)
+{
+	uint32x4_t sum = vdupq_n_u32(0);
+
+	/* Same lane overflow limits as above */
+	while (*len >= 16) {
+		sum = vpadalq_u16(sum, vld1q_u16((const uint16_t *)*ptr));
+
+		*ptr += 16;
+		*len -= 16;
+	}
+
+	return acc + vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) +
+		vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+}
+#else
+static inline u64_t chksum_simd(u64_t acc, const u8_t **ptr, size_t *len)
+{
+	return acc;
+}
+#endif
+
+/* Sum of a buffer that starts at an even address */
+static u64_t chksum_aligned(u64_t acc, const u8_t *ptr, size_t len)
+{
+	if (((uintptr_t)ptr & 2) && len >= 2) {
+		acc += *(const chksum_u16_t *)ptr;
 		ptr += 2;
+		len -= 2;
 	}
 
-	if (ptr == end) {
-		tmp = ptr[0] << 8;
-		sum += tmp;
-		if (sum < tmp) {
-			sum++;
-		}
+	acc = chksum_simd(acc, &ptr, &len);
+
+	while (len >= 16) {
+		const chksum_u32_t *p = (const chksum_u32_t *)ptr;
+
+		acc += (u64_t)p[0] + p[1] + p[2] + p[3];
+		ptr += 16;
+		len -= 16;
 	}
 
-	return sum;
+	while (len >= 4) {
+		acc += *(const chksum_u32_t *)ptr;
+		ptr += 4;
+		len -= 4;
+	}
+
+	if (len >= 2) {
+		acc += *(const chksum_u16_t *)ptr;
+		ptr += 2;
+		len -= 2;
+	}
+
+	if (len) {
+		u16_t last = 0;
+
+		*(u8_t *)&last = *ptr;
+		acc += last;
+	}
+
+	return acc;
+}
+
+/* Sum of a buffer that is at an even offset of the checksummed data */
+static u16_t chksum_partial(const u8_t *ptr, size_t len)
+{
+	u16_t first = 0;
+	u16_t sum;
+
+	if (!((uintptr_t)ptr & 1)) {
+		return chksum_fold(chksum_aligned(0, ptr, len));
+	}
+
+	if (!len) {
+		return 0;
+	}
+
+	/* Sum the rest of the buffer from the next even address. The bytes
+	 * then end up in the wrong halves of the words, which is fixed by
+	 * swapping the result.
+	 */
+	sum = chksum_fold(chksum_aligned(0, ptr + 1, len - 1));
+	sum = __bswap_16(sum);
+
+	*(u8_t *)&first = *ptr;
+
+	return chksum_fold((u64_t)sum + first);
+}
+
+static u16_t calc_chksum(u16_t sum, const u8_t *ptr, u16_t len)
+{
+	u64_t acc = htons(sum);
+
+	acc += chksum_partial(ptr, len);
+
+	return ntohs(chksum_fold(acc));
 }
 
 static inline u16_t calc_chksum_pkt(u16_t sum, struct net_pkt *pkt,
@@ -422,9 +543,11 @@ static inline u16_t calc_chksum_pkt(u16_t sum, struct net_pkt *pkt,
 {
 	u16_t proto_len = net_pkt_ip_hdr_len(pkt) +
 		net_pkt_ipv6_ext_len(pkt);
+	u64_t acc = htons(sum);
 	struct net_buf *frag;
+	bool odd = false;
 	u16_t offset;
-	s16_t len;
+	u16_t len;
 	u8_t *ptr;
 
 	ARG_UNUSED(upper_layer_len);
@@ -442,29 +565,28 @@ static inline u16_t calc_chksum_pkt(u16_t sum, struct net_pkt *pkt,
 	len = frag->len - offset;
 
 	while (frag) {
-		sum = calc_chksum(sum, ptr, len);
+		u16_t part = chksum_partial(ptr, len);
+
+		/* A fragment that starts at an odd offset of the data has
+		 * its bytes in the wrong halves of the words.
+		 */
+		if (odd) {
+			part = __bswap_16(part);
+		}
+
+		acc += part;
+		odd ^= len & 1;
+
 		frag = frag->frags;
 		if (!frag) {
 			break;
 		}
 
 		ptr = frag->data;
-
-		/* Do we need to take first byte from next fragment */
-		if (len % 2) {
-			u16_t tmp = *ptr;
-			sum += tmp;
-			if (sum < tmp) {
-				sum++;
-			}
-			len = frag->len - 1;
-			ptr++;
-		} else {
-			len = frag->len;
-		}
+		len = frag->len;
 	}
 
-	return sum;
+	return ntohs(chksum_fold(acc));
 }
 
 u16_t net_calc_chksum(struct net_pkt *pkt, u8_t proto)
@@ -19,6 +19,7 @@
 
 #include "arp.h"
 #include "net_private.h"
+#include "route.h"
 
 #define NET_BUF_TIMEOUT K_MSEC(100)
 #define ARP_REQUEST_TIMEOUT K_SECONDS(2)
@@ -338,6 +339,22 @@ static inline struct net_pkt *arp_prepare(struct net_if *iface,
 	return pkt;
 }
 
+/* Gateway of the most specific route towards the destination, if any */
+static inline struct in_addr *route_gw(struct net_if *iface,
+				       struct in_addr *dst)
+{
+#if defined(CONFIG_NET_ROUTE_IPV4)
+	struct net_route_entry_ipv4 *route;
+
+	route = net_route_ipv4_lookup(iface, dst);
+	if (route) {
+		return &route->gw;
+	}
+#endif
+
+	return NULL;
+}
+
 struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 				struct in_addr *request_ip,
 				struct in_addr *current_ip)
@@ -382,7 +399,11 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 		struct net_if_ipv4 *ipv4 = net_pkt_iface(pkt)->config.ip.ipv4;
 
 		if (ipv4) {
-			addr = &ipv4->gw;
+			addr = route_gw(net_pkt_iface(pkt), request_ip);
+			if (!addr) {
+				addr = &ipv4->gw;
+			}
+
 			if (net_ipv4_is_addr_unspecified(addr)) {
 				NET_ERR("Gateway not set for iface %p",
 					net_pkt_iface(pkt));
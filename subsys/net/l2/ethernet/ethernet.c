@@ -966,6 +966,14 @@ void ethernet_init(struct net_if *iface)
 		ctx->ethernet_l2_flags |= NET_L2_PROMISC_MODE;
 	}
 
+	if (net_eth_get_hw_capabilities(iface) & ETHERNET_HW_TX_CHKSUM_OFFLOAD) {
+		atomic_set_bit(iface->if_dev->flags, NET_IF_TX_CHKSUM_OFFLOAD);
+	}
+
+	if (net_eth_get_hw_capabilities(iface) & ETHERNET_HW_RX_CHKSUM_OFFLOAD) {
+		atomic_set_bit(iface->if_dev->flags, NET_IF_RX_CHKSUM_OFFLOAD);
+	}
+
 #if defined(CONFIG_NET_VLAN)
 	if (!(net_eth_get_hw_capabilities(iface) & ETHERNET_HW_VLAN)) {
 		return;
@@ -43,16 +43,24 @@ static void new_client(struct net_context *net_ctx,
 
 static int get_avail_net_ctx(struct net_app_ctx *ctx)
 {
-	int i;
+	int i, avail = -1, used = 0;
 
 	for (i = 0; i < CONFIG_NET_APP_SERVER_NUM_CONN; i++) {
 		if (!ctx->server.net_ctxs[i] ||
 		    !net_context_is_used(ctx->server.net_ctxs[i])) {
-			return i;
+			if (avail < 0) {
+				avail = i;
+			}
+		} else {
+			used++;
 		}
 	}
 
-	return -1;
+	if (ctx->server.max_conn && used >= ctx->server.max_conn) {
+		return -1;
+	}
+
+	return avail;
 }
 
 void _net_app_accept_cb(struct net_context *net_ctx,
@@ -514,3 +522,26 @@ bool net_app_server_disable(struct net_app_ctx *ctx)
 #endif
 	return old;
 }
+
+int net_app_server_set_max_conn(struct net_app_ctx *ctx, int max_conn)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (ctx->app_type != NET_APP_SERVER) {
+		return -EINVAL;
+	}
+
+#if defined(CONFIG_NET_TCP)
+	if (max_conn < 0 || max_conn > CONFIG_NET_APP_SERVER_NUM_CONN) {
+		return -EINVAL;
+	}
+
+	ctx->server.max_conn = max_conn;
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
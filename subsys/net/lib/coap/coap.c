@@ -23,8 +23,7 @@
 
 struct option_context {
 	u16_t delta;
-	u16_t offset;
-	struct net_buf *frag;
+	struct net_pkt_cursor cursor;
 };
 
 #define COAP_VERSION 1
@@ -96,6 +95,16 @@ static int check_frag_read_status(const struct net_buf *frag, u16_t offset)
 	return 1;
 }
 
+/* Same as check_frag_read_status(), after a read with a cursor */
+static int check_cursor_read_status(struct net_pkt_cursor *cursor, int r)
+{
+	if (r < 0) {
+		return -EINVAL;
+	}
+
+	return net_pkt_cursor_at_end(cursor) ? 0 : 1;
+}
+
 static int decode_delta(struct option_context *context, u16_t opt,
 			u16_t *opt_ext, u16_t *hdr_len)
 {
@@ -105,12 +114,8 @@ static int decode_delta(struct option_context *context, u16_t opt,
 		u8_t val;
 
 		*hdr_len = 1;
-		context->frag = net_frag_read_u8(context->frag,
-						 context->offset,
-						 &context->offset,
-						 &val);
-		ret = check_frag_read_status(context->frag,
-					     context->offset);
+		ret = net_pkt_cursor_read_u8(&context->cursor, &val);
+		ret = check_cursor_read_status(&context->cursor, ret);
 		if (ret < 0) {
 			return -EINVAL;
 		}
@@ -120,12 +125,8 @@ static int decode_delta(struct option_context *context, u16_t opt,
 		u16_t val;
 
 		*hdr_len = 2;
-		context->frag = net_frag_read_be16(context->frag,
-						   context->offset,
-						   &context->offset,
-						   &val);
-		ret = check_frag_read_status(context->frag,
-					     context->offset);
+		ret = net_pkt_cursor_read_be16(&context->cursor, &val);
+		ret = check_cursor_read_status(&context->cursor, ret);
 		if (ret < 0) {
 			return -EINVAL;
 		}
@@ -151,11 +152,8 @@ static int parse_option(const struct coap_packet *cpkt,
 	u8_t opt;
 	int r;
 
-	context->frag = net_frag_read_u8(context->frag,
-					 context->offset,
-					 &context->offset,
-					 &opt);
-	r = check_frag_read_status(context->frag, context->offset);
+	r = net_pkt_cursor_read_u8(&context->cursor, &opt);
+	r = check_cursor_read_status(&context->cursor, r);
 	if (r < 0) {
 		return r;
 	}
@@ -230,15 +228,13 @@ static int parse_option(const struct coap_packet *cpkt,
 
 		option->delta = context->delta + delta;
 		option->len = len;
-		context->frag = net_frag_read(context->frag, context->offset,
-					      &context->offset, len,
-					      &option->value[0]);
+		r = net_pkt_cursor_read(&context->cursor, &option->value[0],
+					len);
 	} else {
-		context->frag = net_frag_skip(context->frag, context->offset,
-					      &context->offset, len);
+		r = net_pkt_cursor_skip(&context->cursor, len);
 	}
 
-	r = check_frag_read_status(context->frag, context->offset);
+	r = check_cursor_read_status(&context->cursor, r);
 	if (r < 0) {
 		return r;
 	}
@@ -253,17 +249,16 @@ static int parse_options(const struct coap_packet *cpkt,
 {
 	struct option_context context = {
 					.delta = 0,
-					.frag = NULL,
-					.offset = 0
 					};
 	u16_t opt_len;
 	u8_t num;
 	int r;
 
 	/* Skip CoAP header */
-	context.frag = net_frag_skip(cpkt->frag, cpkt->offset,
-				     &context.offset, cpkt->hdr_len);
-	r = check_frag_read_status(context.frag, context.offset);
+	net_pkt_cursor_set(&context.cursor, cpkt->pkt, cpkt->frag,
+			   cpkt->offset);
+	r = net_pkt_cursor_skip(&context.cursor, cpkt->hdr_len);
+	r = check_cursor_read_status(&context.cursor, r);
 	if (r <= 0) {
 		return r;
 	}
@@ -658,6 +653,19 @@ static bool is_request(const struct coap_packet *cpkt)
 	return !(code & ~COAP_REQUEST_MASK);
 }
 
+static int resource_handle_request(struct coap_resource *resource,
+				   struct coap_packet *cpkt)
+{
+	coap_method_t method;
+
+	method = method_from_code(resource, coap_header_get_code(cpkt));
+	if (!method) {
+		return 0;
+	}
+
+	return method(resource, cpkt);
+}
+
 int coap_handle_request(struct coap_packet *cpkt,
 			struct coap_resource *resources,
 			struct coap_option *options,
@@ -671,20 +679,11 @@ int coap_handle_request(struct coap_packet *cpkt,
 
 	/* FIXME: deal with hierarchical resources */
 	for (resource = resources; resource && resource->path; resource++) {
-		coap_method_t method;
-		u8_t code;
-
 		if (!uri_path_eq(cpkt, resource->path, options, opt_num)) {
 			continue;
 		}
 
-		code = coap_header_get_code(cpkt);
-		method = method_from_code(resource, code);
-		if (!method) {
-			return 0;
-		}
-
-		return method(resource, cpkt);
+		return resource_handle_request(resource, cpkt);
 	}
 
 	return -ENOENT;
@@ -726,6 +725,27 @@ static int get_observe_option(const struct coap_packet *cpkt)
 	return coap_option_value_to_int(&option);
 }
 
+/* Returns false for a notification older than the last one */
+static bool reply_age_update(struct coap_reply *reply,
+			     const struct coap_packet *response)
+{
+	int age;
+
+	age = get_observe_option(response);
+	if (age > 0) {
+		/* age == 2 means that the notifications wrapped,
+		 * or this is the first one
+		 */
+		if (reply->age > age && age != 2) {
+			return false;
+		}
+
+		reply->age = age;
+	}
+
+	return true;
+}
+
 struct coap_reply *coap_response_received(
 	const struct coap_packet *response,
 	const struct sockaddr *from,
@@ -741,8 +761,6 @@ struct coap_reply *coap_response_received(
 	tkl = coap_header_get_token(response, (u8_t *)token);
 
 	for (i = 0, r = replies; i < len; i++, r++) {
-		int age;
-
 		if ((r->id == 0) && (r->tkl == 0)) {
 			continue;
 		}
@@ -756,16 +774,8 @@ struct coap_reply *coap_response_received(
 			continue;
 		}
 
-		age = get_observe_option(response);
-		if (age > 0) {
-			/* age == 2 means that the notifications wrapped,
-			 * or this is the first one
-			 */
-			if (r->age > age && age != 2) {
-				continue;
-			}
-
-			r->age = age;
+		if (!reply_age_update(r, response)) {
+			continue;
 		}
 
 		r->reply(response, r, from);
@@ -918,6 +928,268 @@ struct coap_observer *coap_find_observer_by_addr(
 	return NULL;
 }
 
+#if defined(CONFIG_COAP_INDEX)
+/* FNV-1a */
+#define INDEX_HASH_INIT		2166136261U
+#define INDEX_HASH_PRIME	16777619U
+
+/* Separates the segments of a path, so that "ab" and "a/b" differ */
+#define INDEX_PATH_SEPARATOR	'/'
+
+static u32_t index_hash(u32_t hash, const void *data, size_t len)
+{
+	const u8_t *p = data;
+
+	while (len--) {
+		hash = (hash ^ *p++) * INDEX_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static inline sys_slist_t *index_bucket(struct coap_index *index, u32_t hash)
+{
+	return &index->buckets[hash % CONFIG_COAP_INDEX_SIZE];
+}
+
+static u32_t path_hash(const char * const *path)
+{
+	u32_t hash = INDEX_HASH_INIT;
+	u8_t sep = INDEX_PATH_SEPARATOR;
+
+	for (; *path; path++) {
+		hash = index_hash(hash, *path, strlen(*path));
+		hash = index_hash(hash, &sep, sizeof(sep));
+	}
+
+	return hash;
+}
+
+/* Same hash as path_hash(), from the Uri-Path options of a request */
+static u32_t options_path_hash(struct coap_option *options, u8_t opt_num)
+{
+	u32_t hash = INDEX_HASH_INIT;
+	u8_t sep = INDEX_PATH_SEPARATOR;
+	u8_t i;
+
+	for (i = 0; i < opt_num; i++) {
+		if (options[i].delta != COAP_OPTION_URI_PATH) {
+			continue;
+		}
+
+		hash = index_hash(hash, options[i].value, options[i].len);
+		hash = index_hash(hash, &sep, sizeof(sep));
+	}
+
+	return hash;
+}
+
+static u32_t addr_hash(const struct sockaddr *addr)
+{
+	u32_t hash = index_hash(INDEX_HASH_INIT, &addr->sa_family,
+				sizeof(addr->sa_family));
+
+	if (addr->sa_family == AF_INET6) {
+		const struct sockaddr_in6 *a6 = net_sin6(addr);
+
+		hash = index_hash(hash, &a6->sin6_port, sizeof(a6->sin6_port));
+		hash = index_hash(hash, &a6->sin6_addr, sizeof(a6->sin6_addr));
+	} else if (addr->sa_family == AF_INET) {
+		const struct sockaddr_in *a4 = net_sin(addr);
+
+		hash = index_hash(hash, &a4->sin_port, sizeof(a4->sin_port));
+		hash = index_hash(hash, &a4->sin_addr, sizeof(a4->sin_addr));
+	}
+
+	return hash;
+}
+
+static inline u32_t id_hash(u16_t id)
+{
+	return index_hash(INDEX_HASH_INIT, &id, sizeof(id));
+}
+
+/* Replies are keyed on their token, or on the message ID without token */
+static inline u32_t reply_hash(const u8_t *token, u8_t tkl, u16_t id)
+{
+	return tkl ? index_hash(INDEX_HASH_INIT, token, tkl) : id_hash(id);
+}
+
+void coap_index_init(struct coap_index *index)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_COAP_INDEX_SIZE; i++) {
+		sys_slist_init(&index->buckets[i]);
+	}
+}
+
+int coap_index_add_resources(struct coap_index *index,
+			     struct coap_resource *resources)
+{
+	struct coap_resource *resource;
+	int count = 0;
+
+	/* Appended, so that the first of resources with the same path is
+	 * found, as with coap_handle_request()
+	 */
+	for (resource = resources; resource->path; resource++) {
+		resource->path_hash = path_hash(resource->path);
+		sys_slist_append(index_bucket(index, resource->path_hash),
+				 &resource->index_node);
+		count++;
+	}
+
+	return count;
+}
+
+int coap_index_handle_request(struct coap_packet *cpkt,
+			      struct coap_index *index,
+			      struct coap_option *options,
+			      u8_t opt_num)
+{
+	struct coap_resource *resource;
+	u32_t hash;
+
+	if (!is_request(cpkt)) {
+		return 0;
+	}
+
+	hash = options_path_hash(options, opt_num);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(index_bucket(index, hash), resource,
+				     index_node) {
+		if (resource->path_hash != hash ||
+		    !uri_path_eq(cpkt, resource->path, options, opt_num)) {
+			continue;
+		}
+
+		return resource_handle_request(resource, cpkt);
+	}
+
+	return -ENOENT;
+}
+
+void coap_index_add_observer(struct coap_index *index,
+			     struct coap_observer *observer)
+{
+	sys_slist_append(index_bucket(index, addr_hash(&observer->addr)),
+			 &observer->index_node);
+}
+
+void coap_index_remove_observer(struct coap_index *index,
+				struct coap_observer *observer)
+{
+	sys_slist_find_and_remove(index_bucket(index,
+					       addr_hash(&observer->addr)),
+				  &observer->index_node);
+}
+
+struct coap_observer *coap_index_find_observer_by_addr(
+	struct coap_index *index, const struct sockaddr *addr)
+{
+	struct coap_observer *o;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(index_bucket(index, addr_hash(addr)), o,
+				     index_node) {
+		if (sockaddr_equal(&o->addr, addr)) {
+			return o;
+		}
+	}
+
+	return NULL;
+}
+
+void coap_index_add_pending(struct coap_index *index,
+			    struct coap_pending *pending)
+{
+	sys_slist_append(index_bucket(index, id_hash(pending->id)),
+			 &pending->index_node);
+}
+
+void coap_index_remove_pending(struct coap_index *index,
+			       struct coap_pending *pending)
+{
+	sys_slist_find_and_remove(index_bucket(index, id_hash(pending->id)),
+				  &pending->index_node);
+}
+
+struct coap_pending *coap_index_pending_received(
+	const struct coap_packet *response,
+	struct coap_index *index)
+{
+	u16_t resp_id = coap_header_get_id(response);
+	sys_slist_t *bucket = index_bucket(index, id_hash(resp_id));
+	struct coap_pending *p;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(bucket, p, index_node) {
+		if (!p->timeout || p->id != resp_id) {
+			continue;
+		}
+
+		sys_slist_find_and_remove(bucket, &p->index_node);
+		coap_pending_clear(p);
+		return p;
+	}
+
+	return NULL;
+}
+
+void coap_index_add_reply(struct coap_index *index,
+			  struct coap_reply *reply)
+{
+	sys_slist_append(index_bucket(index, reply_hash(reply->token,
+							reply->tkl,
+							reply->id)),
+			 &reply->index_node);
+}
+
+void coap_index_remove_reply(struct coap_index *index,
+			     struct coap_reply *reply)
+{
+	sys_slist_find_and_remove(index_bucket(index,
+					       reply_hash(reply->token,
+							  reply->tkl,
+							  reply->id)),
+				  &reply->index_node);
+}
+
+struct coap_reply *coap_index_response_received(
+	const struct coap_packet *response,
+	const struct sockaddr *from,
+	struct coap_index *index)
+{
+	struct coap_reply *r;
+	u8_t token[8];
+	u16_t id;
+	u8_t tkl;
+
+	id = coap_header_get_id(response);
+	tkl = coap_header_get_token(response, (u8_t *)token);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(index_bucket(index,
+						  reply_hash(token, tkl, id)),
+				     r, index_node) {
+		if (!r->reply || r->tkl != tkl) {
+			continue;
+		}
+
+		if (tkl ? memcmp(r->token, token, tkl) : r->id != id) {
+			continue;
+		}
+
+		if (!reply_age_update(r, response)) {
+			continue;
+		}
+
+		r->reply(response, r, from);
+		return r;
+	}
+
+	return NULL;
+}
+#endif /* CONFIG_COAP_INDEX */
+
 int coap_packet_append_payload_marker(struct coap_packet *cpkt)
 {
 	return net_pkt_append_u8_timeout(cpkt->pkt, COAP_MARKER,
@@ -1074,8 +1346,6 @@ int coap_find_options(const struct coap_packet *cpkt, u16_t code,
 {
 	struct option_context context = {
 					  .delta = 0,
-					  .frag = NULL,
-					  .offset = 0
 					};
 	u16_t opt_len;
 	int count;
@@ -1086,9 +1356,10 @@ int coap_find_options(const struct coap_packet *cpkt, u16_t code,
 	}
 
 	/* Skip CoAP header */
-	context.frag = net_frag_skip(cpkt->frag, cpkt->offset,
-				     &context.offset, cpkt->hdr_len);
-	r = check_frag_read_status(context.frag, context.offset);
+	net_pkt_cursor_set(&context.cursor, cpkt->pkt, cpkt->frag,
+			   cpkt->offset);
+	r = net_pkt_cursor_skip(&context.cursor, cpkt->hdr_len);
+	r = check_cursor_read_status(&context.cursor, r);
 	if (r <= 0) {
 		return r;
 	}
@@ -1192,6 +1463,7 @@ u8_t coap_header_get_code(const struct coap_packet *cpkt)
 	case COAP_METHOD_POST:
 	case COAP_METHOD_PUT:
 	case COAP_METHOD_DELETE:
+	case COAP_METHOD_FETCH:
 
 	/* All the defined response codes */
 	case COAP_RESPONSE_CODE_OK:
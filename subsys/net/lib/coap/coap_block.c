@@ -0,0 +1,879 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_coap_block
+#define NET_LOG_LEVEL CONFIG_COAP_LOG_LEVEL
+
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <misc/byteorder.h>
+#include <net/buf.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+
+#include <net/coap.h>
+#include <net/coap_block.h>
+
+#define COAP_VERSION 1
+
+/* Values as per RFC 7252, section 4.8 */
+#define MAX_RETRANSMIT 4
+
+#define TOKEN_LEN 8
+
+#define BLOCK_SIZE(v) ((v) & 0x07)
+#define BLOCK_MORE(v) (!!((v) & 0x08))
+#define BLOCK_NUM(v) ((v) >> 4)
+#define BLOCK_OFFSET(v) (BLOCK_NUM(v) << (BLOCK_SIZE(v) + 4))
+
+#define CODE_CLASS(code) ((code) >> 5)
+
+static inline size_t block_bytes(enum coap_block_size block_size)
+{
+	return coap_block_size_to_bytes(block_size);
+}
+
+static unsigned int block_value(size_t offset, bool more,
+				enum coap_block_size block_size)
+{
+	return ((offset >> (block_size + 4)) << 4) | (more ? 0x08 : 0) |
+		block_size;
+}
+
+static int get_block_option(const struct coap_packet *cpkt, u16_t code)
+{
+	struct coap_option option;
+
+	if (coap_find_options(cpkt, code, &option, 1) <= 0) {
+		return -ENOENT;
+	}
+
+	return coap_option_value_to_int(&option);
+}
+
+/* Passes the payload of a message to the consumer, fragment by fragment */
+static int write_payload(struct coap_blockwise *bw,
+			 const struct coap_packet *cpkt, size_t offset,
+			 bool last, u16_t *len)
+{
+	struct net_buf *frag;
+	u16_t pos, remaining, chunk;
+	int r;
+
+	frag = coap_packet_get_payload(cpkt, &pos, len);
+	if (!frag && pos == 0xffff) {
+		return -EINVAL;
+	}
+
+	if (!frag || !*len) {
+		*len = 0;
+		return last ? bw->write(bw, offset, NULL, 0, true) : 0;
+	}
+
+	remaining = *len;
+
+	while (frag && remaining) {
+		chunk = min(frag->len - pos, remaining);
+		remaining -= chunk;
+
+		r = bw->write(bw, offset, frag->data + pos, chunk,
+			      last && !remaining);
+		if (r < 0) {
+			return r;
+		}
+
+		offset += chunk;
+		frag = frag->frags;
+		pos = 0;
+	}
+
+	return remaining ? -EINVAL : 0;
+}
+
+static void slot_release(struct coap_blockwise *bw,
+			 struct coap_block_slot *slot)
+{
+	net_pkt_unref(slot->pkt);
+	slot->pkt = NULL;
+	bw->in_flight--;
+}
+
+static struct coap_block_slot *slot_find(struct coap_blockwise *bw,
+					 size_t offset)
+{
+	int i;
+
+	for (i = 0; i < bw->window; i++) {
+		if (bw->slots[i].pkt && bw->slots[i].offset == offset) {
+			return &bw->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct coap_block_slot *slot_next_unused(struct coap_blockwise *bw)
+{
+	int i;
+
+	for (i = 0; i < bw->window; i++) {
+		if (!bw->slots[i].pkt) {
+			return &bw->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void finish(struct coap_blockwise *bw, int status)
+{
+	int i;
+
+	for (i = 0; i < bw->window; i++) {
+		if (bw->slots[i].pkt) {
+			slot_release(bw, &bw->slots[i]);
+		}
+	}
+
+	bw->active = false;
+
+	if (bw->done) {
+		bw->done(bw, status);
+	}
+}
+
+static int append_path(struct coap_packet *cpkt, const char * const *path)
+{
+	int r;
+
+	for (; path && *path; path++) {
+		r = coap_packet_append_option(cpkt, COAP_OPTION_URI_PATH,
+					      (const u8_t *)*path,
+					      strlen(*path));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+static bool is_upload(struct coap_blockwise *bw)
+{
+	return bw->method != COAP_METHOD_GET;
+}
+
+/* Sends the request of the block at bw->next, on a client */
+static int send_block(struct coap_blockwise *bw,
+		      struct coap_block_slot *slot)
+{
+	size_t bytes = block_bytes(bw->block_size);
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	u8_t token[TOKEN_LEN];
+	bool last = false;
+	int len = 0;
+	int r;
+
+	if (is_upload(bw)) {
+		len = bw->read(bw, bw->next, bw->buf, bytes, &last);
+		if (len < 0) {
+			return len;
+		}
+
+		if ((size_t)len > bytes || (!last && len != bytes)) {
+			return -EINVAL;
+		}
+	}
+
+	pkt = bw->alloc(bw);
+	if (!pkt) {
+		return -ENOMEM;
+	}
+
+	memcpy(token, bw->token, sizeof(bw->token));
+	sys_put_be32(bw->next, token + sizeof(bw->token));
+
+	r = coap_packet_init(&cpkt, pkt, COAP_VERSION, COAP_TYPE_CON,
+			     sizeof(token), token, bw->method, coap_next_id());
+	if (r < 0) {
+		goto error;
+	}
+
+	r = append_path(&cpkt, bw->path);
+	if (r < 0) {
+		goto error;
+	}
+
+	if (is_upload(bw)) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_BLOCK1,
+					   block_value(bw->next, !last,
+						       bw->block_size));
+	} else {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_BLOCK2,
+					   block_value(bw->next, false,
+						       bw->block_size));
+	}
+
+	if (r < 0) {
+		goto error;
+	}
+
+	if (len) {
+		r = coap_packet_append_payload_marker(&cpkt);
+		if (r < 0) {
+			goto error;
+		}
+
+		r = coap_packet_append_payload(&cpkt, bw->buf, len);
+		if (r < 0) {
+			goto error;
+		}
+	}
+
+	slot->pkt = pkt;
+	slot->offset = bw->next;
+	slot->id = coap_header_get_id(&cpkt);
+	slot->sent = k_uptime_get_32();
+	slot->timeout = bw->ack_timeout;
+	slot->retries = 0;
+	bw->in_flight++;
+
+	if (last) {
+		bw->last = true;
+		bw->end = bw->next + len;
+	}
+
+	bw->next += bytes;
+
+	/* The slot keeps a reference for retransmissions, a lost
+	 * message is sent again by coap_blockwise_poll().
+	 */
+	net_pkt_ref(pkt);
+	(void)bw->send(bw, pkt, &bw->addr);
+
+	return 0;
+
+error:
+	net_pkt_unref(pkt);
+	return r;
+}
+
+/* Requests blocks until the window is full, or the body is covered */
+static int fill_window(struct coap_blockwise *bw)
+{
+	size_t bytes = block_bytes(bw->block_size);
+	u8_t window = bw->negotiated ? bw->window : 1;
+	struct coap_block_slot *slot;
+	int r;
+
+	while (bw->in_flight < window && !bw->last &&
+	       bw->next < bw->base + window * bytes) {
+		slot = slot_next_unused(bw);
+		if (!slot) {
+			break;
+		}
+
+		r = send_block(bw, slot);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+int coap_blockwise_client_init(struct coap_blockwise *bw, u8_t method,
+			       const struct sockaddr *addr,
+			       const char * const *path,
+			       enum coap_block_size block_size, u8_t window)
+{
+	if (!bw || !addr || !bw->alloc || !bw->send) {
+		return -EINVAL;
+	}
+
+	if (method == COAP_METHOD_GET) {
+		if (!bw->write) {
+			return -EINVAL;
+		}
+	} else if (method == COAP_METHOD_PUT || method == COAP_METHOD_POST) {
+		if (!bw->read) {
+			return -EINVAL;
+		}
+	} else {
+		return -EINVAL;
+	}
+
+	if (block_bytes(block_size) > CONFIG_COAP_BLOCKWISE_MAX_BLOCK_SIZE ||
+	    window == 0 || window > CONFIG_COAP_BLOCKWISE_WINDOW) {
+		return -EINVAL;
+	}
+
+	(void)memset(bw->slots, 0, sizeof(bw->slots));
+	memcpy(&bw->addr, addr, sizeof(bw->addr));
+	memcpy(bw->token, coap_next_token(), sizeof(bw->token));
+
+	bw->path = path;
+	bw->method = method;
+	bw->block_size = block_size;
+	bw->window = window;
+	bw->in_flight = 0;
+	bw->active = false;
+
+	if (!bw->ack_timeout) {
+		bw->ack_timeout = CONFIG_COAP_INIT_ACK_TIMEOUT_MS;
+	}
+
+	return 0;
+}
+
+int coap_blockwise_start(struct coap_blockwise *bw)
+{
+	int r;
+
+	if (bw->active) {
+		return -EALREADY;
+	}
+
+	bw->base = 0;
+	bw->next = 0;
+	bw->end = 0;
+	bw->acked = 0;
+	bw->code = 0;
+	bw->negotiated = false;
+	bw->last = false;
+	bw->active = true;
+
+	r = fill_window(bw);
+	if (r < 0) {
+		finish(bw, r);
+	}
+
+	return r;
+}
+
+/* The first response fixes the block size of the next blocks */
+static int negotiate(struct coap_blockwise *bw, int block)
+{
+	if (block >= 0 && BLOCK_SIZE(block) < bw->block_size) {
+		bw->block_size = BLOCK_SIZE(block);
+
+		/* A server takes all of a larger first block, but sends
+		 * the first block of its size.
+		 */
+		if (!is_upload(bw)) {
+			bw->next = block_bytes(bw->block_size);
+		}
+	}
+
+	bw->base = bw->next;
+	bw->acked = 0;
+	bw->negotiated = true;
+
+	return 0;
+}
+
+static int handle_block(struct coap_blockwise *bw,
+			const struct coap_packet *response,
+			struct coap_block_slot *slot)
+{
+	size_t offset = slot->offset;
+	u8_t code = coap_header_get_code(response);
+	bool more;
+	u16_t len;
+	int block, r;
+
+	block = get_block_option(response, is_upload(bw) ?
+				 COAP_OPTION_BLOCK1 : COAP_OPTION_BLOCK2);
+
+	if (!is_upload(bw)) {
+		if (block >= 0 && BLOCK_OFFSET(block) != offset) {
+			return -EINVAL;
+		}
+
+		/* Without Block2 option, the whole body is in the response */
+		more = block >= 0 && BLOCK_MORE(block);
+
+		r = write_payload(bw, response, offset, !more, &len);
+		if (r < 0) {
+			return r;
+		}
+
+		if (!more) {
+			bw->last = true;
+			bw->end = offset + len;
+		}
+	}
+
+	if (code != COAP_RESPONSE_CODE_CONTINUE) {
+		bw->code = code;
+	}
+
+	slot_release(bw, slot);
+
+	if (!bw->negotiated) {
+		return negotiate(bw, block);
+	}
+
+	bw->acked |= BIT((offset - bw->base) >> (bw->block_size + 4));
+
+	while (bw->acked & 1) {
+		bw->acked >>= 1;
+		bw->base += block_bytes(bw->block_size);
+	}
+
+	return 0;
+}
+
+int coap_blockwise_response(struct coap_blockwise *bw,
+			    const struct coap_packet *response)
+{
+	struct coap_block_slot *slot;
+	u8_t token[TOKEN_LEN];
+	u8_t type, code;
+	int r;
+
+	if (!bw->active) {
+		return -ENOENT;
+	}
+
+	if (coap_header_get_token(response, token) != sizeof(token) ||
+	    memcmp(token, bw->token, sizeof(bw->token))) {
+		return -ENOENT;
+	}
+
+	slot = slot_find(bw, sys_get_be32(token + sizeof(bw->token)));
+	if (!slot) {
+		/* Response to a retransmission, already handled */
+		return 0;
+	}
+
+	type = coap_header_get_type(response);
+	code = coap_header_get_code(response);
+
+	if (type == COAP_TYPE_RESET) {
+		finish(bw, -ECONNRESET);
+		return 0;
+	}
+
+	if (code == COAP_CODE_EMPTY) {
+		/* The response will come separately */
+		return 0;
+	}
+
+	if (CODE_CLASS(code) != 2) {
+		/* The body ends before the blocks requested past its end */
+		if (!is_upload(bw) && bw->negotiated &&
+		    code == COAP_RESPONSE_CODE_BAD_OPTION) {
+			if (!bw->last || slot->offset < bw->end) {
+				bw->last = true;
+				bw->end = slot->offset;
+			}
+
+			slot_release(bw, slot);
+			goto next;
+		}
+
+		finish(bw, code);
+		return 0;
+	}
+
+	r = handle_block(bw, response, slot);
+	if (r < 0) {
+		finish(bw, r);
+		return r;
+	}
+
+next:
+	if (bw->last && bw->base >= bw->end) {
+		finish(bw, bw->code);
+		return 0;
+	}
+
+	r = fill_window(bw);
+	if (r < 0) {
+		finish(bw, r);
+	}
+
+	return r;
+}
+
+s32_t coap_blockwise_poll(struct coap_blockwise *bw)
+{
+	u32_t now = k_uptime_get_32();
+	s32_t next = K_FOREVER;
+	struct coap_block_slot *slot;
+	s32_t remaining;
+	int i;
+
+	for (i = 0; i < bw->window; i++) {
+		slot = &bw->slots[i];
+		if (!slot->pkt) {
+			continue;
+		}
+
+		remaining = slot->timeout - (s32_t)(now - slot->sent);
+		if (remaining <= 0) {
+			if (slot->retries == MAX_RETRANSMIT) {
+				finish(bw, -ETIMEDOUT);
+				return K_FOREVER;
+			}
+
+			net_pkt_ref(slot->pkt);
+			(void)bw->send(bw, slot->pkt, &bw->addr);
+
+			slot->retries++;
+			slot->timeout <<= 1;
+			slot->sent = now;
+			remaining = slot->timeout;
+		}
+
+		if (next == K_FOREVER || remaining < next) {
+			next = remaining;
+		}
+	}
+
+	return next;
+}
+
+void coap_blockwise_cancel(struct coap_blockwise *bw)
+{
+	int i;
+
+	for (i = 0; i < bw->window; i++) {
+		if (bw->slots[i].pkt) {
+			slot_release(bw, &bw->slots[i]);
+		}
+	}
+
+	bw->active = false;
+}
+
+int coap_blockwise_server_init(struct coap_blockwise *bw,
+			       enum coap_block_size block_size, u8_t code)
+{
+	if (!bw || !bw->alloc || !bw->send ||
+	    block_bytes(block_size) > CONFIG_COAP_BLOCKWISE_MAX_BLOCK_SIZE) {
+		return -EINVAL;
+	}
+
+	(void)memset(bw->slots, 0, sizeof(bw->slots));
+
+	bw->path = NULL;
+	bw->block_size = block_size;
+	bw->code = code;
+	bw->window = CONFIG_COAP_BLOCKWISE_WINDOW;
+	bw->in_flight = 0;
+	bw->last = false;
+	bw->active = false;
+
+	return 0;
+}
+
+static int init_response(struct coap_blockwise *bw,
+			 const struct coap_packet *request,
+			 struct coap_packet *response, u8_t code)
+{
+	u8_t token[TOKEN_LEN];
+	struct net_pkt *pkt;
+	u8_t tkl, type;
+	u16_t id;
+	int r;
+
+	pkt = bw->alloc(bw);
+	if (!pkt) {
+		return -ENOMEM;
+	}
+
+	tkl = coap_header_get_token(request, token);
+
+	if (coap_header_get_type(request) == COAP_TYPE_CON) {
+		type = COAP_TYPE_ACK;
+		id = coap_header_get_id(request);
+	} else {
+		type = COAP_TYPE_NON_CON;
+		id = coap_next_id();
+	}
+
+	r = coap_packet_init(response, pkt, COAP_VERSION, type, tkl, token,
+			     code, id);
+	if (r < 0) {
+		net_pkt_unref(pkt);
+	}
+
+	return r;
+}
+
+static int send_response(struct coap_blockwise *bw,
+			 const struct coap_packet *request,
+			 const struct sockaddr *to, u8_t code,
+			 u16_t option, int block)
+{
+	struct coap_packet response;
+	int r;
+
+	r = init_response(bw, request, &response, code);
+	if (r < 0) {
+		return r;
+	}
+
+	if (block >= 0) {
+		r = coap_append_option_int(&response, option, block);
+		if (r < 0) {
+			net_pkt_unref(response.pkt);
+			return r;
+		}
+	}
+
+	return bw->send(bw, response.pkt, to);
+}
+
+/* Acknowledges a confirmable request whose response comes later */
+static int send_empty_ack(struct coap_blockwise *bw,
+			  const struct coap_packet *request,
+			  const struct sockaddr *to)
+{
+	struct coap_packet ack;
+	struct net_pkt *pkt;
+	int r;
+
+	if (coap_header_get_type(request) != COAP_TYPE_CON) {
+		return 0;
+	}
+
+	pkt = bw->alloc(bw);
+	if (!pkt) {
+		return -ENOMEM;
+	}
+
+	r = coap_packet_init(&ack, pkt, COAP_VERSION, COAP_TYPE_ACK, 0, NULL,
+			     COAP_CODE_EMPTY, coap_header_get_id(request));
+	if (r < 0) {
+		net_pkt_unref(pkt);
+		return r;
+	}
+
+	return bw->send(bw, pkt, to);
+}
+
+/* Serves any block of the body, the server keeps no state */
+static int serve_block2(struct coap_blockwise *bw,
+			const struct coap_packet *request,
+			const struct sockaddr *from)
+{
+	enum coap_block_size block_size = bw->block_size;
+	struct coap_packet response;
+	size_t offset = 0;
+	bool last = false;
+	int block, len, r;
+
+	block = get_block_option(request, COAP_OPTION_BLOCK2);
+	if (block >= 0) {
+		block_size = min(BLOCK_SIZE(block), bw->block_size);
+		offset = BLOCK_OFFSET(block);
+	}
+
+	len = bw->read(bw, offset, bw->buf, block_bytes(block_size), &last);
+	if (len < 0) {
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_INTERNAL_ERROR, 0, -1);
+	}
+
+	if (len == 0 && offset > 0) {
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_BAD_OPTION, 0, -1);
+	}
+
+	r = init_response(bw, request, &response,
+			  COAP_RESPONSE_CODE_CONTENT);
+	if (r < 0) {
+		return r;
+	}
+
+	r = coap_append_option_int(&response, COAP_OPTION_BLOCK2,
+				   block_value(offset, !last, block_size));
+	if (r < 0) {
+		goto error;
+	}
+
+	if (len) {
+		r = coap_packet_append_payload_marker(&response);
+		if (r < 0) {
+			goto error;
+		}
+
+		r = coap_packet_append_payload(&response, bw->buf, len);
+		if (r < 0) {
+			goto error;
+		}
+	}
+
+	return bw->send(bw, response.pkt, from);
+
+error:
+	net_pkt_unref(response.pkt);
+	return r;
+}
+
+static bool same_peer(const struct sockaddr *a, const struct sockaddr *b)
+{
+	if (a->sa_family != b->sa_family) {
+		return false;
+	}
+
+	if (a->sa_family == AF_INET6) {
+		return net_sin6(a)->sin6_port == net_sin6(b)->sin6_port &&
+			net_ipv6_addr_cmp(&net_sin6(a)->sin6_addr,
+					  &net_sin6(b)->sin6_addr);
+	}
+
+	if (a->sa_family == AF_INET) {
+		return net_sin(a)->sin_port == net_sin(b)->sin_port &&
+			net_ipv4_addr_cmp(&net_sin(a)->sin_addr,
+					  &net_sin(b)->sin_addr);
+	}
+
+	return false;
+}
+
+/* Receives the blocks of a body, in any order within the window. The
+ * last block is only answered once the ones before it are received.
+ */
+static int receive_block1(struct coap_blockwise *bw,
+			  const struct coap_packet *request,
+			  const struct sockaddr *from)
+{
+	enum coap_block_size block_size = bw->block_size;
+	size_t offset = 0, bit;
+	bool more = false;
+	int block, r;
+	u16_t len;
+
+	block = get_block_option(request, COAP_OPTION_BLOCK1);
+	if (block >= 0) {
+		block_size = BLOCK_SIZE(block);
+		offset = BLOCK_OFFSET(block);
+		more = BLOCK_MORE(block);
+	}
+
+	if (offset == 0 && (!bw->active || bw->base == 0)) {
+		memcpy(&bw->addr, from, sizeof(bw->addr));
+		bw->base = 0;
+		bw->end = 0;
+		bw->acked = 0;
+		bw->last = false;
+		bw->active = true;
+	}
+
+	if (!same_peer(&bw->addr, from)) {
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE,
+				     0, -1);
+	}
+
+	if (!bw->active) {
+		/* Last block again, its response was lost */
+		if (bw->last && !more && offset < bw->end) {
+			goto done;
+		}
+
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_INCOMPLETE, 0, -1);
+	}
+
+	if (offset < bw->base) {
+		goto ack;
+	}
+
+	bit = (offset - bw->base) >> (block_size + 4);
+	if (bit >= bw->window) {
+		/* Out of the window, the block is not stored */
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_INCOMPLETE, 0, -1);
+	}
+
+	if (bw->acked & BIT(bit)) {
+		goto ack;
+	}
+
+	r = write_payload(bw, request, offset, !more, &len);
+	if (r < 0) {
+		finish(bw, r);
+		return send_response(bw, request, from,
+				     COAP_RESPONSE_CODE_INTERNAL_ERROR, 0, -1);
+	}
+
+	bw->acked |= BIT(bit);
+
+	if (!more) {
+		bw->last = true;
+		bw->end = offset + len;
+	}
+
+	if (offset == 0) {
+		/* The client uses the block size of the server after it */
+		bw->base = len;
+		bw->acked = 0;
+	}
+
+	while (bw->acked & 1) {
+		bw->acked >>= 1;
+		bw->base += block_bytes(block_size);
+	}
+
+ack:
+	if (bw->last && bw->base >= bw->end) {
+		finish(bw, bw->code);
+		goto done;
+	}
+
+	if (!more) {
+		/* The final response is sent once the missing blocks are
+		 * received, stop the retransmissions of this one meanwhile.
+		 */
+		return send_empty_ack(bw, request, from);
+	}
+
+	if (offset == 0) {
+		block_size = min(block_size, bw->block_size);
+	}
+
+	return send_response(bw, request, from,
+			     COAP_RESPONSE_CODE_CONTINUE, COAP_OPTION_BLOCK1,
+			     block_value(offset, true, block_size));
+
+done:
+	return send_response(bw, request, from, bw->code,
+			     COAP_OPTION_BLOCK1,
+			     block_value(offset, false, block_size));
+}
+
+int coap_blockwise_request(struct coap_blockwise *bw,
+			   const struct coap_packet *request,
+			   const struct sockaddr *from)
+{
+	switch (coap_header_get_code(request)) {
+	case COAP_METHOD_GET:
+		if (!bw->read) {
+			return -EINVAL;
+		}
+
+		return serve_block2(bw, request, from);
+	case COAP_METHOD_PUT:
+	case COAP_METHOD_POST:
+		if (!bw->write) {
+			return -EINVAL;
+		}
+
+		return receive_block1(bw, request, from);
+	default:
+		return -EINVAL;
+	}
+}
@@ -0,0 +1,270 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * Answers of the DNS servers are kept for the time to live given by the
+ * server. Negative answers are cached as described in RFC 2308. When the
+ * cache is full, the least recently used answer is replaced.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_dns_cache
+#define NET_LOG_LEVEL CONFIG_DNS_RESOLVER_LOG_LEVEL
+
+#include <zephyr.h>
+#include <string.h>
+#include <strings.h>
+#include <misc/dlist.h>
+
+#include <net/net_core.h>
+#include <net/net_ip.h>
+#include <net/dns_resolve.h>
+
+#include "dns_cache.h"
+
+struct dns_cache_entry {
+	/** Node in the LRU list */
+	sys_dnode_t node;
+
+	/** Uptime in milliseconds when the answer expires */
+	s64_t expires;
+
+	/** Number of queries answered from this entry */
+	u32_t hits;
+
+	/** Query type */
+	enum dns_query_type type;
+
+	/** Status of the answer */
+	enum dns_resolve_status status;
+
+	/** Number of addresses */
+	u8_t count;
+
+	/** Name that was resolved, empty if the entry is not in use */
+	char name[CONFIG_DNS_RESOLVER_CACHE_MAX_NAME_LEN + 1];
+
+	/** Addresses of a positive answer, packed one after another */
+	u8_t addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS *
+		  sizeof(struct in6_addr)];
+};
+
+static struct dns_cache_entry entries[CONFIG_DNS_RESOLVER_CACHE_SIZE];
+
+/* Entries in use, the most recently used one first */
+static sys_dlist_t lru_list = SYS_DLIST_STATIC_INIT(&lru_list);
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static inline size_t addr_len(enum dns_query_type type)
+{
+	return type == DNS_QUERY_TYPE_A ? sizeof(struct in_addr) :
+		sizeof(struct in6_addr);
+}
+
+static void cache_remove(struct dns_cache_entry *entry)
+{
+	sys_dlist_remove(&entry->node);
+	entry->name[0] = '\0';
+}
+
+static struct dns_cache_entry *cache_find(const char *name,
+					  enum dns_query_type type,
+					  s64_t now)
+{
+	struct dns_cache_entry *entry, *next;
+
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&lru_list, entry, next, node) {
+		if (entry->expires <= now) {
+			NET_DBG("Expired %s", entry->name);
+			cache_remove(entry);
+			continue;
+		}
+
+		/* DNS names are case insensitive, RFC 4343 */
+		if (entry->type == type &&
+		    !strncasecmp(entry->name, name, sizeof(entry->name))) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static struct dns_cache_entry *cache_get_entry(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(entries); i++) {
+		if (!entries[i].name[0]) {
+			return &entries[i];
+		}
+	}
+
+	/* Replace the least recently used answer */
+	return CONTAINER_OF(sys_dlist_peek_tail(&lru_list),
+			    struct dns_cache_entry, node);
+}
+
+int dns_cache_lookup(const char *name, enum dns_query_type type,
+		     dns_resolve_cb_t cb, void *user_data)
+{
+	struct dns_addrinfo info = { 0 };
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry copy;
+	int i;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	entry = cache_find(name, type, k_uptime_get());
+	if (!entry) {
+		k_mutex_unlock(&cache_lock);
+		return -ENOENT;
+	}
+
+	entry->hits++;
+
+	sys_dlist_remove(&entry->node);
+	sys_dlist_prepend(&lru_list, &entry->node);
+
+	/* The callback is called without holding the lock */
+	memcpy(&copy, entry, sizeof(copy));
+
+	k_mutex_unlock(&cache_lock);
+
+	NET_DBG("Cache hit %s type %d status %d", copy.name, type,
+		copy.status);
+
+	if (copy.status != DNS_EAI_ALLDONE) {
+		cb(copy.status, NULL, user_data);
+		return 0;
+	}
+
+	for (i = 0; i < copy.count; i++) {
+		if (type == DNS_QUERY_TYPE_A) {
+			memcpy(&net_sin(&info.ai_addr)->sin_addr,
+			       copy.addr + i * sizeof(struct in_addr),
+			       sizeof(struct in_addr));
+			info.ai_family = AF_INET;
+			info.ai_addr.sa_family = AF_INET;
+			info.ai_addrlen = sizeof(struct sockaddr_in);
+		} else {
+#if defined(CONFIG_NET_IPV6)
+			memcpy(&net_sin6(&info.ai_addr)->sin6_addr,
+			       copy.addr + i * sizeof(struct in6_addr),
+			       sizeof(struct in6_addr));
+			info.ai_family = AF_INET6;
+			info.ai_addr.sa_family = AF_INET6;
+			info.ai_addrlen = sizeof(struct sockaddr_in6);
+#else
+			continue;
+#endif
+		}
+
+		cb(DNS_EAI_INPROGRESS, &info, user_data);
+	}
+
+	cb(DNS_EAI_ALLDONE, NULL, user_data);
+
+	return 0;
+}
+
+void dns_cache_add(const char *name, enum dns_query_type type,
+		   enum dns_resolve_status status, const u8_t *addr,
+		   int count, u32_t ttl)
+{
+	struct dns_cache_entry *entry;
+	size_t len = strlen(name);
+	s64_t now;
+
+	if (status == DNS_EAI_ALLDONE) {
+		ttl = min(ttl, CONFIG_DNS_RESOLVER_CACHE_MAX_TTL);
+	} else {
+		ttl = min(ttl, CONFIG_DNS_RESOLVER_CACHE_NEG_TTL);
+	}
+
+	/* An answer with zero TTL must not be cached, RFC 1035 3.2.1 */
+	if (!ttl || !len || len > CONFIG_DNS_RESOLVER_CACHE_MAX_NAME_LEN) {
+		return;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	entry = cache_find(name, type, now);
+	if (!entry) {
+		entry = cache_get_entry();
+		entry->hits = 0;
+	}
+
+	if (entry->name[0]) {
+		sys_dlist_remove(&entry->node);
+	}
+
+	memcpy(entry->name, name, len + 1);
+	entry->type = type;
+	entry->status = status;
+	entry->expires = now + (s64_t)ttl * MSEC_PER_SEC;
+	entry->count = min(count, CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS);
+	memcpy(entry->addr, addr, entry->count * addr_len(type));
+
+	sys_dlist_prepend(&lru_list, &entry->node);
+
+	k_mutex_unlock(&cache_lock);
+
+	NET_DBG("Cached %s type %d status %d ttl %u", entry->name, type,
+		status, ttl);
+}
+
+int dns_cache_foreach(dns_cache_cb_t cb, void *user_data)
+{
+	struct dns_cache_entry *entry, *next;
+	struct dns_cache_info info;
+	int count = 0;
+	s64_t now;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&lru_list, entry, next, node) {
+		if (entry->expires <= now) {
+			cache_remove(entry);
+			continue;
+		}
+
+		info.name = entry->name;
+		info.addr = entry->addr;
+		info.ttl = (entry->expires - now + MSEC_PER_SEC - 1) /
+			MSEC_PER_SEC;
+		info.hits = entry->hits;
+		info.type = entry->type;
+		info.status = entry->status;
+		info.count = entry->count;
+
+		cb(&info, user_data);
+		count++;
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return count;
+}
+
+void dns_cache_flush(void)
+{
+	struct dns_cache_entry *entry, *next;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&lru_list, entry, next, node) {
+		cache_remove(entry);
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,55 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * Internal API of the DNS answer cache used by the DNS resolver.
+ */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _DNS_CACHE_H_
+#define _DNS_CACHE_H_
+
+#include <zephyr/types.h>
+#include <net/dns_resolve.h>
+
+/**
+ * @brief Resolve a name from the cache.
+ *
+ * @details If a valid answer is found in the cache, the callback is called
+ * with the cached addresses, or with the status of a negative answer,
+ * before this function returns.
+ *
+ * @param name Name to resolve
+ * @param type Query type
+ * @param cb Result callback
+ * @param user_data User data passed to the callback
+ *
+ * @return 0 if the name was resolved, -ENOENT if it is not in the cache.
+ */
+int dns_cache_lookup(const char *name, enum dns_query_type type,
+		     dns_resolve_cb_t cb, void *user_data);
+
+/**
+ * @brief Add an answer to the cache.
+ *
+ * @details An existing answer for the same name and type is replaced.
+ * If the cache is full, the least recently used answer is dropped.
+ *
+ * @param name Name that was resolved
+ * @param type Query type
+ * @param status DNS_EAI_ALLDONE for a positive answer, DNS_EAI_NONAME or
+ * DNS_EAI_NODATA for a negative one.
+ * @param addr Addresses of a positive answer, 4 bytes each for
+ * DNS_QUERY_TYPE_A and 16 bytes each for DNS_QUERY_TYPE_AAAA.
+ * @param count Number of addresses
+ * @param ttl Time to live of the answer in seconds
+ */
+void dns_cache_add(const char *name, enum dns_query_type type,
+		   enum dns_resolve_status status, const u8_t *addr,
+		   int count, u32_t ttl);
+
+#endif /* _DNS_CACHE_H_ */
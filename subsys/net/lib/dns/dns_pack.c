@@ -173,7 +173,6 @@ int dns_unpack_response_header(struct dns_msg_t *msg, int src_id)
 	u8_t *dns_header;
 	u16_t size;
 	int qdcount;
-	int ancount;
 	int rc;
 
 	dns_header = msg->msg;
@@ -208,9 +207,11 @@ int dns_unpack_response_header(struct dns_msg_t *msg, int src_id)
 
 	}
 
+	/* A response without answers is a valid negative response,
+	 * see RFC 2308 2.2. No Data
+	 */
 	qdcount = dns_unpack_header_qdcount(dns_header);
-	ancount = dns_unpack_header_ancount(dns_header);
-	if (qdcount < 1 || ancount < 1) {
+	if (qdcount < 1) {
 		return -EINVAL;
 	}
 
@@ -345,6 +346,85 @@ int dns_unpack_response_query(struct dns_msg_t *dns_msg)
 	return 0;
 }
 
+/* Returns the number of octets a possibly compressed name takes in msg */
+static int dns_skip_name(const u8_t *msg, u16_t size, u16_t pos)
+{
+	u16_t start = pos;
+	u8_t lb_size;
+
+	while (pos < size) {
+		lb_size = msg[pos];
+
+		if (lb_size == 0) {
+			return pos + DNS_LABEL_LEN_SIZE - start;
+		}
+
+		/* A pointer always ends the name, see RFC 1035, 4.1.4. */
+		if ((lb_size & NS_CMPRSFLGS) == NS_CMPRSFLGS) {
+			if (pos + 2 > size) {
+				return -ENOMEM;
+			}
+
+			return pos + 2 - start;
+		}
+
+		pos += DNS_LABEL_LEN_SIZE + lb_size;
+	}
+
+	return -ENOMEM;
+}
+
+int dns_unpack_negative_ttl(struct dns_msg_t *dns_msg, u32_t *ttl)
+{
+	u16_t msg_size = dns_msg->msg_size;
+	u8_t *msg = dns_msg->msg;
+	u16_t pos = dns_msg->answer_offset;
+	int ancount, count, rdlength, type, len, i;
+	u32_t rr_ttl, minimum;
+
+	ancount = dns_unpack_header_ancount(msg);
+	count = ancount + dns_unpack_header_nscount(msg);
+
+	for (i = 0; i < count; i++) {
+		len = dns_skip_name(msg, msg_size, pos);
+		if (len < 0) {
+			return len;
+		}
+
+		/* type + class + ttl + rdlength */
+		pos += len;
+		if (pos + DNS_ANSWER_MIN_SIZE - DNS_COMMON_UINT_SIZE >
+		    msg_size) {
+			return -ENOMEM;
+		}
+
+		type = ntohs(UNALIGNED_GET((u16_t *)(msg + pos)));
+		rr_ttl = ntohl(UNALIGNED_GET((u32_t *)(msg + pos + 4)));
+		rdlength = ntohs(UNALIGNED_GET((u16_t *)(msg + pos + 8)));
+
+		pos += DNS_ANSWER_MIN_SIZE - DNS_COMMON_UINT_SIZE;
+		if (pos + rdlength > msg_size) {
+			return -ENOMEM;
+		}
+
+		/* MINIMUM is the last field of the SOA RDATA, after two names
+		 * and four 32-bit values.
+		 */
+		if (i >= ancount && type == DNS_RR_TYPE_SOA &&
+		    rdlength >= 2 + 5 * sizeof(u32_t)) {
+			minimum = ntohl(UNALIGNED_GET((u32_t *)(msg + pos +
+								rdlength - 4)));
+			*ttl = min(rr_ttl, minimum);
+
+			return 0;
+		}
+
+		pos += rdlength;
+	}
+
+	return -ENOENT;
+}
+
 int dns_copy_qname(u8_t *buf, u16_t *len, u16_t size,
 		   struct dns_msg_t *dns_msg, u16_t pos)
 {
@@ -55,6 +55,7 @@ enum dns_rr_type {
 	DNS_RR_TYPE_INVALID = 0,
 	DNS_RR_TYPE_A	= 1,		/* IPv4  */
 	DNS_RR_TYPE_CNAME = 5,		/* CNAME */
+	DNS_RR_TYPE_SOA = 6,		/* SOA   */
 	DNS_RR_TYPE_AAAA = 28		/* IPv6  */
 };
 
@@ -175,6 +176,11 @@ static inline int dns_header_nscount(u8_t *header)
 	return htons(UNALIGNED_GET((u16_t *)(header + 8)));
 }
 
+static inline int dns_unpack_header_nscount(u8_t *header)
+{
+	return ntohs(UNALIGNED_GET((u16_t *)(header + 8)));
+}
+
 /** It returns the ARCOUNT field in the DNS msg header	*/
 static inline int dns_header_arcount(u8_t *header)
 {
@@ -268,7 +274,7 @@ int dns_unpack_answer(struct dns_msg_t *dns_msg, int dname_ptr, u32_t *ttl);
  * @retval -EINVAL if the src_id does not match the header's id, or if the
  *         header's QR value is not DNS_RESPONSE or if the header's OPCODE
  *         value is not DNS_QUERY, or if the header's Z value is not 0 or if
- *         the question counter is not 1 or the answer counter is less than 1.
+ *         the question counter is less than 1.
  * @retval RFC 1035 RCODEs (> 0) 1 Format error, 2 Server failure, 3 Name Error,
  *         4 Not Implemented and 5 Refused.
  */
@@ -309,6 +315,22 @@ int dns_msg_pack_query(u8_t *buf, u16_t *len, u16_t size,
  */
 int dns_unpack_response_query(struct dns_msg_t *dns_msg);
 
+/**
+ * @brief Unpacks the TTL of a negative response.
+ *
+ * @details RFC 2308, 5. Caching Negative Answers states that the TTL is the
+ *          minimum of the SOA record's TTL and its MINIMUM field. The SOA
+ *          record is searched in the authority section, so answer_offset
+ *          must be computed first, see dns_unpack_response_query.
+ *
+ * @param dns_msg Structure containing the message.
+ * @param ttl TTL of the negative response.
+ * @retval 0 on success
+ * @retval -ENOENT if there is no SOA record in the authority section.
+ * @retval -ENOMEM if a record does not fit into the message.
+ */
+int dns_unpack_negative_ttl(struct dns_msg_t *dns_msg, u32_t *ttl);
+
 /**
  * @brief Copies the qname from dns_msg to buf
  *
@@ -17,11 +17,13 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <strings.h>
 
 #include <net/net_ip.h>
 #include <net/net_pkt.h>
 #include <net/dns_resolve.h>
 #include "dns_pack.h"
+#include "dns_cache.h"
 
 #define DNS_SERVER_COUNT CONFIG_DNS_RESOLVER_MAX_SERVERS
 #define SERVER_COUNT     (DNS_SERVER_COUNT + DNS_MAX_MCAST_SERVERS)
@@ -320,6 +322,78 @@ static inline int get_slot_by_id(struct dns_resolve_context *ctx,
 	return -ENOENT;
 }
 
+static inline int get_slot_by_wire_id(struct dns_resolve_context *ctx,
+				      u16_t wire_id)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (ctx->queries[i].cb && ctx->queries[i].wire_id == wire_id) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+static inline int get_slot_by_name(struct dns_resolve_context *ctx,
+				   const char *name,
+				   enum dns_query_type type)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (ctx->queries[i].cb && ctx->queries[i].name[0] &&
+		    ctx->queries[i].query_type == type &&
+		    !strncasecmp(ctx->queries[i].name, name,
+				 sizeof(ctx->queries[i].name))) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+#endif
+
+/* Pass a resolved address to all the queries waiting for the answer */
+static void dns_deliver(struct dns_resolve_context *ctx, u16_t wire_id,
+			struct dns_addrinfo *info)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (ctx->queries[i].cb && ctx->queries[i].wire_id == wire_id) {
+			ctx->queries[i].cb(DNS_EAI_INPROGRESS, info,
+					   ctx->queries[i].user_data);
+		}
+	}
+}
+
+/* Mark the end of the results for all the queries waiting for the answer */
+static void dns_finish(struct dns_resolve_context *ctx, u16_t wire_id,
+		       int status)
+{
+	dns_resolve_cb_t cb;
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (!ctx->queries[i].cb || ctx->queries[i].wire_id != wire_id) {
+			continue;
+		}
+
+		if (k_delayed_work_remaining_get(&ctx->queries[i].timer) > 0) {
+			k_delayed_work_cancel(&ctx->queries[i].timer);
+		}
+
+		/* Free the slot first, the callback might start a new query */
+		cb = ctx->queries[i].cb;
+		ctx->queries[i].cb = NULL;
+
+		cb(status, NULL, ctx->queries[i].user_data);
+	}
+}
+
 static int dns_read(struct dns_resolve_context *ctx,
 		    struct net_pkt *pkt,
 		    struct net_buf *dns_data,
@@ -329,7 +403,12 @@ static int dns_read(struct dns_resolve_context *ctx,
 	struct dns_addrinfo info = { 0 };
 	/* Helper struct to track the dns msg received from the server */
 	struct dns_msg_t dns_msg;
-	u32_t ttl; /* RR ttl, so far it is not passed to caller */
+	u32_t ttl; /* RR ttl, it is only used for caching the answer */
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	u8_t cache_addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS * DNS_IPV6_LEN];
+	u32_t min_ttl = UINT32_MAX;
+#endif
+	bool name_error;
 	u8_t *src, *addr;
 	int address_size;
 	/* index that points to the current answer being analyzed */
@@ -362,7 +441,7 @@ static int dns_read(struct dns_resolve_context *ctx,
 	 */
 	*dns_id = dns_unpack_header_id(dns_msg.msg);
 
-	query_idx = get_slot_by_id(ctx, *dns_id);
+	query_idx = get_slot_by_wire_id(ctx, *dns_id);
 	if (query_idx < 0) {
 		ret = DNS_EAI_SYSTEM;
 		goto quit;
@@ -374,11 +453,14 @@ static int dns_read(struct dns_resolve_context *ctx,
 	}
 
 	ret = dns_unpack_response_header(&dns_msg, *dns_id);
-	if (ret < 0) {
+	if (ret < 0 ||
+	    (ret != DNS_HEADER_NOERROR && ret != DNS_HEADER_NAMEERROR)) {
 		ret = DNS_EAI_FAIL;
 		goto quit;
 	}
 
+	name_error = (ret == DNS_HEADER_NAMEERROR);
+
 	if (dns_header_qdcount(dns_msg.msg) != 1) {
 		ret = DNS_EAI_FAIL;
 		goto quit;
@@ -390,6 +472,11 @@ static int dns_read(struct dns_resolve_context *ctx,
 		goto quit;
 	}
 
+	if (name_error) {
+		ret = DNS_EAI_NONAME;
+		goto done;
+	}
+
 	if (ctx->queries[query_idx].query_type == DNS_QUERY_TYPE_A) {
 		address_size = DNS_IPV4_LEN;
 		addr = (u8_t *)&net_sin(&info.ai_addr)->sin_addr;
@@ -427,6 +514,11 @@ static int dns_read(struct dns_resolve_context *ctx,
 			goto quit;
 		}
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/* The whole answer expires with its shortest-lived record */
+		min_ttl = min(min_ttl, ttl);
+#endif
+
 		switch (dns_msg.response_type) {
 		case DNS_RESPONSE_IP:
 			if (dns_msg.response_length < address_size) {
@@ -439,8 +531,14 @@ static int dns_read(struct dns_resolve_context *ctx,
 
 			memcpy(addr, src, address_size);
 
-			ctx->queries[query_idx].cb(DNS_EAI_INPROGRESS, &info,
-					ctx->queries[query_idx].user_data);
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+			if (items < CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS) {
+				memcpy(cache_addr + items * address_size, src,
+				       address_size);
+			}
+#endif
+
+			dns_deliver(ctx, *dns_id, &info);
 			items++;
 			break;
 
@@ -488,21 +586,31 @@ static int dns_read(struct dns_resolve_context *ctx,
 		ret = DNS_EAI_ALLDONE;
 	}
 
-	if (k_delayed_work_remaining_get(&ctx->queries[query_idx].timer) > 0) {
-		k_delayed_work_cancel(&ctx->queries[query_idx].timer);
+done:
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	/* A negative answer without a SOA record is not cached, see
+	 * RFC 2308 5.
+	 */
+	if (ret == DNS_EAI_ALLDONE) {
+		dns_cache_add(ctx->queries[query_idx].name,
+			      ctx->queries[query_idx].query_type, ret,
+			      cache_addr, items, min_ttl);
+	} else if (!dns_unpack_negative_ttl(&dns_msg, &ttl)) {
+		dns_cache_add(ctx->queries[query_idx].name,
+			      ctx->queries[query_idx].query_type, ret,
+			      NULL, 0, ttl);
 	}
+#endif
 
 	/* Marks the end of the results */
-	ctx->queries[query_idx].cb(ret, NULL,
-				   ctx->queries[query_idx].user_data);
-	ctx->queries[query_idx].cb = NULL;
+	dns_finish(ctx, *dns_id, ret);
 
 	net_pkt_unref(pkt);
 
 	return 0;
 
 finished:
-	dns_resolve_cancel(ctx, *dns_id);
+	dns_finish(ctx, *dns_id, DNS_EAI_CANCELED);
 
 quit:
 	net_pkt_unref(pkt);
@@ -553,7 +661,7 @@ static void cb_recv(struct net_context *net_ctx,
 		int failure = 0;
 		int j;
 
-		i = get_slot_by_id(ctx, dns_id);
+		i = get_slot_by_wire_id(ctx, dns_id);
 		if (i < 0) {
 			goto free_buf;
 		}
@@ -582,18 +690,8 @@ static void cb_recv(struct net_context *net_ctx,
 	}
 
 quit:
-	i = get_slot_by_id(ctx, dns_id);
-	if (i < 0) {
-		goto free_buf;
-	}
-
-	if (k_delayed_work_remaining_get(&ctx->queries[i].timer) > 0) {
-		k_delayed_work_cancel(&ctx->queries[i].timer);
-	}
-
 	/* Marks the end of the results */
-	ctx->queries[i].cb(ret, NULL, ctx->queries[i].user_data);
-	ctx->queries[i].cb = NULL;
+	dns_finish(ctx, dns_id, ret);
 
 free_buf:
 	if (dns_data) {
@@ -622,7 +720,7 @@ static int dns_write(struct dns_resolve_context *ctx,
 
 	net_ctx = ctx->servers[server_idx].net_ctx;
 	server = &ctx->servers[server_idx].dns_server;
-	dns_id = ctx->queries[query_idx].id;
+	dns_id = ctx->queries[query_idx].wire_id;
 	query_type = ctx->queries[query_idx].query_type;
 
 	ret = dns_msg_pack_query(dns_data->data, &dns_data->len, dns_data->size,
@@ -795,11 +893,21 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 	}
 
 try_resolve:
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	if (!dns_cache_lookup(query, type, cb, user_data)) {
+		return 0;
+	}
+#endif
+
 	i = get_cb_slot(ctx);
 	if (i < 0) {
 		return -EAGAIN;
 	}
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	j = get_slot_by_name(ctx, query, type);
+#endif
+
 	ctx->queries[i].cb = cb;
 	ctx->queries[i].timeout = timeout;
 	ctx->queries[i].query = query;
@@ -809,6 +917,33 @@ try_resolve:
 
 	k_delayed_work_init(&ctx->queries[i].timer, query_timeout);
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	if (strlen(query) < sizeof(ctx->queries[i].name)) {
+		strcpy(ctx->queries[i].name, query);
+	} else {
+		ctx->queries[i].name[0] = '\0';
+	}
+
+	/* If the same name is already being resolved, wait for its answer
+	 * instead of sending another query.
+	 */
+	if (j >= 0) {
+		ctx->queries[i].id = sys_rand32_get();
+		ctx->queries[i].wire_id = ctx->queries[j].wire_id;
+
+		if (dns_id) {
+			*dns_id = ctx->queries[i].id;
+		}
+
+		NET_DBG("[%d] waiting for the answer of id %u", i,
+			ctx->queries[i].wire_id);
+
+		k_delayed_work_submit(&ctx->queries[i].timer, timeout);
+
+		return 0;
+	}
+#endif
+
 	dns_data = net_buf_alloc(&dns_msg_pool, ctx->buf_timeout);
 	if (!dns_data) {
 		ret = -ENOMEM;
@@ -828,6 +963,7 @@ try_resolve:
 	}
 
 	ctx->queries[i].id = sys_rand32_get();
+	ctx->queries[i].wire_id = ctx->queries[i].id;
 
 	/* Do this immediately after calculating the Id so that the unit
 	 * test will work properly.
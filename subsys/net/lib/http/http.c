@@ -19,6 +19,14 @@
 #include <net/net_ip.h>
 #include <net/http.h>
 
+#if defined(CONFIG_HTTP_SEND_STATIC)
+/* These buffers only reference the static data, they have no data of
+ * their own.
+ */
+NET_BUF_POOL_FIXED_DEFINE(http_static_bufs, CONFIG_HTTP_SEND_STATIC_BUFS,
+			  0, NULL);
+#endif
+
 int http_set_cb(struct http_ctx *ctx,
 		http_connect_cb_t connect_cb,
 		http_recv_cb_t recv_cb,
@@ -186,6 +194,86 @@ error:
 	return ret;
 }
 
+#if defined(CONFIG_HTTP_SEND_STATIC)
+int http_send_static(struct http_ctx *ctx, const void *payload,
+		     size_t payload_len, const struct sockaddr *dst,
+		     void *user_send_data)
+{
+	const u8_t *data = payload;
+	struct net_buf *frag, *rest;
+	size_t len;
+	u16_t added;
+	int ret;
+
+	while (payload_len) {
+		if (!ctx->pending) {
+			ctx->pending = get_net_pkt(ctx, dst);
+			if (!ctx->pending) {
+				return -ENOMEM;
+			}
+		}
+
+		/* Reference no more data than fits in the packet, so that
+		 * it does not need to be split.
+		 */
+		len = min(payload_len, 0xffff);
+		if (net_pkt_context(ctx->pending)) {
+			len = min(len, ctx->pending->data_len);
+		}
+
+		if (!len) {
+			ret = http_send_flush(ctx, user_send_data);
+			if (ret < 0) {
+				goto error;
+			}
+
+			continue;
+		}
+
+		frag = net_buf_alloc_with_data(&http_static_bufs,
+					       (void *)data, len,
+					       ctx->timeout);
+		if (!frag) {
+			ret = -ENOMEM;
+			goto error;
+		}
+
+		added = net_pkt_append_frags(ctx->pending, frag, &rest,
+					     ctx->timeout);
+		if (!added) {
+			net_buf_unref(frag);
+			ret = -ENOMEM;
+			goto error;
+		}
+
+		/* The data that did not fit is referenced again */
+		if (rest) {
+			net_buf_unref(rest);
+		}
+
+		data += added;
+		payload_len -= added;
+
+		if (payload_len) {
+			ret = http_send_flush(ctx, user_send_data);
+			if (ret < 0) {
+				goto error;
+			}
+		}
+	}
+
+	return 0;
+
+error:
+	if (ctx->pending) {
+		net_pkt_unref(ctx->pending);
+		ctx->pending = NULL;
+	}
+
+	return ret;
+}
+#endif /* CONFIG_HTTP_SEND_STATIC */
+
 int http_send_flush(struct http_ctx *ctx, void *user_send_data)
 {
 	int ret;
@@ -551,7 +551,141 @@ static void http_closed(struct net_app_ctx *app_ctx,
 #endif
 
 	ctx->http.field_values_ctr = 0;
+	ctx->http.data_len = 0;
+}
+
+#if defined(CONFIG_HTTP_SERVER_KEEPALIVE)
+static int on_scan_complete(struct http_parser *parser)
+{
+	/* Stop at the end of the request, the data after it belongs to the
+	 * next one.
+	 */
+	http_parser_pause(parser, 1);
+
+	return 0;
+}
+
+static const struct http_parser_settings scan_settings = {
+	.on_message_complete = on_scan_complete,
+};
+
+/* Length of the request at the start of the request buffer, 0 if it is
+ * not complete yet.
+ */
+static int request_len(struct http_ctx *ctx)
+{
+	struct http_parser scan;
+	size_t len;
+
+	http_parser_init(&scan, HTTP_REQUEST);
+
+	len = http_parser_execute(&scan, &scan_settings,
+				  ctx->http.request_buf, ctx->http.data_len);
+
+	switch (HTTP_PARSER_ERRNO(&scan)) {
+	case HPE_PAUSED:
+		return len;
+	case HPE_OK:
+		return 0;
+	default:
+		NET_DBG("[%p] Invalid request (%s)", ctx,
+			http_errno_name(HTTP_PARSER_ERRNO(&scan)));
+		return -EINVAL;
+	}
+}
+
+/* Each request is parsed once it is complete in the request buffer, so
+ * that the parser callbacks run once per request and the URL and header
+ * fields point to contiguous data. The requests are then served in
+ * order, and the data of the next ones is kept for the next call.
+ */
+static void http_received_keepalive(struct http_ctx *ctx,
+				    struct net_pkt *pkt,
+				    const struct sockaddr *dst)
+{
+	struct net_buf *frag;
+	bool keep_alive;
+	int len;
+
+	for (frag = pkt->frags; frag; frag = frag->frags) {
+		if (ctx->http.data_len + frag->len >
+		    ctx->http.request_buf_len) {
+			NET_DBG("[%p] Request does not fit in %zd bytes", ctx,
+				ctx->http.request_buf_len);
+			net_pkt_unref(pkt);
+			goto fail;
+		}
+
+		memcpy(ctx->http.request_buf + ctx->http.data_len,
+		       frag->data, frag->len);
+		ctx->http.data_len += frag->len;
+	}
+
+	net_pkt_unref(pkt);
+
+	while (ctx->http.data_len) {
+		len = request_len(ctx);
+		if (len < 0) {
+			goto fail;
+		}
+
+		if (len == 0) {
+			return;
+		}
+
+		ctx->http.field_values_ctr = 0;
+		http_parser_init(&ctx->http.parser, HTTP_REQUEST);
+		ctx->http.parser.addr = dst;
+
+		http_parser_execute(&ctx->http.parser,
+				    &ctx->http.parser_settings,
+				    ctx->http.request_buf, len);
+		if (ctx->http.parser.http_errno != HPE_OK) {
+			goto fail;
+		}
+
+		if (ctx->state == HTTP_STATE_HEADER_RECEIVED) {
+			/* The connection is a websocket from now on */
+			http_change_state(ctx, HTTP_STATE_OPEN);
+			url_connected(ctx, WS_CONNECTION, dst);
+			ctx->http.field_values_ctr = 0;
+			ctx->http.data_len = 0;
+			return;
+		}
+
+		keep_alive = http_should_keep_alive(&ctx->http.parser);
+
+		if (http_process_recv(ctx, dst) < 0) {
+			NET_DBG("[%p] No handler for the request", ctx);
+			keep_alive = false;
+		}
+
+		if (ctx->state == HTTP_STATE_CLOSED) {
+			/* Closed by the application */
+			return;
+		}
+
+		if (!keep_alive) {
+			http_close(ctx);
+			return;
+		}
+
+		/* Wait for the next request */
+		http_change_state(ctx, HTTP_STATE_CLOSED);
+		http_server_conn_del(ctx);
+
+		ctx->http.data_len -= len;
+		memmove(ctx->http.request_buf, ctx->http.request_buf + len,
+			ctx->http.data_len);
+	}
+
+	return;
+
+fail:
+	http_send_error(ctx, 400, NULL, 0, dst);
+	http_close(ctx);
 }
+#endif /* CONFIG_HTTP_SERVER_KEEPALIVE */
 
 static void http_received(struct net_app_ctx *app_ctx,
 			  struct net_pkt *pkt,
@@ -603,6 +737,11 @@ static void http_received(struct net_app_ctx *app_ctx,
 		goto ws_only;
 	}
 
+#if defined(CONFIG_HTTP_SERVER_KEEPALIVE)
+	http_received_keepalive(ctx, pkt, dst);
+	return;
+#endif
+
 	while (frag) {
 		/* If this fragment cannot be copied to result buf,
 		 * then parse what we have which will cause the callback to be
@@ -1117,3 +1256,91 @@ int http_server_disable(struct http_ctx *ctx)
 
 	return 0;
 }
+
+int http_server_set_max_connections(struct http_ctx *ctx, int max_conn)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (max_conn > CONFIG_HTTP_SERVER_CONNECTIONS) {
+		return -EINVAL;
+	}
+
+	return net_app_server_set_max_conn(&ctx->app_ctx, max_conn);
+}
+
+int http_add_chunked_header(struct http_ctx *ctx, const char *status,
+			    const char *content_type,
+			    const struct sockaddr *dst,
+			    void *user_send_data)
+{
+	int ret;
+
+	ret = http_add_header(ctx, status, dst, user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (content_type) {
+		ret = http_add_header_field(ctx, "Content-Type", content_type,
+					    dst, user_send_data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	ret = http_add_header_field(ctx, "Transfer-Encoding", "chunked",
+				    dst, user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return http_add_header(ctx, HTTP_CRLF, dst, user_send_data);
+}
+
+#if defined(CONFIG_HTTP_SEND_STATIC)
+int http_send_static_response(struct http_ctx *ctx, const char *status,
+			      const char *content_type,
+			      const void *body, size_t body_len,
+			      const struct sockaddr *dst,
+			      void *user_send_data)
+{
+	char content_len[sizeof("4294967295")];
+	int ret;
+
+	ret = http_add_header(ctx, status, dst, user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (content_type) {
+		ret = http_add_header_field(ctx, "Content-Type", content_type,
+					    dst, user_send_data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	snprintk(content_len, sizeof(content_len), "%u",
+		 (unsigned int)body_len);
+
+	ret = http_add_header_field(ctx, "Content-Length", content_len, dst,
+				    user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = http_add_header(ctx, HTTP_CRLF, dst, user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = http_send_static(ctx, body, body_len, dst, user_send_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return http_send_flush(ctx, user_send_data);
+}
+#endif /* CONFIG_HTTP_SEND_STATIC */
@@ -51,6 +51,12 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #ifdef CONFIG_LWM2M_RW_JSON_SUPPORT
 #include "lwm2m_rw_json.h"
 #endif
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+#include "lwm2m_rw_senml_json.h"
+#endif
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+#include "lwm2m_rw_senml_cbor.h"
+#endif
 #ifdef CONFIG_LWM2M_RD_CLIENT_SUPPORT
 #include "lwm2m_rd_client.h"
 #endif
@@ -95,28 +101,39 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 #define MAX_TOKEN_LEN		8
 
+struct notification_attrs {
+	/* use to determine which value is set */
+	float32_value_t gt;
+	float32_value_t lt;
+	float32_value_t st;
+	s32_t pmin;
+	s32_t pmax;
+	u8_t flags;
+};
+
 struct observe_node {
 	sys_snode_t node;
 	struct lwm2m_ctx *ctx;
 	struct lwm2m_obj_path path;
 	u8_t  token[MAX_TOKEN_LEN];
-	s64_t event_timestamp;
 	s64_t last_timestamp;
+	/* value at the last notification, in millionths (gt/lt/st) */
+	s64_t last_value;
+	float32_value_t gt;
+	float32_value_t lt;
+	float32_value_t st;
 	u32_t min_period_sec;
 	u32_t max_period_sec;
 	u32_t counter;
 	u16_t format;
 	u8_t  tkl;
-};
-
-struct notification_attrs {
-	/* use to determine which value is set */
-	float32_value_t gt;
-	float32_value_t lt;
-	float32_value_t st;
-	s32_t pmin;
-	s32_t pmax;
-	u8_t flags;
+	u8_t  attr_flags;
+	/* an event is waiting to be notified */
+	bool  pending;
+	/* notification held back by the rate limit */
+	bool  deferred;
+	/* one of the paths of an Observe-Composite, sharing its token */
+	bool  composite;
 };
 
 static struct observe_node observe_node_data[CONFIG_LWM2M_ENGINE_MAX_OBSERVER];
@@ -132,8 +149,17 @@ struct service_node {
 
 static struct service_node service_node_data[MAX_PERIODIC_SERVICE];
 
+/* Both lists are sorted by ID, so the instances of an object follow each
+ * other. The instances are also hashed on their object and instance IDs.
+ */
 static sys_slist_t engine_obj_list;
 static sys_slist_t engine_obj_inst_list;
+static sys_slist_t engine_obj_inst_index[CONFIG_LWM2M_ENGINE_OBJ_INST_HASH_SIZE];
+
+/* Changed when an object instance goes away, so that the resource handles
+ * resolved before are resolved again.
+ */
+static u32_t engine_generation;
 static sys_slist_t engine_observer_list;
 static sys_slist_t engine_service_list;
 
@@ -170,6 +196,10 @@ static struct k_thread engine_thread_data;
 static struct lwm2m_engine_obj *get_engine_obj(int obj_id);
 static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
 							 int obj_inst_id);
+static int path_to_objs(const struct lwm2m_obj_path *path,
+			struct lwm2m_engine_obj_inst **obj_inst,
+			struct lwm2m_engine_obj_field **obj_field,
+			struct lwm2m_engine_res_inst **res);
 
 /* Shared set of in-flight LwM2M messages */
 static struct lwm2m_message messages[CONFIG_LWM2M_ENGINE_MAX_MESSAGES];
@@ -377,6 +407,187 @@ static void clear_attrs(void *ref)
 	}
 }
 
+/* gt/lt/st are compared in millionths, as float32_value_t holds them */
+#define ATTR_VALUE_SCALE	1000000LL
+
+static s64_t attr_value(const float32_value_t *value)
+{
+	return (s64_t)value->val1 * ATTR_VALUE_SCALE + value->val2;
+}
+
+/* current value of the numeric resource observed, in millionths */
+static int observer_value(struct observe_node *obs, s64_t *value)
+{
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res;
+	void *data_ptr;
+	size_t data_len;
+
+	if (obs->path.level < 3 ||
+	    path_to_objs(&obs->path, NULL, &obj_field, &res) < 0) {
+		return -EINVAL;
+	}
+
+	data_ptr = res->data_ptr;
+	data_len = res->data_len;
+	if (res->read_cb) {
+		data_ptr = res->read_cb(obs->path.obj_inst_id, &data_len);
+	}
+
+	if (!data_ptr || !data_len) {
+		return -ENOENT;
+	}
+
+	switch (obj_field->data_type) {
+
+	case LWM2M_RES_TYPE_U64:
+		*value = *(u64_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_U32:
+	case LWM2M_RES_TYPE_TIME:
+		*value = *(u32_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_U16:
+		*value = *(u16_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_U8:
+		*value = *(u8_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_S64:
+		*value = *(s64_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_S32:
+		*value = *(s32_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_S16:
+		*value = *(s16_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_S8:
+		*value = *(s8_t *)data_ptr * ATTR_VALUE_SCALE;
+		break;
+
+	case LWM2M_RES_TYPE_FLOAT32:
+		*value = attr_value((float32_value_t *)data_ptr);
+		break;
+
+	case LWM2M_RES_TYPE_FLOAT64:
+		*value = ((float64_value_t *)data_ptr)->val1 *
+			 ATTR_VALUE_SCALE +
+			 ((float64_value_t *)data_ptr)->val2;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * An event is notified when no gt/lt/st attribute applies, or when the
+ * value moved by st at least or crossed gt or lt since the last
+ * notification (OMA-TS-LightweightM2M-V1_0-20170208-A, 5.1.2).
+ */
+static bool observer_value_changed(struct observe_node *obs)
+{
+	s64_t value, delta;
+
+	if (!(obs->attr_flags & (BIT(LWM2M_ATTR_GT) | BIT(LWM2M_ATTR_LT) |
+				 BIT(LWM2M_ATTR_STEP))) ||
+	    observer_value(obs, &value) < 0) {
+		return true;
+	}
+
+	if (obs->attr_flags & BIT(LWM2M_ATTR_STEP)) {
+		delta = value - obs->last_value;
+		if (delta < 0) {
+			delta = -delta;
+		}
+
+		if (delta >= attr_value(&obs->st)) {
+			return true;
+		}
+	}
+
+	if ((obs->attr_flags & BIT(LWM2M_ATTR_GT)) &&
+	    (value > attr_value(&obs->gt)) !=
+	    (obs->last_value > attr_value(&obs->gt))) {
+		return true;
+	}
+
+	if ((obs->attr_flags & BIT(LWM2M_ATTR_LT)) &&
+	    (value < attr_value(&obs->lt)) !=
+	    (obs->last_value < attr_value(&obs->lt))) {
+		return true;
+	}
+
+	return false;
+}
+
+static bool observer_same_token(struct observe_node *a,
+				struct observe_node *b)
+{
+	return a->ctx == b->ctx && a->tkl == b->tkl &&
+	       !memcmp(a->token, b->token, a->tkl);
+}
+
+/*
+ * The paths of an Observe-Composite share a token and are notified
+ * together, the first of them in the list leading the group.
+ */
+static bool observer_in_group(struct observe_node *first,
+			      struct observe_node *obs)
+{
+	return obs == first ||
+	       (first->composite && obs->composite &&
+		observer_same_token(first, obs));
+}
+
+static bool observer_group_first(struct observe_node *obs)
+{
+	struct observe_node *tmp;
+
+	if (!obs->composite) {
+		return true;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, tmp, node) {
+		if (tmp == obs) {
+			break;
+		}
+
+		if (observer_in_group(tmp, obs)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool observer_group_pending(struct observe_node *obs)
+{
+	struct observe_node *tmp;
+
+	if (!obs->composite) {
+		return obs->pending;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, tmp, node) {
+		if (observer_in_group(obs, tmp) && tmp->pending) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 int lwm2m_notify_observer(u16_t obj_id, u16_t obj_inst_id, u16_t res_id)
 {
 	struct observe_node *obs;
@@ -388,8 +599,19 @@ int lwm2m_notify_observer(u16_t obj_id, u16_t obj_inst_id, u16_t res_id)
 		    obs->path.obj_inst_id == obj_inst_id &&
 		    (obs->path.level < 3 ||
 		     obs->path.res_id == res_id)) {
-			/* update the event time for this observer */
-			obs->event_timestamp = k_uptime_get();
+			obs->ctx->notify_stats.events++;
+
+			if (!observer_value_changed(obs)) {
+				obs->ctx->notify_stats.filtered++;
+				continue;
+			}
+
+			/* already waiting for pmin: sent as one notification */
+			if (observer_group_pending(obs)) {
+				obs->ctx->notify_stats.coalesced++;
+			}
+
+			obs->pending = true;
 
 			LOG_DBG("NOTIFY EVENT %u/%u/%u",
 				obj_id, obj_inst_id, res_id);
@@ -407,59 +629,15 @@ int lwm2m_notify_observer_path(struct lwm2m_obj_path *path)
 				     path->res_id);
 }
 
-static int engine_add_observer(struct lwm2m_message *msg,
-			       const u8_t *token, u8_t tkl,
-			       struct lwm2m_obj_path *path,
-			       u16_t format)
+/* check that the path can be observed and collect its attributes */
+static int observer_attrs(struct lwm2m_obj_path *path,
+			  struct notification_attrs *attrs)
 {
 	struct lwm2m_engine_obj *obj = NULL;
 	struct lwm2m_engine_obj_field *obj_field = NULL;
 	struct lwm2m_engine_obj_inst *obj_inst = NULL;
-	struct observe_node *obs;
-	struct sockaddr *addr;
-	struct notification_attrs attrs = {
-		.flags = BIT(LWM2M_ATTR_PMIN) || BIT(LWM2M_ATTR_PMAX),
-		.pmin  = DEFAULT_SERVER_PMIN,
-		.pmax  = DEFAULT_SERVER_PMAX,
-	};
 	int i, ret;
 
-	if (!msg || !msg->ctx) {
-		LOG_ERR("valid lwm2m message is required");
-		return -EINVAL;
-	}
-
-	if (!token || (tkl == 0 || tkl > MAX_TOKEN_LEN)) {
-		LOG_ERR("token(%p) and token length(%u) must be valid.",
-			token, tkl);
-		return -EINVAL;
-	}
-
-	/* remote addr */
-	addr = &msg->ctx->net_app_ctx.default_ctx->remote;
-
-	/* TODO: get server object for default pmin/pmax
-	 * and observe dup checking
-	 */
-
-	/* make sure this observer doesn't exist already */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		/* TODO: distinguish server object */
-		if (obs->ctx == msg->ctx &&
-		    memcmp(&obs->path, path, sizeof(*path)) == 0) {
-			/* quietly update the token information */
-			memcpy(obs->token, token, tkl);
-			obs->tkl = tkl;
-
-			LOG_DBG("OBSERVER DUPLICATE %u/%u/%u(%u) [%s]",
-				path->obj_id, path->obj_inst_id,
-				path->res_id, path->level,
-				lwm2m_sprint_ip_addr(addr));
-
-			return 0;
-		}
-	}
-
 	/* check if object exists */
 	obj = get_engine_obj(path->obj_id);
 	if (!obj) {
@@ -467,7 +645,7 @@ static int engine_add_observer(struct lwm2m_message *msg,
 		return -ENOENT;
 	}
 
-	ret = update_attrs(obj, &attrs);
+	ret = update_attrs(obj, attrs);
 	if (ret < 0) {
 		return ret;
 	}
@@ -482,7 +660,7 @@ static int engine_add_observer(struct lwm2m_message *msg,
 			return -ENOENT;
 		}
 
-		ret = update_attrs(obj_inst, &attrs);
+		ret = update_attrs(obj_inst, attrs);
 		if (ret < 0) {
 			return ret;
 		}
@@ -518,12 +696,32 @@ static int engine_add_observer(struct lwm2m_message *msg,
 			return -EPERM;
 		}
 
-		ret = update_attrs(&obj_inst->resources[i], &attrs);
+		ret = update_attrs(&obj_inst->resources[i], attrs);
 		if (ret < 0) {
 			return ret;
 		}
 	}
 
+	return 0;
+}
+
+static int observer_add(struct lwm2m_ctx *ctx, const u8_t *token, u8_t tkl,
+			struct lwm2m_obj_path *path, u16_t format,
+			bool composite)
+{
+	struct observe_node *obs;
+	struct notification_attrs attrs = {
+		.flags = BIT(LWM2M_ATTR_PMIN) || BIT(LWM2M_ATTR_PMAX),
+		.pmin  = DEFAULT_SERVER_PMIN,
+		.pmax  = DEFAULT_SERVER_PMAX,
+	};
+	int i, ret;
+
+	ret = observer_attrs(path, &attrs);
+	if (ret < 0) {
+		return ret;
+	}
+
 	/* find an unused observer index node */
 	for (i = 0; i < CONFIG_LWM2M_ENGINE_MAX_OBSERVER; i++) {
 		if (!observe_node_data[i].ctx) {
@@ -537,19 +735,76 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	}
 
 	/* copy the values and add it to the list */
-	observe_node_data[i].ctx = msg->ctx;
-	memcpy(&observe_node_data[i].path, path, sizeof(*path));
-	memcpy(observe_node_data[i].token, token, tkl);
-	observe_node_data[i].tkl = tkl;
-	observe_node_data[i].last_timestamp = k_uptime_get();
-	observe_node_data[i].event_timestamp =
-			observe_node_data[i].last_timestamp;
-	observe_node_data[i].min_period_sec = attrs.pmin;
-	observe_node_data[i].max_period_sec = max(attrs.pmax, attrs.pmin);
-	observe_node_data[i].format = format;
-	observe_node_data[i].counter = 1;
-	sys_slist_append(&engine_observer_list,
-			 &observe_node_data[i].node);
+	obs = &observe_node_data[i];
+	obs->ctx = ctx;
+	memcpy(&obs->path, path, sizeof(*path));
+	memcpy(obs->token, token, tkl);
+	obs->tkl = tkl;
+	obs->last_timestamp = k_uptime_get();
+	obs->min_period_sec = attrs.pmin;
+	obs->max_period_sec = max(attrs.pmax, attrs.pmin);
+	obs->gt = attrs.gt;
+	obs->lt = attrs.lt;
+	obs->st = attrs.st;
+	obs->attr_flags = attrs.flags;
+	obs->format = format;
+	obs->counter = 1;
+	obs->composite = composite;
+	(void)observer_value(obs, &obs->last_value);
+	sys_slist_append(&engine_observer_list, &obs->node);
+
+	return 0;
+}
+
+static int engine_add_observer(struct lwm2m_message *msg,
+			       const u8_t *token, u8_t tkl,
+			       struct lwm2m_obj_path *path,
+			       u16_t format)
+{
+	struct observe_node *obs;
+	struct sockaddr *addr;
+	int ret;
+
+	if (!msg || !msg->ctx) {
+		LOG_ERR("valid lwm2m message is required");
+		return -EINVAL;
+	}
+
+	if (!token || (tkl == 0 || tkl > MAX_TOKEN_LEN)) {
+		LOG_ERR("token(%p) and token length(%u) must be valid.",
+			token, tkl);
+		return -EINVAL;
+	}
+
+	/* remote addr */
+	addr = &msg->ctx->net_app_ctx.default_ctx->remote;
+
+	/* TODO: get server object for default pmin/pmax
+	 * and observe dup checking
+	 */
+
+	/* make sure this observer doesn't exist already */
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		/* TODO: distinguish server object */
+		if (obs->ctx == msg->ctx && !obs->composite &&
+		    memcmp(&obs->path, path, sizeof(*path)) == 0) {
+			/* quietly update the token information */
+			memcpy(obs->token, token, tkl);
+			obs->tkl = tkl;
+
+			LOG_DBG("OBSERVER DUPLICATE %u/%u/%u(%u) [%s]",
+				path->obj_id, path->obj_inst_id,
+				path->res_id, path->level,
+				lwm2m_sprint_ip_addr(addr));
+
+			return 0;
+		}
+	}
+
+	ret = observer_add(msg->ctx, token, tkl, path, format, false);
+	if (ret < 0) {
+		return ret;
+	}
 
 	LOG_DBG("OBSERVER ADDED %u/%u/%u(%u) token:'%s' addr:%s",
 		path->obj_id, path->obj_inst_id, path->res_id, path->level,
@@ -558,10 +813,12 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	return 0;
 }
 
+/* remove all the observers of the token, every path of a composite one */
 static int engine_remove_observer(const u8_t *token, u8_t tkl)
 {
-	struct observe_node *obs, *found_obj = NULL;
+	struct observe_node *obs, *tmp;
 	sys_snode_t *prev_node = NULL;
+	bool found = false;
 
 	if (!token || (tkl == 0 || tkl > MAX_TOKEN_LEN)) {
 		LOG_ERR("token(%p) and token length(%u) must be valid.",
@@ -569,28 +826,67 @@ static int engine_remove_observer(const u8_t *token, u8_t tkl)
 		return -EINVAL;
 	}
 
-	/* find the node index */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		if (memcmp(obs->token, token, tkl) == 0) {
-			found_obj = obs;
-			break;
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(
+			&engine_observer_list, obs, tmp, node) {
+		if (memcmp(obs->token, token, tkl) != 0) {
+			prev_node = &obs->node;
+			continue;
 		}
 
-		prev_node = &obs->node;
+		sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
+		(void)memset(obs, 0, sizeof(*obs));
+		found = true;
 	}
 
-	if (!found_obj) {
+	if (!found) {
 		return -ENOENT;
 	}
 
-	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
-	(void)memset(found_obj, 0, sizeof(*found_obj));
-
 	LOG_DBG("observer '%s' removed", sprint_token(token, tkl));
 
 	return 0;
 }
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+static int engine_add_composite_observer(struct lwm2m_message *msg,
+					 const u8_t *token, u8_t tkl,
+					 struct lwm2m_obj_path *paths,
+					 int path_count, u16_t format)
+{
+	int i, ret;
+
+	if (!msg || !msg->ctx) {
+		LOG_ERR("valid lwm2m message is required");
+		return -EINVAL;
+	}
+
+	if (!token || (tkl == 0 || tkl > MAX_TOKEN_LEN)) {
+		LOG_ERR("token(%p) and token length(%u) must be valid.",
+			token, tkl);
+		return -EINVAL;
+	}
+
+	/* observing again with the same token replaces the paths */
+	(void)engine_remove_observer(token, tkl);
+
+	for (i = 0; i < path_count; i++) {
+		ret = observer_add(msg->ctx, token, tkl, &paths[i], format,
+				   true);
+		if (ret < 0) {
+			(void)engine_remove_observer(token, tkl);
+			return ret;
+		}
+	}
+
+	LOG_DBG("COMPOSITE OBSERVER ADDED %d paths token:'%s' addr:%s",
+		path_count, sprint_token(token, tkl),
+		lwm2m_sprint_ip_addr(
+			&msg->ctx->net_app_ctx.default_ctx->remote));
+
+	return 0;
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
+
 static void engine_remove_observer_by_id(u16_t obj_id, s32_t obj_inst_id)
 {
 	struct observe_node *obs, *tmp;
@@ -614,13 +910,25 @@ static void engine_remove_observer_by_id(u16_t obj_id, s32_t obj_inst_id)
 
 void lwm2m_register_obj(struct lwm2m_engine_obj *obj)
 {
-	sys_slist_append(&engine_obj_list, &obj->node);
+	struct lwm2m_engine_obj *tmp, *prev = NULL;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_list, tmp, node) {
+		if (tmp->obj_id > obj->obj_id) {
+			break;
+		}
+
+		prev = tmp;
+	}
+
+	sys_slist_insert(&engine_obj_list, prev ? &prev->node : NULL,
+			 &obj->node);
 }
 
 void lwm2m_unregister_obj(struct lwm2m_engine_obj *obj)
 {
 	engine_remove_observer_by_id(obj->obj_id, -1);
 	sys_slist_find_and_remove(&engine_obj_list, &obj->node);
+	engine_generation++;
 }
 
 static struct lwm2m_engine_obj *get_engine_obj(int obj_id)
@@ -631,6 +939,10 @@ static struct lwm2m_engine_obj *get_engine_obj(int obj_id)
 		if (obj->obj_id == obj_id) {
 			return obj;
 		}
+
+		if (obj->obj_id > obj_id) {
+			break;
+		}
 	}
 
 	return NULL;
@@ -654,9 +966,48 @@ lwm2m_get_engine_obj_field(struct lwm2m_engine_obj *obj, int res_id)
 
 /* engine object instance */
 
+static sys_slist_t *obj_inst_bucket(u16_t obj_id, u16_t obj_inst_id)
+{
+	u32_t hash = ((u32_t)obj_id << 16 | obj_inst_id) * 2654435761U;
+
+	return &engine_obj_inst_index[(hash >> 16) %
+				      CONFIG_LWM2M_ENGINE_OBJ_INST_HASH_SIZE];
+}
+
+/* sort order of the instances: by object, then instance ID */
+static bool obj_inst_after(struct lwm2m_engine_obj_inst *obj_inst,
+			   u16_t obj_id, u16_t obj_inst_id)
+{
+	return obj_inst->obj->obj_id > obj_id ||
+	       (obj_inst->obj->obj_id == obj_id &&
+		obj_inst->obj_inst_id > obj_inst_id);
+}
+
 static void engine_register_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 {
-	sys_slist_append(&engine_obj_inst_list, &obj_inst->node);
+	struct lwm2m_engine_obj_inst *tmp, *prev;
+	u16_t obj_id = obj_inst->obj->obj_id;
+
+	/* instances are usually created in order, check the tail first */
+	prev = SYS_SLIST_PEEK_TAIL_CONTAINER(&engine_obj_inst_list, tmp, node);
+	if (prev && obj_inst_after(prev, obj_id, obj_inst->obj_inst_id)) {
+		prev = NULL;
+
+		SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, tmp,
+					     node) {
+			if (obj_inst_after(tmp, obj_id,
+					   obj_inst->obj_inst_id)) {
+				break;
+			}
+
+			prev = tmp;
+		}
+	}
+
+	sys_slist_insert(&engine_obj_inst_list, prev ? &prev->node : NULL,
+			 &obj_inst->node);
+	sys_slist_prepend(obj_inst_bucket(obj_id, obj_inst->obj_inst_id),
+			  &obj_inst->index_node);
 }
 
 static void engine_unregister_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
@@ -664,6 +1015,10 @@ static void engine_unregister_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 	engine_remove_observer_by_id(
 			obj_inst->obj->obj_id, obj_inst->obj_inst_id);
 	sys_slist_find_and_remove(&engine_obj_inst_list, &obj_inst->node);
+	sys_slist_find_and_remove(obj_inst_bucket(obj_inst->obj->obj_id,
+						  obj_inst->obj_inst_id),
+				  &obj_inst->index_node);
+	engine_generation++;
 }
 
 static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
@@ -671,8 +1026,13 @@ static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
 {
 	struct lwm2m_engine_obj_inst *obj_inst;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, obj_inst,
-				     node) {
+	if (obj_id < 0 || obj_id > UINT16_MAX ||
+	    obj_inst_id < 0 || obj_inst_id > UINT16_MAX) {
+		return NULL;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(obj_inst_bucket(obj_id, obj_inst_id),
+				     obj_inst, index_node) {
 		if (obj_inst->obj->obj_id == obj_id &&
 		    obj_inst->obj_inst_id == obj_inst_id) {
 			return obj_inst;
@@ -685,18 +1045,32 @@ static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
 static struct lwm2m_engine_obj_inst *
 next_engine_obj_inst(int obj_id, int obj_inst_id)
 {
-	struct lwm2m_engine_obj_inst *obj_inst, *next = NULL;
+	struct lwm2m_engine_obj_inst *obj_inst;
+
+	/* the next instance follows the current one in the sorted list */
+	obj_inst = get_engine_obj_inst(obj_id, obj_inst_id);
+	if (obj_inst) {
+		obj_inst = SYS_SLIST_PEEK_NEXT_CONTAINER(obj_inst, node);
+		if (obj_inst && obj_inst->obj->obj_id == obj_id) {
+			return obj_inst;
+		}
+
+		return NULL;
+	}
+
+	/* first instance, or the current one was deleted */
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, obj_inst, node) {
+		if (obj_inst->obj->obj_id > obj_id) {
+			break;
+		}
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, obj_inst,
-				     node) {
 		if (obj_inst->obj->obj_id == obj_id &&
-		    obj_inst->obj_inst_id > obj_inst_id &&
-		    (!next || next->obj_inst_id > obj_inst->obj_inst_id)) {
-			next = obj_inst;
+		    obj_inst->obj_inst_id > obj_inst_id) {
+			return obj_inst;
 		}
 	}
 
-	return next;
+	return NULL;
 }
 
 int lwm2m_create_obj_inst(u16_t obj_id, u16_t obj_inst_id,
@@ -1150,26 +1524,25 @@ u16_t lwm2m_get_rd_data(u8_t *client_data, u16_t size)
 			continue;
 		}
 
-		SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list,
-					     obj_inst, node) {
-			if (obj_inst->obj->obj_id == obj->obj_id) {
-				len = snprintk(temp, sizeof(temp),
-					       "%s</%u/%u>",
-					       (pos > 0) ? "," : "",
-					       obj_inst->obj->obj_id,
-					       obj_inst->obj_inst_id);
-				/*
-				 * TODO: iterate through resources once block
-				 * transfer is handled correctly
-				 */
-				if (pos + len >= size) {
-					/* full buffer -- exit loop */
-					break;
-				}
-
-				memcpy(&client_data[pos], temp, len);
-				pos += len;
+		for (obj_inst = next_engine_obj_inst(obj->obj_id, -1);
+		     obj_inst;
+		     obj_inst = next_engine_obj_inst(obj->obj_id,
+						     obj_inst->obj_inst_id)) {
+			len = snprintk(temp, sizeof(temp), "%s</%u/%u>",
+				       (pos > 0) ? "," : "",
+				       obj_inst->obj->obj_id,
+				       obj_inst->obj_inst_id);
+			/*
+			 * TODO: iterate through resources once block
+			 * transfer is handled correctly
+			 */
+			if (pos + len >= size) {
+				/* full buffer -- exit loop */
+				break;
 			}
+
+			memcpy(&client_data[pos], temp, len);
+			pos += len;
 		}
 	}
 
@@ -1204,6 +1577,18 @@ static int select_writer(struct lwm2m_output_context *out, u16_t accept)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		out->writer = &senml_json_writer;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		out->writer = &senml_cbor_writer;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", accept);
 		return -ENOMSG;
@@ -1228,6 +1613,18 @@ static int select_reader(struct lwm2m_input_context *in, u16_t format)
 		in->reader = &oma_tlv_reader;
 		break;
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		in->reader = &senml_json_reader;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		in->reader = &senml_cbor_reader;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", format);
 		return -ENOMSG;
@@ -1416,41 +1813,17 @@ int lwm2m_engine_set_res_data(char *pathstr, void *data_ptr, u16_t data_len,
 	return ret;
 }
 
-static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
+static int engine_set_res(struct lwm2m_obj_path *path,
+			  struct lwm2m_engine_obj_inst *obj_inst,
+			  struct lwm2m_engine_obj_field *obj_field,
+			  struct lwm2m_engine_res_inst *res,
+			  void *value, u16_t len)
 {
-	struct lwm2m_obj_path path;
-	struct lwm2m_engine_obj_inst *obj_inst;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_engine_res_inst *res = NULL;
 	void *data_ptr = NULL;
 	size_t data_len = 0;
 	int ret = 0;
 	bool changed = false;
 
-	LOG_DBG("path:%s, value:%p, len:%d", pathstr, value, len);
-
-	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (path.level < 3) {
-		LOG_ERR("path must have 3 parts");
-		return -EINVAL;
-	}
-
-	/* look up resource obj */
-	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (!res) {
-		LOG_ERR("res instance %d not found", path.res_id);
-		return -ENOENT;
-	}
-
 	if (LWM2M_HAS_RES_FLAG(res, LWM2M_RES_DATA_FLAG_RO)) {
 		LOG_ERR("res data pointer is read-only");
 		return -EACCES;
@@ -1474,7 +1847,7 @@ static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
 	if (len > res->data_len -
 		(obj_field->data_type == LWM2M_RES_TYPE_STRING ? 1 : 0)) {
 		LOG_ERR("length %u is too long for resource %d data",
-			len, path.res_id);
+			len, path->res_id);
 		return -ENOMEM;
 	}
 
@@ -1556,12 +1929,47 @@ static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
 	}
 
 	if (changed) {
-		NOTIFY_OBSERVER_PATH(&path);
+		NOTIFY_OBSERVER_PATH(path);
 	}
 
 	return ret;
 }
 
+static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
+{
+	struct lwm2m_obj_path path;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+	int ret = 0;
+
+	LOG_DBG("path:%s, value:%p, len:%d", pathstr, value, len);
+
+	/* translate path -> path_obj */
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	/* look up resource obj */
+	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!res) {
+		LOG_ERR("res instance %d not found", path.res_id);
+		return -ENOENT;
+	}
+
+	return engine_set_res(&path, obj_inst, obj_field, res, value, len);
+}
+
 int lwm2m_engine_set_opaque(char *pathstr, char *data_ptr, u16_t data_len)
 {
 	return lwm2m_engine_set(pathstr, data_ptr, data_len);
@@ -1662,39 +2070,13 @@ int lwm2m_engine_get_res_data(char *pathstr, void **data_ptr, u16_t *data_len,
 	return 0;
 }
 
-static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
-{
-	int ret = 0;
-	struct lwm2m_obj_path path;
-	struct lwm2m_engine_obj_inst *obj_inst;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_engine_res_inst *res = NULL;
-	void *data_ptr = NULL;
-	size_t data_len = 0;
-
-	LOG_DBG("path:%s, buf:%p, buflen:%d", pathstr, buf, buflen);
-
-	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (path.level < 3) {
-		LOG_ERR("path must have 3 parts");
-		return -EINVAL;
-	}
-
-	/* look up resource obj */
-	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (!res) {
-		LOG_ERR("res instance %d not found", path.res_id);
-		return -ENOENT;
-	}
+static int engine_get_res(struct lwm2m_engine_obj_inst *obj_inst,
+			  struct lwm2m_engine_obj_field *obj_field,
+			  struct lwm2m_engine_res_inst *res,
+			  void *buf, u16_t buflen)
+{
+	void *data_ptr = NULL;
+	size_t data_len = 0;
 
 	/* setup initial data elements */
 	data_ptr = res->data_ptr;
@@ -1784,6 +2166,41 @@ static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
 	return 0;
 }
 
+static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
+{
+	int ret = 0;
+	struct lwm2m_obj_path path;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+
+	LOG_DBG("path:%s, buf:%p, buflen:%d", pathstr, buf, buflen);
+
+	/* translate path -> path_obj */
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	/* look up resource obj */
+	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!res) {
+		LOG_ERR("res instance %d not found", path.res_id);
+		return -ENOENT;
+	}
+
+	return engine_get_res(obj_inst, obj_field, res, buf, buflen);
+}
+
 int lwm2m_engine_get_opaque(char *pathstr, void *buf, u16_t buflen)
 {
 	return lwm2m_engine_get(pathstr, buf, buflen);
@@ -1875,6 +2292,263 @@ int lwm2m_engine_get_resource(char *pathstr, struct lwm2m_engine_res_inst **res)
 	return path_to_objs(&path, NULL, NULL, res);
 }
 
+/* pre-resolved resource handles */
+
+int lwm2m_engine_get_handle(char *pathstr,
+			    struct lwm2m_engine_res_handle *handle)
+{
+	struct lwm2m_obj_path path;
+	int ret;
+
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	ret = path_to_objs(&path, &handle->obj_inst, &handle->obj_field,
+			   &handle->res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	handle->obj_id = path.obj_id;
+	handle->obj_inst_id = path.obj_inst_id;
+	handle->res_id = path.res_id;
+	handle->generation = engine_generation;
+
+	return 0;
+}
+
+/* Resolves the handle again if an object instance went away since it was
+ * resolved, its resource may be gone.
+ */
+static int handle_to_objs(struct lwm2m_engine_res_handle *handle,
+			  struct lwm2m_obj_path *path)
+{
+	int ret;
+
+	path->obj_id = handle->obj_id;
+	path->obj_inst_id = handle->obj_inst_id;
+	path->res_id = handle->res_id;
+	path->res_inst_id = 0;
+	path->level = 3;
+
+	if (handle->generation == engine_generation) {
+		return 0;
+	}
+
+	ret = path_to_objs(path, &handle->obj_inst, &handle->obj_field,
+			   &handle->res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	handle->generation = engine_generation;
+
+	return 0;
+}
+
+static int lwm2m_engine_handle_set(struct lwm2m_engine_res_handle *handle,
+				   void *value, u16_t len)
+{
+	struct lwm2m_obj_path path;
+	int ret;
+
+	ret = handle_to_objs(handle, &path);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return engine_set_res(&path, handle->obj_inst, handle->obj_field,
+			      handle->res, value, len);
+}
+
+int lwm2m_engine_handle_set_opaque(struct lwm2m_engine_res_handle *handle,
+				   char *data_ptr, u16_t data_len)
+{
+	return lwm2m_engine_handle_set(handle, data_ptr, data_len);
+}
+
+int lwm2m_engine_handle_set_string(struct lwm2m_engine_res_handle *handle,
+				   char *data_ptr)
+{
+	return lwm2m_engine_handle_set(handle, data_ptr, strlen(data_ptr));
+}
+
+int lwm2m_engine_handle_set_u8(struct lwm2m_engine_res_handle *handle,
+			       u8_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 1);
+}
+
+int lwm2m_engine_handle_set_u16(struct lwm2m_engine_res_handle *handle,
+			       u16_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 2);
+}
+
+int lwm2m_engine_handle_set_u32(struct lwm2m_engine_res_handle *handle,
+			       u32_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 4);
+}
+
+int lwm2m_engine_handle_set_u64(struct lwm2m_engine_res_handle *handle,
+			       u64_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 8);
+}
+
+int lwm2m_engine_handle_set_s8(struct lwm2m_engine_res_handle *handle,
+			       s8_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 1);
+}
+
+int lwm2m_engine_handle_set_s16(struct lwm2m_engine_res_handle *handle,
+			       s16_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 2);
+}
+
+int lwm2m_engine_handle_set_s32(struct lwm2m_engine_res_handle *handle,
+			       s32_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 4);
+}
+
+int lwm2m_engine_handle_set_s64(struct lwm2m_engine_res_handle *handle,
+			       s64_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 8);
+}
+
+int lwm2m_engine_handle_set_bool(struct lwm2m_engine_res_handle *handle,
+				 bool value)
+{
+	u8_t temp = (value != 0 ? 1 : 0);
+
+	return lwm2m_engine_handle_set(handle, &temp, 1);
+}
+
+int lwm2m_engine_handle_set_float32(struct lwm2m_engine_res_handle *handle,
+				    float32_value_t *value)
+{
+	return lwm2m_engine_handle_set(handle, value, sizeof(float32_value_t));
+}
+
+int lwm2m_engine_handle_set_float64(struct lwm2m_engine_res_handle *handle,
+				    float64_value_t *value)
+{
+	return lwm2m_engine_handle_set(handle, value, sizeof(float64_value_t));
+}
+
+static int lwm2m_engine_handle_get(struct lwm2m_engine_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	struct lwm2m_obj_path path;
+	int ret;
+
+	ret = handle_to_objs(handle, &path);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return engine_get_res(handle->obj_inst, handle->obj_field,
+			      handle->res, buf, buflen);
+}
+
+int lwm2m_engine_handle_get_opaque(struct lwm2m_engine_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	return lwm2m_engine_handle_get(handle, buf, buflen);
+}
+
+int lwm2m_engine_handle_get_string(struct lwm2m_engine_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	return lwm2m_engine_handle_get(handle, buf, buflen);
+}
+
+int lwm2m_engine_handle_get_u8(struct lwm2m_engine_res_handle *handle,
+			       u8_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 1);
+}
+
+int lwm2m_engine_handle_get_u16(struct lwm2m_engine_res_handle *handle,
+			       u16_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 2);
+}
+
+int lwm2m_engine_handle_get_u32(struct lwm2m_engine_res_handle *handle,
+			       u32_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 4);
+}
+
+int lwm2m_engine_handle_get_u64(struct lwm2m_engine_res_handle *handle,
+			       u64_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 8);
+}
+
+int lwm2m_engine_handle_get_s8(struct lwm2m_engine_res_handle *handle,
+			       s8_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 1);
+}
+
+int lwm2m_engine_handle_get_s16(struct lwm2m_engine_res_handle *handle,
+			       s16_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 2);
+}
+
+int lwm2m_engine_handle_get_s32(struct lwm2m_engine_res_handle *handle,
+			       s32_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 4);
+}
+
+int lwm2m_engine_handle_get_s64(struct lwm2m_engine_res_handle *handle,
+			       s64_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 8);
+}
+
+int lwm2m_engine_handle_get_bool(struct lwm2m_engine_res_handle *handle,
+				 bool *value)
+{
+	int ret = 0;
+	s8_t temp = 0;
+
+	ret = lwm2m_engine_handle_get_s8(handle, &temp);
+	if (!ret) {
+		*value = temp != 0;
+	}
+
+	return ret;
+}
+
+int lwm2m_engine_handle_get_float32(struct lwm2m_engine_res_handle *handle,
+				    float32_value_t *buf)
+{
+	return lwm2m_engine_handle_get(handle, buf, sizeof(float32_value_t));
+}
+
+int lwm2m_engine_handle_get_float64(struct lwm2m_engine_res_handle *handle,
+				    float64_value_t *buf)
+{
+	return lwm2m_engine_handle_get(handle, buf, sizeof(float64_value_t));
+}
+
 int lwm2m_engine_register_read_callback(char *pathstr,
 					lwm2m_engine_get_data_cb_t cb)
 {
@@ -2515,11 +3189,7 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 		if (!(BIT(type) & nattrs.flags)) {
 			LOG_DBG("Unset attr %s", LWM2M_ATTR_STR[type]);
 			(void)memset(attr, 0, sizeof(*attr));
-
-			if (type <= LWM2M_ATTR_PMAX) {
-				update_observe_node = true;
-			}
-
+			update_observe_node = true;
 			continue;
 		}
 
@@ -2540,6 +3210,7 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 
 			memcpy(&attr->float_val, nattr_ptrs[type],
 			       sizeof(float32_value_t));
+			update_observe_node = true;
 		}
 
 		LOG_DBG("Update %s to %d.%06d", LWM2M_ATTR_STR[type],
@@ -2569,18 +3240,18 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 
 		if (type <= LWM2M_ATTR_PMAX) {
 			attr->int_val = *(s32_t *)nattr_ptrs[type];
-			update_observe_node = true;
 		} else {
 			memcpy(&attr->float_val, nattr_ptrs[type],
 			       sizeof(float32_value_t));
 		}
 
+		update_observe_node = true;
 		nattrs.flags &= ~BIT(type);
 		LOG_DBG("Add %s to %d.%06d", LWM2M_ATTR_STR[type],
 			attr->float_val.val1, attr->float_val.val2);
 	}
 
-	/* check only pmin/pmax */
+	/* no attribute changed */
 	if (!update_observe_node) {
 		return 0;
 	}
@@ -2656,6 +3327,10 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 			nattrs.pmin, max(nattrs.pmin, nattrs.pmax));
 		obs->min_period_sec = (u32_t)nattrs.pmin;
 		obs->max_period_sec = (u32_t)max(nattrs.pmin, nattrs.pmax);
+		obs->gt = nattrs.gt;
+		obs->lt = nattrs.lt;
+		obs->st = nattrs.st;
+		obs->attr_flags = nattrs.flags;
 		(void)memset(&nattrs, 0, sizeof(nattrs));
 	}
 
@@ -2721,6 +3396,16 @@ static int do_read_op(struct lwm2m_engine_obj *obj,
 		return do_read_op_json(obj, context, content_format);
 #endif
 
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_read_op_senml_json(obj, context, content_format);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_read_op_senml_cbor(obj, context, content_format);
+#endif
+
 	default:
 		LOG_ERR("Unsupported content-format: %u", content_format);
 		return -ENOMSG;
@@ -2728,29 +3413,80 @@ static int do_read_op(struct lwm2m_engine_obj *obj,
 	}
 }
 
-int lwm2m_perform_read_op(struct lwm2m_engine_obj *obj,
-			  struct lwm2m_engine_context *context,
-			  u16_t content_format)
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+static int do_composite_read_op(struct lwm2m_engine_context *context,
+				struct lwm2m_obj_path *paths, int path_count,
+				u16_t content_format)
 {
-	struct lwm2m_output_context *out = context->out;
-	struct lwm2m_obj_path temp_path, *path = context->path;
-	struct lwm2m_engine_obj_inst *obj_inst = NULL;
-	struct lwm2m_engine_res_inst *res = NULL;
-	struct lwm2m_engine_obj_field *obj_field;
-	int ret = 0, index;
-	u16_t temp_len;
-	u8_t num_read = 0;
+	switch (content_format) {
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_composite_read_op_senml_json(context, paths,
+						       path_count,
+						       content_format);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_composite_read_op_senml_cbor(context, paths,
+						       path_count,
+						       content_format);
+#endif
+
+	default:
+		LOG_ERR("Unsupported composite content-format: %u",
+			content_format);
+		return -ENOMSG;
+
+	}
+}
+
+static int do_composite_paths(struct lwm2m_input_context *in,
+			      u16_t content_format,
+			      struct lwm2m_obj_path *paths, int max_paths)
+{
+	switch (content_format) {
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_composite_paths_senml_json(in, paths, max_paths);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_composite_paths_senml_cbor(in, paths, max_paths);
+#endif
+
+	default:
+		LOG_ERR("Unsupported composite content-format: %u",
+			content_format);
+		return -ENOMSG;
+
+	}
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
 
+/* First object instance to read for the path */
+static struct lwm2m_engine_obj_inst *
+read_op_first_obj_inst(struct lwm2m_obj_path *path)
+{
 	if (path->level >= 2) {
-		obj_inst = get_engine_obj_inst(path->obj_id, path->obj_inst_id);
+		return get_engine_obj_inst(path->obj_id, path->obj_inst_id);
 	} else if (path->level == 1) {
 		/* find first obj_inst with path's obj_id */
-		obj_inst = next_engine_obj_inst(path->obj_id, -1);
+		return next_engine_obj_inst(path->obj_id, -1);
 	}
 
-	if (!obj_inst) {
-		return -ENOENT;
-	}
+	return NULL;
+}
+
+/* Set the content-format of the response and start its payload */
+static int read_op_begin(struct lwm2m_output_context *out,
+			 u16_t content_format)
+{
+	u16_t temp_len;
+	int ret;
 
 	/* set output content-format */
 	ret = coap_append_option_int(out->out_cpkt, COAP_OPTION_CONTENT_FORMAT,
@@ -2766,12 +3502,27 @@ int lwm2m_perform_read_op(struct lwm2m_engine_obj *obj,
 		return ret;
 	}
 
+	out->frag = coap_packet_get_payload(out->out_cpkt, &out->offset,
+					    &temp_len);
+	out->offset++;
+
+	return 0;
+}
+
+/* Format the resources of the context path, from its first object
+ * instance obj_inst.
+ */
+static int read_op_path(struct lwm2m_engine_context *context,
+			struct lwm2m_engine_obj_inst *obj_inst)
+{
+	struct lwm2m_obj_path temp_path, *path = context->path;
+	struct lwm2m_engine_res_inst *res = NULL;
+	struct lwm2m_engine_obj_field *obj_field;
+	int ret = 0, index;
+	u8_t num_read = 0;
+
 	/* store original path values so we can change them during processing */
 	memcpy(&temp_path, path, sizeof(temp_path));
-	out->frag = coap_packet_get_payload(out->out_cpkt, &out->offset,
-					    &temp_len);
-	out->offset++;
-	engine_put_begin(out, path);
 
 	while (obj_inst) {
 		if (!obj_inst->resources || obj_inst->resource_count == 0) {
@@ -2852,8 +3603,6 @@ move_forward:
 		}
 	}
 
-	engine_put_end(context->out, path);
-
 	/* restore original path values */
 	memcpy(path, &temp_path, sizeof(temp_path));
 
@@ -2865,6 +3614,73 @@ move_forward:
 	return ret;
 }
 
+int lwm2m_perform_read_op(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  u16_t content_format)
+{
+	struct lwm2m_output_context *out = context->out;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	int ret;
+
+	obj_inst = read_op_first_obj_inst(context->path);
+	if (!obj_inst) {
+		return -ENOENT;
+	}
+
+	ret = read_op_begin(out, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	engine_put_begin(out, context->path);
+	ret = read_op_path(context, obj_inst);
+	engine_put_end(out, context->path);
+
+	return ret;
+}
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+/* Read all the paths into a single payload. Like the resources of an
+ * object instance, the paths which cannot be read are left out.
+ */
+int lwm2m_perform_composite_read_op(struct lwm2m_engine_context *context,
+				    struct lwm2m_obj_path *paths,
+				    int path_count, u16_t content_format)
+{
+	struct lwm2m_output_context *out = context->out;
+	struct lwm2m_obj_path *path = context->path;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	int ret, i;
+
+	ret = read_op_begin(out, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	engine_put_begin(out, path);
+
+	for (i = 0; i < path_count; i++) {
+		obj_inst = read_op_first_obj_inst(&paths[i]);
+		if (!obj_inst) {
+			continue;
+		}
+
+		context->path = &paths[i];
+		(void)read_op_path(context, obj_inst);
+	}
+
+	context->path = path;
+	engine_put_end(out, path);
+
+	return 0;
+}
+
+int lwm2m_string_to_path(char *pathstr, struct lwm2m_obj_path *path)
+{
+	return string_to_path(pathstr, path, '/');
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
+
 static int print_attr(struct net_pkt *pkt, char *buf, u16_t buflen, void *ref)
 {
 	struct lwm2m_attr *attr;
@@ -3096,6 +3912,72 @@ int lwm2m_get_or_create_engine_obj(struct lwm2m_engine_context *context,
 	return ret;
 }
 
+/* Write the value at the input position to the resource at pathstr, for
+ * the content formats giving the path of each value (SenML). The path
+ * has to be a resource of obj, inside the path of the request.
+ */
+int lwm2m_write_record(struct lwm2m_engine_obj *obj,
+		       struct lwm2m_engine_context *context, char *pathstr)
+{
+	struct lwm2m_obj_path temp_path, *path = context->path;
+	struct lwm2m_engine_obj_inst *obj_inst = NULL;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+	int ret, i;
+
+	/* store original path values, the record changes them */
+	memcpy(&temp_path, path, sizeof(temp_path));
+
+	ret = string_to_path(pathstr, path, '/');
+	if (ret < 0) {
+		goto out;
+	}
+
+	if (path->level != 3 || path->obj_id != obj->obj_id ||
+	    (temp_path.level >= 2 &&
+	     path->obj_inst_id != temp_path.obj_inst_id) ||
+	    (temp_path.level >= 3 && path->res_id != temp_path.res_id)) {
+		LOG_ERR("Record %s outside of the request path", pathstr);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = lwm2m_get_or_create_engine_obj(context, &obj_inst, NULL);
+	if (ret < 0) {
+		goto out;
+	}
+
+	obj_field = lwm2m_get_engine_obj_field(obj, path->res_id);
+	if (!obj_field) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	if (!LWM2M_HAS_PERM(obj_field, LWM2M_PERM_W)) {
+		ret = -EPERM;
+		goto out;
+	}
+
+	for (i = 0; i < obj_inst->resource_count; i++) {
+		if (obj_inst->resources[i].res_id == path->res_id) {
+			res = &obj_inst->resources[i];
+			break;
+		}
+	}
+
+	if (!res) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	ret = lwm2m_write_handler(obj_inst, res, obj_field, context);
+
+out:
+	/* restore original path values */
+	memcpy(path, &temp_path, sizeof(temp_path));
+	return ret;
+}
+
 static int do_write_op(struct lwm2m_engine_obj *obj,
 		       struct lwm2m_engine_context *context,
 		       u16_t format)
@@ -3117,6 +3999,16 @@ static int do_write_op(struct lwm2m_engine_obj *obj,
 		return do_write_op_json(obj, context);
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_write_op_senml_json(obj, context);
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_write_op_senml_cbor(obj, context);
+#endif
+
 	default:
 		LOG_ERR("Unsupported format: %u", format);
 		return -ENOMSG;
@@ -3124,6 +4016,106 @@ static int do_write_op(struct lwm2m_engine_obj *obj,
 	}
 }
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+/*
+ * Read-Composite and Observe-Composite: FETCH on the root path, with the
+ * SenML list of the paths to read as payload.
+ */
+static int handle_composite_request(struct lwm2m_message *msg,
+				    struct lwm2m_engine_context *context,
+				    u8_t *token, u8_t tkl)
+{
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_MAX_PATHS];
+	struct lwm2m_input_context *in = context->in;
+	struct lwm2m_output_context *out = context->out;
+	struct coap_option option;
+	u16_t format, accept;
+	int observe, count, i, r;
+
+	/* the paths are given as SenML records */
+	r = coap_find_options(in->in_cpkt, COAP_OPTION_CONTENT_FORMAT,
+			      &option, 1);
+	if (r <= 0) {
+		return -ENOMSG;
+	}
+
+	format = coap_option_value_to_int(&option);
+	r = select_reader(in, format);
+	if (r < 0) {
+		return r;
+	}
+
+	/* answer in the format of the request by default */
+	r = coap_find_options(in->in_cpkt, COAP_OPTION_ACCEPT, &option, 1);
+	if (r > 0) {
+		accept = coap_option_value_to_int(&option);
+	} else {
+		accept = format;
+	}
+
+	r = select_writer(out, accept);
+	if (r < 0) {
+		return r;
+	}
+
+	in->frag = coap_packet_get_payload(in->in_cpkt, &in->offset,
+					   &in->payload_len);
+	if (!in->frag || !in->payload_len) {
+		return -EEXIST;
+	}
+
+	count = do_composite_paths(in, format, paths, ARRAY_SIZE(paths));
+	if (count < 0) {
+		return count;
+	}
+
+	for (i = 0; i < count; i++) {
+		/* do not expose security obj */
+		if (paths[i].level == 0 ||
+		    paths[i].obj_id == LWM2M_OBJECT_SECURITY_ID) {
+			return -EPERM;
+		}
+	}
+
+	observe = get_option_int(in->in_cpkt, COAP_OPTION_OBSERVE);
+	context->operation = LWM2M_OP_READ;
+	msg->code = COAP_RESPONSE_CODE_CONTENT;
+
+	r = lwm2m_init_message(msg);
+	if (r < 0) {
+		return r;
+	}
+
+	if (observe == 0) {
+		if (!msg->token) {
+			LOG_ERR("OBSERVE request missing token");
+			return -EINVAL;
+		}
+
+		r = coap_append_option_int(out->out_cpkt, COAP_OPTION_OBSERVE,
+					   1);
+		if (r < 0) {
+			LOG_ERR("OBSERVE option error: %d", r);
+			return r;
+		}
+
+		r = engine_add_composite_observer(msg, token, tkl, paths,
+						  count, accept);
+		if (r < 0) {
+			LOG_ERR("add OBSERVE error: %d", r);
+			return r;
+		}
+	} else if (observe == 1) {
+		r = engine_remove_observer(token, tkl);
+		if (r < 0) {
+			LOG_ERR("remove observe error: %d", r);
+		}
+	}
+
+	return do_composite_read_op(context, paths, count, accept);
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
+
 static int handle_request(struct coap_packet *request,
 			  struct lwm2m_message *msg)
 {
@@ -3172,6 +4164,17 @@ static int handle_request(struct coap_packet *request,
 	r = coap_find_options(in.in_cpkt, COAP_OPTION_URI_PATH, options,
 			      ARRAY_SIZE(options));
 	if (r <= 0) {
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+		if ((code & COAP_REQUEST_MASK) == COAP_METHOD_FETCH) {
+			r = handle_composite_request(msg, &context, token, tkl);
+			if (r < 0) {
+				goto error;
+			}
+
+			return 0;
+		}
+#endif
+
 		/* '/' is used by bootstrap-delete only */
 
 		/*
@@ -3705,11 +4708,46 @@ static int notify_message_reply_cb(const struct coap_packet *response,
 	return 0;
 }
 
+/* read the paths of the group into the notification */
+static int observer_group_read(struct lwm2m_engine_context *context,
+			       struct observe_node *obs)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_MAX_PATHS];
+	struct observe_node *tmp;
+	int path_count = 0;
+
+	if (obs->composite) {
+		SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, tmp, node) {
+			if (observer_in_group(obs, tmp) &&
+			    path_count < ARRAY_SIZE(paths)) {
+				memcpy(&paths[path_count++], &tmp->path,
+				       sizeof(tmp->path));
+			}
+		}
+
+		return do_composite_read_op(context, paths, path_count,
+					    obs->format);
+	}
+#endif
+
+	obj_inst = get_engine_obj_inst(obs->path.obj_id,
+				       obs->path.obj_inst_id);
+	if (!obj_inst) {
+		LOG_ERR("unable to get engine obj for %u/%u",
+			obs->path.obj_id,
+			obs->path.obj_inst_id);
+		return -EINVAL;
+	}
+
+	return do_read_op(obj_inst->obj, context, obs->format);
+}
+
 static int generate_notify_message(struct observe_node *obs,
 				   bool manual_trigger)
 {
 	struct lwm2m_message *msg;
-	struct lwm2m_engine_obj_inst *obj_inst;
 	struct lwm2m_output_context out;
 	struct lwm2m_engine_context context;
 	struct lwm2m_obj_path path;
@@ -3740,15 +4778,6 @@ static int generate_notify_message(struct observe_node *obs,
 			&obs->ctx->net_app_ctx.default_ctx->remote),
 		k_uptime_get());
 
-	obj_inst = get_engine_obj_inst(obs->path.obj_id,
-				       obs->path.obj_inst_id);
-	if (!obj_inst) {
-		LOG_ERR("unable to get engine obj for %u/%u",
-			obs->path.obj_id,
-			obs->path.obj_inst_id);
-		return -EINVAL;
-	}
-
 	msg = lwm2m_get_message(obs->ctx);
 	if (!msg) {
 		LOG_ERR("Unable to get a lwm2m message!");
@@ -3781,7 +4810,7 @@ static int generate_notify_message(struct observe_node *obs,
 	/* set the output writer */
 	select_writer(&out, obs->format);
 
-	ret = do_read_op(obj_inst->obj, &context, obs->format);
+	ret = observer_group_read(&context, obs);
 	if (ret < 0) {
 		LOG_ERR("error in multi-format read (err:%d)", ret);
 		goto cleanup;
@@ -3793,6 +4822,7 @@ static int generate_notify_message(struct observe_node *obs,
 		goto cleanup;
 	}
 
+	obs->ctx->notify_stats.sent++;
 	LOG_DBG("NOTIFY MSG: SENT");
 	return 0;
 
@@ -3801,6 +4831,148 @@ cleanup:
 	return ret;
 }
 
+/*
+ * A group is due when one of its paths has an event pending for pmin
+ * at least, or has not been notified for pmax.
+ */
+static bool observer_group_due(struct observe_node *first, s64_t timestamp,
+			       bool *manual_trigger)
+{
+	struct observe_node *obs;
+	bool due = false;
+
+	*manual_trigger = false;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		if (!observer_in_group(first, obs)) {
+			continue;
+		}
+
+		/*
+		 * manual notify requirements:
+		 * - an event is pending
+		 * - current timestamp > last_timestamp + min_period_sec
+		 */
+		if (obs->pending &&
+		    timestamp > obs->last_timestamp +
+				K_SECONDS(obs->min_period_sec)) {
+			*manual_trigger = true;
+			due = true;
+
+		/*
+		 * automatic time-based notify requirements:
+		 * - current timestamp > last_timestamp + max_period_sec
+		 */
+		} else if (timestamp > obs->last_timestamp +
+				K_SECONDS(obs->max_period_sec)) {
+			due = true;
+		}
+	}
+
+	return due;
+}
+
+/* the values notified are the new reference for gt/lt/st */
+static void observer_group_update(struct observe_node *first,
+				  s64_t timestamp)
+{
+	struct observe_node *obs;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		if (!observer_in_group(first, obs)) {
+			continue;
+		}
+
+		obs->last_timestamp = timestamp;
+		obs->pending = false;
+		obs->deferred = false;
+		(void)observer_value(obs, &obs->last_value);
+	}
+}
+
+#if CONFIG_LWM2M_ENGINE_NOTIFY_BURST > 0
+/*
+ * Token bucket of the server: a notification takes a token, and one is
+ * given back every CONFIG_LWM2M_ENGINE_NOTIFY_PERIOD up to the burst size.
+ */
+static bool notify_rate_allowed(struct lwm2m_ctx *ctx, s64_t timestamp)
+{
+	s64_t refill;
+
+	refill = (timestamp - ctx->notify_timestamp) /
+		 CONFIG_LWM2M_ENGINE_NOTIFY_PERIOD;
+	if (refill > 0) {
+		if (ctx->notify_tokens + refill >=
+		    CONFIG_LWM2M_ENGINE_NOTIFY_BURST) {
+			ctx->notify_tokens = CONFIG_LWM2M_ENGINE_NOTIFY_BURST;
+			ctx->notify_timestamp = timestamp;
+		} else {
+			ctx->notify_tokens += refill;
+			ctx->notify_timestamp +=
+				refill * CONFIG_LWM2M_ENGINE_NOTIFY_PERIOD;
+		}
+	}
+
+	if (!ctx->notify_tokens) {
+		return false;
+	}
+
+	ctx->notify_tokens--;
+	return true;
+}
+
+/* the token of a notification which could not be sent is given back */
+static void notify_rate_refund(struct lwm2m_ctx *ctx)
+{
+	if (ctx->notify_tokens < CONFIG_LWM2M_ENGINE_NOTIFY_BURST) {
+		ctx->notify_tokens++;
+	}
+}
+#else
+static inline bool notify_rate_allowed(struct lwm2m_ctx *ctx,
+				       s64_t timestamp)
+{
+	return true;
+}
+
+static inline void notify_rate_refund(struct lwm2m_ctx *ctx)
+{
+}
+#endif
+
+static void notify_observers(void)
+{
+	struct observe_node *obs;
+	s64_t timestamp = k_uptime_get();
+	bool manual_trigger;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		/* the paths of a composite observation are sent at once */
+		if (!observer_group_first(obs) ||
+		    !observer_group_due(obs, timestamp, &manual_trigger)) {
+			continue;
+		}
+
+		if (!notify_rate_allowed(obs->ctx, timestamp)) {
+			/* retried by the next loop, counted once */
+			if (!obs->deferred) {
+				obs->ctx->notify_stats.rate_limited++;
+				obs->deferred = true;
+			}
+
+			continue;
+		}
+
+		/* still pending, retried by the next loop */
+		if (generate_notify_message(obs, manual_trigger) < 0) {
+			notify_rate_refund(obs->ctx);
+			continue;
+		}
+
+		observer_group_update(obs, timestamp);
+	}
+}
+
 s32_t engine_next_service_timeout_ms(u32_t max_timeout)
 {
 	struct service_node *srv;
@@ -3858,7 +5030,6 @@ int lwm2m_engine_add_service(void (*service)(void), u32_t period_ms)
 /* TODO: this needs to be triggered via work_queue */
 static void lwm2m_engine_service(void)
 {
-	struct observe_node *obs;
 	struct service_node *srv;
 	s64_t timestamp, service_due_timestamp;
 
@@ -3869,30 +5040,7 @@ static void lwm2m_engine_service(void)
 		 * 3. For each observer match, generate a NOTIFY message,
 		 *    attaching the notify response handler
 		 */
-		timestamp = k_uptime_get();
-		SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-			/*
-			 * manual notify requirements:
-			 * - event_timestamp > last_timestamp
-			 * - current timestamp > last_timestamp + min_period_sec
-			 */
-			if (obs->event_timestamp > obs->last_timestamp &&
-			    timestamp > obs->last_timestamp +
-					K_SECONDS(obs->min_period_sec)) {
-				obs->last_timestamp = k_uptime_get();
-				generate_notify_message(obs, true);
-
-			/*
-			 * automatic time-based notify requirements:
-			 * - current timestamp > last_timestamp + max_period_sec
-			 */
-			} else if (timestamp > obs->last_timestamp +
-					K_SECONDS(obs->min_period_sec)) {
-				obs->last_timestamp = k_uptime_get();
-				generate_notify_message(obs, false);
-			}
-
-		}
+		notify_observers();
 
 		timestamp = k_uptime_get();
 		SYS_SLIST_FOR_EACH_CONTAINER(&engine_service_list, srv, node) {
@@ -3930,6 +5078,11 @@ void lwm2m_engine_context_init(struct lwm2m_ctx *client_ctx)
 {
 	k_delayed_work_init(&client_ctx->retransmit_work, retransmit_request);
 
+#if CONFIG_LWM2M_ENGINE_NOTIFY_BURST > 0
+	client_ctx->notify_timestamp = k_uptime_get();
+	client_ctx->notify_tokens = CONFIG_LWM2M_ENGINE_NOTIFY_BURST;
+#endif
+
 #if defined(CONFIG_NET_CONTEXT_NET_PKT_POOL)
 	net_app_set_net_pkt_pool(&client_ctx->net_app_ctx,
 				 client_ctx->tx_slab, client_ctx->data_pool);
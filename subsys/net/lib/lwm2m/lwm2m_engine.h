@@ -18,6 +18,8 @@
 #define LWM2M_FORMAT_APP_OCTET_STREAM	42
 #define LWM2M_FORMAT_APP_EXI		47
 #define LWM2M_FORMAT_APP_JSON		50
+#define LWM2M_FORMAT_APP_SENML_JSON	110
+#define LWM2M_FORMAT_APP_SENML_CBOR	112
 #define LWM2M_FORMAT_OMA_PLAIN_TEXT	1541
 #define LWM2M_FORMAT_OMA_OLD_TLV	1542
 #define LWM2M_FORMAT_OMA_OLD_JSON	1543
@@ -115,6 +117,16 @@ int lwm2m_write_handler(struct lwm2m_engine_obj_inst *obj_inst,
 			struct lwm2m_engine_obj_field *obj_field,
 			struct lwm2m_engine_context *context);
 
+int lwm2m_write_record(struct lwm2m_engine_obj *obj,
+		       struct lwm2m_engine_context *context, char *pathstr);
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int lwm2m_perform_composite_read_op(struct lwm2m_engine_context *context,
+				    struct lwm2m_obj_path *paths,
+				    int path_count, u16_t content_format);
+int lwm2m_string_to_path(char *pathstr, struct lwm2m_obj_path *path);
+#endif
+
 void lwm2m_udp_receive(struct lwm2m_ctx *client_ctx, struct net_pkt *pkt,
 		       bool handle_separate_response,
 		       udp_request_handler_cb_t udp_request_handler);
@@ -246,6 +246,9 @@ struct lwm2m_engine_obj_inst {
 	/* instance list */
 	sys_snode_t node;
 
+	/* instance hash table */
+	sys_snode_t index_node;
+
 	struct lwm2m_engine_obj *obj;
 	struct lwm2m_engine_res_inst *resources;
 
@@ -222,22 +222,39 @@ static size_t oma_tlv_put(const struct oma_tlv *tlv,
 	return pos + tlv->length;
 }
 
+static void in_cursor_init(struct lwm2m_input_context *in,
+			   struct net_pkt_cursor *cursor)
+{
+	net_pkt_cursor_set(cursor, in->in_cpkt->pkt, in->frag, in->offset);
+}
+
+/* Update the read position of the input context, in the format of
+ * net_frag_read(): the fragment of the next byte, or NULL at the end.
+ */
+static void in_cursor_update(struct lwm2m_input_context *in,
+			     struct net_pkt_cursor *cursor)
+{
+	u16_t len;
+
+	net_pkt_cursor_span(cursor, &len);
+
+	in->frag = cursor->buf;
+	in->offset = cursor->pos;
+}
+
 static size_t oma_tlv_get(struct oma_tlv *tlv,
 			  struct lwm2m_input_context *in,
 			  bool dont_advance)
 {
-	struct net_buf *tmp_frag;
+	struct net_pkt_cursor cursor;
 	u8_t len_type;
 	u8_t len_pos = 1;
 	size_t tlv_len;
-	u16_t tmp_offset;
 	u8_t buf[2];
 
-	tmp_frag = in->frag;
-	tmp_offset = in->offset;
-	tmp_frag = net_frag_read_u8(tmp_frag, tmp_offset, &tmp_offset, &buf[0]);
+	in_cursor_init(in, &cursor);
 
-	if (!tmp_frag && tmp_offset == 0xffff) {
+	if (net_pkt_cursor_read(&cursor, buf, sizeof(buf)) < 0) {
 		goto error;
 	}
 
@@ -245,18 +262,11 @@ static size_t oma_tlv_get(struct oma_tlv *tlv,
 	len_type = (buf[0] >> 3) & 3;
 	len_pos = 1 + (((buf[0] & (1 << 5)) != 0) ? 2 : 1);
 
-	tmp_frag = net_frag_read_u8(tmp_frag, tmp_offset, &tmp_offset, &buf[1]);
-	if (!tmp_frag && tmp_offset == 0xffff) {
-		return 0;
-	}
-
 	tlv->id = buf[1];
 
 	/* if len_pos > 2 it means that there are more ID to read */
 	if (len_pos > 2) {
-		tmp_frag = net_frag_read_u8(tmp_frag, tmp_offset,
-					    &tmp_offset, &buf[1]);
-		if (!tmp_frag && tmp_offset == 0xffff) {
+		if (net_pkt_cursor_read_u8(&cursor, &buf[1]) < 0) {
 			goto error;
 		}
 
@@ -269,9 +279,7 @@ static size_t oma_tlv_get(struct oma_tlv *tlv,
 		/* read the length */
 		tlv_len = 0;
 		while (len_type > 0) {
-			tmp_frag = net_frag_read_u8(tmp_frag, tmp_offset,
-						    &tmp_offset, &buf[1]);
-			if (!tmp_frag && tmp_offset == 0xffff) {
+			if (net_pkt_cursor_read_u8(&cursor, &buf[1]) < 0) {
 				goto error;
 			}
 
@@ -285,8 +293,7 @@ static size_t oma_tlv_get(struct oma_tlv *tlv,
 	tlv->length = tlv_len;
 
 	if (!dont_advance) {
-		in->frag = tmp_frag;
-		in->offset = tmp_offset;
+		in_cursor_update(in, &cursor);
 	}
 
 	return len_pos + tlv_len;
@@ -294,8 +301,7 @@ static size_t oma_tlv_get(struct oma_tlv *tlv,
 error:
 	/* TODO: Generate error? */
 	if (!dont_advance) {
-		in->frag = tmp_frag;
-		in->offset = tmp_offset;
+		in_cursor_update(in, &cursor);
 	}
 
 	return 0;
@@ -829,14 +835,14 @@ int do_read_op_tlv(struct lwm2m_engine_obj *obj,
 static int do_write_op_tlv_dummy_read(struct lwm2m_engine_context *context)
 {
 	struct lwm2m_input_context *in = context->in;
+	struct net_pkt_cursor cursor;
 	struct oma_tlv tlv;
-	u8_t read_char;
 
 	oma_tlv_get(&tlv, in, false);
-	while (in->frag && tlv.length--) {
-		in->frag = net_frag_read_u8(in->frag, in->offset, &in->offset,
-					    &read_char);
-	}
+
+	in_cursor_init(in, &cursor);
+	net_pkt_cursor_skip(&cursor, tlv.length);
+	in_cursor_update(in, &cursor);
 
 	return 0;
 }
@@ -0,0 +1,1071 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML CBOR content format (RFC 8428), as used by LwM2M 1.1.
+ *
+ * A read is encoded with tinycbor, through a writer which appends each
+ * encoded item to the packet fragments: the records are an array of
+ * indefinite length, closed by put_end(), so that nothing has to be
+ * buffered or counted in advance. Labels are the integer ones of the
+ * RFC, the base name is only repeated when the object instance changes.
+ *
+ * A write is decoded in place from the packet fragments, tinycbor
+ * reading them through a net_pkt cursor.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <misc/byteorder.h>
+
+#include "cbor.h"
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_engine.h"
+
+/* SenML labels */
+#define SENML_BN		-2
+#define SENML_N			0
+#define SENML_V			2
+#define SENML_VS		3
+#define SENML_VB		4
+#define SENML_VD		8
+
+/* base name and name, up to a whole path */
+#define SENML_NAME_LEN		sizeof("/65535/65535/65535/65535")
+
+#define FLOAT32_DIGITS		6
+#define FLOAT64_DIGITS		9
+
+/* CBOR initial bytes of the floating point values */
+#define CBOR_FLOAT32		0xfa
+#define CBOR_FLOAT64		0xfb
+
+struct senml_cbor_out_formatter_data {
+	struct cbor_encoder_writer writer;
+	struct lwm2m_output_context *out;
+	CborEncoder encoder;
+	CborEncoder records;
+	/* object instance of the last base name, -1 before the first one */
+	s32_t base_obj_inst_id;
+	u16_t base_obj_id;
+	u8_t writer_flags;
+};
+
+static int senml_cbor_write(struct cbor_encoder_writer *writer,
+			    const char *data, int len)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	struct lwm2m_output_context *out;
+
+	fd = CONTAINER_OF(writer, struct senml_cbor_out_formatter_data, writer);
+	out = fd->out;
+
+	out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
+				  out->offset, &out->offset, len,
+				  (u8_t *)data, BUF_ALLOC_TIMEOUT);
+	if (!out->frag && out->offset == 0xffff) {
+		return CborErrorOutOfMemory;
+	}
+
+	writer->bytes_written += len;
+	return CborNoError;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	cbor_encoder_cust_writer_init(&fd->encoder, &fd->writer, 0);
+
+	if (cbor_encoder_create_array(&fd->encoder, &fd->records,
+				      CborIndefiniteLength) != CborNoError) {
+		return 0;
+	}
+
+	return 1;
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (cbor_encoder_close_container(&fd->encoder,
+					 &fd->records) != CborNoError) {
+		return 0;
+	}
+
+	return 1;
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* Open the map of a record and encode its names, up to the label of its
+ * value.
+ */
+static CborError record_begin(struct senml_cbor_out_formatter_data *fd,
+			      struct lwm2m_obj_path *path, CborEncoder *map,
+			      int label)
+{
+	char name[SENML_NAME_LEN];
+	bool base_name = fd->base_obj_inst_id != path->obj_inst_id ||
+			 fd->base_obj_id != path->obj_id;
+	CborError err;
+
+	err = cbor_encoder_create_map(&fd->records, map, base_name ? 3 : 2);
+
+	if (base_name) {
+		fd->base_obj_inst_id = path->obj_inst_id;
+		fd->base_obj_id = path->obj_id;
+		snprintk(name, sizeof(name), "/%u/%u/",
+			 path->obj_id, path->obj_inst_id);
+
+		err |= cbor_encode_int(map, SENML_BN);
+		err |= cbor_encode_text_stringz(map, name);
+	}
+
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		snprintk(name, sizeof(name), "%u/%u",
+			 path->res_id, path->res_inst_id);
+	} else {
+		snprintk(name, sizeof(name), "%u", path->res_id);
+	}
+
+	err |= cbor_encode_int(map, SENML_N);
+	err |= cbor_encode_text_stringz(map, name);
+	err |= cbor_encode_int(map, label);
+
+	return err;
+}
+
+/* Close the map of a record, returning the length of the record */
+static size_t record_end(struct senml_cbor_out_formatter_data *fd,
+			 CborEncoder *map, CborError err, int start)
+{
+	/* The map has a definite length, closing it only checks its count
+	 * of items, and then the end of the default writer, which is not
+	 * the one in use. Writer errors have already been returned by the
+	 * encoding functions.
+	 */
+	(void)cbor_encoder_close_container(&fd->records, map);
+
+	if (err != CborNoError) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_OUTPUT_VALUE;
+	return fd->writer.bytes_written - start;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s64_t value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_V);
+	err |= cbor_encode_int(&map, value);
+
+	return record_end(fd, &map, err, start);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s32_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s16_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, s8_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+/* Encode the bits of a float or a double. cbor_encode_floating_point()
+ * is only built along with CONFIG_CBOR_FLOATING_POINT, which requires
+ * newlib, so the item is written here.
+ */
+static CborError encode_float_bits(CborEncoder *map, u8_t type, u64_t bits)
+{
+	u8_t buf[1 + sizeof(bits)];
+	int len;
+
+	buf[0] = type;
+
+	if (type == CBOR_FLOAT32) {
+		sys_put_be32((u32_t)bits, &buf[1]);
+		len = 1 + sizeof(u32_t);
+	} else {
+		sys_put_be32((u32_t)(bits >> 32), &buf[1]);
+		sys_put_be32((u32_t)bits, &buf[5]);
+		len = 1 + sizeof(u64_t);
+	}
+
+	if (map->remaining) {
+		map->remaining--;
+	}
+
+	return map->writer->write(map->writer, (const char *)buf, len);
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+	float f;
+	u32_t bits;
+
+	/* Whole numbers are shorter as integers */
+	if (!value->val2) {
+		return put_s64(out, path, (s64_t)value->val1);
+	}
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	f = (float)value->val1 + (float)value->val2 / 1000000.0f;
+	memcpy(&bits, &f, sizeof(bits));
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_V);
+	err |= encode_float_bits(&map, CBOR_FLOAT32, bits);
+
+	return record_end(fd, &map, err, start);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+	double d;
+	u64_t bits;
+
+	if (!value->val2) {
+		return put_s64(out, path, value->val1);
+	}
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	d = (double)value->val1 + (double)value->val2 / 1000000000.0;
+	memcpy(&bits, &d, sizeof(bits));
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_V);
+	err |= encode_float_bits(&map, CBOR_FLOAT64, bits);
+
+	return record_end(fd, &map, err, start);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_VB);
+	err |= cbor_encode_boolean(&map, value);
+
+	return record_end(fd, &map, err, start);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_VS);
+	err |= cbor_encode_text_string(&map, buf, buflen);
+
+	return record_end(fd, &map, err, start);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+	CborEncoder map;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = record_begin(fd, path, &map, SENML_VD);
+	err |= cbor_encode_byte_string(&map, (const u8_t *)buf, buflen);
+
+	return record_end(fd, &map, err, start);
+}
+
+/* tinycbor reads the message at absolute offsets, which are followed
+ * here with a cursor: reading forward only moves it, reading backward
+ * starts again from the beginning of the message.
+ */
+struct senml_cbor_reader {
+	struct cbor_decoder_reader r;
+	struct net_pkt_cursor start;
+	struct net_pkt_cursor cursor;
+	int offset;
+};
+
+static int reader_seek(struct senml_cbor_reader *reader, int offset)
+{
+	if (offset < reader->offset) {
+		reader->cursor = reader->start;
+		reader->offset = 0;
+	}
+
+	if (offset > reader->offset) {
+		if (net_pkt_cursor_skip(&reader->cursor,
+					offset - reader->offset) < 0) {
+			return -EINVAL;
+		}
+
+		reader->offset = offset;
+	}
+
+	return 0;
+}
+
+static int reader_peek(struct cbor_decoder_reader *d, int offset,
+		       void *buf, size_t len)
+{
+	struct senml_cbor_reader *reader;
+
+	reader = CONTAINER_OF(d, struct senml_cbor_reader, r);
+
+	if (reader_seek(reader, offset) < 0) {
+		return -EINVAL;
+	}
+
+	return net_pkt_cursor_peek(&reader->cursor, buf, len);
+}
+
+static uint8_t reader_get8(struct cbor_decoder_reader *d, int offset)
+{
+	u8_t value;
+
+	if (reader_peek(d, offset, &value, sizeof(value)) < 0) {
+		/* a break byte, which ends any container */
+		return 0xff;
+	}
+
+	return value;
+}
+
+static uint16_t reader_get16(struct cbor_decoder_reader *d, int offset)
+{
+	u8_t buf[sizeof(u16_t)];
+
+	if (reader_peek(d, offset, buf, sizeof(buf)) < 0) {
+		return 0;
+	}
+
+	return sys_get_be16(buf);
+}
+
+static uint32_t reader_get32(struct cbor_decoder_reader *d, int offset)
+{
+	u8_t buf[sizeof(u32_t)];
+
+	if (reader_peek(d, offset, buf, sizeof(buf)) < 0) {
+		return 0;
+	}
+
+	return sys_get_be32(buf);
+}
+
+static uint64_t reader_get64(struct cbor_decoder_reader *d, int offset)
+{
+	u8_t buf[sizeof(u64_t)];
+
+	if (reader_peek(d, offset, buf, sizeof(buf)) < 0) {
+		return 0;
+	}
+
+	return (u64_t)sys_get_be32(buf) << 32 | sys_get_be32(&buf[4]);
+}
+
+/* Nonzero when equal, as tinycbor expects */
+static uintptr_t reader_cmp(struct cbor_decoder_reader *d, char *buf,
+			    int offset, size_t len)
+{
+	u8_t chunk[16];
+	size_t count;
+
+	while (len) {
+		count = min(len, sizeof(chunk));
+
+		if (reader_peek(d, offset, chunk, count) < 0 ||
+		    memcmp(chunk, buf, count)) {
+			return 0;
+		}
+
+		buf += count;
+		offset += count;
+		len -= count;
+	}
+
+	return 1;
+}
+
+static uintptr_t reader_cpy(struct cbor_decoder_reader *d, char *dst,
+			    int offset, size_t len)
+{
+	if (reader_peek(d, offset, dst, len) < 0) {
+		return 0;
+	}
+
+	return (uintptr_t)dst;
+}
+
+/* The chunk is not contiguous in memory, tinycbor only checks that it
+ * is there and then reads it with cpy().
+ */
+static uintptr_t reader_get_string_chunk(struct cbor_decoder_reader *d,
+					 int offset, size_t *len)
+{
+	return (uintptr_t)d;
+}
+
+static void reader_init(struct senml_cbor_reader *reader,
+			struct net_pkt_cursor *cursor)
+{
+	reader->r.get8 = reader_get8;
+	reader->r.get16 = reader_get16;
+	reader->r.get32 = reader_get32;
+	reader->r.get64 = reader_get64;
+	reader->r.cmp = reader_cmp;
+	reader->r.cpy = reader_cpy;
+	reader->r.get_string_chunk = reader_get_string_chunk;
+	reader->r.message_size = net_pkt_cursor_remaining(cursor);
+
+	reader->start = *cursor;
+	reader->cursor = *cursor;
+	reader->offset = 0;
+}
+
+static void in_cursor_init(struct lwm2m_input_context *in,
+			   struct net_pkt_cursor *cursor)
+{
+	net_pkt_cursor_set(cursor, in->in_cpkt->pkt, in->frag, in->offset);
+}
+
+/* Update the read position of the input context, in the format of
+ * net_frag_read(): the fragment of the next byte, or NULL at the end.
+ */
+static void in_cursor_update(struct lwm2m_input_context *in,
+			     struct net_pkt_cursor *cursor)
+{
+	u16_t len;
+
+	net_pkt_cursor_span(cursor, &len);
+
+	in->frag = cursor->buf;
+	in->offset = cursor->pos;
+}
+
+/* Start parsing the value at the read position of the input context */
+static int value_init(struct lwm2m_input_context *in,
+		      struct senml_cbor_reader *reader, CborParser *parser,
+		      CborValue *value)
+{
+	struct net_pkt_cursor cursor;
+
+	in_cursor_init(in, &cursor);
+	reader_init(reader, &cursor);
+
+	if (cbor_parser_cust_reader_init(&reader->r, 0, parser,
+					 value) != CborNoError) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Move the read position of the input context after the value */
+static size_t value_done(struct lwm2m_input_context *in,
+			 struct senml_cbor_reader *reader, CborValue *value)
+{
+	if (cbor_value_advance(value) != CborNoError ||
+	    reader_seek(reader, value->offset) < 0) {
+		return 0;
+	}
+
+	in_cursor_update(in, &reader->cursor);
+
+	return value->offset;
+}
+
+static double half_to_double(u16_t half)
+{
+	int exponent = (half >> 10) & 0x1f;
+	int mantissa = half & 0x3ff;
+	double value;
+
+	if (exponent == 0) {
+		value = mantissa / 16777216.0;
+	} else {
+		value = (mantissa + 1024) / 1024.0;
+
+		while (exponent > 15) {
+			value *= 2;
+			exponent--;
+		}
+
+		while (exponent < 15) {
+			value /= 2;
+			exponent++;
+		}
+	}
+
+	return half & 0x8000 ? -value : value;
+}
+
+/* Decode a number as its integer part and its decimals times 10^digits */
+static int decode_number(CborValue *value, s64_t *val1, s64_t *val2,
+			 int digits)
+{
+	s64_t scale = 1;
+	int64_t integer;
+	double d;
+	float f;
+	u16_t half;
+
+	while (digits--) {
+		scale *= 10;
+	}
+
+	if (cbor_value_is_integer(value)) {
+		if (cbor_value_get_int64(value, &integer) != CborNoError) {
+			return -EINVAL;
+		}
+
+		*val1 = integer;
+		if (val2) {
+			*val2 = 0;
+		}
+
+		return 0;
+	}
+
+	if (cbor_value_is_float(value)) {
+		cbor_value_get_float(value, &f);
+		d = f;
+	} else if (cbor_value_is_double(value)) {
+		cbor_value_get_double(value, &d);
+	} else if (cbor_value_is_half_float(value)) {
+		cbor_value_get_half_float(value, &half);
+		d = half_to_double(half);
+	} else {
+		return -EINVAL;
+	}
+
+	*val1 = (s64_t)d;
+	if (val2) {
+		*val2 = (s64_t)((d - *val1) * scale + (d < 0 ? -0.5 : 0.5));
+
+		/* rounding up to the next integer */
+		if (*val2 == scale || *val2 == -scale) {
+			*val1 += *val2 / scale;
+			*val2 = 0;
+		}
+	}
+
+	return 0;
+}
+
+/* Length of the head of a string of definite length */
+static int string_header_len(size_t len)
+{
+	if (len < 24) {
+		return 1;
+	} else if (len <= 0xff) {
+		return 2;
+	} else if (len <= 0xffff) {
+		return 3;
+	}
+
+	return 5;
+}
+
+/* Read a text string, truncated to buflen - 1 bytes and NUL terminated.
+ * Strings in chunks are not supported.
+ */
+static int read_text(struct senml_cbor_reader *reader, CborValue *value,
+		     char *buf, size_t buflen)
+{
+	size_t len, header_len;
+
+	if (!cbor_value_is_text_string(value) ||
+	    cbor_value_get_string_length(value, &len) != CborNoError) {
+		return -EINVAL;
+	}
+
+	header_len = string_header_len(len);
+	len = min(len, buflen - 1);
+
+	if (reader_peek(&reader->r, value->offset + header_len,
+			buf, len) < 0) {
+		return -EINVAL;
+	}
+
+	buf[len] = '\0';
+
+	return len;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, s64_t *value)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    decode_number(&it, value, NULL, 0) < 0) {
+		return 0;
+	}
+
+	return value_done(in, &reader, &it);
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, s32_t *value)
+{
+	s64_t tmp = 0;
+	size_t len;
+
+	len = get_s64(in, &tmp);
+	if (len > 0) {
+		*value = (s32_t)tmp;
+	}
+
+	return len;
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    read_text(&reader, &it, (char *)buf, buflen) < 0) {
+		buf[0] = '\0';
+		return 0;
+	}
+
+	return value_done(in, &reader, &it);
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+	s64_t tmp1, tmp2;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    decode_number(&it, &tmp1, &tmp2, FLOAT32_DIGITS) < 0) {
+		return 0;
+	}
+
+	value->val1 = (s32_t)tmp1;
+	value->val2 = (s32_t)tmp2;
+
+	return value_done(in, &reader, &it);
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    decode_number(&it, &value->val1, &value->val2,
+			  FLOAT64_DIGITS) < 0) {
+		return 0;
+	}
+
+	return value_done(in, &reader, &it);
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    !cbor_value_is_boolean(&it) ||
+	    cbor_value_get_boolean(&it, value) != CborNoError) {
+		return 0;
+	}
+
+	return value_done(in, &reader, &it);
+}
+
+/* The data of the byte string is left to lwm2m_engine_get_opaque_more(),
+ * which reads it raw, block after block.
+ */
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen, bool *last_block)
+{
+	struct senml_cbor_reader reader;
+	CborParser parser;
+	CborValue it;
+	size_t len;
+
+	*last_block = true;
+	in->opaque_len = 0;
+
+	if (value_init(in, &reader, &parser, &it) < 0 ||
+	    !cbor_value_is_byte_string(&it) ||
+	    cbor_value_get_string_length(&it, &len) != CborNoError ||
+	    reader_seek(&reader, string_header_len(len)) < 0) {
+		return 0;
+	}
+
+	in_cursor_update(in, &reader.cursor);
+	in->opaque_len = len;
+
+	return lwm2m_engine_get_opaque_more(in, buf, buflen, last_block);
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+};
+
+const struct lwm2m_reader senml_cbor_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.writer.write = senml_cbor_write;
+	fd.out = context->out;
+	fd.base_obj_inst_id = -1;
+
+	engine_set_out_user_data(context->out, &fd);
+	ret = lwm2m_perform_read_op(obj, context, content_format);
+	engine_clear_out_user_data(context->out);
+
+	return ret;
+}
+
+/* Parse the labels of a record, the base name being kept for the
+ * following records. The offset of the value is set to 0 when the
+ * record has none.
+ */
+static int parse_record(struct senml_cbor_reader *reader, CborValue *record,
+			char *base_name, char *name, int *value_offset)
+{
+	CborValue fields;
+	int label;
+
+	name[0] = '\0';
+	*value_offset = 0;
+
+	if (!cbor_value_is_map(record) ||
+	    cbor_value_enter_container(record, &fields) != CborNoError) {
+		return -EINVAL;
+	}
+
+	while (!cbor_value_at_end(&fields)) {
+		if (!cbor_value_is_integer(&fields) ||
+		    cbor_value_get_int(&fields, &label) != CborNoError) {
+			/* string labels are not used by LwM2M, skip them */
+			label = INT_MAX;
+		}
+
+		if (cbor_value_advance(&fields) != CborNoError) {
+			return -EINVAL;
+		}
+
+		switch (label) {
+		case SENML_BN:
+			if (read_text(reader, &fields, base_name,
+				      SENML_NAME_LEN) < 0) {
+				return -EINVAL;
+			}
+
+			break;
+		case SENML_N:
+			if (read_text(reader, &fields, name,
+				      SENML_NAME_LEN) < 0) {
+				return -EINVAL;
+			}
+
+			break;
+		case SENML_V:
+		case SENML_VS:
+		case SENML_VB:
+		case SENML_VD:
+			*value_offset = fields.offset;
+			break;
+		default:
+			break;
+		}
+
+		if (cbor_value_advance(&fields) != CborNoError) {
+			return -EINVAL;
+		}
+	}
+
+	if (cbor_value_leave_container(record, &fields) != CborNoError) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_write_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			   struct lwm2m_engine_context *context)
+{
+	struct lwm2m_input_context *in = context->in;
+	struct senml_cbor_reader reader;
+	struct net_pkt_cursor cursor;
+	char base_name[SENML_NAME_LEN] = "";
+	char name[SENML_NAME_LEN];
+	char path[SENML_NAME_LEN * 2];
+	CborParser parser;
+	CborValue it, record;
+	int value_offset;
+	int ret;
+
+	in_cursor_init(in, &cursor);
+	reader_init(&reader, &cursor);
+
+	if (cbor_parser_cust_reader_init(&reader.r, 0, &parser,
+					 &it) != CborNoError ||
+	    !cbor_value_is_array(&it) ||
+	    cbor_value_enter_container(&it, &record) != CborNoError) {
+		return -EINVAL;
+	}
+
+	while (!cbor_value_at_end(&record)) {
+		ret = parse_record(&reader, &record, base_name, name,
+				   &value_offset);
+		if (ret < 0) {
+			LOG_ERR("Invalid SenML record");
+			return ret;
+		}
+
+		if (!value_offset) {
+			continue;
+		}
+
+		snprintk(path, sizeof(path), "%s%s", base_name, name);
+
+		/* the value is read by the reader functions above */
+		cursor = reader.start;
+		if (net_pkt_cursor_skip(&cursor, value_offset) < 0) {
+			return -EINVAL;
+		}
+
+		in_cursor_update(in, &cursor);
+		ret = lwm2m_write_record(obj, context, path);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int do_composite_read_op_senml_cbor(struct lwm2m_engine_context *context,
+				    struct lwm2m_obj_path *paths,
+				    int path_count, int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.writer.write = senml_cbor_write;
+	fd.out = context->out;
+	fd.base_obj_inst_id = -1;
+
+	engine_set_out_user_data(context->out, &fd);
+	ret = lwm2m_perform_composite_read_op(context, paths, path_count,
+					      content_format);
+	engine_clear_out_user_data(context->out);
+
+	return ret;
+}
+
+/* The paths of a composite operation are the names of its records, the
+ * values being ignored. Returns the number of paths.
+ */
+int do_composite_paths_senml_cbor(struct lwm2m_input_context *in,
+				  struct lwm2m_obj_path *paths, int max_paths)
+{
+	struct senml_cbor_reader reader;
+	struct net_pkt_cursor cursor;
+	char base_name[SENML_NAME_LEN] = "";
+	char name[SENML_NAME_LEN];
+	char path[SENML_NAME_LEN * 2];
+	CborParser parser;
+	CborValue it, record;
+	int value_offset;
+	int count = 0;
+	int ret;
+
+	in_cursor_init(in, &cursor);
+	reader_init(&reader, &cursor);
+
+	if (cbor_parser_cust_reader_init(&reader.r, 0, &parser,
+					 &it) != CborNoError ||
+	    !cbor_value_is_array(&it) ||
+	    cbor_value_enter_container(&it, &record) != CborNoError) {
+		return -EINVAL;
+	}
+
+	while (!cbor_value_at_end(&record)) {
+		ret = parse_record(&reader, &record, base_name, name,
+				   &value_offset);
+		if (ret < 0) {
+			LOG_ERR("Invalid SenML record");
+			return ret;
+		}
+
+		if (count == max_paths) {
+			return -EFBIG;
+		}
+
+		snprintk(path, sizeof(path), "%s%s", base_name, name);
+
+		ret = lwm2m_string_to_path(path, &paths[count++]);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return count;
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
@@ -0,0 +1,999 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML JSON content format (RFC 8428), as used by LwM2M 1.1.
+ *
+ * A read is written as an array of records, each one written to the
+ * packet fragments as soon as it is formatted:
+ *
+ *   [{"bn":"/3/0/","n":"0","vs":"Zephyr"},{"n":"9","v":75},...]
+ *
+ * The base name is the path of the object instance, it is only repeated
+ * when the instance changes. A write is read in place from the packet
+ * fragments: each record is parsed up to its value, then the value is
+ * read by the reader functions below.
+ *
+ * Numbers with an exponent are not supported.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_json
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_json.h"
+#include "lwm2m_engine.h"
+
+/* base name and name, up to a whole path */
+#define SENML_NAME_LEN		sizeof("/65535/65535/65535/65535")
+
+/* longest SenML label we look at is "bver" */
+#define SENML_LABEL_LEN		5
+
+#define FLOAT32_DIGITS		6
+#define FLOAT64_DIGITS		9
+
+struct senml_json_out_formatter_data {
+	/* object instance of the last base name, -1 before the first one */
+	s32_t base_obj_inst_id;
+	u16_t base_obj_id;
+	u8_t writer_flags;
+};
+
+/* some temporary buffer space for format conversions */
+static char senml_json_buffer[96];
+
+static const char base64url[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static size_t senml_json_write(struct lwm2m_output_context *out,
+			       char *buf, int len)
+{
+	out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
+				  out->offset, &out->offset, len, (u8_t *)buf,
+				  BUF_ALLOC_TIMEOUT);
+	if (!out->frag && out->offset == 0xffff) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	return senml_json_write(out, "[", 1);
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	return senml_json_write(out, "]", 1);
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* Format the start of a record in senml_json_buffer, up to its value */
+static int put_record_prefix(struct senml_json_out_formatter_data *fd,
+			     struct lwm2m_obj_path *path, const char *label)
+{
+	int len = 0;
+
+	if (fd->writer_flags & WRITER_OUTPUT_VALUE) {
+		senml_json_buffer[len++] = ',';
+	}
+
+	senml_json_buffer[len++] = '{';
+
+	if (fd->base_obj_inst_id != path->obj_inst_id ||
+	    fd->base_obj_id != path->obj_id) {
+		fd->base_obj_inst_id = path->obj_inst_id;
+		fd->base_obj_id = path->obj_id;
+		len += snprintk(senml_json_buffer + len,
+				sizeof(senml_json_buffer) - len,
+				"\"bn\":\"/%u/%u/\",",
+				path->obj_id, path->obj_inst_id);
+	}
+
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		len += snprintk(senml_json_buffer + len,
+				sizeof(senml_json_buffer) - len,
+				"\"n\":\"%u/%u\",\"%s\":",
+				path->res_id, path->res_inst_id, label);
+	} else {
+		len += snprintk(senml_json_buffer + len,
+				sizeof(senml_json_buffer) - len,
+				"\"n\":\"%u\",\"%s\":", path->res_id, label);
+	}
+
+	return len;
+}
+
+/* Write a whole record, its value being formatted with format */
+static size_t put_record(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path, const char *label,
+			 const char *format, ...)
+{
+	struct senml_json_out_formatter_data *fd;
+	va_list vargs;
+	int len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = put_record_prefix(fd, path, label);
+
+	va_start(vargs, format);
+	len += vsnprintk(senml_json_buffer + len,
+			 sizeof(senml_json_buffer) - len, format, vargs);
+	va_end(vargs);
+
+	if (len >= sizeof(senml_json_buffer) - 1) {
+		return 0;
+	}
+
+	senml_json_buffer[len++] = '}';
+
+	fd->writer_flags |= WRITER_OUTPUT_VALUE;
+	return senml_json_write(out, senml_json_buffer, len);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s32_t value)
+{
+	return put_record(out, path, "v", "%d", value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s16_t value)
+{
+	return put_s32(out, path, (s32_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, s8_t value)
+{
+	return put_s32(out, path, (s32_t)value);
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s64_t value)
+{
+	return put_record(out, path, "v", "%lld", value);
+}
+
+/* Format a fixed point value, val2 being its decimals times 10^digits,
+ * without the trailing zeros of the decimals.
+ */
+static void format_fixed(char *buf, size_t buflen, s64_t val1, s64_t val2,
+			 int digits)
+{
+	char decimals[FLOAT64_DIGITS + 1];
+	bool neg = val1 < 0 || val2 < 0;
+	int i;
+
+	val1 = val1 < 0 ? -val1 : val1;
+	val2 = val2 < 0 ? -val2 : val2;
+
+	for (i = digits - 1; i >= 0; i--) {
+		decimals[i] = '0' + val2 % 10;
+		val2 /= 10;
+	}
+
+	while (digits > 0 && decimals[digits - 1] == '0') {
+		digits--;
+	}
+
+	decimals[digits] = '\0';
+
+	snprintk(buf, buflen, "%s%lld%s%s", neg ? "-" : "", val1,
+		 digits ? "." : "", decimals);
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	char buf[24];
+
+	format_fixed(buf, sizeof(buf), value->val1, value->val2,
+		     FLOAT32_DIGITS);
+
+	return put_record(out, path, "v", "%s", buf);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	char buf[32];
+
+	format_fixed(buf, sizeof(buf), value->val1, value->val2,
+		     FLOAT64_DIGITS);
+
+	return put_record(out, path, "v", "%s", buf);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	return put_record(out, path, "vb", "%s", value ? "true" : "false");
+}
+
+/* Write the buffered part of a long record, keeping room for the next
+ * few characters.
+ */
+static int flush_record(struct lwm2m_output_context *out, int *len,
+			size_t *total)
+{
+	if (*len < sizeof(senml_json_buffer) - 8) {
+		return 0;
+	}
+
+	if (!senml_json_write(out, senml_json_buffer, *len)) {
+		return -ENOMEM;
+	}
+
+	*total += *len;
+	*len = 0;
+
+	return 0;
+}
+
+static size_t put_record_end(struct lwm2m_output_context *out,
+			     struct senml_json_out_formatter_data *fd,
+			     int len, size_t total)
+{
+	senml_json_buffer[len++] = '"';
+	senml_json_buffer[len++] = '}';
+
+	if (!senml_json_write(out, senml_json_buffer, len)) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_OUTPUT_VALUE;
+	return total + len;
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_json_out_formatter_data *fd;
+	size_t total = 0, i;
+	int len;
+	u8_t c;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = put_record_prefix(fd, path, "vs");
+	senml_json_buffer[len++] = '"';
+
+	for (i = 0; i < buflen; i++) {
+		if (flush_record(out, &len, &total) < 0) {
+			return 0;
+		}
+
+		c = buf[i];
+
+		if (c == '"' || c == '\\') {
+			senml_json_buffer[len++] = '\\';
+			senml_json_buffer[len++] = c;
+		} else if (c < 0x20) {
+			len += snprintk(senml_json_buffer + len,
+					sizeof(senml_json_buffer) - len,
+					"\\u%04x", c);
+		} else {
+			senml_json_buffer[len++] = c;
+		}
+	}
+
+	return put_record_end(out, fd, len, total);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_json_out_formatter_data *fd;
+	size_t total = 0, i;
+	int len, count;
+	u32_t bits;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = put_record_prefix(fd, path, "vd");
+	senml_json_buffer[len++] = '"';
+
+	/* base64url without padding, as required by SenML */
+	for (i = 0; i < buflen; i += 3) {
+		if (flush_record(out, &len, &total) < 0) {
+			return 0;
+		}
+
+		count = min(buflen - i, 3);
+
+		bits = (u8_t)buf[i] << 16;
+		if (count > 1) {
+			bits |= (u8_t)buf[i + 1] << 8;
+		}
+
+		if (count > 2) {
+			bits |= (u8_t)buf[i + 2];
+		}
+
+		senml_json_buffer[len++] = base64url[(bits >> 18) & 0x3f];
+		senml_json_buffer[len++] = base64url[(bits >> 12) & 0x3f];
+
+		if (count > 1) {
+			senml_json_buffer[len++] = base64url[(bits >> 6) & 0x3f];
+		}
+
+		if (count > 2) {
+			senml_json_buffer[len++] = base64url[bits & 0x3f];
+		}
+	}
+
+	return put_record_end(out, fd, len, total);
+}
+
+static void in_cursor_init(struct lwm2m_input_context *in,
+			   struct net_pkt_cursor *cursor)
+{
+	net_pkt_cursor_set(cursor, in->in_cpkt->pkt, in->frag, in->offset);
+}
+
+/* Update the read position of the input context, in the format of
+ * net_frag_read(): the fragment of the next byte, or NULL at the end.
+ */
+static void in_cursor_update(struct lwm2m_input_context *in,
+			     struct net_pkt_cursor *cursor)
+{
+	u16_t len;
+
+	net_pkt_cursor_span(cursor, &len);
+
+	in->frag = cursor->buf;
+	in->offset = cursor->pos;
+}
+
+static bool is_space(u8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void json_skip_space(struct net_pkt_cursor *cursor)
+{
+	u8_t c;
+
+	while (!net_pkt_cursor_peek(cursor, &c, 1) && is_space(c)) {
+		net_pkt_cursor_skip(cursor, 1);
+	}
+}
+
+/* Read the next character which is not white space */
+static int json_next_char(struct net_pkt_cursor *cursor, u8_t *c)
+{
+	do {
+		if (net_pkt_cursor_read_u8(cursor, c) < 0) {
+			return -ENODATA;
+		}
+	} while (is_space(*c));
+
+	return 0;
+}
+
+static void string_add(u8_t *buf, size_t buflen, size_t *len, u8_t c)
+{
+	if (buf && *len + 1 < buflen) {
+		buf[(*len)++] = c;
+	}
+}
+
+/* Add the UTF-8 encoding of a \u escape sequence */
+static int json_read_unicode(struct net_pkt_cursor *cursor,
+			     u8_t *buf, size_t buflen, size_t *len)
+{
+	u16_t code = 0;
+	u8_t c;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (net_pkt_cursor_read_u8(cursor, &c) < 0 || !isxdigit(c)) {
+			return -EINVAL;
+		}
+
+		code = code << 4 | (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+	}
+
+	if (code < 0x80) {
+		string_add(buf, buflen, len, code);
+	} else if (code < 0x800) {
+		string_add(buf, buflen, len, 0xc0 | code >> 6);
+		string_add(buf, buflen, len, 0x80 | (code & 0x3f));
+	} else {
+		string_add(buf, buflen, len, 0xe0 | code >> 12);
+		string_add(buf, buflen, len, 0x80 | ((code >> 6) & 0x3f));
+		string_add(buf, buflen, len, 0x80 | (code & 0x3f));
+	}
+
+	return 0;
+}
+
+/* Read a string after its opening quote, truncated to buflen - 1 bytes
+ * and NUL terminated. With a NULL buf, the string is only skipped.
+ */
+static int json_read_string(struct net_pkt_cursor *cursor,
+			    u8_t *buf, size_t buflen)
+{
+	size_t len = 0;
+	u8_t c;
+
+	while (1) {
+		if (net_pkt_cursor_read_u8(cursor, &c) < 0) {
+			return -EINVAL;
+		}
+
+		if (c == '"') {
+			break;
+		}
+
+		if (c != '\\') {
+			string_add(buf, buflen, &len, c);
+			continue;
+		}
+
+		if (net_pkt_cursor_read_u8(cursor, &c) < 0) {
+			return -EINVAL;
+		}
+
+		switch (c) {
+		case 'b':
+			c = '\b';
+			break;
+		case 'f':
+			c = '\f';
+			break;
+		case 'n':
+			c = '\n';
+			break;
+		case 'r':
+			c = '\r';
+			break;
+		case 't':
+			c = '\t';
+			break;
+		case 'u':
+			if (json_read_unicode(cursor, buf, buflen, &len) < 0) {
+				return -EINVAL;
+			}
+
+			continue;
+		default:
+			/* '"', '\\' and '/' */
+			break;
+		}
+
+		string_add(buf, buflen, &len, c);
+	}
+
+	if (buf && buflen) {
+		buf[len] = '\0';
+	}
+
+	return len;
+}
+
+static int json_read_quoted_string(struct net_pkt_cursor *cursor,
+				   u8_t *buf, size_t buflen)
+{
+	u8_t c;
+
+	if (json_next_char(cursor, &c) < 0 || c != '"') {
+		return -EINVAL;
+	}
+
+	return json_read_string(cursor, buf, buflen);
+}
+
+/* Skip a string, number or literal. SenML has no nested value. */
+static int json_skip_value(struct net_pkt_cursor *cursor)
+{
+	u8_t c;
+
+	if (net_pkt_cursor_peek(cursor, &c, 1) < 0) {
+		return -EINVAL;
+	}
+
+	if (c == '"') {
+		return json_read_quoted_string(cursor, NULL, 0);
+	}
+
+	if (c == '{' || c == '[') {
+		return -EINVAL;
+	}
+
+	while (!net_pkt_cursor_peek(cursor, &c, 1) &&
+	       c != ',' && c != '}' && c != ']' && !is_space(c)) {
+		net_pkt_cursor_skip(cursor, 1);
+	}
+
+	return 0;
+}
+
+/* Read a number as its integer part and its decimals times 10^digits */
+static size_t json_read_number(struct net_pkt_cursor *cursor,
+			       s64_t *val1, s64_t *val2, int digits)
+{
+	s64_t int_part = 0, decimals = 0;
+	bool neg = false, dot = false;
+	int decimal_digits = 0;
+	size_t count = 0;
+	u8_t c;
+
+	while (!net_pkt_cursor_peek(cursor, &c, 1)) {
+		if (c == '-' && !count) {
+			neg = true;
+		} else if (c == '.' && count && !dot) {
+			dot = true;
+		} else if (isdigit(c) && !dot) {
+			int_part = int_part * 10 + (c - '0');
+		} else if (isdigit(c)) {
+			if (decimal_digits < digits) {
+				decimals = decimals * 10 + (c - '0');
+				decimal_digits++;
+			}
+		} else {
+			break;
+		}
+
+		net_pkt_cursor_skip(cursor, 1);
+		count++;
+	}
+
+	while (decimal_digits++ < digits) {
+		decimals *= 10;
+	}
+
+	*val1 = neg ? -int_part : int_part;
+	if (val2) {
+		*val2 = neg ? -decimals : decimals;
+	}
+
+	return count;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, s64_t *value)
+{
+	struct net_pkt_cursor cursor;
+	size_t len;
+
+	in_cursor_init(in, &cursor);
+	len = json_read_number(&cursor, value, NULL, 0);
+	in_cursor_update(in, &cursor);
+
+	return len;
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, s32_t *value)
+{
+	s64_t tmp = 0;
+	size_t len;
+
+	len = get_s64(in, &tmp);
+	if (len > 0) {
+		*value = (s32_t)tmp;
+	}
+
+	return len;
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen)
+{
+	struct net_pkt_cursor cursor;
+	int len;
+
+	in_cursor_init(in, &cursor);
+	len = json_read_quoted_string(&cursor, buf, buflen);
+	in_cursor_update(in, &cursor);
+
+	if (len < 0) {
+		buf[0] = '\0';
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	struct net_pkt_cursor cursor;
+	s64_t tmp1, tmp2;
+	size_t len;
+
+	in_cursor_init(in, &cursor);
+	len = json_read_number(&cursor, &tmp1, &tmp2, FLOAT32_DIGITS);
+	in_cursor_update(in, &cursor);
+
+	if (len > 0) {
+		value->val1 = (s32_t)tmp1;
+		value->val2 = (s32_t)tmp2;
+	}
+
+	return len;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	struct net_pkt_cursor cursor;
+	size_t len;
+
+	in_cursor_init(in, &cursor);
+	len = json_read_number(&cursor, &value->val1, &value->val2,
+			       FLOAT64_DIGITS);
+	in_cursor_update(in, &cursor);
+
+	return len;
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	struct net_pkt_cursor cursor;
+	u8_t buf[5];
+	size_t len;
+
+	in_cursor_init(in, &cursor);
+
+	if (!net_pkt_cursor_peek(&cursor, buf, 4) &&
+	    !memcmp(buf, "true", 4)) {
+		*value = true;
+		len = 4;
+	} else if (!net_pkt_cursor_peek(&cursor, buf, 5) &&
+		   !memcmp(buf, "false", 5)) {
+		*value = false;
+		len = 5;
+	} else {
+		return 0;
+	}
+
+	net_pkt_cursor_skip(&cursor, len);
+	in_cursor_update(in, &cursor);
+
+	return len;
+}
+
+static int base64url_value(u8_t c)
+{
+	if (c >= 'A' && c <= 'Z') {
+		return c - 'A';
+	} else if (c >= 'a' && c <= 'z') {
+		return c - 'a' + 26;
+	} else if (c >= '0' && c <= '9') {
+		return c - '0' + 52;
+	} else if (c == '-' || c == '+') {
+		return 62;
+	} else if (c == '_' || c == '/') {
+		return 63;
+	}
+
+	return -EINVAL;
+}
+
+/* The whole value is decoded at once, as the engine reads the following
+ * blocks of an opaque value raw with lwm2m_engine_get_opaque_more().
+ */
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen, bool *last_block)
+{
+	struct net_pkt_cursor cursor;
+	u32_t bits = 0;
+	size_t len = 0;
+	int count = 0;
+	int value;
+	u8_t c;
+
+	*last_block = true;
+	in->opaque_len = 0;
+
+	in_cursor_init(in, &cursor);
+
+	if (json_next_char(&cursor, &c) < 0 || c != '"') {
+		return 0;
+	}
+
+	while (1) {
+		if (net_pkt_cursor_read_u8(&cursor, &c) < 0) {
+			return 0;
+		}
+
+		if (c == '"') {
+			break;
+		}
+
+		/* tolerate the padding of base64 */
+		if (c == '=') {
+			continue;
+		}
+
+		value = base64url_value(c);
+		if (value < 0) {
+			return 0;
+		}
+
+		bits = bits << 6 | value;
+		count += 6;
+
+		if (count >= 8) {
+			count -= 8;
+
+			if (len < buflen) {
+				buf[len++] = bits >> count;
+			}
+		}
+	}
+
+	in_cursor_update(in, &cursor);
+
+	return len;
+}
+
+const struct lwm2m_writer senml_json_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+};
+
+const struct lwm2m_reader senml_json_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+};
+
+int do_read_op_senml_json(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  int content_format)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.base_obj_inst_id = -1;
+
+	engine_set_out_user_data(context->out, &fd);
+	ret = lwm2m_perform_read_op(obj, context, content_format);
+	engine_clear_out_user_data(context->out);
+
+	return ret;
+}
+
+/* Parse the labels of a record, up to its closing brace. The base name
+ * is kept for the following records.
+ */
+static int parse_record(struct net_pkt_cursor *cursor, char *base_name,
+			char *name, struct net_pkt_cursor *value,
+			bool *has_value)
+{
+	char label[SENML_LABEL_LEN];
+	int ret;
+	u8_t c;
+
+	name[0] = '\0';
+	*has_value = false;
+
+	do {
+		if (json_read_quoted_string(cursor, label, sizeof(label)) < 0 ||
+		    json_next_char(cursor, &c) < 0 || c != ':') {
+			return -EINVAL;
+		}
+
+		json_skip_space(cursor);
+
+		if (!strcmp(label, "bn")) {
+			ret = json_read_quoted_string(cursor, base_name,
+						      SENML_NAME_LEN);
+		} else if (!strcmp(label, "n")) {
+			ret = json_read_quoted_string(cursor, name,
+						      SENML_NAME_LEN);
+		} else {
+			if (!strcmp(label, "v") || !strcmp(label, "vs") ||
+			    !strcmp(label, "vb") || !strcmp(label, "vd")) {
+				*value = *cursor;
+				*has_value = true;
+			}
+
+			ret = json_skip_value(cursor);
+		}
+
+		if (ret < 0 || json_next_char(cursor, &c) < 0) {
+			return -EINVAL;
+		}
+	} while (c == ',');
+
+	return c == '}' ? 0 : -EINVAL;
+}
+
+int do_write_op_senml_json(struct lwm2m_engine_obj *obj,
+			   struct lwm2m_engine_context *context)
+{
+	struct lwm2m_input_context *in = context->in;
+	struct net_pkt_cursor cursor, value;
+	char base_name[SENML_NAME_LEN] = "";
+	char name[SENML_NAME_LEN];
+	char path[SENML_NAME_LEN * 2];
+	bool has_value;
+	int ret;
+	u8_t c;
+
+	in_cursor_init(in, &cursor);
+
+	if (json_next_char(&cursor, &c) < 0 || c != '[' ||
+	    json_next_char(&cursor, &c) < 0) {
+		return -EINVAL;
+	}
+
+	while (c == '{') {
+		ret = parse_record(&cursor, base_name, name, &value,
+				   &has_value);
+		if (ret < 0) {
+			LOG_ERR("Invalid SenML record");
+			return ret;
+		}
+
+		if (has_value) {
+			snprintk(path, sizeof(path), "%s%s", base_name, name);
+
+			in_cursor_update(in, &value);
+			ret = lwm2m_write_record(obj, context, path);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+
+		if (json_next_char(&cursor, &c) < 0) {
+			return -EINVAL;
+		}
+
+		if (c == ',' && json_next_char(&cursor, &c) < 0) {
+			return -EINVAL;
+		}
+	}
+
+	return c == ']' ? 0 : -EINVAL;
+}
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int do_composite_read_op_senml_json(struct lwm2m_engine_context *context,
+				    struct lwm2m_obj_path *paths,
+				    int path_count, int content_format)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.base_obj_inst_id = -1;
+
+	engine_set_out_user_data(context->out, &fd);
+	ret = lwm2m_perform_composite_read_op(context, paths, path_count,
+					      content_format);
+	engine_clear_out_user_data(context->out);
+
+	return ret;
+}
+
+/* The paths of a composite operation are the names of its records, the
+ * values being ignored. Returns the number of paths.
+ */
+int do_composite_paths_senml_json(struct lwm2m_input_context *in,
+				  struct lwm2m_obj_path *paths, int max_paths)
+{
+	struct net_pkt_cursor cursor, value;
+	char base_name[SENML_NAME_LEN] = "";
+	char name[SENML_NAME_LEN];
+	char path[SENML_NAME_LEN * 2];
+	bool has_value;
+	int count = 0;
+	int ret;
+	u8_t c;
+
+	in_cursor_init(in, &cursor);
+
+	if (json_next_char(&cursor, &c) < 0 || c != '[' ||
+	    json_next_char(&cursor, &c) < 0) {
+		return -EINVAL;
+	}
+
+	while (c == '{') {
+		ret = parse_record(&cursor, base_name, name, &value,
+				   &has_value);
+		if (ret < 0) {
+			LOG_ERR("Invalid SenML record");
+			return ret;
+		}
+
+		if (count == max_paths) {
+			return -EFBIG;
+		}
+
+		snprintk(path, sizeof(path), "%s%s", base_name, name);
+
+		ret = lwm2m_string_to_path(path, &paths[count++]);
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (json_next_char(&cursor, &c) < 0) {
+			return -EINVAL;
+		}
+
+		if (c == ',' && json_next_char(&cursor, &c) < 0) {
+			return -EINVAL;
+		}
+	}
+
+	return c == ']' ? count : -EINVAL;
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
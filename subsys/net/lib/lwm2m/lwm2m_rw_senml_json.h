@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWM2M_RW_SENML_JSON_H_
+#define LWM2M_RW_SENML_JSON_H_
+
+#include "lwm2m_object.h"
+
+extern const struct lwm2m_writer senml_json_writer;
+extern const struct lwm2m_reader senml_json_reader;
+
+int do_read_op_senml_json(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  int content_format);
+int do_write_op_senml_json(struct lwm2m_engine_obj *obj,
+			   struct lwm2m_engine_context *context);
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int do_composite_read_op_senml_json(struct lwm2m_engine_context *context,
+				    struct lwm2m_obj_path *paths,
+				    int path_count, int content_format);
+int do_composite_paths_senml_json(struct lwm2m_input_context *in,
+				  struct lwm2m_obj_path *paths, int max_paths);
+#endif
+
+#endif /* LWM2M_RW_SENML_JSON_H_ */
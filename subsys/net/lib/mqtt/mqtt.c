@@ -14,7 +14,9 @@
 #include <net/net_pkt.h>
 #include <net/net_app.h>
 #include <net/buf.h>
+#include <misc/byteorder.h>
 #include <errno.h>
+#include <string.h>
 
 #define MSG_SIZE        CONFIG_MQTT_MSG_MAX_SIZE
 #define MQTT_BUF_CTR    (1 + CONFIG_MQTT_ADDITIONAL_BUFFER_CTR)
@@ -25,12 +27,161 @@
  */
 NET_BUF_POOL_DEFINE(mqtt_msg_pool, MQTT_BUF_CTR, MSG_SIZE, 0, NULL);
 
-#define MQTT_PUBLISHER_MIN_MSG_SIZE     2
+/* Packet type and flags, then 1 to 4 bytes of Remaining Length */
+#define MQTT_FIXED_HDR_MAX_SIZE		5
+
+#define MQTT_PUBLISH_QOS(first_byte)	(((first_byte) & 0x06) >> 1)
+
+/* See MQTT 1.5.2 and 2.3.1 */
+#define MQTT_TOPIC_LEN_SIZE		2
+#define MQTT_PKT_ID_SIZE		2
 
 #if defined(CONFIG_MQTT_LIB_TLS)
 #define TLS_HS_DEFAULT_TIMEOUT 3000
 #endif
 
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+static void inflight_reset(struct mqtt_ctx *ctx)
+{
+	memset(ctx->inflight, 0, sizeof(ctx->inflight));
+
+	k_sem_init(&ctx->inflight_free, CONFIG_MQTT_INFLIGHT_WINDOW,
+		   CONFIG_MQTT_INFLIGHT_WINDOW);
+	k_mutex_init(&ctx->inflight_lock);
+}
+
+/* A pkt_id of 0 returns a free slot */
+static struct mqtt_inflight *inflight_find(struct mqtt_ctx *ctx, u16_t pkt_id)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_MQTT_INFLIGHT_WINDOW; i++) {
+		if (ctx->inflight[i].pkt_id == pkt_id) {
+			return &ctx->inflight[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Takes a slot of the window for a QoS 1 or QoS 2 PUBLISH msg
+ *
+ * @param [in] ctx MQTT context
+ * @param [in] msg MQTT PUBLISH msg about to be sent
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the Packet Identifier is 0 or already in flight
+ * @retval -EAGAIN if no slot was freed within the network timeout
+ */
+static int inflight_add(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg)
+{
+	struct mqtt_inflight *slot;
+
+	if (msg->pkt_id == 0) {
+		return -EINVAL;
+	}
+
+	if (k_sem_take(&ctx->inflight_free, ctx->net_timeout) != 0) {
+		return -EAGAIN;
+	}
+
+	k_mutex_lock(&ctx->inflight_lock, K_FOREVER);
+
+	if (inflight_find(ctx, msg->pkt_id)) {
+		k_mutex_unlock(&ctx->inflight_lock);
+		k_sem_give(&ctx->inflight_free);
+		return -EINVAL;
+	}
+
+	/* There is a free slot as the semaphore was taken */
+	slot = inflight_find(ctx, 0);
+	slot->pkt_id = msg->pkt_id;
+	slot->qos = msg->qos;
+	slot->state = MQTT_PUBLISH;
+
+	k_mutex_unlock(&ctx->inflight_lock);
+
+	return 0;
+}
+
+static void inflight_remove(struct mqtt_ctx *ctx, u16_t pkt_id)
+{
+	struct mqtt_inflight *slot;
+
+	k_mutex_lock(&ctx->inflight_lock, K_FOREVER);
+
+	slot = pkt_id ? inflight_find(ctx, pkt_id) : NULL;
+	if (slot) {
+		slot->pkt_id = 0;
+		k_sem_give(&ctx->inflight_free);
+	}
+
+	k_mutex_unlock(&ctx->inflight_lock);
+}
+
+/**
+ * Moves the msg matching a PUBACK, PUBREC or PUBCOMP msg to its next state
+ *
+ * @details The slot of a msg whose QoS handshake is complete is freed.
+ *
+ * @param [in] ctx MQTT context
+ * @param [in] pkt_id Packet Identifier of the acknowledgment
+ * @param [in] type Packet type of the acknowledgment
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if no msg in flight expects this acknowledgment
+ */
+static int inflight_ack(struct mqtt_ctx *ctx, u16_t pkt_id,
+			enum mqtt_packet type)
+{
+	struct mqtt_inflight *slot;
+	bool done = false;
+	int rc = -EINVAL;
+
+	k_mutex_lock(&ctx->inflight_lock, K_FOREVER);
+
+	slot = pkt_id ? inflight_find(ctx, pkt_id) : NULL;
+	if (!slot) {
+		goto exit_ack;
+	}
+
+	switch (type) {
+	case MQTT_PUBACK:
+		if (slot->qos == MQTT_QoS1) {
+			done = true;
+			rc = 0;
+		}
+		break;
+	case MQTT_PUBREC:
+		/* A PUBREC msg may be retransmitted after the PUBREL msg */
+		if (slot->qos == MQTT_QoS2) {
+			slot->state = MQTT_PUBREL;
+			rc = 0;
+		}
+		break;
+	case MQTT_PUBCOMP:
+		if (slot->state == MQTT_PUBREL) {
+			done = true;
+			rc = 0;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (done) {
+		slot->pkt_id = 0;
+		k_sem_give(&ctx->inflight_free);
+	}
+
+exit_ack:
+	k_mutex_unlock(&ctx->inflight_lock);
+
+	return rc;
+}
+#endif
+
 int mqtt_tx_connect(struct mqtt_ctx *ctx, struct mqtt_connect_msg *msg)
 {
 	struct net_buf *data = NULL;
@@ -218,9 +369,19 @@ int mqtt_tx_publish(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg)
 	struct net_pkt *tx = NULL;
 	int rc;
 
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+	if (msg->qos != MQTT_QoS0) {
+		rc = inflight_add(ctx, msg);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+#endif
+
 	data = net_buf_alloc(&mqtt_msg_pool, ctx->net_timeout);
 	if (data == NULL) {
-		return -ENOMEM;
+		rc = -ENOMEM;
+		goto exit_publish;
 	}
 
 	rc = mqtt_pack_publish(data->data, &data->len, data->size, msg);
@@ -243,6 +404,7 @@ int mqtt_tx_publish(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg)
 			      tx, NULL, 0, ctx->net_timeout, NULL);
 	if (rc < 0) {
 		net_pkt_unref(tx);
+		goto exit_publish;
 	}
 
 	tx = NULL;
@@ -250,7 +412,15 @@ int mqtt_tx_publish(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg)
 	return rc;
 
 exit_publish:
-	net_pkt_frag_unref(data);
+	if (data) {
+		net_pkt_frag_unref(data);
+	}
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+	if (msg->qos != MQTT_QoS0) {
+		inflight_remove(ctx, msg->pkt_id);
+	}
+#endif
 
 	return rc;
 }
@@ -385,17 +555,13 @@ exit_unsub:
 	return rc;
 }
 
-int mqtt_rx_connack(struct mqtt_ctx *ctx, struct net_buf *rx, int clean_session)
+static int rx_connack(struct mqtt_ctx *ctx, u8_t *data, u16_t len,
+		      int clean_session)
 {
-	u16_t len;
 	u8_t connect_rc;
 	u8_t session;
-	u8_t *data;
 	int rc;
 
-	data = rx->data;
-	len = rx->len;
-
 	/* CONNACK is 4 bytes len */
 	rc = mqtt_unpack_connack(data, len, &session, &connect_rc);
 	if (rc != 0) {
@@ -435,8 +601,13 @@ exit_connect:
 	return rc;
 }
 
+int mqtt_rx_connack(struct mqtt_ctx *ctx, struct net_buf *rx, int clean_session)
+{
+	return rx_connack(ctx, rx->data, rx->len, clean_session);
+}
+
 /**
- * Parses and validates the MQTT PUBxxxx message contained in the rx packet.
+ * Parses and validates the MQTT PUBxxxx message contained in data.
  *
  *
  * @details It validates against message structure and Packet Identifier.
@@ -444,21 +615,20 @@ exit_connect:
  * corresponding MQTT PUB msg.
  *
  * @param ctx MQTT context
- * @param rx RX packet
+ * @param data MQTT message
+ * @param len Length of the MQTT message
  * @param type MQTT Packet type
  *
  * @retval 0 on success
  * @retval -EINVAL on error
  */
 static
-int mqtt_rx_pub_msgs(struct mqtt_ctx *ctx, struct net_buf *rx,
+int mqtt_rx_pub_msgs(struct mqtt_ctx *ctx, u8_t *data, u16_t len,
 		     enum mqtt_packet type)
 {
 	int (*unpack)(u8_t *, u16_t, u16_t *) = NULL;
 	int (*response)(struct mqtt_ctx *, u16_t) = NULL;
 	u16_t pkt_id;
-	u16_t len;
-	u8_t *data;
 	int rc;
 
 	switch (type) {
@@ -480,9 +650,6 @@ int mqtt_rx_pub_msgs(struct mqtt_ctx *ctx, struct net_buf *rx,
 		return -EINVAL;
 	}
 
-	data = rx->data;
-	len = rx->len;
-
 	/* 4 bytes message */
 	rc = unpack(data, len, &pkt_id);
 	if (rc != 0) {
@@ -499,7 +666,21 @@ int mqtt_rx_pub_msgs(struct mqtt_ctx *ctx, struct net_buf *rx,
 			rc = -EINVAL;
 		}
 	} else {
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+		rc = inflight_ack(ctx, pkt_id, type);
+		if (rc != 0) {
+			return -EINVAL;
+		}
+#endif
+
 		rc = ctx->publish_tx(ctx, pkt_id, type);
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+		/* The QoS handshake stops here, as for the application */
+		if (rc != 0) {
+			inflight_remove(ctx, pkt_id);
+		}
+#endif
 	}
 
 	if (rc != 0) {
@@ -520,32 +701,32 @@ int mqtt_rx_pub_msgs(struct mqtt_ctx *ctx, struct net_buf *rx,
 
 int mqtt_rx_puback(struct mqtt_ctx *ctx, struct net_buf *rx)
 {
-	return mqtt_rx_pub_msgs(ctx, rx, MQTT_PUBACK);
+	return mqtt_rx_pub_msgs(ctx, rx->data, rx->len, MQTT_PUBACK);
 }
 
 int mqtt_rx_pubcomp(struct mqtt_ctx *ctx, struct net_buf *rx)
 {
-	return mqtt_rx_pub_msgs(ctx, rx, MQTT_PUBCOMP);
+	return mqtt_rx_pub_msgs(ctx, rx->data, rx->len, MQTT_PUBCOMP);
 }
 
 int mqtt_rx_pubrec(struct mqtt_ctx *ctx, struct net_buf *rx)
 {
-	return mqtt_rx_pub_msgs(ctx, rx, MQTT_PUBREC);
+	return mqtt_rx_pub_msgs(ctx, rx->data, rx->len, MQTT_PUBREC);
 }
 
 int mqtt_rx_pubrel(struct mqtt_ctx *ctx, struct net_buf *rx)
 {
-	return mqtt_rx_pub_msgs(ctx, rx, MQTT_PUBREL);
+	return mqtt_rx_pub_msgs(ctx, rx->data, rx->len, MQTT_PUBREL);
 }
 
-int mqtt_rx_pingresp(struct mqtt_ctx *ctx, struct net_buf *rx)
+static int rx_pingresp(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
 {
 	int rc;
 
 	ARG_UNUSED(ctx);
 
 	/* 2 bytes message */
-	rc = mqtt_unpack_pingresp(rx->data, rx->len);
+	rc = mqtt_unpack_pingresp(data, len);
 
 	if (rc != 0) {
 		return -EINVAL;
@@ -554,18 +735,18 @@ int mqtt_rx_pingresp(struct mqtt_ctx *ctx, struct net_buf *rx)
 	return 0;
 }
 
-int mqtt_rx_suback(struct mqtt_ctx *ctx, struct net_buf *rx)
+int mqtt_rx_pingresp(struct mqtt_ctx *ctx, struct net_buf *rx)
+{
+	return rx_pingresp(ctx, rx->data, rx->len);
+}
+
+static int rx_suback(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
 {
 	enum mqtt_qos suback_qos[CONFIG_MQTT_SUBSCRIBE_MAX_TOPICS];
 	u16_t pkt_id;
-	u16_t len;
 	u8_t items;
-	u8_t *data;
 	int rc;
 
-	data = rx->data;
-	len = rx->len;
-
 	rc = mqtt_unpack_suback(data, len, &pkt_id, &items,
 				CONFIG_MQTT_SUBSCRIBE_MAX_TOPICS, suback_qos);
 	if (rc != 0) {
@@ -584,16 +765,16 @@ int mqtt_rx_suback(struct mqtt_ctx *ctx, struct net_buf *rx)
 	return 0;
 }
 
-int mqtt_rx_unsuback(struct mqtt_ctx *ctx, struct net_buf *rx)
+int mqtt_rx_suback(struct mqtt_ctx *ctx, struct net_buf *rx)
+{
+	return rx_suback(ctx, rx->data, rx->len);
+}
+
+static int rx_unsuback(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
 {
 	u16_t pkt_id;
-	u16_t len;
-	u8_t *data;
 	int rc;
 
-	data = rx->data;
-	len = rx->len;
-
 	/* 4 bytes message */
 	rc = mqtt_unpack_unsuback(data, len, &pkt_id);
 	if (rc != 0) {
@@ -612,27 +793,27 @@ int mqtt_rx_unsuback(struct mqtt_ctx *ctx, struct net_buf *rx)
 	return 0;
 }
 
-int mqtt_rx_publish(struct mqtt_ctx *ctx, struct net_buf *rx)
+int mqtt_rx_unsuback(struct mqtt_ctx *ctx, struct net_buf *rx)
 {
-	struct mqtt_publish_msg msg;
-	int rc;
+	return rx_unsuback(ctx, rx->data, rx->len);
+}
 
-	rc = mqtt_unpack_publish(rx->data, rx->len, &msg);
-	if (rc != 0) {
-		return -EINVAL;
-	}
+/* Hands a PUBLISH msg to the application, then acknowledges it */
+static int rx_publish_done(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg)
+{
+	int rc;
 
-	rc = ctx->publish_rx(ctx, &msg, msg.pkt_id, MQTT_PUBLISH);
+	rc = ctx->publish_rx(ctx, msg, msg->pkt_id, MQTT_PUBLISH);
 	if (rc != 0) {
 		return -EINVAL;
 	}
 
-	switch (msg.qos) {
+	switch (msg->qos) {
 	case MQTT_QoS2:
-		rc = mqtt_tx_pubrec(ctx, msg.pkt_id);
+		rc = mqtt_tx_pubrec(ctx, msg->pkt_id);
 		break;
 	case MQTT_QoS1:
-		rc = mqtt_tx_puback(ctx, msg.pkt_id);
+		rc = mqtt_tx_puback(ctx, msg->pkt_id);
 		break;
 	case MQTT_QoS0:
 		break;
@@ -643,128 +824,349 @@ int mqtt_rx_publish(struct mqtt_ctx *ctx, struct net_buf *rx)
 	return rc;
 }
 
-/**
- * Linearizes an IP fragmented packet
- *
- * @param [in] ctx MQTT context structure
- * @param [in] rx RX IP stack packet
- * @param [in] min_size Min message size allowed. This allows us to exit if the
- * rx packet is shorter than the expected msg size
- *
- * @retval Data buffer
- * @retval NULL on error
- */
-static
-struct net_buf *mqtt_linearize_packet(struct mqtt_ctx *ctx, struct net_pkt *rx,
-				      u16_t min_size)
+static int rx_publish(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
 {
-	struct net_buf *data = NULL;
-	u16_t data_len;
-	u16_t offset;
+	struct mqtt_publish_msg msg;
 	int rc;
 
-	/* CONFIG_MQTT_MSG_MAX_SIZE is defined via Kconfig. So here it's
-	 * determined if the input packet could fit our data buffer or if
-	 * it has the expected size.
-	 */
-	data_len = net_pkt_appdatalen(rx);
-	if (data_len < min_size || data_len > CONFIG_MQTT_MSG_MAX_SIZE) {
-		return NULL;
-	}
-
-	data = net_buf_alloc(&mqtt_msg_pool, ctx->net_timeout);
-	if (data == NULL) {
-		return NULL;
-	}
-
-	offset = net_pkt_get_len(rx) - data_len;
-	rc = net_frag_linear_copy(data, rx->frags, offset, data_len);
+	rc = mqtt_unpack_publish(data, len, &msg);
 	if (rc != 0) {
-		goto exit_error;
+		return -EINVAL;
 	}
 
-	return data;
-
-exit_error:
-	net_pkt_frag_unref(data);
+	return rx_publish_done(ctx, &msg);
+}
 
-	return NULL;
+int mqtt_rx_publish(struct mqtt_ctx *ctx, struct net_buf *rx)
+{
+	return rx_publish(ctx, rx->data, rx->len);
 }
 
 /**
- * Calls the appropriate rx routine for the MQTT message contained in rx
- *
- * @details On error, this routine will execute the 'ctx->malformed' callback
- * (if defined)
+ * Calls the appropriate rx routine for the MQTT message contained in data
  *
  * @param ctx MQTT context
- * @param rx RX packet
+ * @param data MQTT message
+ * @param len Length of the MQTT message
  *
  * @retval 0 on success
  * @retval -EINVAL if an unknown message is received
- * @retval -ENOMEM if no data buffer is available
  * @retval mqtt_rx_connack, mqtt_rx_pingresp, mqtt_rx_puback, mqtt_rx_pubcomp,
  *         mqtt_rx_publish, mqtt_rx_pubrec, mqtt_rx_pubrel and mqtt_rx_suback
  *         return codes
  */
-static
-int mqtt_parser(struct mqtt_ctx *ctx, struct net_pkt *rx)
+static int rx_dispatch(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
 {
-	u16_t pkt_type = MQTT_INVALID;
-	struct net_buf *data = NULL;
-	int rc = -EINVAL;
-
-	data = mqtt_linearize_packet(ctx, rx, MQTT_PUBLISHER_MIN_MSG_SIZE);
-	if (!data) {
-		return -ENOMEM;
-	}
-
-	pkt_type = MQTT_PACKET_TYPE(data->data[0]);
+	int rc;
 
-	switch (pkt_type) {
+	switch (MQTT_PACKET_TYPE(data[0])) {
 	case MQTT_CONNACK:
 		if (!ctx->connected) {
-			rc = mqtt_rx_connack(ctx, data, ctx->clean_session);
+			rc = rx_connack(ctx, data, len, ctx->clean_session);
 		} else {
 			rc = -EINVAL;
 		}
 		break;
 	case MQTT_PUBACK:
-		rc = mqtt_rx_puback(ctx, data);
+		rc = mqtt_rx_pub_msgs(ctx, data, len, MQTT_PUBACK);
 		break;
 	case MQTT_PUBREC:
-		rc = mqtt_rx_pubrec(ctx, data);
+		rc = mqtt_rx_pub_msgs(ctx, data, len, MQTT_PUBREC);
 		break;
 	case MQTT_PUBCOMP:
-		rc = mqtt_rx_pubcomp(ctx, data);
+		rc = mqtt_rx_pub_msgs(ctx, data, len, MQTT_PUBCOMP);
 		break;
 	case MQTT_PINGRESP:
-		rc = mqtt_rx_pingresp(ctx, data);
+		rc = rx_pingresp(ctx, data, len);
 		break;
 	case MQTT_PUBLISH:
-		rc = mqtt_rx_publish(ctx, data);
+		rc = rx_publish(ctx, data, len);
 		break;
 	case MQTT_PUBREL:
-		rc = mqtt_rx_pubrel(ctx, data);
+		rc = mqtt_rx_pub_msgs(ctx, data, len, MQTT_PUBREL);
 		break;
 	case MQTT_SUBACK:
-		rc = mqtt_rx_suback(ctx, data);
+		rc = rx_suback(ctx, data, len);
 		break;
 	case MQTT_UNSUBACK:
-		rc = mqtt_rx_unsuback(ctx, data);
+		rc = rx_unsuback(ctx, data, len);
 		break;
 	default:
 		rc = -EINVAL;
 		break;
 	}
 
-	if (rc != 0 && ctx->malformed) {
-		ctx->malformed(ctx, pkt_type);
+	return rc;
+}
+
+static void rx_reset(struct mqtt_rx *rx)
+{
+	rx->rlen = 0;
+	rx->offset = 0;
+	rx->len = 0;
+	rx->hdr_len = 0;
+	rx->payload = 0;
+	rx->discard = 0;
+}
+
+static void rx_malformed(struct mqtt_ctx *ctx)
+{
+	if (ctx->malformed) {
+		ctx->malformed(ctx, ctx->rx.len ?
+			       MQTT_PACKET_TYPE(ctx->rx.buf[0]) : MQTT_INVALID);
 	}
+}
 
-	net_pkt_frag_unref(data);
+/* The payload of a PUBLISH msg is streamed if the application can take it */
+static inline bool rx_is_streamed(struct mqtt_ctx *ctx)
+{
+	return MQTT_PACKET_TYPE(ctx->rx.buf[0]) == MQTT_PUBLISH &&
+	       ctx->publish_rx_data;
+}
 
-	return rc;
+/**
+ * Stores a byte of the fixed header
+ *
+ * @retval 1 once the fixed header is complete
+ * @retval 0 if more bytes are needed
+ * @retval -EINVAL if the Remaining Length is too long
+ */
+static int rx_fixed_hdr(struct mqtt_rx *rx, u8_t byte)
+{
+	rx->buf[rx->len++] = byte;
+
+	if (rx->len == 1) {
+		return 0;
+	}
+
+	rx->rlen |= (u32_t)(byte & 0x7F) << (7 * (rx->len - 2));
+
+	if (byte & 0x80) {
+		/* MQTT 2.2.3: the Remaining Length takes 4 bytes at most */
+		if (rx->len == MQTT_FIXED_HDR_MAX_SIZE) {
+			return -EINVAL;
+		}
+
+		return 0;
+	}
+
+	rx->hdr_len = rx->len;
+
+	return 1;
+}
+
+/**
+ * Returns the number of bytes after the fixed header that must be stored
+ * before the message can be processed: the whole message, or the variable
+ * header of a PUBLISH msg whose payload is streamed.
+ */
+static u32_t rx_needed(struct mqtt_ctx *ctx)
+{
+	struct mqtt_rx *rx = &ctx->rx;
+	u32_t needed;
+
+	if (!rx_is_streamed(ctx)) {
+		return rx->rlen;
+	}
+
+	/* Topic length first */
+	if (rx->offset < MQTT_TOPIC_LEN_SIZE) {
+		return MQTT_TOPIC_LEN_SIZE;
+	}
+
+	needed = MQTT_TOPIC_LEN_SIZE + sys_get_be16(rx->buf + rx->hdr_len);
+	if (MQTT_PUBLISH_QOS(rx->buf[0]) != MQTT_QoS0) {
+		needed += MQTT_PKT_ID_SIZE;
+	}
+
+	return needed;
+}
+
+/* Decodes the variable header of a PUBLISH msg whose payload is streamed */
+static int rx_publish_start(struct mqtt_ctx *ctx)
+{
+	struct mqtt_rx *rx = &ctx->rx;
+	struct mqtt_publish_msg *msg = &rx->msg;
+	u8_t *data = rx->buf + rx->hdr_len;
+
+	msg->dup = (rx->buf[0] & 0x08) >> 3;
+	msg->qos = MQTT_PUBLISH_QOS(rx->buf[0]);
+	msg->retain = rx->buf[0] & 0x01;
+
+	if (msg->qos > MQTT_QoS2) {
+		return -EINVAL;
+	}
+
+	msg->topic_len = sys_get_be16(data);
+	msg->topic = (char *)data + MQTT_TOPIC_LEN_SIZE;
+	data += MQTT_TOPIC_LEN_SIZE + msg->topic_len;
+
+	if (msg->qos != MQTT_QoS0) {
+		msg->pkt_id = sys_get_be16(data);
+	} else {
+		msg->pkt_id = 0;
+	}
+
+	rx->payload = 1;
+
+	return 0;
+}
+
+static int rx_publish_data(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
+{
+	struct mqtt_rx *rx = &ctx->rx;
+	u32_t var_hdr_len = rx->len - rx->hdr_len;
+
+	rx->msg.msg = data;
+	rx->msg.msg_len = len;
+
+	return ctx->publish_rx_data(ctx, &rx->msg, rx->offset - var_hdr_len,
+				    rx->rlen - var_hdr_len);
+}
+
+/* Processes a message whose last byte was received */
+static void rx_complete(struct mqtt_ctx *ctx)
+{
+	struct mqtt_rx *rx = &ctx->rx;
+	int rc;
+
+	if (rx->discard) {
+		return;
+	}
+
+	if (rx->payload) {
+		rx->msg.msg = NULL;
+		rx->msg.msg_len = 0;
+		rc = rx_publish_done(ctx, &rx->msg);
+	} else {
+		rc = rx_dispatch(ctx, rx->buf, rx->len);
+	}
+
+	if (rc != 0) {
+		rx_malformed(ctx);
+	}
+}
+
+/**
+ * Parses a part of the incoming message stream
+ *
+ * @details Messages may be split at any byte and several messages may be
+ * received at once. Everything but the payload of streamed PUBLISH msgs is
+ * stored in the context until the message, or its header, is complete.
+ *
+ * @param ctx MQTT context
+ * @param data Received bytes
+ * @param len Number of received bytes
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the stream cannot be parsed any further
+ */
+static int rx_feed(struct mqtt_ctx *ctx, u8_t *data, u16_t len)
+{
+	struct mqtt_rx *rx = &ctx->rx;
+	u32_t needed;
+	u32_t chunk;
+	int rc;
+
+	while (len > 0) {
+		if (!rx->hdr_len) {
+			rc = rx_fixed_hdr(rx, *data);
+			data++;
+			len--;
+
+			if (rc < 0) {
+				/* The message boundaries are lost */
+				rx_malformed(ctx);
+				rx_reset(rx);
+				return rc;
+			}
+
+			if (rc == 0) {
+				continue;
+			}
+		} else if (rx->payload || rx->discard) {
+			chunk = min(len, rx->rlen - rx->offset);
+
+			if (rx->payload && rx_publish_data(ctx, data, chunk)) {
+				rx->payload = 0;
+				rx->discard = 1;
+			}
+
+			rx->offset += chunk;
+			data += chunk;
+			len -= chunk;
+		} else {
+			needed = rx_needed(ctx);
+			if (needed > rx->rlen ||
+			    rx->hdr_len + needed > sizeof(rx->buf)) {
+				NET_DBG("Message too long, %u bytes",
+					rx->hdr_len + rx->rlen);
+				rx_malformed(ctx);
+				rx->discard = 1;
+				continue;
+			}
+
+			chunk = min(len, needed - rx->offset);
+			memcpy(rx->buf + rx->len, data, chunk);
+
+			rx->len += chunk;
+			rx->offset += chunk;
+			data += chunk;
+			len -= chunk;
+
+			/* The topic length gives the size of the header */
+			if (rx->offset < rx_needed(ctx)) {
+				continue;
+			}
+
+			if (rx_is_streamed(ctx) && rx_publish_start(ctx)) {
+				rx_malformed(ctx);
+				rx->discard = 1;
+			}
+		}
+
+		if (rx->offset == rx->rlen) {
+			rx_complete(ctx);
+			rx_reset(rx);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Parses the MQTT messages contained in the rx packet
+ *
+ * @details The fragments of the packet are parsed in place. On error, this
+ * routine will execute the 'ctx->malformed' callback (if defined)
+ *
+ * @param ctx MQTT context
+ * @param rx RX packet
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the message stream cannot be parsed any further
+ */
+static
+int mqtt_parser(struct mqtt_ctx *ctx, struct net_pkt *rx)
+{
+	struct net_buf *frag;
+	u16_t offset;
+	int rc;
+
+	frag = net_frag_get_pos(rx, net_pkt_get_len(rx) -
+				net_pkt_appdatalen(rx), &offset);
+
+	while (frag) {
+		rc = rx_feed(ctx, frag->data + offset, frag->len - offset);
+		if (rc != 0) {
+			return rc;
+		}
+
+		frag = frag->frags;
+		offset = 0;
+	}
+
+	return 0;
 }
 
 static
@@ -815,6 +1217,13 @@ int mqtt_connect(struct mqtt_ctx *ctx)
 		return -EFAULT;
 	}
 
+	/* A new connection starts a new message stream */
+	rx_reset(&ctx->rx);
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+	inflight_reset(ctx);
+#endif
+
 	rc = net_app_init_tcp_client(&ctx->net_app_ctx,
 				     NULL,
 				     NULL,
@@ -883,6 +1292,11 @@ int mqtt_init(struct mqtt_ctx *ctx, enum mqtt_app app_type)
 
 	ctx->app_type = app_type;
 	ctx->rcv = mqtt_parser;
+	rx_reset(&ctx->rx);
+
+#if CONFIG_MQTT_INFLIGHT_WINDOW > 0
+	inflight_reset(ctx);
+#endif
 
 #if defined(CONFIG_MQTT_LIB_TLS)
 	if (ctx->tls_hs_timeout == 0) {
@@ -58,7 +58,7 @@ static void zsock_flush_queue(struct net_context *ctx)
 	k_fifo_cancel_wait(&ctx->recv_q);
 }
 
-static inline struct net_context *sock_to_net_ctx(int sock)
+struct net_context *sock_to_net_ctx(int sock)
 {
 	return z_get_fd_obj(sock, &sock_fd_op_vtable, ENOTSOCK);
 }
@@ -360,11 +360,11 @@ Z_SYSCALL_HANDLER(zsock_accept, sock, addr, addrlen)
 }
 #endif /* CONFIG_USERSPACE */
 
-ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
-			 int flags,
-			 const struct sockaddr *dest_addr, socklen_t addrlen)
+static ssize_t zsock_sendmsg_ctx(struct net_context *ctx,
+				 const struct zsock_msghdr *msg, int flags)
 {
 	int err;
+	size_t i, len = 0;
 	struct net_pkt *send_pkt;
 	s32_t timeout = K_FOREVER;
 
@@ -378,7 +378,25 @@ ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 		return -1;
 	}
 
-	len = net_pkt_append(send_pkt, len, buf, timeout);
+	/* Gather the data into one packet, as much as fits into it */
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		const struct zsock_iovec *iov = &msg->msg_iov[i];
+		u16_t iov_len = min(iov->iov_len, UINT16_MAX);
+		u16_t appended;
+
+		if (!iov_len) {
+			continue;
+		}
+
+		appended = net_pkt_append(send_pkt, iov_len, iov->iov_base,
+					  timeout);
+		len += appended;
+
+		if (appended != iov->iov_len) {
+			break;
+		}
+	}
+
 	if (!len) {
 		net_pkt_unref(send_pkt);
 		errno = EAGAIN;
@@ -395,9 +413,10 @@ ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 		return -1;
 	}
 
-	if (dest_addr) {
-		err = net_context_sendto(send_pkt, dest_addr, addrlen, NULL,
-					 timeout, NULL, ctx->user_data);
+	if (msg->msg_name) {
+		err = net_context_sendto(send_pkt, msg->msg_name,
+					 msg->msg_namelen, NULL, timeout, NULL,
+					 ctx->user_data);
 	} else {
 		err = net_context_send(send_pkt, NULL, timeout, NULL, ctx->user_data);
 	}
@@ -411,6 +430,24 @@ ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 	return len;
 }
 
+ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
+			 int flags,
+			 const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	struct zsock_iovec iov = {
+		.iov_base = (void *)buf,
+		.iov_len = len,
+	};
+	struct zsock_msghdr msg = {
+		.msg_name = (void *)dest_addr,
+		.msg_namelen = addrlen,
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+
+	return zsock_sendmsg_ctx(ctx, &msg, flags);
+}
+
 ssize_t _impl_zsock_sendto(int sock, const void *buf, size_t len, int flags,
 			   const struct sockaddr *dest_addr, socklen_t addrlen)
 {
@@ -441,17 +478,41 @@ Z_SYSCALL_HANDLER(zsock_sendto, sock, buf, len, flags, dest_addr, addrlen)
 }
 #endif /* CONFIG_USERSPACE */
 
+static int zsock_get_src_addr(struct net_pkt *pkt, struct sockaddr *src_addr,
+			      socklen_t *addrlen)
+{
+	int rv;
+
+	rv = net_pkt_get_src_addr(pkt, src_addr, *addrlen);
+	if (rv < 0) {
+		errno = rv;
+		return -1;
+	}
+
+	/* addrlen is a value-result argument, set to actual
+	 * size of source address
+	 */
+	if (src_addr->sa_family == AF_INET) {
+		*addrlen = sizeof(struct sockaddr_in);
+	} else if (src_addr->sa_family == AF_INET6) {
+		*addrlen = sizeof(struct sockaddr_in6);
+	} else {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return 0;
+}
+
 static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
-				       void *buf,
-				       size_t max_len,
-				       int flags,
-				       struct sockaddr *src_addr,
-				       socklen_t *addrlen)
+				       struct zsock_msghdr *msg,
+				       int flags)
 {
 	size_t recv_len = 0;
 	s32_t timeout = K_FOREVER;
 	unsigned int header_len;
 	struct net_pkt *pkt;
+	size_t i, data_len;
 
 	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
 		timeout = K_NO_WAIT;
@@ -477,24 +538,9 @@ static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
 		return -1;
 	}
 
-	if (src_addr && addrlen) {
-		int rv;
-
-		rv = net_pkt_get_src_addr(pkt, src_addr, *addrlen);
-		if (rv < 0) {
-			errno = rv;
-			return -1;
-		}
-
-		/* addrlen is a value-result argument, set to actual
-		 * size of source address
-		 */
-		if (src_addr->sa_family == AF_INET) {
-			*addrlen = sizeof(struct sockaddr_in);
-		} else if (src_addr->sa_family == AF_INET6) {
-			*addrlen = sizeof(struct sockaddr_in6);
-		} else {
-			errno = ENOTSUP;
+	if (msg->msg_name) {
+		if (zsock_get_src_addr(pkt, msg->msg_name,
+				       &msg->msg_namelen) < 0) {
 			return -1;
 		}
 	}
@@ -503,13 +549,25 @@ static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
 	 * handled src addr and port.
 	 */
 	header_len = net_pkt_appdata(pkt) - pkt->frags->data;
+	data_len = net_pkt_appdatalen(pkt);
 
-	recv_len = net_pkt_appdatalen(pkt);
-	if (recv_len > max_len) {
-		recv_len = max_len;
+	/* Scatter the datagram to the buffers, dropping what does not fit */
+	for (i = 0; i < msg->msg_iovlen && recv_len < data_len; i++) {
+		struct zsock_iovec *iov = &msg->msg_iov[i];
+		size_t len = min(iov->iov_len, data_len - recv_len);
+
+		if (!len) {
+			continue;
+		}
+
+		net_frag_linearize(iov->iov_base, len, pkt,
+				   header_len + recv_len, len);
+		recv_len += len;
 	}
 
-	net_frag_linearize(buf, recv_len, pkt, header_len, recv_len);
+	if (recv_len < data_len) {
+		msg->msg_flags |= ZSOCK_MSG_TRUNC;
+	}
 
 	if (!(flags & ZSOCK_MSG_PEEK)) {
 		net_pkt_unref(pkt);
@@ -604,14 +662,93 @@ static inline ssize_t zsock_recv_stream(struct net_context *ctx,
 	return recv_len;
 }
 
+static ssize_t zsock_recv_stream_msg(struct net_context *ctx,
+				     struct zsock_msghdr *msg, int flags)
+{
+	ssize_t recv_len = 0;
+	size_t i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		struct zsock_iovec *iov = &msg->msg_iov[i];
+		ssize_t len;
+
+		if (!iov->iov_len) {
+			continue;
+		}
+
+		/* Only wait for the first piece of data */
+		len = zsock_recv_stream(ctx, iov->iov_base, iov->iov_len,
+					recv_len ? flags | ZSOCK_MSG_DONTWAIT :
+					flags);
+		if (len < 0) {
+			if (recv_len) {
+				break;
+			}
+
+			return -1;
+		}
+
+		recv_len += len;
+
+		/* Peeking does not consume data, so it would be returned
+		 * again to the next buffer.
+		 */
+		if (len < iov->iov_len || (flags & ZSOCK_MSG_PEEK)) {
+			break;
+		}
+	}
+
+	return recv_len;
+}
+
+static ssize_t zsock_recvmsg_ctx(struct net_context *ctx,
+				 struct zsock_msghdr *msg, int flags)
+{
+	enum net_sock_type sock_type = net_context_get_type(ctx);
+
+	msg->msg_flags = 0;
+	msg->msg_controllen = 0;
+
+	if (sock_type == SOCK_DGRAM) {
+		return zsock_recv_dgram(ctx, msg, flags);
+	} else if (sock_type == SOCK_STREAM) {
+		msg->msg_namelen = 0;
+		return zsock_recv_stream_msg(ctx, msg, flags);
+	} else {
+		__ASSERT(0, "Unknown socket type");
+	}
+
+	return 0;
+}
+
 ssize_t zsock_recvfrom_ctx(struct net_context *ctx, void *buf, size_t max_len,
 			   int flags,
 			   struct sockaddr *src_addr, socklen_t *addrlen)
 {
 	enum net_sock_type sock_type = net_context_get_type(ctx);
+	struct zsock_iovec iov = {
+		.iov_base = buf,
+		.iov_len = max_len,
+	};
+	struct zsock_msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	ssize_t ret;
 
 	if (sock_type == SOCK_DGRAM) {
-		return zsock_recv_dgram(ctx, buf, max_len, flags, src_addr, addrlen);
+		if (src_addr && addrlen) {
+			msg.msg_name = src_addr;
+			msg.msg_namelen = *addrlen;
+		}
+
+		ret = zsock_recv_dgram(ctx, &msg, flags);
+
+		if (ret >= 0 && msg.msg_name) {
+			*addrlen = msg.msg_namelen;
+		}
+
+		return ret;
 	} else if (sock_type == SOCK_STREAM) {
 		return zsock_recv_stream(ctx, buf, max_len, flags);
 	} else {
@@ -666,6 +803,515 @@ Z_SYSCALL_HANDLER(zsock_recvfrom, sock, buf, max_len, flags, src_addr,
 }
 #endif /* CONFIG_USERSPACE */
 
+/* The message calls pass the data to the net_context as is. On a TLS
+ * socket this would bypass the encryption, so they have to go through the
+ * ztls_ variants instead.
+ */
+static struct net_context *msg_sock_to_net_ctx(int sock)
+{
+	struct net_context *ctx = sock_to_net_ctx(sock);
+
+#if defined(CONFIG_NET_SOCKETS_SOCKOPT_TLS)
+	if (ctx && ctx->tls) {
+		errno = EOPNOTSUPP;
+		return NULL;
+	}
+#endif
+
+	return ctx;
+}
+
+ssize_t _impl_zsock_sendmsg(int sock, const struct zsock_msghdr *msg,
+			    int flags)
+{
+	struct net_context *ctx = msg_sock_to_net_ctx(sock);
+
+	if (ctx == NULL) {
+		return -1;
+	}
+
+	return zsock_sendmsg_ctx(ctx, msg, flags);
+}
+
+ssize_t _impl_zsock_recvmsg(int sock, struct zsock_msghdr *msg, int flags)
+{
+	struct net_context *ctx = msg_sock_to_net_ctx(sock);
+
+	if (ctx == NULL) {
+		return -1;
+	}
+
+	return zsock_recvmsg_ctx(ctx, msg, flags);
+}
+
+int _impl_zsock_sendmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			 unsigned int vlen, int flags)
+{
+	struct net_context *ctx = msg_sock_to_net_ctx(sock);
+	unsigned int i;
+	ssize_t len;
+
+	if (ctx == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i < vlen; i++) {
+		len = zsock_sendmsg_ctx(ctx, &msgvec[i].msg_hdr, flags);
+		if (len < 0) {
+			/* The error is reported only if nothing was sent */
+			return i ? i : -1;
+		}
+
+		msgvec[i].msg_len = len;
+	}
+
+	return i;
+}
+
+int _impl_zsock_recvmmsg(int sock, struct zsock_mmsghdr *msgvec,
+			 unsigned int vlen, int flags)
+{
+	struct net_context *ctx = msg_sock_to_net_ctx(sock);
+	unsigned int i;
+	ssize_t len;
+
+	if (ctx == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i < vlen; i++) {
+		/* Only wait for the first message */
+		len = zsock_recvmsg_ctx(ctx, &msgvec[i].msg_hdr,
+					i ? flags | ZSOCK_MSG_DONTWAIT : flags);
+		if (len < 0) {
+			return i ? i : -1;
+		}
+
+		msgvec[i].msg_len = len;
+
+		/* End of stream */
+		if (len == 0 && net_context_get_type(ctx) == SOCK_STREAM) {
+			return i + 1;
+		}
+	}
+
+	return i;
+}
+
+#ifdef CONFIG_USERSPACE
+/* Copy a message header and its I/O vector from user mode and check that
+ * the caller can access the buffers. The data itself is not copied. The
+ * destination address of a sent message is copied to name.
+ */
+static int zsock_msghdr_from_user(struct zsock_msghdr *msg,
+				  const struct zsock_msghdr *user_msg,
+				  struct sockaddr_storage *name, bool write)
+{
+	struct zsock_iovec *iov = NULL;
+	size_t i;
+
+	if (z_user_from_copy(msg, (void *)user_msg, sizeof(*msg))) {
+		return -EFAULT;
+	}
+
+	if (msg->msg_iovlen) {
+		if (Z_SYSCALL_MEMORY_ARRAY_READ(msg->msg_iov, msg->msg_iovlen,
+						sizeof(struct zsock_iovec))) {
+			return -EFAULT;
+		}
+
+		iov = z_user_alloc_from_copy(msg->msg_iov, msg->msg_iovlen *
+					     sizeof(struct zsock_iovec));
+		if (!iov) {
+			return -ENOMEM;
+		}
+	}
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		if (Z_SYSCALL_MEMORY(iov[i].iov_base, iov[i].iov_len,
+				     write)) {
+			k_free(iov);
+			return -EFAULT;
+		}
+	}
+
+	msg->msg_iov = iov;
+	msg->msg_control = NULL;
+	msg->msg_controllen = 0;
+
+	if (!msg->msg_name) {
+		return 0;
+	}
+
+	if (write) {
+		if (Z_SYSCALL_MEMORY_WRITE(msg->msg_name, msg->msg_namelen)) {
+			k_free(iov);
+			return -EFAULT;
+		}
+	} else {
+		if (msg->msg_namelen > sizeof(*name) ||
+		    z_user_from_copy(name, msg->msg_name, msg->msg_namelen)) {
+			k_free(iov);
+			return -EFAULT;
+		}
+
+		msg->msg_name = name;
+	}
+
+	return 0;
+}
+
+/* Return the results of a received message to user mode */
+static int zsock_msghdr_to_user(struct zsock_msghdr *user_msg,
+				struct zsock_msghdr *msg)
+{
+	if (z_user_to_copy(&user_msg->msg_namelen, &msg->msg_namelen,
+			   sizeof(msg->msg_namelen)) ||
+	    z_user_to_copy(&user_msg->msg_controllen, &msg->msg_controllen,
+			   sizeof(msg->msg_controllen)) ||
+	    z_user_to_copy(&user_msg->msg_flags, &msg->msg_flags,
+			   sizeof(msg->msg_flags))) {
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+Z_SYSCALL_HANDLER(zsock_sendmsg, sock, msg, flags)
+{
+	struct sockaddr_storage name;
+	struct zsock_msghdr msg_copy;
+	ssize_t ret;
+
+	ret = zsock_msghdr_from_user(&msg_copy, (struct zsock_msghdr *)msg,
+				     &name, false);
+	if (ret == -ENOMEM) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	Z_OOPS(ret);
+
+	ret = _impl_zsock_sendmsg(sock, &msg_copy, flags);
+
+	k_free(msg_copy.msg_iov);
+
+	return ret;
+}
+
+Z_SYSCALL_HANDLER(zsock_recvmsg, sock, msg, flags)
+{
+	struct zsock_msghdr msg_copy;
+	ssize_t ret;
+
+	ret = zsock_msghdr_from_user(&msg_copy, (struct zsock_msghdr *)msg,
+				     NULL, true);
+	if (ret == -ENOMEM) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	Z_OOPS(ret);
+
+	ret = _impl_zsock_recvmsg(sock, &msg_copy, flags);
+
+	k_free(msg_copy.msg_iov);
+
+	if (ret >= 0) {
+		Z_OOPS(zsock_msghdr_to_user((struct zsock_msghdr *)msg,
+					    &msg_copy));
+	}
+
+	return ret;
+}
+
+/* The messages are handled one by one with the single message calls, so
+ * that only one I/O vector needs to be copied from user mode at a time.
+ */
+Z_SYSCALL_HANDLER(zsock_sendmmsg, sock, msgvec, vlen, flags)
+{
+	struct zsock_mmsghdr *user_vec = (struct zsock_mmsghdr *)msgvec;
+	struct sockaddr_storage name;
+	struct zsock_msghdr msg_copy;
+	unsigned int i, len;
+	ssize_t ret;
+
+	for (i = 0; i < vlen; i++) {
+		ret = zsock_msghdr_from_user(&msg_copy, &user_vec[i].msg_hdr,
+					     &name, false);
+		if (ret == -ENOMEM) {
+			errno = ENOMEM;
+			break;
+		}
+
+		Z_OOPS(ret);
+
+		ret = _impl_zsock_sendmsg(sock, &msg_copy, flags);
+
+		k_free(msg_copy.msg_iov);
+
+		if (ret < 0) {
+			break;
+		}
+
+		len = ret;
+		Z_OOPS(z_user_to_copy(&user_vec[i].msg_len, &len,
+				      sizeof(len)));
+	}
+
+	return (i || !vlen) ? i : -1;
+}
+
+Z_SYSCALL_HANDLER(zsock_recvmmsg, sock, msgvec, vlen, flags)
+{
+	struct zsock_mmsghdr *user_vec = (struct zsock_mmsghdr *)msgvec;
+	struct net_context *ctx = sock_to_net_ctx(sock);
+	struct zsock_msghdr msg_copy;
+	unsigned int i, len;
+	ssize_t ret;
+
+	for (i = 0; i < vlen; i++) {
+		ret = zsock_msghdr_from_user(&msg_copy, &user_vec[i].msg_hdr,
+					     NULL, true);
+		if (ret == -ENOMEM) {
+			errno = ENOMEM;
+			break;
+		}
+
+		Z_OOPS(ret);
+
+		ret = _impl_zsock_recvmsg(sock, &msg_copy,
+					  i ? flags | ZSOCK_MSG_DONTWAIT : flags);
+
+		k_free(msg_copy.msg_iov);
+
+		if (ret < 0) {
+			break;
+		}
+
+		len = ret;
+		Z_OOPS(zsock_msghdr_to_user(&user_vec[i].msg_hdr, &msg_copy));
+		Z_OOPS(z_user_to_copy(&user_vec[i].msg_len, &len,
+				      sizeof(len)));
+
+		/* End of stream */
+		if (len == 0 && ctx &&
+		    net_context_get_type(ctx) == SOCK_STREAM) {
+			i++;
+			break;
+		}
+	}
+
+	return (i || !vlen) ? i : -1;
+}
+#endif /* CONFIG_USERSPACE */
+
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+ssize_t zsock_recvfrom_zc(int sock, struct net_pkt **pkt, int flags,
+			  struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	struct net_context *ctx = sock_to_net_ctx(sock);
+	enum net_sock_type sock_type;
+	s32_t timeout = K_FOREVER;
+	struct net_pkt *recv_pkt;
+	size_t recv_len;
+
+	if (ctx == NULL) {
+		return -1;
+	}
+
+	if (!pkt || (flags & ZSOCK_MSG_PEEK)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*pkt = NULL;
+	sock_type = net_context_get_type(ctx);
+
+	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
+		timeout = K_NO_WAIT;
+	}
+
+	if (sock_type == SOCK_STREAM && sock_is_eof(ctx)) {
+		return 0;
+	}
+
+	recv_pkt = k_fifo_get(&ctx->recv_q, timeout);
+	if (!recv_pkt) {
+		/* Either timeout expired, or wait was cancelled
+		 * due to connection closure by peer.
+		 */
+		if (sock_type == SOCK_STREAM && sock_is_eof(ctx)) {
+			return 0;
+		}
+
+		errno = EAGAIN;
+		return -1;
+	}
+
+	if (sock_type == SOCK_DGRAM) {
+		if (src_addr && addrlen &&
+		    zsock_get_src_addr(recv_pkt, src_addr, addrlen) < 0) {
+			net_pkt_unref(recv_pkt);
+			return -1;
+		}
+
+		/* Leave only the payload in the lent fragment chain */
+		net_buf_pull(recv_pkt->frags,
+			     net_pkt_appdata(recv_pkt) - recv_pkt->frags->data);
+
+		recv_len = net_pkt_appdatalen(recv_pkt);
+	} else {
+		/* Headers were already removed in zsock_received_cb(), and
+		 * zsock_recv_stream() might have consumed part of the data.
+		 */
+		if (net_pkt_eof(recv_pkt)) {
+			sock_set_eof(ctx);
+		}
+
+		recv_len = net_pkt_get_len(recv_pkt);
+		if (!recv_len) {
+			net_pkt_unref(recv_pkt);
+			return 0;
+		}
+	}
+
+	/* Remember the lent amount so that the receive window can be
+	 * opened again when the application releases the packet.
+	 */
+	net_pkt_set_appdatalen(recv_pkt, recv_len);
+	net_pkt_set_appdata(recv_pkt, recv_pkt->frags->data);
+
+	*pkt = recv_pkt;
+
+	return recv_len;
+}
+
+void zsock_recv_zc_release(int sock, struct net_pkt *pkt)
+{
+	struct net_context *ctx = sock_to_net_ctx(sock);
+
+	if (!pkt) {
+		return;
+	}
+
+	if (ctx && net_context_get_type(ctx) == SOCK_STREAM) {
+		net_context_update_recv_wnd(ctx, net_pkt_appdatalen(pkt));
+	}
+
+	net_pkt_unref(pkt);
+}
+
+struct net_buf *zsock_get_buf(int sock, s32_t timeout)
+{
+	struct net_context *ctx = sock_to_net_ctx(sock);
+	struct net_buf *buf;
+
+	if (ctx == NULL) {
+		return NULL;
+	}
+
+	buf = net_pkt_get_data(ctx, timeout);
+	if (!buf) {
+		errno = ENOMEM;
+	}
+
+	return buf;
+}
+
+ssize_t zsock_sendto_zc(int sock, struct net_buf *frags, int flags,
+			const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	struct net_context *ctx = sock_to_net_ctx(sock);
+	s32_t timeout = K_FOREVER;
+	struct net_pkt *send_pkt;
+	struct net_buf *rest;
+	ssize_t sent = 0;
+	size_t len;
+	int err;
+
+	if (ctx == NULL) {
+		if (frags) {
+			net_buf_unref(frags);
+		}
+
+		return -1;
+	}
+
+	if (!frags) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
+		timeout = K_NO_WAIT;
+	}
+
+	/* Register the callback before sending in order to receive the response
+	 * from the peer.
+	 */
+	err = net_context_recv(ctx, zsock_received_cb, K_NO_WAIT, ctx->user_data);
+	if (err < 0) {
+		goto fail;
+	}
+
+	while (frags) {
+		send_pkt = net_pkt_get_tx(ctx, timeout);
+		if (!send_pkt) {
+			err = -EAGAIN;
+			goto fail;
+		}
+
+		len = net_pkt_append_frags(send_pkt, frags, &rest, timeout);
+		if (!len) {
+			net_pkt_unref(send_pkt);
+			err = -EAGAIN;
+			goto fail;
+		}
+
+		if (rest && net_context_get_type(ctx) != SOCK_STREAM) {
+			/* Datagrams are never split */
+			net_pkt_unref(send_pkt);
+			frags = rest;
+			err = -EMSGSIZE;
+			goto fail;
+		}
+
+		frags = rest;
+
+		if (dest_addr) {
+			err = net_context_sendto(send_pkt, dest_addr, addrlen,
+						 NULL, timeout, NULL,
+						 ctx->user_data);
+		} else {
+			err = net_context_send(send_pkt, NULL, timeout, NULL,
+					       ctx->user_data);
+		}
+
+		if (err < 0) {
+			net_pkt_unref(send_pkt);
+			goto fail;
+		}
+
+		sent += len;
+	}
+
+	return sent;
+
+fail:
+	if (frags) {
+		net_buf_unref(frags);
+	}
+
+	if (sent) {
+		return sent;
+	}
+
+	errno = -err;
+	return -1;
+}
+#endif /* CONFIG_NET_SOCKETS_ZEROCOPY */
+
 /* As this is limited function, we don't follow POSIX signature, with
  * "..." instead of last arg.
  */
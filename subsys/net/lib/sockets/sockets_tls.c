@@ -14,6 +14,7 @@
 #include <entropy.h>
 #include <misc/util.h>
 #include <net/net_context.h>
+#include <net/net_pkt.h>
 #include <net/socket.h>
 
 #if defined(CONFIG_MBEDTLS)
@@ -29,6 +30,8 @@
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/ssl.h>
 #include <mbedtls/ssl_cookie.h>
+#include <mbedtls/ssl_cache.h>
+#include <mbedtls/ssl_ticket.h>
 #include <mbedtls/error.h>
 #include <mbedtls/debug.h>
 #endif /* CONFIG_MBEDTLS */
@@ -95,6 +98,9 @@ struct tls_context {
 
 		/** DTLS role, client by default. */
 		s8_t role;
+
+		/** Information whether session resumption is enabled. */
+		bool cache_enabled;
 	} options;
 
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
@@ -109,6 +115,40 @@ struct tls_context {
 
 	/** DTLS peer address length. */
 	socklen_t dtls_peer_addrlen;
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+	/** Socket owning the context. */
+	struct net_context *dtls_context;
+
+	/** File descriptor of the socket owning the context. */
+	int dtls_sock;
+
+	/** For a peer of a DTLS server, the listening socket it came from.
+	 *  Cleared when the peer is closed or evicted.
+	 */
+	struct net_context *dtls_listener;
+
+	/** Node in the peer table of the DTLS server. */
+	sys_snode_t dtls_node;
+
+	/** Uptime in milliseconds of the last datagram from the peer. */
+	u32_t dtls_last_rx;
+
+	/** ClientHello being answered by a listening socket. */
+	struct net_pkt *dtls_hello;
+
+	/** Maximum number of peers with a handshake in progress. */
+	int dtls_backlog;
+
+	/** Information whether the DTLS server socket is listening. */
+	bool dtls_is_listening;
+
+	/** Information whether the context belongs to a peer. */
+	bool dtls_is_peer;
+
+	/** Information whether the peer was returned by accept(). */
+	bool dtls_is_accepted;
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
 #if defined(CONFIG_MBEDTLS)
@@ -129,6 +169,8 @@ struct tls_context {
 	mbedtls_pk_context priv_key;
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
+	/** Buffers of a sendmsg() call gathered into one record. */
+	u8_t sendmsg_buf[MBEDTLS_SSL_MAX_CONTENT_LEN];
 #endif /* CONFIG_MBEDTLS */
 };
 
@@ -140,6 +182,58 @@ static struct tls_context tls_contexts[CONFIG_NET_SOCKETS_TLS_MAX_CONTEXTS];
 /* A mutex for protecting TLS context allocation. */
 static struct k_mutex context_lock;
 
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+/* Peers of all DTLS servers, hashed by the listening socket and the peer
+ * address.
+ */
+static sys_slist_t dtls_peers[CONFIG_NET_SOCKETS_DTLS_SERVER_HASH_SIZE];
+
+/* Protects the peer table and the dtls_listener pointers. */
+static K_MUTEX_DEFINE(dtls_peer_lock);
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+/* Lifetime hint of the session tickets issued by servers, in seconds. */
+#define TLS_SESSION_TICKET_LIFETIME 86400
+
+/** Session of a TLS/DTLS client, cached for resumption. */
+struct tls_session_cache {
+	/** Information whether the entry is used. */
+	bool is_used;
+
+	/** Uptime of the last use of the session. */
+	u32_t timestamp;
+
+	/** Address of the peer the session was established with. */
+	struct sockaddr peer_addr;
+
+	/** Hostname the session was established for, may be empty. */
+	char hostname[CONFIG_NET_SOCKETS_TLS_SESSION_CACHE_HOSTNAME_LEN + 1];
+
+	/** mbedTLS session. */
+	mbedtls_ssl_session session;
+};
+
+/* Sessions of TLS/DTLS clients. */
+static struct tls_session_cache client_sessions[
+				CONFIG_NET_SOCKETS_TLS_SESSION_CACHE_SIZE];
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+/* Session ID cache shared by all TLS/DTLS servers. */
+static mbedtls_ssl_cache_context server_cache;
+#endif
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+/* Session ticket keys shared by all TLS/DTLS servers. */
+static mbedtls_ssl_ticket_context server_ticket;
+#endif
+
+/* A mutex for protecting the session caches, which mbedTLS does not
+ * protect on its own.
+ */
+static struct k_mutex session_lock;
+#endif /* CONFIG_NET_SOCKETS_TLS_SESSION_CACHE */
+
 #define IS_LISTENING(context) (net_context_get_state(context) == \
 			       NET_CONTEXT_LISTENING)
 
@@ -243,6 +337,317 @@ static int dtls_timing_get_delay(void *data)
 }
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS) || \
+	defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+static bool peer_addr_cmp(const struct sockaddr *addr1,
+			  const struct sockaddr *addr2)
+{
+	if (addr1->sa_family != addr2->sa_family) {
+		return false;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && addr1->sa_family == AF_INET6) {
+		return (net_sin6(addr1)->sin6_port ==
+			net_sin6(addr2)->sin6_port) &&
+			net_ipv6_addr_cmp(&net_sin6(addr1)->sin6_addr,
+					  &net_sin6(addr2)->sin6_addr);
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		   addr1->sa_family == AF_INET) {
+		return (net_sin(addr1)->sin_port ==
+			net_sin(addr2)->sin_port) &&
+			net_ipv4_addr_cmp(&net_sin(addr1)->sin_addr,
+					  &net_sin(addr2)->sin_addr);
+	}
+
+	return false;
+}
+#endif
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+static const struct sockaddr *tls_session_peer_addr(
+						struct net_context *context)
+{
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
+	if (net_context_get_type(context) == SOCK_DGRAM) {
+		return &context->tls->dtls_peer_addr;
+	}
+#endif
+
+	return &context->remote;
+}
+
+static const char *tls_session_hostname(struct net_context *context)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (context->tls->ssl.hostname) {
+		return context->tls->ssl.hostname;
+	}
+#endif
+
+	return "";
+}
+
+/* Find the cached session of a client. Must be called with session_lock
+ * held.
+ */
+static struct tls_session_cache *tls_session_find(struct net_context *context)
+{
+	const struct sockaddr *peer_addr = tls_session_peer_addr(context);
+	const char *hostname = tls_session_hostname(context);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+		if (client_sessions[i].is_used &&
+		    peer_addr_cmp(&client_sessions[i].peer_addr, peer_addr) &&
+		    !strcmp(client_sessions[i].hostname, hostname)) {
+			return &client_sessions[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void tls_session_free(struct tls_session_cache *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	entry->is_used = false;
+}
+
+/* Set the cached session, if any, on a client before the handshake, so
+ * that the client asks the server to resume it.
+ */
+static void tls_session_restore(struct net_context *context)
+{
+	struct tls_session_cache *entry;
+	int ret;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = tls_session_find(context);
+	if (entry) {
+		ret = mbedtls_ssl_set_session(&context->tls->ssl,
+					      &entry->session);
+		if (ret != 0) {
+			NET_DBG("Cannot set session: -%x", -ret);
+			tls_session_free(entry);
+		} else {
+			NET_DBG("Resuming session %p", entry);
+			entry->timestamp = k_uptime_get_32();
+		}
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+/* Store the session of a client after a successful handshake. If the
+ * cache is full, the least recently used session is replaced.
+ */
+static void tls_session_save(struct net_context *context)
+{
+	const struct sockaddr *peer_addr = tls_session_peer_addr(context);
+	const char *hostname = tls_session_hostname(context);
+	struct tls_session_cache *entry;
+	size_t len = strlen(hostname);
+	int i, ret;
+
+	if (len >= sizeof(entry->hostname)) {
+		return;
+	}
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = tls_session_find(context);
+	if (!entry) {
+		entry = &client_sessions[0];
+
+		for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+			if (!client_sessions[i].is_used) {
+				entry = &client_sessions[i];
+				break;
+			}
+
+			if ((s32_t)(client_sessions[i].timestamp -
+				    entry->timestamp) < 0) {
+				entry = &client_sessions[i];
+			}
+		}
+	}
+
+	if (entry->is_used) {
+		tls_session_free(entry);
+	}
+
+	mbedtls_ssl_session_init(&entry->session);
+
+	ret = mbedtls_ssl_get_session(&context->tls->ssl, &entry->session);
+	if (ret != 0) {
+		NET_DBG("Cannot get session: -%x", -ret);
+		mbedtls_ssl_session_free(&entry->session);
+	} else {
+		memcpy(&entry->peer_addr, peer_addr, sizeof(entry->peer_addr));
+		memcpy(entry->hostname, hostname, len + 1);
+		entry->timestamp = k_uptime_get_32();
+		entry->is_used = true;
+
+		NET_DBG("Saved session %p", entry);
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+/* Drop the cached session of a client whose handshake failed, so that the
+ * next connection starts with a full handshake.
+ */
+static void tls_session_drop(struct net_context *context)
+{
+	struct tls_session_cache *entry;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = tls_session_find(context);
+	if (entry) {
+		tls_session_free(entry);
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+static int tls_session_cache_get(void *data, mbedtls_ssl_session *session)
+{
+	int ret;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+	ret = mbedtls_ssl_cache_get(data, session);
+	k_mutex_unlock(&session_lock);
+
+	return ret;
+}
+
+static int tls_session_cache_set(void *data,
+				 const mbedtls_ssl_session *session)
+{
+	int ret;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+	ret = mbedtls_ssl_cache_set(data, session);
+	k_mutex_unlock(&session_lock);
+
+	return ret;
+}
+#endif /* MBEDTLS_SSL_CACHE_C */
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+static int tls_session_ticket_write(void *data,
+				    const mbedtls_ssl_session *session,
+				    unsigned char *start,
+				    const unsigned char *end,
+				    size_t *tlen, uint32_t *lifetime)
+{
+	int ret;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+	ret = mbedtls_ssl_ticket_write(data, session, start, end, tlen,
+				       lifetime);
+	k_mutex_unlock(&session_lock);
+
+	return ret;
+}
+
+static int tls_session_ticket_parse(void *data, mbedtls_ssl_session *session,
+				    unsigned char *buf, size_t len)
+{
+	int ret;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+	ret = mbedtls_ssl_ticket_parse(data, session, buf, len);
+	k_mutex_unlock(&session_lock);
+
+	return ret;
+}
+#endif /* MBEDTLS_SSL_TICKET_C */
+
+/* Configure session resumption of a TLS context. */
+static void tls_session_conf(struct tls_context *tls, bool is_server)
+{
+	if (!is_server) {
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		/* Do not make servers issue tickets that are never used. */
+		mbedtls_ssl_conf_session_tickets(
+			&tls->config, tls->options.cache_enabled ?
+			MBEDTLS_SSL_SESSION_TICKETS_ENABLED :
+			MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+#endif
+		return;
+	}
+
+	if (!tls->options.cache_enabled) {
+		return;
+	}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_conf_session_cache(&tls->config, &server_cache,
+				       tls_session_cache_get,
+				       tls_session_cache_set);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_conf_session_tickets_cb(&tls->config,
+					    tls_session_ticket_write,
+					    tls_session_ticket_parse,
+					    &server_ticket);
+#endif
+}
+
+static void tls_session_server_cache_init(void)
+{
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_cache_init(&server_cache);
+	mbedtls_ssl_cache_set_max_entries(
+			&server_cache, CONFIG_NET_SOCKETS_TLS_SESSION_CACHE_SIZE);
+#endif
+}
+
+static void tls_session_purge(void)
+{
+	int i;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+		if (client_sessions[i].is_used) {
+			tls_session_free(&client_sessions[i]);
+		}
+	}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+	mbedtls_ssl_cache_free(&server_cache);
+	tls_session_server_cache_init();
+#endif
+
+	k_mutex_unlock(&session_lock);
+}
+
+static int tls_session_init(void)
+{
+	k_mutex_init(&session_lock);
+
+	tls_session_server_cache_init();
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+	mbedtls_ssl_ticket_init(&server_ticket);
+
+	if (mbedtls_ssl_ticket_setup(&server_ticket, mbedtls_ctr_drbg_random,
+				     &tls_ctr_drbg, MBEDTLS_CIPHER_AES_128_CCM,
+				     TLS_SESSION_TICKET_LIFETIME) != 0) {
+		mbedtls_ssl_ticket_free(&server_ticket);
+		return -EFAULT;
+	}
+#endif
+
+	return 0;
+}
+#endif /* CONFIG_NET_SOCKETS_TLS_SESSION_CACHE */
+
 /* Initialize TLS internals. */
 static int tls_init(struct device *unused)
 {
@@ -282,6 +687,14 @@ static int tls_init(struct device *unused)
 	mbedtls_debug_set_threshold(CONFIG_MBEDTLS_DEBUG_LEVEL);
 #endif
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	ret = tls_session_init();
+	if (ret < 0) {
+		NET_ERR("TLS session cache initialization failed");
+		return ret;
+	}
+#endif
+
 	return 0;
 }
 
@@ -397,29 +810,11 @@ static bool dtls_is_peer_addr_valid(struct net_context *context,
 				    const struct sockaddr *peer_addr,
 				    socklen_t addrlen)
 {
-	if (context->tls->dtls_peer_addrlen != addrlen ||
-	    context->tls->dtls_peer_addr.sa_family != peer_addr->sa_family) {
+	if (context->tls->dtls_peer_addrlen != addrlen) {
 		return false;
 	}
 
-	if (IS_ENABLED(CONFIG_NET_IPV6) && peer_addr->sa_family == AF_INET6) {
-		struct sockaddr_in6 *addr1 = net_sin6(peer_addr);
-		struct sockaddr_in6 *addr2 =
-				net_sin6(&context->tls->dtls_peer_addr);
-
-		return (addr1->sin6_port == addr2->sin6_port) &&
-			net_ipv6_addr_cmp(&addr1->sin6_addr, &addr2->sin6_addr);
-	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
-		   peer_addr->sa_family == AF_INET) {
-		struct sockaddr_in *addr1 = net_sin(peer_addr);
-		struct sockaddr_in *addr2 =
-				net_sin(&context->tls->dtls_peer_addr);
-
-		return (addr1->sin_port == addr2->sin_port) &&
-			net_ipv4_addr_cmp(&addr1->sin_addr, &addr2->sin_addr);
-	}
-
-	return false;
+	return peer_addr_cmp(peer_addr, &context->tls->dtls_peer_addr);
 }
 
 static void dtls_peer_address_set(struct net_context *context,
@@ -444,13 +839,12 @@ static void dtls_peer_address_get(struct net_context *context,
 
 static int dtls_tx(void *ctx, const unsigned char *buf, size_t len)
 {
-	int sock = POINTER_TO_INT(ctx);
 	struct net_context *context = ctx;
 	ssize_t sent;
 
-	sent = zsock_sendto(sock, buf, len, context->tls->flags,
-			    &context->tls->dtls_peer_addr,
-			    context->tls->dtls_peer_addrlen);
+	sent = zsock_sendto_ctx(context, buf, len, context->tls->flags,
+				&context->tls->dtls_peer_addr,
+				context->tls->dtls_peer_addrlen);
 	if (sent < 0) {
 		if (errno == EAGAIN) {
 			return MBEDTLS_ERR_SSL_WANT_WRITE;
@@ -464,7 +858,6 @@ static int dtls_tx(void *ctx, const unsigned char *buf, size_t len)
 
 static int dtls_rx(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
 {
-	int sock = POINTER_TO_INT(ctx);
 	struct net_context *context = ctx;
 	bool is_block = !((context->tls->flags & ZSOCK_MSG_DONTWAIT) ||
 			  sock_is_nonblock(context));
@@ -474,7 +867,7 @@ static int dtls_rx(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
 	struct sockaddr addr;
 	int err;
 	ssize_t received;
-	struct pollfd fds;
+	struct k_poll_event event;
 	bool retry;
 
 	do {
@@ -484,15 +877,20 @@ static int dtls_rx(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
 		 * poll for timeout functionality.
 		 */
 		if (is_block) {
-			fds.fd = sock;
-			fds.events = POLLIN;
-			if (zsock_poll(&fds, 1, remaining_time) == 0) {
+			k_poll_event_init(&event,
+					  K_POLL_TYPE_FIFO_DATA_AVAILABLE,
+					  K_POLL_MODE_NOTIFY_ONLY,
+					  &context->recv_q);
+			if (k_poll(&event, 1, remaining_time) == -EAGAIN) {
 				return MBEDTLS_ERR_SSL_TIMEOUT;
 			}
 		}
 
-		received = zsock_recvfrom(sock, buf, len, context->tls->flags,
-					  &addr, &addrlen);
+		/* Data is available, or the wait was cancelled */
+		received = zsock_recvfrom_ctx(context, buf, len,
+					      context->tls->flags |
+					      ZSOCK_MSG_DONTWAIT,
+					      &addr, &addrlen);
 		if (received < 0) {
 			if (errno == EAGAIN) {
 				return MBEDTLS_ERR_SSL_WANT_READ;
@@ -535,15 +933,145 @@ static int dtls_rx(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
 
 	return received;
 }
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+/* Send a datagram of a DTLS server through the listening socket. The
+ * datagram does not go through the socket layer, as that would replace the
+ * receive callback demultiplexing the peers.
+ */
+static int dtls_server_tx(void *ctx, const unsigned char *buf, size_t len)
+{
+	struct net_context *context = ctx;
+	struct net_context *listener;
+	struct net_pkt *pkt;
+	s32_t timeout = K_FOREVER;
+	int ret;
+
+	if ((context->tls->flags & ZSOCK_MSG_DONTWAIT) ||
+	    sock_is_nonblock(context)) {
+		timeout = K_NO_WAIT;
+	}
+
+	/* Keep the listening socket around even if it is closed meanwhile */
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+	if (context->tls->dtls_is_peer) {
+		listener = context->tls->dtls_listener;
+	} else {
+		listener = context;
+	}
+
+	if (listener) {
+		net_context_ref(listener);
+	}
+
+	k_mutex_unlock(&dtls_peer_lock);
+
+	if (!listener) {
+		return MBEDTLS_ERR_NET_SEND_FAILED;
+	}
+
+	pkt = net_pkt_get_tx(listener, timeout);
+	if (!pkt) {
+		ret = MBEDTLS_ERR_SSL_WANT_WRITE;
+		goto out;
+	}
+
+	if (net_pkt_append(pkt, len, buf, timeout) != len) {
+		net_pkt_unref(pkt);
+		ret = MBEDTLS_ERR_SSL_WANT_WRITE;
+		goto out;
+	}
+
+	ret = net_context_sendto(pkt, &context->tls->dtls_peer_addr,
+				 context->tls->dtls_peer_addrlen, NULL,
+				 timeout, NULL, NULL);
+	if (ret < 0) {
+		net_pkt_unref(pkt);
+		ret = MBEDTLS_ERR_NET_SEND_FAILED;
+	} else {
+		ret = len;
+	}
+
+out:
+	net_context_unref(listener);
+
+	return ret;
+}
+
+/* Receive the ClientHello that a listening socket is answering. */
+static int dtls_hello_rx(void *ctx, unsigned char *buf, size_t len,
+			 uint32_t timeout)
+{
+	struct net_context *context = ctx;
+	struct net_pkt *pkt = context->tls->dtls_hello;
+	u16_t header_len;
+	size_t data_len;
+
+	ARG_UNUSED(timeout);
+
+	if (!pkt) {
+		return MBEDTLS_ERR_SSL_WANT_READ;
+	}
+
+	context->tls->dtls_hello = NULL;
+
+	header_len = net_pkt_appdata(pkt) - pkt->frags->data;
+	data_len = min(net_pkt_appdatalen(pkt), len);
+
+	net_frag_linearize(buf, data_len, pkt, header_len, data_len);
+	net_pkt_unref(pkt);
+
+	return data_len;
+}
+
+/* The listening socket verified the cookie of the ClientHello the peer was
+ * created for.
+ */
+static int dtls_peer_cookie_check(void *ctx, const unsigned char *cookie,
+				  size_t cookie_len,
+				  const unsigned char *cli_id,
+				  size_t cli_id_len)
+{
+	return 0;
+}
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
+
+static int dtls_cookie_setup(struct tls_context *tls)
+{
+	int ret;
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+	if (tls->dtls_is_peer) {
+		/* No cookie write callback, so that a peer never sends a
+		 * HelloVerifyRequest.
+		 */
+		mbedtls_ssl_conf_dtls_cookies(&tls->config, NULL,
+					      dtls_peer_cookie_check, NULL);
+		return 0;
+	}
+#endif
+
+	ret = mbedtls_ssl_cookie_setup(&tls->cookie, mbedtls_ctr_drbg_random,
+				       &tls_ctr_drbg);
+	if (ret != 0) {
+		return -ENOMEM;
+	}
+
+	mbedtls_ssl_conf_dtls_cookies(&tls->config, mbedtls_ssl_cookie_write,
+				      mbedtls_ssl_cookie_check, &tls->cookie);
+
+	return 0;
+}
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
 static int tls_tx(void *ctx, const unsigned char *buf, size_t len)
 {
-	int sock = POINTER_TO_INT(ctx);
 	struct net_context *context = ctx;
 	ssize_t sent;
 
-	sent = zsock_send(sock, buf, len, context->tls->flags);
+	sent = zsock_sendto_ctx(context, buf, len, context->tls->flags,
+				NULL, 0);
 	if (sent < 0) {
 		if (errno == EAGAIN) {
 			return MBEDTLS_ERR_SSL_WANT_WRITE;
@@ -557,11 +1085,11 @@ static int tls_tx(void *ctx, const unsigned char *buf, size_t len)
 
 static int tls_rx(void *ctx, unsigned char *buf, size_t len)
 {
-	int sock = POINTER_TO_INT(ctx);
 	struct net_context *context = ctx;
 	ssize_t received;
 
-	received = zsock_recv(sock, buf, len, context->tls->flags);
+	received = zsock_recvfrom_ctx(context, buf, len, context->tls->flags,
+				      NULL, 0);
 	if (received < 0) {
 		if (errno == EAGAIN) {
 			return MBEDTLS_ERR_SSL_WANT_READ;
@@ -790,6 +1318,17 @@ static int tls_mbedtls_handshake(struct net_context *context, bool block)
 		context->tls->tls_established = true;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	if (context->tls->options.cache_enabled &&
+	    context->tls->config.endpoint == MBEDTLS_SSL_IS_CLIENT) {
+		if (ret == 0) {
+			tls_session_save(context);
+		} else if (ret != -EAGAIN) {
+			tls_session_drop(context);
+		}
+	}
+#endif
+
 	return ret;
 }
 
@@ -810,6 +1349,16 @@ static int tls_mbedtls_init(struct net_context *context, bool is_server)
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 		mbedtls_ssl_set_bio(&context->tls->ssl, context,
 				    dtls_tx, NULL, dtls_rx);
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+		if (context->tls->dtls_is_listening) {
+			mbedtls_ssl_set_bio(&context->tls->ssl, context,
+					    dtls_server_tx, NULL,
+					    dtls_hello_rx);
+		} else if (context->tls->dtls_is_peer) {
+			mbedtls_ssl_set_bio(&context->tls->ssl, context,
+					    dtls_server_tx, NULL, dtls_rx);
+		}
+#endif
 #else
 		return -ENOTSUP;
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
@@ -835,18 +1384,11 @@ static int tls_mbedtls_init(struct net_context *context, bool is_server)
 
 		/* Configure cookie for DTLS server */
 		if (role == MBEDTLS_SSL_IS_SERVER) {
-			ret = mbedtls_ssl_cookie_setup(&context->tls->cookie,
-						       mbedtls_ctr_drbg_random,
-						       &tls_ctr_drbg);
-			if (ret != 0) {
-				return -ENOMEM;
+			ret = dtls_cookie_setup(context->tls);
+			if (ret < 0) {
+				return ret;
 			}
 
-			mbedtls_ssl_conf_dtls_cookies(&context->tls->config,
-						      mbedtls_ssl_cookie_write,
-						      mbedtls_ssl_cookie_check,
-						      &context->tls->cookie);
-
 			mbedtls_ssl_conf_read_timeout(
 					&context->tls->config,
 					CONFIG_NET_SOCKETS_DTLS_TIMEOUT);
@@ -881,6 +1423,10 @@ static int tls_mbedtls_init(struct net_context *context, bool is_server)
 		return ret;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	tls_session_conf(context->tls, is_server);
+#endif
+
 	ret = mbedtls_ssl_setup(&context->tls->ssl,
 				&context->tls->config);
 	if (ret != 0) {
@@ -890,6 +1436,12 @@ static int tls_mbedtls_init(struct net_context *context, bool is_server)
 		return -ENOMEM;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	if (context->tls->options.cache_enabled && !is_server) {
+		tls_session_restore(context);
+	}
+#endif
+
 	context->tls->is_initialized = true;
 
 	return 0;
@@ -1054,34 +1606,656 @@ static int tls_opt_peer_verify_set(struct net_context *context,
 		return -EINVAL;
 	}
 
-	context->tls->options.verify_level = *peer_verify;
+	context->tls->options.verify_level = *peer_verify;
+
+	return 0;
+}
+
+static int tls_opt_dtls_role_set(struct net_context *context,
+				 const void *optval, socklen_t optlen)
+{
+	int *role;
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	role = (int *)optval;
+	if (*role != MBEDTLS_SSL_IS_CLIENT &&
+	    *role != MBEDTLS_SSL_IS_SERVER) {
+		return -EINVAL;
+	}
+
+	context->tls->options.role = *role;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_set(struct net_context *context,
+				     const void *optval, socklen_t optlen)
+{
+	int *cache;
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	cache = (int *)optval;
+	if (*cache != 0 && *cache != 1) {
+		return -EINVAL;
+	}
+
+	if (*cache && !IS_ENABLED(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)) {
+		return -ENOTSUP;
+	}
+
+	context->tls->options.cache_enabled = *cache;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_get(struct net_context *context,
+				     void *optval, socklen_t *optlen)
+{
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = context->tls->options.cache_enabled;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_purge_set(struct net_context *context,
+					   const void *optval,
+					   socklen_t optlen)
+{
+	ARG_UNUSED(context);
+	ARG_UNUSED(optval);
+	ARG_UNUSED(optlen);
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	tls_session_purge();
+#endif
+
+	return 0;
+}
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+/* Fixed part of a DTLS record and handshake message header, followed by the
+ * version and random of a ClientHello.
+ */
+#define DTLS_HELLO_SESSION_ID_OFFSET (13 + 12 + 2 + 32)
+
+/* Enough for the ClientHello fields up to the cookie */
+#define DTLS_HELLO_MAX_LEN (DTLS_HELLO_SESSION_ID_OFFSET + 1 + 32 + 1 + 32)
+
+static int dtls_peer_hash(struct net_context *listener,
+			  const struct sockaddr *addr)
+{
+	u32_t hash = POINTER_TO_UINT(listener);
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && addr->sa_family == AF_INET6) {
+		hash ^= UNALIGNED_GET(&net_sin6(addr)->sin6_addr.s6_addr32[3]);
+		hash ^= net_sin6(addr)->sin6_port;
+	} else {
+		hash ^= UNALIGNED_GET(&net_sin(addr)->sin_addr.s_addr);
+		hash ^= net_sin(addr)->sin_port;
+	}
+
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+
+	return hash % CONFIG_NET_SOCKETS_DTLS_SERVER_HASH_SIZE;
+}
+
+/* Must be called with dtls_peer_lock held. */
+static struct tls_context *dtls_peer_find(struct net_context *listener,
+					  const struct sockaddr *addr)
+{
+	struct tls_context *peer;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&dtls_peers[dtls_peer_hash(listener,
+								addr)],
+				     peer, dtls_node) {
+		if (peer->dtls_listener == listener &&
+		    peer_addr_cmp(&peer->dtls_peer_addr, addr)) {
+			return peer;
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with dtls_peer_lock held. */
+static void dtls_peer_unlink(struct tls_context *peer)
+{
+	if (!peer->dtls_listener) {
+		return;
+	}
+
+	sys_slist_find_and_remove(
+		&dtls_peers[dtls_peer_hash(peer->dtls_listener,
+					   &peer->dtls_peer_addr)],
+		&peer->dtls_node);
+	peer->dtls_listener = NULL;
+}
+
+/* Detach an accepted peer from the listening socket. Further reads on the
+ * socket of the peer return end of file. Must be called with dtls_peer_lock
+ * held.
+ */
+static void dtls_peer_evict(struct tls_context *peer)
+{
+	NET_DBG("Evicting DTLS peer %p", peer);
+
+	dtls_peer_unlink(peer);
+
+	sock_set_eof(peer->dtls_context);
+	k_fifo_cancel_wait(&peer->dtls_context->recv_q);
+}
+
+/* Release a peer that was not accepted yet. */
+static void dtls_peer_free(struct tls_context *peer)
+{
+	struct net_context *context = peer->dtls_context;
+	int sock = peer->dtls_sock;
+
+	NET_DBG("Dropping DTLS peer %p", peer);
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+	dtls_peer_unlink(peer);
+	k_mutex_unlock(&dtls_peer_lock);
+
+	context->tls = NULL;
+	(void)tls_release(peer);
+	(void)zsock_close(sock);
+}
+
+static void dtls_peer_handshake(struct tls_context *peer)
+{
+	int ret;
+
+	ret = tls_mbedtls_handshake(peer->dtls_context, false);
+	if (ret == 0) {
+		NET_DBG("DTLS peer %p connected", peer);
+	} else if (ret != -EAGAIN) {
+		dtls_peer_free(peer);
+	}
+}
+
+/* Drop the least recently active peer with a handshake in progress if the
+ * backlog of the listening socket is full.
+ */
+static void dtls_peer_backlog_check(struct net_context *listener)
+{
+	struct tls_context *peer, *oldest = NULL;
+	u32_t now = k_uptime_get_32();
+	int i, count = 0;
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(tls_contexts); i++) {
+		peer = &tls_contexts[i];
+
+		if (!peer->is_used || peer->dtls_listener != listener ||
+		    peer->dtls_is_accepted) {
+			continue;
+		}
+
+		if (!oldest || now - peer->dtls_last_rx >
+			       now - oldest->dtls_last_rx) {
+			oldest = peer;
+		}
+
+		count++;
+	}
+
+	k_mutex_unlock(&dtls_peer_lock);
+
+	if (oldest && count >= listener->tls->dtls_backlog) {
+		dtls_peer_free(oldest);
+	}
+}
+
+static void dtls_peer_add(struct net_context *listener, struct net_pkt *pkt,
+			  const struct sockaddr *addr, socklen_t addrlen)
+{
+	struct net_context *context;
+	struct tls_context *peer;
+	int sock, ret;
+
+	dtls_peer_backlog_check(listener);
+
+	sock = zsock_socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		NET_WARN("No socket for DTLS peer");
+		goto drop;
+	}
+
+	context = sock_to_net_ctx(sock);
+
+	peer = tls_clone(listener->tls);
+	if (!peer) {
+		(void)zsock_close(sock);
+		goto drop;
+	}
+
+	context->tls = peer;
+	peer->dtls_context = context;
+	peer->dtls_sock = sock;
+	peer->dtls_is_peer = true;
+	peer->dtls_last_rx = k_uptime_get_32();
+
+	/* The handshake must not block the listening socket */
+	peer->flags = ZSOCK_MSG_DONTWAIT;
+
+	dtls_peer_address_set(context, addr, addrlen);
+
+	ret = tls_mbedtls_init(context, true);
+	if (ret == 0) {
+		ret = mbedtls_ssl_set_client_transport_id(
+			&peer->ssl, (const unsigned char *)addr, addrlen);
+	}
+
+	if (ret != 0) {
+		NET_WARN("Cannot set up DTLS peer (%d)", ret);
+		context->tls = NULL;
+		(void)tls_release(peer);
+		(void)zsock_close(sock);
+		goto drop;
+	}
+
+	/* The ClientHello starts the handshake of the peer */
+	k_fifo_put(&context->recv_q, pkt);
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+	peer->dtls_listener = listener;
+	sys_slist_append(&dtls_peers[dtls_peer_hash(listener, addr)],
+			 &peer->dtls_node);
+	k_mutex_unlock(&dtls_peer_lock);
+
+	NET_DBG("New DTLS peer %p", peer);
+
+	dtls_peer_handshake(peer);
+
+	return;
+
+drop:
+	net_pkt_unref(pkt);
+}
+
+/* Check if the datagram is a ClientHello with a cookie that was sent to the
+ * peer address by the listening socket.
+ */
+static bool dtls_hello_cookie_check(struct net_context *listener,
+				    struct net_pkt *pkt,
+				    const struct sockaddr *addr,
+				    socklen_t addrlen)
+{
+	u8_t buf[DTLS_HELLO_MAX_LEN];
+	u16_t header_len, len;
+	size_t pos = DTLS_HELLO_SESSION_ID_OFFSET;
+	size_t cookie_len;
+
+	header_len = net_pkt_appdata(pkt) - pkt->frags->data;
+	len = min(net_pkt_appdatalen(pkt), sizeof(buf));
+
+	if (len <= pos ||
+	    net_frag_linearize(buf, len, pkt, header_len, len) < 0 ||
+	    buf[0] != MBEDTLS_SSL_MSG_HANDSHAKE ||
+	    buf[13] != MBEDTLS_SSL_HS_CLIENT_HELLO) {
+		return false;
+	}
+
+	/* Skip the session ID */
+	pos += 1 + buf[pos];
+	if (pos >= len) {
+		return false;
+	}
+
+	cookie_len = buf[pos++];
+	if (!cookie_len || pos + cookie_len > len) {
+		return false;
+	}
+
+	return mbedtls_ssl_cookie_check(&listener->tls->cookie, buf + pos,
+					cookie_len,
+					(const unsigned char *)addr,
+					addrlen) == 0;
+}
+
+/* Answer a ClientHello without a valid cookie with a HelloVerifyRequest.
+ * Nothing is kept about the peer until it proves that it receives at its
+ * address.
+ */
+static void dtls_hello_verify(struct net_context *listener,
+			      struct net_pkt *pkt,
+			      const struct sockaddr *addr, socklen_t addrlen)
+{
+	struct tls_context *tls = listener->tls;
+	int ret;
+
+	tls->dtls_hello = pkt;
+	tls->flags = ZSOCK_MSG_DONTWAIT;
+	dtls_peer_address_set(listener, addr, addrlen);
+
+	ret = mbedtls_ssl_set_client_transport_id(
+		&tls->ssl, (const unsigned char *)addr, addrlen);
+	if (ret == 0) {
+		ret = mbedtls_ssl_handshake(&tls->ssl);
+	}
+
+	NET_DBG("ClientHello handled (-0x%x)", -ret);
+
+	if (tls->dtls_hello) {
+		net_pkt_unref(tls->dtls_hello);
+		tls->dtls_hello = NULL;
+	}
+
+	(void)tls_mbedtls_reset(listener);
+}
+
+/* Handle a datagram queued on a listening socket. */
+static void dtls_server_input(struct net_context *listener,
+			      struct net_pkt *pkt)
+{
+	struct tls_context *peer;
+	struct sockaddr addr;
+	socklen_t addrlen;
+
+	(void)memset(&addr, 0, sizeof(addr));
+
+	if (net_pkt_get_src_addr(pkt, &addr, sizeof(addr)) < 0) {
+		net_pkt_unref(pkt);
+		return;
+	}
+
+	if (addr.sa_family == AF_INET6) {
+		addrlen = sizeof(struct sockaddr_in6);
+	} else {
+		addrlen = sizeof(struct sockaddr_in);
+	}
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+	peer = dtls_peer_find(listener, &addr);
+	if (peer) {
+		peer->dtls_last_rx = k_uptime_get_32();
+		k_fifo_put(&peer->dtls_context->recv_q, pkt);
+	}
+
+	k_mutex_unlock(&dtls_peer_lock);
+
+	if (peer) {
+		if (!peer->dtls_is_accepted) {
+			dtls_peer_handshake(peer);
+		}
+	} else if (dtls_hello_cookie_check(listener, pkt, &addr, addrlen)) {
+		dtls_peer_add(listener, pkt, &addr, addrlen);
+	} else {
+		dtls_hello_verify(listener, pkt, &addr, addrlen);
+	}
+}
+
+/* Datagrams of accepted peers go directly to the socket of the peer, all
+ * the others are handled by accept() on the listening socket.
+ */
+static void dtls_server_received_cb(struct net_context *ctx,
+				    struct net_pkt *pkt, int status,
+				    void *user_data)
+{
+	struct tls_context *peer;
+	struct sockaddr addr;
+
+	if (!pkt) {
+		return;
+	}
+
+	(void)memset(&addr, 0, sizeof(addr));
+
+	if (net_pkt_get_src_addr(pkt, &addr, sizeof(addr)) < 0) {
+		net_pkt_unref(pkt);
+		return;
+	}
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+	peer = dtls_peer_find(ctx, &addr);
+	if (peer && peer->dtls_is_accepted) {
+		peer->dtls_last_rx = k_uptime_get_32();
+		k_fifo_put(&peer->dtls_context->recv_q, pkt);
+	} else {
+		k_fifo_put(&ctx->recv_q, pkt);
+	}
+
+	k_mutex_unlock(&dtls_peer_lock);
+}
+
+static s32_t dtls_timeout_min(s32_t timeout, s32_t left)
+{
+	left = max(left, 0);
+
+	return timeout == K_FOREVER ? left : min(timeout, left);
+}
+
+/* Retransmit the handshake messages of the peers and evict the idle ones.
+ * Returns the time until the next timer of a peer expires.
+ */
+static s32_t dtls_server_service(struct net_context *listener)
+{
+	struct dtls_timing_context *timing;
+	struct tls_context *peer;
+	s32_t timeout = K_FOREVER;
+	bool is_idle, is_accepted;
+	u32_t now, idle;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tls_contexts); i++) {
+		peer = &tls_contexts[i];
+
+		k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+		if (!peer->is_used || peer->dtls_listener != listener) {
+			k_mutex_unlock(&dtls_peer_lock);
+			continue;
+		}
+
+		now = k_uptime_get_32();
+		idle = now - peer->dtls_last_rx;
+		is_idle = CONFIG_NET_SOCKETS_DTLS_TIMEOUT &&
+			  idle >= CONFIG_NET_SOCKETS_DTLS_TIMEOUT;
+		is_accepted = peer->dtls_is_accepted;
+
+		if (is_idle && is_accepted) {
+			dtls_peer_evict(peer);
+		}
+
+		k_mutex_unlock(&dtls_peer_lock);
+
+		if (is_idle) {
+			if (!is_accepted) {
+				dtls_peer_free(peer);
+			}
+
+			continue;
+		}
+
+		if (CONFIG_NET_SOCKETS_DTLS_TIMEOUT) {
+			timeout = dtls_timeout_min(timeout,
+					CONFIG_NET_SOCKETS_DTLS_TIMEOUT - idle);
+		}
+
+		if (is_accepted) {
+			continue;
+		}
+
+		timing = &peer->dtls_timing;
+
+		if (dtls_timing_get_delay(timing) == 2) {
+			/* Retransmits the last flight */
+			dtls_peer_handshake(peer);
+			if (!peer->is_used || peer->dtls_listener != listener) {
+				continue;
+			}
+		}
+
+		if (timing->fin_ms) {
+			timeout = dtls_timeout_min(timeout, timing->fin_ms -
+				(k_uptime_get_32() - timing->snapshot));
+		}
+	}
+
+	return timeout;
+}
+
+/* Take a peer that completed the handshake. */
+static struct tls_context *dtls_peer_accept(struct net_context *listener)
+{
+	struct tls_context *peer;
+	int i;
+
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(tls_contexts); i++) {
+		peer = &tls_contexts[i];
+
+		if (peer->is_used && peer->dtls_listener == listener &&
+		    !peer->dtls_is_accepted && peer->tls_established) {
+			peer->dtls_is_accepted = true;
+			peer->flags = 0;
+			k_mutex_unlock(&dtls_peer_lock);
+
+			return peer;
+		}
+	}
+
+	k_mutex_unlock(&dtls_peer_lock);
+
+	return NULL;
+}
+
+static int dtls_listen(struct net_context *context, int backlog)
+{
+	struct tls_context *tls = context->tls;
+	int ret;
+
+	if (tls->options.role != MBEDTLS_SSL_IS_SERVER) {
+		return -EOPNOTSUPP;
+	}
+
+	if (!tls->dtls_is_listening) {
+		if (tls->is_initialized) {
+			return -EINVAL;
+		}
+
+		/* The TLS context of the listening socket only answers
+		 * ClientHello messages with a HelloVerifyRequest.
+		 */
+		tls->dtls_is_listening = true;
+		tls->dtls_context = context;
+
+		ret = tls_mbedtls_init(context, true);
+		if (ret < 0) {
+			tls->dtls_is_listening = false;
+			return ret;
+		}
+	}
+
+	tls->dtls_backlog = max(backlog, 1);
 
-	return 0;
+	return net_context_recv(context, dtls_server_received_cb, K_NO_WAIT,
+				context->user_data);
 }
 
-static int tls_opt_dtls_role_set(struct net_context *context,
-				 const void *optval, socklen_t optlen)
+static int dtls_accept(struct net_context *listener, struct sockaddr *addr,
+		       socklen_t *addrlen)
 {
-	int *role;
+	bool is_block = !sock_is_nonblock(listener);
+	struct tls_context *peer;
+	struct net_pkt *pkt;
+	s32_t timeout;
 
-	if (!optval) {
+	if (!listener->tls->dtls_is_listening) {
 		return -EINVAL;
 	}
 
-	if (optlen != sizeof(int)) {
-		return -EINVAL;
+	/* The handshakes of the peers progress while accept() is called */
+	while (true) {
+		timeout = dtls_server_service(listener);
+
+		peer = dtls_peer_accept(listener);
+		if (peer) {
+			break;
+		}
+
+		pkt = k_fifo_get(&listener->recv_q,
+				 is_block ? timeout : K_NO_WAIT);
+		if (pkt) {
+			dtls_server_input(listener, pkt);
+		} else if (!is_block) {
+			return -EAGAIN;
+		}
 	}
 
-	role = (int *)optval;
-	if (*role != MBEDTLS_SSL_IS_CLIENT &&
-	    *role != MBEDTLS_SSL_IS_SERVER) {
-		return -EINVAL;
+	if (addr && addrlen) {
+		dtls_peer_address_get(peer->dtls_context, addr, addrlen);
 	}
 
-	context->tls->options.role = *role;
+	return peer->dtls_sock;
+}
 
-	return 0;
+/* Close the peers of a listening socket. Accepted peers stay open until
+ * their sockets are closed, but only return end of file.
+ */
+static void dtls_server_close(struct net_context *listener)
+{
+	struct tls_context *peer;
+	bool is_pending;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tls_contexts); i++) {
+		peer = &tls_contexts[i];
+
+		k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+
+		is_pending = false;
+
+		if (peer->is_used && peer->dtls_listener == listener) {
+			if (peer->dtls_is_accepted) {
+				dtls_peer_evict(peer);
+			} else {
+				is_pending = true;
+			}
+		}
+
+		k_mutex_unlock(&dtls_peer_lock);
+
+		if (is_pending) {
+			dtls_peer_free(peer);
+		}
+	}
+}
+
+/* Called when the socket of a peer is closed or the peer closed the
+ * connection.
+ */
+static void dtls_peer_close(struct net_context *context)
+{
+	k_mutex_lock(&dtls_peer_lock, K_FOREVER);
+	dtls_peer_unlink(context->tls);
+	sock_set_eof(context);
+	k_mutex_unlock(&dtls_peer_lock);
 }
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
 
 int ztls_socket(int family, int type, int proto)
 {
@@ -1119,7 +2293,7 @@ int ztls_socket(int family, int type, int proto)
 
 	if (tls_proto != 0) {
 		/* If TLS protocol is used, allocate TLS context */
-		struct net_context *context = INT_TO_POINTER(sock);
+		struct net_context *context = sock_to_net_ctx(sock);
 
 		context->tls = tls_alloc();
 
@@ -1143,14 +2317,26 @@ error:
 
 int ztls_close(int sock)
 {
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
 	int ret, err = 0;
 
+	if (!context) {
+		return -1;
+	}
+
 	if (context->tls) {
 		/* Try to send close notification. */
 		context->tls->flags = 0;
 		(void)mbedtls_ssl_close_notify(&context->tls->ssl);
 
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+		if (context->tls->dtls_is_listening) {
+			dtls_server_close(context);
+		} else if (context->tls->dtls_is_peer) {
+			dtls_peer_close(context);
+		}
+#endif
+
 		err = tls_release(context->tls);
 	}
 
@@ -1178,7 +2364,7 @@ int ztls_bind(int sock, const struct sockaddr *addr, socklen_t addrlen)
 int ztls_connect(int sock, const struct sockaddr *addr, socklen_t addrlen)
 {
 	int ret;
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
 
 	ret = zsock_connect(sock, addr, addrlen);
 	if (ret < 0) {
@@ -1224,16 +2410,49 @@ error:
 
 int ztls_listen(int sock, int backlog)
 {
-	/* No extra action needed here. */
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+	struct net_context *context = sock_to_net_ctx(sock);
+	int ret;
+
+	if (context && context->tls &&
+	    net_context_get_type(context) == SOCK_DGRAM) {
+		ret = dtls_listen(context, backlog);
+		if (ret < 0) {
+			errno = -ret;
+			return -1;
+		}
+
+		return 0;
+	}
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
+
+	/* No extra action needed here for TLS. */
 	return zsock_listen(sock, backlog);
 }
 
 int ztls_accept(int sock, struct sockaddr *addr, socklen_t *addrlen)
 {
 	int child_sock, ret, err;
-	struct net_context *parent_context = INT_TO_POINTER(sock);
+	struct net_context *parent_context = sock_to_net_ctx(sock);
 	struct net_context *child_context = NULL;
 
+	if (!parent_context) {
+		return -1;
+	}
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+	if (parent_context->tls &&
+	    net_context_get_type(parent_context) == SOCK_DGRAM) {
+		child_sock = dtls_accept(parent_context, addr, addrlen);
+		if (child_sock < 0) {
+			errno = -child_sock;
+			return -1;
+		}
+
+		return child_sock;
+	}
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
+
 	child_sock = zsock_accept(sock, addr, addrlen);
 	if (child_sock < 0) {
 		/* errno will be propagated */
@@ -1241,7 +2460,7 @@ int ztls_accept(int sock, struct sockaddr *addr, socklen_t *addrlen)
 	}
 
 	if (parent_context->tls) {
-		child_context = INT_TO_POINTER(child_sock);
+		child_context = sock_to_net_ctx(child_sock);
 
 		child_context->tls = tls_clone(parent_context->tls);
 		if (!child_context->tls) {
@@ -1387,7 +2606,11 @@ static ssize_t sendto_dtls_server(struct net_context *context, const void *buf,
 ssize_t ztls_sendto(int sock, const void *buf, size_t len, int flags,
 		    const struct sockaddr *dest_addr, socklen_t addrlen)
 {
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
+
+	if (!context) {
+		return -1;
+	}
 
 	if (!context->tls) {
 		return zsock_sendto(sock, buf, len, flags, dest_addr, addrlen);
@@ -1403,6 +2626,12 @@ ssize_t ztls_sendto(int sock, const void *buf, size_t len, int flags,
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	/* DTLS */
 	if (context->tls->options.role == MBEDTLS_SSL_IS_SERVER) {
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+		if (context->tls->dtls_is_peer && sock_is_eof(context)) {
+			errno = ECONNRESET;
+			return -1;
+		}
+#endif
 		return sendto_dtls_server(context, buf, len, flags,
 					  dest_addr, addrlen);
 	}
@@ -1573,12 +2802,65 @@ error:
 	errno = -ret;
 	return -1;
 }
+
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+static ssize_t recvfrom_dtls_peer(struct net_context *context, void *buf,
+				  size_t max_len, int flags,
+				  struct sockaddr *src_addr,
+				  socklen_t *addrlen)
+{
+	int ret;
+
+	/* Closed by the peer, or evicted by the listening socket */
+	if (sock_is_eof(context)) {
+		return 0;
+	}
+
+	ret = mbedtls_ssl_read(&context->tls->ssl, buf, max_len);
+	if (ret >= 0) {
+		if (src_addr && addrlen) {
+			dtls_peer_address_get(context, src_addr, addrlen);
+		}
+		return ret;
+	}
+
+	switch (ret) {
+	case MBEDTLS_ERR_SSL_TIMEOUT:
+		(void)mbedtls_ssl_close_notify(&context->tls->ssl);
+		/* fallthrough */
+
+	case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY:
+		dtls_peer_close(context);
+		return 0;
+
+	case MBEDTLS_ERR_SSL_WANT_READ:
+	case MBEDTLS_ERR_SSL_WANT_WRITE:
+		if (sock_is_eof(context)) {
+			return 0;
+		}
+
+		ret = -EAGAIN;
+		break;
+
+	default:
+		ret = -EIO;
+		break;
+	}
+
+	errno = -ret;
+	return -1;
+}
+#endif /* CONFIG_NET_SOCKETS_DTLS_SERVER */
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
 ssize_t ztls_recvfrom(int sock, void *buf, size_t max_len, int flags,
 		      struct sockaddr *src_addr, socklen_t *addrlen)
 {
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
+
+	if (!context) {
+		return -1;
+	}
 
 	if (!context->tls) {
 		return zsock_recvfrom(sock, buf, max_len, flags,
@@ -1603,6 +2885,17 @@ ssize_t ztls_recvfrom(int sock, void *buf, size_t max_len, int flags,
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	/* DTLS */
 	if (context->tls->options.role == MBEDTLS_SSL_IS_SERVER) {
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+		if (context->tls->dtls_is_peer) {
+			return recvfrom_dtls_peer(context, buf, max_len, flags,
+						  src_addr, addrlen);
+		}
+
+		if (context->tls->dtls_is_listening) {
+			errno = ENOTCONN;
+			return -1;
+		}
+#endif
 		return recvfrom_dtls_server(context, buf, max_len, flags,
 					    src_addr, addrlen);
 	}
@@ -1615,12 +2908,277 @@ ssize_t ztls_recvfrom(int sock, void *buf, size_t max_len, int flags,
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 }
 
+/* Copies the data of the message from iov[*i] + *offset into buf, up to
+ * len bytes, and moves past what was copied.
+ */
+static size_t sendmsg_gather(const struct zsock_msghdr *msg, size_t *i,
+			     size_t *offset, u8_t *buf, size_t len)
+{
+	size_t chunk, gathered = 0;
+
+	while (*i < msg->msg_iovlen && gathered < len) {
+		const struct zsock_iovec *iov = &msg->msg_iov[*i];
+
+		chunk = min(iov->iov_len - *offset, len - gathered);
+		memcpy(buf + gathered, (u8_t *)iov->iov_base + *offset, chunk);
+		gathered += chunk;
+		*offset += chunk;
+
+		if (*offset == iov->iov_len) {
+			(*i)++;
+			*offset = 0;
+		}
+	}
+
+	return gathered;
+}
+
+static ssize_t sendmsg_tls(struct tls_context *tls, int sock,
+			   const struct zsock_msghdr *msg, int flags)
+{
+	size_t i = 0, offset = 0, len;
+	ssize_t ret, sent = 0;
+
+	if (msg->msg_iovlen == 1) {
+		return ztls_send(sock, msg->msg_iov[0].iov_base,
+				 msg->msg_iov[0].iov_len, flags);
+	}
+
+	/* Small buffers, like a header, do not get a record of their own */
+	while (i < msg->msg_iovlen) {
+		len = sendmsg_gather(msg, &i, &offset, tls->sendmsg_buf,
+				     sizeof(tls->sendmsg_buf));
+		if (!len) {
+			break;
+		}
+
+		ret = ztls_send(sock, tls->sendmsg_buf, len, flags);
+		if (ret < 0) {
+			return sent ? sent : -1;
+		}
+
+		sent += ret;
+
+		if (ret < len) {
+			break;
+		}
+	}
+
+	return sent;
+}
+
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
+/* A DTLS message has to be sent as one record */
+static ssize_t sendmsg_dtls(struct tls_context *tls, int sock,
+			    const struct zsock_msghdr *msg, int flags)
+{
+	size_t i = 0, offset = 0, len;
+
+	if (msg->msg_iovlen == 1) {
+		return ztls_sendto(sock, msg->msg_iov[0].iov_base,
+				   msg->msg_iov[0].iov_len, flags,
+				   msg->msg_name, msg->msg_namelen);
+	}
+
+	len = sendmsg_gather(msg, &i, &offset, tls->sendmsg_buf,
+			     sizeof(tls->sendmsg_buf));
+
+	/* Skip the empty buffers left, anything else does not fit */
+	while (i < msg->msg_iovlen && !msg->msg_iov[i].iov_len) {
+		i++;
+	}
+
+	if (i < msg->msg_iovlen) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+
+	return ztls_sendto(sock, tls->sendmsg_buf, len, flags,
+			   msg->msg_name, msg->msg_namelen);
+}
+#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
+
+ssize_t ztls_sendmsg(int sock, const struct zsock_msghdr *msg, int flags)
+{
+	struct net_context *context = sock_to_net_ctx(sock);
+
+	if (!context) {
+		return -1;
+	}
+
+	if (!context->tls) {
+		return zsock_sendmsg(sock, msg, flags);
+	}
+
+	/* TLS */
+	if (net_context_get_type(context) == SOCK_STREAM) {
+		return sendmsg_tls(context->tls, sock, msg, flags);
+	}
+
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
+	/* DTLS */
+	return sendmsg_dtls(context->tls, sock, msg, flags);
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
+}
+
+ssize_t ztls_recvmsg(int sock, struct zsock_msghdr *msg, int flags)
+{
+	struct net_context *context = sock_to_net_ctx(sock);
+	socklen_t addrlen = msg->msg_namelen;
+	mbedtls_ssl_context *ssl;
+	ssize_t len, received;
+	size_t i = 0;
+
+	if (!context) {
+		return -1;
+	}
+
+	if (!context->tls) {
+		return zsock_recvmsg(sock, msg, flags);
+	}
+
+	msg->msg_flags = 0;
+	msg->msg_controllen = 0;
+
+	while (i < msg->msg_iovlen && !msg->msg_iov[i].iov_len) {
+		i++;
+	}
+
+	if (i == msg->msg_iovlen) {
+		return 0;
+	}
+
+	/* The first buffer goes through the usual receive path, which waits
+	 * for a record and reports the DTLS peer address.
+	 */
+	received = ztls_recvfrom(sock, msg->msg_iov[i].iov_base,
+				 msg->msg_iov[i].iov_len, flags,
+				 msg->msg_name, msg->msg_name ? &addrlen : NULL);
+	if (received <= 0) {
+		return received;
+	}
+
+	if (net_context_get_type(context) == SOCK_STREAM) {
+		msg->msg_namelen = 0;
+	} else if (msg->msg_name) {
+		msg->msg_namelen = addrlen;
+	}
+
+	/* The rest of the record is already decrypted */
+	ssl = &context->tls->ssl;
+
+	for (i++; i < msg->msg_iovlen && mbedtls_ssl_get_bytes_avail(ssl);
+	     i++) {
+		if (!msg->msg_iov[i].iov_len) {
+			continue;
+		}
+
+		len = mbedtls_ssl_read(ssl, msg->msg_iov[i].iov_base,
+				       msg->msg_iov[i].iov_len);
+		if (len <= 0) {
+			break;
+		}
+
+		received += len;
+	}
+
+	/* A datagram is a single record, what did not fit is dropped */
+	if (net_context_get_type(context) == SOCK_DGRAM &&
+	    mbedtls_ssl_get_bytes_avail(ssl)) {
+		u8_t discard[32];
+
+		while (mbedtls_ssl_get_bytes_avail(ssl) &&
+		       mbedtls_ssl_read(ssl, discard, sizeof(discard)) > 0) {
+		}
+
+		msg->msg_flags |= ZSOCK_MSG_TRUNC;
+	}
+
+	return received;
+}
+
+int ztls_sendmmsg(int sock, struct zsock_mmsghdr *msgvec, unsigned int vlen,
+		  int flags)
+{
+	struct net_context *context = sock_to_net_ctx(sock);
+	unsigned int i;
+	ssize_t len;
+
+	if (!context) {
+		return -1;
+	}
+
+	if (!context->tls) {
+		return zsock_sendmmsg(sock, msgvec, vlen, flags);
+	}
+
+	/* Each message is encrypted on its own */
+	for (i = 0; i < vlen; i++) {
+		len = ztls_sendmsg(sock, &msgvec[i].msg_hdr, flags);
+		if (len < 0) {
+			return i ? i : -1;
+		}
+
+		msgvec[i].msg_len = len;
+	}
+
+	return i;
+}
+
+int ztls_recvmmsg(int sock, struct zsock_mmsghdr *msgvec, unsigned int vlen,
+		  int flags)
+{
+	struct net_context *context = sock_to_net_ctx(sock);
+	unsigned int i;
+	ssize_t len;
+
+	if (!context) {
+		return -1;
+	}
+
+	if (!context->tls) {
+		return zsock_recvmmsg(sock, msgvec, vlen, flags);
+	}
+
+	for (i = 0; i < vlen; i++) {
+		/* Only wait for the first message */
+		len = ztls_recvmsg(sock, &msgvec[i].msg_hdr,
+				   i ? flags | ZSOCK_MSG_DONTWAIT : flags);
+		if (len < 0) {
+			return i ? i : -1;
+		}
+
+		msgvec[i].msg_len = len;
+
+		/* End of stream */
+		if (len == 0 && net_context_get_type(context) == SOCK_STREAM) {
+			return i + 1;
+		}
+	}
+
+	return i;
+}
+
 int ztls_fcntl(int sock, int cmd, int flags)
 {
 	/* No extra action needed here. */
 	return zsock_fcntl(sock, cmd, flags);
 }
 
+static bool tls_is_listening(struct net_context *context)
+{
+#if defined(CONFIG_NET_SOCKETS_DTLS_SERVER)
+	if (context->tls->dtls_is_listening) {
+		return true;
+	}
+#endif
+
+	return IS_LISTENING(context);
+}
+
 int ztls_poll(struct zsock_pollfd *fds, int nfds, int timeout)
 {
 	bool retry = true;
@@ -1639,8 +3197,9 @@ int ztls_poll(struct zsock_pollfd *fds, int nfds, int timeout)
 		}
 
 		if (pfd->events & ZSOCK_POLLIN) {
-			context = INT_TO_POINTER(pfd->fd);
-			if (!context->tls || IS_LISTENING(context)) {
+			context = sock_to_net_ctx(pfd->fd);
+			if (!context || !context->tls ||
+			    tls_is_listening(context)) {
 				continue;
 			}
 
@@ -1676,8 +3235,9 @@ int ztls_poll(struct zsock_pollfd *fds, int nfds, int timeout)
 			}
 
 			if (pfd->events & ZSOCK_POLLIN) {
-				context = INT_TO_POINTER(pfd->fd);
-				if (!context->tls || IS_LISTENING(context)) {
+				context = sock_to_net_ctx(pfd->fd);
+				if (!context || !context->tls ||
+				    tls_is_listening(context)) {
 					continue;
 				}
 
@@ -1735,7 +3295,7 @@ int ztls_getsockopt(int sock, int level, int optname,
 		    void *optval, socklen_t *optlen)
 {
 	int err;
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
 
 	if (level != SOL_TLS) {
 		return zsock_getsockopt(sock, level, optname, optval, optlen);
@@ -1762,6 +3322,10 @@ int ztls_getsockopt(int sock, int level, int optname,
 		err = tls_opt_ciphersuite_used_get(context, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_get(context, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or write-only option. */
 		err = -ENOPROTOOPT;
@@ -1780,7 +3344,7 @@ int ztls_setsockopt(int sock, int level, int optname,
 		    const void *optval, socklen_t optlen)
 {
 	int err;
-	struct net_context *context = INT_TO_POINTER(sock);
+	struct net_context *context = sock_to_net_ctx(sock);
 
 	if (level != SOL_TLS) {
 		return zsock_setsockopt(sock, level, optname, optval, optlen);
@@ -1811,6 +3375,14 @@ int ztls_setsockopt(int sock, int level, int optname,
 		err = tls_opt_dtls_role_set(context, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_set(context, optval, optlen);
+		break;
+
+	case TLS_SESSION_CACHE_PURGE:
+		err = tls_opt_session_cache_purge_set(context, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or read-only option. */
 		err = -ENOPROTOOPT;
@@ -0,0 +1,548 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_CAPTURE_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <misc/byteorder.h>
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/net_context.h>
+#include <net/capture.h>
+
+#include "net_private.h"
+
+#define SRC_PORT 4242
+#define DST_PORT 5353
+#define OTHER_PORT 5354
+
+/* IPv4 and UDP headers */
+#define HDR_LEN 28
+
+#define SNAPLEN CONFIG_NET_CAPTURE_SNAPLEN
+
+/* Number of captures of the benchmark */
+#define CAPTURES 1000
+
+#define PCAPNG_SHB 0x0a0d0d0a
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define LINKTYPE_RAW 101
+
+static struct net_if *iface;
+static struct net_context *ctx;
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr peer_addr = { { { 192, 0, 2, 2 } } };
+static struct in_addr netmask = { { { 255, 255, 255, 0 } } };
+
+/* The sent packets are received back when set */
+static bool loop_back;
+
+static u8_t payload[200];
+
+static u8_t export_buf[CONFIG_NET_CAPTURE_BUF_SIZE * 2];
+static size_t export_len;
+
+/* Content of the last export */
+struct epb_info {
+	u32_t iface;
+	u32_t caplen;
+	u32_t orig_len;
+	u32_t flags;
+	u64_t time;
+	const u8_t *data;
+};
+
+static struct epb_info epbs[CONFIG_NET_CAPTURE_BUF_SIZE / 16];
+static int epb_count;
+static int idb_count;
+
+static u8_t mac_addr[sizeof(struct net_eth_addr)] = {
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	0x00, 0x00, 0x5E, 0x00, 0x53, 0x01
+};
+
+static int capture_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void capture_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	struct net_pkt *rx;
+
+	if (loop_back) {
+		rx = net_pkt_clone(pkt, K_NO_WAIT);
+		if (rx) {
+			net_pkt_set_iface(rx, iface);
+
+			if (net_recv_data(iface, rx) < 0) {
+				net_pkt_unref(rx);
+			}
+		}
+	}
+
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api capture_if_api = {
+	.init = capture_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(capture_test, "capture_test",
+		capture_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&capture_if_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static void send_udp(u16_t port, size_t len)
+{
+	struct sockaddr_in dst;
+	struct net_pkt *pkt;
+	int ret;
+
+	dst.sin_family = AF_INET;
+	dst.sin_port = htons(port);
+	net_ipaddr_copy(&dst.sin_addr, &peer_addr);
+
+	pkt = net_pkt_get_tx(ctx, K_SECONDS(1));
+	zassert_not_null(pkt, "Cannot get packet");
+
+	zassert_true(net_pkt_append_all(pkt, len, payload, K_SECONDS(1)),
+		     "Cannot append data");
+
+	ret = net_context_sendto(pkt, (struct sockaddr *)&dst, sizeof(dst),
+				 NULL, K_NO_WAIT, NULL, NULL);
+	zassert_equal(ret, 0, "Cannot send (%d)", ret);
+
+	/* Let the TX and RX threads handle the packet */
+	k_sleep(K_MSEC(10));
+}
+
+static int export_cb(const void *data, size_t len, void *user_data)
+{
+	if (export_len + len > sizeof(export_buf)) {
+		return -ENOMEM;
+	}
+
+	memcpy(export_buf + export_len, data, len);
+	export_len += len;
+
+	return 0;
+}
+
+static u32_t get32(size_t offset)
+{
+	return sys_get_le32(export_buf + offset);
+}
+
+/* Exports the capture and checks the structure of the pcapng blocks */
+static int export(void)
+{
+	size_t offset, len;
+	struct epb_info *epb;
+	int ret;
+
+	export_len = 0;
+	epb_count = 0;
+	idb_count = 0;
+
+	ret = net_capture_export(export_cb, NULL);
+	zassert_true(ret >= 0, "Cannot export (%d)", ret);
+
+	zassert_true(export_len >= 28, "No section header");
+	zassert_equal(get32(0), PCAPNG_SHB, "Invalid section header");
+	zassert_equal(get32(8), 0x1a2b3c4d, "Invalid byte order magic");
+
+	for (offset = 0; offset < export_len; offset += len) {
+		len = get32(offset + 4);
+
+		zassert_true(len >= 12 && len % 4 == 0 &&
+			     offset + len <= export_len,
+			     "Invalid block length %u", len);
+		zassert_equal(get32(offset + len - 4), len,
+			      "Invalid trailing block length");
+
+		switch (get32(offset)) {
+		case PCAPNG_IDB:
+			if (idb_count == net_if_get_by_iface(iface)) {
+				zassert_equal(get32(offset + 8) & 0xffff,
+					      LINKTYPE_RAW,
+					      "Invalid link type");
+				zassert_equal(get32(offset + 12), SNAPLEN,
+					      "Invalid snapshot length");
+			}
+
+			idb_count++;
+			break;
+
+		case PCAPNG_EPB:
+			zassert_true(epb_count < ARRAY_SIZE(epbs),
+				     "Too many packets");
+
+			epb = &epbs[epb_count++];
+			epb->iface = get32(offset + 8);
+			epb->time = (u64_t)get32(offset + 12) << 32 |
+				get32(offset + 16);
+			epb->caplen = get32(offset + 20);
+			epb->orig_len = get32(offset + 24);
+			epb->data = export_buf + offset + 28;
+
+			zassert_equal(len, 44 + ROUND_UP(epb->caplen, 4),
+				      "Invalid packet block length");
+			zassert_equal(get32(offset + len - 16),
+				      2 | 4 << 16, "No flags option");
+
+			epb->flags = get32(offset + len - 12);
+			break;
+		}
+	}
+
+	zassert_equal(epb_count, ret, "Wrong number of packets");
+
+	return ret;
+}
+
+static void test_init(void)
+{
+	struct sockaddr_in addr;
+
+	iface = net_if_get_default();
+	zassert_not_null(iface, "No interface");
+
+	net_if_ipv4_set_netmask(iface, &netmask);
+	zassert_not_null(net_if_ipv4_addr_add(iface, &my_addr,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add address");
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SRC_PORT);
+	net_ipaddr_copy(&addr.sin_addr, &my_addr);
+
+	zassert_equal(net_context_get(AF_INET, SOCK_DGRAM, IPPROTO_UDP, &ctx),
+		      0, "Cannot get context");
+	zassert_equal(net_context_bind(ctx, (struct sockaddr *)&addr,
+				       sizeof(addr)), 0, "Cannot bind");
+}
+
+static void test_capture(void)
+{
+	struct net_capture_stats before, after;
+	int i;
+
+	net_capture_get_stats(&before);
+
+	/* Not captured */
+	send_udp(DST_PORT, 10);
+
+	loop_back = true;
+
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_RX |
+					NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	zassert_true(net_capture_is_active(), "Not started");
+
+	send_udp(DST_PORT, 10);
+	send_udp(DST_PORT, 20);
+
+	net_capture_stop();
+	zassert_false(net_capture_is_active(), "Not stopped");
+
+	loop_back = false;
+
+	/* Not captured */
+	send_udp(DST_PORT, 10);
+
+	net_capture_get_stats(&after);
+	zassert_equal(after.captured - before.captured, 4,
+		      "Wrong number of captured packets");
+
+	zassert_equal(export(), 4, "Wrong number of exported packets");
+	zassert_true(idb_count > net_if_get_by_iface(iface),
+		     "Interface not described");
+
+	for (i = 0; i < epb_count; i++) {
+		zassert_equal(epbs[i].iface, net_if_get_by_iface(iface),
+			      "Wrong interface");
+		zassert_equal(epbs[i].orig_len, HDR_LEN + (i < 2 ? 10 : 20),
+			      "Wrong length");
+		zassert_equal(epbs[i].caplen, epbs[i].orig_len,
+			      "Wrong captured length");
+		zassert_equal(epbs[i].data[0], 0x45, "Not an IPv4 packet");
+		zassert_equal(sys_get_be16(epbs[i].data + 22), DST_PORT,
+			      "Wrong destination port");
+		zassert_false(memcmp(epbs[i].data + HDR_LEN, payload,
+				     epbs[i].caplen - HDR_LEN),
+			      "Wrong data");
+
+		if (i) {
+			zassert_true(epbs[i].time >= epbs[i - 1].time,
+				     "Time went backwards");
+		}
+	}
+
+	/* Each packet is sent, then received */
+	zassert_equal(epbs[0].flags, 2, "Packet not outbound");
+	zassert_equal(epbs[1].flags, 1, "Packet not inbound");
+	zassert_equal(epbs[2].flags, 2, "Packet not outbound");
+	zassert_equal(epbs[3].flags, 1, "Packet not inbound");
+
+	/* The exported packets are removed */
+	zassert_equal(export(), 0, "Packets exported twice");
+}
+
+static void test_direction(void)
+{
+	loop_back = true;
+
+	zassert_equal(net_capture_start(NULL, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	send_udp(DST_PORT, 10);
+	net_capture_stop();
+
+	loop_back = false;
+
+	zassert_equal(export(), 1, "Wrong number of exported packets");
+	zassert_equal(epbs[0].flags, 2, "Packet not outbound");
+
+	zassert_equal(net_capture_start(NULL, 0), -EINVAL,
+		      "Started without direction");
+}
+
+static void test_filter(void)
+{
+	/* udp dst port 5353, as compiled by "tcpdump -d" for a raw IP
+	 * link.
+	 */
+	static const struct net_capture_insn prog[] = {
+		NET_CAPTURE_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+		NET_CAPTURE_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 4),
+		NET_CAPTURE_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+		NET_CAPTURE_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+		NET_CAPTURE_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DST_PORT, 0, 1),
+		NET_CAPTURE_STMT(BPF_RET | BPF_K, 0xffff),
+		NET_CAPTURE_STMT(BPF_RET | BPF_K, 0),
+	};
+	/* Jumps past the end */
+	static const struct net_capture_insn bad_jump[] = {
+		NET_CAPTURE_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 1),
+		NET_CAPTURE_STMT(BPF_RET | BPF_K, 0),
+	};
+	/* Does not end with a return */
+	static const struct net_capture_insn no_ret[] = {
+		NET_CAPTURE_STMT(BPF_RET | BPF_K, 0),
+		NET_CAPTURE_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+	};
+	/* Divides by zero */
+	static const struct net_capture_insn div_zero[] = {
+		NET_CAPTURE_STMT(BPF_ALU | BPF_DIV | BPF_K, 0),
+		NET_CAPTURE_STMT(BPF_RET | BPF_A, 0),
+	};
+	/* Reads past the end of the packets */
+	static const struct net_capture_insn past_end[] = {
+		NET_CAPTURE_STMT(BPF_LD | BPF_W | BPF_ABS, 1000),
+		NET_CAPTURE_STMT(BPF_RET | BPF_K, 0xffff),
+	};
+	struct net_capture_stats before, after;
+
+	zassert_equal(net_capture_set_filter(bad_jump, ARRAY_SIZE(bad_jump)),
+		      -EINVAL, "Invalid jump accepted");
+	zassert_equal(net_capture_set_filter(no_ret, ARRAY_SIZE(no_ret)),
+		      -EINVAL, "Missing return accepted");
+	zassert_equal(net_capture_set_filter(div_zero, ARRAY_SIZE(div_zero)),
+		      -EINVAL, "Division by zero accepted");
+	zassert_equal(net_capture_set_filter(prog,
+					     CONFIG_NET_CAPTURE_FILTER_LEN + 1),
+		      -ENOMEM, "Too long filter accepted");
+
+	zassert_equal(net_capture_set_filter(prog, ARRAY_SIZE(prog)), 0,
+		      "Cannot set filter");
+
+	net_capture_get_stats(&before);
+
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+
+	zassert_equal(net_capture_set_filter(NULL, 0), -EBUSY,
+		      "Filter changed while capturing");
+
+	send_udp(OTHER_PORT, 10);
+	send_udp(DST_PORT, 10);
+	send_udp(OTHER_PORT, 10);
+
+	net_capture_stop();
+
+	net_capture_get_stats(&after);
+	zassert_equal(after.filtered - before.filtered, 2,
+		      "Wrong number of filtered packets");
+
+	zassert_equal(export(), 1, "Wrong number of exported packets");
+	zassert_equal(sys_get_be16(epbs[0].data + 22), DST_PORT,
+		      "Wrong packet captured");
+
+	/* The reads past the end reject the packets */
+	zassert_equal(net_capture_set_filter(past_end, ARRAY_SIZE(past_end)),
+		      0, "Cannot set filter");
+
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	send_udp(DST_PORT, 10);
+	net_capture_stop();
+
+	zassert_equal(export(), 0, "Packet captured");
+
+	zassert_equal(net_capture_set_filter(NULL, 0), 0,
+		      "Cannot remove filter");
+}
+
+static void test_snaplen(void)
+{
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	send_udp(DST_PORT, sizeof(payload));
+	net_capture_stop();
+
+	zassert_equal(export(), 1, "Wrong number of exported packets");
+	zassert_equal(epbs[0].caplen, SNAPLEN, "Packet not truncated");
+	zassert_equal(epbs[0].orig_len, HDR_LEN + sizeof(payload),
+		      "Wrong original length");
+	zassert_false(memcmp(epbs[0].data + HDR_LEN, payload,
+			     SNAPLEN - HDR_LEN), "Wrong data");
+}
+
+static void test_overflow(void)
+{
+	struct net_capture_stats before, after;
+	int count, i;
+
+	/* More packets than the buffer holds */
+	count = CONFIG_NET_CAPTURE_BUF_SIZE / (16 + SNAPLEN) + 5;
+
+	net_capture_get_stats(&before);
+
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+
+	for (i = 0; i < count; i++) {
+		send_udp(DST_PORT, sizeof(payload));
+	}
+
+	net_capture_stop();
+
+	net_capture_get_stats(&after);
+	zassert_true(after.dropped > before.dropped, "No packet dropped");
+	zassert_equal(after.captured - before.captured +
+		      after.dropped - before.dropped, count,
+		      "Packets lost");
+
+	zassert_equal(export(), after.captured - before.captured,
+		      "Wrong number of exported packets");
+
+	/* The buffer can be used again */
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	send_udp(DST_PORT, 10);
+	net_capture_stop();
+
+	zassert_equal(export(), 1, "Wrong number of exported packets");
+
+	/* And be cleared */
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+	send_udp(DST_PORT, 10);
+	net_capture_stop();
+
+	net_capture_clear();
+	zassert_equal(export(), 0, "Packets not cleared");
+}
+
+static void test_bench(void)
+{
+	u32_t start, cycles;
+	struct net_pkt *pkt;
+	int i;
+
+	pkt = net_pkt_get_reserve_tx(0, K_SECONDS(1));
+	zassert_not_null(pkt, "Cannot get packet");
+
+	zassert_true(net_pkt_append_all(pkt, sizeof(payload), payload,
+					K_SECONDS(1)), "Cannot append data");
+
+	/* Disabled, as done for every packet */
+	start = k_cycle_get_32();
+
+	for (i = 0; i < CAPTURES; i++) {
+		net_capture_tx(iface, pkt);
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("Capture stopped: %u cycles per packet\n",
+		 cycles / CAPTURES);
+
+	zassert_equal(net_capture_start(iface, NET_CAPTURE_TX), 0,
+		      "Cannot start");
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < CAPTURES; i++) {
+		net_capture_tx(iface, pkt);
+
+		if (i % 8 == 7) {
+			net_capture_clear();
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	net_capture_stop();
+	net_capture_clear();
+
+	TC_PRINT("Capture started: %u cycles per packet of %u bytes\n",
+		 cycles / CAPTURES, SNAPLEN);
+
+	net_pkt_unref(pkt);
+}
+
+void test_main(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	ztest_test_suite(capture,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_capture),
+			 ztest_unit_test(test_direction),
+			 ztest_unit_test(test_filter),
+			 ztest_unit_test(test_snaplen),
+			 ztest_unit_test(test_overflow),
+			 ztest_unit_test(test_bench));
+
+	ztest_run_test_suite(capture);
+}
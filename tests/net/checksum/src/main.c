@@ -0,0 +1,280 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_UTILS_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+#include <random/rand32.h>
+
+#include <tc_util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+
+#include "net_private.h"
+
+#define MAX_PAYLOAD 1500
+#define ROUNDS 64
+#define BENCH_ROUNDS 256
+
+/* Stop scattering the data after this many fragments so that the
+ * buffer pool is not exhausted.
+ */
+#define MAX_SCATTER_FRAGS 24
+
+static struct in6_addr src_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr dst_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static u8_t payload[MAX_PAYLOAD];
+
+/* The straightforward RFC 1071 checksum, one 16-bit word at a time */
+static u16_t ref_sum(u16_t sum, const u8_t *ptr, u16_t len)
+{
+	const u8_t *end = ptr + len - 1;
+	u16_t tmp;
+
+	while (ptr < end) {
+		tmp = (ptr[0] << 8) + ptr[1];
+		sum += tmp;
+		if (sum < tmp) {
+			sum++;
+		}
+
+		ptr += 2;
+	}
+
+	if (ptr == end) {
+		tmp = ptr[0] << 8;
+		sum += tmp;
+		if (sum < tmp) {
+			sum++;
+		}
+	}
+
+	return sum;
+}
+
+static u16_t ref_chksum_udp(const u8_t *data, u16_t len)
+{
+	u16_t sum;
+
+	sum = ref_sum(len + IPPROTO_UDP, src_addr.s6_addr,
+		      sizeof(struct in6_addr));
+	sum = ref_sum(sum, dst_addr.s6_addr, sizeof(struct in6_addr));
+	sum = ref_sum(sum, data, len);
+
+	return (sum == 0) ? 0xffff : htons(sum);
+}
+
+static void fill_random(u8_t *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		data[i] = sys_rand32_get();
+	}
+}
+
+/* Build an IPv6 packet with the given upper layer data. If scatter is set,
+ * the data is split to fragments of random length that start at random
+ * alignment.
+ */
+static struct net_pkt *build_pkt(const u8_t *data, u16_t len, bool scatter)
+{
+	struct net_buf *frag;
+	bool new_frag = false;
+	struct net_pkt *pkt;
+	int frags = 1;
+
+	pkt = net_pkt_get_reserve_tx(0, K_SECONDS(1));
+	zassert_not_null(pkt, "Out of mem");
+
+	frag = net_pkt_get_frag(pkt, K_SECONDS(1));
+	zassert_not_null(frag, "Out of mem");
+
+	net_pkt_frag_add(pkt, frag);
+	net_pkt_set_family(pkt, AF_INET6);
+	net_pkt_set_ip_hdr_len(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_set_ipv6_ext_len(pkt, 0);
+
+	net_buf_add(frag, sizeof(struct net_ipv6_hdr));
+
+	NET_IPV6_HDR(pkt)->vtc = 0x60;
+	NET_IPV6_HDR(pkt)->tcflow = 0;
+	NET_IPV6_HDR(pkt)->flow = 0;
+	NET_IPV6_HDR(pkt)->len = htons(len);
+	NET_IPV6_HDR(pkt)->nexthdr = IPPROTO_UDP;
+	NET_IPV6_HDR(pkt)->hop_limit = 255;
+
+	net_ipaddr_copy(&NET_IPV6_HDR(pkt)->src, &src_addr);
+	net_ipaddr_copy(&NET_IPV6_HDR(pkt)->dst, &dst_addr);
+
+	while (len) {
+		size_t chunk;
+
+		if (!net_buf_tailroom(frag) || new_frag) {
+			frag = net_pkt_get_frag(pkt, K_SECONDS(1));
+			zassert_not_null(frag, "Out of mem");
+
+			if (scatter) {
+				net_buf_reserve(frag, sys_rand32_get() % 4);
+			}
+
+			net_pkt_frag_add(pkt, frag);
+			frags++;
+		}
+
+		chunk = min(len, net_buf_tailroom(frag));
+
+		new_frag = scatter && frags < MAX_SCATTER_FRAGS;
+		if (new_frag) {
+			chunk = min(chunk, 1 + sys_rand32_get() % 64);
+		}
+
+		net_buf_add_mem(frag, data, chunk);
+		data += chunk;
+		len -= chunk;
+	}
+
+	return pkt;
+}
+
+static void test_chksum(void)
+{
+	struct net_pkt *pkt;
+	int i;
+
+	for (i = 0; i < ROUNDS; i++) {
+		u16_t len = sys_rand32_get() % 512;
+		bool scatter = i % 2;
+
+		fill_random(payload, len);
+
+		/* Exercise the carries with all ones data */
+		if (i % 8 == 7) {
+			memset(payload, 0xff, len);
+		}
+
+		pkt = build_pkt(payload, len, scatter);
+
+		zassert_equal(net_calc_chksum_udp(pkt),
+			      ref_chksum_udp(payload, len),
+			      "Checksum mismatch, len %u%s", len,
+			      scatter ? " scattered" : "");
+
+		net_pkt_unref(pkt);
+	}
+}
+
+static bool chksum_equal(u16_t a, u16_t b)
+{
+	/* Both zeros of one's complement arithmetic are valid */
+	return a == b || ((a == 0 || a == 0xffff) && (b == 0 || b == 0xffff));
+}
+
+static void test_chksum_update(void)
+{
+	struct net_pkt *pkt;
+	u16_t chksum, old16, new16;
+	u32_t old32, new32;
+	int i;
+
+	for (i = 0; i < ROUNDS; i++) {
+		u16_t len = 8 + 2 * (sys_rand32_get() % 200);
+		u16_t off = 2 * (sys_rand32_get() % ((len - 4) / 2));
+
+		fill_random(payload, len);
+
+		chksum = ~ref_chksum_udp(payload, len);
+
+		memcpy(&old16, &payload[off], sizeof(old16));
+		new16 = sys_rand32_get();
+		memcpy(&payload[off], &new16, sizeof(new16));
+
+		chksum = net_chksum_update_u16(chksum, old16, new16);
+
+		pkt = build_pkt(payload, len, true);
+
+		zassert_true(chksum_equal(chksum,
+					  (u16_t)~net_calc_chksum_udp(pkt)),
+			     "16-bit update mismatch, offset %u", off);
+
+		net_pkt_unref(pkt);
+
+		memcpy(&old32, &payload[off], sizeof(old32));
+		new32 = sys_rand32_get();
+		memcpy(&payload[off], &new32, sizeof(new32));
+
+		chksum = net_chksum_update_u32(chksum, old32, new32);
+
+		zassert_true(chksum_equal(chksum,
+					  (u16_t)~ref_chksum_udp(payload, len)),
+			     "32-bit update mismatch, offset %u", off);
+	}
+}
+
+static void bench(u16_t len)
+{
+	u32_t start, pkt_cycles, ref_cycles;
+	volatile u16_t sum;
+	struct net_pkt *pkt;
+	int i;
+
+	fill_random(payload, len);
+
+	pkt = build_pkt(payload, len, false);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		sum = net_calc_chksum_udp(pkt);
+	}
+
+	pkt_cycles = (k_cycle_get_32() - start) / BENCH_ROUNDS;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		sum = ref_chksum_udp(payload, len);
+	}
+
+	ref_cycles = (k_cycle_get_32() - start) / BENCH_ROUNDS;
+
+	ARG_UNUSED(sum);
+
+	TC_PRINT("%4u bytes: %6u cycles (16-bit loop %6u cycles)\n",
+		 len, pkt_cycles, ref_cycles);
+
+	net_pkt_unref(pkt);
+}
+
+static void test_bench(void)
+{
+	static const u16_t sizes[] = { 64, 128, 256, 576, 1024, 1280, 1500 };
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		bench(sizes[i]);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(checksum,
+			 ztest_unit_test(test_chksum),
+			 ztest_unit_test(test_chksum_update),
+			 ztest_unit_test(test_bench));
+
+	ztest_run_test_suite(checksum);
+}
@@ -0,0 +1,244 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_CONN_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "connection.h"
+#include "udp_internal.h"
+
+#define BENCH_MAX_CONN 256
+#define LOOKUPS 4096
+
+#define NET_UDP_HDR(pkt)  ((struct net_udp_hdr *)(net_pkt_udp_data(pkt)))
+
+#define BASE_PORT 5683
+#define PEER_PORT 1234
+
+BUILD_ASSERT(CONFIG_NET_MAX_CONN >= BENCH_MAX_CONN);
+
+static struct in6_addr my_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static struct net_conn_handle *handles[BENCH_MAX_CONN];
+static struct net_pkt *pkt;
+static void *matched;
+
+static int conn_demux_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void conn_demux_iface_init(struct net_if *iface)
+{
+	static u8_t mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api conn_demux_if_api = {
+	.init = conn_demux_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(conn_demux_test, "conn_demux_test",
+		conn_demux_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&conn_demux_if_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static enum net_verdict demux_cb(struct net_conn *conn,
+				 struct net_pkt *pkt,
+				 void *user_data)
+{
+	matched = user_data;
+
+	/* Keep the packet so that it can be received again */
+	return NET_OK;
+}
+
+static void set_ports(u16_t src_port, u16_t dst_port)
+{
+	NET_UDP_HDR(pkt)->src_port = htons(src_port);
+	NET_UDP_HDR(pkt)->dst_port = htons(dst_port);
+}
+
+static void *demux(u16_t src_port, u16_t dst_port)
+{
+	matched = NULL;
+
+	set_ports(src_port, dst_port);
+	net_conn_input(IPPROTO_UDP, pkt);
+
+	return matched;
+}
+
+static void test_init(void)
+{
+	struct net_buf *frag;
+
+	pkt = net_pkt_get_reserve_rx(0, K_SECONDS(1));
+	zassert_not_null(pkt, "Out of mem");
+
+	frag = net_pkt_get_frag(pkt, K_SECONDS(1));
+	zassert_not_null(frag, "Out of mem");
+
+	net_pkt_frag_add(pkt, frag);
+	net_pkt_set_iface(pkt, net_if_get_default());
+	net_pkt_set_family(pkt, AF_INET6);
+
+	NET_IPV6_HDR(pkt)->vtc = 0x60;
+	NET_IPV6_HDR(pkt)->tcflow = 0;
+	NET_IPV6_HDR(pkt)->flow = 0;
+	NET_IPV6_HDR(pkt)->len = htons(NET_UDPH_LEN);
+	NET_IPV6_HDR(pkt)->nexthdr = IPPROTO_UDP;
+	NET_IPV6_HDR(pkt)->hop_limit = 255;
+
+	net_ipaddr_copy(&NET_IPV6_HDR(pkt)->src, &peer_addr);
+	net_ipaddr_copy(&NET_IPV6_HDR(pkt)->dst, &my_addr);
+
+	net_pkt_set_ip_hdr_len(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_set_ipv6_ext_len(pkt, 0);
+
+	net_buf_add(frag, net_pkt_ip_hdr_len(pkt) +
+		    sizeof(struct net_udp_hdr));
+}
+
+static void test_most_specific(void)
+{
+	struct sockaddr_in6 local = {
+		.sin6_family = AF_INET6,
+		.sin6_addr = my_addr,
+	};
+	struct sockaddr_in6 remote = {
+		.sin6_family = AF_INET6,
+		.sin6_addr = peer_addr,
+	};
+	struct net_conn_handle *listener, *connected, *any;
+	int ret;
+
+	ret = net_udp_register((struct sockaddr *)&remote,
+			       (struct sockaddr *)&local,
+			       PEER_PORT, BASE_PORT, demux_cb,
+			       &connected, &connected);
+	zassert_equal(ret, 0, "Cannot register connected handler");
+
+	ret = net_udp_register(NULL, (struct sockaddr *)&local,
+			       0, BASE_PORT, demux_cb, &listener, &listener);
+	zassert_equal(ret, 0, "Cannot register listener");
+
+	ret = net_udp_register(NULL, NULL, 0, 0, demux_cb, &any, &any);
+	zassert_equal(ret, 0, "Cannot register wildcard handler");
+
+	zassert_equal_ptr(demux(PEER_PORT, BASE_PORT), &connected,
+			  "connected handler not found");
+	zassert_equal_ptr(demux(PEER_PORT + 1, BASE_PORT), &listener,
+			  "listener not found");
+	zassert_equal_ptr(demux(PEER_PORT, BASE_PORT + 1), &any,
+			  "wildcard handler not found");
+
+	zassert_equal(net_udp_unregister(connected), 0, "unregister failed");
+
+	zassert_equal_ptr(demux(PEER_PORT, BASE_PORT), &listener,
+			  "listener not found");
+
+	zassert_equal(net_udp_unregister(listener), 0, "unregister failed");
+
+	zassert_equal_ptr(demux(PEER_PORT, BASE_PORT), &any,
+			  "wildcard handler not found");
+
+	zassert_equal(net_udp_unregister(any), 0, "unregister failed");
+}
+
+static void run_bench(int count)
+{
+	struct sockaddr_in6 local = {
+		.sin6_family = AF_INET6,
+		.sin6_addr = my_addr,
+	};
+	u32_t start, cycles;
+	int i, ret, errors = 0;
+
+	for (i = 0; i < count; i++) {
+		ret = net_udp_register(NULL, (struct sockaddr *)&local,
+				       0, BASE_PORT + i, demux_cb,
+				       &handles[i], &handles[i]);
+		zassert_equal(ret, 0, "Cannot register handler %d", i);
+	}
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < LOOKUPS; i++) {
+		/* Go through the ports in a scattered order */
+		int idx = (i * 7) % count;
+
+		if (demux(PEER_PORT, BASE_PORT + idx) != &handles[idx]) {
+			errors++;
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("%3d connections: %u cycles per packet\n", count,
+		 cycles / LOOKUPS);
+
+	zassert_equal(errors, 0, "%d packets demultiplexed wrong", errors);
+
+	for (i = 0; i < count; i++) {
+		zassert_equal(net_udp_unregister(handles[i]), 0,
+			      "Cannot unregister handler %d", i);
+	}
+}
+
+static void test_bench_8(void)
+{
+	run_bench(8);
+}
+
+static void test_bench_64(void)
+{
+	run_bench(64);
+}
+
+static void test_bench_256(void)
+{
+	run_bench(256);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(conn_demux,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_most_specific),
+			 ztest_unit_test(test_bench_8),
+			 ztest_unit_test(test_bench_64),
+			 ztest_unit_test(test_bench_256));
+
+	ztest_run_test_suite(conn_demux);
+}
@@ -0,0 +1,334 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_IPV4_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
+#define DBG(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#else
+#define DBG(fmt, ...)
+#endif
+
+#define TEST_MTU 576
+#define DATA_LEN 1400
+#define MAX_FRAGS 8
+
+#define ALLOC_TIMEOUT K_MSEC(500)
+#define WAIT_TIME K_SECONDS(1)
+
+#define LOCAL_PORT 4242
+#define REMOTE_PORT 4343
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr peer_addr = { { { 192, 0, 2, 2 } } };
+
+static struct net_if *iface;
+static struct net_conn_handle *handle;
+
+static struct net_pkt *frags[MAX_FRAGS];
+static int frag_count;
+
+static K_SEM_DEFINE(wait_send, 0, 1);
+static K_SEM_DEFINE(wait_recv, 0, UINT_MAX);
+
+static bool recv_ok;
+
+static u8_t data_byte(int i)
+{
+	return (u8_t)(i * 7 + 3);
+}
+
+static int net_iface_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static u8_t mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x04 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	u16_t flags;
+
+	if (frag_count == MAX_FRAGS) {
+		net_pkt_unref(pkt);
+		return 0;
+	}
+
+	DBG("Fragment %d len %zd\n", frag_count, net_pkt_get_len(pkt));
+
+	/* Keep the fragment so that it can be fed back to us */
+	frags[frag_count++] = pkt;
+
+	flags = sys_get_be16(NET_IPV4_HDR(pkt)->offset);
+	if (!(flags & NET_IPV4_MF)) {
+		k_sem_give(&wait_send);
+	}
+
+	return 0;
+}
+
+static struct net_if_api net_iface_api = {
+	.init = net_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(net_ipv4_frag_test, "net_ipv4_frag_test",
+		net_iface_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), TEST_MTU);
+
+static enum net_verdict udp_data_received(struct net_conn *conn,
+					  struct net_pkt *pkt,
+					  void *user_data)
+{
+	static u8_t buf[DATA_LEN];
+	int hdr_len = NET_IPV4H_LEN + NET_UDPH_LEN;
+	int i;
+
+	recv_ok = false;
+
+	if (net_pkt_get_len(pkt) != hdr_len + DATA_LEN) {
+		DBG("Invalid length %zd\n", net_pkt_get_len(pkt));
+		goto out;
+	}
+
+	if (net_frag_linearize(buf, sizeof(buf), pkt, hdr_len,
+			       DATA_LEN) != DATA_LEN) {
+		goto out;
+	}
+
+	for (i = 0; i < DATA_LEN; i++) {
+		if (buf[i] != data_byte(i)) {
+			DBG("Invalid data at %d\n", i);
+			goto out;
+		}
+	}
+
+	recv_ok = true;
+
+out:
+	net_pkt_unref(pkt);
+	k_sem_give(&wait_recv);
+
+	return NET_OK;
+}
+
+static void frag_count_cb(struct net_ipv4_reassembly *reass, void *user_data)
+{
+	int *count = user_data;
+
+	(*count)++;
+}
+
+static int pending_reassemblies(void)
+{
+	int count = 0;
+
+	net_ipv4_frag_foreach(frag_count_cb, &count);
+
+	return count;
+}
+
+/* Feed a sent fragment back to the stack as if it came from the peer.
+ * Swapping the addresses does not change the UDP checksum.
+ */
+static void recv_fragment(int idx)
+{
+	struct net_buf *frag = frags[idx]->frags;
+	struct net_pkt *pkt;
+	int ret;
+
+	pkt = net_pkt_get_reserve_rx(0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "Out of RX packets");
+
+	while (frag) {
+		zassert_true(net_pkt_append_all(pkt, frag->len, frag->data,
+						ALLOC_TIMEOUT),
+			     "Cannot append data");
+		frag = frag->frags;
+	}
+
+	net_ipaddr_copy(&NET_IPV4_HDR(pkt)->src, &peer_addr);
+	net_ipaddr_copy(&NET_IPV4_HDR(pkt)->dst, &my_addr);
+
+	NET_IPV4_HDR(pkt)->chksum = 0;
+	NET_IPV4_HDR(pkt)->chksum = ~net_calc_chksum_ipv4(pkt);
+
+	ret = net_recv_data(iface, pkt);
+	zassert_equal(ret, 0, "Cannot receive fragment (%d)", ret);
+}
+
+static void test_setup(void)
+{
+	struct net_if_addr *ifaddr;
+	int ret;
+
+	iface = net_if_get_default();
+
+	ifaddr = net_if_ipv4_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add IPv4 address");
+
+	ret = net_udp_register(NULL, NULL, LOCAL_PORT, REMOTE_PORT,
+			       udp_data_received, NULL, &handle);
+	zassert_equal(ret, 0, "Cannot register UDP handler");
+}
+
+static void test_send_fragmented(void)
+{
+	struct net_udp_hdr hdr;
+	struct net_pkt *pkt;
+	u16_t id, offset = 0;
+	int i, ret;
+
+	pkt = net_pkt_get_reserve_tx(0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "Out of TX packets");
+
+	net_pkt_set_iface(pkt, iface);
+
+	pkt = net_ipv4_create(pkt, &my_addr, &peer_addr, iface,
+			      IPPROTO_UDP);
+	zassert_not_null(pkt, "Cannot create IPv4 packet");
+
+	hdr.src_port = htons(LOCAL_PORT);
+	hdr.dst_port = htons(REMOTE_PORT);
+	hdr.len = htons(NET_UDPH_LEN + DATA_LEN);
+	hdr.chksum = 0;
+
+	zassert_true(net_pkt_append_all(pkt, sizeof(hdr), (u8_t *)&hdr,
+					ALLOC_TIMEOUT), "Cannot append");
+
+	for (i = 0; i < DATA_LEN; i++) {
+		u8_t byte = data_byte(i);
+
+		zassert_true(net_pkt_append_all(pkt, 1, &byte, ALLOC_TIMEOUT),
+			     "Cannot append data");
+	}
+
+	net_ipv4_finalize(pkt, IPPROTO_UDP);
+
+	ret = net_send_data(pkt);
+	zassert_equal(ret, 0, "Cannot send (%d)", ret);
+
+	zassert_equal(k_sem_take(&wait_send, WAIT_TIME), 0,
+		      "Timeout while waiting fragments");
+
+	zassert_equal(frag_count, 3, "Invalid fragment count %d", frag_count);
+
+	id = sys_get_be16(NET_IPV4_HDR(frags[0])->id);
+
+	for (i = 0; i < frag_count; i++) {
+		struct net_ipv4_hdr *ip = NET_IPV4_HDR(frags[i]);
+		u16_t flags = sys_get_be16(ip->offset);
+
+		zassert_true(net_pkt_get_len(frags[i]) <= TEST_MTU,
+			     "Fragment %d too long", i);
+		zassert_equal(ntohs(ip->len), net_pkt_get_len(frags[i]),
+			      "Fragment %d length mismatch", i);
+		zassert_equal(sys_get_be16(ip->id), id,
+			      "Fragment %d id mismatch", i);
+		zassert_equal((flags & NET_IPV4_FRAGH_OFFSET_MASK) * 8,
+			      offset, "Fragment %d offset mismatch", i);
+		zassert_equal(!!(flags & NET_IPV4_MF), i < frag_count - 1,
+			      "Fragment %d MF flag invalid", i);
+
+		offset += ntohs(ip->len) - NET_IPV4H_LEN;
+	}
+
+	zassert_equal(offset, NET_UDPH_LEN + DATA_LEN, "Invalid total length");
+}
+
+static void test_reassemble_reverse(void)
+{
+	int i;
+
+	for (i = frag_count - 1; i >= 0; i--) {
+		recv_fragment(i);
+	}
+
+	zassert_equal(k_sem_take(&wait_recv, WAIT_TIME), 0,
+		      "Timeout while waiting reassembled data");
+	zassert_true(recv_ok, "Reassembled data invalid");
+	zassert_equal(pending_reassemblies(), 0, "Reassembly pending");
+}
+
+static void test_reassemble_duplicate(void)
+{
+	recv_fragment(0);
+	recv_fragment(1);
+	recv_fragment(0);
+	recv_fragment(2);
+
+	zassert_equal(k_sem_take(&wait_recv, WAIT_TIME), 0,
+		      "Timeout while waiting reassembled data");
+	zassert_true(recv_ok, "Reassembled data invalid");
+
+	zassert_not_equal(k_sem_take(&wait_recv, K_MSEC(100)), 0,
+			  "Datagram delivered twice");
+}
+
+static void test_reassembly_timeout(void)
+{
+	recv_fragment(0);
+
+	/* Let the RX thread to process the fragment */
+	k_sleep(K_MSEC(100));
+
+	zassert_equal(pending_reassemblies(), 1, "Reassembly not pending");
+
+	k_sleep(K_SECONDS(CONFIG_NET_IPV4_FRAGMENT_TIMEOUT) + K_MSEC(500));
+
+	zassert_equal(pending_reassemblies(), 0, "Reassembly not timed out");
+	zassert_not_equal(k_sem_take(&wait_recv, K_NO_WAIT), 0,
+			  "Partial datagram delivered");
+}
+
+static void test_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < frag_count; i++) {
+		net_pkt_unref(frags[i]);
+	}
+
+	zassert_equal(net_udp_unregister(handle), 0, "Cannot unregister");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_ipv4_fragment_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_send_fragmented),
+			 ztest_unit_test(test_reassemble_reverse),
+			 ztest_unit_test(test_reassemble_duplicate),
+			 ztest_unit_test(test_reassembly_timeout),
+			 ztest_unit_test(test_cleanup));
+
+	ztest_run_test_suite(net_ipv4_fragment_test);
+}
@@ -0,0 +1,312 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_IPV6_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "ipv6.h"
+#include "nbr.h"
+
+#define NBRS CONFIG_NET_IPV6_MAX_NEIGHBORS
+#define LOOKUPS 4096
+
+/* Number of neighbors with a running reachable timer */
+#define TIMERS 16
+
+/* Base reachable time of the interface, the timers expire in 0.5 to 1.5
+ * times this.
+ */
+#define REACHABLE_TIME 100
+
+static struct net_if *iface;
+
+static u8_t mac_addr[sizeof(struct net_eth_addr)] = {
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	0x00, 0x00, 0x5E, 0x00, 0x53, 0x01
+};
+
+static int nbr_cache_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void nbr_cache_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api nbr_cache_if_api = {
+	.init = nbr_cache_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(nbr_cache_test, "nbr_cache_test",
+		nbr_cache_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&nbr_cache_if_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+/* 2001:db8::5eff:fe00:xxxx, like the addresses of a 6LoWPAN network */
+static void nbr_addr(struct in6_addr *addr, int i)
+{
+	(void)memset(addr, 0, sizeof(*addr));
+
+	addr->s6_addr16[0] = htons(0x2001);
+	addr->s6_addr16[1] = htons(0x0db8);
+	addr->s6_addr16[5] = htons(0x5eff);
+	addr->s6_addr16[6] = htons(0xfe00);
+	addr->s6_addr16[7] = htons(i);
+}
+
+static struct net_nbr *nbr_add(int i)
+{
+	u8_t mac[sizeof(struct net_eth_addr)];
+	struct net_linkaddr lladdr;
+	struct in6_addr addr;
+
+	nbr_addr(&addr, i);
+
+	memcpy(mac, mac_addr, sizeof(mac));
+	mac[4] = i >> 8;
+	mac[5] = i;
+
+	lladdr.addr = mac;
+	lladdr.len = sizeof(mac);
+	lladdr.type = NET_LINK_ETHERNET;
+
+	return net_ipv6_nbr_add(iface, &addr, &lladdr, false,
+				NET_IPV6_NBR_STATE_REACHABLE);
+}
+
+static struct net_nbr *nbr_find(struct net_if *iface, int i)
+{
+	struct in6_addr addr;
+
+	nbr_addr(&addr, i);
+
+	return net_ipv6_nbr_lookup(iface, &addr);
+}
+
+static void nbr_del(int i)
+{
+	struct in6_addr addr;
+
+	nbr_addr(&addr, i);
+
+	net_ipv6_nbr_rm(iface, &addr);
+}
+
+static void fill_table(void)
+{
+	int i;
+
+	for (i = 0; i < NBRS + 2; i++) {
+		nbr_del(i);
+	}
+
+	for (i = 0; i < NBRS; i++) {
+		zassert_not_null(nbr_add(i), "Cannot add neighbor %d", i);
+	}
+}
+
+static void test_init(void)
+{
+	iface = net_if_get_default();
+	zassert_not_null(iface, "No interface");
+}
+
+static void test_lookup(void)
+{
+	struct net_linkaddr_storage *lladdr;
+	struct net_nbr *nbr;
+	int i;
+
+	fill_table();
+
+	for (i = 0; i < NBRS; i++) {
+		nbr = nbr_find(iface, i);
+		zassert_not_null(nbr, "Neighbor %d not found", i);
+		zassert_equal_ptr(nbr_find(NULL, i), nbr,
+				  "Neighbor %d not found without iface", i);
+
+		lladdr = net_nbr_get_lladdr(nbr->idx);
+		zassert_true(lladdr->addr[4] == (u8_t)(i >> 8) &&
+			     lladdr->addr[5] == (u8_t)i,
+			     "Wrong lladdr for neighbor %d", i);
+	}
+
+	zassert_is_null(nbr_find(iface, NBRS), "Unknown neighbor found");
+
+	nbr_del(NBRS / 2);
+	zassert_is_null(nbr_find(iface, NBRS / 2), "Removed neighbor found");
+	zassert_not_null(nbr_find(iface, NBRS / 2 + 1), "Neighbor not found");
+
+	zassert_not_null(nbr_add(NBRS / 2), "Cannot add neighbor again");
+	zassert_not_null(nbr_find(iface, NBRS / 2), "Neighbor not found");
+}
+
+static void test_last_hit(void)
+{
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	struct net_ipv6_nbr_stats before, after;
+
+	zassert_not_null(nbr_find(iface, 1), "Neighbor not found");
+
+	net_ipv6_nbr_get_stats(&before);
+
+	zassert_not_null(nbr_find(iface, 1), "Neighbor not found");
+	zassert_not_null(nbr_find(iface, 2), "Neighbor not found");
+	zassert_is_null(nbr_find(iface, NBRS), "Unknown neighbor found");
+
+	net_ipv6_nbr_get_stats(&after);
+
+	zassert_equal(after.lookups - before.lookups, 3, "Wrong lookups");
+	zassert_equal(after.last_hits - before.last_hits, 1,
+		      "Wrong last hits");
+	zassert_equal(after.misses - before.misses, 1, "Wrong misses");
+#else
+	ztest_test_skip();
+#endif
+}
+
+static void test_eviction(void)
+{
+	struct net_nbr *nbr;
+	int i;
+
+	fill_table();
+
+	/* Neighbor 0 is now the least recently used one */
+	for (i = 1; i < NBRS; i++) {
+		zassert_not_null(nbr_find(iface, i), "Neighbor not found");
+	}
+
+	nbr = nbr_add(NBRS);
+
+#if defined(CONFIG_NET_IPV6_NBR_HASH)
+	zassert_not_null(nbr, "Cannot replace a neighbor");
+	zassert_is_null(nbr_find(iface, 0), "LRU neighbor not replaced");
+
+	/* Neighbor 1 is used by a route for example, so the next least
+	 * recently used neighbor is replaced instead.
+	 */
+	nbr = net_nbr_ref(nbr_find(NULL, 1));
+
+	zassert_not_null(nbr_add(NBRS + 1), "Cannot replace a neighbor");
+	zassert_not_null(nbr_find(iface, 1), "Referenced neighbor replaced");
+	zassert_is_null(nbr_find(iface, 2), "LRU neighbor not replaced");
+
+	net_nbr_unref(nbr);
+
+	for (i = 3; i < NBRS + 2; i++) {
+		zassert_not_null(nbr_find(iface, i), "Neighbor %d lost", i);
+	}
+#else
+	zassert_is_null(nbr, "Neighbor added to a full cache");
+#endif
+}
+
+static void test_reachable_timer(void)
+{
+#if defined(CONFIG_NET_IPV6_ND)
+	struct net_nbr *nbr;
+	int i;
+
+	fill_table();
+
+	net_if_ipv6_set_base_reachable_time(iface, REACHABLE_TIME);
+	net_if_ipv6_set_reachable_time(iface->config.ip.ipv6);
+
+	for (i = 0; i < TIMERS; i++) {
+		net_ipv6_nbr_set_reachable_timer(iface, nbr_find(iface, i));
+	}
+
+	/* A neighbor removed while its timer runs */
+	nbr_del(0);
+
+	/* A timer restarted before it expired */
+	net_ipv6_nbr_set_reachable_timer(iface, nbr_find(iface, 1));
+
+	k_sleep(REACHABLE_TIME * 3);
+
+	for (i = 1; i < NBRS; i++) {
+		nbr = nbr_find(iface, i);
+		zassert_not_null(nbr, "Neighbor %d lost", i);
+
+		zassert_equal(net_ipv6_nbr_data(nbr)->state,
+			      i < TIMERS ? NET_IPV6_NBR_STATE_STALE :
+			      NET_IPV6_NBR_STATE_REACHABLE,
+			      "Wrong state for neighbor %d", i);
+		zassert_equal(net_ipv6_nbr_data(nbr)->reachable, 0,
+			      "Timer of neighbor %d still running", i);
+	}
+#else
+	ztest_test_skip();
+#endif
+}
+
+static void run_bench(const char *name, int step)
+{
+	u32_t start, cycles;
+	int i, errors = 0;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < LOOKUPS; i++) {
+		if (!nbr_find(iface, (i / step) % NBRS)) {
+			errors++;
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("%d neighbors, %s: %u cycles per lookup\n", NBRS, name,
+		 cycles / LOOKUPS);
+
+	zassert_equal(errors, 0, "%d failed lookups", errors);
+}
+
+static void test_bench(void)
+{
+	fill_table();
+
+	run_bench("different neighbors", 1);
+	run_bench("same neighbor", LOOKUPS);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(ipv6_nbr_cache,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_lookup),
+			 ztest_unit_test(test_last_hit),
+			 ztest_unit_test(test_eviction),
+			 ztest_unit_test(test_reachable_timer),
+			 ztest_unit_test(test_bench));
+
+	ztest_run_test_suite(ipv6_nbr_cache);
+}
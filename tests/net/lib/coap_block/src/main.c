@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_COAP_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_context.h>
+#include <net/coap.h>
+#include <net/coap_block.h>
+
+#define SERVER_PORT 5683
+#define CLIENT_PORT 5684
+
+#define BODY_SIZE 32768
+
+/* One message of ten is dropped when loss is induced */
+#define LOSS_PERIOD 10
+
+#define ACK_TIMEOUT 100
+
+#define WAIT_TIME K_SECONDS(10)
+
+static const char * const path[] = { "fw", NULL };
+
+static struct sockaddr_in server_addr;
+static struct sockaddr_in client_addr;
+
+static struct net_context *server_ctx;
+static struct net_context *client_ctx;
+
+static struct coap_blockwise server;
+static struct coap_blockwise client;
+
+static K_FIFO_DEFINE(rx_fifo);
+
+static u32_t sent_count;
+static u32_t lost_count;
+static u32_t loss_period;
+
+/* Bytes received by the consumers, and where they did not match */
+static size_t received;
+static bool corrupted;
+
+static int client_status;
+static bool client_done;
+static int server_status;
+static bool server_done;
+
+static size_t upload_offset;
+
+static u8_t pattern(size_t offset)
+{
+	return (u8_t)(offset * 7 + (offset >> 8));
+}
+
+static int body_read(struct coap_blockwise *bw, size_t offset, u8_t *data,
+		     size_t len, bool *last)
+{
+	size_t i;
+
+	if (offset >= BODY_SIZE) {
+		*last = true;
+		return 0;
+	}
+
+	len = min(len, BODY_SIZE - offset);
+	*last = offset + len == BODY_SIZE;
+
+	for (i = 0; i < len; i++) {
+		data[i] = pattern(offset + i);
+	}
+
+	return len;
+}
+
+/* A client reads its body once, in order */
+static int upload_read(struct coap_blockwise *bw, size_t offset, u8_t *data,
+		       size_t len, bool *last)
+{
+	zassert_equal(offset, upload_offset, "Body read out of order");
+	upload_offset += len;
+
+	return body_read(bw, offset, data, len, last);
+}
+
+static int body_write(struct coap_blockwise *bw, size_t offset,
+		      const u8_t *data, size_t len, bool last)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (data[i] != pattern(offset + i)) {
+			corrupted = true;
+		}
+	}
+
+	if (last && offset + len != BODY_SIZE) {
+		corrupted = true;
+	}
+
+	received += len;
+
+	return 0;
+}
+
+static void client_transfer_done(struct coap_blockwise *bw, int status)
+{
+	client_status = status;
+	client_done = true;
+}
+
+static void server_transfer_done(struct coap_blockwise *bw, int status)
+{
+	server_status = status;
+	server_done = true;
+}
+
+static struct net_pkt *pkt_alloc(struct coap_blockwise *bw)
+{
+	struct net_context *ctx = bw->user_data;
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+
+	pkt = net_pkt_get_tx(ctx, K_NO_WAIT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	frag = net_pkt_get_data(ctx, K_NO_WAIT);
+	if (!frag) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_frag_add(pkt, frag);
+
+	return pkt;
+}
+
+static int pkt_send(struct coap_blockwise *bw, struct net_pkt *pkt,
+		    const struct sockaddr *addr)
+{
+	int r;
+
+	if (loss_period && ++sent_count % loss_period == 0) {
+		lost_count++;
+		net_pkt_unref(pkt);
+		return 0;
+	}
+
+	r = net_context_sendto(pkt, addr, sizeof(struct sockaddr_in), NULL,
+			       K_NO_WAIT, NULL, NULL);
+	if (r < 0) {
+		net_pkt_unref(pkt);
+	}
+
+	return r;
+}
+
+static void recv_cb(struct net_context *context, struct net_pkt *pkt,
+		    int status, void *user_data)
+{
+	if (pkt) {
+		k_fifo_put(&rx_fifo, pkt);
+	}
+}
+
+static void handle_pkt(struct net_pkt *pkt)
+{
+	struct coap_option options[16];
+	struct coap_packet cpkt;
+	int r;
+
+	(void)memset(options, 0, sizeof(options));
+
+	r = coap_packet_parse(&cpkt, pkt, options, ARRAY_SIZE(options));
+	zassert_equal(r, 0, "Cannot parse message");
+
+	if (net_pkt_context(pkt) == server_ctx) {
+		r = coap_blockwise_request(&server, &cpkt,
+					   (struct sockaddr *)&client_addr);
+		zassert_equal(r, 0, "Request not handled (%d)", r);
+	} else {
+		r = coap_blockwise_response(&client, &cpkt);
+		zassert_true(r == 0 || client_done,
+			     "Response not handled (%d)", r);
+	}
+
+	net_pkt_unref(pkt);
+}
+
+static struct net_context *context_setup(struct sockaddr_in *addr, u16_t port)
+{
+	struct net_context *ctx;
+
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	zassert_true(net_addr_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				   &addr->sin_addr) == 0, "Invalid address");
+
+	zassert_equal(net_context_get(AF_INET, SOCK_DGRAM, IPPROTO_UDP, &ctx),
+		      0, "Cannot get context");
+	zassert_equal(net_context_bind(ctx, (struct sockaddr *)addr,
+				       sizeof(*addr)), 0, "Cannot bind");
+	zassert_equal(net_context_recv(ctx, recv_cb, K_NO_WAIT, NULL), 0,
+		      "Cannot receive");
+
+	return ctx;
+}
+
+static void test_setup(void)
+{
+	server_ctx = context_setup(&server_addr, SERVER_PORT);
+	client_ctx = context_setup(&client_addr, CLIENT_PORT);
+
+	server.alloc = pkt_alloc;
+	server.send = pkt_send;
+	server.read = body_read;
+	server.write = body_write;
+	server.done = server_transfer_done;
+	server.user_data = server_ctx;
+
+	client.alloc = pkt_alloc;
+	client.send = pkt_send;
+	client.done = client_transfer_done;
+	client.user_data = client_ctx;
+	client.ack_timeout = ACK_TIMEOUT;
+}
+
+/* Runs a client transfer to its end */
+static void transfer(const char *name, u8_t method,
+		     enum coap_block_size client_size,
+		     enum coap_block_size server_size, u8_t window,
+		     u32_t loss)
+{
+	struct net_pkt *pkt;
+	u32_t start, time;
+	s32_t timeout;
+
+	client.read = method == COAP_METHOD_GET ? NULL : upload_read;
+	client.write = method == COAP_METHOD_GET ? body_write : NULL;
+
+	zassert_equal(coap_blockwise_server_init(&server, server_size,
+						 COAP_RESPONSE_CODE_CHANGED),
+		      0, "Cannot init server");
+	zassert_equal(coap_blockwise_client_init(&client, method,
+						 (struct sockaddr *)&server_addr,
+						 path, client_size, window),
+		      0, "Cannot init client");
+
+	received = 0;
+	corrupted = false;
+	upload_offset = 0;
+	client_done = false;
+	server_done = false;
+	sent_count = 0;
+	lost_count = 0;
+	loss_period = loss;
+
+	start = k_uptime_get_32();
+
+	zassert_equal(coap_blockwise_start(&client), 0, "Cannot start");
+
+	while (!client_done) {
+		timeout = coap_blockwise_poll(&client);
+		if (client_done) {
+			break;
+		}
+
+		pkt = k_fifo_get(&rx_fifo,
+				 timeout == K_FOREVER ? WAIT_TIME : timeout);
+		if (!pkt) {
+			zassert_true(timeout != K_FOREVER, "Transfer stalled");
+			continue;
+		}
+
+		handle_pkt(pkt);
+	}
+
+	time = k_uptime_get_32() - start;
+
+	/* Answer the retransmissions still in flight */
+	loss_period = 0;
+	while ((pkt = k_fifo_get(&rx_fifo, K_MSEC(10)))) {
+		handle_pkt(pkt);
+	}
+
+	zassert_false(corrupted, "Body corrupted");
+	zassert_equal(received, BODY_SIZE, "Invalid body size %u",
+		      (unsigned int)received);
+
+	if (method == COAP_METHOD_GET) {
+		zassert_equal(client_status, COAP_RESPONSE_CODE_CONTENT,
+			      "Download failed (%d)", client_status);
+	} else {
+		zassert_equal(client_status, COAP_RESPONSE_CODE_CHANGED,
+			      "Upload failed (%d)", client_status);
+		zassert_true(server_done, "Upload not done on server");
+		zassert_equal(server_status, COAP_RESPONSE_CODE_CHANGED,
+			      "Upload failed on server (%d)", server_status);
+	}
+
+	zassert_equal(client.block_size, min(client_size, server_size),
+		      "Block size not negotiated");
+
+	TC_PRINT("%s: %u bytes in %u ms, %u messages, %u lost",
+		 name, BODY_SIZE, time, sent_count, lost_count);
+	if (time) {
+		TC_PRINT(", %u bytes/s", BODY_SIZE * MSEC_PER_SEC / time);
+	}
+	TC_PRINT("\n");
+}
+
+static void test_download(void)
+{
+	transfer("GET", COAP_METHOD_GET, COAP_BLOCK_1024, COAP_BLOCK_1024,
+		 1, 0);
+	transfer("GET window 8", COAP_METHOD_GET, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 8, 0);
+}
+
+static void test_download_loss(void)
+{
+	transfer("GET loss", COAP_METHOD_GET, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 1, LOSS_PERIOD);
+	transfer("GET window 8 loss", COAP_METHOD_GET, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 8, LOSS_PERIOD);
+}
+
+static void test_upload(void)
+{
+	transfer("PUT", COAP_METHOD_PUT, COAP_BLOCK_1024, COAP_BLOCK_1024,
+		 1, 0);
+	transfer("PUT window 8", COAP_METHOD_PUT, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 8, 0);
+}
+
+static void test_upload_loss(void)
+{
+	transfer("PUT loss", COAP_METHOD_PUT, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 1, LOSS_PERIOD);
+	transfer("PUT window 8 loss", COAP_METHOD_PUT, COAP_BLOCK_1024,
+		 COAP_BLOCK_1024, 8, LOSS_PERIOD);
+}
+
+/* The server prefers smaller blocks than the client */
+static void test_negotiation(void)
+{
+	transfer("GET 256", COAP_METHOD_GET, COAP_BLOCK_1024,
+		 COAP_BLOCK_256, 4, 0);
+	transfer("PUT 256", COAP_METHOD_PUT, COAP_BLOCK_1024,
+		 COAP_BLOCK_256, 4, 0);
+}
+
+static void test_timeout(void)
+{
+	s32_t timeout;
+
+	/* Nothing answers on this port, the requests time out */
+	server_addr.sin_port = htons(SERVER_PORT + 10);
+
+	client.read = NULL;
+	client.write = body_write;
+	client_done = false;
+
+	zassert_equal(coap_blockwise_client_init(&client, COAP_METHOD_GET,
+						 (struct sockaddr *)&server_addr,
+						 path, COAP_BLOCK_64, 1),
+		      0, "Cannot init client");
+	zassert_equal(coap_blockwise_start(&client), 0, "Cannot start");
+
+	while (!client_done) {
+		timeout = coap_blockwise_poll(&client);
+		if (!client_done) {
+			k_sleep(timeout);
+		}
+	}
+
+	zassert_equal(client_status, -ETIMEDOUT, "Transfer not timed out");
+
+	server_addr.sin_port = htons(SERVER_PORT);
+}
+
+/* Sends a PUT block of 64 bytes straight to the server, and returns the
+ * type and code of its response, or -1 without response.
+ */
+static int put_block(u16_t id, size_t offset, bool more, u8_t *code)
+{
+	struct coap_option options[16];
+	struct coap_packet cpkt;
+	u8_t data[64];
+	struct net_pkt *pkt;
+	u8_t token[8];
+	size_t i;
+	int type;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = pattern(offset + i);
+	}
+
+	(void)memset(token, 0, sizeof(token));
+
+	pkt = pkt_alloc(&client);
+	zassert_not_null(pkt, "Cannot allocate request");
+
+	zassert_equal(coap_packet_init(&cpkt, pkt, 1, COAP_TYPE_CON,
+				       sizeof(token), token, COAP_METHOD_PUT,
+				       id), 0,
+		      "Cannot init request");
+	zassert_equal(coap_append_option_int(&cpkt, COAP_OPTION_BLOCK1,
+					     (offset / sizeof(data)) << 4 |
+					     (more ? 0x08 : 0) |
+					     COAP_BLOCK_64), 0,
+		      "Cannot append Block1");
+	zassert_equal(coap_packet_append_payload_marker(&cpkt), 0,
+		      "Cannot append payload marker");
+	zassert_equal(coap_packet_append_payload(&cpkt, data, sizeof(data)),
+		      0, "Cannot append payload");
+
+	(void)memset(options, 0, sizeof(options));
+
+	zassert_equal(coap_packet_parse(&cpkt, pkt, options,
+					ARRAY_SIZE(options)), 0,
+		      "Cannot parse request");
+	zassert_equal(coap_blockwise_request(&server, &cpkt,
+					     (struct sockaddr *)&client_addr),
+		      0, "Request not handled");
+
+	net_pkt_unref(pkt);
+
+	pkt = k_fifo_get(&rx_fifo, K_MSEC(100));
+	if (!pkt) {
+		return -1;
+	}
+
+	(void)memset(options, 0, sizeof(options));
+
+	zassert_equal(coap_packet_parse(&cpkt, pkt, options,
+					ARRAY_SIZE(options)), 0,
+		      "Cannot parse response");
+	zassert_equal(coap_header_get_id(&cpkt), id, "Invalid message id");
+
+	type = coap_header_get_type(&cpkt);
+	*code = coap_header_get_code(&cpkt);
+
+	net_pkt_unref(pkt);
+
+	return type;
+}
+
+/* Every confirmable block gets a response, or at least an empty ACK */
+static void test_upload_responses(void)
+{
+	u8_t code;
+
+	zassert_equal(coap_blockwise_server_init(&server, COAP_BLOCK_64,
+						 COAP_RESPONSE_CODE_CHANGED),
+		      0, "Cannot init server");
+
+	server_done = false;
+	loss_period = 0;
+
+	zassert_equal(put_block(1, 0, true, &code), COAP_TYPE_ACK,
+		      "No response to the first block");
+	zassert_equal(code, COAP_RESPONSE_CODE_CONTINUE, "Invalid code");
+
+	/* Past the window of the server */
+	zassert_equal(put_block(2, 64 * (CONFIG_COAP_BLOCKWISE_WINDOW + 1),
+				true, &code), COAP_TYPE_ACK,
+		      "No response out of the window");
+	zassert_equal(code, COAP_RESPONSE_CODE_INCOMPLETE, "Invalid code");
+
+	/* Last block before the second and third ones */
+	zassert_equal(put_block(3, 3 * 64, false, &code), COAP_TYPE_ACK,
+		      "No response to the early last block");
+	zassert_equal(code, COAP_CODE_EMPTY, "Last block answered early");
+	zassert_false(server_done, "Upload done with missing blocks");
+
+	zassert_equal(put_block(4, 64, true, &code), COAP_TYPE_ACK,
+		      "No response to the second block");
+	zassert_equal(code, COAP_RESPONSE_CODE_CONTINUE, "Invalid code");
+
+	zassert_equal(put_block(5, 2 * 64, true, &code), COAP_TYPE_ACK,
+		      "No response to the third block");
+	zassert_equal(code, COAP_RESPONSE_CODE_CHANGED, "Invalid code");
+	zassert_true(server_done, "Upload not done on server");
+	zassert_equal(server_status, COAP_RESPONSE_CODE_CHANGED,
+		      "Upload failed on server (%d)", server_status);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(coap_block,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_download),
+			 ztest_unit_test(test_download_loss),
+			 ztest_unit_test(test_upload),
+			 ztest_unit_test(test_upload_loss),
+			 ztest_unit_test(test_negotiation),
+			 ztest_unit_test(test_upload_responses),
+			 ztest_unit_test(test_timeout));
+
+	ztest_run_test_suite(coap_block);
+}
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_COAP_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <stdio.h>
+#include <misc/byteorder.h>
+
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/udp.h>
+#include <net/coap.h>
+
+#define MAX_RESOURCES 500
+#define NUM_OBSERVERS 64
+#define NUM_PENDINGS 64
+#define NUM_REPLIES 64
+
+/* Requests dispatched to each resource during the benchmark */
+#define BENCH_ROUNDS 20
+
+#define COAP_BUF_SIZE 128
+
+NET_PKT_TX_SLAB_DEFINE(coap_pkt_slab, 4);
+
+NET_BUF_POOL_DEFINE(coap_data_pool, 4, COAP_BUF_SIZE, 0, NULL);
+
+/* IPv6 + UDP frame (48 bytes) */
+static const u8_t ipv6_udp_hdr[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x16, 0x11, 0xFF,
+	0x20, 0x01, 0x0D, 0xB8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+	0x20, 0x01, 0x0D, 0xB8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0xd8, 0xb4, 0x16, 0x33, 0x00, 0x16, 0x00, 0x00,
+};
+
+/* Resources /sensors/0 to /sensors/499, and a terminator */
+static char names[MAX_RESOURCES][4];
+static const char *paths[MAX_RESOURCES][3];
+static struct coap_resource resources[MAX_RESOURCES + 1];
+
+static struct coap_observer observers[NUM_OBSERVERS];
+static struct coap_pending pendings[NUM_PENDINGS];
+static struct coap_reply replies[NUM_REPLIES];
+
+static struct coap_index index;
+
+static struct coap_resource *handled;
+static struct coap_reply *replied;
+
+static int resource_get(struct coap_resource *resource,
+			struct coap_packet *request)
+{
+	handled = resource;
+
+	return 0;
+}
+
+static int reply_cb(const struct coap_packet *response,
+		    struct coap_reply *reply,
+		    const struct sockaddr *from)
+{
+	replied = reply;
+
+	return 0;
+}
+
+static void append_option(struct net_pkt *pkt, u8_t delta, const char *value)
+{
+	u8_t len = strlen(value);
+	u8_t opt = (delta << 4) | len;
+
+	zassert_true(len < 13 && delta < 13, "Option too long");
+	zassert_true(net_pkt_append_all(pkt, 1, &opt, K_FOREVER),
+		     "Cannot append option");
+	zassert_true(net_pkt_append_all(pkt, len, (u8_t *)value, K_FOREVER),
+		     "Cannot append option");
+}
+
+/* Builds a message for the path of the resource res, if not negative */
+static struct net_pkt *build_msg(struct coap_packet *cpkt,
+				 struct coap_option *options, u8_t opt_num,
+				 u8_t code, u16_t id, const u8_t *token,
+				 u8_t tkl, int res)
+{
+	u8_t hdr[4] = { 0x40 | tkl, code };
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+	int r;
+
+	pkt = net_pkt_get_reserve(&coap_pkt_slab, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Could not get packet from pool");
+
+	frag = net_buf_alloc(&coap_data_pool, K_NO_WAIT);
+	zassert_not_null(frag, "Could not get buffer from pool");
+
+	net_pkt_frag_add(pkt, frag);
+
+	sys_put_be16(id, hdr + 2);
+
+	net_pkt_append_all(pkt, sizeof(ipv6_udp_hdr), (u8_t *)ipv6_udp_hdr,
+			   K_FOREVER);
+	net_pkt_append_all(pkt, sizeof(hdr), hdr, K_FOREVER);
+	net_pkt_append_all(pkt, tkl, (u8_t *)token, K_FOREVER);
+
+	if (res >= 0) {
+		append_option(pkt, COAP_OPTION_URI_PATH, paths[res][0]);
+		append_option(pkt, 0, paths[res][1]);
+	}
+
+	net_pkt_set_ip_hdr_len(pkt, NET_IPV6H_LEN);
+	net_pkt_set_ipv6_ext_len(pkt, 0);
+
+	/* Options past the ones of the packet are left untouched */
+	memset(options, 0, sizeof(*options) * opt_num);
+
+	r = coap_packet_parse(cpkt, pkt, options, opt_num);
+	zassert_equal(r, 0, "Could not parse packet");
+
+	return pkt;
+}
+
+static struct net_pkt *build_request(struct coap_packet *cpkt,
+				     struct coap_option *options,
+				     u8_t opt_num, int res)
+{
+	return build_msg(cpkt, options, opt_num, COAP_METHOD_GET, 0, NULL, 0,
+			 res);
+}
+
+/* Makes the first count resources the known ones */
+static void set_resource_count(int count)
+{
+	int i;
+
+	for (i = 0; i < MAX_RESOURCES; i++) {
+		resources[i].path = i < count ? paths[i] : NULL;
+	}
+
+	coap_index_init(&index);
+	zassert_equal(coap_index_add_resources(&index, resources), count,
+		      "Invalid resource count");
+}
+
+static void test_resources(void)
+{
+	struct coap_option options[4];
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	u8_t opt_num = ARRAY_SIZE(options);
+	int i;
+
+	for (i = 0; i < MAX_RESOURCES; i++) {
+		snprintf(names[i], sizeof(names[i]), "%d", i);
+		paths[i][0] = "sensors";
+		paths[i][1] = names[i];
+		paths[i][2] = NULL;
+
+		resources[i].get = resource_get;
+		resources[i].path = paths[i];
+	}
+
+	set_resource_count(MAX_RESOURCES);
+
+	for (i = 0; i < MAX_RESOURCES; i++) {
+		pkt = build_request(&cpkt, options, opt_num, i);
+
+		handled = NULL;
+		zassert_equal(coap_index_handle_request(&cpkt, &index, options,
+							opt_num), 0,
+			      "Resource %d not found", i);
+		zassert_equal_ptr(handled, &resources[i], "Wrong resource");
+
+		net_pkt_unref(pkt);
+	}
+
+	/* Neither an empty nor an unknown path match */
+	pkt = build_request(&cpkt, options, opt_num, -1);
+	zassert_equal(coap_index_handle_request(&cpkt, &index, options,
+						opt_num), -ENOENT,
+		      "Empty path matched");
+	net_pkt_unref(pkt);
+
+	set_resource_count(10);
+
+	pkt = build_request(&cpkt, options, opt_num, 10);
+	zassert_equal(coap_index_handle_request(&cpkt, &index, options,
+						opt_num), -ENOENT,
+		      "Unknown path matched");
+	net_pkt_unref(pkt);
+}
+
+static void test_observers(void)
+{
+	struct sockaddr_in6 addr = {
+		.sin6_family = AF_INET6,
+		.sin6_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				   0, 0, 0, 0, 0, 0, 0, 0x2 } } },
+	};
+	int i;
+
+	coap_index_init(&index);
+
+	for (i = 0; i < NUM_OBSERVERS; i++) {
+		addr.sin6_port = htons(5683 + i);
+		net_ipaddr_copy(&observers[i].addr, (struct sockaddr *)&addr);
+		coap_index_add_observer(&index, &observers[i]);
+	}
+
+	for (i = 0; i < NUM_OBSERVERS; i++) {
+		addr.sin6_port = htons(5683 + i);
+		zassert_equal_ptr(coap_index_find_observer_by_addr(&index,
+					(struct sockaddr *)&addr),
+				  &observers[i], "Observer %d not found", i);
+	}
+
+	coap_index_remove_observer(&index, &observers[1]);
+
+	addr.sin6_port = htons(5683 + 1);
+	zassert_is_null(coap_index_find_observer_by_addr(&index,
+						(struct sockaddr *)&addr),
+			"Removed observer found");
+
+	addr.sin6_port = htons(5683 + NUM_OBSERVERS);
+	zassert_is_null(coap_index_find_observer_by_addr(&index,
+						(struct sockaddr *)&addr),
+			"Unknown observer found");
+}
+
+static void test_pendings(void)
+{
+	struct coap_option options[4];
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	u8_t opt_num = ARRAY_SIZE(options);
+	int i;
+
+	coap_index_init(&index);
+
+	for (i = 0; i < NUM_PENDINGS; i++) {
+		pendings[i].id = 1000 + i;
+		pendings[i].timeout = CONFIG_COAP_INIT_ACK_TIMEOUT_MS;
+		coap_index_add_pending(&index, &pendings[i]);
+	}
+
+	/* The pending request owns a packet reference, as when cycled */
+	pendings[5].pkt = net_pkt_get_reserve(&coap_pkt_slab, 0, K_NO_WAIT);
+	zassert_not_null(pendings[5].pkt, "Could not get packet from pool");
+
+	pkt = build_msg(&cpkt, options, opt_num, COAP_RESPONSE_CODE_CONTENT,
+			1000 + 5, NULL, 0, -1);
+
+	zassert_equal_ptr(coap_index_pending_received(&cpkt, &index),
+			  &pendings[5], "Pending request not found");
+	zassert_equal(pendings[5].timeout, 0, "Pending request not cleared");
+	zassert_is_null(pendings[5].pkt, "Pending request not cleared");
+
+	/* Removed from the index once received */
+	zassert_is_null(coap_index_pending_received(&cpkt, &index),
+			"Pending request received twice");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_replies(void)
+{
+	struct coap_option options[4];
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	u8_t token[4];
+	u8_t opt_num = ARRAY_SIZE(options);
+	int i;
+
+	coap_index_init(&index);
+
+	for (i = 0; i < NUM_REPLIES; i++) {
+		replies[i].reply = reply_cb;
+		replies[i].id = 2000 + i;
+
+		/* The first one has no token */
+		if (i) {
+			sys_put_be32(0xdead0000 + i, replies[i].token);
+			replies[i].tkl = sizeof(token);
+		}
+
+		coap_index_add_reply(&index, &replies[i]);
+	}
+
+	sys_put_be32(0xdead0000 + 7, token);
+
+	pkt = build_msg(&cpkt, options, opt_num, COAP_RESPONSE_CODE_CONTENT,
+			1, token, sizeof(token), -1);
+
+	replied = NULL;
+	zassert_equal_ptr(coap_index_response_received(&cpkt, NULL, &index),
+			  &replies[7], "Reply not found by token");
+	zassert_equal_ptr(replied, &replies[7], "Reply not called");
+
+	net_pkt_unref(pkt);
+
+	pkt = build_msg(&cpkt, options, opt_num, COAP_RESPONSE_CODE_CONTENT,
+			2000, NULL, 0, -1);
+
+	zassert_equal_ptr(coap_index_response_received(&cpkt, NULL, &index),
+			  &replies[0], "Reply not found by id");
+
+	net_pkt_unref(pkt);
+
+	/* A response without token does not match a request with one */
+	pkt = build_msg(&cpkt, options, opt_num, COAP_RESPONSE_CODE_CONTENT,
+			2000 + 7, NULL, 0, -1);
+
+	zassert_is_null(coap_index_response_received(&cpkt, NULL, &index),
+			"Reply with token found by id");
+
+	net_pkt_unref(pkt);
+
+	coap_index_remove_reply(&index, &replies[7]);
+
+	pkt = build_msg(&cpkt, options, opt_num, COAP_RESPONSE_CODE_CONTENT,
+			1, token, sizeof(token), -1);
+
+	zassert_is_null(coap_index_response_received(&cpkt, NULL, &index),
+			"Removed reply found");
+
+	net_pkt_unref(pkt);
+}
+
+/* Average time to dispatch a request to any of count resources */
+static void bench_dispatch(int count)
+{
+	struct coap_option options[4];
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	u32_t linear = 0, indexed = 0;
+	u32_t start;
+	u8_t opt_num = ARRAY_SIZE(options);
+	int i, j;
+
+	set_resource_count(count);
+
+	for (i = 0; i < count; i++) {
+		pkt = build_request(&cpkt, options, opt_num, i);
+
+		start = k_cycle_get_32();
+		for (j = 0; j < BENCH_ROUNDS; j++) {
+			coap_handle_request(&cpkt, resources, options,
+					    opt_num);
+		}
+		linear += k_cycle_get_32() - start;
+
+		start = k_cycle_get_32();
+		for (j = 0; j < BENCH_ROUNDS; j++) {
+			coap_index_handle_request(&cpkt, &index, options,
+						  opt_num);
+		}
+		indexed += k_cycle_get_32() - start;
+
+		zassert_equal_ptr(handled, &resources[i], "Wrong resource");
+
+		net_pkt_unref(pkt);
+	}
+
+	TC_PRINT("%3d resources: %u cycles linear, %u cycles indexed\n",
+		 count, linear / (count * BENCH_ROUNDS),
+		 indexed / (count * BENCH_ROUNDS));
+}
+
+static void test_dispatch_benchmark(void)
+{
+	bench_dispatch(10);
+	bench_dispatch(100);
+	bench_dispatch(500);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(coap_index,
+			 ztest_unit_test(test_resources),
+			 ztest_unit_test(test_observers),
+			 ztest_unit_test(test_pendings),
+			 ztest_unit_test(test_replies),
+			 ztest_unit_test(test_dispatch_benchmark));
+
+	ztest_run_test_suite(coap_index);
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_DNS_RESOLVER_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <misc/byteorder.h>
+
+#include <net/socket.h>
+#include <net/dns_resolve.h>
+
+#define DNS_PORT 53
+
+#define NAME_WWW	"www.example.com"
+#define NAME_NOTTL	"nottl.example.com"
+#define NAME_NX		"nx.example.com"
+#define NAME_NODATA	"nodata.example.com"
+#define NAME_SLOW	"slow.example.com"
+
+/* Short enough for the tests to wait for the answers to expire */
+#define WWW_TTL		2
+#define NEG_TTL		1
+#define OTHER_TTL	60
+
+#define SLOW_DELAY	K_MSEC(100)
+#define WAIT_TIME	K_SECONDS(1)
+
+#define MAX_ADDRS	4
+#define MAX_MSG_LEN	512
+
+struct result {
+	struct k_sem sem;
+	enum dns_resolve_status status;
+	struct in_addr addr[MAX_ADDRS];
+	int count;
+};
+
+static int server_sock;
+static int query_count;
+
+static K_THREAD_STACK_DEFINE(server_stack, 2048);
+static struct k_thread server_thread;
+
+/* Convert the question name to the dotted form and return its length */
+static int get_qname(const u8_t *buf, int len, char *name, int size)
+{
+	int pos = 12, out = 0;
+
+	while (pos < len && buf[pos]) {
+		int lb_size = buf[pos++];
+
+		if (pos + lb_size > len || out + lb_size + 1 >= size) {
+			return -1;
+		}
+
+		if (out) {
+			name[out++] = '.';
+		}
+
+		memcpy(name + out, buf + pos, lb_size);
+		out += lb_size;
+		pos += lb_size;
+	}
+
+	name[out] = '\0';
+
+	return pos + 1 - 12;
+}
+
+/* Append a record whose name points to the question */
+static int append_rr(u8_t *buf, int pos, u16_t type, u32_t ttl,
+		     const u8_t *rdata, u16_t rdlength)
+{
+	buf[pos++] = 0xc0;
+	buf[pos++] = 12;
+	sys_put_be16(type, buf + pos);
+	sys_put_be16(1, buf + pos + 2);
+	sys_put_be32(ttl, buf + pos + 4);
+	sys_put_be16(rdlength, buf + pos + 8);
+	memcpy(buf + pos + 10, rdata, rdlength);
+
+	return pos + 10 + rdlength;
+}
+
+/* Root names for MNAME and RNAME, then serial, refresh, retry, expire and
+ * minimum.
+ */
+static int append_soa(u8_t *buf, int pos, u32_t minimum)
+{
+	u8_t soa[2 + 5 * sizeof(u32_t)] = { 0 };
+
+	sys_put_be32(minimum, soa + sizeof(soa) - sizeof(u32_t));
+
+	return append_rr(buf, pos, 6, OTHER_TTL, soa, sizeof(soa));
+}
+
+static void server(void *p1, void *p2, void *p3)
+{
+	static u8_t buf[MAX_MSG_LEN];
+	struct sockaddr addr;
+	socklen_t addrlen;
+	char name[64];
+	u8_t ip[4] = { 192, 0, 2, 10 };
+	int len, pos, ancount, nscount;
+
+	while (1) {
+		addrlen = sizeof(addr);
+		len = recvfrom(server_sock, buf, sizeof(buf), 0, &addr,
+			       &addrlen);
+		if (len < 12) {
+			continue;
+		}
+
+		pos = get_qname(buf, len, name, sizeof(name));
+		if (pos < 0 || 12 + pos + 4 > len) {
+			continue;
+		}
+
+		/* Question name, type and class */
+		pos += 12 + 4;
+		ancount = 0;
+		nscount = 0;
+
+		query_count++;
+
+		/* QR and RA */
+		buf[2] |= 0x80;
+		buf[3] = 0x80;
+
+		if (!strcmp(name, NAME_NX)) {
+			buf[3] |= 3;
+			pos = append_soa(buf, pos, NEG_TTL);
+			nscount++;
+		} else if (!strcmp(name, NAME_NODATA)) {
+			pos = append_soa(buf, pos, OTHER_TTL);
+			nscount++;
+		} else if (!strcmp(name, NAME_WWW)) {
+			ip[3] = 10;
+			pos = append_rr(buf, pos, 1, WWW_TTL, ip, sizeof(ip));
+			ip[3] = 11;
+			pos = append_rr(buf, pos, 1, WWW_TTL, ip, sizeof(ip));
+			ancount = 2;
+		} else {
+			ip[3] = 20;
+			pos = append_rr(buf, pos, 1,
+					strcmp(name, NAME_NOTTL) ?
+					OTHER_TTL : 0, ip, sizeof(ip));
+			ancount = 1;
+		}
+
+		sys_put_be16(ancount, buf + 6);
+		sys_put_be16(nscount, buf + 8);
+		sys_put_be16(0, buf + 10);
+
+		if (!strcmp(name, NAME_SLOW)) {
+			k_sleep(SLOW_DELAY);
+		}
+
+		sendto(server_sock, buf, pos, 0, &addr, addrlen);
+	}
+}
+
+static void resolve_cb(enum dns_resolve_status status,
+		       struct dns_addrinfo *info, void *user_data)
+{
+	struct result *res = user_data;
+
+	if (info) {
+		if (res->count < MAX_ADDRS) {
+			res->addr[res->count] =
+				net_sin(&info->ai_addr)->sin_addr;
+		}
+
+		res->count++;
+		return;
+	}
+
+	res->status = status;
+	k_sem_give(&res->sem);
+}
+
+static void resolve_start(const char *name, struct result *res)
+{
+	int ret;
+
+	memset(res, 0, sizeof(*res));
+	k_sem_init(&res->sem, 0, 1);
+
+	ret = dns_get_addr_info(name, DNS_QUERY_TYPE_A, NULL, resolve_cb,
+				res, WAIT_TIME);
+	zassert_equal(ret, 0, "Cannot resolve %s (%d)", name, ret);
+}
+
+static void resolve_wait(struct result *res)
+{
+	zassert_equal(k_sem_take(&res->sem, WAIT_TIME), 0,
+		      "No answer received");
+}
+
+/* Resolve a name and return the number of queries sent for it */
+static int resolve(const char *name, struct result *res)
+{
+	int count = query_count;
+
+	resolve_start(name, res);
+	resolve_wait(res);
+
+	return query_count - count;
+}
+
+static void check_www(struct result *res)
+{
+	zassert_equal(res->status, DNS_EAI_ALLDONE, "Invalid status %d",
+		      res->status);
+	zassert_equal(res->count, 2, "Invalid address count %d",
+		      res->count);
+	zassert_equal(res->addr[0].s4_addr[3], 10, "Invalid address");
+	zassert_equal(res->addr[1].s4_addr[3], 11, "Invalid address");
+}
+
+static void test_init(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(DNS_PORT),
+	};
+
+	server_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "socket open failed");
+
+	zassert_equal(bind(server_sock, (struct sockaddr *)&addr,
+			   sizeof(addr)), 0, "bind failed");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+static void test_cache_hit(void)
+{
+	struct result res;
+
+	dns_cache_flush();
+
+	zassert_equal(resolve(NAME_WWW, &res), 1, "Query not sent");
+	check_www(&res);
+
+	/* Answered from the cache before the call returns */
+	resolve_start(NAME_WWW, &res);
+	zassert_equal(k_sem_count_get(&res.sem), 1, "Not answered from cache");
+	resolve_wait(&res);
+	check_www(&res);
+
+	/* Names are case insensitive */
+	zassert_equal(resolve("WWW.Example.COM", &res), 0,
+		      "Query sent for cached name");
+	check_www(&res);
+}
+
+static void test_ttl(void)
+{
+	struct result res;
+
+	k_sleep(K_SECONDS(WWW_TTL + 1));
+
+	zassert_equal(resolve(NAME_WWW, &res), 1,
+		      "Expired answer used");
+	check_www(&res);
+
+	zassert_equal(resolve(NAME_NOTTL, &res), 1, "Query not sent");
+	zassert_equal(res.status, DNS_EAI_ALLDONE, "Invalid status %d",
+		      res.status);
+	zassert_equal(resolve(NAME_NOTTL, &res), 1,
+		      "Answer with zero TTL cached");
+}
+
+static void test_negative(void)
+{
+	struct result res;
+
+	zassert_equal(resolve(NAME_NX, &res), 1, "Query not sent");
+	zassert_equal(res.status, DNS_EAI_NONAME, "Invalid status %d",
+		      res.status);
+
+	zassert_equal(resolve(NAME_NX, &res), 0,
+		      "Negative answer not cached");
+	zassert_equal(res.status, DNS_EAI_NONAME, "Invalid status %d",
+		      res.status);
+
+	zassert_equal(resolve(NAME_NODATA, &res), 1, "Query not sent");
+	zassert_equal(res.status, DNS_EAI_NODATA, "Invalid status %d",
+		      res.status);
+
+	zassert_equal(resolve(NAME_NODATA, &res), 0,
+		      "Negative answer not cached");
+	zassert_equal(res.status, DNS_EAI_NODATA, "Invalid status %d",
+		      res.status);
+
+	/* The SOA minimum limits the time a negative answer is cached */
+	k_sleep(K_SECONDS(NEG_TTL + 1));
+
+	zassert_equal(resolve(NAME_NX, &res), 1,
+		      "Expired negative answer used");
+}
+
+static void test_coalesce(void)
+{
+	struct result res1, res2;
+	int count = query_count;
+
+	resolve_start(NAME_SLOW, &res1);
+	resolve_start(NAME_SLOW, &res2);
+
+	resolve_wait(&res1);
+	resolve_wait(&res2);
+
+	zassert_equal(query_count - count, 1, "Duplicate query sent");
+
+	zassert_equal(res1.status, DNS_EAI_ALLDONE, "Invalid status");
+	zassert_equal(res1.count, 1, "Invalid address count");
+	zassert_equal(res2.status, DNS_EAI_ALLDONE, "Invalid status");
+	zassert_equal(res2.count, 1, "Invalid address count");
+}
+
+static void cache_cb(const struct dns_cache_info *info, void *user_data)
+{
+	const char **names = user_data;
+
+	while (*names) {
+		names++;
+	}
+
+	*names = info->name;
+}
+
+static void test_lru(void)
+{
+	const char *names[CONFIG_DNS_RESOLVER_CACHE_SIZE + 1];
+	struct result res;
+
+	dns_cache_flush();
+
+	resolve("a.example.com", &res);
+	resolve("b.example.com", &res);
+	resolve("c.example.com", &res);
+
+	/* The use makes a the most recently used one, so b is dropped */
+	zassert_equal(resolve("a.example.com", &res), 0, "Not cached");
+	zassert_equal(resolve("d.example.com", &res), 1, "Query not sent");
+
+	memset(names, 0, sizeof(names));
+	zassert_equal(dns_cache_foreach(cache_cb, names),
+		      CONFIG_DNS_RESOLVER_CACHE_SIZE, "Invalid entry count");
+
+	zassert_equal(strcmp(names[0], "d.example.com"), 0, "Invalid order");
+	zassert_equal(strcmp(names[1], "a.example.com"), 0, "Invalid order");
+	zassert_equal(strcmp(names[2], "c.example.com"), 0, "Invalid order");
+
+	dns_cache_flush();
+
+	zassert_equal(dns_cache_foreach(cache_cb, names), 0,
+		      "Cache not flushed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dns_cache,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_cache_hit),
+			 ztest_unit_test(test_ttl),
+			 ztest_unit_test(test_negative),
+			 ztest_unit_test(test_coalesce),
+			 ztest_unit_test(test_lru));
+
+	ztest_run_test_suite(dns_cache);
+}
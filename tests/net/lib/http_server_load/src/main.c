@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_HTTP_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/http.h>
+
+#define SERVER_PORT 8080
+
+/* Number of requests of each measure */
+#define REQUESTS 200
+
+/* Number of requests sent at once when pipelining */
+#define PIPELINE 8
+
+#define POLL_TIMEOUT 2000
+
+#define STATIC_URL "/static"
+#define CHUNKED_URL "/chunked"
+
+#define GET_STATIC "GET " STATIC_URL " HTTP/1.1\r\n" \
+		   "Host: 192.0.2.1\r\n" \
+		   "\r\n"
+#define GET_STATIC_CLOSE "GET " STATIC_URL " HTTP/1.1\r\n" \
+			 "Host: 192.0.2.1\r\n" \
+			 "Connection: close\r\n" \
+			 "\r\n"
+#define GET_CHUNKED "GET " CHUNKED_URL " HTTP/1.1\r\n" \
+		    "Host: 192.0.2.1\r\n" \
+		    "\r\n"
+
+#define BODY "<html><body>Hello from the static response path, which " \
+	     "sends this body without copying it.</body></html>"
+
+#define STATIC_RESPONSE "HTTP/1.1 200 OK\r\n" \
+			"Content-Type: text/html\r\n" \
+			"Content-Length: 104\r\n" \
+			"\r\n" \
+			BODY
+
+#define CHUNK_1 "Hello "
+#define CHUNK_2 "chunked world"
+
+#define CHUNKED_RESPONSE "HTTP/1.1 200 OK\r\n" \
+			 "Content-Type: text/plain\r\n" \
+			 "Transfer-Encoding: chunked\r\n" \
+			 "\r\n" \
+			 "6\r\n" CHUNK_1 "\r\n" \
+			 "d\r\n" CHUNK_2 "\r\n" \
+			 "0\r\n" \
+			 "\r\n"
+
+static const char body[] = BODY;
+
+static struct http_ctx http_ctx;
+static struct http_server_urls http_urls;
+static u8_t request_buf[1024];
+
+static char response[PIPELINE * sizeof(STATIC_RESPONSE)];
+
+static u32_t latency[REQUESTS];
+
+static void http_connected(struct http_ctx *ctx,
+			   enum http_connection_type type,
+			   const struct sockaddr *dst,
+			   void *user_data)
+{
+	if (!strncmp(ctx->http.url, CHUNKED_URL, ctx->http.url_len)) {
+		http_add_chunked_header(ctx, "HTTP/1.1 200 OK\r\n",
+					"text/plain", dst, NULL);
+		http_send_chunk(ctx, CHUNK_1, sizeof(CHUNK_1) - 1, dst, NULL);
+		http_send_chunk(ctx, CHUNK_2, sizeof(CHUNK_2) - 1, dst, NULL);
+		http_send_chunk(ctx, NULL, 0, dst, NULL);
+		http_send_flush(ctx, NULL);
+		return;
+	}
+
+	http_send_static_response(ctx, "HTTP/1.1 200 OK\r\n", "text/html",
+				  body, sizeof(body) - 1, dst, NULL);
+}
+
+static int client_connect(void)
+{
+	struct sockaddr_in addr;
+	int sock;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SERVER_PORT);
+	zassert_equal(inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				&addr.sin_addr), 1, "Invalid address");
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "Cannot create socket");
+
+	zassert_equal(connect(sock, (struct sockaddr *)&addr, sizeof(addr)),
+		      0, "Cannot connect");
+
+	return sock;
+}
+
+static void client_send(int sock, const char *data, size_t len)
+{
+	ssize_t sent;
+
+	while (len) {
+		sent = send(sock, data, len, 0);
+		zassert_true(sent > 0, "Cannot send");
+
+		data += sent;
+		len -= sent;
+	}
+}
+
+/* Receives exactly len bytes */
+static void client_recv(int sock, char *data, size_t len)
+{
+	struct pollfd pfd = { .fd = sock, .events = POLLIN };
+	ssize_t received;
+
+	while (len) {
+		zassert_equal(poll(&pfd, 1, POLL_TIMEOUT), 1,
+			      "No response");
+
+		received = recv(sock, data, len, 0);
+		zassert_true(received > 0, "Connection closed");
+
+		data += received;
+		len -= received;
+	}
+}
+
+/* Checks that the server closed the connection */
+static void client_recv_close(int sock)
+{
+	struct pollfd pfd = { .fd = sock, .events = POLLIN };
+	char c;
+
+	zassert_equal(poll(&pfd, 1, POLL_TIMEOUT), 1, "Not closed");
+	zassert_true(recv(sock, &c, 1, 0) <= 0, "Unexpected data");
+}
+
+static void print_stats(const char *name, u32_t time)
+{
+	u32_t tmp;
+	int i, j;
+
+	/* Few enough values for an insertion sort */
+	for (i = 1; i < REQUESTS; i++) {
+		tmp = latency[i];
+
+		for (j = i; j > 0 && latency[j - 1] > tmp; j--) {
+			latency[j] = latency[j - 1];
+		}
+
+		latency[j] = tmp;
+	}
+
+	TC_PRINT("%s: %u requests in %u ms", name, REQUESTS, time);
+	if (time) {
+		TC_PRINT(", %u requests/s", REQUESTS * MSEC_PER_SEC / time);
+	}
+
+	TC_PRINT(", latency p50 %u us p90 %u us p99 %u us\n",
+		 latency[REQUESTS / 2], latency[REQUESTS * 9 / 10],
+		 latency[REQUESTS * 99 / 100]);
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in addr;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SERVER_PORT);
+	addr.sin_addr.s_addr = INADDR_ANY;
+
+	zassert_not_null(http_server_add_url(&http_urls, STATIC_URL,
+					     HTTP_URL_STANDARD),
+			 "Cannot add URL");
+	zassert_not_null(http_server_add_url(&http_urls, CHUNKED_URL,
+					     HTTP_URL_STANDARD),
+			 "Cannot add URL");
+
+	zassert_equal(http_server_init(&http_ctx, &http_urls,
+				       (struct sockaddr *)&addr,
+				       request_buf, sizeof(request_buf),
+				       NULL, NULL), 0, "Cannot init server");
+	zassert_equal(http_set_cb(&http_ctx, http_connected, NULL, NULL,
+				  NULL), 0, "Cannot set callbacks");
+	zassert_equal(http_server_enable(&http_ctx), 0,
+		      "Cannot enable server");
+}
+
+/* One request after the other on a persistent connection */
+static void test_keepalive(void)
+{
+	u32_t start, sent;
+	int sock, i;
+
+	sock = client_connect();
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < REQUESTS; i++) {
+		sent = k_cycle_get_32();
+
+		client_send(sock, GET_STATIC, sizeof(GET_STATIC) - 1);
+		client_recv(sock, response, sizeof(STATIC_RESPONSE) - 1);
+
+		latency[i] = SYS_CLOCK_HW_CYCLES_TO_NS(k_cycle_get_32() -
+						       sent) / NSEC_PER_USEC;
+
+		zassert_false(memcmp(response, STATIC_RESPONSE,
+				     sizeof(STATIC_RESPONSE) - 1),
+			      "Invalid response");
+	}
+
+	print_stats("keep-alive", k_uptime_get_32() - start);
+
+	close(sock);
+}
+
+/* Batches of requests sent without waiting for the responses */
+static void test_pipelining(void)
+{
+	char requests[PIPELINE * (sizeof(GET_STATIC) - 1)];
+	const size_t len = sizeof(STATIC_RESPONSE) - 1;
+	u32_t start, sent;
+	int sock, i, j;
+
+	for (j = 0; j < PIPELINE; j++) {
+		memcpy(requests + j * (sizeof(GET_STATIC) - 1), GET_STATIC,
+		       sizeof(GET_STATIC) - 1);
+	}
+
+	sock = client_connect();
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < REQUESTS; i += PIPELINE) {
+		sent = k_cycle_get_32();
+
+		client_send(sock, requests, sizeof(requests));
+
+		for (j = 0; j < PIPELINE; j++) {
+			client_recv(sock, response + j * len, len);
+
+			latency[i + j] =
+				SYS_CLOCK_HW_CYCLES_TO_NS(k_cycle_get_32() -
+							  sent) /
+				NSEC_PER_USEC;
+
+			zassert_false(memcmp(response + j * len,
+					     STATIC_RESPONSE, len),
+				      "Invalid response %d", i + j);
+		}
+	}
+
+	print_stats("pipelining", k_uptime_get_32() - start);
+
+	close(sock);
+}
+
+static void test_chunked(void)
+{
+	int sock;
+
+	sock = client_connect();
+
+	client_send(sock, GET_CHUNKED, sizeof(GET_CHUNKED) - 1);
+	client_recv(sock, response, sizeof(CHUNKED_RESPONSE) - 1);
+
+	zassert_false(memcmp(response, CHUNKED_RESPONSE,
+			     sizeof(CHUNKED_RESPONSE) - 1),
+		      "Invalid response");
+
+	close(sock);
+}
+
+static void test_connection_close(void)
+{
+	int sock;
+
+	sock = client_connect();
+
+	client_send(sock, GET_STATIC_CLOSE, sizeof(GET_STATIC_CLOSE) - 1);
+	client_recv(sock, response, sizeof(STATIC_RESPONSE) - 1);
+	client_recv_close(sock);
+
+	close(sock);
+}
+
+static void test_bad_request(void)
+{
+	static const char request[] = "GARBAGE\r\n\r\n";
+	static const char status[] = "HTTP/1.1 400 Bad Request\r\n";
+	int sock;
+
+	sock = client_connect();
+
+	client_send(sock, request, sizeof(request) - 1);
+	client_recv(sock, response, sizeof(status) - 1);
+
+	zassert_false(memcmp(response, status, sizeof(status) - 1),
+		      "Invalid response");
+
+	close(sock);
+}
+
+static void test_max_connections(void)
+{
+	int sock1, sock2;
+
+	zassert_equal(http_server_set_max_connections(&http_ctx, 1), 0,
+		      "Cannot set the limit");
+
+	sock1 = client_connect();
+
+	/* The first connection is accepted before the second one */
+	client_send(sock1, GET_STATIC, sizeof(GET_STATIC) - 1);
+	client_recv(sock1, response, sizeof(STATIC_RESPONSE) - 1);
+
+	sock2 = client_connect();
+	client_recv_close(sock2);
+	close(sock2);
+
+	/* The first connection is still served */
+	client_send(sock1, GET_STATIC, sizeof(GET_STATIC) - 1);
+	client_recv(sock1, response, sizeof(STATIC_RESPONSE) - 1);
+
+	close(sock1);
+
+	zassert_equal(http_server_set_max_connections(&http_ctx, 0), 0,
+		      "Cannot remove the limit");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_server_load,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_keepalive),
+			 ztest_unit_test(test_pipelining),
+			 ztest_unit_test(test_chunked),
+			 ztest_unit_test(test_connection_close),
+			 ztest_unit_test(test_bad_request),
+			 ztest_unit_test(test_max_connections));
+
+	ztest_run_test_suite(http_server_load);
+}
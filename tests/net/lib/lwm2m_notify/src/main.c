@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_context.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+
+/* The test is the LwM2M server of the engine, both over the loopback */
+#define SERVER_PORT 5683
+
+#define TEST_OBJ_ID 32769
+#define COUNT_ID 0
+#define STEP_ID 1
+#define RANGE_ID 2
+
+/* Events fired within pmin, sent as one notification */
+#define EVENTS 5
+
+#define WAIT_TIME K_SECONDS(3)
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_field fields[] = {
+	OBJ_FIELD_DATA(COUNT_ID, R, S32),
+	OBJ_FIELD_DATA(STEP_ID, R, S32),
+	OBJ_FIELD_DATA(RANGE_ID, R, S32),
+};
+
+static struct lwm2m_engine_obj_inst inst;
+static struct lwm2m_engine_res_inst res[ARRAY_SIZE(fields)];
+static s32_t count;
+static s32_t step;
+static s32_t range;
+
+static struct lwm2m_ctx client;
+static struct net_context *server_ctx;
+static struct sockaddr_in server_addr;
+static struct sockaddr_in client_addr;
+
+static K_FIFO_DEFINE(rx_fifo);
+
+static struct lwm2m_engine_obj_inst *test_obj_create(u16_t obj_inst_id)
+{
+	int i = 0;
+
+	if (inst.obj) {
+		return NULL;
+	}
+
+	INIT_OBJ_RES_DATA(res, i, COUNT_ID, &count, sizeof(count));
+	INIT_OBJ_RES_DATA(res, i, STEP_ID, &step, sizeof(step));
+	INIT_OBJ_RES_DATA(res, i, RANGE_ID, &range, sizeof(range));
+
+	inst.resources = res;
+	inst.resource_count = i;
+
+	return &inst;
+}
+
+static void recv_cb(struct net_context *context, struct net_pkt *pkt,
+		    int status, void *user_data)
+{
+	if (pkt) {
+		k_fifo_put(&rx_fifo, pkt);
+	}
+}
+
+static void addr_setup(struct sockaddr_in *addr, u16_t port)
+{
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	zassert_true(net_addr_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				   &addr->sin_addr) == 0, "Invalid address");
+}
+
+static struct net_pkt *pkt_alloc(void)
+{
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+
+	pkt = net_pkt_get_tx(server_ctx, K_FOREVER);
+	zassert_not_null(pkt, "Cannot get packet");
+
+	frag = net_pkt_get_data(server_ctx, K_FOREVER);
+	zassert_not_null(frag, "Cannot get data");
+
+	net_pkt_frag_add(pkt, frag);
+
+	return pkt;
+}
+
+static void pkt_send(struct net_pkt *pkt)
+{
+	zassert_equal(net_context_sendto(pkt, (struct sockaddr *)&client_addr,
+					 sizeof(client_addr), NULL, K_NO_WAIT,
+					 NULL, NULL), 0, "Cannot send");
+}
+
+/* Sends a request on 32769/0/<res_id>, with an observe option if >= 0 */
+static void send_request(u8_t method, u16_t res_id, const char *token,
+			 int observe, const char * const *queries)
+{
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+	char id[6];
+
+	pkt = pkt_alloc();
+
+	zassert_equal(coap_packet_init(&cpkt, pkt, 1, COAP_TYPE_CON,
+				       strlen(token), (u8_t *)token, method,
+				       coap_next_id()), 0, "Cannot init");
+
+	if (observe >= 0) {
+		zassert_equal(coap_append_option_int(&cpkt,
+						     COAP_OPTION_OBSERVE,
+						     observe), 0,
+			      "Cannot append observe");
+	}
+
+	snprintf(id, sizeof(id), "%u", TEST_OBJ_ID);
+	coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, id,
+				  strlen(id));
+	coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, "0", 1);
+	snprintf(id, sizeof(id), "%u", res_id);
+	coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, id,
+				  strlen(id));
+
+	while (queries && *queries) {
+		coap_packet_append_option(&cpkt, COAP_OPTION_URI_QUERY,
+					  *queries, strlen(*queries));
+		queries++;
+	}
+
+	pkt_send(pkt);
+}
+
+/* The engine answers the requests with piggybacked responses */
+static void wait_response(u8_t code)
+{
+	struct coap_packet cpkt;
+	struct net_pkt *pkt;
+
+	pkt = k_fifo_get(&rx_fifo, WAIT_TIME);
+	zassert_not_null(pkt, "No response");
+	zassert_equal(coap_packet_parse(&cpkt, pkt, NULL, 0), 0,
+		      "Cannot parse response");
+	zassert_equal(coap_header_get_type(&cpkt), COAP_TYPE_ACK,
+		      "Response is not an ACK");
+	zassert_equal(coap_header_get_code(&cpkt), code,
+		      "Request failed (%u)", coap_header_get_code(&cpkt));
+
+	net_pkt_unref(pkt);
+}
+
+static void write_attrs(u16_t res_id, const char * const *queries)
+{
+	send_request(COAP_METHOD_PUT, res_id, "wa", -1, queries);
+	wait_response(COAP_RESPONSE_CODE_CHANGED);
+}
+
+static void observe(u16_t res_id, const char *token)
+{
+	send_request(COAP_METHOD_GET, res_id, token, 0, NULL);
+	wait_response(COAP_RESPONSE_CODE_CONTENT);
+}
+
+/* Counts the notifications received for a while, acknowledging them */
+static int wait_notifications(s32_t timeout)
+{
+	struct coap_packet cpkt, ack;
+	struct net_pkt *pkt, *ack_pkt;
+	int notified = 0;
+	s64_t end = k_uptime_get() + timeout;
+	s64_t now;
+
+	while ((now = k_uptime_get()) < end) {
+		pkt = k_fifo_get(&rx_fifo, end - now);
+		if (!pkt) {
+			break;
+		}
+
+		zassert_equal(coap_packet_parse(&cpkt, pkt, NULL, 0), 0,
+			      "Cannot parse notification");
+		zassert_equal(coap_header_get_type(&cpkt), COAP_TYPE_CON,
+			      "Notification is not confirmable");
+		zassert_equal(coap_header_get_code(&cpkt),
+			      COAP_RESPONSE_CODE_CONTENT,
+			      "Invalid notification");
+
+		ack_pkt = pkt_alloc();
+		zassert_equal(coap_packet_init(&ack, ack_pkt, 1, COAP_TYPE_ACK,
+					       0, NULL, COAP_CODE_EMPTY,
+					       coap_header_get_id(&cpkt)), 0,
+			      "Cannot init ACK");
+		pkt_send(ack_pkt);
+
+		net_pkt_unref(pkt);
+		notified++;
+	}
+
+	return notified;
+}
+
+static void test_setup(void)
+{
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = 1;
+	test_obj.create_cb = test_obj_create;
+	lwm2m_register_obj(&test_obj);
+
+	zassert_equal(lwm2m_engine_create_obj_inst("32769/0"), 0,
+		      "Cannot create instance");
+
+	addr_setup(&server_addr, SERVER_PORT);
+	addr_setup(&client_addr, CONFIG_LWM2M_LOCAL_PORT);
+
+	zassert_equal(net_context_get(AF_INET, SOCK_DGRAM, IPPROTO_UDP,
+				      &server_ctx), 0, "Cannot get context");
+	zassert_equal(net_context_bind(server_ctx,
+				       (struct sockaddr *)&server_addr,
+				       sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(net_context_recv(server_ctx, recv_cb, K_NO_WAIT, NULL),
+		      0, "Cannot receive");
+
+	client.net_init_timeout = WAIT_TIME;
+	client.net_timeout = WAIT_TIME;
+	zassert_equal(lwm2m_engine_start(&client,
+					 CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+					 SERVER_PORT), 0, "Cannot start");
+}
+
+/* The events within pmin are sent as one notification */
+static void test_coalesce(void)
+{
+	static const char * const attrs[] = { "pmin=1", "pmax=60", NULL };
+	struct lwm2m_notify_stats stats = client.notify_stats;
+	int i;
+
+	write_attrs(COUNT_ID, attrs);
+	observe(COUNT_ID, "co");
+
+	for (i = 0; i < EVENTS; i++) {
+		count++;
+		zassert_equal(lwm2m_notify_observer(TEST_OBJ_ID, 0, COUNT_ID),
+			      1, "Observer not found");
+	}
+
+	zassert_equal(wait_notifications(WAIT_TIME), 1,
+		      "Events not coalesced");
+
+	zassert_equal(client.notify_stats.events - stats.events, EVENTS,
+		      "Events not counted");
+	zassert_equal(client.notify_stats.coalesced - stats.coalesced,
+		      EVENTS - 1, "Coalesced events not counted");
+	zassert_equal(client.notify_stats.filtered - stats.filtered, 0,
+		      "Events filtered");
+	zassert_equal(client.notify_stats.sent - stats.sent, 1,
+		      "Notification not counted");
+}
+
+/* The changes below st, or which do not cross gt or lt, are not sent */
+static void test_filter(void)
+{
+	static const char * const step_attrs[] = {
+		"pmin=1", "pmax=60", "st=5", NULL
+	};
+	static const char * const range_attrs[] = {
+		"pmin=1", "pmax=60", "gt=20", "lt=-20", NULL
+	};
+	struct lwm2m_notify_stats stats = client.notify_stats;
+
+	write_attrs(STEP_ID, step_attrs);
+	write_attrs(RANGE_ID, range_attrs);
+	observe(STEP_ID, "st");
+	observe(RANGE_ID, "ra");
+
+	step = 2;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, STEP_ID);
+	step = 4;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, STEP_ID);
+
+	range = 10;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, RANGE_ID);
+	range = -10;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, RANGE_ID);
+
+	zassert_equal(wait_notifications(WAIT_TIME), 0,
+		      "Changes below the thresholds notified");
+	zassert_equal(client.notify_stats.filtered - stats.filtered, 4,
+		      "Changes below the thresholds not filtered");
+
+	/* a step of st, and crossing gt */
+	step = 9;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, STEP_ID);
+	range = 25;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, RANGE_ID);
+
+	zassert_equal(wait_notifications(WAIT_TIME), 2,
+		      "Changes above the thresholds not notified");
+	zassert_equal(client.notify_stats.filtered - stats.filtered, 4,
+		      "Changes above the thresholds filtered");
+	zassert_equal(client.notify_stats.sent - stats.sent, 2,
+		      "Notifications not counted");
+
+	/* the values notified are the new reference */
+	step = 12;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, STEP_ID);
+	range = 30;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, RANGE_ID);
+
+	zassert_equal(client.notify_stats.filtered - stats.filtered, 6,
+		      "Reference not updated");
+}
+
+/* Past the burst, the notifications due wait for the bucket to refill */
+static void test_rate_limit(void)
+{
+#if CONFIG_LWM2M_ENGINE_NOTIFY_BURST > 0
+	int burst = min(3, CONFIG_LWM2M_ENGINE_NOTIFY_BURST);
+	struct lwm2m_notify_stats stats;
+
+	/* a full bucket */
+	k_sleep(CONFIG_LWM2M_ENGINE_NOTIFY_BURST *
+		CONFIG_LWM2M_ENGINE_NOTIFY_PERIOD);
+	stats = client.notify_stats;
+
+	/* all three are due at once, the engine must not run in between */
+	k_sched_lock();
+	count++;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, COUNT_ID);
+	step += 10;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, STEP_ID);
+	range = -30;
+	lwm2m_notify_observer(TEST_OBJ_ID, 0, RANGE_ID);
+	k_sched_unlock();
+
+	/* the engine runs every 500 ms, before the next token is given */
+	zassert_equal(wait_notifications(K_MSEC(750)), burst,
+		      "Burst not limited");
+
+	/* the notification held back is sent once the bucket refills */
+	zassert_equal(wait_notifications(WAIT_TIME), 3 - burst,
+		      "Notification held back lost");
+
+	zassert_equal(client.notify_stats.rate_limited - stats.rate_limited,
+		      3 - burst, "Notifications held back not counted once");
+	zassert_equal(client.notify_stats.sent - stats.sent, 3,
+		      "Notifications not counted");
+#else
+	ztest_test_skip();
+#endif
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_notify,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_coalesce),
+			 ztest_unit_test(test_filter),
+			 ztest_unit_test(test_rate_limit));
+
+	ztest_run_test_suite(lwm2m_notify);
+}
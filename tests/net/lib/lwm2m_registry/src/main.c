@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <net/lwm2m.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+
+/* A vendor object with many instances, like a gateway reporting the
+ * sensors behind it.
+ */
+#define TEST_OBJ_ID 32769
+#define VALUE_ID 5700
+#define COUNTER_ID 5750
+
+#define MAX_INSTANCES 200
+
+/* Operations of each measure of the benchmark */
+#define BENCH_OPS 2000
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_field fields[] = {
+	OBJ_FIELD_DATA(VALUE_ID, R, FLOAT32),
+	OBJ_FIELD_DATA(COUNTER_ID, RW, S32),
+};
+
+static struct lwm2m_engine_obj_inst inst[MAX_INSTANCES];
+static struct lwm2m_engine_res_inst res[MAX_INSTANCES][ARRAY_SIZE(fields)];
+static float32_value_t value[MAX_INSTANCES];
+static s32_t counter[MAX_INSTANCES];
+
+static char paths[MAX_INSTANCES][24];
+static struct lwm2m_engine_res_handle handles[MAX_INSTANCES];
+
+static u8_t rd_data[MAX_INSTANCES * 16];
+
+static struct lwm2m_engine_obj_inst *test_obj_create(u16_t obj_inst_id)
+{
+	int i = 0;
+
+	if (obj_inst_id >= MAX_INSTANCES || inst[obj_inst_id].obj) {
+		return NULL;
+	}
+
+	value[obj_inst_id].val1 = 0;
+	value[obj_inst_id].val2 = 0;
+	counter[obj_inst_id] = 0;
+
+	INIT_OBJ_RES_DATA(res[obj_inst_id], i, VALUE_ID, &value[obj_inst_id],
+			  sizeof(value[obj_inst_id]));
+	INIT_OBJ_RES_DATA(res[obj_inst_id], i, COUNTER_ID,
+			  &counter[obj_inst_id], sizeof(counter[obj_inst_id]));
+
+	inst[obj_inst_id].resources = res[obj_inst_id];
+	inst[obj_inst_id].resource_count = i;
+
+	return &inst[obj_inst_id];
+}
+
+static int test_obj_delete(u16_t obj_inst_id)
+{
+	/* the engine clears the instance */
+	return 0;
+}
+
+static void create_inst(int id)
+{
+	char path[16];
+
+	snprintf(path, sizeof(path), "%u/%d", TEST_OBJ_ID, id);
+	zassert_equal(lwm2m_engine_create_obj_inst(path), 0,
+		      "Cannot create instance %d", id);
+}
+
+static void test_setup(void)
+{
+	int i;
+
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = MAX_INSTANCES;
+	test_obj.create_cb = test_obj_create;
+	test_obj.delete_cb = test_obj_delete;
+	lwm2m_register_obj(&test_obj);
+
+	/* out of order, the registry sorts them */
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		create_inst((i * 7) % MAX_INSTANCES);
+	}
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		snprintf(paths[i], sizeof(paths[i]), "%u/%d/%u",
+			 TEST_OBJ_ID, i, COUNTER_ID);
+	}
+}
+
+static void test_lookup(void)
+{
+	s32_t v;
+	int i;
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		zassert_equal(lwm2m_engine_set_s32(paths[i], i * 3), 0,
+			      "Cannot set %s", paths[i]);
+	}
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		zassert_equal(lwm2m_engine_get_s32(paths[i], &v), 0,
+			      "Cannot get %s", paths[i]);
+		zassert_equal(v, i * 3, "Wrong value for %s", paths[i]);
+		zassert_equal(counter[i], i * 3, "Wrong resource for %s",
+			      paths[i]);
+	}
+
+	zassert_equal(lwm2m_engine_get_s32("32769/200/5750", &v), -ENOENT,
+		      "Unknown instance found");
+	zassert_equal(lwm2m_engine_get_s32("32770/0/5750", &v), -ENOENT,
+		      "Unknown object found");
+	zassert_equal(lwm2m_engine_get_s32("32769/0/5751", &v), -ENOENT,
+		      "Unknown resource found");
+}
+
+/* The registration lists the instances of each object in order */
+static void test_order(void)
+{
+	char expected[16];
+	char *pos;
+	int i;
+
+	lwm2m_get_rd_data(rd_data, sizeof(rd_data));
+
+	pos = strstr((char *)rd_data, "</32769/");
+	zassert_not_null(pos, "Object not registered");
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		snprintf(expected, sizeof(expected), "</%u/%d>",
+			 TEST_OBJ_ID, i);
+		zassert_equal(strncmp(pos, expected, strlen(expected)), 0,
+			      "Instance %d out of order", i);
+
+		pos += strlen(expected);
+		if (*pos == ',') {
+			pos++;
+		}
+	}
+}
+
+static void test_handle(void)
+{
+	struct lwm2m_engine_res_handle handle;
+	float32_value_t f = { 21, 500000 }, g;
+	s32_t v;
+
+	zassert_equal(lwm2m_engine_get_handle("32769/5/5700", &handle), 0,
+		      "Cannot get handle");
+
+	zassert_equal(lwm2m_engine_handle_set_float32(&handle, &f), 0,
+		      "Cannot set through handle");
+	zassert_equal(lwm2m_engine_get_float32("32769/5/5700", &g), 0,
+		      "Cannot get");
+	zassert_true(g.val1 == f.val1 && g.val2 == f.val2, "Wrong value");
+
+	f.val1 = -4;
+	zassert_equal(lwm2m_engine_set_float32("32769/5/5700", &f), 0,
+		      "Cannot set");
+	zassert_equal(lwm2m_engine_handle_get_float32(&handle, &g), 0,
+		      "Cannot get through handle");
+	zassert_true(g.val1 == f.val1 && g.val2 == f.val2, "Wrong value");
+
+	zassert_equal(lwm2m_engine_get_handle("32769/5", &handle), -EINVAL,
+		      "Handle of an instance");
+	zassert_equal(lwm2m_engine_get_handle("32769/5/1", &handle), -ENOENT,
+		      "Handle of an unknown resource");
+
+	/* The handle follows the instance when it is deleted and created
+	 * again.
+	 */
+	zassert_equal(lwm2m_engine_get_handle(paths[7], &handle), 0,
+		      "Cannot get handle");
+	zassert_equal(lwm2m_delete_obj_inst(TEST_OBJ_ID, 7), 0,
+		      "Cannot delete instance");
+
+	zassert_equal(lwm2m_engine_handle_set_s32(&handle, 1), -ENOENT,
+		      "Handle of a deleted instance used");
+	zassert_equal(lwm2m_engine_handle_get_s32(&handle, &v), -ENOENT,
+		      "Handle of a deleted instance used");
+
+	create_inst(7);
+
+	zassert_equal(lwm2m_engine_handle_set_s32(&handle, 77), 0,
+		      "Cannot set through handle");
+	zassert_equal(counter[7], 77, "Wrong resource set");
+
+	/* Still sorted */
+	test_order();
+}
+
+static void bench_print(const char *name, u32_t cycles)
+{
+	TC_PRINT("%u instances, %s: %u cycles per operation\n",
+		 MAX_INSTANCES, name, cycles / BENCH_OPS);
+}
+
+static void test_bench(void)
+{
+	u32_t start;
+	s32_t v;
+	int i;
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		zassert_equal(lwm2m_engine_get_handle(paths[i], &handles[i]),
+			      0, "Cannot get handle");
+	}
+
+	/* Each set changes the value, so that observers are notified */
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_OPS; i++) {
+		lwm2m_engine_set_s32(paths[i % MAX_INSTANCES], i);
+	}
+
+	bench_print("set by path", k_cycle_get_32() - start);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_OPS; i++) {
+		lwm2m_engine_handle_set_s32(&handles[i % MAX_INSTANCES],
+					    i + 1);
+	}
+
+	bench_print("set by handle", k_cycle_get_32() - start);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_OPS; i++) {
+		lwm2m_engine_get_s32(paths[i % MAX_INSTANCES], &v);
+	}
+
+	bench_print("get by path", k_cycle_get_32() - start);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_OPS; i++) {
+		lwm2m_engine_handle_get_s32(&handles[i % MAX_INSTANCES], &v);
+	}
+
+	bench_print("get by handle", k_cycle_get_32() - start);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < BENCH_OPS / MAX_INSTANCES; i++) {
+		lwm2m_get_rd_data(rd_data, sizeof(rd_data));
+	}
+
+	TC_PRINT("%u instances, enumeration: %u cycles per instance\n",
+		 MAX_INSTANCES, (k_cycle_get_32() - start) / BENCH_OPS);
+
+	for (i = 0; i < MAX_INSTANCES; i++) {
+		zassert_equal(counter[i],
+			      BENCH_OPS - MAX_INSTANCES + i + 1,
+			      "Wrong value for %s", paths[i]);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_registry,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_lookup),
+			 ztest_unit_test(test_order),
+			 ztest_unit_test(test_handle),
+			 ztest_unit_test(test_bench));
+
+	ztest_run_test_suite(lwm2m_registry);
+}
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <net/lwm2m.h>
+#include <net/coap.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_rw_oma_tlv.h"
+#include "lwm2m_rw_json.h"
+#include "lwm2m_rw_senml_json.h"
+#include "lwm2m_rw_senml_cbor.h"
+
+/* A vendor object with many resources of the usual types, read at once */
+#define TEST_OBJ_ID 32770
+#define RESOURCES 100
+#define STRING_LEN 16
+
+/* Reads of each measure of the benchmark */
+#define BENCH_OPS 10
+
+typedef int (*read_op_t)(struct lwm2m_engine_obj *obj,
+			 struct lwm2m_engine_context *context,
+			 int content_format);
+typedef int (*write_op_t)(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context);
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_field fields[RESOURCES];
+
+static struct lwm2m_engine_obj_inst inst;
+static struct lwm2m_engine_res_inst res[RESOURCES];
+
+static s32_t s32_value[RESOURCES];
+static float32_value_t float_value[RESOURCES];
+static char string_value[RESOURCES][STRING_LEN];
+static bool bool_value[RESOURCES];
+
+static struct lwm2m_engine_obj_inst *test_obj_create(u16_t obj_inst_id)
+{
+	int i;
+
+	if (obj_inst_id > 0 || inst.obj) {
+		return NULL;
+	}
+
+	for (i = 0; i < RESOURCES; i++) {
+		switch (fields[i].data_type) {
+		case LWM2M_RES_TYPE_S32:
+			res[i].data_ptr = &s32_value[i];
+			res[i].data_len = sizeof(s32_value[i]);
+			break;
+		case LWM2M_RES_TYPE_FLOAT32:
+			res[i].data_ptr = &float_value[i];
+			res[i].data_len = sizeof(float_value[i]);
+			break;
+		case LWM2M_RES_TYPE_STRING:
+			res[i].data_ptr = string_value[i];
+			res[i].data_len = sizeof(string_value[i]);
+			break;
+		default:
+			res[i].data_ptr = &bool_value[i];
+			res[i].data_len = sizeof(bool_value[i]);
+			break;
+		}
+
+		res[i].res_id = i;
+	}
+
+	inst.resources = res;
+	inst.resource_count = RESOURCES;
+
+	return &inst;
+}
+
+static void set_values(void)
+{
+	int i;
+
+	for (i = 0; i < RESOURCES; i++) {
+		s32_value[i] = i * 1000 - 7;
+		float_value[i].val1 = -i;
+		float_value[i].val2 = -250000;
+		snprintf(string_value[i], STRING_LEN, "value \"%d\"", i);
+		bool_value[i] = (i % 8) == 3;
+	}
+}
+
+static void clear_values(void)
+{
+	(void)memset(s32_value, 0, sizeof(s32_value));
+	(void)memset(float_value, 0, sizeof(float_value));
+	(void)memset(string_value, 0, sizeof(string_value));
+	(void)memset(bool_value, 0, sizeof(bool_value));
+}
+
+static void check_values(void)
+{
+	char expected[STRING_LEN];
+	int i;
+
+	for (i = 0; i < RESOURCES; i++) {
+		switch (fields[i].data_type) {
+		case LWM2M_RES_TYPE_S32:
+			zassert_equal(s32_value[i], i * 1000 - 7,
+				      "Wrong integer %d", i);
+			break;
+		case LWM2M_RES_TYPE_FLOAT32:
+			zassert_true(float_value[i].val1 == -i &&
+				     float_value[i].val2 == -250000,
+				     "Wrong float %d", i);
+			break;
+		case LWM2M_RES_TYPE_STRING:
+			snprintf(expected, sizeof(expected), "value \"%d\"", i);
+			zassert_equal(strcmp(string_value[i], expected), 0,
+				      "Wrong string %d", i);
+			break;
+		default:
+			zassert_equal(bool_value[i], (i % 8) == 3,
+				      "Wrong boolean %d", i);
+			break;
+		}
+	}
+}
+
+static void test_setup(void)
+{
+	static const u8_t types[] = {
+		LWM2M_RES_TYPE_S32, LWM2M_RES_TYPE_FLOAT32,
+		LWM2M_RES_TYPE_STRING, LWM2M_RES_TYPE_BOOL,
+	};
+	int i;
+
+	for (i = 0; i < RESOURCES; i++) {
+		fields[i].res_id = i;
+		fields[i].permissions = LWM2M_PERM_RW;
+		fields[i].data_type = types[i % ARRAY_SIZE(types)];
+		fields[i].multi_max_count = 1;
+	}
+
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = 1;
+	test_obj.create_cb = test_obj_create;
+	lwm2m_register_obj(&test_obj);
+
+	zassert_equal(lwm2m_engine_create_obj_inst("32770/0"), 0,
+		      "Cannot create instance");
+
+	set_values();
+}
+
+static struct net_pkt *alloc_response(struct coap_packet *cpkt)
+{
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+
+	pkt = net_pkt_get_reserve_tx(0, K_FOREVER);
+	zassert_not_null(pkt, "Cannot get packet");
+
+	frag = net_pkt_get_frag(pkt, K_FOREVER);
+	zassert_not_null(frag, "Cannot get fragment");
+	net_pkt_frag_add(pkt, frag);
+
+	zassert_equal(coap_packet_init(cpkt, pkt, 1, COAP_TYPE_ACK, 0, NULL,
+				       COAP_RESPONSE_CODE_CONTENT, 0), 0,
+		      "Cannot initialize packet");
+
+	return pkt;
+}
+
+/* Read the whole instance into a new packet, returning the payload size */
+static u16_t encode(struct coap_packet *cpkt, read_op_t read_op,
+		    const struct lwm2m_writer *writer, u16_t format)
+{
+	struct lwm2m_output_context out;
+	struct lwm2m_engine_context context;
+	struct lwm2m_obj_path path;
+	u16_t offset, len;
+
+	alloc_response(cpkt);
+
+	(void)memset(&out, 0, sizeof(out));
+	out.writer = writer;
+	out.out_cpkt = cpkt;
+
+	(void)memset(&path, 0, sizeof(path));
+	path.obj_id = TEST_OBJ_ID;
+	path.obj_inst_id = 0;
+	path.level = 2;
+
+	(void)memset(&context, 0, sizeof(context));
+	context.out = &out;
+	context.path = &path;
+	context.operation = LWM2M_OP_READ;
+
+	zassert_equal(read_op(&test_obj, &context, format), 0,
+		      "Cannot read instance");
+
+	zassert_not_null(coap_packet_get_payload(cpkt, &offset, &len),
+			 "No payload");
+
+	/* without the payload marker */
+	return len - 1;
+}
+
+/* Write the payload of the packet back to the instance */
+static void decode(struct coap_packet *cpkt, write_op_t write_op,
+		   const struct lwm2m_reader *reader)
+{
+	struct lwm2m_input_context in;
+	struct lwm2m_engine_context context;
+	struct lwm2m_obj_path path;
+	u16_t len;
+
+	(void)memset(&in, 0, sizeof(in));
+	in.reader = reader;
+	in.in_cpkt = cpkt;
+	in.frag = coap_packet_get_payload(cpkt, &in.offset, &len);
+	in.offset++;
+	in.payload_len = len - 1;
+
+	(void)memset(&path, 0, sizeof(path));
+	path.obj_id = TEST_OBJ_ID;
+	path.obj_inst_id = 0;
+	path.level = 2;
+
+	(void)memset(&context, 0, sizeof(context));
+	context.in = &in;
+	context.path = &path;
+	context.operation = LWM2M_OP_WRITE;
+
+	zassert_equal(write_op(&test_obj, &context), 0,
+		      "Cannot write instance");
+}
+
+static void bench(const char *name, read_op_t read_op,
+		  const struct lwm2m_writer *writer, u16_t format)
+{
+	struct coap_packet cpkt;
+	u32_t start, cycles = 0;
+	u16_t len = 0;
+	int i;
+
+	for (i = 0; i < BENCH_OPS; i++) {
+		start = k_cycle_get_32();
+		len = encode(&cpkt, read_op, writer, format);
+		cycles += k_cycle_get_32() - start;
+
+		net_pkt_unref(cpkt.pkt);
+	}
+
+	TC_PRINT("%u resources, %s: %u bytes, %u cycles per read\n",
+		 RESOURCES, name, len, cycles / BENCH_OPS);
+}
+
+static void round_trip(read_op_t read_op, write_op_t write_op,
+		       const struct lwm2m_writer *writer,
+		       const struct lwm2m_reader *reader, u16_t format)
+{
+	struct coap_packet cpkt;
+
+	set_values();
+	encode(&cpkt, read_op, writer, format);
+
+	clear_values();
+	decode(&cpkt, write_op, reader);
+
+	net_pkt_unref(cpkt.pkt);
+
+	check_values();
+}
+
+static void test_senml_json(void)
+{
+	round_trip(do_read_op_senml_json, do_write_op_senml_json,
+		   &senml_json_writer, &senml_json_reader,
+		   LWM2M_FORMAT_APP_SENML_JSON);
+}
+
+static void test_senml_cbor(void)
+{
+	round_trip(do_read_op_senml_cbor, do_write_op_senml_cbor,
+		   &senml_cbor_writer, &senml_cbor_reader,
+		   LWM2M_FORMAT_APP_SENML_CBOR);
+}
+
+typedef int (*composite_read_op_t)(struct lwm2m_engine_context *context,
+				   struct lwm2m_obj_path *paths,
+				   int path_count, int content_format);
+typedef int (*composite_paths_t)(struct lwm2m_input_context *in,
+				 struct lwm2m_obj_path *paths, int max_paths);
+
+/* Read paths of two objects at once, then parse the paths back */
+static void composite(composite_read_op_t read_op, composite_paths_t paths_op,
+		      const struct lwm2m_writer *writer,
+		      const struct lwm2m_reader *reader, u16_t format)
+{
+	static const char * const pathstr[] = {
+		"32770/0/0", "32770/0/2", "3/0/0", "32770/0/3",
+	};
+	struct lwm2m_obj_path paths[ARRAY_SIZE(pathstr)];
+	struct lwm2m_obj_path parsed[ARRAY_SIZE(pathstr)];
+	struct lwm2m_output_context out;
+	struct lwm2m_input_context in;
+	struct lwm2m_engine_context context;
+	struct lwm2m_obj_path path;
+	struct coap_packet cpkt;
+	u16_t len;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pathstr); i++) {
+		zassert_equal(lwm2m_string_to_path((char *)pathstr[i],
+						   &paths[i]), 0,
+			      "Invalid path %s", pathstr[i]);
+	}
+
+	set_values();
+	alloc_response(&cpkt);
+
+	(void)memset(&out, 0, sizeof(out));
+	out.writer = writer;
+	out.out_cpkt = &cpkt;
+
+	(void)memset(&path, 0, sizeof(path));
+
+	(void)memset(&context, 0, sizeof(context));
+	context.out = &out;
+	context.path = &path;
+	context.operation = LWM2M_OP_READ;
+
+	zassert_equal(read_op(&context, paths, ARRAY_SIZE(paths), format), 0,
+		      "Cannot read paths");
+
+	(void)memset(&in, 0, sizeof(in));
+	in.reader = reader;
+	in.in_cpkt = &cpkt;
+	in.frag = coap_packet_get_payload(&cpkt, &in.offset, &len);
+	zassert_not_null(in.frag, "No payload");
+	in.offset++;
+	in.payload_len = len - 1;
+
+	zassert_equal(paths_op(&in, parsed, ARRAY_SIZE(parsed)),
+		      ARRAY_SIZE(parsed), "Wrong number of records");
+
+	for (i = 0; i < ARRAY_SIZE(parsed); i++) {
+		zassert_true(parsed[i].obj_id == paths[i].obj_id &&
+			     parsed[i].obj_inst_id == paths[i].obj_inst_id &&
+			     parsed[i].res_id == paths[i].res_id &&
+			     parsed[i].level == 3,
+			     "Wrong path %d", i);
+	}
+
+	/* one path less than the records */
+	in.offset = 0;
+	in.frag = coap_packet_get_payload(&cpkt, &in.offset, &len);
+	in.offset++;
+	zassert_equal(paths_op(&in, parsed, ARRAY_SIZE(parsed) - 1), -EFBIG,
+		      "Too many paths accepted");
+
+	net_pkt_unref(cpkt.pkt);
+}
+
+static void test_composite_senml_json(void)
+{
+	composite(do_composite_read_op_senml_json,
+		  do_composite_paths_senml_json, &senml_json_writer,
+		  &senml_json_reader, LWM2M_FORMAT_APP_SENML_JSON);
+}
+
+static void test_composite_senml_cbor(void)
+{
+	composite(do_composite_read_op_senml_cbor,
+		  do_composite_paths_senml_cbor, &senml_cbor_writer,
+		  &senml_cbor_reader, LWM2M_FORMAT_APP_SENML_CBOR);
+}
+
+static void test_bench(void)
+{
+	set_values();
+
+	bench("TLV", do_read_op_tlv, &oma_tlv_writer, LWM2M_FORMAT_OMA_TLV);
+	bench("JSON", do_read_op_json, &json_writer, LWM2M_FORMAT_OMA_JSON);
+	bench("SenML JSON", do_read_op_senml_json, &senml_json_writer,
+	      LWM2M_FORMAT_APP_SENML_JSON);
+	bench("SenML CBOR", do_read_op_senml_cbor, &senml_cbor_writer,
+	      LWM2M_FORMAT_APP_SENML_CBOR);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_senml,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_senml_json),
+			 ztest_unit_test(test_senml_cbor),
+			 ztest_unit_test(test_composite_senml_json),
+			 ztest_unit_test(test_composite_senml_cbor),
+			 ztest_unit_test(test_bench));
+
+	ztest_run_test_suite(lwm2m_senml);
+}
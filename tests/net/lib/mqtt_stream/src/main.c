@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL LOG_LEVEL_WRN
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+#include <misc/byteorder.h>
+
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#define BROKER_PORT 1883
+
+#define WAIT_TIME K_SECONDS(5)
+#define NET_TIMEOUT K_SECONDS(2)
+
+#define TOPIC "sensors/door"
+
+/* Larger than CONFIG_MQTT_MSG_MAX_SIZE */
+#define LARGE_PAYLOAD_LEN 8192
+#define STREAM_PAYLOAD_LEN 65536
+#define CHUNK_LEN 500
+
+#define BENCH_COUNT 256
+#define BENCH_PAYLOAD_LEN 64
+
+static int listen_sock;
+static int broker_sock = -1;
+
+/* While set, the broker does not acknowledge PUBLISH msgs */
+static bool broker_hold;
+static u16_t held_ids[CONFIG_MQTT_INFLIGHT_WINDOW];
+static int held_count;
+
+static K_SEM_DEFINE(broker_acked, 0, UINT_MAX);
+static K_SEM_DEFINE(broker_ready, 0, 1);
+
+static K_THREAD_STACK_DEFINE(broker_stack, 2048);
+static struct k_thread broker_thread;
+
+static struct mqtt_ctx client;
+
+static K_SEM_DEFINE(connected, 0, 1);
+static K_SEM_DEFINE(published, 0, UINT_MAX);
+static K_SEM_DEFINE(released, 0, UINT_MAX);
+static K_SEM_DEFINE(acked, 0, UINT_MAX);
+static K_SEM_DEFINE(malformed, 0, UINT_MAX);
+
+static u16_t malformed_type;
+
+/* Last PUBLISH msg received by the client */
+static char rx_topic[32];
+static u8_t rx_payload[32];
+static u16_t rx_payload_len;
+static u32_t rx_streamed;
+static u32_t rx_total;
+static bool rx_in_order;
+
+static u8_t buf[CHUNK_LEN * 2];
+
+static int send_all(int sock, const u8_t *data, int len)
+{
+	int ret;
+
+	while (len > 0) {
+		ret = send(sock, data, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int recv_all(int sock, u8_t *data, int len)
+{
+	int ret;
+
+	while (len > 0) {
+		ret = recv(sock, data, len, 0);
+		if (ret <= 0) {
+			return -1;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Reads a message, stores what follows the fixed header */
+static int broker_recv(u8_t *type, u8_t *data, int size)
+{
+	u32_t rlen = 0;
+	int shift = 0;
+	u8_t byte;
+
+	if (recv_all(broker_sock, type, 1) < 0) {
+		return -1;
+	}
+
+	do {
+		if (recv_all(broker_sock, &byte, 1) < 0) {
+			return -1;
+		}
+
+		rlen |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (rlen > size || recv_all(broker_sock, data, rlen) < 0) {
+		return -1;
+	}
+
+	return rlen;
+}
+
+static void broker_send_ack(u8_t type, u16_t pkt_id)
+{
+	u8_t ack[4] = { type << 4, 2 };
+
+	/* PUBREL has a reserved flag set */
+	if (type == MQTT_PUBREL) {
+		ack[0] |= 0x02;
+	}
+
+	sys_put_be16(pkt_id, ack + 2);
+	send_all(broker_sock, ack, sizeof(ack));
+}
+
+static void broker(void *p1, void *p2, void *p3)
+{
+	static u8_t msg[256];
+	u8_t connack[] = { MQTT_CONNACK << 4, 2, 0, 0 };
+	u16_t pkt_id;
+	u8_t type;
+	int len;
+
+	broker_sock = accept(listen_sock, NULL, NULL);
+	k_sem_give(&broker_ready);
+
+	while (1) {
+		len = broker_recv(&type, msg, sizeof(msg));
+		if (len < 0) {
+			break;
+		}
+
+		switch (type >> 4) {
+		case MQTT_CONNECT:
+			send_all(broker_sock, connack, sizeof(connack));
+			break;
+		case MQTT_PUBLISH:
+			if (!(type & 0x06)) {
+				break;
+			}
+
+			/* Packet Identifier follows the topic */
+			pkt_id = sys_get_be16(msg + 2 + sys_get_be16(msg));
+
+			if (broker_hold) {
+				held_ids[held_count++] = pkt_id;
+			} else if (type & 0x04) {
+				broker_send_ack(MQTT_PUBREC, pkt_id);
+			} else {
+				broker_send_ack(MQTT_PUBACK, pkt_id);
+			}
+			break;
+		case MQTT_PUBREL:
+			broker_send_ack(MQTT_PUBCOMP, sys_get_be16(msg));
+			break;
+		case MQTT_PUBREC:
+			broker_send_ack(MQTT_PUBREL, sys_get_be16(msg));
+			break;
+		case MQTT_PUBACK:
+		case MQTT_PUBCOMP:
+			k_sem_give(&broker_acked);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/* Builds the fixed and variable header of a PUBLISH msg */
+static int publish_hdr(u8_t *data, u8_t qos, u16_t pkt_id, u32_t payload_len)
+{
+	u32_t rlen = 2 + strlen(TOPIC) + (qos ? 2 : 0) + payload_len;
+	int len = 0;
+
+	data[len++] = (MQTT_PUBLISH << 4) | (qos << 1);
+
+	do {
+		data[len] = rlen & 0x7F;
+		rlen >>= 7;
+		if (rlen) {
+			data[len] |= 0x80;
+		}
+		len++;
+	} while (rlen);
+
+	sys_put_be16(strlen(TOPIC), data + len);
+	memcpy(data + len + 2, TOPIC, strlen(TOPIC));
+	len += 2 + strlen(TOPIC);
+
+	if (qos) {
+		sys_put_be16(pkt_id, data + len);
+		len += 2;
+	}
+
+	return len;
+}
+
+static int publish(u8_t *data, u8_t qos, u16_t pkt_id, const char *payload)
+{
+	int len = publish_hdr(data, qos, pkt_id, strlen(payload));
+
+	memcpy(data + len, payload, strlen(payload));
+
+	return len + strlen(payload);
+}
+
+/* Sends a PUBLISH msg whose payload is a counter, in separate segments */
+static void send_large_publish(u8_t qos, u16_t pkt_id, u32_t payload_len)
+{
+	u32_t offset = 0;
+	int len, i;
+
+	len = publish_hdr(buf, qos, pkt_id, payload_len);
+
+	while (offset < payload_len) {
+		for (i = 0; i < CHUNK_LEN && offset < payload_len; i++) {
+			buf[len++] = offset++;
+		}
+
+		zassert_equal(send_all(broker_sock, buf, len), 0,
+			      "Cannot send");
+		len = 0;
+	}
+}
+
+static void connect_cb(struct mqtt_ctx *ctx)
+{
+	k_sem_give(&connected);
+}
+
+static int publish_tx_cb(struct mqtt_ctx *ctx, u16_t pkt_id,
+			 enum mqtt_packet type)
+{
+	k_sem_give(&acked);
+
+	return 0;
+}
+
+static int publish_rx_cb(struct mqtt_ctx *ctx, struct mqtt_publish_msg *msg,
+			 u16_t pkt_id, enum mqtt_packet type)
+{
+	if (type == MQTT_PUBREL) {
+		k_sem_give(&released);
+		return 0;
+	}
+
+	memset(rx_topic, 0, sizeof(rx_topic));
+	memcpy(rx_topic, msg->topic, min(msg->topic_len, sizeof(rx_topic) - 1));
+
+	rx_payload_len = msg->msg_len;
+	if (msg->msg) {
+		memcpy(rx_payload, msg->msg,
+		       min(msg->msg_len, sizeof(rx_payload)));
+	}
+
+	k_sem_give(&published);
+
+	return 0;
+}
+
+static int publish_rx_data_cb(struct mqtt_ctx *ctx,
+			      struct mqtt_publish_msg *msg,
+			      u32_t offset, u32_t total_len)
+{
+	int i;
+
+	if (offset != rx_streamed) {
+		rx_in_order = false;
+	}
+
+	for (i = 0; i < msg->msg_len; i++) {
+		if (msg->msg[i] != (u8_t)(offset + i)) {
+			rx_in_order = false;
+		}
+	}
+
+	rx_streamed += msg->msg_len;
+	rx_total = total_len;
+
+	return 0;
+}
+
+static void malformed_cb(struct mqtt_ctx *ctx, u16_t pkt_type)
+{
+	malformed_type = pkt_type;
+	k_sem_give(&malformed);
+}
+
+static void check_publish(const char *payload)
+{
+	zassert_equal(k_sem_take(&published, WAIT_TIME), 0,
+		      "PUBLISH not received");
+	zassert_equal(strcmp(rx_topic, TOPIC), 0, "Invalid topic");
+	zassert_equal(rx_payload_len, strlen(payload), "Invalid length");
+	zassert_equal(memcmp(rx_payload, payload, strlen(payload)), 0,
+		      "Invalid payload");
+}
+
+static void stream_reset(void)
+{
+	rx_streamed = 0;
+	rx_total = 0;
+	rx_in_order = true;
+}
+
+static void test_connect(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(BROKER_PORT),
+	};
+	struct mqtt_connect_msg msg = {
+		.clean_session = 1,
+		.client_id = "stream",
+		.client_id_len = 6,
+	};
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listen_sock >= 0, "Cannot create socket");
+	zassert_equal(bind(listen_sock, (struct sockaddr *)&addr,
+			   sizeof(addr)), 0, "Cannot bind");
+	zassert_equal(listen(listen_sock, 1), 0, "Cannot listen");
+
+	k_thread_create(&broker_thread, broker_stack,
+			K_THREAD_STACK_SIZEOF(broker_stack), broker,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	client.connect = connect_cb;
+	client.publish_tx = publish_tx_cb;
+	client.publish_rx = publish_rx_cb;
+	client.malformed = malformed_cb;
+	client.net_init_timeout = WAIT_TIME;
+	client.net_timeout = NET_TIMEOUT;
+	client.peer_addr_str = CONFIG_NET_CONFIG_MY_IPV4_ADDR;
+	client.peer_port = BROKER_PORT;
+
+	zassert_equal(mqtt_init(&client, MQTT_APP_PUBLISHER_SUBSCRIBER), 0,
+		      "Cannot init");
+	zassert_equal(mqtt_connect(&client), 0, "Cannot connect");
+	zassert_equal(k_sem_take(&broker_ready, WAIT_TIME), 0,
+		      "Connection not accepted");
+
+	zassert_equal(mqtt_tx_connect(&client, &msg), 0, "Cannot send CONNECT");
+	zassert_equal(k_sem_take(&connected, WAIT_TIME), 0, "No CONNACK");
+}
+
+/* A message split at every byte is reassembled */
+static void test_split(void)
+{
+	int len, i;
+
+	len = publish(buf, 0, 0, "split");
+
+	for (i = 0; i < len; i++) {
+		zassert_equal(send_all(broker_sock, buf + i, 1), 0,
+			      "Cannot send");
+		k_sleep(K_MSEC(1));
+	}
+
+	check_publish("split");
+}
+
+/* Several messages received at once are all processed */
+static void test_coalesced(void)
+{
+	int len;
+
+	len = publish(buf, 1, 1, "first");
+	len += publish(buf + len, 0, 0, "second");
+	len += publish(buf + len, 1, 2, "third");
+
+	zassert_equal(send_all(broker_sock, buf, len), 0, "Cannot send");
+
+	check_publish("first");
+	check_publish("second");
+	check_publish("third");
+
+	zassert_equal(k_sem_take(&broker_acked, WAIT_TIME), 0, "No PUBACK");
+	zassert_equal(k_sem_take(&broker_acked, WAIT_TIME), 0, "No PUBACK");
+}
+
+/* A message that is too long to be reassembled is skipped */
+static void test_oversized(void)
+{
+	int len;
+
+	len = publish_hdr(buf, 0, 0, CHUNK_LEN);
+	memset(buf + len, 0, CHUNK_LEN);
+	len += CHUNK_LEN;
+	len += publish(buf + len, 0, 0, "after");
+
+	zassert_equal(send_all(broker_sock, buf, len), 0, "Cannot send");
+
+	zassert_equal(k_sem_take(&malformed, WAIT_TIME), 0,
+		      "Message not rejected");
+	zassert_equal(malformed_type, MQTT_PUBLISH, "Invalid type");
+
+	check_publish("after");
+	zassert_equal(k_sem_count_get(&published), 0, "Skipped msg received");
+}
+
+/* The payload of a large message is streamed, the QoS 2 flow follows */
+static void test_stream(void)
+{
+	stream_reset();
+	client.publish_rx_data = publish_rx_data_cb;
+
+	send_large_publish(2, 3, LARGE_PAYLOAD_LEN);
+
+	zassert_equal(k_sem_take(&published, WAIT_TIME), 0,
+		      "PUBLISH not received");
+	zassert_equal(strcmp(rx_topic, TOPIC), 0, "Invalid topic");
+	zassert_equal(rx_payload_len, 0, "Payload not streamed");
+	zassert_equal(rx_streamed, LARGE_PAYLOAD_LEN, "Payload truncated");
+	zassert_equal(rx_total, LARGE_PAYLOAD_LEN, "Invalid total length");
+	zassert_true(rx_in_order, "Payload corrupted");
+
+	/* PUBREC, PUBREL from the broker, then PUBCOMP */
+	zassert_equal(k_sem_take(&released, WAIT_TIME), 0, "No PUBREL");
+	zassert_equal(k_sem_take(&broker_acked, WAIT_TIME), 0, "No PUBCOMP");
+
+	client.publish_rx_data = NULL;
+}
+
+static void publish_msg(struct mqtt_publish_msg *msg, u16_t pkt_id)
+{
+	static u8_t payload[BENCH_PAYLOAD_LEN];
+
+	msg->dup = 0;
+	msg->qos = MQTT_QoS1;
+	msg->retain = 0;
+	msg->pkt_id = pkt_id;
+	msg->topic = TOPIC;
+	msg->topic_len = strlen(TOPIC);
+	msg->msg = payload;
+	msg->msg_len = sizeof(payload);
+}
+
+/* Publishing waits for a free slot in the window of msgs in flight */
+static void test_window(void)
+{
+	struct mqtt_publish_msg msg;
+	int i;
+
+	broker_hold = true;
+	held_count = 0;
+
+	for (i = 0; i < CONFIG_MQTT_INFLIGHT_WINDOW; i++) {
+		publish_msg(&msg, 100 + i);
+		zassert_equal(mqtt_tx_publish(&client, &msg), 0,
+			      "Cannot publish %d", i);
+	}
+
+	/* The window is full until the broker answers */
+	client.net_timeout = K_MSEC(100);
+	publish_msg(&msg, 100);
+	zassert_equal(mqtt_tx_publish(&client, &msg), -EAGAIN,
+		      "Window not full");
+	client.net_timeout = NET_TIMEOUT;
+
+	while (held_count < CONFIG_MQTT_INFLIGHT_WINDOW) {
+		k_sleep(K_MSEC(10));
+	}
+
+	broker_hold = false;
+
+	/* Unknown Packet Identifiers are rejected */
+	broker_send_ack(MQTT_PUBACK, 99);
+	zassert_equal(k_sem_take(&malformed, WAIT_TIME), 0,
+		      "Unknown PUBACK accepted");
+	zassert_equal(malformed_type, MQTT_PUBACK, "Invalid type");
+	zassert_equal(k_sem_count_get(&acked), 0, "Unknown PUBACK passed");
+
+	for (i = 0; i < held_count; i++) {
+		broker_send_ack(MQTT_PUBACK, held_ids[i]);
+	}
+
+	for (i = 0; i < CONFIG_MQTT_INFLIGHT_WINDOW; i++) {
+		zassert_equal(k_sem_take(&acked, WAIT_TIME), 0,
+			      "PUBACK %d not received", i);
+	}
+
+	/* The window is free again */
+	publish_msg(&msg, 100);
+	zassert_equal(mqtt_tx_publish(&client, &msg), 0, "Cannot publish");
+	zassert_equal(k_sem_take(&acked, WAIT_TIME), 0, "No PUBACK");
+}
+
+static u32_t bench_publish(bool pipelined)
+{
+	struct mqtt_publish_msg msg;
+	u32_t start;
+	int i;
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < BENCH_COUNT; i++) {
+		publish_msg(&msg, 1 + i);
+		zassert_equal(mqtt_tx_publish(&client, &msg), 0,
+			      "Cannot publish %d", i);
+
+		if (!pipelined) {
+			zassert_equal(k_sem_take(&acked, WAIT_TIME), 0,
+				      "PUBACK %d not received", i);
+		}
+	}
+
+	if (pipelined) {
+		for (i = 0; i < BENCH_COUNT; i++) {
+			zassert_equal(k_sem_take(&acked, WAIT_TIME), 0,
+				      "PUBACK %d not received", i);
+		}
+	}
+
+	return k_uptime_get_32() - start;
+}
+
+static void print_rate(const char *name, u32_t count, const char *unit,
+		       u32_t time)
+{
+	TC_PRINT("%s: %u %s in %u ms", name, count, unit, time);
+	if (time) {
+		TC_PRINT(", %u %s/s", count * MSEC_PER_SEC / time, unit);
+	}
+	TC_PRINT("\n");
+}
+
+static void test_throughput(void)
+{
+	u32_t time;
+
+	time = bench_publish(false);
+	print_rate("QoS 1, one msg in flight", BENCH_COUNT, "msgs", time);
+
+	time = bench_publish(true);
+	print_rate("QoS 1, window of " STRINGIFY(CONFIG_MQTT_INFLIGHT_WINDOW),
+		   BENCH_COUNT, "msgs", time);
+
+	stream_reset();
+	client.publish_rx_data = publish_rx_data_cb;
+
+	time = k_uptime_get_32();
+	send_large_publish(0, 0, STREAM_PAYLOAD_LEN);
+	zassert_equal(k_sem_take(&published, WAIT_TIME), 0,
+		      "PUBLISH not received");
+	time = k_uptime_get_32() - time;
+
+	zassert_equal(rx_streamed, STREAM_PAYLOAD_LEN, "Payload truncated");
+	zassert_true(rx_in_order, "Payload corrupted");
+
+	print_rate("Streamed payload", STREAM_PAYLOAD_LEN / 1024, "KiB", time);
+
+	client.publish_rx_data = NULL;
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_stream,
+			 ztest_unit_test(test_connect),
+			 ztest_unit_test(test_split),
+			 ztest_unit_test(test_coalesced),
+			 ztest_unit_test(test_oversized),
+			 ztest_unit_test(test_stream),
+			 ztest_unit_test(test_window),
+			 ztest_unit_test(test_throughput));
+
+	ztest_run_test_suite(mqtt_stream);
+}
@@ -1196,6 +1196,212 @@ static void test_net_pkt_append_memset(void)
 	net_pkt_unref(pkt);
 }
 
+#define CURSOR_FRAGS 12
+
+/* Number of times the data is parsed when measuring throughput */
+#define CURSOR_ROUNDS 20
+
+static u8_t cursor_pattern(size_t offset)
+{
+	return (u8_t)(offset * 7 + (offset >> 8));
+}
+
+static struct net_pkt *cursor_pkt(size_t *len)
+{
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+	size_t i;
+	int j;
+
+	pkt = net_pkt_get_reserve_rx(0, K_FOREVER);
+	*len = 0;
+
+	for (j = 0; j < CURSOR_FRAGS; j++) {
+		frag = net_pkt_get_reserve_rx_data(LL_RESERVE, K_FOREVER);
+
+		/* Fragments of different sizes, the last one is empty */
+		if (j < CURSOR_FRAGS - 1) {
+			for (i = net_buf_tailroom(frag) - j; i > 0; i--) {
+				net_buf_add_u8(frag, cursor_pattern((*len)++));
+			}
+		}
+
+		net_pkt_frag_add(pkt, frag);
+	}
+
+	return pkt;
+}
+
+static void test_pkt_cursor(void)
+{
+	struct net_pkt_cursor cursor, dst_cursor;
+	struct net_pkt *pkt, *dst;
+	u8_t data[200];
+	size_t len, i;
+	u16_t span_len, v16;
+	u32_t v32;
+	u8_t *span, v8;
+
+	pkt = cursor_pkt(&len);
+
+	net_pkt_cursor_init(&cursor, pkt);
+	zassert_equal(net_pkt_cursor_remaining(&cursor), len,
+		      "Invalid remaining length");
+
+	/* Reads across fragments */
+	zassert_equal(net_pkt_cursor_read(&cursor, data, sizeof(data)), 0,
+		      "Read failed");
+	for (i = 0; i < sizeof(data); i++) {
+		zassert_equal(data[i], cursor_pattern(i), "Invalid data");
+	}
+
+	zassert_equal(net_pkt_cursor_peek(&cursor, &v8, 1), 0, "Peek failed");
+	zassert_equal(v8, cursor_pattern(sizeof(data)), "Invalid peek");
+
+	zassert_equal(net_pkt_cursor_read_u8(&cursor, &v8), 0, "Read failed");
+	zassert_equal(v8, cursor_pattern(sizeof(data)), "Invalid u8");
+
+	zassert_equal(net_pkt_cursor_read_be16(&cursor, &v16), 0,
+		      "Read failed");
+	zassert_equal(v16, cursor_pattern(sizeof(data) + 1) << 8 |
+		      cursor_pattern(sizeof(data) + 2), "Invalid be16");
+
+	zassert_equal(net_pkt_cursor_read_be32(&cursor, &v32), 0,
+		      "Read failed");
+	zassert_equal(v32, (u32_t)cursor_pattern(sizeof(data) + 3) << 24 |
+		      cursor_pattern(sizeof(data) + 4) << 16 |
+		      cursor_pattern(sizeof(data) + 5) << 8 |
+		      cursor_pattern(sizeof(data) + 6), "Invalid be32");
+
+	i = sizeof(data) + 7;
+
+	zassert_equal(net_pkt_cursor_skip(&cursor, 100), 0, "Skip failed");
+	i += 100;
+
+	span = net_pkt_cursor_span(&cursor, &span_len);
+	zassert_not_null(span, "No span");
+	zassert_true(span_len > 0, "Empty span");
+	zassert_equal(span[0], cursor_pattern(i), "Invalid span");
+
+	zassert_equal(net_pkt_cursor_remaining(&cursor), len - i,
+		      "Invalid remaining length");
+
+	/* Overwrites in place */
+	zassert_equal(net_pkt_cursor_write_be16(&cursor, 0x1234, K_FOREVER),
+		      0, "Write failed");
+	net_pkt_cursor_init(&dst_cursor, pkt);
+	zassert_equal(net_pkt_cursor_skip(&dst_cursor, i), 0, "Skip failed");
+	zassert_equal(net_pkt_cursor_read_be16(&dst_cursor, &v16), 0,
+		      "Read failed");
+	zassert_equal(v16, 0x1234, "Invalid write");
+	zassert_equal(net_pkt_get_len(pkt), len, "Packet length changed");
+
+	/* Reading past the end fails */
+	zassert_equal(net_pkt_cursor_skip(&cursor, len), -ENODATA,
+		      "Skip past the end");
+	zassert_true(net_pkt_cursor_at_end(&cursor), "Not at the end");
+	zassert_is_null(net_pkt_cursor_span(&cursor, &span_len),
+			"Span at the end");
+
+	/* Copies to a packet that grows */
+	dst = net_pkt_get_reserve_rx(0, K_FOREVER);
+	net_pkt_cursor_init(&dst_cursor, dst);
+	net_pkt_cursor_init(&cursor, pkt);
+
+	zassert_equal(net_pkt_cursor_copy(&dst_cursor, &cursor, 300,
+					  K_FOREVER), 0, "Copy failed");
+	zassert_equal(net_pkt_get_len(dst), 300, "Invalid copy length");
+
+	net_pkt_cursor_init(&dst_cursor, dst);
+	for (i = 0; i < 300; i++) {
+		zassert_equal(net_pkt_cursor_read_u8(&dst_cursor, &v8), 0,
+			      "Read failed");
+		zassert_equal(v8, cursor_pattern(i), "Invalid copy");
+	}
+
+	net_pkt_unref(dst);
+	net_pkt_unref(pkt);
+}
+
+static u32_t cycles_to_us(u32_t cycles)
+{
+	return SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / NSEC_PER_USEC;
+}
+
+static void print_throughput(const char *name, size_t len, u32_t cycles)
+{
+	u32_t us = cycles_to_us(cycles);
+
+	TC_PRINT("%s: %zu bytes in %u us", name, len, us);
+	if (us) {
+		TC_PRINT(", %u kB/s", (u32_t)((u64_t)len * 1000 / us));
+	}
+	TC_PRINT("\n");
+}
+
+/* Parses the data of a packet byte by byte, the way protocol parsers
+ * read it, with the offset based API and with a cursor.
+ */
+static void test_pkt_cursor_throughput(void)
+{
+	struct net_pkt_cursor cursor;
+	struct net_buf *frag;
+	struct net_pkt *pkt;
+	u32_t sum, expected, start;
+	size_t len, i;
+	u16_t pos;
+	u8_t v8;
+	int round;
+
+	pkt = cursor_pkt(&len);
+
+	expected = 0;
+	for (i = 0; i < len; i++) {
+		expected += cursor_pattern(i);
+	}
+
+	/* Offset from the start of the packet at each read */
+	start = k_cycle_get_32();
+	for (round = 0, sum = 0; round < CURSOR_ROUNDS; round++) {
+		for (i = 0; i < len; i++) {
+			net_frag_read_u8(pkt->frags, i, &pos, &v8);
+			sum += v8;
+		}
+	}
+	print_throughput("net_frag_read() from the start",
+			 len * CURSOR_ROUNDS, k_cycle_get_32() - start);
+	zassert_equal(sum, expected * CURSOR_ROUNDS, "Invalid data");
+
+	/* Offset from the fragment returned by the previous read */
+	start = k_cycle_get_32();
+	for (round = 0, sum = 0; round < CURSOR_ROUNDS; round++) {
+		frag = pkt->frags;
+		pos = 0;
+
+		for (i = 0; i < len; i++) {
+			frag = net_frag_read_u8(frag, pos, &pos, &v8);
+			sum += v8;
+		}
+	}
+	print_throughput("net_frag_read() chained", len * CURSOR_ROUNDS,
+			 k_cycle_get_32() - start);
+	zassert_equal(sum, expected * CURSOR_ROUNDS, "Invalid data");
+
+	start = k_cycle_get_32();
+	for (round = 0, sum = 0; round < CURSOR_ROUNDS; round++) {
+		net_pkt_cursor_init(&cursor, pkt);
+
+		while (!net_pkt_cursor_read_u8(&cursor, &v8)) {
+			sum += v8;
+		}
+	}
+	print_throughput("net_pkt_cursor_read_u8()", len * CURSOR_ROUNDS,
+			 k_cycle_get_32() - start);
+	zassert_equal(sum, expected * CURSOR_ROUNDS, "Invalid data");
+
+	net_pkt_unref(pkt);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(net_pkt_tests,
@@ -1206,7 +1412,9 @@ void test_main(void)
 			 ztest_unit_test(test_fragment_compact),
 			 ztest_unit_test(test_fragment_split),
 			 ztest_unit_test(test_pkt_pull),
-			 ztest_unit_test(test_net_pkt_append_memset)
+			 ztest_unit_test(test_net_pkt_append_memset),
+			 ztest_unit_test(test_pkt_cursor),
+			 ztest_unit_test(test_pkt_cursor_throughput)
 			 );
 
 	ztest_run_test_suite(net_pkt_tests);
@@ -0,0 +1,368 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_ROUTE_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+#include <errno.h>
+
+#include <tc_util.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "ipv6.h"
+#include "nbr.h"
+#include "route.h"
+
+#define NEXTHOPS CONFIG_NET_IPV6_MAX_NEIGHBORS
+#define BENCH_MAX_ROUTES 1024
+#define LOOKUPS 4096
+
+BUILD_ASSERT(CONFIG_NET_MAX_ROUTES >= BENCH_MAX_ROUTES);
+
+static struct net_if *iface;
+
+static struct in6_addr nexthop_addr[NEXTHOPS];
+static u8_t nexthop_mac[NEXTHOPS][sizeof(struct net_eth_addr)];
+
+static struct in6_addr bench_dst[BENCH_MAX_ROUTES];
+static struct net_route_entry *bench_routes[BENCH_MAX_ROUTES];
+
+static u8_t mac_addr[sizeof(struct net_eth_addr)] = {
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	0x00, 0x00, 0x5E, 0x00, 0x53, 0x01
+};
+
+static int route_lpm_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void route_lpm_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api route_lpm_if_api = {
+	.init = route_lpm_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(route_lpm_test, "route_lpm_test",
+		route_lpm_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&route_lpm_if_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static void test_init(void)
+{
+	struct net_linkaddr lladdr;
+	struct net_nbr *nbr;
+	int i;
+
+	iface = net_if_get_default();
+	zassert_not_null(iface, "No interface");
+
+	for (i = 0; i < NEXTHOPS; i++) {
+		/* fe80::1 ... fe80::NEXTHOPS */
+		nexthop_addr[i].s6_addr[0] = 0xfe;
+		nexthop_addr[i].s6_addr[1] = 0x80;
+		nexthop_addr[i].s6_addr[15] = i + 1;
+
+		memcpy(nexthop_mac[i], mac_addr, sizeof(mac_addr));
+		nexthop_mac[i][5] = 0x10 + i;
+
+		lladdr.addr = nexthop_mac[i];
+		lladdr.len = sizeof(mac_addr);
+		lladdr.type = NET_LINK_ETHERNET;
+
+		nbr = net_ipv6_nbr_add(iface, &nexthop_addr[i], &lladdr,
+				       false, NET_IPV6_NBR_STATE_REACHABLE);
+		zassert_not_null(nbr, "Cannot add nexthop %d", i);
+	}
+}
+
+static void ipv6_addr(struct in6_addr *addr, u16_t g2, u16_t g3, u16_t g4,
+		      u8_t last)
+{
+	(void)memset(addr, 0, sizeof(*addr));
+
+	addr->s6_addr16[0] = htons(0x2001);
+	addr->s6_addr16[1] = htons(0x0db8);
+	addr->s6_addr16[2] = htons(g2);
+	addr->s6_addr16[3] = htons(g3);
+	addr->s6_addr16[4] = htons(g4);
+	addr->s6_addr[15] = last;
+}
+
+static void check_lookup(struct in6_addr *dst, struct net_route_entry *expected)
+{
+	struct net_route_entry *route;
+
+	route = net_route_lookup(iface, dst);
+	zassert_equal_ptr(route, expected, "wrong route for %s",
+			  net_sprint_ipv6_addr(dst));
+}
+
+static void test_ipv6_longest_match(void)
+{
+	struct net_route_entry *r32, *r48, *r64, *r128;
+	struct in6_addr addr;
+
+	/* Add the most generic route first so that adding the more
+	 * specific ones must not replace it.
+	 */
+	ipv6_addr(&addr, 0, 0, 0, 0);
+	r32 = net_route_add(iface, &addr, 32, &nexthop_addr[0]);
+	zassert_not_null(r32, "Cannot add /32 route");
+
+	ipv6_addr(&addr, 1, 0, 0, 0);
+	r48 = net_route_add(iface, &addr, 48, &nexthop_addr[1]);
+	zassert_not_null(r48, "Cannot add /48 route");
+
+	ipv6_addr(&addr, 1, 2, 0, 0);
+	r64 = net_route_add(iface, &addr, 64, &nexthop_addr[2]);
+	zassert_not_null(r64, "Cannot add /64 route");
+
+	ipv6_addr(&addr, 1, 2, 0, 5);
+	r128 = net_route_add(iface, &addr, 128, &nexthop_addr[3]);
+	zassert_not_null(r128, "Cannot add /128 route");
+
+	ipv6_addr(&addr, 1, 2, 0, 5);
+	check_lookup(&addr, r128);
+
+	ipv6_addr(&addr, 1, 2, 0, 6);
+	check_lookup(&addr, r64);
+
+	ipv6_addr(&addr, 1, 3, 0, 1);
+	check_lookup(&addr, r48);
+
+	ipv6_addr(&addr, 2, 0, 0x8000, 1);
+	check_lookup(&addr, r32);
+
+	ipv6_addr(&addr, 0, 0, 0, 1);
+	addr.s6_addr[3] = 0xb9;
+	check_lookup(&addr, NULL);
+
+	/* Adding an existing prefix via the same nexthop is a no-op */
+	ipv6_addr(&addr, 1, 0, 0, 0);
+	zassert_equal_ptr(net_route_add(iface, &addr, 48, &nexthop_addr[1]),
+			  r48, "route was not reused");
+
+	/* Removing a prefix in the middle keeps the more specific ones */
+	zassert_equal(net_route_del(r48), 0, "Cannot delete /48 route");
+
+	ipv6_addr(&addr, 1, 3, 0, 1);
+	check_lookup(&addr, r32);
+
+	ipv6_addr(&addr, 1, 2, 0, 5);
+	check_lookup(&addr, r128);
+
+	zassert_equal(net_route_del(r64), 0, "Cannot delete /64 route");
+
+	ipv6_addr(&addr, 1, 2, 0, 6);
+	check_lookup(&addr, r32);
+
+	zassert_equal(net_route_del(r32), 0, "Cannot delete /32 route");
+
+	ipv6_addr(&addr, 1, 2, 0, 6);
+	check_lookup(&addr, NULL);
+
+	ipv6_addr(&addr, 1, 2, 0, 5);
+	check_lookup(&addr, r128);
+
+	zassert_equal(net_route_del(r128), 0, "Cannot delete /128 route");
+
+	check_lookup(&addr, NULL);
+}
+
+static void ipv4_check_gw(const char *dst, const char *gw)
+{
+	struct net_route_entry_ipv4 *route;
+	struct in_addr addr, expected;
+
+	zassert_equal(net_addr_pton(AF_INET, dst, &addr), 0, NULL);
+
+	route = net_route_ipv4_lookup(iface, &addr);
+	if (!gw) {
+		zassert_is_null(route, "unexpected route for %s", dst);
+		return;
+	}
+
+	zassert_not_null(route, "no route for %s", dst);
+	zassert_equal(net_addr_pton(AF_INET, gw, &expected), 0, NULL);
+	zassert_true(net_ipv4_addr_cmp(&route->gw, &expected),
+		     "wrong gateway for %s", dst);
+}
+
+static struct net_route_entry_ipv4 *ipv4_add(const char *prefix, u8_t len,
+					     const char *gw)
+{
+	struct in_addr addr, gw_addr;
+
+	zassert_equal(net_addr_pton(AF_INET, prefix, &addr), 0, NULL);
+	zassert_equal(net_addr_pton(AF_INET, gw, &gw_addr), 0, NULL);
+
+	return net_route_ipv4_add(iface, &addr, len, &gw_addr);
+}
+
+static void test_ipv4_longest_match(void)
+{
+	struct net_route_entry_ipv4 *r0, *r8, *r16, *r32;
+
+	r8 = ipv4_add("10.0.0.0", 8, "192.0.2.2");
+	zassert_not_null(r8, "Cannot add /8 route");
+
+	ipv4_check_gw("172.16.0.1", NULL);
+
+	r0 = ipv4_add("0.0.0.0", 0, "192.0.2.1");
+	zassert_not_null(r0, "Cannot add default route");
+
+	r16 = ipv4_add("10.1.0.0", 16, "192.0.2.3");
+	zassert_not_null(r16, "Cannot add /16 route");
+
+	r32 = ipv4_add("10.1.2.3", 32, "192.0.2.4");
+	zassert_not_null(r32, "Cannot add /32 route");
+
+	ipv4_check_gw("10.1.2.3", "192.0.2.4");
+	ipv4_check_gw("10.1.2.4", "192.0.2.3");
+	ipv4_check_gw("10.2.0.1", "192.0.2.2");
+	ipv4_check_gw("172.16.0.1", "192.0.2.1");
+
+	/* Same prefix again only updates the gateway */
+	zassert_equal_ptr(ipv4_add("10.0.0.0", 8, "192.0.2.5"), r8,
+			  "route was not reused");
+	ipv4_check_gw("10.2.0.1", "192.0.2.5");
+}
+
+static void count_route(struct net_route_entry_ipv4 *entry, void *user_data)
+{
+	(*(int *)user_data)++;
+}
+
+static void test_ipv4_del(void)
+{
+	struct net_route_entry_ipv4 *route;
+	struct in_addr addr;
+	int count = 0;
+
+	zassert_equal(net_route_ipv4_foreach(count_route, &count), 4,
+		      "wrong number of routes");
+	zassert_equal(count, 4, "callback not called");
+
+	zassert_equal(net_addr_pton(AF_INET, "10.1.9.9", &addr), 0, NULL);
+	route = net_route_ipv4_lookup(iface, &addr);
+	zassert_not_null(route, "no /16 route");
+	zassert_equal(route->prefix_len, 16, "wrong route");
+
+	zassert_equal(net_route_ipv4_del(route), 0, "Cannot delete route");
+	zassert_equal(net_route_ipv4_del(route), -EINVAL, "deleted twice");
+
+	ipv4_check_gw("10.1.9.9", "192.0.2.5");
+	ipv4_check_gw("10.1.2.3", "192.0.2.4");
+
+	while ((route = net_route_ipv4_lookup(NULL, &addr))) {
+		zassert_equal(net_route_ipv4_del(route), 0,
+			      "Cannot delete route");
+	}
+
+	ipv4_check_gw("10.1.2.3", "192.0.2.4");
+
+	zassert_equal(net_addr_pton(AF_INET, "10.1.2.3", &addr), 0, NULL);
+	zassert_equal(net_route_ipv4_del(net_route_ipv4_lookup(NULL, &addr)),
+		      0, "Cannot delete route");
+
+	ipv4_check_gw("10.1.2.3", NULL);
+}
+
+static void run_bench(int count)
+{
+	struct net_route_entry *route;
+	struct in6_addr prefix;
+	struct in6_addr *nexthop;
+	u32_t start, cycles;
+	int i, errors = 0;
+
+	for (i = 0; i < count; i++) {
+		/* Odd multiplier spreads the prefixes over the whole
+		 * 16 bit space of the group.
+		 */
+		ipv6_addr(&prefix, 0x00aa, (u16_t)(i * 40503), 0, 0);
+		ipv6_addr(&bench_dst[i], 0x00aa, (u16_t)(i * 40503),
+			  i, 1);
+
+		bench_routes[i] = net_route_add(iface, &prefix, 64,
+						&nexthop_addr[i % NEXTHOPS]);
+		zassert_not_null(bench_routes[i], "Cannot add route %d", i);
+	}
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < LOOKUPS; i++) {
+		if (!net_route_get_info(iface, &bench_dst[i % count],
+					&route, &nexthop) ||
+		    route != bench_routes[i % count]) {
+			errors++;
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("%4d routes: %u cycles per forwarding lookup\n", count,
+		 cycles / LOOKUPS);
+
+	zassert_equal(errors, 0, "%d wrong lookups", errors);
+
+	for (i = 0; i < count; i++) {
+		zassert_equal(net_route_del(bench_routes[i]), 0,
+			      "Cannot delete route %d", i);
+	}
+}
+
+static void test_bench_16(void)
+{
+	run_bench(16);
+}
+
+static void test_bench_256(void)
+{
+	run_bench(256);
+}
+
+static void test_bench_1024(void)
+{
+	run_bench(1024);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(route_lpm,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_ipv6_longest_match),
+			 ztest_unit_test(test_ipv4_longest_match),
+			 ztest_unit_test(test_ipv4_del),
+			 ztest_unit_test(test_bench_16),
+			 ztest_unit_test(test_bench_256),
+			 ztest_unit_test(test_bench_1024));
+
+	ztest_run_test_suite(route_lpm);
+}
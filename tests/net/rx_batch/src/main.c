@@ -0,0 +1,466 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_CORE_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "ipv4.h"
+#include "udp_internal.h"
+#include "tcp_internal.h"
+
+#define ALLOC_TIMEOUT K_MSEC(500)
+#define WAIT_TIME K_MSEC(500)
+
+#define BATCH 16
+#define ROUNDS 64
+#define SEGS 4
+#define SEG_LEN 100
+#define BENCH_LEN 64
+#define BASE_SEQ 1000
+
+#define LOCAL_PORT 4242
+#define REMOTE_PORT 4343
+
+#define TCP_HDR_LEN (NET_IPV4H_LEN + NET_TCPH_LEN)
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr peer_addr = { { { 192, 0, 2, 2 } } };
+
+static struct net_if *iface;
+static struct net_conn_handle *udp_handle;
+static struct net_conn_handle *tcp_handle;
+
+static K_SEM_DEFINE(recv_sem, 0, UINT_MAX);
+
+static u16_t expected_seq;
+static int deliveries;
+static int recv_errors;
+static int recv_bytes;
+
+static int rx_batch_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void rx_batch_iface_init(struct net_if *iface)
+{
+	static u8_t mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x05 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api rx_batch_if_api = {
+	.init = rx_batch_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(rx_batch_test, "rx_batch_test",
+		rx_batch_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&rx_batch_if_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 1500);
+
+/* UDP packets carry a sequence number in the first payload byte */
+static enum net_verdict udp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     void *user_data)
+{
+	u8_t seq;
+
+	net_frag_linearize(&seq, 1, pkt, NET_IPV4H_LEN + NET_UDPH_LEN, 1);
+
+	if (seq != (u8_t)expected_seq) {
+		recv_errors++;
+	}
+
+	expected_seq++;
+	recv_bytes += net_pkt_get_len(pkt) - NET_IPV4H_LEN - NET_UDPH_LEN;
+
+	net_pkt_unref(pkt);
+	k_sem_give(&recv_sem);
+
+	return NET_OK;
+}
+
+/* Byte at stream offset N of the TCP payload has the value N & 0xff */
+static enum net_verdict tcp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     void *user_data)
+{
+	static u8_t buf[BATCH * BENCH_LEN];
+	struct net_tcp_hdr *tcp;
+	u32_t offset;
+	int len, i;
+
+	tcp = (struct net_tcp_hdr *)(pkt->frags->data + NET_IPV4H_LEN);
+	offset = sys_get_be32(tcp->seq) - BASE_SEQ;
+	len = net_pkt_get_len(pkt) - TCP_HDR_LEN;
+
+	if (len > sizeof(buf) ||
+	    net_frag_linearize(buf, sizeof(buf), pkt, TCP_HDR_LEN,
+			       len) != len) {
+		recv_errors++;
+		goto out;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != (u8_t)(offset + i)) {
+			recv_errors++;
+			break;
+		}
+	}
+
+out:
+	deliveries++;
+	recv_bytes += len;
+
+	net_pkt_unref(pkt);
+	k_sem_give(&recv_sem);
+
+	return NET_OK;
+}
+
+static struct net_pkt *create_pkt(u8_t proto, u32_t seq, u16_t len)
+{
+	struct net_pkt *pkt;
+	int i;
+
+	pkt = net_pkt_get_reserve_rx(0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "Out of RX packets");
+
+	net_pkt_set_iface(pkt, iface);
+
+	pkt = net_ipv4_create(pkt, &peer_addr, &my_addr, iface, proto);
+	zassert_not_null(pkt, "Cannot create IPv4 packet");
+
+	if (proto == IPPROTO_TCP) {
+		struct net_tcp_hdr hdr = { 0 };
+
+		hdr.src_port = htons(REMOTE_PORT);
+		hdr.dst_port = htons(LOCAL_PORT);
+		sys_put_be32(BASE_SEQ + seq, hdr.seq);
+		sys_put_be32(1, hdr.ack);
+		hdr.offset = (NET_TCPH_LEN / 4) << 4;
+		hdr.flags = NET_TCP_ACK;
+		sys_put_be16(1024, hdr.wnd);
+
+		zassert_true(net_pkt_append_all(pkt, sizeof(hdr),
+						(u8_t *)&hdr, ALLOC_TIMEOUT),
+			     "Cannot append");
+	} else {
+		struct net_udp_hdr hdr;
+
+		hdr.src_port = htons(REMOTE_PORT);
+		hdr.dst_port = htons(LOCAL_PORT);
+		hdr.len = htons(NET_UDPH_LEN + len);
+		hdr.chksum = 0;
+
+		zassert_true(net_pkt_append_all(pkt, sizeof(hdr),
+						(u8_t *)&hdr, ALLOC_TIMEOUT),
+			     "Cannot append");
+	}
+
+	for (i = 0; i < len; i++) {
+		u8_t byte = seq + i;
+
+		zassert_true(net_pkt_append_all(pkt, 1, &byte, ALLOC_TIMEOUT),
+			     "Cannot append data");
+	}
+
+	net_ipv4_finalize(pkt, proto);
+
+	return pkt;
+}
+
+static void wait_deliveries(int count)
+{
+	while (count--) {
+		zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+			      "Timeout while waiting data");
+	}
+
+	zassert_not_equal(k_sem_take(&recv_sem, K_MSEC(50)), 0,
+			  "Unexpected data received");
+}
+
+static void test_setup(void)
+{
+	int ret;
+
+	iface = net_if_get_default();
+
+	zassert_not_null(net_if_ipv4_addr_add(iface, &my_addr,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address");
+
+	ret = net_udp_register(NULL, NULL, REMOTE_PORT, LOCAL_PORT,
+			       udp_received, NULL, &udp_handle);
+	zassert_equal(ret, 0, "Cannot register UDP handler");
+
+	ret = net_tcp_register(NULL, NULL, REMOTE_PORT, LOCAL_PORT,
+			       tcp_received, NULL, &tcp_handle);
+	zassert_equal(ret, 0, "Cannot register TCP handler");
+}
+
+static void test_batch_order(void)
+{
+	struct net_pkt *pkts[BATCH];
+	int i, ret;
+
+	expected_seq = 0;
+	recv_errors = 0;
+
+	for (i = 0; i < BATCH; i++) {
+		pkts[i] = create_pkt(IPPROTO_UDP, i, BENCH_LEN);
+	}
+
+	ret = net_recv_data_batch(iface, pkts, BATCH);
+	zassert_equal(ret, 0, "Cannot receive batch (%d)", ret);
+
+	wait_deliveries(BATCH);
+
+	zassert_equal(recv_errors, 0, "Packets received out of order");
+}
+
+static void test_batch_invalid(void)
+{
+	struct net_pkt *pkts[2];
+	struct net_buf *frags;
+	int ret;
+
+	pkts[0] = create_pkt(IPPROTO_UDP, 0, BENCH_LEN);
+	pkts[1] = create_pkt(IPPROTO_UDP, 1, BENCH_LEN);
+
+	frags = pkts[1]->frags;
+	pkts[1]->frags = NULL;
+
+	ret = net_recv_data_batch(iface, pkts, 2);
+	zassert_equal(ret, -ENODATA, "Invalid batch accepted");
+
+	pkts[1]->frags = frags;
+
+	net_pkt_unref(pkts[0]);
+	net_pkt_unref(pkts[1]);
+}
+
+static void recv_segments(const u32_t *offsets, int count)
+{
+	struct net_pkt *pkts[SEGS];
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		pkts[i] = create_pkt(IPPROTO_TCP, offsets[i], SEG_LEN);
+	}
+
+	ret = net_recv_data_batch(iface, pkts, count);
+	zassert_equal(ret, 0, "Cannot receive batch (%d)", ret);
+}
+
+static void test_gro_in_order(void)
+{
+	static const u32_t offsets[SEGS] = {
+		0, SEG_LEN, 2 * SEG_LEN, 3 * SEG_LEN
+	};
+	int expected = IS_ENABLED(CONFIG_NET_GRO) ? 1 : SEGS;
+
+	deliveries = 0;
+	recv_errors = 0;
+
+	recv_segments(offsets, SEGS);
+
+	wait_deliveries(expected);
+
+	zassert_equal(deliveries, expected, "Invalid number of segments");
+	zassert_equal(recv_errors, 0, "Invalid data received");
+}
+
+static void test_gro_out_of_order(void)
+{
+	static const u32_t offsets[SEGS] = {
+		0, 2 * SEG_LEN, SEG_LEN, 3 * SEG_LEN
+	};
+
+	deliveries = 0;
+	recv_errors = 0;
+
+	/* None of the segments follows directly the previous one */
+	recv_segments(offsets, SEGS);
+
+	wait_deliveries(SEGS);
+
+	zassert_equal(recv_errors, 0, "Invalid data received");
+}
+
+static void test_gro_bad_chksum(void)
+{
+	struct net_pkt *pkts[3];
+	struct net_tcp_hdr *tcp;
+	int i, ret;
+
+	deliveries = 0;
+	recv_errors = 0;
+
+	for (i = 0; i < 3; i++) {
+		pkts[i] = create_pkt(IPPROTO_TCP, i * SEG_LEN, SEG_LEN);
+	}
+
+	tcp = (struct net_tcp_hdr *)(pkts[1]->frags->data + NET_IPV4H_LEN);
+	tcp->chksum = ~tcp->chksum;
+
+	ret = net_recv_data_batch(iface, pkts, 3);
+	zassert_equal(ret, 0, "Cannot receive batch (%d)", ret);
+
+	/* The corrupted segment is dropped and it splits the rest */
+	wait_deliveries(2);
+
+	zassert_equal(recv_errors, 0, "Invalid data received");
+}
+
+static void recv_ip_hdr_change(bool corrupt)
+{
+	struct net_pkt *pkts[3];
+	struct net_ipv4_hdr *hdr;
+	int i, ret;
+
+	deliveries = 0;
+	recv_errors = 0;
+
+	for (i = 0; i < 3; i++) {
+		pkts[i] = create_pkt(IPPROTO_TCP, i * SEG_LEN, SEG_LEN);
+	}
+
+	hdr = NET_IPV4_HDR(pkts[1]);
+
+	if (corrupt) {
+		hdr->chksum = ~hdr->chksum;
+	} else {
+		hdr->tos = 0x01;
+		hdr->chksum = 0;
+		hdr->chksum = ~net_calc_chksum_ipv4(pkts[1]);
+	}
+
+	ret = net_recv_data_batch(iface, pkts, 3);
+	zassert_equal(ret, 0, "Cannot receive batch (%d)", ret);
+
+	/* The changed segment is not merged and it splits the rest */
+	wait_deliveries(3);
+
+	zassert_equal(deliveries, 3, "Invalid number of segments");
+	zassert_equal(recv_errors, 0, "Invalid data received");
+}
+
+static void test_gro_ip_hdr(void)
+{
+	recv_ip_hdr_change(true);
+	recv_ip_hdr_change(false);
+}
+
+static void run_bench(const char *name, u8_t proto, bool batch)
+{
+	struct net_pkt *pkts[BATCH];
+	u32_t start, cycles = 0;
+	u64_t ns;
+	int round, i;
+
+	expected_seq = 0;
+	recv_bytes = 0;
+
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < BATCH; i++) {
+			if (proto == IPPROTO_TCP) {
+				pkts[i] = create_pkt(proto,
+						     (round * BATCH + i) *
+						     BENCH_LEN, BENCH_LEN);
+			} else {
+				pkts[i] = create_pkt(proto, round * BATCH + i,
+						     BENCH_LEN);
+			}
+		}
+
+		start = k_cycle_get_32();
+
+		if (batch) {
+			zassert_equal(net_recv_data_batch(iface, pkts, BATCH),
+				      0, "Cannot receive batch");
+		} else {
+			for (i = 0; i < BATCH; i++) {
+				zassert_equal(net_recv_data(iface, pkts[i]),
+					      0, "Cannot receive");
+			}
+		}
+
+		/* With GRO the TCP segments of one round are delivered
+		 * in fewer packets, so wait for the data instead.
+		 */
+		while (recv_bytes < (round + 1) * BATCH * BENCH_LEN) {
+			zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+				      "Timeout while waiting data");
+		}
+
+		cycles += k_cycle_get_32() - start;
+	}
+
+	ns = SYS_CLOCK_HW_CYCLES_TO_NS64(cycles);
+
+	TC_PRINT("%-16s %6u cycles per packet, %8u packets per second\n",
+		 name, cycles / (ROUNDS * BATCH),
+		 ns ? (u32_t)((u64_t)ROUNDS * BATCH * NSEC_PER_SEC / ns) : 0);
+}
+
+static void test_bench(void)
+{
+	recv_errors = 0;
+
+	run_bench("UDP single", IPPROTO_UDP, false);
+	run_bench("UDP batch", IPPROTO_UDP, true);
+	run_bench("TCP single", IPPROTO_TCP, false);
+	run_bench("TCP batch", IPPROTO_TCP, true);
+
+	zassert_equal(recv_errors, 0, "Invalid data received");
+}
+
+static void test_cleanup(void)
+{
+	zassert_equal(net_udp_unregister(udp_handle), 0, "Cannot unregister");
+	zassert_equal(net_tcp_unregister(tcp_handle), 0, "Cannot unregister");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_rx_batch,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_batch_order),
+			 ztest_unit_test(test_batch_invalid),
+			 ztest_unit_test(test_gro_in_order),
+			 ztest_unit_test(test_gro_out_of_order),
+			 ztest_unit_test(test_gro_bad_chksum),
+			 ztest_unit_test(test_gro_ip_hdr),
+			 ztest_unit_test(test_bench),
+			 ztest_unit_test(test_cleanup));
+
+	ztest_run_test_suite(net_rx_batch);
+}
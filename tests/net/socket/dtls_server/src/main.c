@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_SOCKETS_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/tls_credentials.h>
+
+#if !defined(CONFIG_MBEDTLS_CFG_FILE)
+#include "mbedtls/config.h"
+#else
+#include CONFIG_MBEDTLS_CFG_FILE
+#endif
+
+#include <mbedtls/memory_buffer_alloc.h>
+
+#define SERVER_PORT 4433
+#define PSK_TAG 1
+
+#define CLIENT_THREADS 4
+#define CLIENTS_PER_THREAD 16
+#define CLIENTS (CLIENT_THREADS * CLIENTS_PER_THREAD)
+
+#define WAIT_TIME K_SECONDS(10)
+
+static const u8_t psk[] = {
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10
+};
+static const char psk_id[] = "dtls_server_test";
+
+static const sec_tag_t sec_tags[] = { PSK_TAG };
+
+static struct sockaddr_in server_addr;
+static int listen_sock;
+
+/* Sockets of the clients and of their peers on the server */
+static int clients[CLIENTS];
+static int peers[CLIENTS];
+static int peer_count;
+
+static K_SEM_DEFINE(accepted, 0, CLIENTS);
+static K_SEM_DEFINE(connected, 0, CLIENTS);
+
+static K_THREAD_STACK_DEFINE(server_stack, 4096);
+static struct k_thread server_thread;
+
+static K_THREAD_STACK_ARRAY_DEFINE(client_stacks, CLIENT_THREADS, 4096);
+static struct k_thread client_threads[CLIENT_THREADS];
+
+static void server(void *p1, void *p2, void *p3)
+{
+	struct sockaddr addr;
+	socklen_t addrlen;
+	int sock;
+
+	while (1) {
+		/* Also retransmits handshake messages and evicts idle peers */
+		addrlen = sizeof(addr);
+		sock = accept(listen_sock, &addr, &addrlen);
+		if (sock < 0) {
+			continue;
+		}
+
+		zassert_equal(addrlen, sizeof(struct sockaddr_in),
+			      "Invalid peer address");
+
+		peers[peer_count++] = sock;
+		k_sem_give(&accepted);
+	}
+}
+
+/* The handshake is done when the first datagram is sent */
+static int client_connect(int id)
+{
+	int sock, ret;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_DTLS_1_2);
+	if (sock < 0) {
+		return -errno;
+	}
+
+	ret = setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tags,
+			 sizeof(sec_tags));
+	if (ret == 0) {
+		ret = connect(sock, (struct sockaddr *)&server_addr,
+			      sizeof(server_addr));
+	}
+
+	if (ret == 0 && send(sock, &id, sizeof(id), 0) != sizeof(id)) {
+		ret = -1;
+	}
+
+	if (ret < 0) {
+		ret = -errno;
+		close(sock);
+		return ret;
+	}
+
+	return sock;
+}
+
+static void client(void *p1, void *p2, void *p3)
+{
+	int first = POINTER_TO_INT(p1);
+	int i;
+
+	for (i = first; i < first + CLIENTS_PER_THREAD; i++) {
+		clients[i] = client_connect(i);
+		k_sem_give(&connected);
+	}
+}
+
+static size_t heap_used(void)
+{
+	size_t used, blocks;
+
+	mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+
+	return used;
+}
+
+static void test_setup(void)
+{
+	/* DTLS server */
+	int role = 1;
+
+	zassert_equal(tls_credential_add(PSK_TAG, TLS_CREDENTIAL_PSK, psk,
+					 sizeof(psk)), 0, "Cannot add PSK");
+	zassert_equal(tls_credential_add(PSK_TAG, TLS_CREDENTIAL_PSK_ID,
+					 psk_id, strlen(psk_id)), 0,
+		      "Cannot add PSK ID");
+
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(SERVER_PORT);
+	zassert_equal(inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				&server_addr.sin_addr), 1, "Invalid address");
+
+	listen_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_DTLS_1_2);
+	zassert_true(listen_sock >= 0, "Cannot create socket");
+
+	zassert_equal(setsockopt(listen_sock, SOL_TLS, TLS_SEC_TAG_LIST,
+				 sec_tags, sizeof(sec_tags)), 0,
+		      "Cannot set tags");
+	zassert_equal(setsockopt(listen_sock, SOL_TLS, TLS_DTLS_ROLE, &role,
+				 sizeof(role)), 0, "Cannot set role");
+
+	zassert_equal(bind(listen_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(listen(listen_sock, CLIENT_THREADS), 0,
+		      "Cannot listen");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+/* A ClientHello without a cookie gets a HelloVerifyRequest */
+static void test_hello_verify(void)
+{
+	static const u8_t hello[] = {
+		/* Record header, handshake, DTLS 1.2, epoch and sequence */
+		22, 0xfe, 0xfd, 0, 0, 0, 0, 0, 0, 0, 0, 0, 54,
+		/* ClientHello header, whole message in one fragment */
+		1, 0, 0, 42, 0, 0, 0, 0, 0, 0, 0, 0, 42,
+		/* DTLS 1.2 and random */
+		0xfe, 0xfd,
+		1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8,
+		1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8,
+		/* No session ID and no cookie */
+		0, 0,
+		/* TLS_PSK_WITH_AES_128_CBC_SHA256 */
+		0, 2, 0x00, 0xae,
+		/* No compression */
+		1, 0,
+	};
+	struct pollfd fds;
+	u8_t buf[64];
+	int sock, len;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Cannot create socket");
+
+	zassert_equal(sendto(sock, hello, sizeof(hello), 0,
+			     (struct sockaddr *)&server_addr,
+			     sizeof(server_addr)), sizeof(hello),
+		      "Cannot send");
+
+	fds.fd = sock;
+	fds.events = POLLIN;
+	zassert_equal(poll(&fds, 1, WAIT_TIME), 1, "No answer");
+
+	len = recv(sock, buf, sizeof(buf), 0);
+	zassert_true(len > 13, "Invalid answer");
+	zassert_equal(buf[0], 22, "Not a handshake message");
+	zassert_equal(buf[13], 3, "Not a HelloVerifyRequest");
+
+	close(sock);
+
+	zassert_equal(k_sem_count_get(&accepted), 0, "Peer accepted");
+}
+
+static void test_handshakes(void)
+{
+	u32_t start, time;
+	int i;
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < CLIENT_THREADS; i++) {
+		k_thread_create(&client_threads[i], client_stacks[i],
+				K_THREAD_STACK_SIZEOF(client_stacks[i]),
+				client, INT_TO_POINTER(i * CLIENTS_PER_THREAD),
+				NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+	}
+
+	for (i = 0; i < CLIENTS; i++) {
+		zassert_equal(k_sem_take(&connected, WAIT_TIME), 0,
+			      "Client %d not connected", i);
+		zassert_equal(k_sem_take(&accepted, WAIT_TIME), 0,
+			      "Peer %d not accepted", i);
+	}
+
+	time = k_uptime_get_32() - start;
+
+	for (i = 0; i < CLIENTS; i++) {
+		zassert_true(clients[i] >= 0, "Client %d failed (%d)", i,
+			     clients[i]);
+	}
+
+	zassert_equal(peer_count, CLIENTS, "Invalid peer count");
+
+	TC_PRINT("%d handshakes in %u ms", CLIENTS, time);
+	if (time) {
+		TC_PRINT(", %u handshakes/s", CLIENTS * MSEC_PER_SEC / time);
+	}
+	TC_PRINT("\n");
+}
+
+/* Each peer echoes the ID its client sent after the handshake */
+static void test_echo(void)
+{
+	int i, id, reply;
+
+	for (i = 0; i < CLIENTS; i++) {
+		zassert_equal(recv(peers[i], &id, sizeof(id), 0), sizeof(id),
+			      "Peer %d recv failed (%d)", i, errno);
+		zassert_true(id >= 0 && id < CLIENTS, "Invalid ID %d", id);
+
+		zassert_equal(send(peers[i], &id, sizeof(id), 0), sizeof(id),
+			      "Peer %d send failed (%d)", i, errno);
+
+		zassert_equal(recv(clients[id], &reply, sizeof(reply), 0),
+			      sizeof(reply), "Client %d recv failed (%d)", id,
+			      errno);
+		zassert_equal(reply, id, "Reply for another client");
+	}
+}
+
+static void test_memory(void)
+{
+	size_t with_peers, without_peers;
+	int i;
+
+	with_peers = heap_used();
+
+	for (i = 0; i < CLIENTS; i++) {
+		zassert_equal(close(peers[i]), 0, "Cannot close peer %d", i);
+	}
+
+	without_peers = heap_used();
+
+	for (i = 0; i < CLIENTS; i++) {
+		zassert_equal(close(clients[i]), 0, "Cannot close client %d",
+			      i);
+	}
+
+	zassert_true(with_peers > without_peers, "Peer memory not freed");
+
+	TC_PRINT("%u bytes of mbedTLS heap per peer, %u per client\n",
+		 (unsigned int)(with_peers - without_peers) / CLIENTS,
+		 (unsigned int)(without_peers - heap_used()) / CLIENTS);
+
+	peer_count = 0;
+}
+
+/* Messages made of several buffers are encrypted as one record each */
+static void test_msg(void)
+{
+	static const char hdr[] = "hdr:";
+	static const char data[] = "payload";
+	struct mmsghdr msgs[3];
+	struct iovec iovs[3];
+	struct iovec iov[2];
+	struct msghdr msg;
+	char buf1[6], buf2[16];
+	int values[3];
+	int sock, id, i, count;
+
+	sock = client_connect(0);
+	zassert_true(sock >= 0, "Cannot connect (%d)", sock);
+
+	zassert_equal(k_sem_take(&accepted, WAIT_TIME), 0,
+		      "Peer not accepted");
+	zassert_equal(recv(peers[0], &id, sizeof(id), 0), sizeof(id),
+		      "Peer recv failed (%d)", errno);
+
+	(void)memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = ARRAY_SIZE(iov);
+
+	iov[0].iov_base = (void *)hdr;
+	iov[0].iov_len = strlen(hdr);
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = strlen(data);
+
+	zassert_equal(sendmsg(sock, &msg, 0), strlen(hdr) + strlen(data),
+		      "sendmsg failed (%d)", errno);
+
+	/* Received into buffers split at another place */
+	iov[0].iov_base = buf1;
+	iov[0].iov_len = sizeof(buf1);
+	iov[1].iov_base = buf2;
+	iov[1].iov_len = sizeof(buf2);
+
+	zassert_equal(recvmsg(peers[0], &msg, 0), strlen(hdr) + strlen(data),
+		      "recvmsg failed (%d)", errno);
+	zassert_false(msg.msg_flags & MSG_TRUNC, "Message truncated");
+	zassert_equal(memcmp(buf1, "hdr:pa", sizeof(buf1)), 0, "Invalid data");
+	zassert_equal(memcmp(buf2, "yload", 5), 0, "Invalid data");
+
+	/* The part of a record that does not fit is dropped */
+	zassert_equal(send(sock, "0123456789", 10, 0), 10, "send failed");
+
+	msg.msg_iovlen = 1;
+	zassert_equal(recvmsg(peers[0], &msg, 0), sizeof(buf1),
+		      "recvmsg failed (%d)", errno);
+	zassert_true(msg.msg_flags & MSG_TRUNC, "Truncation not reported");
+	zassert_equal(memcmp(buf1, "012345", sizeof(buf1)), 0, "Invalid data");
+
+	for (i = 0; i < ARRAY_SIZE(msgs); i++) {
+		values[i] = i;
+		iovs[i].iov_base = &values[i];
+		iovs[i].iov_len = sizeof(values[i]);
+
+		(void)memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	zassert_equal(sendmmsg(sock, msgs, ARRAY_SIZE(msgs), 0),
+		      ARRAY_SIZE(msgs), "sendmmsg failed (%d)", errno);
+
+	(void)memset(values, 0xff, sizeof(values));
+
+	/* Only the first message is waited for */
+	for (i = 0; i < ARRAY_SIZE(msgs); i += count) {
+		count = recvmmsg(peers[0], &msgs[i], ARRAY_SIZE(msgs) - i, 0);
+		zassert_true(count > 0, "recvmmsg failed (%d)", errno);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(msgs); i++) {
+		zassert_equal(msgs[i].msg_len, sizeof(values[i]),
+			      "Invalid length");
+		zassert_equal(values[i], i, "Invalid message %d", i);
+	}
+
+	close(peers[0]);
+	close(sock);
+
+	peer_count = 0;
+}
+
+/* An idle peer is evicted by the listening socket */
+static void test_idle_eviction(void)
+{
+	int sock, id;
+
+	sock = client_connect(0);
+	zassert_true(sock >= 0, "Cannot connect (%d)", sock);
+
+	zassert_equal(k_sem_take(&accepted, WAIT_TIME), 0,
+		      "Peer not accepted");
+
+	k_sleep(CONFIG_NET_SOCKETS_DTLS_TIMEOUT + K_SECONDS(1));
+
+	zassert_equal(recv(peers[0], &id, sizeof(id), MSG_DONTWAIT), 0,
+		      "Idle peer not evicted");
+	zassert_equal(send(peers[0], &id, sizeof(id), 0), -1,
+		      "Send to evicted peer");
+	zassert_equal(errno, ECONNRESET, "Invalid error %d", errno);
+
+	close(peers[0]);
+	close(sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_dtls_server,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_hello_verify),
+			 ztest_unit_test(test_handshakes),
+			 ztest_unit_test(test_echo),
+			 ztest_unit_test(test_memory),
+			 ztest_unit_test(test_msg),
+			 ztest_unit_test(test_idle_eviction));
+
+	ztest_run_test_suite(socket_dtls_server);
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_SOCKETS_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/net_mgmt.h>
+#include <net/net_stats.h>
+#include <net/tls_credentials.h>
+
+#define SERVER_PORT 4433
+#define PSK_TAG 1
+
+#define WAIT_TIME K_SECONDS(10)
+
+static const u8_t psk[] = {
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10
+};
+static const char psk_id[] = "tls_session_test";
+
+static const sec_tag_t sec_tags[] = { PSK_TAG };
+
+/* Cost of a handshake */
+struct result {
+	u32_t time;
+	u32_t bytes;
+};
+
+static struct result full, resumed;
+
+static struct sockaddr_in server_addr;
+static int listen_sock;
+
+static K_SEM_DEFINE(accepted, 0, 1);
+static K_SEM_DEFINE(closed, 0, 1);
+
+static K_THREAD_STACK_DEFINE(server_stack, 4096);
+static struct k_thread server_thread;
+
+static void server(void *p1, void *p2, void *p3)
+{
+	char c;
+	int sock;
+
+	while (1) {
+		/* Returns when the handshake is complete */
+		sock = accept(listen_sock, NULL, NULL);
+		if (sock < 0) {
+			continue;
+		}
+
+		k_sem_give(&accepted);
+
+		/* Wait for the client to close the connection */
+		(void)recv(sock, &c, sizeof(c), 0);
+		close(sock);
+
+		k_sem_give(&closed);
+	}
+}
+
+/* Bytes sent over the loopback interface, in both directions */
+static u32_t bytes_on_air(void)
+{
+	struct net_stats_bytes stats;
+
+	zassert_equal(net_mgmt(NET_REQUEST_STATS_GET_BYTES, NULL, &stats,
+			       sizeof(stats)), 0, "Cannot get statistics");
+
+	return stats.sent;
+}
+
+static void set_cache(int sock, int cache)
+{
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &cache,
+				 sizeof(cache)), 0, "Cannot set session cache");
+}
+
+static void purge_cache(int sock)
+{
+	int dummy = 0;
+
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE_PURGE,
+				 &dummy, sizeof(dummy)), 0,
+		      "Cannot purge session cache");
+}
+
+/* Connect to the server and measure the handshake */
+static void handshake(int cache, struct result *res)
+{
+	u32_t start, bytes;
+	int sock, ret;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(sock >= 0, "Cannot create socket");
+
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tags,
+				 sizeof(sec_tags)), 0, "Cannot set tags");
+	set_cache(sock, cache);
+
+	bytes = bytes_on_air();
+	start = k_uptime_get_32();
+
+	ret = connect(sock, (struct sockaddr *)&server_addr,
+		      sizeof(server_addr));
+	zassert_equal(ret, 0, "Cannot connect (%d)", errno);
+
+	res->time = k_uptime_get_32() - start;
+
+	zassert_equal(k_sem_take(&accepted, WAIT_TIME), 0,
+		      "Server handshake not complete");
+
+	res->bytes = bytes_on_air() - bytes;
+
+	close(sock);
+
+	zassert_equal(k_sem_take(&closed, WAIT_TIME), 0,
+		      "Server did not close");
+}
+
+static void print_result(const char *name, struct result *res)
+{
+	TC_PRINT("%s handshake: %u ms, %u bytes\n", name, res->time,
+		 res->bytes);
+}
+
+static void test_setup(void)
+{
+	socklen_t optlen = sizeof(int);
+	int cache = 0;
+
+	zassert_equal(tls_credential_add(PSK_TAG, TLS_CREDENTIAL_PSK, psk,
+					 sizeof(psk)), 0, "Cannot add PSK");
+	zassert_equal(tls_credential_add(PSK_TAG, TLS_CREDENTIAL_PSK_ID,
+					 psk_id, strlen(psk_id)), 0,
+		      "Cannot add PSK ID");
+
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(SERVER_PORT);
+	zassert_equal(inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				&server_addr.sin_addr), 1, "Invalid address");
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(listen_sock >= 0, "Cannot create socket");
+
+	zassert_equal(setsockopt(listen_sock, SOL_TLS, TLS_SEC_TAG_LIST,
+				 sec_tags, sizeof(sec_tags)), 0,
+		      "Cannot set tags");
+	set_cache(listen_sock, 1);
+
+	zassert_equal(getsockopt(listen_sock, SOL_TLS, TLS_SESSION_CACHE,
+				 &cache, &optlen), 0, "Cannot get session cache");
+	zassert_equal(cache, 1, "Session cache not enabled");
+
+	zassert_equal(bind(listen_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(listen(listen_sock, 1), 0, "Cannot listen");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+static void test_resume(void)
+{
+	purge_cache(listen_sock);
+
+	handshake(1, &full);
+	handshake(1, &resumed);
+
+	print_result("Full", &full);
+	print_result("Resumed", &resumed);
+
+	zassert_true(resumed.bytes < full.bytes, "Session not resumed");
+	zassert_true(resumed.time <= full.time, "Resumption slower");
+}
+
+static void test_disabled(void)
+{
+	struct result res;
+
+	/* The client does not offer the session it has cached */
+	handshake(0, &res);
+	print_result("Uncached", &res);
+
+	zassert_true(res.bytes > resumed.bytes, "Session resumed");
+}
+
+static void test_purge(void)
+{
+	struct result res;
+
+	handshake(1, &res);
+	zassert_true(res.bytes < full.bytes, "Session not resumed");
+
+	purge_cache(listen_sock);
+
+	handshake(1, &res);
+	zassert_true(res.bytes > resumed.bytes, "Purged session resumed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_tls_session,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_resume),
+			 ztest_unit_test(test_disabled),
+			 ztest_unit_test(test_purge));
+
+	ztest_run_test_suite(socket_tls_session);
+}
@@ -325,6 +325,160 @@ void test_send_recv_2_sock(void)
 	zassert_equal(rv, 0, "close failed");
 }
 
+static void prepare_sock_pair(int *server_sock, int *client_sock,
+			      struct sockaddr_in *server_addr)
+{
+	int rv;
+
+	prepare_sock_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			server_sock, server_addr);
+
+	rv = bind(*server_sock, (struct sockaddr *)server_addr,
+		  sizeof(*server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	*client_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(*client_sock >= 0, "socket open failed");
+}
+
+void test_sendmsg_recvmsg(void)
+{
+	int server_sock, client_sock;
+	struct sockaddr_in server_addr, addr;
+	char part1[] = "scatter", part2[] = "-gather";
+	char buf1[4], buf2[16];
+	struct iovec iov[2];
+	struct msghdr msg;
+	ssize_t len;
+	int rv;
+
+	prepare_sock_pair(&server_sock, &client_sock, &server_addr);
+
+	iov[0].iov_base = part1;
+	iov[0].iov_len = STRLEN(part1);
+	iov[1].iov_base = part2;
+	iov[1].iov_len = STRLEN(part2);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &server_addr;
+	msg.msg_namelen = sizeof(server_addr);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	len = sendmsg(client_sock, &msg, 0);
+	zassert_equal(len, STRLEN(part1) + STRLEN(part2), "invalid send len");
+
+	/* The datagram is split over the buffers */
+	iov[0].iov_base = buf1;
+	iov[0].iov_len = sizeof(buf1);
+	iov[1].iov_base = buf2;
+	iov[1].iov_len = sizeof(buf2);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	len = recvmsg(server_sock, &msg, 0);
+	zassert_equal(len, STRLEN(part1) + STRLEN(part2), "invalid recv len");
+	zassert_equal(msg.msg_namelen, sizeof(struct sockaddr_in),
+		      "invalid addrlen");
+	zassert_equal(msg.msg_flags, 0, "invalid flags");
+	zassert_equal(memcmp(buf1, "scat", sizeof(buf1)), 0, "invalid data");
+	zassert_equal(memcmp(buf2, "ter-gather", 10), 0, "invalid data");
+
+	/* A datagram longer than the buffers is truncated */
+	len = sendto(client_sock, BUF_AND_SIZE("truncated datagram"), 0,
+		     (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(len, STRLEN("truncated datagram"), "invalid send len");
+
+	msg.msg_iovlen = 1;
+
+	len = recvmsg(server_sock, &msg, 0);
+	zassert_equal(len, sizeof(buf1), "invalid recv len");
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "truncation not reported");
+	zassert_equal(memcmp(buf1, "trun", sizeof(buf1)), 0, "invalid data");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+#define MMSG_COUNT 3
+
+void test_sendmmsg_recvmmsg(void)
+{
+	int server_sock, client_sock;
+	struct sockaddr_in server_addr;
+	struct mmsghdr msgs[MMSG_COUNT + 1];
+	struct iovec iov[MMSG_COUNT + 1];
+	char bufs[MMSG_COUNT + 1][8];
+	int i, rv;
+
+	prepare_sock_pair(&server_sock, &client_sock, &server_addr);
+
+	memset(msgs, 0, sizeof(msgs));
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		snprintf(bufs[i], sizeof(bufs[i]), "msg%d", i);
+
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = strlen(bufs[i]);
+
+		msgs[i].msg_hdr.msg_name = &server_addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof(server_addr);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	rv = sendmmsg(client_sock, msgs, MMSG_COUNT, 0);
+	zassert_equal(rv, MMSG_COUNT, "invalid sent count");
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		zassert_equal(msgs[i].msg_len, 4, "invalid send len");
+	}
+
+	memset(msgs, 0, sizeof(msgs));
+	memset(bufs, 0, sizeof(bufs));
+
+	for (i = 0; i < MMSG_COUNT + 1; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = sizeof(bufs[i]);
+
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	/* Let the datagrams pass the loopback interface */
+	k_sleep(K_MSEC(100));
+
+	/* Only the queued datagrams are returned */
+	rv = recvmmsg(server_sock, msgs, MMSG_COUNT + 1, 0);
+	zassert_equal(rv, MMSG_COUNT, "invalid received count");
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		char expected[8];
+
+		snprintf(expected, sizeof(expected), "msg%d", i);
+
+		zassert_equal(msgs[i].msg_len, 4, "invalid recv len");
+		zassert_equal(strcmp(bufs[i], expected), 0, "invalid data");
+	}
+
+	rv = recvmmsg(server_sock, msgs, MMSG_COUNT, MSG_DONTWAIT);
+	zassert_equal(rv, -1, "unexpected data");
+	zassert_equal(errno, EAGAIN, "invalid errno");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(socket_udp,
@@ -332,7 +486,9 @@ void test_main(void)
 			 ztest_unit_test(test_v4_sendto_recvfrom),
 			 ztest_unit_test(test_v6_sendto_recvfrom),
 			 ztest_unit_test(test_v4_bind_sendto),
-			 ztest_unit_test(test_v6_bind_sendto));
+			 ztest_unit_test(test_v6_bind_sendto),
+			 ztest_unit_test(test_sendmsg_recvmsg),
+			 ztest_unit_test(test_sendmmsg_recvmmsg));
 
 	ztest_run_test_suite(socket_udp);
 }
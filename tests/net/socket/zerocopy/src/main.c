@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_SOCKETS_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+#include <net/socket.h>
+#include <net/net_pkt.h>
+#include <net/buf.h>
+
+#define SERVER_PORT 4242
+#define ANY_PORT 0
+
+/* Fits into one datagram on the loopback interface */
+#define DGRAM_LEN 512
+#define STREAM_LEN 3000
+
+#define BENCH_ROUNDS 200
+
+#define WAIT_TIME K_SECONDS(1)
+#define TCP_TEARDOWN_TIMEOUT K_SECONDS(1)
+
+static u8_t data_byte(int i)
+{
+	return (u8_t)(i * 7 + 3);
+}
+
+static void prepare_sock(int type, u16_t port, int *sock,
+			 struct sockaddr_in *sockaddr)
+{
+	int rv;
+
+	*sock = socket(AF_INET, type,
+		       type == SOCK_STREAM ? IPPROTO_TCP : IPPROTO_UDP);
+	zassert_true(*sock >= 0, "socket open failed");
+
+	sockaddr->sin_family = AF_INET;
+	sockaddr->sin_port = htons(port);
+	rv = inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+		       &sockaddr->sin_addr);
+	zassert_equal(rv, 1, "inet_pton failed");
+}
+
+/* Build a buffer chain holding len bytes of test data starting at offset */
+static struct net_buf *create_chain(int sock, int offset, int len)
+{
+	struct net_buf *head = NULL;
+
+	while (len > 0) {
+		struct net_buf *buf;
+		int chunk;
+
+		buf = zsock_get_buf(sock, WAIT_TIME);
+		zassert_not_null(buf, "Out of buffers");
+
+		chunk = min(len, net_buf_tailroom(buf));
+
+		for (len -= chunk; chunk; chunk--) {
+			net_buf_add_u8(buf, data_byte(offset++));
+		}
+
+		if (head) {
+			net_buf_frag_add(head, buf);
+		} else {
+			head = buf;
+		}
+	}
+
+	return head;
+}
+
+static void check_pkt(struct net_pkt *pkt, int offset, int len)
+{
+	struct net_buf *frag;
+	int i, count = 0;
+
+	for (frag = pkt->frags; frag; frag = frag->frags) {
+		for (i = 0; i < frag->len; i++) {
+			zassert_equal(frag->data[i], data_byte(offset + count),
+				      "Invalid data at %d", offset + count);
+			count++;
+		}
+	}
+
+	zassert_equal(count, len, "Invalid length %d, expected %d", count,
+		      len);
+}
+
+static void test_udp_send_recv(void)
+{
+	struct sockaddr_in c_saddr, s_saddr, addr;
+	socklen_t addrlen = sizeof(addr);
+	struct net_pkt *pkt;
+	int c_sock, s_sock;
+	ssize_t ret;
+
+	prepare_sock(SOCK_DGRAM, ANY_PORT, &c_sock, &c_saddr);
+	prepare_sock(SOCK_DGRAM, SERVER_PORT, &s_sock, &s_saddr);
+
+	zassert_equal(bind(s_sock, (struct sockaddr *)&s_saddr,
+			   sizeof(s_saddr)), 0, "bind failed");
+
+	ret = zsock_sendto_zc(c_sock, create_chain(c_sock, 0, DGRAM_LEN), 0,
+			      (struct sockaddr *)&s_saddr, sizeof(s_saddr));
+	zassert_equal(ret, DGRAM_LEN, "sendto failed (%d)", errno);
+
+	ret = zsock_recvfrom_zc(s_sock, &pkt, 0, (struct sockaddr *)&addr,
+				&addrlen);
+	zassert_equal(ret, DGRAM_LEN, "recvfrom failed (%d)", errno);
+	zassert_not_null(pkt, "No packet lent");
+	zassert_equal(addrlen, sizeof(struct sockaddr_in), "wrong addrlen");
+
+	check_pkt(pkt, 0, DGRAM_LEN);
+	zsock_recv_zc_release(s_sock, pkt);
+
+	/* Nothing else must be queued */
+	ret = zsock_recv_zc(s_sock, &pkt, ZSOCK_MSG_DONTWAIT);
+	zassert_equal(ret, -1, "Unexpected data");
+	zassert_equal(errno, EAGAIN, "Unexpected errno %d", errno);
+	zassert_is_null(pkt, "Unexpected packet");
+
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+}
+
+static void test_udp_too_long(void)
+{
+	struct sockaddr_in c_saddr, s_saddr;
+	int c_sock;
+	ssize_t ret;
+
+	prepare_sock(SOCK_DGRAM, ANY_PORT, &c_sock, &c_saddr);
+
+	s_saddr = c_saddr;
+	s_saddr.sin_port = htons(SERVER_PORT);
+
+	ret = zsock_sendto_zc(c_sock, create_chain(c_sock, 0, 2 * DGRAM_LEN),
+			      0, (struct sockaddr *)&s_saddr, sizeof(s_saddr));
+	zassert_equal(ret, -1, "Too long datagram sent");
+	zassert_equal(errno, EMSGSIZE, "Unexpected errno %d", errno);
+
+	ret = zsock_recv_zc(c_sock, NULL, 0);
+	zassert_equal(ret, -1, "NULL packet pointer accepted");
+	zassert_equal(errno, EINVAL, "Unexpected errno %d", errno);
+
+	zassert_equal(close(c_sock), 0, "close failed");
+}
+
+static void test_tcp_send_recv(void)
+{
+	struct sockaddr_in c_saddr, s_saddr, addr;
+	socklen_t addrlen = sizeof(addr);
+	int c_sock, s_sock, new_sock;
+	struct net_pkt *pkt;
+	int received = 0;
+	ssize_t ret;
+
+	prepare_sock(SOCK_STREAM, ANY_PORT, &c_sock, &c_saddr);
+	prepare_sock(SOCK_STREAM, SERVER_PORT, &s_sock, &s_saddr);
+
+	zassert_equal(bind(s_sock, (struct sockaddr *)&s_saddr,
+			   sizeof(s_saddr)), 0, "bind failed");
+	zassert_equal(listen(s_sock, 1), 0, "listen failed");
+	zassert_equal(connect(c_sock, (struct sockaddr *)&s_saddr,
+			      sizeof(s_saddr)), 0, "connect failed");
+
+	new_sock = accept(s_sock, (struct sockaddr *)&addr, &addrlen);
+	zassert_true(new_sock >= 0, "accept failed");
+
+	/* Longer than one segment, so the chain is split */
+	ret = zsock_send_zc(c_sock, create_chain(c_sock, 0, STREAM_LEN), 0);
+	zassert_equal(ret, STREAM_LEN, "send failed (%d)", errno);
+
+	while (received < STREAM_LEN) {
+		ret = zsock_recv_zc(new_sock, &pkt, 0);
+		zassert_true(ret > 0, "recv failed (%d)", errno);
+
+		check_pkt(pkt, received, ret);
+		received += ret;
+
+		zsock_recv_zc_release(new_sock, pkt);
+	}
+
+	zassert_equal(received, STREAM_LEN, "Too much data received");
+
+	zassert_equal(close(c_sock), 0, "close failed");
+
+	ret = zsock_recv_zc(new_sock, &pkt, 0);
+	zassert_equal(ret, 0, "No end of stream");
+	zassert_is_null(pkt, "Unexpected packet");
+
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+
+	k_sleep(TCP_TEARDOWN_TIMEOUT);
+}
+
+static void bench_print(const char *name, u32_t cycles)
+{
+	u64_t ns = SYS_CLOCK_HW_CYCLES_TO_NS64(cycles);
+
+	TC_PRINT("%-16s %6u cycles per datagram, %8u kB per second\n",
+		 name, cycles / BENCH_ROUNDS,
+		 ns ? (u32_t)((u64_t)BENCH_ROUNDS * DGRAM_LEN *
+			      NSEC_PER_SEC / 1024 / ns) : 0);
+}
+
+/* Measure UDP throughput over loopback with copying and zero-copy calls.
+ * On native_posix the cycle counter is simulated, so the figures are only
+ * meaningful on real targets or qemu.
+ */
+static void test_udp_throughput(void)
+{
+	static u8_t buf[DGRAM_LEN];
+	struct sockaddr_in c_saddr, s_saddr;
+	u32_t start, cycles;
+	struct net_pkt *pkt;
+	int c_sock, s_sock;
+	int i;
+
+	prepare_sock(SOCK_DGRAM, ANY_PORT, &c_sock, &c_saddr);
+	prepare_sock(SOCK_DGRAM, SERVER_PORT, &s_sock, &s_saddr);
+
+	zassert_equal(bind(s_sock, (struct sockaddr *)&s_saddr,
+			   sizeof(s_saddr)), 0, "bind failed");
+	zassert_equal(connect(c_sock, (struct sockaddr *)&s_saddr,
+			      sizeof(s_saddr)), 0, "connect failed");
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = data_byte(i);
+	}
+
+	cycles = 0;
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		start = k_cycle_get_32();
+
+		zassert_equal(send(c_sock, buf, sizeof(buf), 0), sizeof(buf),
+			      "send failed");
+		zassert_equal(recv(s_sock, buf, sizeof(buf), 0), sizeof(buf),
+			      "recv failed");
+
+		cycles += k_cycle_get_32() - start;
+	}
+
+	bench_print("UDP copy", cycles);
+
+	cycles = 0;
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		struct net_buf *chain;
+
+		/* Filling the buffers is the application's own work */
+		chain = create_chain(c_sock, 0, DGRAM_LEN);
+
+		start = k_cycle_get_32();
+
+		zassert_equal(zsock_send_zc(c_sock, chain, 0), DGRAM_LEN,
+			      "send failed");
+		zassert_equal(zsock_recv_zc(s_sock, &pkt, 0), DGRAM_LEN,
+			      "recv failed");
+		zsock_recv_zc_release(s_sock, pkt);
+
+		cycles += k_cycle_get_32() - start;
+	}
+
+	bench_print("UDP zero-copy", cycles);
+
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_zerocopy,
+			 ztest_unit_test(test_udp_send_recv),
+			 ztest_unit_test(test_udp_too_long),
+			 ztest_unit_test(test_tcp_send_recv),
+			 ztest_unit_test(test_udp_throughput));
+
+	ztest_run_test_suite(socket_zerocopy);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_TCP_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+
+#include <net/socket.h>
+#include <net/loopback.h>
+
+#include "net_stats.h"
+#include "tcp_internal.h"
+
+#define SERVER_PORT 4242
+
+/* One-way delay, i.e. the round-trip time is 50 ms */
+#define LINK_DELAY 25
+
+#define CHUNK_LEN 4096
+#define TOTAL_LEN (2 * 1024 * 1024)
+
+#define RECV_STACK_SIZE 2048
+#define RECV_PRIORITY K_PRIO_PREEMPT(8)
+
+#define TCP_TEARDOWN_TIMEOUT K_SECONDS(1)
+
+static K_THREAD_STACK_DEFINE(recv_stack, RECV_STACK_SIZE);
+static struct k_thread recv_thread;
+static K_SEM_DEFINE(recv_done, 0, 1);
+static size_t recv_total;
+static u8_t recv_buf[CHUNK_LEN];
+static u8_t send_buf[CHUNK_LEN];
+
+static void recv_entry(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+	ssize_t len;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	recv_total = 0;
+
+	while (recv_total < TOTAL_LEN) {
+		len = recv(sock, recv_buf, sizeof(recv_buf), 0);
+		if (len <= 0) {
+			break;
+		}
+
+		recv_total += len;
+	}
+
+	k_sem_give(&recv_done);
+}
+
+static void tcp_flags_cb(struct net_tcp *tcp, void *user_data)
+{
+	u8_t *flags = user_data;
+
+	if (net_tcp_get_state(tcp) == NET_TCP_ESTABLISHED) {
+		*flags |= tcp->flags;
+	}
+}
+
+static void check_options(void)
+{
+	u8_t flags = 0;
+
+	net_tcp_foreach(tcp_flags_cb, &flags);
+
+	zassert_equal(!!(flags & NET_TCP_WSCALE),
+		      IS_ENABLED(CONFIG_NET_TCP_WINDOW_SCALE),
+		      "window scale not negotiated");
+	zassert_equal(!!(flags & NET_TCP_TS),
+		      IS_ENABLED(CONFIG_NET_TCP_TIMESTAMPS),
+		      "timestamps not negotiated");
+	zassert_equal(!!(flags & NET_TCP_SACK),
+		      IS_ENABLED(CONFIG_NET_TCP_SACK),
+		      "SACK not negotiated");
+}
+
+static void run_throughput(u32_t drop_ratio)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+	};
+	int c_sock, s_sock, new_sock;
+	u32_t start, elapsed, rexmit;
+	size_t sent;
+	ssize_t len;
+
+	(void)memset(send_buf, 'a', sizeof(send_buf));
+
+	zassert_equal(inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				&addr.sin_addr), 1, "inet_pton failed");
+
+	s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(s_sock >= 0, "socket open failed");
+	c_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(c_sock >= 0, "socket open failed");
+
+	zassert_equal(bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "bind failed");
+	zassert_equal(listen(s_sock, 1), 0, "listen failed");
+	zassert_equal(connect(c_sock, (struct sockaddr *)&addr,
+			      sizeof(addr)), 0, "connect failed");
+
+	new_sock = accept(s_sock, NULL, NULL);
+	zassert_true(new_sock >= 0, "accept failed");
+
+	check_options();
+
+	k_thread_create(&recv_thread, recv_stack,
+			K_THREAD_STACK_SIZEOF(recv_stack), recv_entry,
+			INT_TO_POINTER(new_sock), NULL, NULL,
+			RECV_PRIORITY, 0, K_NO_WAIT);
+
+	rexmit = GET_STAT(net_if_get_default(), tcp.rexmit);
+
+	/* The handshake is done without delay or loss */
+	loopback_set_delay(LINK_DELAY);
+	loopback_set_packet_drop_ratio(drop_ratio);
+
+	start = k_uptime_get_32();
+
+	for (sent = 0; sent < TOTAL_LEN; sent += len) {
+		len = send(c_sock, send_buf,
+			   min(sizeof(send_buf), TOTAL_LEN - sent), 0);
+		zassert_true(len > 0, "send failed");
+	}
+
+	zassert_equal(k_sem_take(&recv_done, K_SECONDS(120)), 0,
+		      "receive timeout (%zu bytes)", recv_total);
+
+	elapsed = max(k_uptime_get_32() - start, 1);
+
+	loopback_set_packet_drop_ratio(0);
+	loopback_set_delay(0);
+
+	zassert_equal(recv_total, TOTAL_LEN, "data lost");
+
+	TC_PRINT("rtt %u ms, loss %2u.%u%%: %u bytes in %u ms, %u kB/s, "
+		 "%u retransmits\n", 2 * LINK_DELAY,
+		 drop_ratio / 10, drop_ratio % 10, TOTAL_LEN, elapsed,
+		 TOTAL_LEN / elapsed,
+		 GET_STAT(net_if_get_default(), tcp.rexmit) - rexmit);
+
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+
+	k_sleep(TCP_TEARDOWN_TIMEOUT);
+}
+
+static void test_throughput_no_loss(void)
+{
+	run_throughput(0);
+}
+
+static void test_throughput_1_percent_loss(void)
+{
+	run_throughput(10);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(tcp_bdp,
+			 ztest_unit_test(test_throughput_no_loss),
+			 ztest_unit_test(test_throughput_1_percent_loss));
+
+	ztest_run_test_suite(tcp_bdp);
+}
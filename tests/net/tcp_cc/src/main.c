@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_TCP_LOG_LEVEL
+
+#include <ztest.h>
+#include <tc_util.h>
+
+#include <net/socket.h>
+#include <net/loopback.h>
+
+#include "net_stats.h"
+#include "tcp_internal.h"
+
+#define TEST_MSS 1000
+
+#define SERVER_PORT 4242
+
+#define CHUNK_LEN 256
+#define TOTAL_LEN (64 * 1024)
+
+#define RECV_STACK_SIZE 2048
+#define RECV_PRIORITY K_PRIO_PREEMPT(8)
+
+#define TCP_TEARDOWN_TIMEOUT K_SECONDS(1)
+
+static struct net_tcp tcp;
+
+static K_THREAD_STACK_DEFINE(recv_stack, RECV_STACK_SIZE);
+static struct k_thread recv_thread;
+static K_SEM_DEFINE(recv_done, 0, 1);
+static size_t recv_total;
+
+static void cc_reset(const struct net_tcp_cc *cc, u32_t cwnd)
+{
+	(void)memset(&tcp, 0, sizeof(tcp));
+
+	tcp.send_mss = TEST_MSS;
+	tcp.cwnd = cwnd;
+	tcp.ssthresh = UINT32_MAX;
+	tcp.srtt = 10 << 3;
+	tcp.cc = cc;
+
+	if (cc->init) {
+		cc->init(&tcp);
+	}
+}
+
+/* Acknowledge one full window of data, one segment at a time */
+static void cc_ack_window(const struct net_tcp_cc *cc)
+{
+	u32_t segs = tcp.cwnd / TEST_MSS;
+
+	while (segs--) {
+		cc->ack(&tcp, TEST_MSS);
+	}
+}
+
+static void test_newreno(void)
+{
+	const struct net_tcp_cc *cc = &net_tcp_cc_newreno;
+	u32_t cwnd;
+
+	cc_reset(cc, 4 * TEST_MSS);
+
+	/* Slow start doubles the window every round trip */
+	cc_ack_window(cc);
+	zassert_equal(tcp.cwnd, 8 * TEST_MSS, "slow start failed");
+
+	/* Loss halves the window */
+	tcp.ssthresh = cc->ssthresh(&tcp, tcp.cwnd);
+	zassert_equal(tcp.ssthresh, 4 * TEST_MSS, "wrong ssthresh");
+
+	tcp.ssthresh = cc->ssthresh(&tcp, TEST_MSS);
+	zassert_equal(tcp.ssthresh, 2 * TEST_MSS, "ssthresh below 2 * MSS");
+
+	/* Congestion avoidance grows about one MSS per round trip */
+	tcp.cwnd = 8 * TEST_MSS;
+	tcp.ssthresh = 8 * TEST_MSS;
+	cwnd = tcp.cwnd;
+
+	cc_ack_window(cc);
+	zassert_true(tcp.cwnd > cwnd && tcp.cwnd <= cwnd + TEST_MSS,
+		     "congestion avoidance failed (%u)", tcp.cwnd);
+}
+
+static void test_cubic(void)
+{
+#if defined(CONFIG_NET_TCP_CC_CUBIC)
+	const struct net_tcp_cc *cc = &net_tcp_cc_cubic;
+	u32_t cwnd;
+	int i;
+
+	cc_reset(cc, 4 * TEST_MSS);
+
+	cc_ack_window(cc);
+	zassert_equal(tcp.cwnd, 8 * TEST_MSS, "slow start failed");
+
+	/* beta_cubic is 0.7 */
+	tcp.cwnd = 100 * TEST_MSS;
+	tcp.ssthresh = cc->ssthresh(&tcp, tcp.cwnd);
+	zassert_true(tcp.ssthresh > 69 * TEST_MSS &&
+		     tcp.ssthresh < 71 * TEST_MSS,
+		     "wrong ssthresh (%u)", tcp.ssthresh);
+	zassert_equal(tcp.cubic.w_max, 100 * TEST_MSS, "wrong w_max");
+
+	/* After the reduction the window grows back towards w_max */
+	tcp.cwnd = tcp.ssthresh;
+	cwnd = tcp.cwnd;
+
+	for (i = 0; i < 10; i++) {
+		cc_ack_window(cc);
+	}
+
+	zassert_true(tcp.cwnd > cwnd, "window did not grow (%u)", tcp.cwnd);
+	zassert_true(tcp.cubic.k > 0, "K not calculated");
+
+	/* Fast convergence, the next loss happens below w_max */
+	tcp.cwnd = 90 * TEST_MSS;
+	tcp.ssthresh = cc->ssthresh(&tcp, tcp.cwnd);
+	zassert_true(tcp.cubic.w_max < 90 * TEST_MSS,
+		     "fast convergence failed (%u)", tcp.cubic.w_max);
+#else
+	ztest_test_skip();
+#endif
+}
+
+static void recv_entry(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+	char buf[CHUNK_LEN];
+	ssize_t len;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	recv_total = 0;
+
+	while (recv_total < TOTAL_LEN) {
+		len = recv(sock, buf, sizeof(buf), 0);
+		if (len <= 0) {
+			break;
+		}
+
+		recv_total += len;
+	}
+
+	k_sem_give(&recv_done);
+}
+
+static void run_throughput(u32_t drop_ratio)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+	};
+	char buf[CHUNK_LEN];
+	int c_sock, s_sock, new_sock;
+	u32_t start, elapsed, rexmit;
+	size_t sent;
+
+	(void)memset(buf, 'a', sizeof(buf));
+
+	zassert_equal(inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+				&addr.sin_addr), 1, "inet_pton failed");
+
+	s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(s_sock >= 0, "socket open failed");
+	c_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(c_sock >= 0, "socket open failed");
+
+	zassert_equal(bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "bind failed");
+	zassert_equal(listen(s_sock, 1), 0, "listen failed");
+	zassert_equal(connect(c_sock, (struct sockaddr *)&addr,
+			      sizeof(addr)), 0, "connect failed");
+
+	new_sock = accept(s_sock, NULL, NULL);
+	zassert_true(new_sock >= 0, "accept failed");
+
+	k_thread_create(&recv_thread, recv_stack,
+			K_THREAD_STACK_SIZEOF(recv_stack), recv_entry,
+			INT_TO_POINTER(new_sock), NULL, NULL,
+			RECV_PRIORITY, 0, K_NO_WAIT);
+
+	rexmit = GET_STAT(net_if_get_default(), tcp.rexmit);
+
+	/* Only data segments are lost, the handshake is not retried */
+	loopback_set_packet_drop_ratio(drop_ratio);
+
+	start = k_uptime_get_32();
+
+	for (sent = 0; sent < TOTAL_LEN; sent += sizeof(buf)) {
+		zassert_equal(send(c_sock, buf, sizeof(buf), 0), sizeof(buf),
+			      "send failed");
+	}
+
+	zassert_equal(k_sem_take(&recv_done, K_SECONDS(60)), 0,
+		      "receive timeout (%zu bytes)", recv_total);
+
+	elapsed = max(k_uptime_get_32() - start, 1);
+
+	loopback_set_packet_drop_ratio(0);
+
+	zassert_equal(recv_total, TOTAL_LEN, "data lost");
+
+	TC_PRINT("loss %2u.%u%%: %u bytes in %u ms, %u kB/s, "
+		 "%u retransmits, %u dropped\n",
+		 drop_ratio / 10, drop_ratio % 10, TOTAL_LEN, elapsed,
+		 TOTAL_LEN / elapsed,
+		 GET_STAT(net_if_get_default(), tcp.rexmit) - rexmit,
+		 loopback_get_num_dropped_packets());
+
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+
+	k_sleep(TCP_TEARDOWN_TIMEOUT);
+}
+
+static void test_throughput_no_loss(void)
+{
+	run_throughput(0);
+}
+
+static void test_throughput_1_percent_loss(void)
+{
+	run_throughput(10);
+}
+
+static void test_throughput_5_percent_loss(void)
+{
+	run_throughput(50);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(tcp_cc,
+			 ztest_unit_test(test_newreno),
+			 ztest_unit_test(test_cubic),
+			 ztest_unit_test(test_throughput_no_loss),
+			 ztest_unit_test(test_throughput_1_percent_loss),
+			 ztest_unit_test(test_throughput_5_percent_loss));
+
+	ztest_run_test_suite(tcp_cc);
+}
@@ -0,0 +1,211 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_MODULE_NAME net_test
+#define NET_LOG_LEVEL CONFIG_NET_TC_LOG_LEVEL
+
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <string.h>
+
+#include <tc_util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+
+#define PKT_LEN CONFIG_NET_TX_SCHED_QUANTUM
+#define PKT_MARKER 0x5a
+#define MAX_SENT 32
+
+#define ALLOC_TIMEOUT K_MSEC(500)
+#define WAIT_TIME K_MSEC(200)
+
+static struct net_if *iface;
+
+/* Traffic class and time of each packet in the order they were sent */
+static u8_t sent_tc[MAX_SENT];
+static s64_t sent_time[MAX_SENT];
+static int sent_count;
+
+/* A priority that maps to each Tx traffic class */
+static enum net_priority tc_prio[NET_TC_TX_COUNT];
+
+static int net_iface_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static u8_t mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x05 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_ETHERNET);
+}
+
+static int tester_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	/* Ignore anything the stack itself might send */
+	if (net_pkt_get_len(pkt) == PKT_LEN &&
+	    pkt->frags->data[0] == PKT_MARKER && sent_count < MAX_SENT) {
+		sent_tc[sent_count] =
+			net_tx_priority2tc(net_pkt_priority(pkt));
+		sent_time[sent_count] = k_uptime_get();
+		sent_count++;
+	}
+
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct net_if_api net_iface_api = {
+	.init = net_iface_init,
+	.send = tester_send,
+};
+
+NET_DEVICE_INIT(net_tx_sched_test, "net_tx_sched_test",
+		net_iface_dev_init, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 1500);
+
+/* The test thread is cooperative, so nothing is sent before it sleeps */
+static void queue_pkt(u8_t tc)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_get_reserve_tx(0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "Out of TX packets");
+
+	zassert_true(net_pkt_append_memset(pkt, PKT_LEN, PKT_MARKER,
+					   ALLOC_TIMEOUT) == PKT_LEN,
+		     "Cannot append data");
+
+	net_pkt_set_iface(pkt, iface);
+	net_pkt_set_priority(pkt, tc_prio[tc]);
+
+	net_if_queue_tx(iface, pkt);
+}
+
+static void test_setup(void)
+{
+	int prio;
+
+	iface = net_if_get_default();
+
+	for (prio = NET_PRIORITY_NC; prio >= 0; prio--) {
+		tc_prio[net_tx_priority2tc(prio)] = prio;
+	}
+
+	zassert_not_equal(net_tx_priority2tc(tc_prio[0]),
+			  net_tx_priority2tc(tc_prio[1]),
+			  "Priorities map to one traffic class");
+}
+
+static void test_weighted_fair(void)
+{
+	struct net_if_tx_queue_stats stats;
+	int i, high = 0;
+
+	zassert_equal(net_if_tx_sched_set_weight(iface, 0, 1), 0,
+		      "Cannot set weight");
+	zassert_equal(net_if_tx_sched_set_weight(iface, 1, 3), 0,
+		      "Cannot set weight");
+	zassert_equal(net_if_tx_sched_set_weight(iface, 1, 0), -EINVAL,
+		      "Zero weight accepted");
+
+	sent_count = 0;
+
+	for (i = 0; i < 8; i++) {
+		queue_pkt(0);
+		queue_pkt(1);
+	}
+
+	k_sleep(WAIT_TIME);
+
+	zassert_equal(sent_count, 16, "Invalid number of packets sent %d",
+		      sent_count);
+
+	/* The classes share the link 1:3 while both are backlogged */
+	for (i = 0; i < 8; i++) {
+		if (sent_tc[i] == 1) {
+			high++;
+		}
+	}
+
+	zassert_equal(high, 6, "Invalid share %d/8 for high class", high);
+
+	zassert_equal(net_if_tx_sched_get_stats(iface, 1, &stats), 0,
+		      "Cannot get stats");
+	zassert_equal(stats.len, 0, "Packets left in queue");
+	zassert_equal(stats.max_len, 8, "Invalid max queue length");
+	zassert_equal(stats.sent, 8, "Invalid sent count");
+}
+
+static void test_queue_full(void)
+{
+	struct net_if_tx_queue_stats stats;
+	int i;
+
+	sent_count = 0;
+
+	for (i = 0; i < CONFIG_NET_TX_SCHED_QUEUE_LEN + 2; i++) {
+		queue_pkt(0);
+	}
+
+	k_sleep(WAIT_TIME);
+
+	zassert_equal(sent_count, CONFIG_NET_TX_SCHED_QUEUE_LEN,
+		      "Invalid number of packets sent %d", sent_count);
+
+	zassert_equal(net_if_tx_sched_get_stats(iface, 0, &stats), 0,
+		      "Cannot get stats");
+	zassert_equal(stats.dropped, 2, "Invalid drop count %u",
+		      stats.dropped);
+}
+
+static void test_shaping(void)
+{
+	s64_t elapsed;
+	int i;
+
+	/* One packet every 10 ms after the first one */
+	net_if_tx_sched_set_rate(iface, PKT_LEN * 100, PKT_LEN);
+
+	sent_count = 0;
+
+	for (i = 0; i < 5; i++) {
+		queue_pkt(0);
+	}
+
+	k_sleep(WAIT_TIME);
+
+	zassert_equal(sent_count, 5, "Invalid number of packets sent %d",
+		      sent_count);
+
+	elapsed = sent_time[4] - sent_time[0];
+	zassert_true(elapsed >= 35 && elapsed < 100,
+		     "Invalid shaping time %d ms", (int)elapsed);
+
+	net_if_tx_sched_set_rate(iface, 0, 0);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_tx_sched_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_weighted_fair),
+			 ztest_unit_test(test_queue_full),
+			 ztest_unit_test(test_shaping));
+
+	ztest_run_test_suite(net_tx_sched_test);
+}